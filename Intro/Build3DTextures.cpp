@@ -7,87 +7,215 @@ Texture3D*	gs_pTexNoise3D = NULL;
 //////////////////////////////////////////////////////////////////////////
 //////////////////////////////////////////////////////////////////////////
 
-int	Build3DTextures( IntroProgressDelegate& _Delegate )
+// Bump this whenever the noise volume changes for the same seeds and size so stale cache files get ignored
+#define NOISE3D_GENERATOR_VERSION	2
+#define NOISE3D_NOISE_SEED			1
+#define NOISE3D_CACHE_MAGIC			0x4433494EU	// "NI3D"
+
+// Header of the mip chain cache files, followed by the half4 mips from the largest to the smallest
+struct	__Noise3DCacheHeader
 {
-	half4*	ppNoise[NOISE3D_SHIFT+1];
+	U32		Magic;
+	U32		Version;
+	U32		Key;
+	U32		Size;
+	U32		MipsCount;
+};
+
+struct	__Noise3DJob
+{
+	const Noise*	pNoise;
+	float3			pOffsets[4];
+	float4*			pVolume;
+	float*			pChannels;		// 4 slices of scratch per thread
+};
+
+// Generates one Z slice of the 4 wrapping noise channels
+static void	Noise3DSliceTask( int _Z, int _ThreadIndex, void* _pJob )
+{
+	__Noise3DJob&	Job = *((__Noise3DJob*) _pJob);
 
-	// Build wrapping 3D noise for mip level 0
-	Noise	N( 1 );
-	_randpushseed();
-	_srand( RAND_DEFAULT_SEED_U, RAND_DEFAULT_SEED_V );
+	const int	SliceSize = NOISE3D_SIZE*NOISE3D_SIZE;
+	const float	Step = 1.0f / NOISE3D_SIZE;
+	float*		pChannels = Job.pChannels + _ThreadIndex * 4*SliceSize;
+
+	// The grid positions Offset + (X,Y,Z) / NOISE3D_SIZE are exactly the ones the per-voxel WrapPerlin() calls used
+	for ( int Channel=0; Channel < 4; Channel++ )
+	{
+		const float3&	Offset = Job.pOffsets[Channel];
+		Job.pNoise->WrapPerlinGrid( float3( Offset.x, Offset.y, Offset.z + float(_Z) * Step ), float3( Step, Step, Step ), NOISE3D_SIZE, NOISE3D_SIZE, 1, pChannels + Channel*SliceSize );
+	}
 
-	ppNoise[0] = new half4[NOISE3D_SIZE*NOISE3D_SIZE*NOISE3D_SIZE];
+	float4*	pSlice = Job.pVolume + SliceSize*_Z;
+	for ( int Index=0; Index < SliceSize; Index++ )
+		pSlice[Index].Set( pChannels[Index], pChannels[SliceSize+Index], pChannels[2*SliceSize+Index], pChannels[3*SliceSize+Index] );
+}
 
-	float3	Position;
-	float3	Offset0( _frand(), _frand(), _frand() );
-	float3	Offset1( _frand(), _frand(), _frand() );
-	float3	Offset2( _frand(), _frand(), _frand() );
-	for ( int Z=0; Z < NOISE3D_SIZE; Z++ )
+// FNV-1a hash of the parameters the volume depends on, used to name and validate the cache file
+static U32	Noise3DCacheKey()
+{
+	U32	pParameters[] = { NOISE3D_GENERATOR_VERSION, NOISE3D_SIZE, NOISE3D_NOISE_SEED, RAND_DEFAULT_SEED_U, RAND_DEFAULT_SEED_V };
+
+	U32	Key = 2166136261U;
+	const U8*	pBytes = (const U8*) pParameters;
+	for ( int ByteIndex=0; ByteIndex < int(sizeof(pParameters)); ByteIndex++ )
 	{
-		Position.z = float(Z) / NOISE3D_SIZE;
-		for ( int Y=0; Y < NOISE3D_SIZE; Y++ )
-		{
-			Position.y = float(Y) / NOISE3D_SIZE;
-			for ( int X=0; X < NOISE3D_SIZE; X++ )
-			{
-				Position.x = float(X) / NOISE3D_SIZE;
+		Key ^= pBytes[ByteIndex];
+		Key *= 16777619U;
+	}
+	return Key;
+}
 
-				int	Index = X+((Y+(Z<<NOISE3D_SHIFT)) << NOISE3D_SHIFT);
+static U32	Noise3DMipsSize()
+{
+	U32	Total = 0;
+	for ( int MipLevel=0; MipLevel <= NOISE3D_SHIFT; MipLevel++ )
+	{
+		U32	Size = NOISE3D_SIZE >> MipLevel;
+		Total += Size*Size*Size*sizeof(half4);
+	}
+	return Total;
+}
 
-				ppNoise[0][Index].x = N.WrapPerlin( Position );
-				ppNoise[0][Index].y = N.WrapPerlin( Position + Offset0 );
-				ppNoise[0][Index].z = N.WrapPerlin( Position + Offset1 );
-				ppNoise[0][Index].w = N.WrapPerlin( Position + Offset2 );
-			}
-		}
+// Maps an existing cache file and points the mips at its content
+//	Returns the mapped view (to unmap once the texture is created) or NULL if there is no valid cache file
+static const void*	MapNoise3DCache( const char* _pFileName, U32 _Key, half4** _ppMips )
+{
+	HANDLE	hFile = CreateFileA( _pFileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hFile == INVALID_HANDLE_VALUE )
+		return NULL;	// Not cached yet
+
+	U32		ExpectedSize = sizeof(__Noise3DCacheHeader) + Noise3DMipsSize();
+	bool	bValidSize = GetFileSize( hFile, NULL ) == ExpectedSize;
+	HANDLE	hMapping = bValidSize ? CreateFileMappingA( hFile, NULL, PAGE_READONLY, 0, 0, NULL ) : NULL;
+	CloseHandle( hFile );
+	if ( hMapping == NULL )
+		return NULL;
+
+	const void*	pView = MapViewOfFile( hMapping, FILE_MAP_READ, 0, 0, 0 );
+	CloseHandle( hMapping );	// The view keeps the mapping alive
+	if ( pView == NULL )
+		return NULL;
+
+	const __Noise3DCacheHeader&	Header = *((const __Noise3DCacheHeader*) pView);
+	if ( Header.Magic != NOISE3D_CACHE_MAGIC || Header.Version != NOISE3D_GENERATOR_VERSION || Header.Key != _Key || Header.Size != NOISE3D_SIZE || Header.MipsCount != NOISE3D_SHIFT+1 )
+	{	// Stale or foreign file, rebuild it
+		UnmapViewOfFile( pView );
+		return NULL;
 	}
-	_randpopseed();
 
-	// Build mipmaps
-	int	Size = NOISE3D_SIZE;
-	for ( int MipLevel=1; MipLevel <= NOISE3D_SHIFT; MipLevel++ )
+	half4*	pMip = (half4*) (&Header + 1);
+	for ( int MipLevel=0; MipLevel <= NOISE3D_SHIFT; MipLevel++ )
 	{
-		int	PreviousSize = Size;
-		Size >>= 1;
+		U32	Size = NOISE3D_SIZE >> MipLevel;
+		_ppMips[MipLevel] = pMip;
+		pMip += Size*Size*Size;
+	}
 
-		ppNoise[MipLevel] = new half4[Size*Size*Size];
-		for ( int Z=0; Z < Size; Z++ )
-		{
-			half4*	pSlice0 = ppNoise[MipLevel-1] + PreviousSize*PreviousSize*(2*Z);
-			half4*	pSlice1 = ppNoise[MipLevel-1] + PreviousSize*PreviousSize*(2*Z+1);
+	return pView;
+}
 
-			half4*	pTargetSlice = ppNoise[MipLevel] + Size*Size*Z;
+static void	SaveNoise3DCache( const char* _pFileName, U32 _Key, half4** _ppMips )
+{
+	HANDLE	hFile = CreateFileA( _pFileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL );
+	if ( hFile == INVALID_HANDLE_VALUE )
+		return;	// Read-only folder? We'll just build the volume again next time...
+
+	__Noise3DCacheHeader	Header = { NOISE3D_CACHE_MAGIC, NOISE3D_GENERATOR_VERSION, _Key, NOISE3D_SIZE, NOISE3D_SHIFT+1 };
+	DWORD	WrittenSize;
+	bool	bSucceeded = WriteFile( hFile, &Header, sizeof(Header), &WrittenSize, NULL ) && WrittenSize == sizeof(Header);
+	for ( int MipLevel=0; bSucceeded && MipLevel <= NOISE3D_SHIFT; MipLevel++ )
+	{
+		U32	Size = NOISE3D_SIZE >> MipLevel;
+		DWORD	MipSize = Size*Size*Size*sizeof(half4);
+		bSucceeded = WriteFile( hFile, _ppMips[MipLevel], MipSize, &WrittenSize, NULL ) && WrittenSize == MipSize;
+	}
 
-			for ( int Y=0; Y < Size; Y++ )
-			{
-				half4*	pScanline00 = pSlice0 + PreviousSize*(2*Y);
-				half4*	pScanline01 = pSlice0 + PreviousSize*(2*Y+1);
-				half4*	pScanline10 = pSlice1 + PreviousSize*(2*Y);
-				half4*	pScanline11 = pSlice1 + PreviousSize*(2*Y+1);
+	CloseHandle( hFile );
+	if ( !bSucceeded )
+		DeleteFileA( _pFileName );	// Don't leave a truncated file behind (disk full?)
+}
 
-				half4*	pTargetScanline = pTargetSlice + Size*Y;
+// Builds the wrapping 3D noise volume and its mip chain
+static void	BuildNoise3DMips( half4** _ppMips )
+{
+	Noise	N( NOISE3D_NOISE_SEED );
+	_randpushseed();
+	_srand( RAND_DEFAULT_SEED_U, RAND_DEFAULT_SEED_V );
 
-				for ( int X=0; X < Size; X++ )
+	__Noise3DJob	Job;
+	Job.pNoise = &N;
+	Job.pOffsets[0].Set( 0.0f, 0.0f, 0.0f );
+	for ( int Channel=1; Channel < 4; Channel++ )
+		Job.pOffsets[Channel].Set( _frand(), _frand(), _frand() );
+	Job.pVolume = new float4[NOISE3D_SIZE*NOISE3D_SIZE*NOISE3D_SIZE];
+
+	_randpopseed();
+
+	// Spread the slices across all the processors, the calling thread generates slices as well
+	Job.pChannels = new float[WorkerPool::GetThreadsCount( NOISE3D_SIZE ) * 4*NOISE3D_SIZE*NOISE3D_SIZE];
+	WorkerPool::ParallelFor( NOISE3D_SIZE, Noise3DSliceTask, &Job );
+	delete[] Job.pChannels;
+
+	// Build all the mips in a single pass over the full precision volume
+	//	Each voxel is accumulated into the voxel covering it in every mip level, the mips are then normalized and converted to half
+	float4*	ppSums[NOISE3D_SHIFT+1];
+	ppSums[0] = Job.pVolume;
+	for ( int MipLevel=1; MipLevel <= NOISE3D_SHIFT; MipLevel++ )
+	{
+		int	Size = NOISE3D_SIZE >> MipLevel;
+		ppSums[MipLevel] = new float4[Size*Size*Size];
+		memset( ppSums[MipLevel], 0, Size*Size*Size*sizeof(float4) );
+	}
+
+	for ( int Z=0; Z < NOISE3D_SIZE; Z++ )
+		for ( int Y=0; Y < NOISE3D_SIZE; Y++ )
+		{
+			const float4*	pScanline = Job.pVolume + NOISE3D_SIZE*(Y+NOISE3D_SIZE*Z);
+			for ( int X=0; X < NOISE3D_SIZE; X++ )
+			{
+				const float4&	V = pScanline[X];
+				for ( int MipLevel=1; MipLevel <= NOISE3D_SHIFT; MipLevel++ )
 				{
-					int			Px = 2*X;
-					int			Nx = 2*X+1;
-
-					float4	V000 = pScanline00[Px];
-					float4	V001 = pScanline00[Nx];
-					float4	V010 = pScanline01[Px];
-					float4	V011 = pScanline01[Nx];
-					float4	V100 = pScanline10[Px];
-					float4	V101 = pScanline10[Nx];
-					float4	V110 = pScanline11[Px];
-					float4	V111 = pScanline11[Nx];
-
-					float4	V = 0.125f * (V000 + V001 + V010 + V011
-											+ V100 + V101 + V110 + V111);
-
-					*pTargetSlice++ = V;
+					int		Shift = NOISE3D_SHIFT - MipLevel;
+					float4&	Sum = ppSums[MipLevel][(X>>MipLevel) + (((Y>>MipLevel) + ((Z>>MipLevel) << Shift)) << Shift)];
+					Sum = Sum + V;
 				}
 			}
 		}
+
+	for ( int MipLevel=0; MipLevel <= NOISE3D_SHIFT; MipLevel++ )
+	{
+		int		Count = (NOISE3D_SIZE*NOISE3D_SIZE*NOISE3D_SIZE) >> (3*MipLevel);
+		float	Normalizer = 1.0f / (1 << (3*MipLevel));
+
+		_ppMips[MipLevel] = new half4[Count];
+		for ( int Index=0; Index < Count; Index++ )
+			_ppMips[MipLevel][Index] = Normalizer * ppSums[MipLevel][Index];
+
+		delete[] ppSums[MipLevel];
+	}
+}
+
+int	Build3DTextures( IntroProgressDelegate& _Delegate )
+{
+	half4*	ppNoise[NOISE3D_SHIFT+1];
+
+	// Map the mip chain from a previous run if the volume for these parameters is already on disk
+	//	The cache lives in the user's temp folder since the current directory (or the exe's folder) may well be read-only
+	U32		CacheKey = Noise3DCacheKey();
+	char	pCacheFileName[MAX_PATH+32];
+	DWORD	TempPathLength = GetTempPathA( MAX_PATH, pCacheFileName );
+	bool	bCacheAvailable = TempPathLength > 0 && TempPathLength < MAX_PATH;
+	if ( bCacheAvailable )
+		wsprintfA( pCacheFileName + TempPathLength, "Noise3D_%08X.cache", CacheKey );
+
+	const void*	pCacheView = bCacheAvailable ? MapNoise3DCache( pCacheFileName, CacheKey, ppNoise ) : NULL;
+	if ( pCacheView == NULL )
+	{
+		BuildNoise3DMips( ppNoise );
+		if ( bCacheAvailable )
+			SaveNoise3DCache( pCacheFileName, CacheKey, ppNoise );
 	}
 
 	// Generate texture
@@ -95,8 +223,11 @@ int	Build3DTextures( IntroProgressDelegate& _Delegate )
 
 	gs_pTexNoise3D->Set( 0, true );	// This is a global texture !
 
-	for ( int MipLevel=0; MipLevel <= NOISE3D_SHIFT; MipLevel++ )
-		delete[] ppNoise[MipLevel];
+	if ( pCacheView != NULL )
+		UnmapViewOfFile( pCacheView );
+	else
+		for ( int MipLevel=0; MipLevel <= NOISE3D_SHIFT; MipLevel++ )
+			delete[] ppNoise[MipLevel];
 
 #if 1
 	// Save as POM format
@@ -286,10 +286,10 @@ void	EffectParticles::Render( float _Time, float _DeltaTime )
 
 namespace	// Drawers & Fillers
 {
-	struct	__VoronoiInfos
+	struct	__Voronoi
 	{
-		int					ParticleIndex;
-		float				Distance;
+		int							W;
+		Noise::CellularFeatures*	pFeatures;
 	};
 	struct	__PerturbVoronoi
 	{
@@ -299,21 +299,13 @@ namespace	// Drawers & Fillers
 		VertexFormatPt4*	pVertices;
 	};
 
-	float	CombineDistances( float _pDistances[], int _pCellX[], int _pCellY[], int _pCellZ[], void* _pData )
-	{
-		__VoronoiInfos&	Infos = *((__VoronoiInfos*) _pData);
-		Infos.ParticleIndex = EFFECT_PARTICLES_COUNT*_pCellY[0] + _pCellX[0];
-		Infos.Distance = sqrtf( _pDistances[0] );
-		return 0.0f;
-	}
 	void	FillVoronoi( int x, int y, const float2& _UV, Pixel& _Pixel, void* _pData )
 	{
- 		Noise&	N = *((Noise*) _pData);
-
-		__VoronoiInfos	Infos;
- 		N.Cellular( EFFECT_PARTICLES_COUNT * _UV, CombineDistances, &Infos, true );	// Simple cellular (NOT Worley !) => Means only 1 point per cell, exactly what we need for a unique particle ID
+		__Voronoi&	Params = *((__Voronoi*) _pData);
 
-		_Pixel.RGBA.Set( float(Infos.ParticleIndex), Infos.Distance, 0, 0 );
+		const Noise::CellularFeatures&	Features = Params.pFeatures[Params.W*y+x];
+		int		ParticleIndex = EFFECT_PARTICLES_COUNT*Features.pCellY[0] + Features.pCellX[0];
+		_Pixel.RGBA.Set( float(ParticleIndex), sqrtf( Features.pSqDistances[0] ), 0, 0 );
 	}
 	void	PerturbVoronoi( int x, int y, const float2& _UV, Pixel& _Pixel, void* _pData )
 	{
@@ -370,8 +362,22 @@ void	EffectParticles::BuildVoronoiTexture( TextureBuilder& _TB, float2* _pCellCe
 	Noise	N( 1 );
 			N.SetCellularWrappingParameters( EFFECT_PARTICLES_COUNT, EFFECT_PARTICLES_COUNT, EFFECT_PARTICLES_COUNT );
 
-	TextureBuilder	TempVoronoi( _TB.GetWidth(), _TB.GetHeight() );
-					TempVoronoi.Fill( ::FillVoronoi, &N );
+	// Query the closest cells of all the texels at once
+	// Simple cellular (NOT Worley !) => Means only 1 point per cell, exactly what we need for a unique particle ID
+	int			W = _TB.GetWidth(), H = _TB.GetHeight();
+	float2*		pUVs = new float2[W*H];
+	for ( int Y=0; Y < H; Y++ )
+		for ( int X=0; X < W; X++ )
+			pUVs[W*Y+X] = EFFECT_PARTICLES_COUNT * float2( float(X) / W, float(Y) / H );
+
+	__Voronoi	Voronoi = { W, new Noise::CellularFeatures[W*H] };
+	N.CreateCellularCache( 2, false );
+	N.CellularN( pUVs, Voronoi.pFeatures, W*H, true );
+	delete[] pUVs;
+
+	TextureBuilder	TempVoronoi( W, H );
+					TempVoronoi.Fill( ::FillVoronoi, &Voronoi );
+	delete[] Voronoi.pFeatures;
 
 	// Clear the vertices to wrong intervals
 	for ( int ParticleIndex=0; ParticleIndex < EFFECT_PARTICLES_COUNT*EFFECT_PARTICLES_COUNT; ParticleIndex++ )
@@ -494,6 +494,8 @@ void WINAPI	EntryPoint()
 
  	IntroExit();
 
+	WorkerPool::Exit();
+
 	WindowExit();
 
 	// Clean exit...
@@ -44,7 +44,8 @@
 #include "Utility/FPSCamera.h"
 #include "Utility/Video.h"
 #include "Utility/TextureFilePOM.h"
-#include "Utility/Octree.h"
+#include "Utility/WorkerPool.h"
+#include "Utility/LinearBVH.h"
 
 // DirectX Renderer
 #include "RendererD3D11/Device.h"
@@ -1,202 +1,328 @@
 #include "../../GodComplex.h"
 
 //////////////////////////////////////////////////////////////////////////
-// Gaussian Blur
-struct __BlurStruct
+// Planes
+// Filters that are not expressed per pixel extract each channel (R, G, B, A, Height and Roughness) as a plane of floats.
+// The planes are split into independent lines (tiles of scanlines or strips of adjacent columns) that are spread across all the processors
+//	by the WorkerPool, each thread using its own scratch buffer.
+//
+static const int	PLANE_CHANNELS_COUNT = 6;
+
+// Gives the address of one of the filtered channels of a pixel (R, G, B, A, Height and Roughness)
+static float*	GetPlaneChannel( Pixel& _Pixel, int _ChannelIndex )
 {
-	TextureBuilder*	pSource;
-	int		W, H;
-	int		Size;
-	float*	pWeights;
-	float	InvSumWeights;
-};
+	switch ( _ChannelIndex )
+	{
+	case 0: return &_Pixel.RGBA.x;
+	case 1: return &_Pixel.RGBA.y;
+	case 2: return &_Pixel.RGBA.z;
+	case 3: return &_Pixel.RGBA.w;
+	case 4: return &_Pixel.Height;
+	default: return &_Pixel.Roughness;
+	}
+}
 
-// Wrap versions
-void	FillBlurGaussianHW( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData )
+struct	__PlaneJob
 {
-	__BlurStruct&	Data = *((__BlurStruct*) _pData);
+	void			(*pProcessTask)( const __PlaneJob& _Job, int _TaskIndex, float* _pScratch );
+	const void*		pParams;		// The filter's parameters
+	int				TasksCount;
+	int				ScratchSize;	// Amount of floats of the scratch buffer used by each thread
+	float*			pScratches;		// One scratch buffer per thread
+};
 
-	float	Xl = _X-1.0f, Xr = _X+1.0f;
-	float	Y = float(_Y);
+static void	PlaneJobTask( int _TaskIndex, int _ThreadIndex, void* _pJob )
+{
+	const __PlaneJob&	Job = *((const __PlaneJob*) _pJob);
+	float*	pScratch = Job.pScratches != NULL ? Job.pScratches + _ThreadIndex * Job.ScratchSize : NULL;
+	(*Job.pProcessTask)( Job, _TaskIndex, pScratch );
+}
 
-	Data.pSource->SampleWrap( float(_X), Y, 0, _Pixel );
+// Runs all the tasks of the job, the calling thread processes tasks as well
+static void	RunPlaneJob( __PlaneJob& _Job )
+{
+	int	ThreadsCount = WorkerPool::GetThreadsCount( _Job.TasksCount );
+	_Job.pScratches = _Job.ScratchSize > 0 ? new float[ThreadsCount * _Job.ScratchSize] : NULL;
 
-	Pixel	Temp;
-	for ( int i=0; i < Data.Size; i++ )
-	{
-		float	Weight = Data.pWeights[i];
-
-		// Accumulate from the left
-		Data.pSource->SampleWrap( Xl, Y, 0, Temp );	Xl--;
-		_Pixel.RGBA = _Pixel.RGBA + Weight * Temp.RGBA;
-		_Pixel.Height += Weight * Temp.Height;
-		_Pixel.Roughness += Weight * Temp.Roughness;
-
-		// Accumulate from the right
-		Data.pSource->SampleWrap( Xr, Y, 0, Temp );	Xr++;
-		_Pixel.RGBA = _Pixel.RGBA + Weight * Temp.RGBA;
-		_Pixel.Height += Weight * Temp.Height;
-		_Pixel.Roughness += Weight * Temp.Roughness;
-	}
+	WorkerPool::ParallelFor( _Job.TasksCount, PlaneJobTask, &_Job );
 
-	// Normalize result
-	_Pixel.RGBA = Data.InvSumWeights * _Pixel.RGBA;
-	_Pixel.Roughness *= Data.InvSumWeights;
-	_Pixel.Height *= Data.InvSumWeights;
+	delete[] _Job.pScratches;
+	_Job.pScratches = NULL;
 }
-void	FillBlurGaussianVW( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData )
+
+//////////////////////////////////////////////////////////////////////////
+// Gaussian Blur
+// The gaussian is approximated by 3 successive box filters whose running sums make the cost per pixel independent of the blur size.
+// Small gaussians can't be approximated by boxes (the narrowest box already has a radius of 1 pixel) so they use the exact kernel instead.
+//
+// The horizontal pass filters tiles of scanlines, the vertical pass filters strips of adjacent columns at once so its inner loops are vectorizable.
+// Each line is copied into a buffer padded with the wrapped or clamped samples so the filters never need to check the borders.
+//
+static const int	BLUR_BOXES_COUNT = 3;
+static const float	BLUR_EXACT_SIGMA = 1.5f;		// Gaussians with a smaller standard deviation use the exact kernel
+static const int	BLUR_EXACT_MAX_RADIUS = 6;		// 4 standard deviations of the largest exact kernel
+static const int	BLUR_TILE_ROWS = 8;
+static const int	BLUR_STRIP_WIDTH = 64;
+
+// The filter applied along one direction: either the boxes or the exact kernel
+struct	__BlurAxis
 {
-	__BlurStruct&	Data = *((__BlurStruct*) _pData);
+	int		pRadii[BLUR_BOXES_COUNT];				// Radii of the boxes (0 if unused)
+	int		KernelRadius;							// Radius of the exact kernel (0 if the boxes are used)
+	float	pWeights[2*BLUR_EXACT_MAX_RADIUS+1];	// Normalized weights of the exact kernel in [-KernelRadius,KernelRadius]
+	int		Padding;								// Amount of samples required on each side of a line
+};
 
-	float	X = float(_X);
-	float	Yl = _Y-1.0f, Yr = _Y+1.0f;
+struct	__BlurParams
+{
+	Pixel*				pPixels;
+	float*				pPlane;
+	int					W, H;
+	int					ChannelIndex;
+	bool				bWrap;
+	const __BlurAxis*	pAxisX;
+	const __BlurAxis*	pAxisY;
+};
 
-	Data.pSource->SampleWrap( X, float(_Y), 0, _Pixel );
+// Computes the radii of the boxes approximating a gaussian of given standard deviation
+// From "Fast Almost-Gaussian Filtering" by P. Kovesi (2010)
+static void	ComputeBoxRadii( float _Sigma, int _pRadii[BLUR_BOXES_COUNT] )
+{
+	float	IdealWidth = sqrtf( 12.0f * _Sigma*_Sigma / BLUR_BOXES_COUNT + 1.0f );
+	int		LowerWidth = int( floorf( IdealWidth ) );
+	if ( (LowerWidth & 1) == 0 )
+		LowerWidth--;	// Box widths must be odd
+	LowerWidth = MAX( 1, LowerWidth );
+	int		UpperWidth = LowerWidth + 2;
+
+	// Amount of boxes using the lower width so that the variance of the boxes matches the gaussian's
+	float	IdealLowerCount = (12.0f * _Sigma*_Sigma - BLUR_BOXES_COUNT * LowerWidth*LowerWidth - 4.0f * BLUR_BOXES_COUNT * LowerWidth - 3.0f * BLUR_BOXES_COUNT) / (-4.0f * LowerWidth - 4.0f);
+	int		LowerCount = int( floorf( IdealLowerCount + 0.5f ) );
+	for ( int BoxIndex=0; BoxIndex < BLUR_BOXES_COUNT; BoxIndex++ )
+		_pRadii[BoxIndex] = ((BoxIndex < LowerCount ? LowerWidth : UpperWidth) - 1) >> 1;
+}
+
+// The gaussian weight exp( -x^2 / (2 Sigma^2) ) reaches _MinWeight at a distance of _Size pixels
+static void	InitBlurAxis( float _Size, float _MinWeight, __BlurAxis& _Axis )
+{
+	memset( &_Axis, 0, sizeof(__BlurAxis) );
 
-	Pixel	Temp;
-	for ( int i=0; i < Data.Size; i++ )
+	float	Sigma = _Size / sqrtf( -2.0f * logf( _MinWeight ) );
+	if ( Sigma < BLUR_EXACT_SIGMA )
 	{
-		float	Weight = Data.pWeights[i];
-
-		// Accumulate from the top
-		Data.pSource->SampleWrap( X, Yl, 0, Temp );	Yl--;
-		_Pixel.RGBA = _Pixel.RGBA + Weight * Temp.RGBA;
-		_Pixel.Height += Weight * Temp.Height;
-		_Pixel.Roughness += Weight * Temp.Roughness;
-
-		// Accumulate from the bottom
-		Data.pSource->SampleWrap( X, Yr, 0, Temp );	Yr++;
-		_Pixel.RGBA = _Pixel.RGBA + Weight * Temp.RGBA;
-		_Pixel.Height += Weight * Temp.Height;
-		_Pixel.Roughness += Weight * Temp.Roughness;
+		_Axis.KernelRadius = MIN( int( ceilf( _Size ) ), BLUR_EXACT_MAX_RADIUS );
+		if ( _Axis.KernelRadius <= 0 )
+			return;	// No blur
+
+		float	k = logf( _MinWeight ) / (_Size*_Size);
+		float	SumWeights = 0.0f;
+		for ( int i=-_Axis.KernelRadius; i <= _Axis.KernelRadius; i++ )
+		{
+			float	Weight = expf( k * i*i );
+			_Axis.pWeights[_Axis.KernelRadius+i] = Weight;
+			SumWeights += Weight;
+		}
+		for ( int i=0; i <= 2*_Axis.KernelRadius; i++ )
+			_Axis.pWeights[i] /= SumWeights;
+		_Axis.Padding = _Axis.KernelRadius;
+		return;
 	}
 
-	// Normalize result
-	_Pixel.RGBA = Data.InvSumWeights * _Pixel.RGBA;
-	_Pixel.Roughness *= Data.InvSumWeights;
-	_Pixel.Height *= Data.InvSumWeights;
+	ComputeBoxRadii( Sigma, _Axis.pRadii );
+	for ( int BoxIndex=0; BoxIndex < BLUR_BOXES_COUNT; BoxIndex++ )
+		_Axis.Padding = MAX( _Axis.Padding, _Axis.pRadii[BoxIndex]+1 );
 }
-// Clamp versions
-void	FillBlurGaussianHC( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData )
-{
-	__BlurStruct&	Data = *((__BlurStruct*) _pData);
 
-	float	Xl = _X-1.0f, Xr = _X+1.0f;
-	float	Y = float(_Y);
-
-	Data.pSource->SampleClamp( float(_X), Y, 0, _Pixel );
-
-	Pixel	Temp;
-	for ( int i=0; i < Data.Size; i++ )
+static inline int	WrapOrClamp( int _Index, int _Size, bool _bWrap )
+{
+	if ( _bWrap )
 	{
-		float	Weight = Data.pWeights[i];
-
-		// Accumulate from the left
-		Data.pSource->SampleClamp( Xl, Y, 0, Temp );	Xl--;
-		_Pixel.RGBA = _Pixel.RGBA + Weight * Temp.RGBA;
-		_Pixel.Height += Weight * Temp.Height;
-		_Pixel.Roughness += Weight * Temp.Roughness;
-
-		// Accumulate from the right
-		Data.pSource->SampleClamp( Xr, Y, 0, Temp );	Xr++;
-		_Pixel.RGBA = _Pixel.RGBA + Weight * Temp.RGBA;
-		_Pixel.Height += Weight * Temp.Height;
-		_Pixel.Roughness += Weight * Temp.Roughness;
+		_Index %= _Size;
+		return _Index < 0 ? _Index + _Size : _Index;
 	}
-
-	// Normalize result
-	_Pixel.RGBA = Data.InvSumWeights * _Pixel.RGBA;
-	_Pixel.Roughness *= Data.InvSumWeights;
-	_Pixel.Height *= Data.InvSumWeights;
+	return _Index < 0 ? 0 : (_Index >= _Size ? _Size-1 : _Index);
 }
-void	FillBlurGaussianVC( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData )
+
+// A line is made of _Count samples of _Lanes floats each (1 for a scanline, the amount of columns for a strip)
+// Fills the _Padding samples on each side of the line with the wrapped or clamped samples
+static void	PadLine( float* _pLine, int _Count, int _Lanes, int _Padding, bool _bWrap )
 {
-	__BlurStruct&	Data = *((__BlurStruct*) _pData);
+	for ( int i=1; i <= _Padding; i++ )
+	{
+		memcpy( _pLine - _Lanes*i, _pLine + _Lanes*WrapOrClamp( -i, _Count, _bWrap ), _Lanes*sizeof(float) );
+		memcpy( _pLine + _Lanes*(_Count-1+i), _pLine + _Lanes*WrapOrClamp( _Count-1+i, _Count, _bWrap ), _Lanes*sizeof(float) );
+	}
+}
 
-	float	X = float(_X);
-	float	Yl = _Y-1.0f, Yr = _Y+1.0f;
+// Box filters a line padded with at least _Radius+1 samples
+static void	BoxLine( const float* _pSource, float* _pTarget, int _Count, int _Lanes, int _Radius )
+{
+	float	Normalizer = 1.0f / (2*_Radius+1);
+	if ( _Lanes == 1 )
+	{
+		float	Sum = 0.0f;
+		for ( int i=-_Radius; i <= _Radius; i++ )
+			Sum += _pSource[i];
 
-	Data.pSource->SampleClamp( X, float(_Y), 0, _Pixel );
+		for ( int i=0; i < _Count; i++ )
+		{
+			_pTarget[i] = Sum * Normalizer;
+			Sum += _pSource[i+_Radius+1] - _pSource[i-_Radius];
+		}
+		return;
+	}
 
-	Pixel	Temp;
-	for ( int i=0; i < Data.Size; i++ )
+	float	pSums[BLUR_STRIP_WIDTH];
+	for ( int Lane=0; Lane < _Lanes; Lane++ )
+		pSums[Lane] = 0.0f;
+	for ( int i=-_Radius; i <= _Radius; i++ )
 	{
-		float	Weight = Data.pWeights[i];
-
-		// Accumulate from the top
-		Data.pSource->SampleClamp( X, Yl, 0, Temp );	Yl--;
-		_Pixel.RGBA = _Pixel.RGBA + Weight * Temp.RGBA;
-		_Pixel.Height += Weight * Temp.Height;
-		_Pixel.Roughness += Weight * Temp.Roughness;
-
-		// Accumulate from the bottom
-		Data.pSource->SampleClamp( X, Yr, 0, Temp );	Yr++;
-		_Pixel.RGBA = _Pixel.RGBA + Weight * Temp.RGBA;
-		_Pixel.Height += Weight * Temp.Height;
-		_Pixel.Roughness += Weight * Temp.Roughness;
+		const float*	pSource = _pSource + _Lanes*i;
+		for ( int Lane=0; Lane < _Lanes; Lane++ )
+			pSums[Lane] += pSource[Lane];
 	}
 
-	// Normalize result
-	_Pixel.RGBA = Data.InvSumWeights * _Pixel.RGBA;
-	_Pixel.Roughness *= Data.InvSumWeights;
-	_Pixel.Height *= Data.InvSumWeights;
+	for ( int i=0; i < _Count; i++ )
+	{
+		float*			pTarget = _pTarget + _Lanes*i;
+		const float*	pAdd = _pSource + _Lanes*(i+_Radius+1);
+		const float*	pRemove = _pSource + _Lanes*(i-_Radius);
+		for ( int Lane=0; Lane < _Lanes; Lane++ )
+		{
+			pTarget[Lane] = pSums[Lane] * Normalizer;
+			pSums[Lane] += pAdd[Lane] - pRemove[Lane];
+		}
+	}
 }
 
-void	Filters::BlurGaussian( TextureBuilder& _Builder, float _SizeX, float _SizeY, bool _bWrap, float _MinWeight )
+// Convolves a line padded with at least _Radius samples with the exact kernel
+static void	KernelLine( const float* _pSource, float* _pTarget, int _Count, int _Lanes, const float* _pWeights, int _Radius )
 {
-	int	W = _Builder.GetWidth(), H = _Builder.GetHeight();
-
-	TextureBuilder	Temp( W, H );
-
-	// Apply horizontal pass
+	for ( int i=0; i < _Count; i++ )
 	{
-		__BlurStruct	BS;
-		BS.pSource = &_Builder;
-		BS.W = W;
-		BS.H = H;
+		float*	pTarget = _pTarget + _Lanes*i;
+		for ( int Lane=0; Lane < _Lanes; Lane++ )
+			pTarget[Lane] = 0.0f;
 
-		BS.Size = int( ceilf( _SizeX ) );
-		float	k = logf( _MinWeight ) / (_SizeX*_SizeX);
-
-		BS.pWeights = new float[BS.Size];
-		BS.InvSumWeights = 1.0f;
-		for ( int i=0; i < BS.Size; i++ )
+		for ( int j=-_Radius; j <= _Radius; j++ )
 		{
-			BS.pWeights[i] = expf( k * (1+i)*(1+i) );
-			BS.InvSumWeights += 2.0f * BS.pWeights[i];
+			float			Weight = _pWeights[_Radius+j];
+			const float*	pSource = _pSource + _Lanes*(i+j);
+			for ( int Lane=0; Lane < _Lanes; Lane++ )
+				pTarget[Lane] += Weight * pSource[Lane];
 		}
-		BS.InvSumWeights = 1.0f / BS.InvSumWeights;
+	}
+}
+
+// Blurs a padded line using the temp line, returns the line holding the result
+static float*	BlurLine( const __BlurAxis& _Axis, float* _pLine, float* _pTemp, int _Count, int _Lanes, bool _bWrap )
+{
+	if ( _Axis.KernelRadius > 0 )
+	{
+		PadLine( _pLine, _Count, _Lanes, _Axis.KernelRadius, _bWrap );
+		KernelLine( _pLine, _pTemp, _Count, _Lanes, _Axis.pWeights, _Axis.KernelRadius );
+		return _pTemp;
+	}
 
-		Temp.Fill( _bWrap ? FillBlurGaussianHW : FillBlurGaussianHC, &BS );
+	for ( int BoxIndex=0; BoxIndex < BLUR_BOXES_COUNT; BoxIndex++ )
+	{
+		int	Radius = _Axis.pRadii[BoxIndex];
+		if ( Radius <= 0 )
+			continue;
 
-		delete[] BS.pWeights;
+		PadLine( _pLine, _Count, _Lanes, Radius+1, _bWrap );
+		BoxLine( _pLine, _pTemp, _Count, _Lanes, Radius );
+		float*	pSwap = _pLine; _pLine = _pTemp; _pTemp = pSwap;
 	}
+	return _pLine;
+}
 
-	// Apply vertical pass
+// Extracts a tile of scanlines of the channel, blurs them horizontally and stores them into the plane
+static void	BlurRowsTask( const __PlaneJob& _Job, int _TaskIndex, float* _pScratch )
+{
+	const __BlurParams&	Params = *((const __BlurParams*) _Job.pParams);
+	const __BlurAxis&	Axis = *Params.pAxisX;
+	int		W = Params.W;
+	float*	pLine = _pScratch + Axis.Padding;
+	float*	pTemp = pLine + W + 2*Axis.Padding;
+
+	int		YEnd = MIN( (_TaskIndex+1) * BLUR_TILE_ROWS, Params.H );
+	for ( int Y=_TaskIndex * BLUR_TILE_ROWS; Y < YEnd; Y++ )
 	{
-		__BlurStruct	BS;
-		BS.pSource = &Temp;
-		BS.W = W;
-		BS.H = H;
+		Pixel*	pScanline = Params.pPixels + W*Y;
+		for ( int X=0; X < W; X++ )
+			pLine[X] = *GetPlaneChannel( pScanline[X], Params.ChannelIndex );
+
+		float*	pResult = BlurLine( Axis, pLine, pTemp, W, 1, Params.bWrap );
+		memcpy( Params.pPlane + W*Y, pResult, W*sizeof(float) );
+	}
+}
 
-		BS.Size = int( ceilf( _SizeY ) );
-		float	k = logf( _MinWeight ) / (_SizeY*_SizeY);
+// Blurs a strip of columns of the plane vertically and writes them back into the channel
+static void	BlurColumnsTask( const __PlaneJob& _Job, int _TaskIndex, float* _pScratch )
+{
+	const __BlurParams&	Params = *((const __BlurParams*) _Job.pParams);
+	const __BlurAxis&	Axis = *Params.pAxisY;
+	int		W = Params.W, H = Params.H;
+	int		X0 = _TaskIndex * BLUR_STRIP_WIDTH;
+	int		Lanes = MIN( BLUR_STRIP_WIDTH, W - X0 );
+	float*	pLine = _pScratch + Lanes*Axis.Padding;
+	float*	pTemp = pLine + Lanes*(H + 2*Axis.Padding);
 
-		BS.pWeights = new float[BS.Size];
-		BS.InvSumWeights = 1.0f;
-		for ( int i=0; i < BS.Size; i++ )
-		{
-			BS.pWeights[i] = expf( k * (1+i)*(1+i) );
-			BS.InvSumWeights += 2.0f * BS.pWeights[i];
-		}
-		BS.InvSumWeights = 1.0f / BS.InvSumWeights;
+	for ( int Y=0; Y < H; Y++ )
+		memcpy( pLine + Lanes*Y, Params.pPlane + W*Y + X0, Lanes*sizeof(float) );
 
-		_Builder.Fill( _bWrap ? FillBlurGaussianVW : FillBlurGaussianVC, &BS );
+	float*	pResult = BlurLine( Axis, pLine, pTemp, H, Lanes, Params.bWrap );
 
-		delete[] BS.pWeights;
+	for ( int Y=0; Y < H; Y++ )
+	{
+		Pixel*			pScanline = Params.pPixels + W*Y + X0;
+		const float*	pSource = pResult + Lanes*Y;
+		for ( int Lane=0; Lane < Lanes; Lane++ )
+			*GetPlaneChannel( pScanline[Lane], Params.ChannelIndex ) = pSource[Lane];
 	}
 }
 
+void	Filters::BlurGaussian( TextureBuilder& _Builder, float _SizeX, float _SizeY, bool _bWrap, float _MinWeight )
+{
+	int		W = _Builder.GetWidth(), H = _Builder.GetHeight();
+
+	__BlurAxis	AxisX, AxisY;
+	InitBlurAxis( _SizeX, _MinWeight, AxisX );
+	InitBlurAxis( _SizeY, _MinWeight, AxisY );
+
+	__BlurParams	Params;
+	Params.pPixels = _Builder.GetMips()[0];
+	Params.pPlane = new float[W*H];
+	Params.W = W;
+	Params.H = H;
+	Params.bWrap = _bWrap;
+	Params.pAxisX = &AxisX;
+	Params.pAxisY = &AxisY;
+
+	__PlaneJob	RowsJob;
+	RowsJob.pProcessTask = BlurRowsTask;
+	RowsJob.pParams = &Params;
+	RowsJob.TasksCount = (H + BLUR_TILE_ROWS-1) / BLUR_TILE_ROWS;
+	RowsJob.ScratchSize = 2 * (W + 2*AxisX.Padding);
+
+	__PlaneJob	ColumnsJob;
+	ColumnsJob.pProcessTask = BlurColumnsTask;
+	ColumnsJob.pParams = &Params;
+	ColumnsJob.TasksCount = (W + BLUR_STRIP_WIDTH-1) / BLUR_STRIP_WIDTH;
+	ColumnsJob.ScratchSize = 2 * BLUR_STRIP_WIDTH * (H + 2*AxisY.Padding);
+
+	for ( int ChannelIndex=0; ChannelIndex < PLANE_CHANNELS_COUNT; ChannelIndex++ )
+	{
+		Params.ChannelIndex = ChannelIndex;
+		RunPlaneJob( RowsJob );
+		RunPlaneJob( ColumnsJob );
+	}
+
+	delete[] Params.pPlane;
+	_Builder.InvalidateMips();
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Unsharp masking
 void	FillUnsharpMaskSubtract( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData )
@@ -224,7 +350,7 @@ void	Filters::UnsharpMask( TextureBuilder& _Builder, float _Size )
 	BlurGaussian( Temp, _Size, _Size );
 
 	// Subtract
-	_Builder.Fill( FillUnsharpMaskSubtract, &Temp );
+	_Builder.Fill( FillUnsharpMaskSubtract, &Temp, true );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -254,7 +380,7 @@ void	Filters::BrightnessContrastGamma( TextureBuilder& _Builder, float _Brightne
 	BCG.C = tanf( HALFPI * 0.5f * (1.0f + _Contrast) );
 	BCG.G = _Gamma;
 
-	_Builder.Fill( FillBCG, &BCG );
+	_Builder.Fill( FillBCG, &BCG, true );
 }
 
 //////////////////////////////////////////////////////////////////////////
@@ -289,93 +415,304 @@ void	Filters::Emboss( TextureBuilder& _Builder, const float2& _Direction, float
 	Params.Direction.Normalize();
 	Params.Amplitude = _Amplitude;
 
-	_Builder.Fill( FillEmboss, &Params );
+	_Builder.Fill( FillEmboss, &Params, true );
 }
 
 
 //////////////////////////////////////////////////////////////////////////
-// Erosion
-struct __ErosionStruct
+// Morphology
+// Erosion and dilation use the van Herk/Gil-Werman algorithm that computes the min/max over a window of any size with 3 comparisons per pixel:
+//	the extended line is cut into blocks the size of the window, where we compute the prefix min/max from the left and the suffix min/max from the right.
+//	Any window then spans exactly 2 blocks and its min/max is the min/max of the suffix of the first block and of the prefix of the second one.
+//
+// The kernel processes strips of adjacent lines at once (columns for the vertical passes, rows for the horizontal ones) so the inner loops are vectorizable.
+// Each strip is gathered into a per-thread buffer before being written back so the strips are independent and spread across all the processors.
+// All passes wrap around the texture borders.
+//
+static const int	MORPH_STRIP_WIDTH = 64;
+static const int	MORPH_TILE_ROWS = 8;
+
+enum MORPH_OPERATION
 {
-	Pixel*	pSource;
-	int		W, H;
-	int		Size;
+	MORPH_ERODE,
+	MORPH_DILATE,
+	MORPH_OPEN,
+	MORPH_CLOSE,
+	MORPH_TOP_HAT,
+	MORPH_BLACK_TOP_HAT,
 };
-void	FillErode( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData )
+
+struct	__VanHerkParams
 {
-	__ErosionStruct&	Params = *((__ErosionStruct*) _pData);
+	float*	pPlane;
+	int		Count;			// Amount of samples along each line
+	int		SampleStride;	// Offset between 2 successive samples of a line
+	int		LineStride;		// Offset between 2 adjacent lines
+	int		LinesCount;
+	int		Radius;
+	int		WindowSize;
+	int		PaddedCount;	// Amount of samples of the extended line rounded up to a multiple of the window size
+	bool	bMax;
+};
 
-	_Pixel.RGBA = FLOAT32_MAX * float4::One;
-	_Pixel.Height = FLOAT32_MAX;
-	_Pixel.Roughness = FLOAT32_MAX;
-	for ( int Y=_Y-Params.Size; Y <= _Y+Params.Size; Y++ )
+// Computes the min (or max) of a strip of lines over a window of 2*Radius+1 pixels, in place
+static void	VanHerkStripTask( const __PlaneJob& _Job, int _TaskIndex, float* _pScratch )
+{
+	const __VanHerkParams&	Params = *((const __VanHerkParams*) _Job.pParams);
+	int		Line0 = _TaskIndex * MORPH_STRIP_WIDTH;
+	int		StripWidth = MIN( MORPH_STRIP_WIDTH, Params.LinesCount - Line0 );
+	int		Count = Params.Count;
+	int		WindowSize = Params.WindowSize;
+	int		PaddedCount = Params.PaddedCount;
+	float*	pStrip = Params.pPlane + Params.LineStride * Line0;
+	float*	pPrefix = _pScratch;
+	float*	pSuffix = _pScratch + MORPH_STRIP_WIDTH * PaddedCount;
+
+	// Gather the extended lines, the extended sample E maps to the source sample E-Radius
+	for ( int E=0; E < PaddedCount; E++ )
 	{
-		int		SampleY = ((Params.H+Y) % Params.H);
-		Pixel*	pScanline = &Params.pSource[Params.W * SampleY];
-		for ( int X=_X-Params.Size; X <= _X+Params.Size; X++ )
+		int				SourceIndex = (E - Params.Radius + Count * (1 + PaddedCount / Count)) % Count;
+		const float*	pSource = pStrip + Params.SampleStride * SourceIndex;
+		float*			pTarget = pPrefix + MORPH_STRIP_WIDTH*E;
+		if ( Params.LineStride == 1 )
+			memcpy( pTarget, pSource, StripWidth*sizeof(float) );
+		else
+			for ( int L=0; L < StripWidth; L++ )
+				pTarget[L] = pSource[Params.LineStride*L];
+	}
+
+	// Suffix min/max from the end of each block
+	for ( int E=PaddedCount-1; E >= 0; E-- )
+	{
+		const float*	pSource = pPrefix + MORPH_STRIP_WIDTH*E;
+		float*			pTarget = pSuffix + MORPH_STRIP_WIDTH*E;
+		if ( E % WindowSize == WindowSize-1 )
 		{
-			int	SampleX = (Params.W+X) % Params.W;
-			_Pixel.RGBA = _Pixel.RGBA.Min( pScanline[SampleX].RGBA );
-			_Pixel.Height = MIN( _Pixel.Height, pScanline[SampleX].Height );
-			_Pixel.Roughness = MIN( _Pixel.Roughness, pScanline[SampleX].Roughness );
+			for ( int L=0; L < StripWidth; L++ )
+				pTarget[L] = pSource[L];
+		}
+		else
+		{
+			const float*	pNext = pTarget + MORPH_STRIP_WIDTH;
+			if ( Params.bMax )
+				for ( int L=0; L < StripWidth; L++ )
+					pTarget[L] = MAX( pNext[L], pSource[L] );
+			else
+				for ( int L=0; L < StripWidth; L++ )
+					pTarget[L] = MIN( pNext[L], pSource[L] );
 		}
 	}
-}
-
-void	Filters::Erode( TextureBuilder& _Builder, int _KernelSize )
-{
-	TextureBuilder	Temp( _Builder.GetWidth(), _Builder.GetHeight() );
-	Temp.CopyFrom( _Builder );
 
-	__ErosionStruct	Params;
-	Params.pSource = Temp.GetMips()[0];
-	Params.W = Temp.GetWidth();
-	Params.H = Temp.GetHeight();
-	Params.Size = _KernelSize;
+	// Prefix min/max from the start of each block, computed in place over the gathered lines
+	for ( int E=0; E < PaddedCount; E++ )
+	{
+		if ( E % WindowSize == 0 )
+			continue;
+
+		float*			pTarget = pPrefix + MORPH_STRIP_WIDTH*E;
+		const float*	pPrevious = pTarget - MORPH_STRIP_WIDTH;
+		if ( Params.bMax )
+			for ( int L=0; L < StripWidth; L++ )
+				pTarget[L] = MAX( pPrevious[L], pTarget[L] );
+		else
+			for ( int L=0; L < StripWidth; L++ )
+				pTarget[L] = MIN( pPrevious[L], pTarget[L] );
+	}
 
-	_Builder.Fill( FillErode, &Params );
+	// The window of sample I covers the extended samples [I,I+2*Radius]
+	for ( int I=0; I < Count; I++ )
+	{
+		float*			pS = pSuffix + MORPH_STRIP_WIDTH*I;
+		const float*	pP = pPrefix + MORPH_STRIP_WIDTH*(I+WindowSize-1);
+		if ( Params.bMax )
+			for ( int L=0; L < StripWidth; L++ )
+				pS[L] = MAX( pS[L], pP[L] );
+		else
+			for ( int L=0; L < StripWidth; L++ )
+				pS[L] = MIN( pS[L], pP[L] );
+
+		float*	pTarget = pStrip + Params.SampleStride * I;
+		if ( Params.LineStride == 1 )
+			memcpy( pTarget, pS, StripWidth*sizeof(float) );
+		else
+			for ( int L=0; L < StripWidth; L++ )
+				pTarget[Params.LineStride*L] = pS[L];
+	}
 }
 
+// Computes the min (or max) of each row (or column) of the plane over a window of 2*_Radius+1 pixels, in place
+static void	VanHerk( float* _pPlane, int _W, int _H, int _Radius, bool _bMax, bool _bHorizontal )
+{
+	if ( _Radius <= 0 )
+		return;
+
+	__VanHerkParams	Params;
+	Params.pPlane = _pPlane;
+	Params.Count = _bHorizontal ? _W : _H;
+	Params.SampleStride = _bHorizontal ? 1 : _W;
+	Params.LineStride = _bHorizontal ? _W : 1;
+	Params.LinesCount = _bHorizontal ? _H : _W;
+	Params.Radius = _Radius;
+	Params.WindowSize = 2*_Radius+1;
+	Params.PaddedCount = ((Params.Count + 2*_Radius + Params.WindowSize-1) / Params.WindowSize) * Params.WindowSize;
+	Params.bMax = _bMax;
+
+	__PlaneJob	Job;
+	Job.pProcessTask = VanHerkStripTask;
+	Job.pParams = &Params;
+	Job.TasksCount = (Params.LinesCount + MORPH_STRIP_WIDTH-1) / MORPH_STRIP_WIDTH;
+	Job.ScratchSize = 2 * MORPH_STRIP_WIDTH * Params.PaddedCount;
+	RunPlaneJob( Job );
+}
 
-//////////////////////////////////////////////////////////////////////////
-// Dilation
-struct __DilationStruct
+struct	__DiskSpanParams
 {
-	Pixel*	pSource;
-	int		W, H;
-	int		Size;
+	const float*	pRows;		// The rows filtered with the span width
+	float*			pDisk;
+	int				W, H;
+	int				DY;			// The rows are shifted up and down by this amount
+	bool			bMax;
 };
-void	FillDilate( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData )
+
+// Accumulates the shifted filtered rows into a tile of rows of the disk
+static void	DiskSpanTask( const __PlaneJob& _Job, int _TaskIndex, float* _pScratch )
 {
-	__DilationStruct&	Params = *((__DilationStruct*) _pData);
+	const __DiskSpanParams&	Params = *((const __DiskSpanParams*) _Job.pParams);
+	int		W = Params.W, H = Params.H;
+	int		YEnd = MIN( (_TaskIndex+1) * MORPH_TILE_ROWS, H );
+	for ( int Y=_TaskIndex * MORPH_TILE_ROWS; Y < YEnd; Y++ )
+	{
+		float*	pTarget = Params.pDisk + W*Y;
+		if ( Params.DY == 0 )
+		{
+			memcpy( pTarget, Params.pRows + W*Y, W*sizeof(float) );
+			continue;
+		}
 
-	_Pixel.RGBA = -FLOAT32_MAX * float4::One;
-	_Pixel.Height = -FLOAT32_MAX;
-	_Pixel.Roughness = -FLOAT32_MAX;
-	for ( int Y=_Y-Params.Size; Y <= _Y+Params.Size; Y++ )
+		for ( int Sign=-1; Sign <= 1; Sign+=2 )
+		{
+			const float*	pSource = Params.pRows + W * ((Y + Sign*Params.DY + H * (1 + Params.DY / H)) % H);
+			if ( Params.bMax )
+				for ( int X=0; X < W; X++ )
+					pTarget[X] = MAX( pTarget[X], pSource[X] );
+			else
+				for ( int X=0; X < W; X++ )
+					pTarget[X] = MIN( pTarget[X], pSource[X] );
+		}
+	}
+}
+
+// Erodes (or dilates) a plane in place using the given structuring element
+//	_pTemp and _pDisk are temporary planes only used by disks
+static void	MorphPlane( float* _pPlane, float* _pTemp, float* _pDisk, int _W, int _H, int _Radius, Filters::STRUCTURING_ELEMENT _Element, bool _bMax )
+{
+	switch ( _Element )
 	{
-		int		SampleY = ((Params.H+Y) % Params.H);
-		Pixel*	pScanline = &Params.pSource[Params.W * SampleY];
-		for ( int X=_X-Params.Size; X <= _X+Params.Size; X++ )
+	case Filters::SE_SQUARE:
+		VanHerk( _pPlane, _W, _H, _Radius, _bMax, true );
+		VanHerk( _pPlane, _W, _H, _Radius, _bMax, false );
+		break;
+
+	case Filters::SE_LINE_H:
+		VanHerk( _pPlane, _W, _H, _Radius, _bMax, true );
+		break;
+
+	case Filters::SE_LINE_V:
+		VanHerk( _pPlane, _W, _H, _Radius, _bMax, false );
+		break;
+
+	case Filters::SE_DISK:
+	{
+		// The disk is the union of the horizontal spans of each of its rows: the result is the min/max of the rows filtered
+		//	with the span widths, shifted vertically. Rows sharing the same span width (i.e. symmetric rows) are filtered only once.
+		__DiskSpanParams	Params;
+		Params.pRows = _pTemp;
+		Params.pDisk = _pDisk;
+		Params.W = _W;
+		Params.H = _H;
+		Params.bMax = _bMax;
+
+		__PlaneJob	Job;
+		Job.pProcessTask = DiskSpanTask;
+		Job.pParams = &Params;
+		Job.TasksCount = (_H + MORPH_TILE_ROWS-1) / MORPH_TILE_ROWS;
+		Job.ScratchSize = 0;
+
+		for ( int DY=0; DY <= _Radius; DY++ )
 		{
-			int	SampleX = (Params.W+X) % Params.W;
-			_Pixel.RGBA = _Pixel.RGBA.Max( pScanline[SampleX].RGBA );
-			_Pixel.Height = MAX( _Pixel.Height, pScanline[SampleX].Height );
-			_Pixel.Roughness = MAX( _Pixel.Roughness, pScanline[SampleX].Roughness );
+			int	SpanRadius = int( floorf( sqrtf( float(_Radius*_Radius - DY*DY) ) ) );
+			memcpy( _pTemp, _pPlane, _W*_H*sizeof(float) );
+			VanHerk( _pTemp, _W, _H, SpanRadius, _bMax, true );
+
+			Params.DY = DY;
+			RunPlaneJob( Job );
 		}
+
+		memcpy( _pPlane, _pDisk, _W*_H*sizeof(float) );
+		break;
+	}
 	}
 }
 
-void	Filters::Dilate( TextureBuilder& _Builder, int _KernelSize )
+static void	ApplyMorphology( TextureBuilder& _Builder, int _KernelSize, Filters::STRUCTURING_ELEMENT _Element, MORPH_OPERATION _Operation )
 {
-	TextureBuilder	Temp( _Builder.GetWidth(), _Builder.GetHeight() );
-	Temp.CopyFrom( _Builder );
+	int		W = _Builder.GetWidth(), H = _Builder.GetHeight();
+	int		Radius = MAX( 0, _KernelSize );
+
+	// Allocate the planes: the channel, the original channel for top-hats, and 2 planes for disks
+	int		PlaneSize = W*H;
+	float*	pAllocation = new float[4*PlaneSize];
+	float*	pPlane = pAllocation;
+	float*	pOriginal = pPlane + PlaneSize;
+	float*	pTemp = pOriginal + PlaneSize;
+	float*	pDisk = pTemp + PlaneSize;
+
+	Pixel*	pPixels = _Builder.GetMips()[0];
+	for ( int ChannelIndex=0; ChannelIndex < PLANE_CHANNELS_COUNT; ChannelIndex++ )
+	{
+		for ( int PixelIndex=0; PixelIndex < PlaneSize; PixelIndex++ )
+			pPlane[PixelIndex] = *GetPlaneChannel( pPixels[PixelIndex], ChannelIndex );
+		if ( _Operation == MORPH_TOP_HAT || _Operation == MORPH_BLACK_TOP_HAT )
+			memcpy( pOriginal, pPlane, PlaneSize*sizeof(float) );
+
+		switch ( _Operation )
+		{
+		case MORPH_ERODE:
+			MorphPlane( pPlane, pTemp, pDisk, W, H, Radius, _Element, false );
+			break;
+		case MORPH_DILATE:
+			MorphPlane( pPlane, pTemp, pDisk, W, H, Radius, _Element, true );
+			break;
+		case MORPH_OPEN:
+		case MORPH_TOP_HAT:
+			MorphPlane( pPlane, pTemp, pDisk, W, H, Radius, _Element, false );
+			MorphPlane( pPlane, pTemp, pDisk, W, H, Radius, _Element, true );
+			break;
+		case MORPH_CLOSE:
+		case MORPH_BLACK_TOP_HAT:
+			MorphPlane( pPlane, pTemp, pDisk, W, H, Radius, _Element, true );
+			MorphPlane( pPlane, pTemp, pDisk, W, H, Radius, _Element, false );
+			break;
+		}
 
-	__DilationStruct	Params;
-	Params.pSource = Temp.GetMips()[0];
-	Params.W = Temp.GetWidth();
-	Params.H = Temp.GetHeight();
-	Params.Size = _KernelSize;
+		if ( _Operation == MORPH_TOP_HAT )
+			for ( int PixelIndex=0; PixelIndex < PlaneSize; PixelIndex++ )
+				pPlane[PixelIndex] = pOriginal[PixelIndex] - pPlane[PixelIndex];
+		else if ( _Operation == MORPH_BLACK_TOP_HAT )
+			for ( int PixelIndex=0; PixelIndex < PlaneSize; PixelIndex++ )
+				pPlane[PixelIndex] = pPlane[PixelIndex] - pOriginal[PixelIndex];
 
-	_Builder.Fill( FillDilate, &Params );
+		for ( int PixelIndex=0; PixelIndex < PlaneSize; PixelIndex++ )
+			*GetPlaneChannel( pPixels[PixelIndex], ChannelIndex ) = pPlane[PixelIndex];
+	}
+
+	delete[] pAllocation;
+	_Builder.InvalidateMips();
 }
+
+void	Filters::Erode( TextureBuilder& _Builder, int _KernelSize, STRUCTURING_ELEMENT _Element )		{ ApplyMorphology( _Builder, _KernelSize, _Element, MORPH_ERODE ); }
+void	Filters::Dilate( TextureBuilder& _Builder, int _KernelSize, STRUCTURING_ELEMENT _Element )		{ ApplyMorphology( _Builder, _KernelSize, _Element, MORPH_DILATE ); }
+void	Filters::Open( TextureBuilder& _Builder, int _KernelSize, STRUCTURING_ELEMENT _Element )		{ ApplyMorphology( _Builder, _KernelSize, _Element, MORPH_OPEN ); }
+void	Filters::Close( TextureBuilder& _Builder, int _KernelSize, STRUCTURING_ELEMENT _Element )		{ ApplyMorphology( _Builder, _KernelSize, _Element, MORPH_CLOSE ); }
+void	Filters::TopHat( TextureBuilder& _Builder, int _KernelSize, STRUCTURING_ELEMENT _Element )		{ ApplyMorphology( _Builder, _KernelSize, _Element, MORPH_TOP_HAT ); }
+void	Filters::BlackTopHat( TextureBuilder& _Builder, int _KernelSize, STRUCTURING_ELEMENT _Element )	{ ApplyMorphology( _Builder, _KernelSize, _Element, MORPH_BLACK_TOP_HAT ); }
@@ -16,7 +16,21 @@ public:		// METHODS
 
 	static void	Emboss( TextureBuilder& _Builder, const float2& _Direction, float _Amplitude=1.0f );
 
-	static void	Erode( TextureBuilder& _Builder, int _KernelSize=4 );
+	// Shapes of the structuring elements used by the morphological operators
+	enum STRUCTURING_ELEMENT
+	{
+		SE_SQUARE,		// (2*KernelSize+1) square
+		SE_DISK,		// Disk of radius KernelSize (costs O(KernelSize) per pixel while the other elements cost O(1))
+		SE_LINE_H,		// Horizontal line of 2*KernelSize+1 pixels
+		SE_LINE_V,		// Vertical line of 2*KernelSize+1 pixels
+	};
 
-	static void	Dilate( TextureBuilder& _Builder, int _KernelSize=4 );
+	// Morphological operators on the RGBA, Height and Roughness channels, wrapping around the texture borders
+	//	_KernelSize is the radius of the structuring element in pixels
+	static void	Erode( TextureBuilder& _Builder, int _KernelSize=4, STRUCTURING_ELEMENT _Element=SE_SQUARE );
+	static void	Dilate( TextureBuilder& _Builder, int _KernelSize=4, STRUCTURING_ELEMENT _Element=SE_SQUARE );
+	static void	Open( TextureBuilder& _Builder, int _KernelSize=4, STRUCTURING_ELEMENT _Element=SE_SQUARE );		// Erosion followed by dilation
+	static void	Close( TextureBuilder& _Builder, int _KernelSize=4, STRUCTURING_ELEMENT _Element=SE_SQUARE );		// Dilation followed by erosion
+	static void	TopHat( TextureBuilder& _Builder, int _KernelSize=4, STRUCTURING_ELEMENT _Element=SE_SQUARE );		// Original minus opening (isolates small bright features)
+	static void	BlackTopHat( TextureBuilder& _Builder, int _KernelSize=4, STRUCTURING_ELEMENT _Element=SE_SQUARE );	// Closing minus original (isolates small dark features)
 };
@@ -40,7 +40,7 @@ void Generators::ComputeNormal( const TextureBuilder& _Source, TextureBuilder& _
 	Params.HeightFactor = _HeightFactor;
 	Params.bNormalize = _bNormalize;
 
-	_Target.Fill( FillNormal, &Params );
+	_Target.Fill( FillNormal, &Params, &_Source != &_Target );
 }
 
 
@@ -98,8 +98,14 @@ void	FillAO( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData )
 	_Pixel.RGBA.Set( SumAO, SumAO, SumAO, SumAO );
 }
 
-void Generators::ComputeAO( const TextureBuilder& _Source, TextureBuilder& _Target, float _HeightFactor, int _DirectionsCount, int _SamplesCount, bool _bWriteOnlyAlpha )
+void Generators::ComputeAO( const TextureBuilder& _Source, TextureBuilder& _Target, float _HeightFactor, int _DirectionsCount, int _SamplesCount, bool _bWriteOnlyAlpha, AO_METHOD _Method )
 {
+	if ( _Method == AO_HORIZON )
+	{	// The horizon sweep doesn't depend on a samples count and wraps like the sampling below
+		ComputeHorizonAO( _Source, _Target, _HeightFactor, _DirectionsCount, true, _bWriteOnlyAlpha );
+		return;
+	}
+
 	__AOStruct	Params;
 	Params.pSource = &_Source;
 	Params.HeightFactor = _HeightFactor;
@@ -107,7 +113,188 @@ void Generators::ComputeAO( const TextureBuilder& _Source, TextureBuilder& _Targ
 	Params.SamplesCount = _SamplesCount;
 	Params.bWriteOnlyAlpha = _bWriteOnlyAlpha;
 
-	_Target.Fill( FillAO, &Params );
+	_Target.Fill( FillAO, &Params, &_Source != &_Target );
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Horizon AO
+// The horizon of each direction is found by sweeping the whole height field once along parallel lines rather than marching a fixed amount
+//	of samples from every texel.
+// NOTE: the visibility measure differs from FillAO(): the slope of the horizon is the height of the occluder *relative to the texel* divided
+//	by its distance (i.e. the actual elevation angle of the horizon) whereas FillAO() divides the absolute height of the occluder by (1+distance).
+//	Both give the same results on flat ground but the horizon method doesn't darken high plateaus, so the two methods don't match exactly.
+// Each line is walked backward (i.e. toward -Direction) so the texels already visited are the ones lying in the direction we're looking at.
+//	We keep the upper convex hull of the (distance, height) profile visited so far in a stack: the hull vertex on top of the stack after
+//	inserting a new texel is the one giving the steepest horizon, and each texel is pushed and popped at most once.
+// The cost is thus O(Pixels x Directions) whatever the distance to the occluders.
+//
+struct __HorizonAOJob
+{
+	int				Width;
+	int				Height;
+	const float*	pHeights;			// Heights of the source, already scaled by the height factor
+	int				DirectionsCount;
+	bool			bWrap;
+	float**			ppAccumulators;		// One visibility accumulator per thread
+	int				MaxStackSize;
+	float*			pStacks;			// One pair of hull stacks (distances then heights) per thread
+};
+
+// Sweeps all the lines of a single direction and accumulates the visibility of each texel
+static void	SweepHorizonAO( const __HorizonAOJob& _Job, int _DirectionIndex, float* _pAccumulator, float* _pStackDistances, float* _pStackHeights )
+{
+	float	Angle = TWOPI * _DirectionIndex / _Job.DirectionsCount;
+	float2	Direction( cosf( Angle ), sinf( Angle ) );
+
+	// Walk one texel at a time along the major axis of the direction, the minor coordinate moves by a fraction of texel each step
+	bool	bMajorX = fabs( Direction.x ) >= fabs( Direction.y );
+	int		MajorSize = bMajorX ? _Job.Width : _Job.Height;
+	int		MinorSize = bMajorX ? _Job.Height : _Job.Width;
+	int		MajorStride = bMajorX ? 1 : _Job.Width;
+	int		MinorStride = bMajorX ? _Job.Width : 1;
+	float	Major = bMajorX ? Direction.x : Direction.y;
+	float	Minor = bMajorX ? Direction.y : Direction.x;
+	int		MajorStep = Major > 0.0f ? -1 : 1;			// Walking backward
+	float	MinorStep = -Minor / fabs( Major );
+	float	StepLength = sqrtf( 1.0f + MinorStep*MinorStep );
+	int		MajorStart = MajorStep < 0 ? MajorSize-1 : 0;
+
+	// When wrapping, each line goes twice around the texture: the first lap only gathers the occluders lying behind the texture's border
+	// When clamping, lines start at the border and extra lines are needed to cover the texels the slanted lines enter on the sides
+	int		StepsCount = _Job.bWrap ? 2*MajorSize : MajorSize;
+	int		FirstWrittenStep = _Job.bWrap ? MajorSize : 0;
+	float	MinorDrift = (MajorSize-1) * MinorStep;
+	int		FirstLine = _Job.bWrap ? 0 : int( floorf( MIN( 0.0f, -MinorDrift ) ) );
+	int		LastLine = _Job.bWrap ? MinorSize-1 : MinorSize-1 + int( ceilf( MAX( 0.0f, -MinorDrift ) ) );
+
+	for ( int Line=FirstLine; Line <= LastLine; Line++ )
+	{
+		int		StackSize = 0;
+		int		MajorPosition = MajorStart;
+		for ( int StepIndex=0; StepIndex < StepsCount; StepIndex++, MajorPosition += MajorStep )
+		{
+			float	MinorPosition = Line + StepIndex * MinorStep;	// Not accumulated so the error doesn't drift along the 2 laps of long lines
+			if ( MajorPosition < 0 )
+				MajorPosition += MajorSize;
+			else if ( MajorPosition >= MajorSize )
+				MajorPosition -= MajorSize;
+
+			// Interpolate the height along the minor axis
+			int		Minor0 = int( floorf( MinorPosition ) );
+			float	t = MinorPosition - Minor0;
+			int		Minor1 = Minor0+1;
+			int		MinorTexel = t < 0.5f ? Minor0 : Minor1;
+			if ( _Job.bWrap )
+			{
+				Minor0 = (Minor0 % MinorSize + MinorSize) % MinorSize;
+				Minor1 = Minor0 < MinorSize-1 ? Minor0+1 : 0;
+				MinorTexel = t < 0.5f ? Minor0 : Minor1;
+			}
+			else
+			{
+				if ( MinorTexel < 0 || MinorTexel >= MinorSize )
+					continue;	// Outside of the height field, nothing to occlude nor to write
+				Minor0 = MAX( 0, Minor0 );
+				Minor1 = MIN( MinorSize-1, Minor1 );
+			}
+
+			const float*	pMajor = _Job.pHeights + MajorStride*MajorPosition;
+			float	Height = (1.0f - t) * pMajor[MinorStride*Minor0] + t * pMajor[MinorStride*Minor1];
+			float	Distance = StepIndex * StepLength;
+
+			// Pop the hull vertices that are now hidden below the segment joining the new texel to the vertex behind them
+			while ( StackSize >= 2 )
+			{
+				float	SlopeTop = (_pStackHeights[StackSize-1] - Height) / (Distance - _pStackDistances[StackSize-1]);
+				float	SlopeBelow = (_pStackHeights[StackSize-2] - Height) / (Distance - _pStackDistances[StackSize-2]);
+				if ( SlopeBelow < SlopeTop )
+					break;
+				StackSize--;
+			}
+
+			if ( StepIndex >= FirstWrittenStep )
+			{
+				float	MaxSlope = 0.0f;
+				if ( StackSize > 0 )
+					MaxSlope = MAX( 0.0f, (_pStackHeights[StackSize-1] - Height) / (Distance - _pStackDistances[StackSize-1]) );
+
+				_pAccumulator[MajorStride*MajorPosition + MinorStride*MinorTexel] += HALFPI - atanf( MaxSlope );
+			}
+
+			_pStackDistances[StackSize] = Distance;
+			_pStackHeights[StackSize] = Height;
+			StackSize++;
+		}
+	}
+}
+
+static void	HorizonAODirectionTask( int _DirectionIndex, int _ThreadIndex, void* _pJob )
+{
+	const __HorizonAOJob&	Job = *((const __HorizonAOJob*) _pJob);
+	float*	pStackDistances = Job.pStacks + 2*Job.MaxStackSize*_ThreadIndex;
+	float*	pStackHeights = pStackDistances + Job.MaxStackSize;
+	SweepHorizonAO( Job, _DirectionIndex, Job.ppAccumulators[_ThreadIndex], pStackDistances, pStackHeights );
+}
+
+void Generators::ComputeHorizonAO( const TextureBuilder& _Source, TextureBuilder& _Target, float _HeightFactor, int _DirectionsCount, bool _bWrap, bool _bWriteOnlyAlpha )
+{
+	int	W = _Source.GetWidth();
+	int	H = _Source.GetHeight();
+	ASSERT( _Target.GetWidth() == W && _Target.GetHeight() == H, "Source and target must have the same size!" );
+
+	// Copy the heights first so the source and target can be the same builder
+	__HorizonAOJob	Job;
+	Job.Width = W;
+	Job.Height = H;
+	Job.DirectionsCount = _DirectionsCount;
+	Job.bWrap = _bWrap;
+	Job.MaxStackSize = 2 * MAX( W, H );
+
+	float*	pHeights = new float[W*H];
+	for ( int Y=0; Y < H; Y++ )
+		for ( int X=0; X < W; X++ )
+		{
+			Pixel	P;
+			_Source.Get( X, Y, 0, P );
+			pHeights[W*Y+X] = _HeightFactor * P.Height;
+		}
+	Job.pHeights = pHeights;
+
+	// Directions are spread across all the processors, each thread accumulates into its own buffer
+	int		ThreadsCount = WorkerPool::GetThreadsCount( _DirectionsCount );
+	float**	ppAccumulators = new float*[ThreadsCount];
+	for ( int ThreadIndex=0; ThreadIndex < ThreadsCount; ThreadIndex++ )
+	{
+		ppAccumulators[ThreadIndex] = new float[W*H];
+		memset( ppAccumulators[ThreadIndex], 0, W*H*sizeof(float) );
+	}
+	Job.ppAccumulators = ppAccumulators;
+	Job.pStacks = new float[2*Job.MaxStackSize*ThreadsCount];
+
+	WorkerPool::ParallelFor( _DirectionsCount, HorizonAODirectionTask, &Job );
+
+	// Sum the accumulators and normalize (the ones of the threads that didn't run are still 0)
+	float	Normalizer = 1.0f / (HALFPI * _DirectionsCount);
+	Pixel*	pTarget = _Target.GetMips()[0];
+	for ( int PixelIndex=0; PixelIndex < W*H; PixelIndex++ )
+	{
+		float	SumAO = 0.0f;
+		for ( int AccumulatorIndex=0; AccumulatorIndex < ThreadsCount; AccumulatorIndex++ )
+			SumAO += ppAccumulators[AccumulatorIndex][PixelIndex];
+		SumAO *= Normalizer;
+
+		pTarget[PixelIndex].RGBA.w = SumAO;
+		if ( !_bWriteOnlyAlpha )
+			pTarget[PixelIndex].RGBA.Set( SumAO, SumAO, SumAO, SumAO );
+	}
+	_Target.InvalidateMips();
+
+	for ( int ThreadIndex=0; ThreadIndex < ThreadsCount; ThreadIndex++ )
+		delete[] ppAccumulators[ThreadIndex];
+	delete[] ppAccumulators;
+	delete[] Job.pStacks;
+	delete[] pHeights;
 }
 
 
@@ -163,6 +350,7 @@ void	Generators::Dirtyness( TextureBuilder& _Builder, const Noise& _Noise, float
 		P.RGBA.Set( InitialValue, InitialValue, InitialValue, 0.0f );
 	}
 
+	// Each line is computed from the previous line of the same builder so this fill must remain serial
 	_Builder.Fill( FillDirtyness, &Params );
 }
 
@@ -233,7 +421,7 @@ void	Generators::Marble( TextureBuilder& _Builder, float _HeightFactor, int _Boo
 	Params.HeightFactor = _HeightFactor;
 	Params.Factor = 1.0f / (Max - Min);
 	Params.pBuffer = pBuffer + W * _BootSize;
-	_Builder.Fill( FillMarble, &Params );
+	_Builder.Fill( FillMarble, &Params, true );
 
 	delete[] pBuffer;
 }
@@ -5,13 +5,28 @@
 
 class	Generators
 {
+public:		// NESTED TYPES
+
+	enum AO_METHOD
+	{
+		AO_SAMPLED,		// Marches _SamplesCount texels from every texel in each direction
+		AO_HORIZON,		// Sweeps the whole height field once per direction, the horizon isn't limited to a distance (see ComputeHorizonAO())
+	};
+
 public:		// METHODS
 
 	// Computes the normal from a source texture's height field
 	static void ComputeNormal( const TextureBuilder& _Source, TextureBuilder& _Target, float _HeightFactor=1.0f, bool _bNormalize=true );
 
 	// Computes the ambient occlusion from a source texture's height field
-	static void ComputeAO( const TextureBuilder& _Source, TextureBuilder& _Target, float _HeightFactor=1.0f, int _DirectionsCount=8, int _SamplesCount=8, bool _bWriteOnlyAlpha=false );
+	//	_SamplesCount is ignored by the AO_HORIZON method
+	static void ComputeAO( const TextureBuilder& _Source, TextureBuilder& _Target, float _HeightFactor=1.0f, int _DirectionsCount=8, int _SamplesCount=8, bool _bWriteOnlyAlpha=false, AO_METHOD _Method=AO_SAMPLED );
+
+	// Computes the ambient occlusion from a source texture's height field by sweeping lines across the height field for each direction
+	//	The cost is O(Pixels x Directions) whatever the distance of the occluders, directions are spread across all the processors
+	//	_bWrap, true for tiling textures: each line walks 2 laps around the texture so occluders are searched across the borders
+	//		from at least one and up to almost 2 texture sizes away, otherwise the outside of the height field doesn't occlude
+	static void ComputeHorizonAO( const TextureBuilder& _Source, TextureBuilder& _Target, float _HeightFactor=1.0f, int _DirectionsCount=8, bool _bWrap=true, bool _bWriteOnlyAlpha=false );
 
 	// Fills a texture with dirtyness/moss/mouldiness leaking from the top of the texture
 	//	_InitialIntensity, intensity for initialization
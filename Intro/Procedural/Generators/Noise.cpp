@@ -1,4 +1,5 @@
 #include "../../GodComplex.h"
+#include <emmintrin.h>
 
 // Used to generate a normalized random vector of variable size
 #define GENERATE_AND_NORMALIZE( pNoise, Shift, Count )	\
@@ -21,6 +22,8 @@ const float	Noise::BIAS_T = 0.9887465321f;
 
 Noise::Noise( int _Seed )
 	: m_pWavelet2D( NULL )
+	, m_CellularCacheDimensions( 0 )
+	, m_pCellularCacheOffsets( NULL )
 {
 	_randpushseed();
 	_srand( _Seed, RAND_DEFAULT_SEED_V );
@@ -78,6 +81,8 @@ Noise::~Noise()
 
 	if ( m_pWavelet2D != NULL )
 		delete[] m_pWavelet2D;
+
+	DestroyCellularCache();
 }
 
 // This should generate a code like this:
@@ -389,10 +394,436 @@ float	Noise::WrapPerlin( const float3& uvw ) const
 	return Perlin( Pos0, Pos1 );
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Batched evaluation
+// Positions are evaluated 4 at a time using SSE. The N-dimensional gradient noise is the same for all dimensions:
+//	_ Each dimension gives a pair of lattice coordinates, offsets to those coordinates and an interpolation weight (the lattice)
+//	_ The 2^N corners are hashed dimension by dimension (sharing the permutations of the corners with a common prefix)
+//	_ The gradients are gathered and dotted with the offsets, then the corner values are interpolated dimension by dimension
+// The operations are carried out in the same order as the scalar versions so both give the same results.
+//
+// Grid fills exploit the coherence of the lattice coordinates: the lattices of the dimensions that only depend on X are computed once per column
+//	and those that don't depend on X are computed once per row.
+//
+struct	__NoiseLattice4
+{
+	union
+	{
+		__m128i	X[2];		// Lower and upper lattice coordinates
+		U32		pX[2][4];
+	};
+	__m128	Offset[2];		// Offsets to the lower (t) and upper (t-1) lattice coordinates
+	__m128	Weight;			// Interpolation weight SCurve(t)
+};
+
+// The intro's operator new (GlobalAlloc) only guarantees an 8 bytes alignment so arrays of lattices are over-allocated and aligned by hand
+//	(_pAllocation is the pointer to delete)
+static __NoiseLattice4*	AllocateLattices4( int _Count, U8*& _pAllocation )
+{
+	_pAllocation = new U8[_Count * sizeof(__NoiseLattice4) + 15];
+	return (__NoiseLattice4*) ((size_t(_pAllocation) + 15) & ~size_t(15));
+}
+
+static inline __m128	Lerp4( __m128 _p0, __m128 _p1, __m128 _x )
+{
+	return _mm_add_ps( _p0, _mm_mul_ps( _mm_sub_ps( _p1, _p0 ), _x ) );
+}
+
+static void	ComputeLattice4( __m128 _Coordinate, float _Bias, __NoiseLattice4& _Lattice )
+{
+	__m128	fX = _mm_mul_ps( _mm_add_ps( _mm_set1_ps( _Bias ), _Coordinate ), _mm_set1_ps( float(NOISE_SIZE) ) );
+
+	// Floor (SSE2 only truncates)
+	__m128i	iX = _mm_cvttps_epi32( fX );
+	__m128	Floor = _mm_cvtepi32_ps( iX );
+	__m128	Greater = _mm_cmpgt_ps( Floor, fX );
+	iX = _mm_add_epi32( iX, _mm_castps_si128( Greater ) );
+	Floor = _mm_sub_ps( Floor, _mm_and_ps( Greater, _mm_set1_ps( 1.0f ) ) );
+
+	__m128	t = _mm_sub_ps( fX, Floor );
+	__m128i	Mask = _mm_set1_epi32( NOISE_MASK );
+	_Lattice.X[0] = _mm_and_si128( iX, Mask );
+	_Lattice.X[1] = _mm_and_si128( _mm_add_epi32( _Lattice.X[0], _mm_set1_epi32( 1 ) ), Mask );
+	_Lattice.Offset[0] = t;
+	_Lattice.Offset[1] = _mm_sub_ps( t, _mm_set1_ps( 1.0f ) );
+
+	// t^3 (10 + t (-15 + 6 t))
+	__m128	Poly = _mm_add_ps( _mm_set1_ps( 10.0f ), _mm_mul_ps( t, _mm_add_ps( _mm_set1_ps( -15.0f ), _mm_mul_ps( t, _mm_set1_ps( 6.0f ) ) ) ) );
+	_Lattice.Weight = _mm_mul_ps( _mm_mul_ps( _mm_mul_ps( t, t ), t ), Poly );
+}
+
+// Evaluates the D-dimensional gradient noise for 4 positions given their lattices
+//	_pGradients, the table of random gradients for that dimension with a stride of (1 << _GradientShift) floats
+template<int D> static __m128	PerlinKernel4( const U32* _pPermutation, const float* _pGradients, int _GradientShift, const __NoiseLattice4* _pLattices )
+{
+	const int	CORNERS_COUNT = 1 << D;
+
+	// Hash the corners, the corner C uses the upper lattice coordinate of dimension d when its bit d is set
+	U32		ppHashes[CORNERS_COUNT][4];
+	for ( int Lane=0; Lane < 4; Lane++ )
+	{
+		ppHashes[0][Lane] = _pLattices[0].pX[0][Lane];
+		ppHashes[1][Lane] = _pLattices[0].pX[1][Lane];
+	}
+	for ( int Dimension=1; Dimension < D; Dimension++ )
+	{
+		const __NoiseLattice4&	Lattice = _pLattices[Dimension];
+		for ( int Corner=(1 << Dimension)-1; Corner >= 0; Corner-- )
+			for ( int Lane=0; Lane < 4; Lane++ )
+			{
+				U32	Hash = _pPermutation[ppHashes[Corner][Lane]];
+				ppHashes[Corner | (1 << Dimension)][Lane] = Hash + Lattice.pX[1][Lane];
+				ppHashes[Corner][Lane] = Hash + Lattice.pX[0][Lane];
+			}
+	}
+
+	// Dot the gradients with the offsets to the corners
+	__m128	pValues[CORNERS_COUNT];
+	for ( int Corner=0; Corner < CORNERS_COUNT; Corner++ )
+	{
+		const float*	pG0 = _pGradients + (_pPermutation[ppHashes[Corner][0]] << _GradientShift);
+		const float*	pG1 = _pGradients + (_pPermutation[ppHashes[Corner][1]] << _GradientShift);
+		const float*	pG2 = _pGradients + (_pPermutation[ppHashes[Corner][2]] << _GradientShift);
+		const float*	pG3 = _pGradients + (_pPermutation[ppHashes[Corner][3]] << _GradientShift);
+
+		__m128	Value = _mm_mul_ps( _mm_set_ps( pG3[0], pG2[0], pG1[0], pG0[0] ), _pLattices[0].Offset[Corner & 1] );
+		for ( int Dimension=1; Dimension < D; Dimension++ )
+			Value = _mm_add_ps( Value, _mm_mul_ps( _mm_set_ps( pG3[Dimension], pG2[Dimension], pG1[Dimension], pG0[Dimension] ), _pLattices[Dimension].Offset[(Corner >> Dimension) & 1] ) );
+		pValues[Corner] = Value;
+	}
+
+	// Interpolate the corners dimension by dimension
+	for ( int Dimension=0; Dimension < D; Dimension++ )
+	{
+		int	Count = CORNERS_COUNT >> (Dimension+1);
+		for ( int Index=0; Index < Count; Index++ )
+			pValues[Index] = Lerp4( pValues[2*Index+0], pValues[2*Index+1], _pLattices[Dimension].Weight );
+	}
+
+	return pValues[0];
+}
+
+// Gathers the component of 4 consecutive vectors, the last vector is repeated past the end of the array
+static __m128	LoadComponent4( const float* _pVectors, int _Stride, int _Component, U32 _Index, U32 _Count )
+{
+	float	pValues[4];
+	for ( int Lane=0; Lane < 4; Lane++ )
+		pValues[Lane] = _pVectors[_Stride * MIN( _Index+Lane, _Count-1 ) + _Component];
+	return _mm_loadu_ps( pValues );
+}
+
+static void		Store4( __m128 _Value, float* _pResult, U32 _Index, U32 _Count )
+{
+	if ( _Index+4 <= _Count )
+	{
+		_mm_storeu_ps( _pResult + _Index, _Value );
+		return;
+	}
+
+	float	pValues[4];
+	_mm_storeu_ps( pValues, _Value );
+	for ( U32 Lane=0; _Index+Lane < _Count; Lane++ )
+		_pResult[_Index+Lane] = pValues[Lane];
+}
+
+// e^x (Cephes polynomial, ~1e-7 relative error)
+static __m128	Exp4( __m128 _x )
+{
+	__m128	x = _mm_min_ps( _mm_max_ps( _x, _mm_set1_ps( -87.0f ) ), _mm_set1_ps( 88.0f ) );
+
+	// x = n ln(2) + r
+	__m128	fn = _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( 1.44269504088896341f ) ), _mm_set1_ps( 0.5f ) );
+	__m128i	n = _mm_cvttps_epi32( fn );
+	__m128	Floor = _mm_cvtepi32_ps( n );
+	__m128	Greater = _mm_cmpgt_ps( Floor, fn );
+	n = _mm_add_epi32( n, _mm_castps_si128( Greater ) );
+	Floor = _mm_sub_ps( Floor, _mm_and_ps( Greater, _mm_set1_ps( 1.0f ) ) );
+	__m128	r = _mm_sub_ps( _mm_sub_ps( x, _mm_mul_ps( Floor, _mm_set1_ps( 0.693359375f ) ) ), _mm_mul_ps( Floor, _mm_set1_ps( -2.12194440e-4f ) ) );
+
+	__m128	Poly = _mm_set1_ps( 1.9875691500e-4f );
+	Poly = _mm_add_ps( _mm_mul_ps( Poly, r ), _mm_set1_ps( 1.3981999507e-3f ) );
+	Poly = _mm_add_ps( _mm_mul_ps( Poly, r ), _mm_set1_ps( 8.3334519073e-3f ) );
+	Poly = _mm_add_ps( _mm_mul_ps( Poly, r ), _mm_set1_ps( 4.1665795894e-2f ) );
+	Poly = _mm_add_ps( _mm_mul_ps( Poly, r ), _mm_set1_ps( 1.6666665459e-1f ) );
+	Poly = _mm_add_ps( _mm_mul_ps( Poly, r ), _mm_set1_ps( 5.0000001201e-1f ) );
+	Poly = _mm_add_ps( _mm_add_ps( _mm_mul_ps( _mm_mul_ps( Poly, r ), r ), r ), _mm_set1_ps( 1.0f ) );
+
+	// Scale by 2^n
+	__m128	Scale = _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( n, _mm_set1_epi32( 127 ) ), 23 ) );
+	return _mm_mul_ps( Poly, Scale );
+}
+
+void	Noise::PerlinN( const float2* _pUV, float* _pResult, U32 _Count ) const
+{
+	__NoiseLattice4	pLattices[2];
+	for ( U32 Index=0; Index < _Count; Index+=4 )
+	{
+		ComputeLattice4( LoadComponent4( &_pUV[0].x, 2, 0, Index, _Count ), BIAS_U, pLattices[0] );
+		ComputeLattice4( LoadComponent4( &_pUV[0].x, 2, 1, Index, _Count ), BIAS_V, pLattices[1] );
+		Store4( PerlinKernel4<2>( m_pPermutation, m_pNoise2, 1, pLattices ), _pResult, Index, _Count );
+	}
+}
+
+void	Noise::PerlinN( const float3* _pUVW, float* _pResult, U32 _Count ) const
+{
+	__NoiseLattice4	pLattices[3];
+	for ( U32 Index=0; Index < _Count; Index+=4 )
+	{
+		ComputeLattice4( LoadComponent4( &_pUVW[0].x, 3, 0, Index, _Count ), BIAS_U, pLattices[0] );
+		ComputeLattice4( LoadComponent4( &_pUVW[0].x, 3, 1, Index, _Count ), BIAS_V, pLattices[1] );
+		ComputeLattice4( LoadComponent4( &_pUVW[0].x, 3, 2, Index, _Count ), BIAS_W, pLattices[2] );
+		Store4( PerlinKernel4<3>( m_pPermutation, m_pNoise3, 2, pLattices ), _pResult, Index, _Count );
+	}
+}
+
+// Computes the lattices of the 2 dimensions of a wrapping circle for 4 coordinates
+static void	WrapLattices4( const float* _pCoordinates, const float2& _Center, float _Radius, float _BiasX, float _BiasY, __NoiseLattice4& _LatticeX, __NoiseLattice4& _LatticeY )
+{
+	float	pX[4], pY[4];
+	for ( int Lane=0; Lane < 4; Lane++ )
+	{
+		float	Angle = TWOPI * _pCoordinates[Lane];
+		pX[Lane] = _Center.x + _Radius * cosf( Angle );
+		pY[Lane] = _Center.y + _Radius * sinf( Angle );
+	}
+
+	ComputeLattice4( _mm_loadu_ps( pX ), _BiasX, _LatticeX );
+	ComputeLattice4( _mm_loadu_ps( pY ), _BiasY, _LatticeY );
+}
+
+// Sums octaves of D-dimensional noise for 4 positions at a time
+//	_pPositions, an array of D-dimensional vectors
+//	_pBiases, the D biases of the dimensions
+template<int D> static void	Fractal4( const U32* _pPermutation, const float* _pGradients, int _GradientShift, const float* _pBiases, const float* _pPositions, float* _pResult, U32 _Count, float _FrequencyFactor, float _AmplitudeFactor, int _OctavesCount, bool _bRidged )
+{
+	__NoiseLattice4	pLattices[D];
+	__m128			pPosition[D];
+	for ( U32 Index=0; Index < _Count; Index+=4 )
+	{
+		for ( int Dimension=0; Dimension < D; Dimension++ )
+			pPosition[Dimension] = LoadComponent4( _pPositions, D, Dimension, Index, _Count );
+
+		__m128	Result = _mm_setzero_ps();
+		__m128	PreviousNoise = _mm_set1_ps( 1.0f );
+		float	Amplitude = 1.0f;
+		float	SumAmplitudes = 0.0f;
+		for ( int Octave=0; Octave < _OctavesCount; Octave++ )
+		{
+			for ( int Dimension=0; Dimension < D; Dimension++ )
+				ComputeLattice4( pPosition[Dimension], _pBiases[Dimension], pLattices[Dimension] );
+
+			__m128	NoiseValue = PerlinKernel4<D>( _pPermutation, _pGradients, _GradientShift, pLattices );
+			if ( _bRidged )
+			{
+				NoiseValue = Exp4( _mm_sub_ps( _mm_setzero_ps(), _mm_mul_ps( NoiseValue, NoiseValue ) ) );
+				Result = _mm_add_ps( Result, _mm_mul_ps( _mm_mul_ps( _mm_set1_ps( Amplitude ), PreviousNoise ), NoiseValue ) );
+				PreviousNoise = NoiseValue;
+			}
+			else
+				Result = _mm_add_ps( Result, _mm_mul_ps( _mm_set1_ps( Amplitude ), NoiseValue ) );
+
+			SumAmplitudes += Amplitude;
+			Amplitude *= _AmplitudeFactor;
+			for ( int Dimension=0; Dimension < D; Dimension++ )
+				pPosition[Dimension] = _mm_mul_ps( pPosition[Dimension], _mm_set1_ps( _FrequencyFactor ) );
+		}
+
+		Store4( _mm_div_ps( Result, _mm_set1_ps( SumAmplitudes ) ), _pResult, Index, _Count );
+	}
+}
+
+void	Noise::WrapPerlinN( const float2* _pUV, float* _pResult, U32 _Count ) const
+{
+	__NoiseLattice4	pLattices[4];
+	float			pCoordinates[4];
+	for ( U32 Index=0; Index < _Count; Index+=4 )
+	{
+		_mm_storeu_ps( pCoordinates, LoadComponent4( &_pUV[0].x, 2, 0, Index, _Count ) );
+		WrapLattices4( pCoordinates, m_WrapCenter0, m_WrapRadius, BIAS_U, BIAS_V, pLattices[0], pLattices[1] );
+		_mm_storeu_ps( pCoordinates, LoadComponent4( &_pUV[0].x, 2, 1, Index, _Count ) );
+		WrapLattices4( pCoordinates, m_WrapCenter1, m_WrapRadius, BIAS_W, BIAS_R, pLattices[2], pLattices[3] );
+		Store4( PerlinKernel4<4>( m_pPermutation, m_pNoise4, 2, pLattices ), _pResult, Index, _Count );
+	}
+}
+
+void	Noise::WrapPerlinN( const float3* _pUVW, float* _pResult, U32 _Count ) const
+{
+	__NoiseLattice4	pLattices[6];
+	float			pCoordinates[4];
+	for ( U32 Index=0; Index < _Count; Index+=4 )
+	{
+		_mm_storeu_ps( pCoordinates, LoadComponent4( &_pUVW[0].x, 3, 0, Index, _Count ) );
+		WrapLattices4( pCoordinates, m_WrapCenter0, m_WrapRadius, BIAS_U, BIAS_V, pLattices[0], pLattices[1] );
+		_mm_storeu_ps( pCoordinates, LoadComponent4( &_pUVW[0].x, 3, 1, Index, _Count ) );
+		WrapLattices4( pCoordinates, m_WrapCenter1, m_WrapRadius, BIAS_W, BIAS_R, pLattices[2], pLattices[3] );
+		_mm_storeu_ps( pCoordinates, LoadComponent4( &_pUVW[0].x, 3, 2, Index, _Count ) );
+		WrapLattices4( pCoordinates, m_WrapCenter2, m_WrapRadius, BIAS_S, BIAS_T, pLattices[4], pLattices[5] );
+		Store4( PerlinKernel4<6>( m_pPermutation, m_pNoise6, 3, pLattices ), _pResult, Index, _Count );
+	}
+}
+
+void	Noise::PerlinGrid( const float2& _Origin, const float2& _Step, int _SizeX, int _SizeY, float* _pResult ) const
+{
+	int					GroupsCount = (_SizeX+3) >> 2;
+	U8*					pAllocation;
+	__NoiseLattice4*	pColumns = AllocateLattices4( GroupsCount, pAllocation );
+	for ( int Group=0; Group < GroupsCount; Group++ )
+	{
+		float	pX[4];
+		for ( int Lane=0; Lane < 4; Lane++ )
+			pX[Lane] = _Origin.x + float( MIN( 4*Group+Lane, _SizeX-1 ) ) * _Step.x;
+		ComputeLattice4( _mm_loadu_ps( pX ), BIAS_U, pColumns[Group] );
+	}
+
+	__NoiseLattice4	pLattices[2];
+	for ( int Y=0; Y < _SizeY; Y++ )
+	{
+		ComputeLattice4( _mm_set1_ps( _Origin.y + float(Y) * _Step.y ), BIAS_V, pLattices[1] );
+
+		float*	pScanline = _pResult + _SizeX*Y;
+		for ( int Group=0; Group < GroupsCount; Group++ )
+		{
+			pLattices[0] = pColumns[Group];
+			Store4( PerlinKernel4<2>( m_pPermutation, m_pNoise2, 1, pLattices ), pScanline, 4*Group, _SizeX );
+		}
+	}
+
+	delete[] pAllocation;
+}
+
+void	Noise::PerlinGrid( const float3& _Origin, const float3& _Step, int _SizeX, int _SizeY, int _SizeZ, float* _pResult ) const
+{
+	int					GroupsCount = (_SizeX+3) >> 2;
+	U8*					pAllocation;
+	__NoiseLattice4*	pColumns = AllocateLattices4( GroupsCount, pAllocation );
+	for ( int Group=0; Group < GroupsCount; Group++ )
+	{
+		float	pX[4];
+		for ( int Lane=0; Lane < 4; Lane++ )
+			pX[Lane] = _Origin.x + float( MIN( 4*Group+Lane, _SizeX-1 ) ) * _Step.x;
+		ComputeLattice4( _mm_loadu_ps( pX ), BIAS_U, pColumns[Group] );
+	}
+
+	__NoiseLattice4	pLattices[3];
+	for ( int Z=0; Z < _SizeZ; Z++ )
+	{
+		ComputeLattice4( _mm_set1_ps( _Origin.z + float(Z) * _Step.z ), BIAS_W, pLattices[2] );
+		for ( int Y=0; Y < _SizeY; Y++ )
+		{
+			ComputeLattice4( _mm_set1_ps( _Origin.y + float(Y) * _Step.y ), BIAS_V, pLattices[1] );
+
+			float*	pScanline = _pResult + _SizeX*(_SizeY*Z+Y);
+			for ( int Group=0; Group < GroupsCount; Group++ )
+			{
+				pLattices[0] = pColumns[Group];
+				Store4( PerlinKernel4<3>( m_pPermutation, m_pNoise3, 2, pLattices ), pScanline, 4*Group, _SizeX );
+			}
+		}
+	}
+
+	delete[] pAllocation;
+}
+
+void	Noise::WrapPerlinGrid( const float2& _Origin, const float2& _Step, int _SizeX, int _SizeY, float* _pResult ) const
+{
+	int					GroupsCount = (_SizeX+3) >> 2;
+	U8*					pAllocation;
+	__NoiseLattice4*	pColumns = AllocateLattices4( 2*GroupsCount, pAllocation );
+	for ( int Group=0; Group < GroupsCount; Group++ )
+	{
+		float	pX[4];
+		for ( int Lane=0; Lane < 4; Lane++ )
+			pX[Lane] = _Origin.x + float( MIN( 4*Group+Lane, _SizeX-1 ) ) * _Step.x;
+		WrapLattices4( pX, m_WrapCenter0, m_WrapRadius, BIAS_U, BIAS_V, pColumns[2*Group+0], pColumns[2*Group+1] );
+	}
+
+	__NoiseLattice4	pLattices[4];
+	for ( int Y=0; Y < _SizeY; Y++ )
+	{
+		float	pY[4];
+		pY[0] = pY[1] = pY[2] = pY[3] = _Origin.y + float(Y) * _Step.y;
+		WrapLattices4( pY, m_WrapCenter1, m_WrapRadius, BIAS_W, BIAS_R, pLattices[2], pLattices[3] );
+
+		float*	pScanline = _pResult + _SizeX*Y;
+		for ( int Group=0; Group < GroupsCount; Group++ )
+		{
+			pLattices[0] = pColumns[2*Group+0];
+			pLattices[1] = pColumns[2*Group+1];
+			Store4( PerlinKernel4<4>( m_pPermutation, m_pNoise4, 2, pLattices ), pScanline, 4*Group, _SizeX );
+		}
+	}
+
+	delete[] pAllocation;
+}
+
+void	Noise::WrapPerlinGrid( const float3& _Origin, const float3& _Step, int _SizeX, int _SizeY, int _SizeZ, float* _pResult ) const
+{
+	int					GroupsCount = (_SizeX+3) >> 2;
+	U8*					pAllocation;
+	__NoiseLattice4*	pColumns = AllocateLattices4( 2*GroupsCount, pAllocation );
+	for ( int Group=0; Group < GroupsCount; Group++ )
+	{
+		float	pX[4];
+		for ( int Lane=0; Lane < 4; Lane++ )
+			pX[Lane] = _Origin.x + float( MIN( 4*Group+Lane, _SizeX-1 ) ) * _Step.x;
+		WrapLattices4( pX, m_WrapCenter0, m_WrapRadius, BIAS_U, BIAS_V, pColumns[2*Group+0], pColumns[2*Group+1] );
+	}
+
+	__NoiseLattice4	pLattices[6];
+	for ( int Z=0; Z < _SizeZ; Z++ )
+	{
+		float	pZ[4];
+		pZ[0] = pZ[1] = pZ[2] = pZ[3] = _Origin.z + float(Z) * _Step.z;
+		WrapLattices4( pZ, m_WrapCenter2, m_WrapRadius, BIAS_S, BIAS_T, pLattices[4], pLattices[5] );
+		for ( int Y=0; Y < _SizeY; Y++ )
+		{
+			float	pY[4];
+			pY[0] = pY[1] = pY[2] = pY[3] = _Origin.y + float(Y) * _Step.y;
+			WrapLattices4( pY, m_WrapCenter1, m_WrapRadius, BIAS_W, BIAS_R, pLattices[2], pLattices[3] );
+
+			float*	pScanline = _pResult + _SizeX*(_SizeY*Z+Y);
+			for ( int Group=0; Group < GroupsCount; Group++ )
+			{
+				pLattices[0] = pColumns[2*Group+0];
+				pLattices[1] = pColumns[2*Group+1];
+				Store4( PerlinKernel4<6>( m_pPermutation, m_pNoise6, 3, pLattices ), pScanline, 4*Group, _SizeX );
+			}
+		}
+	}
+
+	delete[] pAllocation;
+}
+
+void	Noise::FractionalBrownianMotionN( const float2* _pUV, float* _pResult, U32 _Count, float _FrequencyFactor, float _AmplitudeFactor, int _OctavesCount ) const
+{
+	float	pBiases[] = { BIAS_U, BIAS_V };
+	Fractal4<2>( m_pPermutation, m_pNoise2, 1, pBiases, &_pUV[0].x, _pResult, _Count, _FrequencyFactor, _AmplitudeFactor, _OctavesCount, false );
+}
+
+void	Noise::FractionalBrownianMotionN( const float3* _pUVW, float* _pResult, U32 _Count, float _FrequencyFactor, float _AmplitudeFactor, int _OctavesCount ) const
+{
+	float	pBiases[] = { BIAS_U, BIAS_V, BIAS_W };
+	Fractal4<3>( m_pPermutation, m_pNoise3, 2, pBiases, &_pUVW[0].x, _pResult, _Count, _FrequencyFactor, _AmplitudeFactor, _OctavesCount, false );
+}
+
+void	Noise::RidgedMultiFractalN( const float2* _pUV, float* _pResult, U32 _Count, float _FrequencyFactor, float _AmplitudeFactor, int _OctavesCount ) const
+{
+	float	pBiases[] = { BIAS_U, BIAS_V };
+	Fractal4<2>( m_pPermutation, m_pNoise2, 1, pBiases, &_pUV[0].x, _pResult, _Count, _FrequencyFactor, _AmplitudeFactor, _OctavesCount, true );
+}
+
+void	Noise::RidgedMultiFractalN( const float3* _pUVW, float* _pResult, U32 _Count, float _FrequencyFactor, float _AmplitudeFactor, int _OctavesCount ) const
+{
+	float	pBiases[] = { BIAS_U, BIAS_V, BIAS_W };
+	Fractal4<3>( m_pPermutation, m_pNoise3, 2, pBiases, &_pUVW[0].x, _pResult, _Count, _FrequencyFactor, _AmplitudeFactor, _OctavesCount, true );
+}
+
 //////////////////////////////////////////////////////////////////////////
 // Cellular noise
 void	Noise::SetCellularWrappingParameters( int _SizeX, int _SizeY, int _SizeZ )
 {
+	DestroyCellularCache();	// The cached cells depend on the sizes
+
 	m_SizeX = _SizeX;
 	m_SizeY = _SizeY;
 	m_SizeZ = _SizeZ;
@@ -724,6 +1155,451 @@ float	Noise::Worley( const float3& _UVW, CombineDistancesDelegate _Combine, void
 	return _Combine( pSqDistances, pCellX, pCellY, pCellZ, _pData );
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Cached & batched cellular/Worley noise
+// The feature points of the SizeX x SizeY (x SizeZ) cells can be generated once and for all with CreateCellularCache(),
+//	queries that are not wrapping and whose neighbors lie outside that range generate the points on the fly using the same hashing as Cellular() and Worley().
+//
+// A query first tests the feature points of its own cell and of the face neighbors, then the remaining neighbors are skipped
+//	if they lie farther than the current third closest distance. Candidate points are tested 4 at a time with SSE.
+//
+static const int	CELLULAR_MAX_POINTS_PER_CELL = 9;
+static const int	CELLULAR_NEAR_NEIGHBORS_COUNT_2D = 5;
+static const int	CELLULAR_NEAR_NEIGHBORS_COUNT_3D = 7;
+
+// Neighbor cells ordered by increasing distance (own cell, faces, edges then corners)
+static const int	CELLULAR_NEIGHBORS_2D[9][3] = {
+	{ 0, 0, 0 },
+	{ -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 },
+	{ -1, -1, 0 }, { 1, -1, 0 }, { -1, 1, 0 }, { 1, 1, 0 },
+};
+static const int	CELLULAR_NEIGHBORS_3D[27][3] = {
+	{ 0, 0, 0 },
+	{ -1, 0, 0 }, { 1, 0, 0 }, { 0, -1, 0 }, { 0, 1, 0 }, { 0, 0, -1 }, { 0, 0, 1 },
+	{ -1, -1, 0 }, { 1, -1, 0 }, { -1, 1, 0 }, { 1, 1, 0 }, { -1, 0, -1 }, { 1, 0, -1 }, { -1, 0, 1 }, { 1, 0, 1 }, { 0, -1, -1 }, { 0, 1, -1 }, { 0, -1, 1 }, { 0, 1, 1 },
+	{ -1, -1, -1 }, { 1, -1, -1 }, { -1, 1, -1 }, { 1, 1, -1 }, { -1, -1, 1 }, { 1, -1, 1 }, { -1, 1, 1 }, { 1, 1, 1 },
+};
+
+// The candidate feature points of a query
+struct	Noise::CellularCandidates
+{
+	static const int	MAX_POINTS = 27 * CELLULAR_MAX_POINTS_PER_CELL;
+
+	int		Count;
+	float	pX[MAX_POINTS+3];
+	float	pY[MAX_POINTS+3];
+	float	pZ[MAX_POINTS+3];
+	int		pNeighbor[MAX_POINTS];	// Index of the neighbor cell containing the point
+
+	int		pCellX[27];				// Cell coordinates of the neighbors (wrapped if wrapping)
+	int		pCellY[27];
+	int		pCellZ[27];
+};
+
+U32		Noise::CellularHash( U32 _Hx, U32 _Hy, U32 _Hz, int _Dimensions ) const
+{
+	// Hash the integers into a single integer using FNV hash (http://isthe.com/chongo/tech/comp/fnv/#FNV-source)
+	U32	Hash = U32( (((OFFSET_BASIS ^ _Hx) * FNV_PRIME) ^ _Hy) * FNV_PRIME );
+	if ( _Dimensions == 3 )
+		Hash = U32( (Hash ^ _Hz) * FNV_PRIME );
+	return Hash;
+}
+
+int		Noise::CellularGeneratePoints( U32 _Hash, int _Dimensions, bool _bWorley, float* _pX, float* _pY, float* _pZ ) const
+{
+	if ( !_bWorley )
+	{	// Cellular uses a single feature point
+		_pX[0] = LCGRandom( _Hash ) * 2.3283064370807973754314699618685e-10f;
+		_pY[0] = LCGRandom( _Hash ) * 2.3283064370807973754314699618685e-10f;
+		if ( _Dimensions == 3 )
+			_pZ[0] = LCGRandom( _Hash ) * 2.3283064370807973754314699618685e-10f;
+		return 1;
+	}
+
+	int	PointsCount = PoissonPointsCount( _Hash );
+	for ( int PointIndex=0; PointIndex < PointsCount; PointIndex++ )
+	{
+		_pX[PointIndex] = LCGRandom( _Hash ) * 2.3283064370807973754314699618685e-10f;
+		_pY[PointIndex] = LCGRandom( _Hash ) * 2.3283064370807973754314699618685e-10f;
+		if ( _Dimensions == 3 )
+			_pZ[PointIndex] = LCGRandom( _Hash ) * 2.3283064370807973754314699618685e-10f;
+	}
+	return PointsCount;
+}
+
+void	Noise::CreateCellularCache( int _Dimensions, bool _bWorley )
+{
+	DestroyCellularCache();
+
+	// The cells are surrounded by a border of wrapped cells so wrapping queries never need to wrap the neighbor cells
+	int	pPaddedSizes[3] = { m_SizeX+2, m_SizeY+2, _Dimensions == 3 ? m_SizeZ+2 : 1 };
+	m_pCellularCacheStrides[0] = 1;
+	m_pCellularCacheStrides[1] = pPaddedSizes[0];
+	m_pCellularCacheStrides[2] = _Dimensions == 3 ? pPaddedSizes[0] * pPaddedSizes[1] : 0;
+
+	int	CellsCount = pPaddedSizes[0] * pPaddedSizes[1] * pPaddedSizes[2];
+	m_pCellularCacheOffsets = new U32[CellsCount+1];
+
+	// Generate all the points at their maximum count then compact the arrays
+	float*	pX = new float[CELLULAR_MAX_POINTS_PER_CELL*CellsCount];
+	float*	pY = new float[CELLULAR_MAX_POINTS_PER_CELL*CellsCount];
+	float*	pZ = _Dimensions == 3 ? new float[CELLULAR_MAX_POINTS_PER_CELL*CellsCount] : NULL;
+
+	U32		PointsCount = 0;
+	int		CellIndex = 0;
+	for ( int Z=0; Z < pPaddedSizes[2]; Z++ )
+		for ( int Y=0; Y < pPaddedSizes[1]; Y++ )
+			for ( int X=0; X < pPaddedSizes[0]; X++, CellIndex++ )
+			{
+				U32	Hx = (X + m_SizeX-1) % m_SizeX;
+				U32	Hy = (Y + m_SizeY-1) % m_SizeY;
+				U32	Hz = _Dimensions == 3 ? (Z + m_SizeZ-1) % m_SizeZ : 0;
+
+				m_pCellularCacheOffsets[CellIndex] = PointsCount;
+				PointsCount += CellularGeneratePoints( CellularHash( Hx, Hy, Hz, _Dimensions ), _Dimensions, _bWorley, pX+PointsCount, pY+PointsCount, pZ != NULL ? pZ+PointsCount : NULL );
+			}
+	m_pCellularCacheOffsets[CellsCount] = PointsCount;
+
+	const float*	ppPoints[3] = { pX, pY, pZ };
+	for ( int Dimension=0; Dimension < 3; Dimension++ )
+	{
+		m_ppCellularCachePoints[Dimension] = NULL;
+		if ( Dimension >= _Dimensions )
+			continue;
+
+		m_ppCellularCachePoints[Dimension] = new float[PointsCount+3];	// Padded for 4-wide reads of the last cells
+		memcpy( m_ppCellularCachePoints[Dimension], ppPoints[Dimension], PointsCount*sizeof(float) );
+		memset( m_ppCellularCachePoints[Dimension] + PointsCount, 0, 3*sizeof(float) );
+	}
+
+	delete[] pX;
+	delete[] pY;
+	if ( pZ != NULL )
+		delete[] pZ;
+
+	m_CellularCacheDimensions = _Dimensions;
+	m_bCellularCacheWorley = _bWorley;
+}
+
+void	Noise::DestroyCellularCache()
+{
+	if ( m_pCellularCacheOffsets == NULL )
+		return;
+
+	delete[] m_pCellularCacheOffsets;
+	for ( int Dimension=0; Dimension < 3; Dimension++ )
+		if ( m_ppCellularCachePoints[Dimension] != NULL )
+			delete[] m_ppCellularCachePoints[Dimension];
+
+	m_pCellularCacheOffsets = NULL;
+	m_CellularCacheDimensions = 0;
+}
+
+// Appends the feature points of a neighbor cell to the candidates by generating them (i.e. when the cell is not cached)
+void	Noise::CellularGatherCell( int _X, int _Y, int _Z, int _Dimensions, bool _bWorley, bool _bWrap, int _Neighbor, CellularCandidates& _Candidates ) const
+{
+	U32	Hx = _bWrap ? (_X + 100*m_SizeX) % m_SizeX : _X;
+	U32	Hy = _bWrap ? (_Y + 100*m_SizeY) % m_SizeY : _Y;
+	U32	Hz = _Dimensions == 3 ? (_bWrap ? (_Z + 100*m_SizeZ) % m_SizeZ : _Z) : 0;
+	_Candidates.pCellX[_Neighbor] = Hx;
+	_Candidates.pCellY[_Neighbor] = Hy;
+	_Candidates.pCellZ[_Neighbor] = _Dimensions == 3 ? Hz : -1;
+
+	float	pX[CELLULAR_MAX_POINTS_PER_CELL], pY[CELLULAR_MAX_POINTS_PER_CELL], pZ[CELLULAR_MAX_POINTS_PER_CELL];
+	int		Count = CellularGeneratePoints( CellularHash( Hx, Hy, Hz, _Dimensions ), _Dimensions, _bWorley, pX, pY, pZ );
+	for ( int PointIndex=0; PointIndex < Count; PointIndex++ )
+	{
+		_Candidates.pX[_Candidates.Count] = _X + pX[PointIndex];
+		_Candidates.pY[_Candidates.Count] = _Y + pY[PointIndex];
+		_Candidates.pZ[_Candidates.Count] = _Dimensions == 3 ? _Z + pZ[PointIndex] : 0.0f;
+		_Candidates.pNeighbor[_Candidates.Count] = _Neighbor;
+		_Candidates.Count++;
+	}
+}
+
+// Inserts a feature point closer than the current third closest point
+static inline void	CellularInsert( Noise::CellularFeatures& _Features, float _SqDistance, int _CellX, int _CellY, int _CellZ )
+{
+	int	Slot = 2;
+	if ( _SqDistance < _Features.pSqDistances[1] )
+	{
+		_Features.pSqDistances[2] = _Features.pSqDistances[1];
+		_Features.pCellX[2] = _Features.pCellX[1];
+		_Features.pCellY[2] = _Features.pCellY[1];
+		_Features.pCellZ[2] = _Features.pCellZ[1];
+		Slot = 1;
+
+		if ( _SqDistance < _Features.pSqDistances[0] )
+		{
+			_Features.pSqDistances[1] = _Features.pSqDistances[0];
+			_Features.pCellX[1] = _Features.pCellX[0];
+			_Features.pCellY[1] = _Features.pCellY[0];
+			_Features.pCellZ[1] = _Features.pCellZ[0];
+			Slot = 0;
+		}
+	}
+	_Features.pSqDistances[Slot] = _SqDistance;
+	_Features.pCellX[Slot] = _CellX;
+	_Features.pCellY[Slot] = _CellY;
+	_Features.pCellZ[Slot] = _CellZ;
+}
+
+// Tests the candidates 4 at a time and inserts the ones closer than the current 3 closest points
+void	Noise::CellularTestCandidates( const float* _pPosition, int _Dimensions, CellularCandidates& _Candidates, CellularFeatures& _Features )
+{
+	// Pad the candidates with points at infinity
+	for ( int Lane=0; Lane < 3; Lane++ )
+	{
+		_Candidates.pX[_Candidates.Count+Lane] = FLOAT32_MAX;
+		_Candidates.pY[_Candidates.Count+Lane] = FLOAT32_MAX;
+		_Candidates.pZ[_Candidates.Count+Lane] = FLOAT32_MAX;
+	}
+
+	__m128	Px = _mm_set1_ps( _pPosition[0] );
+	__m128	Py = _mm_set1_ps( _pPosition[1] );
+	__m128	Pz = _mm_set1_ps( _pPosition[2] );
+	float	pSqDistances[4];
+	for ( int Index=0; Index < _Candidates.Count; Index+=4 )
+	{
+		__m128	Dx = _mm_sub_ps( Px, _mm_loadu_ps( _Candidates.pX + Index ) );
+		__m128	Dy = _mm_sub_ps( Py, _mm_loadu_ps( _Candidates.pY + Index ) );
+		__m128	SqDistance = _mm_add_ps( _mm_mul_ps( Dx, Dx ), _mm_mul_ps( Dy, Dy ) );
+		if ( _Dimensions == 3 )
+		{
+			__m128	Dz = _mm_sub_ps( Pz, _mm_loadu_ps( _Candidates.pZ + Index ) );
+			SqDistance = _mm_add_ps( SqDistance, _mm_mul_ps( Dz, Dz ) );
+		}
+
+		int	Mask = _mm_movemask_ps( _mm_cmplt_ps( SqDistance, _mm_set1_ps( _Features.pSqDistances[2] ) ) );
+		if ( Mask == 0 )
+			continue;	// Early rejection
+
+		_mm_storeu_ps( pSqDistances, SqDistance );
+		for ( int Lane=0; Lane < 4; Lane++ )
+		{
+			if ( (Mask & (1 << Lane)) == 0 || pSqDistances[Lane] >= _Features.pSqDistances[2] )
+				continue;
+
+			int	Neighbor = _Candidates.pNeighbor[Index+Lane];
+			CellularInsert( _Features, pSqDistances[Lane], _Candidates.pCellX[Neighbor], _Candidates.pCellY[Neighbor], _Candidates.pCellZ[Neighbor] );
+		}
+	}
+}
+
+void	Noise::CellularQuery( const float* _pPosition, int _Dimensions, bool _bWorley, bool _bWrap, CellularFeatures& _Features ) const
+{
+	int		pSizes[3] = { m_SizeX, m_SizeY, m_SizeZ };
+	int		pCell[3] = { 0, 0, 0 };
+	float	pFraction[3] = { 0.0f, 0.0f, 0.0f };
+	bool	bCached = m_CellularCacheDimensions == _Dimensions && m_bCellularCacheWorley == _bWorley;
+	int		CacheIndex = 0;
+	int		ppWrappedCells[3][3] = { { -1, -1, -1 }, { -1, -1, -1 }, { -1, -1, -1 } };	// Wrapped coordinates of the neighbor cells for each dimension
+	for ( int Dimension=0; Dimension < _Dimensions; Dimension++ )
+	{
+		int	Cell = int( floorf( _pPosition[Dimension] ) );
+		int	Size = pSizes[Dimension];
+		pCell[Dimension] = Cell;
+		pFraction[Dimension] = _pPosition[Dimension] - Cell;
+
+		if ( _bWrap )
+		{
+			int	WrappedCell = Cell % Size;
+			WrappedCell += WrappedCell < 0 ? Size : 0;
+			ppWrappedCells[Dimension][0] = WrappedCell > 0 ? WrappedCell-1 : Size-1;
+			ppWrappedCells[Dimension][1] = WrappedCell;
+			ppWrappedCells[Dimension][2] = WrappedCell < Size-1 ? WrappedCell+1 : 0;
+			CacheIndex += (WrappedCell+1) * m_pCellularCacheStrides[Dimension];
+		}
+		else
+		{	// Without wrapping, only the neighbor cells inside the cached range can be read from the cache (the border cells are wrapped)
+			ppWrappedCells[Dimension][0] = Cell-1;
+			ppWrappedCells[Dimension][1] = Cell;
+			ppWrappedCells[Dimension][2] = Cell+1;
+			bCached &= Cell >= 1 && Cell < Size-1;
+			CacheIndex += (Cell+1) * m_pCellularCacheStrides[Dimension];
+		}
+	}
+
+	for ( int i=0; i < 3; i++ )
+	{
+		_Features.pSqDistances[i] = FLOAT32_MAX;
+		_Features.pCellX[i] = _Features.pCellY[i] = _Features.pCellZ[i] = -1;
+	}
+
+	if ( bCached && !_bWorley )
+	{	// Cellular noise has a single point per cell so the cache can be indexed by cell and the 3 neighbors along X are contiguous
+		__m128	Px = _mm_set1_ps( _pPosition[0] );
+		__m128	Py = _mm_set1_ps( _pPosition[1] );
+		__m128	Pz = _mm_set1_ps( _pPosition[2] );
+		__m128	CellsX = _mm_add_ps( _mm_set1_ps( float(pCell[0]) ), _mm_setr_ps( -1.0f, 0.0f, 1.0f, 0.0f ) );
+		float	pSqDistances[4];
+		for ( int Row=0; Row < (_Dimensions == 3 ? 9 : 3); Row++ )
+		{
+			int		OffsetY = Row % 3 - 1;
+			int		OffsetZ = _Dimensions == 3 ? Row / 3 - 1 : 0;
+			int		CellIndex = CacheIndex - 1 + OffsetY * m_pCellularCacheStrides[1] + OffsetZ * m_pCellularCacheStrides[2];
+
+			__m128	Dx = _mm_sub_ps( Px, _mm_add_ps( CellsX, _mm_loadu_ps( m_ppCellularCachePoints[0] + CellIndex ) ) );
+			__m128	Dy = _mm_sub_ps( Py, _mm_add_ps( _mm_set1_ps( float(pCell[1] + OffsetY) ), _mm_loadu_ps( m_ppCellularCachePoints[1] + CellIndex ) ) );
+			__m128	SqDistance = _mm_add_ps( _mm_mul_ps( Dx, Dx ), _mm_mul_ps( Dy, Dy ) );
+			if ( _Dimensions == 3 )
+			{
+				__m128	Dz = _mm_sub_ps( Pz, _mm_add_ps( _mm_set1_ps( float(pCell[2] + OffsetZ) ), _mm_loadu_ps( m_ppCellularCachePoints[2] + CellIndex ) ) );
+				SqDistance = _mm_add_ps( SqDistance, _mm_mul_ps( Dz, Dz ) );
+			}
+
+			int	Mask = _mm_movemask_ps( _mm_cmplt_ps( SqDistance, _mm_set1_ps( _Features.pSqDistances[2] ) ) ) & 7;
+			if ( Mask == 0 )
+				continue;
+
+			_mm_storeu_ps( pSqDistances, SqDistance );
+			for ( int Lane=0; Lane < 3; Lane++ )
+				if ( (Mask & (1 << Lane)) != 0 && pSqDistances[Lane] < _Features.pSqDistances[2] )
+					CellularInsert( _Features, pSqDistances[Lane], ppWrappedCells[0][Lane], ppWrappedCells[1][1+OffsetY], ppWrappedCells[2][1+OffsetZ] );
+		}
+		return;
+	}
+
+	const int	(*pNeighbors)[3] = _Dimensions == 3 ? CELLULAR_NEIGHBORS_3D : CELLULAR_NEIGHBORS_2D;
+	int			NeighborsCount = _Dimensions == 3 ? 27 : 9;
+	int			NearNeighborsCount = _Dimensions == 3 ? CELLULAR_NEAR_NEIGHBORS_COUNT_3D : CELLULAR_NEAR_NEIGHBORS_COUNT_2D;
+
+	CellularCandidates	Candidates;
+	for ( int Pass=0; Pass < 2; Pass++ )
+	{
+		Candidates.Count = 0;
+		for ( int Neighbor=Pass == 0 ? 0 : NearNeighborsCount; Neighbor < (Pass == 0 ? NearNeighborsCount : NeighborsCount); Neighbor++ )
+		{
+			const int*	pOffset = pNeighbors[Neighbor];
+			if ( Pass > 0 )
+			{	// Skip the cells that are farther than the third closest point
+				float	SqDistance = 0.0f;
+				for ( int Dimension=0; Dimension < _Dimensions; Dimension++ )
+				{
+					float	Distance = pOffset[Dimension] < 0 ? pFraction[Dimension] : (pOffset[Dimension] > 0 ? 1.0f - pFraction[Dimension] : 0.0f);
+					SqDistance += Distance * Distance;
+				}
+				if ( SqDistance >= _Features.pSqDistances[2] )
+					continue;
+			}
+
+			int	X = pCell[0] + pOffset[0];
+			int	Y = pCell[1] + pOffset[1];
+			int	Z = pCell[2] + pOffset[2];
+			if ( !bCached )
+			{
+				CellularGatherCell( X, Y, Z, _Dimensions, _bWorley, _bWrap, Neighbor, Candidates );
+				continue;
+			}
+
+			Candidates.pCellX[Neighbor] = ppWrappedCells[0][1+pOffset[0]];
+			Candidates.pCellY[Neighbor] = ppWrappedCells[1][1+pOffset[1]];
+			Candidates.pCellZ[Neighbor] = ppWrappedCells[2][1+pOffset[2]];
+
+			int		CellIndex = CacheIndex + pOffset[0] * m_pCellularCacheStrides[0] + pOffset[1] * m_pCellularCacheStrides[1] + pOffset[2] * m_pCellularCacheStrides[2];
+			U32		First = m_pCellularCacheOffsets[CellIndex];
+			U32		Last = m_pCellularCacheOffsets[CellIndex+1];
+			for ( U32 PointIndex=First; PointIndex < Last; PointIndex++ )
+			{
+				Candidates.pX[Candidates.Count] = X + m_ppCellularCachePoints[0][PointIndex];
+				Candidates.pY[Candidates.Count] = Y + m_ppCellularCachePoints[1][PointIndex];
+				if ( _Dimensions == 3 )
+					Candidates.pZ[Candidates.Count] = Z + m_ppCellularCachePoints[2][PointIndex];
+				Candidates.pNeighbor[Candidates.Count] = Neighbor;
+				Candidates.Count++;
+			}
+		}
+
+		CellularTestCandidates( _pPosition, _Dimensions, Candidates, _Features );
+	}
+}
+
+float	Noise::CombineCellular( const CellularFeatures& _Features, CELLULAR_COMBINE _Combine ) const
+{
+	switch ( _Combine )
+	{
+	case CELLULAR_F1:			return sqrtf( _Features.pSqDistances[0] );
+	case CELLULAR_F2:			return sqrtf( _Features.pSqDistances[1] );
+	case CELLULAR_F3:			return sqrtf( _Features.pSqDistances[2] );
+	case CELLULAR_F2_MINUS_F1:	return sqrtf( _Features.pSqDistances[1] ) - sqrtf( _Features.pSqDistances[0] );
+	case CELLULAR_SQ_F1:		return _Features.pSqDistances[0];
+	case CELLULAR_CELL_ID:		return float( _Features.pCellX[0] + m_SizeX * (_Features.pCellY[0] + m_SizeY * MAX( 0, _Features.pCellZ[0] )) );
+	}
+	return 0.0f;
+}
+
+void	Noise::CellularN( const float2* _pUV, CellularFeatures* _pResult, U32 _Count, bool _bWrap ) const
+{
+	for ( U32 Index=0; Index < _Count; Index++ )
+	{
+		float	pPosition[3] = { _pUV[Index].x, _pUV[Index].y, 0.0f };
+		CellularQuery( pPosition, 2, false, _bWrap, _pResult[Index] );
+	}
+}
+
+void	Noise::CellularN( const float3* _pUVW, CellularFeatures* _pResult, U32 _Count, bool _bWrap ) const
+{
+	for ( U32 Index=0; Index < _Count; Index++ )
+		CellularQuery( &_pUVW[Index].x, 3, false, _bWrap, _pResult[Index] );
+}
+
+void	Noise::WorleyN( const float2* _pUV, CellularFeatures* _pResult, U32 _Count, bool _bWrap ) const
+{
+	for ( U32 Index=0; Index < _Count; Index++ )
+	{
+		float	pPosition[3] = { _pUV[Index].x, _pUV[Index].y, 0.0f };
+		CellularQuery( pPosition, 2, true, _bWrap, _pResult[Index] );
+	}
+}
+
+void	Noise::WorleyN( const float3* _pUVW, CellularFeatures* _pResult, U32 _Count, bool _bWrap ) const
+{
+	for ( U32 Index=0; Index < _Count; Index++ )
+		CellularQuery( &_pUVW[Index].x, 3, true, _bWrap, _pResult[Index] );
+}
+
+void	Noise::CellularN( const float2* _pUV, float* _pResult, U32 _Count, CELLULAR_COMBINE _Combine, bool _bWrap ) const
+{
+	CellularFeatures	Features;
+	for ( U32 Index=0; Index < _Count; Index++ )
+	{
+		float	pPosition[3] = { _pUV[Index].x, _pUV[Index].y, 0.0f };
+		CellularQuery( pPosition, 2, false, _bWrap, Features );
+		_pResult[Index] = CombineCellular( Features, _Combine );
+	}
+}
+
+void	Noise::CellularN( const float3* _pUVW, float* _pResult, U32 _Count, CELLULAR_COMBINE _Combine, bool _bWrap ) const
+{
+	CellularFeatures	Features;
+	for ( U32 Index=0; Index < _Count; Index++ )
+	{
+		CellularQuery( &_pUVW[Index].x, 3, false, _bWrap, Features );
+		_pResult[Index] = CombineCellular( Features, _Combine );
+	}
+}
+
+void	Noise::WorleyN( const float2* _pUV, float* _pResult, U32 _Count, CELLULAR_COMBINE _Combine, bool _bWrap ) const
+{
+	CellularFeatures	Features;
+	for ( U32 Index=0; Index < _Count; Index++ )
+	{
+		float	pPosition[3] = { _pUV[Index].x, _pUV[Index].y, 0.0f };
+		CellularQuery( pPosition, 2, true, _bWrap, Features );
+		_pResult[Index] = CombineCellular( Features, _Combine );
+	}
+}
+
+void	Noise::WorleyN( const float3* _pUVW, float* _pResult, U32 _Count, CELLULAR_COMBINE _Combine, bool _bWrap ) const
+{
+	CellularFeatures	Features;
+	for ( U32 Index=0; Index < _Count; Index++ )
+	{
+		CellularQuery( &_pUVW[Index].x, 3, true, _bWrap, Features );
+		_pResult[Index] = CombineCellular( Features, _Combine );
+	}
+}
+
 U32	Noise::LCGRandom( U32& _LastValue )
 {
 	return _LastValue = U32( (1103515245u * _LastValue + 12345u) );
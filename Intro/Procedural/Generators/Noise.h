@@ -31,6 +31,29 @@ public:		// NESTED TYPES
 
 	typedef float	(*GetNoise2DDelegate)( const float2& _UV, void* _pData );
 
+	// Built-in combiners of the closest cellular distances, used by the batched cellular queries
+	enum	CELLULAR_COMBINE
+	{
+		CELLULAR_F1,			// Distance to the closest feature point
+		CELLULAR_F2,			// Distance to the second closest feature point
+		CELLULAR_F3,			// Distance to the third closest feature point
+		CELLULAR_F2_MINUS_F1,
+		CELLULAR_SQ_F1,			// Squared distance to the closest feature point
+		CELLULAR_CELL_ID,		// Unique index of the cell containing the closest feature point
+	};
+
+	// The 3 closest feature points found by a cellular query (same content as the arguments of CombineDistancesDelegate)
+	struct	CellularFeatures
+	{
+		float	pSqDistances[3];
+		int		pCellX[3];
+		int		pCellY[3];
+		int		pCellZ[3];			// -1 for 2D queries
+	};
+
+private:
+	struct	CellularCandidates;
+
 
 protected:	// FIELDS
 
@@ -53,6 +76,13 @@ protected:	// FIELDS
 	int			m_SizeY;
 	int			m_SizeZ;
 
+	// Cached feature points for cellular/Worley noise
+	int			m_CellularCacheDimensions;		// 0 if there is no cache
+	bool		m_bCellularCacheWorley;
+	int			m_pCellularCacheStrides[3];		// Strides of the cells (the cached cells are surrounded by a border of wrapped cells)
+	U32*		m_pCellularCacheOffsets;		// Index of the first feature point of each cell (one more entry than cells)
+	float*		m_ppCellularCachePoints[3];		// Position of the feature points inside their cell, one array per dimension
+
 	// Wavelet noise tile
 	int			m_WaveletPOT;
 	int			m_WaveletSize;
@@ -81,6 +111,20 @@ public:		// METHODS
 	float	WrapPerlin( const float2& uv ) const;
 	float	WrapPerlin( const float3& uvw ) const;
 
+	// --------- BATCHED ---------
+	// Array-in/array-out versions of the noises above, evaluating 4 positions at a time with SSE (results are the same as the scalar versions)
+	void	PerlinN( const float2* _pUV, float* _pResult, U32 _Count ) const;
+	void	PerlinN( const float3* _pUVW, float* _pResult, U32 _Count ) const;
+	void	WrapPerlinN( const float2* _pUV, float* _pResult, U32 _Count ) const;
+	void	WrapPerlinN( const float3* _pUVW, float* _pResult, U32 _Count ) const;
+
+	// Grid fills of the positions _Origin + (X,Y,Z) * _Step, the result is stored as scanlines of _SizeX values
+	//	The lattice coordinates are computed once per column and once per scanline
+	void	PerlinGrid( const float2& _Origin, const float2& _Step, int _SizeX, int _SizeY, float* _pResult ) const;
+	void	PerlinGrid( const float3& _Origin, const float3& _Step, int _SizeX, int _SizeY, int _SizeZ, float* _pResult ) const;
+	void	WrapPerlinGrid( const float2& _Origin, const float2& _Step, int _SizeX, int _SizeY, float* _pResult ) const;
+	void	WrapPerlinGrid( const float3& _Origin, const float3& _Step, int _SizeX, int _SizeY, int _SizeZ, float* _pResult ) const;
+
 	// --------- CELLULAR ---------
 	void	SetCellularWrappingParameters( int _SizeX, int _SizeY, int _SizeZ );
 	void	CellularGetCenter( int _CellX, int _CellY, float2& _Center, bool _bWrap=false ) const;
@@ -90,6 +134,23 @@ public:		// METHODS
 	float	Worley( const float2& uv, CombineDistancesDelegate _Combine, void* _pData, bool _bWrap=false ) const;
 	float	Worley( const float3& uvw, CombineDistancesDelegate _Combine, void* _pData, bool _bWrap=false ) const;
 
+	// Generates the feature points of all the cells given to SetCellularWrappingParameters() once and for all (setting new wrapping parameters destroys the cache)
+	//	_Dimensions, 2 or 3 depending on the queries that will use the cache
+	//	_bWorley, true to cache the points for Worley queries, false for Cellular queries
+	void	CreateCellularCache( int _Dimensions, bool _bWorley );
+	void	DestroyCellularCache();
+
+	// Batched cellular/Worley queries returning the same features as Cellular() and Worley(), the feature points are read from the cache when possible
+	void	CellularN( const float2* _pUV, CellularFeatures* _pResult, U32 _Count, bool _bWrap=false ) const;
+	void	CellularN( const float3* _pUVW, CellularFeatures* _pResult, U32 _Count, bool _bWrap=false ) const;
+	void	WorleyN( const float2* _pUV, CellularFeatures* _pResult, U32 _Count, bool _bWrap=false ) const;
+	void	WorleyN( const float3* _pUVW, CellularFeatures* _pResult, U32 _Count, bool _bWrap=false ) const;
+	void	CellularN( const float2* _pUV, float* _pResult, U32 _Count, CELLULAR_COMBINE _Combine, bool _bWrap=false ) const;
+	void	CellularN( const float3* _pUVW, float* _pResult, U32 _Count, CELLULAR_COMBINE _Combine, bool _bWrap=false ) const;
+	void	WorleyN( const float2* _pUV, float* _pResult, U32 _Count, CELLULAR_COMBINE _Combine, bool _bWrap=false ) const;
+	void	WorleyN( const float3* _pUVW, float* _pResult, U32 _Count, CELLULAR_COMBINE _Combine, bool _bWrap=false ) const;
+	float	CombineCellular( const CellularFeatures& _Features, CELLULAR_COMBINE _Combine ) const;
+
 	// --------- WAVELET ---------
 	void	Create2DWaveletNoiseTile( int _POT );
 	float	Wavelet( const float2& uv ) const;
@@ -98,6 +159,12 @@ public:		// METHODS
 	float	FractionalBrownianMotion( GetNoise2DDelegate _GetNoise, void* _pData, const float2& uv, float _FrequencyFactor=2.0f, float _AmplitudeFactor=0.5f, int _OctavesCount=4 ) const;
 	float	RidgedMultiFractal( GetNoise2DDelegate _GetNoise, void* _pData, const float2& _UV, float _FrequencyFactor=2.0f, float _AmplitudeFactor=0.5f, int _OctavesCount=4 ) const;
 
+	// Batched versions of the algorithms using Perlin noise for the octaves (all the octaves are evaluated 4 positions at a time with SSE)
+	void	FractionalBrownianMotionN( const float2* _pUV, float* _pResult, U32 _Count, float _FrequencyFactor=2.0f, float _AmplitudeFactor=0.5f, int _OctavesCount=4 ) const;
+	void	FractionalBrownianMotionN( const float3* _pUVW, float* _pResult, U32 _Count, float _FrequencyFactor=2.0f, float _AmplitudeFactor=0.5f, int _OctavesCount=4 ) const;
+	void	RidgedMultiFractalN( const float2* _pUV, float* _pResult, U32 _Count, float _FrequencyFactor=2.0f, float _AmplitudeFactor=0.5f, int _OctavesCount=4 ) const;
+	void	RidgedMultiFractalN( const float3* _pUVW, float* _pResult, U32 _Count, float _FrequencyFactor=2.0f, float _AmplitudeFactor=0.5f, int _OctavesCount=4 ) const;
+
 private:
 
 	// Linear, Bilinear and Trilinear interpolation functions.
@@ -153,6 +220,12 @@ private:
 
 	int		PoissonPointsCount( U32 _Random ) const;
 
+	U32		CellularHash( U32 _Hx, U32 _Hy, U32 _Hz, int _Dimensions ) const;
+	int		CellularGeneratePoints( U32 _Hash, int _Dimensions, bool _bWorley, float* _pX, float* _pY, float* _pZ ) const;
+	void	CellularGatherCell( int _X, int _Y, int _Z, int _Dimensions, bool _bWorley, bool _bWrap, int _Neighbor, CellularCandidates& _Candidates ) const;
+	void	CellularQuery( const float* _pPosition, int _Dimensions, bool _bWorley, bool _bWrap, CellularFeatures& _Features ) const;
+	static void	CellularTestCandidates( const float* _pPosition, int _Dimensions, CellularCandidates& _Candidates, CellularFeatures& _Features );
+
 	void	WaveletDownsampleUpsample( float* _pSource, float* _pTarget, int _X, int _Y, int _Size, int _Stride ) const;
 
 public:
@@ -1,6 +1,198 @@
 #include "../GodComplex.h"
+#include <emmintrin.h>
 
-RayTracer::RayTracer() : m_pQuads( NULL )
+//////////////////////////////////////////////////////////////////////////
+// Helpers
+//
+static inline float	Component( const float3& _Vector, U32 _Axis )	{ return _Axis == 0 ? _Vector.x : (_Axis == 1 ? _Vector.y : _Vector.z); }
+
+static inline void	Extend( float3& _Min, float3& _Max, const float3& _Position )
+{
+	_Min.x = MIN( _Min.x, _Position.x );	_Max.x = MAX( _Max.x, _Position.x );
+	_Min.y = MIN( _Min.y, _Position.y );	_Max.y = MAX( _Max.y, _Position.y );
+	_Min.z = MIN( _Min.z, _Position.z );	_Max.z = MAX( _Max.z, _Position.z );
+}
+
+// Half the surface area of a box (the factor 2 is irrelevant to the SAH)
+static inline float	HalfArea( const float3& _Min, const float3& _Max )
+{
+	float3	Size = _Max - _Min;
+	return Size.x * Size.y + Size.y * Size.z + Size.z * Size.x;
+}
+
+static inline bool	IntersectBox( const float3& _Min, const float3& _Max, const float3& _Position, const float3& _InvDirection, float _MaxDistance )
+{
+	float	t0x = (_Min.x - _Position.x) * _InvDirection.x,	t1x = (_Max.x - _Position.x) * _InvDirection.x;
+	float	t0y = (_Min.y - _Position.y) * _InvDirection.y,	t1y = (_Max.y - _Position.y) * _InvDirection.y;
+	float	t0z = (_Min.z - _Position.z) * _InvDirection.z,	t1z = (_Max.z - _Position.z) * _InvDirection.z;
+	float	tNear = MAX( MAX( MIN( t0x, t1x ), MIN( t0y, t1y ) ), MAX( MIN( t0z, t1z ), 0.0f ) );
+	float	tFar = MIN( MIN( MAX( t0x, t1x ), MAX( t0y, t1y ) ), MIN( MAX( t0z, t1z ), _MaxDistance ) );
+	return tNear <= tFar;
+}
+
+static bool	IntersectQuad( const RayTracer::Quad_Internal& _Quad, RayTracer::Ray& _Ray )
+{
+	float3	ToCenter = _Quad.Center - _Ray.Position;
+	float		HeightFromQuad = ToCenter.Dot( _Quad.Normal );		// Negative if above quad
+	float		SlopeToQuad = _Ray.Direction.Dot( _Quad.Normal );	// Rate at which we get closer to the quad
+	float		HitDistance = HeightFromQuad / SlopeToQuad;			// Distance at which we'll hit the quad's plane
+	if ( !(HitDistance > 0.0f && HitDistance <= _Ray.HitDistance) )
+		return false;	// No hit, or we hit too far away from best hit...
+
+	// Compute hit position and check we're within the quad
+	float3	HitPosition = _Ray.Position + HitDistance * _Ray.Direction;	// Position within quad's plane
+	float3	FromCenter = HitPosition - _Quad.Center;
+	float		DistanceX = FromCenter.Dot( _Quad.Tangent );
+	float		DistanceY = FromCenter.Dot( _Quad.BiTangent );
+	if ( !(abs(DistanceX) <= _Quad.SizeAndInvSize.x && abs(DistanceY) <= _Quad.SizeAndInvSize.y) )
+		return false;	// We hit outside the quad...
+
+	// We have a hit !
+	// Now, all we need to do is to find the UVs where it happened
+	_Ray.HitDistance = HitDistance;
+	_Ray.HitUV.Set( 0.5f + DistanceX * _Quad.SizeAndInvSize.z, 0.5f + DistanceY * _Quad.SizeAndInvSize.w );
+	return true;
+}
+
+// Moller-Trumbore intersection, triangles are double-sided like quads
+static bool	IntersectTriangle( const RayTracer::Triangle_Internal& _Triangle, RayTracer::Ray& _Ray )
+{
+	float3	P = _Ray.Direction.Cross( _Triangle.Edge2 );
+	float	InvDeterminant = 1.0f / _Triangle.Edge1.Dot( P );
+	float3	ToOrigin = _Ray.Position - _Triangle.P0;
+	float	U = ToOrigin.Dot( P ) * InvDeterminant;
+	float3	Q = ToOrigin.Cross( _Triangle.Edge1 );
+	float	V = _Ray.Direction.Dot( Q ) * InvDeterminant;
+	float	HitDistance = _Triangle.Edge2.Dot( Q ) * InvDeterminant;
+	if ( !(U >= 0.0f && V >= 0.0f && U + V <= 1.0f && HitDistance > 0.0f && HitDistance <= _Ray.HitDistance) )
+		return false;
+
+	_Ray.HitDistance = HitDistance;
+	_Ray.HitUV.Set( U, V );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SSE packet of 4 rays
+//
+struct	RayPacket
+{
+	__m128	Ox, Oy, Oz;			// Origins
+	__m128	Dx, Dy, Dz;			// Directions
+	__m128	IDx, IDy, IDz;		// Inverse directions
+	__m128	HitDistance;		// Negative for inactive lanes so they never hit anything
+	__m128	HitU, HitV;
+	__m128i	HitPrimitive;		// Primitive reference, ~0 if no hit
+};
+
+static inline __m128	Select( __m128 _Mask, __m128 _A, __m128 _B )		{ return _mm_or_ps( _mm_and_ps( _Mask, _A ), _mm_andnot_ps( _Mask, _B ) ); }
+static inline __m128	Abs( __m128 _Value )								{ return _mm_andnot_ps( _mm_set1_ps( -0.0f ), _Value ); }
+static inline __m128	Dot( __m128 _Ax, __m128 _Ay, __m128 _Az, __m128 _Bx, __m128 _By, __m128 _Bz )	{ return _mm_add_ps( _mm_add_ps( _mm_mul_ps( _Ax, _Bx ), _mm_mul_ps( _Ay, _By ) ), _mm_mul_ps( _Az, _Bz ) ); }
+
+static inline int	IntersectBox4( const RayPacket& _Packet, const float3& _Min, const float3& _Max )
+{
+	__m128	t0x = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( _Min.x ), _Packet.Ox ), _Packet.IDx );
+	__m128	t1x = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( _Max.x ), _Packet.Ox ), _Packet.IDx );
+	__m128	t0y = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( _Min.y ), _Packet.Oy ), _Packet.IDy );
+	__m128	t1y = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( _Max.y ), _Packet.Oy ), _Packet.IDy );
+	__m128	t0z = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( _Min.z ), _Packet.Oz ), _Packet.IDz );
+	__m128	t1z = _mm_mul_ps( _mm_sub_ps( _mm_set1_ps( _Max.z ), _Packet.Oz ), _Packet.IDz );
+	__m128	tNear = _mm_max_ps( _mm_max_ps( _mm_min_ps( t0x, t1x ), _mm_min_ps( t0y, t1y ) ), _mm_max_ps( _mm_min_ps( t0z, t1z ), _mm_setzero_ps() ) );
+	__m128	tFar = _mm_min_ps( _mm_min_ps( _mm_max_ps( t0x, t1x ), _mm_max_ps( t0y, t1y ) ), _mm_min_ps( _mm_max_ps( t0z, t1z ), _Packet.HitDistance ) );
+	return _mm_movemask_ps( _mm_cmple_ps( tNear, tFar ) );
+}
+
+static inline void	RecordHits4( RayPacket& _Packet, __m128 _Mask, __m128 _HitDistance, __m128 _U, __m128 _V, U32 _PrimitiveReference )
+{
+	_Packet.HitDistance = Select( _Mask, _HitDistance, _Packet.HitDistance );
+	_Packet.HitU = Select( _Mask, _U, _Packet.HitU );
+	_Packet.HitV = Select( _Mask, _V, _Packet.HitV );
+	_Packet.HitPrimitive = _mm_castps_si128( Select( _Mask, _mm_castsi128_ps( _mm_set1_epi32( int(_PrimitiveReference) ) ), _mm_castsi128_ps( _Packet.HitPrimitive ) ) );
+}
+
+static void	IntersectQuad4( RayPacket& _Packet, const RayTracer::Quad_Internal& _Quad, U32 _PrimitiveReference )
+{
+	__m128	Nx = _mm_set1_ps( _Quad.Normal.x ), Ny = _mm_set1_ps( _Quad.Normal.y ), Nz = _mm_set1_ps( _Quad.Normal.z );
+	__m128	ToCenterX = _mm_sub_ps( _mm_set1_ps( _Quad.Center.x ), _Packet.Ox );
+	__m128	ToCenterY = _mm_sub_ps( _mm_set1_ps( _Quad.Center.y ), _Packet.Oy );
+	__m128	ToCenterZ = _mm_sub_ps( _mm_set1_ps( _Quad.Center.z ), _Packet.Oz );
+	__m128	HeightFromQuad = Dot( ToCenterX, ToCenterY, ToCenterZ, Nx, Ny, Nz );
+	__m128	SlopeToQuad = Dot( _Packet.Dx, _Packet.Dy, _Packet.Dz, Nx, Ny, Nz );
+	__m128	HitDistance = _mm_div_ps( HeightFromQuad, SlopeToQuad );
+	__m128	Mask = _mm_and_ps( _mm_cmpgt_ps( HitDistance, _mm_setzero_ps() ), _mm_cmple_ps( HitDistance, _Packet.HitDistance ) );
+	if ( _mm_movemask_ps( Mask ) == 0 )
+		return;
+
+	__m128	FromCenterX = _mm_sub_ps( _mm_mul_ps( HitDistance, _Packet.Dx ), ToCenterX );
+	__m128	FromCenterY = _mm_sub_ps( _mm_mul_ps( HitDistance, _Packet.Dy ), ToCenterY );
+	__m128	FromCenterZ = _mm_sub_ps( _mm_mul_ps( HitDistance, _Packet.Dz ), ToCenterZ );
+	__m128	DistanceX = Dot( FromCenterX, FromCenterY, FromCenterZ, _mm_set1_ps( _Quad.Tangent.x ), _mm_set1_ps( _Quad.Tangent.y ), _mm_set1_ps( _Quad.Tangent.z ) );
+	__m128	DistanceY = Dot( FromCenterX, FromCenterY, FromCenterZ, _mm_set1_ps( _Quad.BiTangent.x ), _mm_set1_ps( _Quad.BiTangent.y ), _mm_set1_ps( _Quad.BiTangent.z ) );
+	Mask = _mm_and_ps( Mask, _mm_cmple_ps( Abs( DistanceX ), _mm_set1_ps( _Quad.SizeAndInvSize.x ) ) );
+	Mask = _mm_and_ps( Mask, _mm_cmple_ps( Abs( DistanceY ), _mm_set1_ps( _Quad.SizeAndInvSize.y ) ) );
+	if ( _mm_movemask_ps( Mask ) == 0 )
+		return;
+
+	__m128	Half = _mm_set1_ps( 0.5f );
+	__m128	U = _mm_add_ps( Half, _mm_mul_ps( DistanceX, _mm_set1_ps( _Quad.SizeAndInvSize.z ) ) );
+	__m128	V = _mm_add_ps( Half, _mm_mul_ps( DistanceY, _mm_set1_ps( _Quad.SizeAndInvSize.w ) ) );
+	RecordHits4( _Packet, Mask, HitDistance, U, V, _PrimitiveReference );
+}
+
+static void	IntersectTriangle4( RayPacket& _Packet, const RayTracer::Triangle_Internal& _Triangle, U32 _PrimitiveReference )
+{
+	__m128	E1x = _mm_set1_ps( _Triangle.Edge1.x ), E1y = _mm_set1_ps( _Triangle.Edge1.y ), E1z = _mm_set1_ps( _Triangle.Edge1.z );
+	__m128	E2x = _mm_set1_ps( _Triangle.Edge2.x ), E2y = _mm_set1_ps( _Triangle.Edge2.y ), E2z = _mm_set1_ps( _Triangle.Edge2.z );
+
+	// P = Direction x Edge2
+	__m128	Px = _mm_sub_ps( _mm_mul_ps( _Packet.Dy, E2z ), _mm_mul_ps( _Packet.Dz, E2y ) );
+	__m128	Py = _mm_sub_ps( _mm_mul_ps( _Packet.Dz, E2x ), _mm_mul_ps( _Packet.Dx, E2z ) );
+	__m128	Pz = _mm_sub_ps( _mm_mul_ps( _Packet.Dx, E2y ), _mm_mul_ps( _Packet.Dy, E2x ) );
+	__m128	InvDeterminant = _mm_div_ps( _mm_set1_ps( 1.0f ), Dot( E1x, E1y, E1z, Px, Py, Pz ) );
+
+	__m128	Tx = _mm_sub_ps( _Packet.Ox, _mm_set1_ps( _Triangle.P0.x ) );
+	__m128	Ty = _mm_sub_ps( _Packet.Oy, _mm_set1_ps( _Triangle.P0.y ) );
+	__m128	Tz = _mm_sub_ps( _Packet.Oz, _mm_set1_ps( _Triangle.P0.z ) );
+	__m128	U = _mm_mul_ps( Dot( Tx, Ty, Tz, Px, Py, Pz ), InvDeterminant );
+
+	// Q = ToOrigin x Edge1
+	__m128	Qx = _mm_sub_ps( _mm_mul_ps( Ty, E1z ), _mm_mul_ps( Tz, E1y ) );
+	__m128	Qy = _mm_sub_ps( _mm_mul_ps( Tz, E1x ), _mm_mul_ps( Tx, E1z ) );
+	__m128	Qz = _mm_sub_ps( _mm_mul_ps( Tx, E1y ), _mm_mul_ps( Ty, E1x ) );
+	__m128	V = _mm_mul_ps( Dot( _Packet.Dx, _Packet.Dy, _Packet.Dz, Qx, Qy, Qz ), InvDeterminant );
+	__m128	HitDistance = _mm_mul_ps( Dot( E2x, E2y, E2z, Qx, Qy, Qz ), InvDeterminant );
+
+	__m128	Zero = _mm_setzero_ps();
+	__m128	Mask = _mm_and_ps( _mm_cmpge_ps( U, Zero ), _mm_cmpge_ps( V, Zero ) );
+	Mask = _mm_and_ps( Mask, _mm_cmple_ps( _mm_add_ps( U, V ), _mm_set1_ps( 1.0f ) ) );
+	Mask = _mm_and_ps( Mask, _mm_cmpgt_ps( HitDistance, Zero ) );
+	Mask = _mm_and_ps( Mask, _mm_cmple_ps( HitDistance, _Packet.HitDistance ) );
+	if ( _mm_movemask_ps( Mask ) == 0 )
+		return;
+
+	RecordHits4( _Packet, Mask, HitDistance, U, V, _PrimitiveReference );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Batch job shared by the worker threads
+//
+struct	BatchJob
+{
+	RayTracer*			pOwner;
+	RayTracer::Ray*		pRays;
+	U32					RaysCount;
+};
+
+//////////////////////////////////////////////////////////////////////////
+//
+RayTracer::RayTracer()
+	: m_QuadsCount( 0 )
+	, m_pQuads( NULL )
+	, m_TrianglesCount( 0 )
+	, m_pTriangles( NULL )
+	, m_NodesCount( 0 )
+	, m_pNodes( NULL )
+	, m_pPrimitives( NULL )
 {
 }
 RayTracer::~RayTracer()
@@ -8,7 +200,7 @@ RayTracer::~RayTracer()
 	ExitGeometry();
 }
 
-void	RayTracer::InitGeometry( int _QuadsCount, const Quad* _pQuads )
+void	RayTracer::InitGeometry( int _QuadsCount, const Quad* _pQuads, int _TrianglesCount, const Triangle* _pTriangles )
 {
 	ExitGeometry();
 
@@ -26,39 +218,414 @@ void	RayTracer::InitGeometry( int _QuadsCount, const Quad* _pQuads )
 		Target.BiTangent = Target.Normal.Cross( Target.Tangent );
 		Target.SizeAndInvSize.Set( 0.5f * Source.Size.x, 0.5f * Source.Size.y, 2.0f / Source.Size.x, 2.0f / Source.Size.y );
 	}
+
+	m_TrianglesCount = _TrianglesCount;
+	m_pTriangles = _TrianglesCount > 0 ? new Triangle_Internal[_TrianglesCount] : NULL;
+
+	for ( int TriangleIndex=0; TriangleIndex < m_TrianglesCount; TriangleIndex++ )
+	{
+		const Triangle&		Source = _pTriangles[TriangleIndex];
+		Triangle_Internal&	Target = m_pTriangles[TriangleIndex];
+		memcpy( &Target, &Source, sizeof(Triangle) );
+
+		Target.Edge1 = Source.P1 - Source.P0;
+		Target.Edge2 = Source.P2 - Source.P0;
+	}
+
+	BuildBVH();
 }
 
+//////////////////////////////////////////////////////////////////////////
+// BVH construction
+//
+void	RayTracer::BuildBVH()
+{
+	U32	PrimitivesCount = U32(m_QuadsCount + m_TrianglesCount);
+	if ( PrimitivesCount == 0 )
+		return;
+
+	// Compute primitive bounds
+	float3*	pMin = new float3[3*PrimitivesCount];
+	float3*	pMax = pMin + PrimitivesCount;
+	float3*	pCentroids = pMax + PrimitivesCount;
+	for ( int QuadIndex=0; QuadIndex < m_QuadsCount; QuadIndex++ )
+	{
+		const Quad_Internal&	Q = m_pQuads[QuadIndex];
+		float3	X = Q.SizeAndInvSize.x * Q.Tangent;
+		float3	Y = Q.SizeAndInvSize.y * Q.BiTangent;
+		pMin[QuadIndex] = pMax[QuadIndex] = Q.Center - X - Y;
+		Extend( pMin[QuadIndex], pMax[QuadIndex], Q.Center + X - Y );
+		Extend( pMin[QuadIndex], pMax[QuadIndex], Q.Center - X + Y );
+		Extend( pMin[QuadIndex], pMax[QuadIndex], Q.Center + X + Y );
+	}
+	for ( int TriangleIndex=0; TriangleIndex < m_TrianglesCount; TriangleIndex++ )
+	{
+		const Triangle_Internal&	T = m_pTriangles[TriangleIndex];
+		U32		PrimitiveIndex = m_QuadsCount + TriangleIndex;
+		pMin[PrimitiveIndex] = pMax[PrimitiveIndex] = T.P0;
+		Extend( pMin[PrimitiveIndex], pMax[PrimitiveIndex], T.P1 );
+		Extend( pMin[PrimitiveIndex], pMax[PrimitiveIndex], T.P2 );
+	}
+	for ( U32 PrimitiveIndex=0; PrimitiveIndex < PrimitivesCount; PrimitiveIndex++ )
+		pCentroids[PrimitiveIndex] = 0.5f * (pMin[PrimitiveIndex] + pMax[PrimitiveIndex]);
+
+	// Build the tree
+	m_pPrimitives = new U32[PrimitivesCount];
+	for ( U32 PrimitiveIndex=0; PrimitiveIndex < PrimitivesCount; PrimitiveIndex++ )
+		m_pPrimitives[PrimitiveIndex] = PrimitiveIndex;
+
+	m_pNodes = new Node[2*PrimitivesCount];
+	m_NodesCount = 0;
+	BuildNode( 0, PrimitivesCount, pMin, pMax, pCentroids, 0 );
+
+	delete[] pMin;
+}
+
+U32	RayTracer::BuildNode( U32 _First, U32 _Last, const float3* _pMin, const float3* _pMax, const float3* _pCentroids, U32 _Depth )
+{
+	U32		NodeIndex = m_NodesCount++;
+	Node&	N = m_pNodes[NodeIndex];
+
+	// Compute the node's bounds and the bounds of the primitives' centroids
+	U32		Count = _Last - _First;
+	N.Min = _pMin[m_pPrimitives[_First]];
+	N.Max = _pMax[m_pPrimitives[_First]];
+	float3	CentroidMin = _pCentroids[m_pPrimitives[_First]];
+	float3	CentroidMax = CentroidMin;
+	for ( U32 i=_First+1; i < _Last; i++ )
+	{
+		U32	PrimitiveIndex = m_pPrimitives[i];
+		Extend( N.Min, N.Max, _pMin[PrimitiveIndex] );
+		Extend( N.Min, N.Max, _pMax[PrimitiveIndex] );
+		Extend( CentroidMin, CentroidMax, _pCentroids[PrimitiveIndex] );
+	}
+
+	N.Offset = _First;
+	N.Count = Count;
+	if ( Count <= MAX_LEAF_PRIMITIVES || _Depth+1 >= MAX_STACK_SIZE )
+		return NodeIndex;	// Leaf
+
+	// Split along the largest extent of the centroids
+	float3	CentroidExtent = CentroidMax - CentroidMin;
+	U32		Axis = CentroidExtent.x > CentroidExtent.y ? (CentroidExtent.x > CentroidExtent.z ? 0 : 2) : (CentroidExtent.y > CentroidExtent.z ? 1 : 2);
+	float	AxisMin = Component( CentroidMin, Axis );
+	float	AxisExtent = Component( CentroidExtent, Axis );
+
+	U32		Split = (_First + _Last) >> 1;	// Median split if all the centroids are identical
+	if ( AxisExtent > 0.0f )
+	{
+		// Bin the primitives
+		U32		pBinCounts[SAH_BINS_COUNT];
+		float3	pBinMin[SAH_BINS_COUNT];
+		float3	pBinMax[SAH_BINS_COUNT];
+		for ( U32 BinIndex=0; BinIndex < SAH_BINS_COUNT; BinIndex++ )
+			pBinCounts[BinIndex] = 0;
+
+		float	BinScale = SAH_BINS_COUNT / AxisExtent;
+		for ( U32 i=_First; i < _Last; i++ )
+		{
+			U32	PrimitiveIndex = m_pPrimitives[i];
+			U32	BinIndex = MIN( SAH_BINS_COUNT-1, U32( (Component( _pCentroids[PrimitiveIndex], Axis ) - AxisMin) * BinScale ) );
+			if ( pBinCounts[BinIndex]++ == 0 )
+			{
+				pBinMin[BinIndex] = _pMin[PrimitiveIndex];
+				pBinMax[BinIndex] = _pMax[PrimitiveIndex];
+			}
+			else
+			{
+				Extend( pBinMin[BinIndex], pBinMax[BinIndex], _pMin[PrimitiveIndex] );
+				Extend( pBinMin[BinIndex], pBinMax[BinIndex], _pMax[PrimitiveIndex] );
+			}
+		}
+
+		// Sweep from the right to accumulate the cost of the right side of each plane
+		float	pRightCosts[SAH_BINS_COUNT];
+		U32		RightCount = 0;
+		float3	RightMin, RightMax;
+		for ( U32 BinIndex=SAH_BINS_COUNT-1; BinIndex > 0; BinIndex-- )
+		{
+			if ( pBinCounts[BinIndex] > 0 )
+			{
+				if ( RightCount == 0 )
+				{
+					RightMin = pBinMin[BinIndex];
+					RightMax = pBinMax[BinIndex];
+				}
+				else
+				{
+					Extend( RightMin, RightMax, pBinMin[BinIndex] );
+					Extend( RightMin, RightMax, pBinMax[BinIndex] );
+				}
+				RightCount += pBinCounts[BinIndex];
+			}
+			pRightCosts[BinIndex] = RightCount > 0 ? RightCount * HalfArea( RightMin, RightMax ) : 0.0f;
+		}
+
+		// Sweep from the left and find the plane with the lowest cost
+		float	BestCost = FLOAT32_MAX;
+		U32		BestPlane = 0;
+		U32		LeftCount = 0;
+		float3	LeftMin, LeftMax;
+		for ( U32 Plane=1; Plane < SAH_BINS_COUNT; Plane++ )
+		{
+			U32	BinIndex = Plane-1;
+			if ( pBinCounts[BinIndex] > 0 )
+			{
+				if ( LeftCount == 0 )
+				{
+					LeftMin = pBinMin[BinIndex];
+					LeftMax = pBinMax[BinIndex];
+				}
+				else
+				{
+					Extend( LeftMin, LeftMax, pBinMin[BinIndex] );
+					Extend( LeftMin, LeftMax, pBinMax[BinIndex] );
+				}
+				LeftCount += pBinCounts[BinIndex];
+			}
+			if ( LeftCount == 0 || LeftCount == Count )
+				continue;
+
+			float	Cost = LeftCount * HalfArea( LeftMin, LeftMax ) + pRightCosts[Plane];
+			if ( Cost < BestCost )
+			{
+				BestCost = Cost;
+				BestPlane = Plane;
+			}
+		}
+
+		// Keep a leaf if splitting is more expensive than intersecting all the primitives (a traversal step costs about as much as an intersection)
+		float	NodeArea = HalfArea( N.Min, N.Max );
+		if ( Count <= MAX_SAH_LEAF_PRIMITIVES && NodeArea > 0.0f && 1.0f + BestCost / NodeArea >= float(Count) )
+			return NodeIndex;
+
+		// Partition the primitives on each side of the best plane
+		U32	Left = _First;
+		U32	Right = _Last;
+		while ( Left < Right )
+		{
+			U32	PrimitiveIndex = m_pPrimitives[Left];
+			U32	BinIndex = MIN( SAH_BINS_COUNT-1, U32( (Component( _pCentroids[PrimitiveIndex], Axis ) - AxisMin) * BinScale ) );
+			if ( BinIndex < BestPlane )
+				Left++;
+			else
+			{
+				m_pPrimitives[Left] = m_pPrimitives[--Right];
+				m_pPrimitives[Right] = PrimitiveIndex;
+			}
+		}
+		if ( Left > _First && Left < _Last )
+			Split = Left;
+	}
+
+	BuildNode( _First, Split, _pMin, _pMax, _pCentroids, _Depth+1 );
+	N.Offset = BuildNode( Split, _Last, _pMin, _pMax, _pCentroids, _Depth+1 );
+	N.Count = 0;
+
+	return NodeIndex;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Tracing
+//
 bool	RayTracer::Trace( Ray& _Ray )
 {
 	_Ray.pHitQuad = NULL;
+	_Ray.pHitTriangle = NULL;
 	_Ray.HitDistance = FLOAT32_MAX;	// Infinity...
+	if ( m_NodesCount == 0 )
+		return false;
+
+	float3	InvDirection( 1.0f / _Ray.Direction.x, 1.0f / _Ray.Direction.y, 1.0f / _Ray.Direction.z );
+
+	U32		pStack[MAX_STACK_SIZE];
+	U32		StackSize = 0;
+	pStack[StackSize++] = 0;
+	while ( StackSize > 0 )
+	{
+		const Node&	N = m_pNodes[pStack[--StackSize]];
+		if ( !IntersectBox( N.Min, N.Max, _Ray.Position, InvDirection, _Ray.HitDistance ) )
+			continue;
+
+		if ( N.Count == 0 )
+		{	// Push the farthest child first so the nearest one is visited first
+			U32		LeftIndex = U32(&N - m_pNodes) + 1;
+			U32		RightIndex = N.Offset;
+			const Node&	L = m_pNodes[LeftIndex];
+			const Node&	R = m_pNodes[RightIndex];
+			float3	LeftToRight = (R.Min + R.Max) - (L.Min + L.Max);
+			bool	LeftFirst = LeftToRight.Dot( _Ray.Direction ) >= 0.0f;
+			pStack[StackSize++] = LeftFirst ? RightIndex : LeftIndex;
+			pStack[StackSize++] = LeftFirst ? LeftIndex : RightIndex;
+			continue;
+		}
+
+		for ( U32 i=N.Offset; i < N.Offset+N.Count; i++ )
+		{
+			U32	PrimitiveIndex = m_pPrimitives[i];
+			if ( PrimitiveIndex < U32(m_QuadsCount) )
+			{
+				if ( IntersectQuad( m_pQuads[PrimitiveIndex], _Ray ) )
+				{
+					_Ray.pHitQuad = &m_pQuads[PrimitiveIndex];
+					_Ray.pHitTriangle = NULL;
+				}
+			}
+			else
+			{
+				Triangle_Internal&	T = m_pTriangles[PrimitiveIndex - m_QuadsCount];
+				if ( IntersectTriangle( T, _Ray ) )
+				{
+					_Ray.pHitQuad = NULL;
+					_Ray.pHitTriangle = &T;
+				}
+			}
+		}
+	}
+
+	return _Ray.pHitQuad != NULL || _Ray.pHitTriangle != NULL;
+}
 
-	Quad_Internal*	pQuad = m_pQuads;
-	for ( int QuadIndex=0; QuadIndex < m_QuadsCount; QuadIndex++, pQuad++ )
+void	RayTracer::TracePacket( Ray* _pRays, U32 _RaysCount )
+{
+	ASSERT( _RaysCount > 0 && _RaysCount <= 4, "Invalid packet size!" );
+
+	// Load the rays in SoA form, missing lanes duplicate the first ray but are made inactive with a negative hit distance
+	__declspec(align(16))	float	pBuffer[10][4];
+	float3	SumDirection( 0, 0, 0 );
+	for ( U32 Lane=0; Lane < 4; Lane++ )
+	{
+		const Ray&	R = _pRays[Lane < _RaysCount ? Lane : 0];
+		pBuffer[0][Lane] = R.Position.x;
+		pBuffer[1][Lane] = R.Position.y;
+		pBuffer[2][Lane] = R.Position.z;
+		pBuffer[3][Lane] = R.Direction.x;
+		pBuffer[4][Lane] = R.Direction.y;
+		pBuffer[5][Lane] = R.Direction.z;
+		pBuffer[6][Lane] = Lane < _RaysCount ? FLOAT32_MAX : -1.0f;
+		if ( Lane < _RaysCount )
+			SumDirection = SumDirection + R.Direction;
+	}
+
+	RayPacket	Packet;
+	Packet.Ox = _mm_load_ps( pBuffer[0] );
+	Packet.Oy = _mm_load_ps( pBuffer[1] );
+	Packet.Oz = _mm_load_ps( pBuffer[2] );
+	Packet.Dx = _mm_load_ps( pBuffer[3] );
+	Packet.Dy = _mm_load_ps( pBuffer[4] );
+	Packet.Dz = _mm_load_ps( pBuffer[5] );
+	Packet.HitDistance = _mm_load_ps( pBuffer[6] );
+	__m128	One = _mm_set1_ps( 1.0f );
+	Packet.IDx = _mm_div_ps( One, Packet.Dx );
+	Packet.IDy = _mm_div_ps( One, Packet.Dy );
+	Packet.IDz = _mm_div_ps( One, Packet.Dz );
+	Packet.HitU = _mm_setzero_ps();
+	Packet.HitV = _mm_setzero_ps();
+	Packet.HitPrimitive = _mm_set1_epi32( -1 );
+
+	// Traverse the tree with the entire packet, nodes are visited as long as at least one active ray intersects them
+	U32		pStack[MAX_STACK_SIZE];
+	U32		StackSize = 0;
+	pStack[StackSize++] = 0;
+	while ( StackSize > 0 )
 	{
-		float3	ToCenter = pQuad->Center - _Ray.Position;
-		float		HeightFromQuad = ToCenter.Dot( pQuad->Normal );		// Negative if above quad
-		float		SlopeToQuad = _Ray.Direction.Dot( pQuad->Normal );	// Rate at which we get closer to the quad
-		float		HitDistance = HeightFromQuad / SlopeToQuad;			// Distance at which we'll hit the quad's plane
-		if ( HitDistance <= 0.0f || HitDistance > _Ray.HitDistance )
-			continue;	// No hit, or we hit too far away from best hit...
-
-		// Compute hit position and check we're within the quad
-		float3	HitPosition = _Ray.Position + HitDistance * _Ray.Direction;	// Position within quad's plane
-		float3	FromCenter = HitPosition - pQuad->Center;
-		float		DistanceX = FromCenter.Dot( pQuad->Tangent );
-		float		DistanceY = FromCenter.Dot( pQuad->BiTangent );
-		if ( abs(DistanceX) > pQuad->SizeAndInvSize.x || abs(DistanceY) > pQuad->SizeAndInvSize.y )
-			continue;	// We hit outside the quad...
-
-		// We have a hit !
-		// Now, all we need to do is to find the UVs where it happened
-		_Ray.HitDistance = HitDistance;
-		_Ray.pHitQuad = pQuad;
-		_Ray.HitUV.Set( 0.5f + DistanceX * pQuad->SizeAndInvSize.z, 0.5f + DistanceY * pQuad->SizeAndInvSize.w );
+		const Node&	N = m_pNodes[pStack[--StackSize]];
+		if ( IntersectBox4( Packet, N.Min, N.Max ) == 0 )
+			continue;
+
+		if ( N.Count == 0 )
+		{
+			U32		LeftIndex = U32(&N - m_pNodes) + 1;
+			U32		RightIndex = N.Offset;
+			const Node&	L = m_pNodes[LeftIndex];
+			const Node&	R = m_pNodes[RightIndex];
+			float3	LeftToRight = (R.Min + R.Max) - (L.Min + L.Max);
+			bool	LeftFirst = LeftToRight.Dot( SumDirection ) >= 0.0f;
+			pStack[StackSize++] = LeftFirst ? RightIndex : LeftIndex;
+			pStack[StackSize++] = LeftFirst ? LeftIndex : RightIndex;
+			continue;
+		}
+
+		for ( U32 i=N.Offset; i < N.Offset+N.Count; i++ )
+		{
+			U32	PrimitiveIndex = m_pPrimitives[i];
+			if ( PrimitiveIndex < U32(m_QuadsCount) )
+				IntersectQuad4( Packet, m_pQuads[PrimitiveIndex], PrimitiveIndex );
+			else
+				IntersectTriangle4( Packet, m_pTriangles[PrimitiveIndex - m_QuadsCount], PrimitiveIndex );
+		}
 	}
 
-	return _Ray.pHitQuad != NULL;
+	// Write back the results
+	_mm_store_ps( pBuffer[6], Packet.HitDistance );
+	_mm_store_ps( pBuffer[7], Packet.HitU );
+	_mm_store_ps( pBuffer[8], Packet.HitV );
+	_mm_store_si128( (__m128i*) pBuffer[9], Packet.HitPrimitive );
+	const U32*	pHitPrimitives = (const U32*) pBuffer[9];
+	for ( U32 Lane=0; Lane < _RaysCount; Lane++ )
+	{
+		Ray&	R = _pRays[Lane];
+		U32		PrimitiveIndex = pHitPrimitives[Lane];
+		R.pHitQuad = NULL;
+		R.pHitTriangle = NULL;
+		if ( PrimitiveIndex == ~0U )
+		{
+			R.HitDistance = FLOAT32_MAX;
+			continue;
+		}
+
+		if ( PrimitiveIndex < U32(m_QuadsCount) )
+			R.pHitQuad = &m_pQuads[PrimitiveIndex];
+		else
+			R.pHitTriangle = &m_pTriangles[PrimitiveIndex - m_QuadsCount];
+		R.HitDistance = pBuffer[6][Lane];
+		R.HitUV.Set( pBuffer[7][Lane], pBuffer[8][Lane] );
+	}
+}
+
+void	RayTracer::TraceRange( Ray* _pRays, U32 _RaysCount )
+{
+	for ( U32 RayIndex=0; RayIndex < _RaysCount; RayIndex+=4 )
+		TracePacket( _pRays + RayIndex, MIN( 4U, _RaysCount - RayIndex ) );
+}
+
+void	RayTracer::TraceBatch( Ray* _pRays, int _RaysCount )
+{
+	if ( _RaysCount <= 0 )
+		return;
+	if ( m_NodesCount == 0 )
+	{	// No geometry
+		for ( int RayIndex=0; RayIndex < _RaysCount; RayIndex++ )
+		{
+			_pRays[RayIndex].pHitQuad = NULL;
+			_pRays[RayIndex].pHitTriangle = NULL;
+			_pRays[RayIndex].HitDistance = FLOAT32_MAX;
+		}
+		return;
+	}
+
+	BatchJob	Job;
+	Job.pOwner = this;
+	Job.pRays = _pRays;
+	Job.RaysCount = U32(_RaysCount);
+
+	// Small batches are not worth the dispatch
+	U32	ChunksCount = (Job.RaysCount + BATCH_CHUNK_SIZE-1) / BATCH_CHUNK_SIZE;
+	if ( ChunksCount <= 1 )
+	{
+		TraceRange( _pRays, Job.RaysCount );
+		return;
+	}
+
+	WorkerPool::ParallelFor( int(ChunksCount), BatchChunkTask, &Job );
+}
+
+void	RayTracer::BatchChunkTask( int _TaskIndex, int _ThreadIndex, void* _pJob )
+{
+	BatchJob&	Job = *reinterpret_cast<BatchJob*>( _pJob );
+	U32	Start = U32(_TaskIndex) * BATCH_CHUNK_SIZE;
+	U32	End = MIN( Start + BATCH_CHUNK_SIZE, Job.RaysCount );
+	Job.pOwner->TraceRange( Job.pRays + Start, End - Start );
 }
 
 void	RayTracer::ExitGeometry()
@@ -66,5 +633,12 @@ void	RayTracer::ExitGeometry()
 	if ( m_pQuads != NULL )
 		delete[] m_pQuads;
 	m_pQuads = NULL;
-}
+	m_QuadsCount = 0;
+
+	SAFE_DELETE_ARRAY( m_pTriangles );
+	m_TrianglesCount = 0;
 
+	SAFE_DELETE_ARRAY( m_pNodes );
+	SAFE_DELETE_ARRAY( m_pPrimitives );
+	m_NodesCount = 0;
+}
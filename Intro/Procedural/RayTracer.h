@@ -1,6 +1,6 @@
 //////////////////////////////////////////////////////////////////////////
 // Helps to ray trace a bunch of rays
-// We only raytrace for quads at the moment
+// We raytrace quads and triangles, accelerated by a BVH built with the surface area heuristic (SAH)
 //
 #pragma once
 
@@ -8,6 +8,12 @@ class	RayTracer
 {
 protected:	// CONSTANTS
 
+	static const U32	MAX_LEAF_PRIMITIVES = 4;	// Leaves are always created below that amount of primitives
+	static const U32	MAX_SAH_LEAF_PRIMITIVES = 16;	// Leaves can be created up to that amount of primitives if splitting is not worth it
+	static const U32	SAH_BINS_COUNT = 16;		// Amount of bins used to evaluate the SAH
+	static const U32	MAX_STACK_SIZE = 64;		// Maximum traversal depth
+	static const U32	BATCH_CHUNK_SIZE = 256;		// Amount of rays traced at once by a thread for batched traces
+
 public:		// NESTED TYPES
 
 	// The geometric quad structure
@@ -26,13 +32,25 @@ public:		// NESTED TYPES
 		int			MaterialID;		// Material ID associated to the quad
 	};
 
+	// The geometric triangle structure
+	// The hit UVs are the barycentric coordinates of the hit so that HitPosition = (1-U-V) * P0 + U * P1 + V * P2
+	//
+	struct	Triangle
+	{
+		float3	P0;				// Vertices in WORLD space
+		float3	P1;
+		float3	P2;
+		int			MaterialID;		// Material ID associated to the triangle
+	};
+
 	struct	Ray
 	{
 		float3	Position;		// Ray position
 		float3	Direction;		// Ray direction
 		float		HitDistance;	// Distance to the hit
-		float2	HitUV;			// UV of the hit within the hit quad
+		float2	HitUV;			// UV of the hit within the hit quad or triangle
 		Quad*		pHitQuad;		// Pointer to the quad that was hit
+		Triangle*	pHitTriangle;	// Pointer to the triangle that was hit
 	};
 
 	struct	Quad_Internal : public Quad
@@ -41,11 +59,34 @@ public:		// NESTED TYPES
 		float4	SizeAndInvSize;	// XY=0.5*Size ZW=1/(0.5*Size)
 	};
 
+	struct	Triangle_Internal : public Triangle
+	{
+		float3	Edge1;			// P1 - P0
+		float3	Edge2;			// P2 - P0
+	};
+
+protected:
+
+	// BVH nodes are stored in depth-first order so the left child of an interior node immediately follows its parent
+	struct	Node
+	{
+		float3	Min;
+		U32		Offset;			// Index of the first primitive reference for leaves, index of the right child for interior nodes
+		float3	Max;
+		U32		Count;			// Amount of primitives for leaves, 0 for interior nodes
+	};
+
 
 protected:	// FIELDS
 
-	int				m_QuadsCount;
-	Quad_Internal*	m_pQuads;
+	int					m_QuadsCount;
+	Quad_Internal*		m_pQuads;
+	int					m_TrianglesCount;
+	Triangle_Internal*	m_pTriangles;
+
+	U32					m_NodesCount;
+	Node*				m_pNodes;
+	U32*				m_pPrimitives;		// Primitive references of the leaves (quads are [0,QuadsCount[, triangles follow)
 
 
 public:		// METHODS
@@ -53,10 +94,25 @@ public:		// METHODS
 	RayTracer();
 	~RayTracer();
 
-	void	InitGeometry( int _QuadsCount, const Quad* _pQuads );
+	// Initializes the geometry and builds the BVH
+	void	InitGeometry( int _QuadsCount, const Quad* _pQuads, int _TrianglesCount=0, const Triangle* _pTriangles=NULL );
 
 	// Traces a ray in the geometry
 	bool	Trace( Ray& _Ray );
 
+	// Traces an array of rays in the geometry
+	// Rays are traced by packets of 4 using SSE and the packets are spread across all the available processors
+	// Coherent rays (e.g. neighbor rays sharing the same origin) should be stored next to each other for best performance
+	void	TraceBatch( Ray* _pRays, int _RaysCount );
+
 	void	ExitGeometry();
+
+protected:
+
+	void	BuildBVH();
+	U32		BuildNode( U32 _First, U32 _Last, const float3* _pMin, const float3* _pMax, const float3* _pCentroids, U32 _Depth );
+	void	TracePacket( Ray* _pRays, U32 _RaysCount );
+	void	TraceRange( Ray* _pRays, U32 _RaysCount );
+
+	static void	BatchChunkTask( int _TaskIndex, int _ThreadIndex, void* _pJob );
 };
@@ -63,7 +63,7 @@ void	TextureBuilder::CopyFromFast( const TextureBuilder& _Source )
 	Param.H = _Source.GetHeight();
 	Param.MipLevel = 0;
 //	Fill( Fillers::CopyFillerFast, (void*) &Param );
-	Fill( Fillers::CopyFiller, (void*) &Param );
+	Fill( Fillers::CopyFiller, (void*) &Param, &_Source != this );
 }
 
 void	TextureBuilder::CopyFrom( const TextureBuilder& _Source )
@@ -87,7 +87,7 @@ void	TextureBuilder::CopyFrom( const TextureBuilder& _Source )
 	Param.H = _Source.m_pMipSizes[2*MipLevel+1];
 	Param.MipLevel = MipLevel;
 
-	Fill( Fillers::CopyFiller, (void*) &Param );
+	Fill( Fillers::CopyFiller, (void*) &Param, &_Source != this );
 }
 
 void	TextureBuilder::Clear( const Pixel& _Pixel )
@@ -102,11 +102,46 @@ void	TextureBuilder::Clear( const Pixel& _Pixel )
 	m_bMipLevelsBuilt = false;
 }
 
-void	TextureBuilder::Fill( FillDelegate _Filler, void* _pData )
+struct	__FillJob
+{
+	TextureBuilder*					pOwner;
+	TextureBuilder::FillDelegate	pFiller;
+	void*							pData;
+	int								Height;
+};
+
+void	TextureBuilder::Fill( FillDelegate _Filler, void* _pData, bool _bParallel )
+{
+	m_bMipLevelsBuilt = false;
+
+	int	TilesCount = (m_Height + FILL_TILE_ROWS-1) / FILL_TILE_ROWS;
+	if ( !_bParallel || TilesCount <= 1 )
+	{	// Fill the mip level 0 serially
+		FillRows( _Filler, _pData, 0, m_Height );
+		return;
+	}
+
+	// The worker pool and the calling thread grab tiles of scanlines until the texture is filled
+	__FillJob	Job;
+	Job.pOwner = this;
+	Job.pFiller = _Filler;
+	Job.pData = _pData;
+	Job.Height = m_Height;
+
+	WorkerPool::ParallelFor( TilesCount, FillTileTask, &Job );
+}
+
+void	TextureBuilder::FillTileTask( int _TaskIndex, int _ThreadIndex, void* _pJob )
+{
+	__FillJob&	Job = *((__FillJob*) _pJob);
+	int	YStart = _TaskIndex * FILL_TILE_ROWS;
+	Job.pOwner->FillRows( Job.pFiller, Job.pData, YStart, MIN( YStart + FILL_TILE_ROWS, Job.Height ) );
+}
+
+void	TextureBuilder::FillRows( FillDelegate _Filler, void* _pData, int _YStart, int _YEnd )
 {
-	// Fill the mip level 0
 	float2	UV;
-	for ( int Y=0; Y < m_Height; Y++ )
+	for ( int Y=_YStart; Y < _YEnd; Y++ )
 	{
 		Pixel*	pScanline = m_ppBufferGeneric[0] + m_Width * Y;
 		UV.y = float(Y) / m_Height;
@@ -116,7 +151,6 @@ void	TextureBuilder::Fill( FillDelegate _Filler, void* _pData )
 			(*_Filler)( X, Y, UV, *pScanline, _pData );
 		}
 	}
-	m_bMipLevelsBuilt = false;
 }
 
 void	TextureBuilder::Get( int _X, int _Y, int _MipLevel, Pixel& _Color ) const
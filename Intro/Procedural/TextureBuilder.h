@@ -10,6 +10,8 @@ class	TextureBuilder
 {
 protected:	// CONSTANTS
 
+	static const int	FILL_TILE_ROWS = 8;		// Amount of scanlines filled at once by a thread in parallel fills
+
 public:		// NESTED TYPES
 
 	typedef void	(*FillDelegate)( int _X, int _Y, const float2& _UV, Pixel& _Pixel, void* _pData );
@@ -78,6 +80,7 @@ public:		// PROPERTIES
 	int				GetHeight( int _MipLevel ) const	{ return m_pMipSizes[(_MipLevel<<1)+1]; }
 
 	Pixel**			GetMips()							{ return m_ppBufferGeneric; }
+	void			InvalidateMips()					{ m_bMipLevelsBuilt = false; }	// Must be called after writing directly into the mip level 0
 	const void**	GetLastConvertedMips() const;
 
 
@@ -89,7 +92,12 @@ public:		// METHODS
 	void			CopyFromFast( const TextureBuilder& _Source );	// Copies from a source TB using mip 0 only
 	void			CopyFrom( const TextureBuilder& _Source );		// Same but if the sizes are different and target is smaller, the copy will be performed using the best mip level as source (implies generation of the mip maps on the source builder)
 	void			Clear( const Pixel& _Pixel );
-	void			Fill( FillDelegate _Filler, void* _pData );
+
+	// Calls the filler for each pixel of the mip level 0
+	//	_bParallel, set to true if the filler is safe for parallel execution: it must only write the pixel it's given and never read the other pixels of this builder (e.g. it reads from a copy) nor write any shared data.
+	//		Tiles of scanlines are then spread across all the processors and the result is identical to the serial fill.
+	void			Fill( FillDelegate _Filler, void* _pData, bool _bParallel=false );
+
 	void			Get( int _X, int _Y, int _MipLevel, Pixel& _Color ) const;
 	void			SampleWrap( float _X, float _Y, int _MipLevel, Pixel& _Pixel ) const;
 	void			SampleClamp( float _X, float _Y, int _MipLevel, Pixel& _Pixel ) const;
@@ -121,5 +129,7 @@ public:		// METHODS
 
 private:
 	void			ReleaseSpecificBuffer() const;
+	void			FillRows( FillDelegate _Filler, void* _pData, int _YStart, int _YEnd );
+	static void		FillTileTask( int _TaskIndex, int _ThreadIndex, void* _pJob );
 	float			BuildComponent( int _ComponentIndex, const ConversionParams& _Params, Pixel& _Pixel0, Pixel& _Pixel1, Pixel& _Pixel2 ) const;
 };
@@ -0,0 +1,124 @@
+//////////////////////////////////////////////////////////////////////////
+// Linear BVH helper
+//
+// Flat bounding volume hierarchy over spheres, built by sorting the sphere centers along a Morton curve
+//	- The nodes are stored in a single array in depth-first order (the left child of a node immediately follows its parent)
+//	- Each node stores the bounding box of its sphere centers and the largest radius of its spheres, which is all we need
+//		to cull nodes both when looking for the spheres containing a position and when looking for the nearest sphere center
+//	- The spheres are stored contiguously in the leaves' order so leaves are scanned linearly
+//
+// Usage: Init(), Append() all the values, then Build() before querying
+//
+#pragma once
+
+#include "../BaseLib/Containers/List.h"
+
+template<typename T> class	LinearBVH
+{
+private:	// CONSTANTS
+
+	static const U32	MAX_LEAF_ELEMENTS = 4;		// Maximum amount of spheres in a leaf node
+	static const U32	MAX_STACK_SIZE = 96;		// Maximum traversal depth (30 bits of Morton codes + median splits of identical codes)
+	static const U32	BATCH_CHUNK_SIZE = 1024;	// Amount of positions processed at once by a thread for batched queries
+
+private:	// NESTED TYPES
+
+	struct	Content
+	{
+		float3	Position;
+		float	Radius;
+		T		Value;
+	};
+
+	struct	Element
+	{
+		float3	Position;
+		float	SqRadius;
+		U32		ContentIndex;
+	};
+
+	struct	Node
+	{
+		float3	Min;			// Bounding box of the spheres' centers
+		float	MaxRadius;		// Largest sphere radius
+		float3	Max;
+		U32		Offset;			// Index of the first element for leaves, index of the right child for interior nodes
+		U32		Count;			// Amount of elements for leaves, 0 for interior nodes
+
+		float	SqDistance( const float3& _Position ) const
+		{
+			float	Dx = MAX( 0.0f, MAX( Min.x - _Position.x, _Position.x - Max.x ) );
+			float	Dy = MAX( 0.0f, MAX( Min.y - _Position.y, _Position.y - Max.y ) );
+			float	Dz = MAX( 0.0f, MAX( Min.z - _Position.z, _Position.z - Max.z ) );
+			return Dx*Dx + Dy*Dy + Dz*Dz;
+		}
+	};
+
+	struct	BatchJob
+	{
+		const LinearBVH*	pOwner;
+		U32					Count;
+		const float3*		pPositions;
+		U32*				pIndices;
+		float*				pDistances;
+	};
+
+private:	// FIELDS
+
+	List<Content>	m_Content;
+
+	U32				m_ElementsCount;
+	Element*		m_pElements;
+	U32				m_NodesCount;
+	Node*			m_pNodes;
+	bool			m_bBuilt;
+
+public:		// PROPERTIES
+
+	U32			GetCount() const					{ return m_Content.GetCount(); }
+	U32			GetNodesCount() const				{ return m_NodesCount; }
+	const T&	GetValue( U32 _Index ) const		{ return m_Content[_Index].Value; }
+
+public:		// METHODS
+
+	LinearBVH();
+	~LinearBVH();
+
+	// Clears the hierarchy
+	//	_MaxElementsCount, if known, initializes the pool of values to the specified maximum. Leave to default if to be dynamically resized.
+	void		Init( U32 _MaxElementsCount=0 );
+
+	// Appends a value to the hierarchy (the hierarchy must be rebuilt before any query)
+	//	_Position, the position of the sphere containing the value
+	//	_Radius, the radius of the sphere containing the value
+	//	_Value, the value to append
+	// Returns the index of the value
+	U32			Append( const float3& _Position, float _Radius, T _Value );
+
+	// Builds the hierarchy once all the values have been appended
+	void		Build();
+
+	// Fetches the values overlapping the provided position
+	//	_Position, the position to find overlapping values for
+	//	_Result, the list that will be populated with values overlapping the provided position
+	void		Fetch( const float3& _Position, List<T>& _Result ) const;
+
+	// Fetches the value whose sphere center is closest to the provided position
+	//	_Distance, the distance to the retrieved value
+	const T*	FetchNearest( const float3& _Position, float& _Distance ) const;
+
+	// Fetches the values closest to an array of positions, the positions are spread across all the available processors
+	//	_pIndices, the array receiving the indices of the nearest values (use GetValue() to retrieve them), ~0U if the hierarchy is empty
+	//	_pDistances, an optional array receiving the distances to the nearest values
+	void		FetchNearest( U32 _Count, const float3* _pPositions, U32* _pIndices, float* _pDistances=NULL ) const;
+
+private:
+	U32			FetchNearestIndex( const float3& _Position, float& _SqDistance ) const;
+	U32			BuildNode( const U32* _pCodes, U32 _First, U32 _Last );
+	void		FetchNearestRange( U32 _Start, U32 _End, const float3* _pPositions, U32* _pIndices, float* _pDistances ) const;
+
+	static U32		MortonSpread( U32 _Value );
+	static void		BatchChunkTask( int _TaskIndex, int _ThreadIndex, void* _pJob );
+};
+
+#include "LinearBVH.inl"
@@ -0,0 +1,356 @@
+template<typename T> LinearBVH<T>::LinearBVH()
+	: m_ElementsCount( 0 )
+	, m_pElements( NULL )
+	, m_NodesCount( 0 )
+	, m_pNodes( NULL )
+	, m_bBuilt( false )
+{
+}
+
+template<typename T> LinearBVH<T>::~LinearBVH()
+{
+	SAFE_DELETE_ARRAY( m_pNodes );
+	SAFE_DELETE_ARRAY( m_pElements );
+}
+
+template<typename T> void	LinearBVH<T>::Init( U32 _MaxElementsCount )
+{
+	SAFE_DELETE_ARRAY( m_pNodes );
+	SAFE_DELETE_ARRAY( m_pElements );
+	m_ElementsCount = 0;
+	m_NodesCount = 0;
+	m_bBuilt = false;
+
+	m_Content.SetCount( 0 );
+	if ( _MaxElementsCount > 0 )
+		m_Content.Init( _MaxElementsCount );
+}
+
+template<typename T> U32	LinearBVH<T>::Append( const float3& _Position, float _Radius, T _Value )
+{
+	U32			Index = m_Content.GetCount();
+	Content&	NewContent = m_Content.Append();
+	NewContent.Position = _Position;
+	NewContent.Radius = _Radius;
+	NewContent.Value = _Value;
+
+	m_bBuilt = false;
+
+	return Index;
+}
+
+template<typename T> void	LinearBVH<T>::Build()
+{
+	SAFE_DELETE_ARRAY( m_pNodes );
+	SAFE_DELETE_ARRAY( m_pElements );
+	m_ElementsCount = m_Content.GetCount();
+	m_NodesCount = 0;
+	m_bBuilt = true;
+	if ( m_ElementsCount == 0 )
+		return;
+
+	// Compute the bounds of the sphere centers
+	float3	Min = m_Content[0].Position;
+	float3	Max = Min;
+	for ( U32 ContentIndex=1; ContentIndex < m_ElementsCount; ContentIndex++ )
+	{
+		const float3&	P = m_Content[ContentIndex].Position;
+		Min.x = MIN( Min.x, P.x );	Max.x = MAX( Max.x, P.x );
+		Min.y = MIN( Min.y, P.y );	Max.y = MAX( Max.y, P.y );
+		Min.z = MIN( Min.z, P.z );	Max.z = MAX( Max.z, P.z );
+	}
+
+	// Compute the 30-bits Morton code of each center
+	float3	Scale;
+	Scale.x = Max.x > Min.x ? 1023.0f / (Max.x - Min.x) : 0.0f;
+	Scale.y = Max.y > Min.y ? 1023.0f / (Max.y - Min.y) : 0.0f;
+	Scale.z = Max.z > Min.z ? 1023.0f / (Max.z - Min.z) : 0.0f;
+
+	U32*	pCodes = new U32[4*m_ElementsCount];
+	U32*	pOrder = pCodes + m_ElementsCount;
+	U32*	pTempCodes = pOrder + m_ElementsCount;
+	U32*	pTempOrder = pTempCodes + m_ElementsCount;
+	for ( U32 ContentIndex=0; ContentIndex < m_ElementsCount; ContentIndex++ )
+	{
+		const float3&	P = m_Content[ContentIndex].Position;
+		U32	X = MIN( 1023U, U32( (P.x - Min.x) * Scale.x ) );
+		U32	Y = MIN( 1023U, U32( (P.y - Min.y) * Scale.y ) );
+		U32	Z = MIN( 1023U, U32( (P.z - Min.z) * Scale.z ) );
+		pCodes[ContentIndex] = MortonSpread( X ) | (MortonSpread( Y ) << 1) | (MortonSpread( Z ) << 2);
+		pOrder[ContentIndex] = ContentIndex;
+	}
+
+	// Sort elements along the Morton curve (LSD radix sort, 8 bits per pass)
+	for ( U32 Shift=0; Shift < 32; Shift+=8 )
+	{
+		U32	pOffsets[256];
+		for ( U32 i=0; i < 256; i++ )
+			pOffsets[i] = 0;
+		for ( U32 i=0; i < m_ElementsCount; i++ )
+			pOffsets[(pCodes[i] >> Shift) & 0xFF]++;
+
+		U32	Sum = 0;
+		for ( U32 i=0; i < 256; i++ )
+		{
+			U32	BucketCount = pOffsets[i];
+			pOffsets[i] = Sum;
+			Sum += BucketCount;
+		}
+
+		for ( U32 i=0; i < m_ElementsCount; i++ )
+		{
+			U32	Target = pOffsets[(pCodes[i] >> Shift) & 0xFF]++;
+			pTempCodes[Target] = pCodes[i];
+			pTempOrder[Target] = pOrder[i];
+		}
+
+		U32*	pSwap = pCodes; pCodes = pTempCodes; pTempCodes = pSwap;
+		pSwap = pOrder; pOrder = pTempOrder; pTempOrder = pSwap;
+	}
+	// 4 passes: pCodes and pOrder point to the original allocation again
+
+	// Store elements in Morton order
+	m_pElements = new Element[m_ElementsCount];
+	for ( U32 ElementIndex=0; ElementIndex < m_ElementsCount; ElementIndex++ )
+	{
+		const Content&	C = m_Content[pOrder[ElementIndex]];
+		Element&		E = m_pElements[ElementIndex];
+		E.Position = C.Position;
+		E.SqRadius = C.Radius * C.Radius;
+		E.ContentIndex = pOrder[ElementIndex];
+	}
+
+	// Build the nodes
+	m_pNodes = new Node[2*m_ElementsCount];
+	BuildNode( pCodes, 0, m_ElementsCount );
+
+	delete[] pCodes;
+}
+
+template<typename T> U32	LinearBVH<T>::BuildNode( const U32* _pCodes, U32 _First, U32 _Last )
+{
+	U32		NodeIndex = m_NodesCount++;
+	Node&	N = m_pNodes[NodeIndex];
+
+	if ( _Last - _First <= MAX_LEAF_ELEMENTS )
+	{	// Create a leaf
+		const Content&	First = m_Content[m_pElements[_First].ContentIndex];
+		N.Min = N.Max = First.Position;
+		N.MaxRadius = First.Radius;
+		for ( U32 ElementIndex=_First+1; ElementIndex < _Last; ElementIndex++ )
+		{
+			const Content&	C = m_Content[m_pElements[ElementIndex].ContentIndex];
+			N.Min.x = MIN( N.Min.x, C.Position.x );	N.Max.x = MAX( N.Max.x, C.Position.x );
+			N.Min.y = MIN( N.Min.y, C.Position.y );	N.Max.y = MAX( N.Max.y, C.Position.y );
+			N.Min.z = MIN( N.Min.z, C.Position.z );	N.Max.z = MAX( N.Max.z, C.Position.z );
+			N.MaxRadius = MAX( N.MaxRadius, C.Radius );
+		}
+		N.Offset = _First;
+		N.Count = _Last - _First;
+		return NodeIndex;
+	}
+
+	// Split at the highest bit that differs between the first and last codes, or at the middle if all the codes are identical
+	U32	Split = (_First + _Last) >> 1;
+	U32	Difference = _pCodes[_First] ^ _pCodes[_Last-1];
+	if ( Difference != 0 )
+	{
+		U32	Mask = 0x80000000U;
+		while ( (Difference & Mask) == 0 )
+			Mask >>= 1;
+
+		// Codes are sorted and share the bits above the mask so we're looking for the first code with the mask bit set
+		U32	Low = _First;
+		U32	High = _Last-1;
+		while ( Low < High )
+		{
+			U32	Middle = (Low + High) >> 1;
+			if ( _pCodes[Middle] & Mask )
+				High = Middle;
+			else
+				Low = Middle + 1;
+		}
+		Split = Low;
+	}
+
+	U32			LeftIndex = BuildNode( _pCodes, _First, Split );
+	U32			RightIndex = BuildNode( _pCodes, Split, _Last );
+	const Node&	L = m_pNodes[LeftIndex];
+	const Node&	R = m_pNodes[RightIndex];
+
+	N.Min.x = MIN( L.Min.x, R.Min.x );	N.Max.x = MAX( L.Max.x, R.Max.x );
+	N.Min.y = MIN( L.Min.y, R.Min.y );	N.Max.y = MAX( L.Max.y, R.Max.y );
+	N.Min.z = MIN( L.Min.z, R.Min.z );	N.Max.z = MAX( L.Max.z, R.Max.z );
+	N.MaxRadius = MAX( L.MaxRadius, R.MaxRadius );
+	N.Offset = RightIndex;
+	N.Count = 0;
+
+	return NodeIndex;
+}
+
+template<typename T> void	LinearBVH<T>::Fetch( const float3& _Position, List<T>& _Result ) const
+{
+	ASSERT( m_bBuilt, "Hierarchy must be built before being queried!" );
+	if ( m_NodesCount == 0 )
+		return;
+
+	U32	pStack[MAX_STACK_SIZE];
+	U32	StackSize = 0;
+	pStack[StackSize++] = 0;
+	while ( StackSize > 0 )
+	{
+		const Node&	N = m_pNodes[pStack[--StackSize]];
+		if ( N.SqDistance( _Position ) > N.MaxRadius * N.MaxRadius )
+			continue;	// Too far from any sphere of that node
+
+		if ( N.Count == 0 )
+		{
+			ASSERT( StackSize+2 <= MAX_STACK_SIZE, "Traversal stack overflow!" );
+			pStack[StackSize++] = N.Offset;
+			pStack[StackSize++] = U32(&N - m_pNodes) + 1;
+			continue;
+		}
+
+		const Element*	pElement = m_pElements + N.Offset;
+		for ( U32 ElementIndex=0; ElementIndex < N.Count; ElementIndex++, pElement++ )
+		{
+			float3	Center2Position = pElement->Position - _Position;
+			if ( Center2Position.LengthSq() <= pElement->SqRadius )
+				_Result.Append( m_Content[pElement->ContentIndex].Value );
+		}
+	}
+}
+
+template<typename T> const T*	LinearBVH<T>::FetchNearest( const float3& _Position, float& _Distance ) const
+{
+	float	SqDistance;
+	U32		Index = FetchNearestIndex( _Position, SqDistance );
+	if ( Index == ~0U )
+		return NULL;
+
+	_Distance = sqrtf( SqDistance );
+	return &m_Content[Index].Value;
+}
+
+template<typename T> U32	LinearBVH<T>::FetchNearestIndex( const float3& _Position, float& _SqDistance ) const
+{
+	ASSERT( m_bBuilt, "Hierarchy must be built before being queried!" );
+	_SqDistance = MAX_FLOAT;
+	if ( m_NodesCount == 0 )
+		return ~0U;
+
+	// Stack entries store the node index and the squared distance to its bounding box so farther nodes can be culled when popped
+	struct	StackEntry
+	{
+		U32		NodeIndex;
+		float	SqDistance;
+	}		pStack[MAX_STACK_SIZE];
+	U32		StackSize = 0;
+	U32		Result = ~0U;
+
+	U32		NodeIndex = 0;
+	while ( true )
+	{
+		const Node&	N = m_pNodes[NodeIndex];
+		if ( N.Count > 0 )
+		{	// Scan the leaf
+			const Element*	pElement = m_pElements + N.Offset;
+			for ( U32 ElementIndex=0; ElementIndex < N.Count; ElementIndex++, pElement++ )
+			{
+				float3	Center2Position = pElement->Position - _Position;
+				float	SqDistance = Center2Position.LengthSq();
+				if ( SqDistance < _SqDistance )
+				{
+					_SqDistance = SqDistance;
+					Result = pElement->ContentIndex;
+				}
+			}
+		}
+		else
+		{	// Visit the nearest child first and keep the other one for later
+			U32		NearIndex = NodeIndex + 1;
+			U32		FarIndex = N.Offset;
+			float	NearSqDistance = m_pNodes[NearIndex].SqDistance( _Position );
+			float	FarSqDistance = m_pNodes[FarIndex].SqDistance( _Position );
+			if ( FarSqDistance < NearSqDistance )
+			{
+				U32		TempIndex = NearIndex; NearIndex = FarIndex; FarIndex = TempIndex;
+				float	TempSqDistance = NearSqDistance; NearSqDistance = FarSqDistance; FarSqDistance = TempSqDistance;
+			}
+
+			if ( FarSqDistance < _SqDistance )
+			{
+				ASSERT( StackSize < MAX_STACK_SIZE, "Traversal stack overflow!" );
+				pStack[StackSize].NodeIndex = FarIndex;
+				pStack[StackSize].SqDistance = FarSqDistance;
+				StackSize++;
+			}
+			if ( NearSqDistance < _SqDistance )
+			{
+				NodeIndex = NearIndex;
+				continue;
+			}
+		}
+
+		// Pop the next node that may still contain a closer center
+		while ( StackSize > 0 && pStack[StackSize-1].SqDistance >= _SqDistance )
+			StackSize--;
+		if ( StackSize == 0 )
+			break;
+		NodeIndex = pStack[--StackSize].NodeIndex;
+	}
+
+	return Result;
+}
+
+template<typename T> void	LinearBVH<T>::FetchNearestRange( U32 _Start, U32 _End, const float3* _pPositions, U32* _pIndices, float* _pDistances ) const
+{
+	for ( U32 PositionIndex=_Start; PositionIndex < _End; PositionIndex++ )
+	{
+		float	SqDistance;
+		_pIndices[PositionIndex] = FetchNearestIndex( _pPositions[PositionIndex], SqDistance );
+		if ( _pDistances != NULL )
+			_pDistances[PositionIndex] = _pIndices[PositionIndex] != ~0U ? sqrtf( SqDistance ) : MAX_FLOAT;
+	}
+}
+
+template<typename T> void	LinearBVH<T>::FetchNearest( U32 _Count, const float3* _pPositions, U32* _pIndices, float* _pDistances ) const
+{
+	ASSERT( m_bBuilt, "Hierarchy must be built before being queried!" );
+
+	BatchJob	Job;
+	Job.pOwner = this;
+	Job.Count = _Count;
+	Job.pPositions = _pPositions;
+	Job.pIndices = _pIndices;
+	Job.pDistances = _pDistances;
+
+	// Small batches are not worth the dispatch
+	U32	ChunksCount = (_Count + BATCH_CHUNK_SIZE-1) / BATCH_CHUNK_SIZE;
+	if ( ChunksCount <= 1 )
+	{
+		FetchNearestRange( 0, _Count, _pPositions, _pIndices, _pDistances );
+		return;
+	}
+
+	WorkerPool::ParallelFor( int(ChunksCount), BatchChunkTask, &Job );
+}
+
+template<typename T> void	LinearBVH<T>::BatchChunkTask( int _TaskIndex, int _ThreadIndex, void* _pJob )
+{
+	const BatchJob&	Job = *reinterpret_cast<BatchJob*>( _pJob );
+	U32	Start = U32(_TaskIndex) * BATCH_CHUNK_SIZE;
+	U32	End = MIN( Start + BATCH_CHUNK_SIZE, Job.Count );
+	Job.pOwner->FetchNearestRange( Start, End, Job.pPositions, Job.pIndices, Job.pDistances );
+}
+
+// Inserts 2 zero bits between each of the 10 lower bits of the value
+template<typename T> U32	LinearBVH<T>::MortonSpread( U32 _Value )
+{
+	_Value &= 0x000003FF;
+	_Value = (_Value | (_Value << 16)) & 0x030000FF;
+	_Value = (_Value | (_Value <<  8)) & 0x0300F00F;
+	_Value = (_Value | (_Value <<  4)) & 0x030C30C3;
+	_Value = (_Value | (_Value <<  2)) & 0x09249249;
+	return _Value;
+}
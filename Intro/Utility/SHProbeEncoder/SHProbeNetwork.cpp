@@ -335,7 +335,7 @@ void	SHProbeNetwork::UpdateDynamicProbes( DynamicUpdateParms& _Parms ) {
 
 U32	SHProbeNetwork::GetNearestProbe( const float3& _wsPosition ) const {
 	float					ProbeDistance;
-	const SHProbe* const*	ppNearestProbe = m_ProbeOctree.FetchNearest( _wsPosition, ProbeDistance );
+	const SHProbe* const*	ppNearestProbe = m_ProbeBVH.FetchNearest( _wsPosition, ProbeDistance );
 	U32						probeID = ppNearestProbe != NULL ? (*ppNearestProbe)->m_ProbeID : 0xFFFFFFFFU;
 	return probeID;
 }
@@ -675,11 +675,11 @@ U32	SHProbeNetwork::MeshWithAdjacency::PropagateProbeInfluences( SHProbeNetwork&
 	return spreadsCount;
 }
 
-U32	SHProbeNetwork::MeshWithAdjacency::AssignNearestProbe( SHProbeNetwork& _Owner ) {
+U32	SHProbeNetwork::MeshWithAdjacency::CollectIsolatedVertices( List< float3 >& _wsPositions, List< ProbeInfluence* >& _Influences ) {
 	U32	isolatedVerticesCount = 0;
 	for ( int PrimitiveIndex=0; PrimitiveIndex < m_PrimitivesCount; PrimitiveIndex++ ) {
 		Primitive&	P = m_pPrimitives[PrimitiveIndex];
-		isolatedVerticesCount += P.AssignNearestProbe( _Owner );
+		isolatedVerticesCount += P.CollectIsolatedVertices( _wsPositions, _Influences );
 	}
 
 	return isolatedVerticesCount;
@@ -909,8 +909,8 @@ U32	SHProbeNetwork::MeshWithAdjacency::Primitive::PropagateProbeInfluences( SHPr
 	return spreadsCount;
 }
 
-// Assigns the nearest probe to any isolated vertex without probe influence (worst case scenario)
-U32	SHProbeNetwork::MeshWithAdjacency::Primitive::AssignNearestProbe( SHProbeNetwork& _Owner ) {
+// Collects the isolated vertices without probe influence (worst case scenario) so they can be assigned their nearest probe in a single batch
+U32	SHProbeNetwork::MeshWithAdjacency::Primitive::CollectIsolatedVertices( List< float3 >& _wsPositions, List< ProbeInfluence* >& _Influences ) {
 	U32				isolatedVerticesCount = 0;
 	WeldedVertex*	pWeldedVertex = &m_WeldedVertices[0];
 	int				VerticesCount = m_WeldedVertices.GetCount();
@@ -918,16 +918,8 @@ U32	SHProbeNetwork::MeshWithAdjacency::Primitive::AssignNearestProbe( SHProbeNet
 		if ( pWeldedVertex->Influence.ProbeID != ~0U )
 			continue;
 
-		float	NearestProbeSqDistance = FLT_MAX;
-		U32		NearestProbeIndex = ~0UL;
-		for ( U32 ProbeIndex=0; ProbeIndex < _Owner.m_ProbesCount; ProbeIndex++ ) {
-			float	SqDistance = (_Owner.m_pProbes[ProbeIndex].m_wsPosition - pWeldedVertex->wsPosition).LengthSq();
-			if ( SqDistance < NearestProbeSqDistance ) {
-				NearestProbeSqDistance = SqDistance;
-				NearestProbeIndex = ProbeIndex;
-			}
-		}
-		pWeldedVertex->Influence.ProbeID = NearestProbeIndex;
+		_wsPositions.Append( pWeldedVertex->wsPosition );
+		_Influences.Append( &pWeldedVertex->Influence );
 		isolatedVerticesCount++;
 	}
 
@@ -995,6 +987,16 @@ bool	SHProbeNetwork::MeshWithAdjacency::Primitive::WeldedVertex::PropagateProbeI
 	return spreading;
 }
 
+// Builds the hierarchy of probes used for nearest probe queries
+void	SHProbeNetwork::BuildProbeBVH() {
+	m_ProbeBVH.Init( m_ProbesCount );
+	for ( U32 ProbeIndex=0; ProbeIndex < m_ProbesCount; ProbeIndex++ ) {
+		SHProbe&	Probe = m_pProbes[ProbeIndex];
+		m_ProbeBVH.Append( Probe.m_wsPosition, Probe.m_MaxDistance, &Probe );
+	}
+	m_ProbeBVH.Build();
+}
+
 void	SHProbeNetwork::BuildProbeInfluenceVertexStream( Scene& _Scene, const char* _pPathToStreamFile ) {
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1052,10 +1054,27 @@ void	SHProbeNetwork::BuildProbeInfluenceVertexStream( Scene& _Scene, const char*
 
 	//////////////////////////////////////////////////////////////////////////
 	// Assign nearest probes to vertices without influence (isolated vertices)
+	List< float3 >				IsolatedPositions;
+	List< ProbeInfluence* >		IsolatedInfluences;
+	IsolatedPositions.Init( visitor.m_TotalVerticesCount );
+	IsolatedInfluences.Init( visitor.m_TotalVerticesCount );
+
 	U32	isolatedVerticesCount = 0;
 	for ( int MeshIndex=0; MeshIndex < Meshes.GetCount(); MeshIndex++ ) {
 		MeshWithAdjacency&	M = Meshes[MeshIndex];
-		isolatedVerticesCount += M.AssignNearestProbe( *this );
+		isolatedVerticesCount += M.CollectIsolatedVertices( IsolatedPositions, IsolatedInfluences );
+	}
+
+	if ( isolatedVerticesCount > 0 ) {
+		BuildProbeBVH();
+
+		U32*	pNearestIndices = new U32[isolatedVerticesCount];
+		m_ProbeBVH.FetchNearest( isolatedVerticesCount, &IsolatedPositions[0], pNearestIndices );
+		for ( U32 VertexIndex=0; VertexIndex < isolatedVerticesCount; VertexIndex++ ) {
+			U32	NearestIndex = pNearestIndices[VertexIndex];
+			IsolatedInfluences[VertexIndex]->ProbeID = NearestIndex != ~0U ? m_ProbeBVH.GetValue( NearestIndex )->m_ProbeID : ~0U;
+		}
+		SAFE_DELETE_ARRAY( pNearestIndices );
 	}
 
 	//////////////////////////////////////////////////////////////////////////
@@ -1226,26 +1245,8 @@ void	SHProbeNetwork::LoadProbes( const char* _pPathToProbes, const float3& _Scen
 
 
 	//////////////////////////////////////////////////////////////////////////
-	// Build the probes' octree
-	float	MaxDimension = (_SceneBBoxMax - _SceneBBoxMin).Max();
-
-	m_ProbeOctree.Init( _SceneBBoxMin, MaxDimension, 4.0f, m_ProbesCount );
-	int		MaxNodesCount = 0;
-	int		TotalNodesCount = 0;
-	U32		MaxNodesProbeIndex = ~0;
-	for ( U32 ProbeIndex=0; ProbeIndex < m_ProbesCount; ProbeIndex++ ) {
-		SHProbe&	Probe = m_pProbes[ProbeIndex];
-
-		int	NodesCount = m_ProbeOctree.Append( Probe.m_wsPosition, Probe.m_MaxDistance, &Probe );
-		TotalNodesCount += NodesCount;
-		if ( NodesCount > MaxNodesCount )
-		{	// New probe with more octree nodes
-			MaxNodesCount = NodesCount;
-			MaxNodesProbeIndex = ProbeIndex;
-		}
-	}
-
-	float	AverageNodesCount = float(TotalNodesCount) / m_ProbesCount;
+	// Build the probes' hierarchy
+	BuildProbeBVH();
 
 
 	//////////////////////////////////////////////////////////////////////////
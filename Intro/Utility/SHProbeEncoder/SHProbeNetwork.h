@@ -175,7 +175,7 @@ private:	// BUILD TIME STRUCTURES
 
 			void	Build( SHProbeNetwork& _Owner, const float4x4& _Local2World, const Scene::Mesh::Primitive& _SourcePrimitive, ProbeInfluence* _pProbeInfluencePerFace );
 			U32		PropagateProbeInfluences( SHProbeNetwork& _Owner );
-			U32		AssignNearestProbe( SHProbeNetwork& _Owner );
+			U32		CollectIsolatedVertices( List< float3 >& _wsPositions, List< ProbeInfluence* >& _Influences );
 			void	RedistributeProbeIDs2Vertices( ProbeInfluence const** _ppProbeInfluences ) const;
 		};
 
@@ -189,7 +189,7 @@ private:	// BUILD TIME STRUCTURES
 
 		void	Build( SHProbeNetwork& _Owner, const Scene::Mesh& _Mesh, ProbeInfluence* _pProbeInfluencePerFace );
 		U32		PropagateProbeInfluences( SHProbeNetwork& _Owner );
-		U32		AssignNearestProbe( SHProbeNetwork& _Owner );
+		U32		CollectIsolatedVertices( List< float3 >& _wsPositions, List< ProbeInfluence* >& _Influences );
 		void	RedistributeProbeIDs2Vertices( ProbeInfluence const**& _ppProbeInfluences ) const;
 	};
 
@@ -213,7 +213,7 @@ private:	// FIELDS
 	ComputeShader*			m_pCSUpdateProbeDynamicSH;	// Dynamically update probes (spread across several frames)
 	ComputeShader*			m_pCSAccumulateProbeSH;		// Dynamically update probes' SH by accumulating static + sky + dynamic SH (done each frame)
 
-	Octree<const SHProbe*>	m_ProbeOctree;				// Scene octree containing probes, queried by dynamic objects
+	LinearBVH<const SHProbe*>	m_ProbeBVH;				// Scene hierarchy containing probes, queried by dynamic objects and isolated vertices
 
 	// Constant buffers
  	CB<CBProbe>*			m_pCB_Probe;
@@ -280,6 +280,7 @@ public:
 
 private:
 
+	void			BuildProbeBVH();
 	void			BuildProbeInfluenceVertexStream( Scene& _Scene, const char* _pPathToStreamFile );
 
 friend class SHProbeEncoder;
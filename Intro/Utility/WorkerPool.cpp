@@ -0,0 +1,138 @@
+#include "../GodComplex.h"
+
+int				WorkerPool::ms_ThreadsCount = 0;
+HANDLE			WorkerPool::ms_pThreads[WorkerPool::MAX_THREADS];
+HANDLE			WorkerPool::ms_hStartSemaphore = NULL;
+HANDLE			WorkerPool::ms_hDoneEvent = NULL;
+volatile LONG	WorkerPool::ms_Busy = 0;
+volatile LONG	WorkerPool::ms_PendingWorkersCount = 0;
+volatile LONG	WorkerPool::ms_NextTask = 0;
+volatile LONG	WorkerPool::ms_NextThreadIndex = 0;
+WorkerPool::TaskDelegate	WorkerPool::ms_pTask = NULL;
+void*			WorkerPool::ms_pData = NULL;
+int				WorkerPool::ms_TasksCount = 0;
+bool			WorkerPool::ms_bExit = false;
+
+int		WorkerPool::GetThreadsCount( int _TasksCount )
+{
+	if ( ms_ThreadsCount == 0 )
+	{	// Workers are not created yet, assume we'll get as many as there are processors
+		SYSTEM_INFO	SystemInfo;
+		GetSystemInfo( &SystemInfo );
+		return MAX( 1, MIN( MIN( int(SystemInfo.dwNumberOfProcessors), MAX_THREADS ), _TasksCount ) );
+	}
+	return MAX( 1, MIN( ms_ThreadsCount, _TasksCount ) );
+}
+
+void	WorkerPool::ParallelFor( int _TasksCount, TaskDelegate _Task, void* _pData )
+{
+	if ( _TasksCount <= 0 )
+		return;
+
+	// Run serially if there's a single task or if the workers are already busy with another loop
+	if ( _TasksCount == 1 || InterlockedCompareExchange( &ms_Busy, 1, 0 ) != 0 )
+	{
+		for ( int TaskIndex=0; TaskIndex < _TasksCount; TaskIndex++ )
+			(*_Task)( TaskIndex, 0, _pData );
+		return;
+	}
+
+	if ( ms_ThreadsCount == 0 )
+		Init();
+
+	int	WorkersCount = MIN( ms_ThreadsCount, _TasksCount ) - 1;
+	if ( WorkersCount <= 0 )
+	{	// Single processor
+		for ( int TaskIndex=0; TaskIndex < _TasksCount; TaskIndex++ )
+			(*_Task)( TaskIndex, 0, _pData );
+		InterlockedExchange( &ms_Busy, 0 );
+		return;
+	}
+
+	// Setup the loop then wake up the workers
+	ms_pTask = _Task;
+	ms_pData = _pData;
+	ms_TasksCount = _TasksCount;
+	ms_NextTask = 0;
+	ms_NextThreadIndex = 1;	// The calling thread is index 0
+	ms_PendingWorkersCount = WorkersCount;
+	ReleaseSemaphore( ms_hStartSemaphore, WorkersCount, NULL );
+
+	RunTasks( 0 );
+
+	// Wait for the last worker to leave the loop before reusing the shared state
+	WaitForSingleObject( ms_hDoneEvent, INFINITE );
+	InterlockedExchange( &ms_Busy, 0 );
+}
+
+void	WorkerPool::Init()
+{
+	SYSTEM_INFO	SystemInfo;
+	GetSystemInfo( &SystemInfo );
+	int	ThreadsCount = MIN( int(SystemInfo.dwNumberOfProcessors), MAX_THREADS );
+
+	ms_ThreadsCount = 1;
+	if ( ThreadsCount <= 1 )
+		return;
+
+	ms_hStartSemaphore = CreateSemaphore( NULL, 0, MAX_THREADS, NULL );
+	ms_hDoneEvent = CreateEvent( NULL, FALSE, FALSE, NULL );	// Auto-reset
+	ms_bExit = false;
+	for ( int ThreadIndex=1; ThreadIndex < ThreadsCount; ThreadIndex++ )
+	{
+		HANDLE	hThread = CreateThread( NULL, 0, WorkerThreadProc, NULL, 0, NULL );
+		if ( hThread != NULL )
+			ms_pThreads[ms_ThreadsCount++] = hThread;
+	}
+}
+
+void	WorkerPool::Exit()
+{
+	if ( ms_ThreadsCount <= 1 )
+	{
+		ms_ThreadsCount = 0;
+		return;
+	}
+
+	int	WorkersCount = ms_ThreadsCount - 1;
+	ms_bExit = true;
+	ReleaseSemaphore( ms_hStartSemaphore, WorkersCount, NULL );
+	WaitForMultipleObjects( WorkersCount, &ms_pThreads[1], TRUE, INFINITE );
+	for ( int ThreadIndex=1; ThreadIndex < ms_ThreadsCount; ThreadIndex++ )
+		CloseHandle( ms_pThreads[ThreadIndex] );
+
+	CloseHandle( ms_hStartSemaphore );
+	CloseHandle( ms_hDoneEvent );
+	ms_hStartSemaphore = NULL;
+	ms_hDoneEvent = NULL;
+	ms_ThreadsCount = 0;
+}
+
+void	WorkerPool::RunTasks( int _ThreadIndex )
+{
+	while ( true )
+	{
+		int	TaskIndex = int( InterlockedIncrement( &ms_NextTask ) - 1 );
+		if ( TaskIndex >= ms_TasksCount )
+			break;
+
+		(*ms_pTask)( TaskIndex, _ThreadIndex, ms_pData );
+	}
+}
+
+DWORD WINAPI	WorkerPool::WorkerThreadProc( void* _pParam )
+{
+	while ( true )
+	{
+		WaitForSingleObject( ms_hStartSemaphore, INFINITE );
+		if ( ms_bExit )
+			break;
+
+		// Workers get their index when they join a loop so the indices of a loop are contiguous
+		RunTasks( int( InterlockedIncrement( &ms_NextThreadIndex ) - 1 ) );
+
+		if ( InterlockedDecrement( &ms_PendingWorkersCount ) == 0 )
+			SetEvent( ms_hDoneEvent );
+	}
+	return 0;
+}
@@ -0,0 +1,53 @@
+//////////////////////////////////////////////////////////////////////////
+// Worker pool
+//
+// A single set of persistent worker threads shared by all the parallel loops of the intro
+//	- The threads are created on the first parallel loop and live until Exit() is called at shutdown
+//	- ParallelFor() runs _Task( TaskIndex, ThreadIndex, _pData ) for all TaskIndex in [0,_TasksCount[, tasks are grabbed
+//		one at a time by the workers and the calling thread, which participates and returns once all the tasks are done
+//	- ThreadIndex is unique among the threads of a loop and lies in [0,GetThreadsCount( _TasksCount )[, the calling thread
+//		is always index 0 so per-thread scratch buffers can simply be indexed by it
+//	- A loop started while another one is running (i.e. from a task, or from another thread) runs serially on its calling thread
+//
+#pragma once
+
+class	WorkerPool
+{
+public:		// CONSTANTS
+
+	static const int	MAX_THREADS = 32;		// Including the calling thread
+
+public:		// NESTED TYPES
+
+	typedef void	(*TaskDelegate)( int _TaskIndex, int _ThreadIndex, void* _pData );
+
+private:	// FIELDS
+
+	static int				ms_ThreadsCount;		// 0 until the workers are created
+	static HANDLE			ms_pThreads[MAX_THREADS];
+	static HANDLE			ms_hStartSemaphore;		// Released once for each worker taking part in a loop
+	static HANDLE			ms_hDoneEvent;			// Signaled by the last worker to leave a loop
+	static volatile LONG	ms_Busy;				// 1 while a loop is dispatched to the workers
+	static volatile LONG	ms_PendingWorkersCount;
+	static volatile LONG	ms_NextTask;
+	static volatile LONG	ms_NextThreadIndex;
+	static TaskDelegate		ms_pTask;
+	static void*			ms_pData;
+	static int				ms_TasksCount;
+	static bool				ms_bExit;
+
+public:		// METHODS
+
+	// Returns the maximum amount of threads running a loop of _TasksCount tasks (i.e. the amount of per-thread buffers to allocate)
+	static int		GetThreadsCount( int _TasksCount );
+
+	static void		ParallelFor( int _TasksCount, TaskDelegate _Task, void* _pData );
+
+	// Stops and releases the worker threads
+	static void		Exit();
+
+private:
+	static void		Init();
+	static void		RunTasks( int _ThreadIndex );
+	static DWORD WINAPI	WorkerThreadProc( void* _pParam );
+};
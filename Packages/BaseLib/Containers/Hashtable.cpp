@@ -9,124 +9,34 @@ using namespace BaseLib;
 int	DictionaryU32::ms_MaxCollisionsCount = 0;
 #endif
 
-DictionaryU32::DictionaryU32( int _PowerOfTwoSize ) {
-	m_POT = _PowerOfTwoSize;
-	m_SizePOT = 1 << m_POT;
-	m_ppTable = new Node*[m_SizePOT];
-	memset( m_ppTable, 0, m_SizePOT*sizeof(Node*) );
+DictionaryU32::DictionaryU32( int _PowerOfTwoSize )
+	: m_map( _PowerOfTwoSize ) {
 }
-DictionaryU32::~DictionaryU32()
-{
-	for ( int i=0; i < m_SizePOT; i++ )
-	{
-		Node*	pNode = m_ppTable[i];
-		while ( pNode != NULL )
-		{
-			Node*	pOld = pNode;
-			pNode = pNode->pNext;
-
-			delete pOld;
-		}
-	}
-
-	delete[] m_ppTable;
+DictionaryU32::~DictionaryU32() {
 }
 
-void*	DictionaryU32::Get( U32 _Key ) const
-{
-//	U32		idx = _Key & (m_SizePOT-1);
-	U32		idx = Fibonacci( _Key );
-	Node*	pNode = m_ppTable[idx];
-
+void*	DictionaryU32::Get( U32 _Key ) const {
+	void**	ppValue = m_map.Get( _Key );
 #ifdef _DEBUG
-	int		CollisionsCount = 0;
-	while ( pNode != NULL )
-	{
-		if ( _Key == pNode->Key )
-		{
-			if ( CollisionsCount > ms_MaxCollisionsCount )
-				ms_MaxCollisionsCount = CollisionsCount;
-			return pNode->pValue;
-		}
- 
-		pNode = pNode->pNext;
-		CollisionsCount++;
-	}
-#else
-	while ( pNode != NULL )
-	{
-		if ( _Key == pNode->Key )
-			return pNode->pValue;
- 
-		pNode = pNode->pNext;
-	}
+	ms_MaxCollisionsCount = MAX( ms_MaxCollisionsCount, int( m_map.GetMaxCollisionsCount() ) );
 #endif
- 
-	return NULL;
+	return ppValue != NULL ? *ppValue : NULL;
 }
 
-void	DictionaryU32::Add( U32 _Key, void* _pValue )
-{
-//	U32		idx = _Key & (m_SizePOT-1);
-	U32		idx = Fibonacci( _Key );
- 
-	Node*	pNode = new Node();
-	pNode->Key = _Key;
-	pNode->pValue = _pValue;
- 
-	pNode->pNext = m_ppTable[idx];	// Here, we could add a check for m_ppTable[idx] == NULL to ensure no collision...
-	m_ppTable[idx] = pNode;
+void	DictionaryU32::Add( U32 _Key, void* _pValue ) {
+	m_map.Add( _Key ) = _pValue;
 }
 
-void	DictionaryU32::Remove( U32 _Key )
-{
-//	U32		idx = _Key & (m_SizePOT-1);
-	U32		idx = Fibonacci( _Key );
- 
-	Node*	pPrevious = NULL;
-	Node*	pCurrent = m_ppTable[idx];
-	while ( pCurrent != NULL )
-	{
-		if ( _Key == pCurrent->Key )
-		{
-			if ( pPrevious != NULL )
-				pPrevious->pNext = pCurrent->pNext;	// Link over...
-			else
-				m_ppTable[idx] = pCurrent->pNext;	// We replaced the root key...
- 
-			delete pCurrent;
- 			return;
-		}
- 
-		pPrevious = pCurrent;
-		pCurrent = pCurrent->pNext;
-	}
+void	DictionaryU32::Remove( U32 _Key ) {
+	m_map.Remove( _Key );
 }
 
 void	DictionaryU32::Clear() {
-	// Clear all linked lists of nodes from each head
-	for ( int HeadIndex=0; HeadIndex < m_SizePOT; HeadIndex++ ) {
-		Node*	pNode = m_ppTable[HeadIndex];
-		while ( pNode != NULL ) {
-			Node*	pOld = pNode;
-			pNode = pNode->pNext;
-			delete pOld;
-		}
-	}
-	// Clear heads
-	memset( m_ppTable, 0, m_SizePOT*sizeof(Node*) );
+	m_map.Clear();
 }
 
-void	DictionaryU32::ForEach( VisitorDelegate _pDelegate, void* _pUserData )
-{
-	int	EntryIndex = 0;
-	for ( int i=0; i < m_SizePOT; i++ )
-	{
-		Node*	pNode = m_ppTable[i];
-		while ( pNode != NULL )
-		{
-			(*_pDelegate)( EntryIndex++, pNode->pValue, _pUserData );
-			pNode = pNode->pNext;
-		}
-	}
-}
\ No newline at end of file
+void	DictionaryU32::ForEach( VisitorDelegate _pDelegate, void* _pUserData ) {
+	HashMap< U32, void* >::Entry*	entry = m_map.GetEntries();
+	for ( U32 EntryIndex=0; EntryIndex < m_map.GetEntriesCount(); EntryIndex++, entry++ )
+		(*_pDelegate)( EntryIndex, entry->value, _pUserData );
+}
@@ -1,5 +1,9 @@
 #pragma once
 
+#include <new>			// Placement new
+#include <utility>		// std::move
+#include <type_traits>	// Entries relocation dispatch
+
 #include "../Types.h"
 #include "../ASMHelpers.h"
 #include "../Math/Math.h"
@@ -14,70 +18,215 @@ static U32	Fibonacci32( U32 _key, U32 _POT ) {
 	return (_key * 2654435769U) >> (32-_POT);	// 2654435769 = 2^32 / Phi
 }
 
-// Source: http://blog.2of1.org/2011/07/11/simple-c-hashtable-code/
+// Flat open-addressing hash map using Robin Hood hashing
+//
+// The table is made of 2 contiguous arrays:
+//	- The slots array, indexed by the Fibonacci hash of the keys, where each slot stores the full hash of a key and the index of its entry
+//	- The entries array that densely stores the (key,value) pairs so iterating the map is a simple linear walk
+//
+// Robin Hood insertion keeps the probe sequences short by displacing the entries that are closer to their home slot than the inserted one,
+//	which also allows lookups to stop early. Removal uses backward shifting so there are no tombstones.
+// The table grows automatically when its load factor exceeds 3/4, the hashes are stored in the slots so the keys never need to be rehashed.
+//
+// Only the first GetEntriesCount() entries are constructed, the remaining entries are raw memory.
+// Entries are moved when the table grows (trivially copyable types and types that can't be moved are copied with memcpy, as in List)
 //
-// simple hashtable
-// David Kaplan <david[at]2of1.org>, 2011
-// 
-// mem = (16 + 8 * size + 24 * entries) bytes [64-bit]
-// mem = (8 + 4 * size + 12 * entries) bytes [32-bit]
-// 
-// some sizes for reference [64-bit]
-// 2^8  = 16K [probably too small - depending on use]
-// 2^16 = 512K [even bigger would be better]
-// 2^24 = 128MB [probably a bit too much]
-// 2^32 = 32GB [whooooa! watch that heap space!]
-// 
-// the hashtable uses basic linked-lists for handling collisions
-// 
-#define HT_DEFAULT_SIZE_POT	13U	// Default size if 8Kb
+// WARNING: pointers and references to the values are invalidated by Add() and Remove()!
+//
+// The default size used to be 2^13 because the chained tables could never grow, it's now only the size of the first allocation:
+//	the table doubles as needed so a small default avoids allocating 8K slots (+6K entries) for each of the many small dictionaries
+#define HT_DEFAULT_SIZE_POT	6U	// Default initial size is 64 slots (the table grows as needed and is only allocated on first insertion)
+#define HT_MIN_SIZE_POT		3U
 #define HT_MAX_KEYLEN	1024U
 
+// Hashing and comparison of the keys
+//	The default traits rely on a GetHash( const K& ) and a Compare( const K&, const K& ) function (that must return 0 for equal keys)
+//	Specialize the traits to provide heterogeneous lookups (i.e. overloads taking other key types that don't require building a K)
+template<typename K> struct	HashKeyTraits {
+	static U32	Hash( const K& _key )					{ return GetHash( _key ); }
+	static bool	Equals( const K& _a, const K& _b )		{ return Compare( _a, _b ) == 0; }
+};
+
+template<> struct	HashKeyTraits<U32> {
+	static U32	Hash( U32 _key )						{ return _key; }
+	static bool	Equals( U32 _a, U32 _b )				{ return _a == _b; }
+};
+
+#if defined(_DEBUG) || !defined(GODCOMPLEX)
+
+// String keys can be looked up using a simple const char* without allocating a temporary BString
+// An empty BString holds a null pointer, null strings are considered equal to ""
+template<> struct	HashKeyTraits<BString> {
+	static U32	Hash( const BString& _key )						{ return Hash( (const char*) _key ); }
+	static U32	Hash( const char* _key ) {
+		// djb2 (same as BString::Hash())
+		if ( _key == nullptr )
+			_key = "";
+		int c;
+		U32 hash = 5381;
+		while ( c = *_key++ )
+			hash = ((hash << 5) + hash) + c;
+		return hash;
+	}
+
+	static bool	Equals( const BString& _a, const BString& _b )	{ return Equals( (const char*) _a, (const char*) _b ); }
+	static bool	Equals( const char* _a, const BString& _b )		{ return Equals( _a, (const char*) _b ); }
+	static bool	Equals( const char* _a, const char* _b ) {
+		if ( _a == nullptr )
+			_a = "";
+		if ( _b == nullptr )
+			_b = "";
+		for ( U32 i=0; i < HT_MAX_KEYLEN; i++, _a++, _b++ ) {
+			if ( *_a != *_b )
+				return false;
+			if ( *_a == '\0' )
+				return true;
+		}
+		return true;
+	}
+};
+
+#endif
+
+template<typename K, typename T, typename Traits=HashKeyTraits<K> > class	HashMap {
+public:		// NESTED TYPES
+
+	struct	Entry {
+		K	key;
+		T	value;
+	};
+
+protected:
+
+	struct	Slot {
+		U32	hash;			// Full hash of the key
+		U32	entryIndex;		// Index of the entry in the entries array, or EMPTY
+	};
+
+	static const U32	EMPTY = ~0U;
+
+protected:	// FIELDS
+
+	U32		m_POT;
+	U32		m_slotsCount;		// 2^m_POT once allocated, 0 before the first insertion
+	Slot*	m_slots;
+
+	U32		m_entriesCount;
+	U32		m_entriesCapacity;	// 3/4 of the slots count
+	Entry*	m_entries;
+
+#ifdef _DEBUG
+	mutable U32	m_maxCollisionsCount;	// Maximum amount of different keys with the same hash compared during a single lookup
+#endif
+
+public:		// PROPERTIES
+
+	U32				GetEntriesCount() const		{ return m_entriesCount; }
+	U32				GetSlotsCount() const		{ return m_slotsCount; }
+
+	// Gives direct access to the densely stored entries, in [0,GetEntriesCount()[
+	Entry*			GetEntries()				{ return m_entries; }
+	const Entry*	GetEntries() const			{ return m_entries; }
+
+#ifdef _DEBUG
+	U32				GetMaxCollisionsCount() const	{ return m_maxCollisionsCount; }
+#endif
+
+public:		// METHODS
+
+	HashMap( U32 _initialPowerOfTwoSize=HT_DEFAULT_SIZE_POT );
+	~HashMap();
+
+	// Retrieves the value associated to the key, nullptr if the key doesn't exist
+	template<typename L>	T*	Get( const L& _key ) const;
+
+	// Retrieves the value associated to the key, a default value is created if the key doesn't exist
+	template<typename L>	T&	Add( const L& _key );
+	template<typename L>	T&	Add( const L& _key, bool& _added );
+
+	// Removes the key and its value, returns false if the key doesn't exist
+	template<typename L>	bool	Remove( const L& _key );
+
+	// Removes all the entries while keeping the allocated memory
+	void	Clear();
+
+	// Makes sure the table can hold the given amount of entries without growing
+	void	Reserve( U32 _entriesCount );
+
+protected:
+	U32		Home( U32 _hash ) const		{ return Fibonacci32( _hash, m_POT ); }
+	U32		Distance( U32 _slotIndex, U32 _hash ) const	{ return (_slotIndex - Home( _hash )) & (m_slotsCount-1); }
+
+	template<typename L>	U32	FindSlot( const L& _key, U32 _hash ) const;
+	void	InsertSlot( U32 _hash, U32 _entryIndex );
+	void	Grow( U32 _POT );
+
+	// Entries relocation
+	static const bool	IS_RAW_RELOCATABLE = std::is_trivially_copyable<Entry>::value || !std::is_move_constructible<Entry>::value;
+	static void	Relocate( Entry* _target, Entry* _source, U32 _count )	{ Relocate( _target, _source, _count, std::integral_constant< bool, IS_RAW_RELOCATABLE >() ); }
+	static void	Relocate( Entry* _target, Entry* _source, U32 _count, std::true_type );
+	static void	Relocate( Entry* _target, Entry* _source, U32 _count, std::false_type );
+	static void	Destroy( Entry* _entries, U32 _count );
+
+private:
+	HashMap( const HashMap& );
+	HashMap&	operator=( const HashMap& );
+};
+
 #if defined(_DEBUG) || !defined(GODCOMPLEX)
 
 // Hashtable of strings, only used to access constants & uniforms by name in the shaders in DEBUG mode
+// Lookups can also be made with a const char* that doesn't require to build a BString
+//
+// Several values can be stored with the same key: Add() always stores a new value that shadows the previous ones,
+//	Get() and Remove() access the most recent value of a key and AddUnique() only stores a value if the key doesn't exist
+//
 template<typename T> class	DictionaryString {
+public:
+
+	typedef bool	(*VisitorDelegate)( int _EntryIndex, const BString& _key, T& _Value, void* _pUserData );
+
 protected:	// NESTED TYPES
 
+	// The values of a key are chained from the most recent to the oldest
 	struct	Node {
 		struct Node*	pNext;
-		BString			key;
 		T				value;
 	};
 
-public:
-
-	typedef bool	(*VisitorDelegate)( int _EntryIndex, const BString& _key, T& _Value, void* _pUserData );
-
 protected:	// FIELDS
 
-	Node**	m_ppTable;
-	int		m_POT;
-	int		m_SizePOT;
-	int		m_EntriesCount;
+	HashMap< BString, Node* >	m_map;
+	int							m_EntriesCount;
 
 public:		// METHODS
 
-	DictionaryString( int _PowerOfTwoSize=HT_DEFAULT_SIZE_POT );
-	~DictionaryString();
+	DictionaryString( int _PowerOfTwoSize=HT_DEFAULT_SIZE_POT ) : m_map( _PowerOfTwoSize ), m_EntriesCount( 0 ) {}
+	~DictionaryString()			{ Clear(); }
+
+	int		GetEntriesCount() const		{ return m_EntriesCount; }	// Amount of entries in the dictionary
 
-	T*		Get( const BString& _key ) const;					// retrieve entry
-	T&		Add( const BString& _key );							// store entry
-	T&		AddUnique( const BString& _key );					// store entry
-	void	Add( const BString& _key, const T& _Value );			// store entry
-	void	AddUnique( const BString& _key, const T& _Value );	// store entry
-	void	Remove( const BString& _key );						// remove entry
+	T*		Get( const BString& _key ) const						{ return Find( _key ); }	// retrieve entry
+	T*		Get( const char* _key ) const							{ return Find( _key ); }	// retrieve entry
+	T&		Add( const BString& _key );								// store entry
+	T&		AddUnique( const BString& _key );						// store entry
+	void	Add( const BString& _key, const T& _Value )				{ Add( _key ) = _Value; }		// store entry
+	void	AddUnique( const BString& _key, const T& _Value )		{ AddUnique( _key ) = _Value; }	// store entry
+	void	Remove( const BString& _key )							{ Unlink( _key ); }		// remove entry
+	void	Remove( const char* _key )								{ Unlink( _key ); }		// remove entry
+	void	Clear();
 	void	ForEach( VisitorDelegate _pDelegate, void* _pUserData );
 
 public:
 
-//	static U32	Hash( const String& _key );
 	static U32	Hash( U32 _Key );
 
 private:
-	U32 Fibonacci( U32 _key ) const {
-		return Fibonacci32( _key, m_POT );
-	}
+	template<typename L>	T*		Find( const L& _key ) const;
+	template<typename L>	void	Unlink( const L& _key );
+
+	DictionaryString( const DictionaryString& );
+	DictionaryString&	operator=( const DictionaryString& );
 };
 
 #endif
@@ -85,14 +234,6 @@ private:
 //////////////////////////////////////////////////////////////////////////
 // Specific dictionary storing explicit typed values
 template<typename T> class	Dictionary {
-protected:	// NESTED TYPES
-
-	struct	Node {
-		struct Node*	pNext;
-		U32				key;
-		T				value;
-	};
-
 public:
 
 	typedef void	(*VisitorDelegate)( int _EntryIndex, T& _Value, void* _pUserData );
@@ -100,59 +241,40 @@ public:
 
 protected:	// FIELDS
 
-	Node**	m_ppTable;
-	int		m_POT;
-	int		m_SizePOT;
-	int		m_EntriesCount;
+	HashMap< U32, T >	m_map;
 
 #ifdef _DEBUG
 public:
-	static int	ms_MaxCollisionsCount;	// You can examine this to know if one of the dictionaries has too many collisions (i.e. size too small)
+	static int	ms_MaxCollisionsCount;	// You can examine this to know if one of the dictionaries has too many collisions (i.e. bad hashing scheme)
 #endif
 
 public:		// METHODS
 
-	Dictionary( int _PowerOfTwoSize=HT_DEFAULT_SIZE_POT );
-	~Dictionary();
+	Dictionary( int _PowerOfTwoSize=HT_DEFAULT_SIZE_POT ) : m_map( _PowerOfTwoSize ) {}
 
-	int		GetEntriesCount() const		{ return m_EntriesCount; }	// Amount of entries in the dictionary
+	int		GetEntriesCount() const		{ return int( m_map.GetEntriesCount() ); }	// Amount of entries in the dictionary
 
 	T*		Get( U32 _Key ) const;				// retrieve entry
-	T&		Add( U32 _Key );					// store entry
+	T&		Add( U32 _Key )						{ return m_map.Add( _Key ); }	// store entry
 	T&		Add( U32 _Key, const T& _Value );	// store entry
-	void	Remove( U32 _Key );					// remove entry
-	void	Clear();
+	void	Remove( U32 _Key )					{ m_map.Remove( _Key ); }		// remove entry
+	void	Clear()								{ m_map.Clear(); }
 	void	ForEach( VisitorDelegate _pDelegate, void* _pUserData );
-
-private:
-	U32 Fibonacci( U32 _key ) const {
-		return Fibonacci32( _key, m_POT );
-	}
 };
 
 // General dictionary storing blind values
 class	DictionaryU32 {
-protected:	// NESTED TYPES
-
-	struct	Node {
-		struct Node*	pNext;
-		U32				Key;
-		void*			pValue;
-	};
- 
 public:
 
 	typedef void	(*VisitorDelegate)( int _EntryIndex, void*& _pValue, void* _pUserData );
 
 protected:	// FIELDS
 
-	Node**	m_ppTable;
-	int		m_POT;
-	int		m_SizePOT;
+	HashMap< U32, void* >	m_map;
 
 #ifdef _DEBUG
 public:
-	static int	ms_MaxCollisionsCount;	// You can examine this to know if one of the dictionaries has too many collisions (i.e. size too small)
+	static int	ms_MaxCollisionsCount;	// You can examine this to know if one of the dictionaries has too many collisions (i.e. bad hashing scheme)
 #endif
 
 public:		// METHODS
@@ -160,29 +282,18 @@ public:		// METHODS
 	DictionaryU32( int _PowerOfTwoSize=HT_DEFAULT_SIZE_POT );
 	~DictionaryU32();
 
+	int		GetEntriesCount() const		{ return int( m_map.GetEntriesCount() ); }	// Amount of entries in the dictionary
+
 	void*	Get( U32 _Key ) const;			// retrieve entry
 	void	Add( U32 _Key, void* _pValue );	// store entry
 	void	Remove( U32 _Key );				// remove entry
 	void	Clear();
 	void	ForEach( VisitorDelegate _pDelegate, void* _pUserData );
-
-private:
-	U32	Fibonacci( U32 _key ) const {
-		return Fibonacci32( _key, m_POT );
-	}
 };
 
 //////////////////////////////////////////////////////////////////////////
 // Generic dictionary storing explicit typed values and using an explicit key class
 template<typename K, typename T> class	DictionaryGeneric {
-protected:		// NESTED TYPES
-
-	struct	Node {
-		struct Node*		pNext;
-		K					key;
-		T					value;
-	};
-
 public:
 
 	// Must return true to continue, false to abort visit
@@ -191,38 +302,29 @@ public:
 
 protected:	// FIELDS
 
-	Node**	m_ppTable;
-	int		m_POT;
-	int		m_SizePOT;
-	int		m_EntriesCount;
+	HashMap< K, T >	m_map;
 
 #ifdef _DEBUG
 public:
-	static int	ms_MaxCollisionsCount;	// You can examine this to know if one of the dictionaries has too many collisions (i.e. size too small)
+	static int	ms_MaxCollisionsCount;	// You can examine this to know if one of the dictionaries has too many collisions (i.e. bad hashing scheme)
 #endif
 
 public:		// METHODS
 
-	DictionaryGeneric( int _PowerOfTwoSize=HT_DEFAULT_SIZE_POT );
-	~DictionaryGeneric();
+	DictionaryGeneric( int _PowerOfTwoSize=HT_DEFAULT_SIZE_POT ) : m_map( _PowerOfTwoSize ) {}
 
-	int		GetEntriesCount() const		{ return m_EntriesCount; }	// Amount of entries in the dictionary
+	int		GetEntriesCount() const		{ return int( m_map.GetEntriesCount() ); }	// Amount of entries in the dictionary
 
 	T*		Get( const K& _Key ) const;				// retrieve entry
-	T&		Add( const K& _Key );					// store entry
+	T&		Add( const K& _Key )					{ return m_map.Add( _Key ); }	// store entry
 	T&		Add( const K& _Key, const T& _Value );	// store entry
-	void	Remove( const K& _Key );				// remove entry
-	void	Clear();
+	void	Remove( const K& _Key )					{ m_map.Remove( _Key ); }		// remove entry
+	void	Clear()									{ m_map.Clear(); }
 	void	ForEach( VisitorDelegate _pDelegate, void* _pUserData );
-
-private:
-	U32 Fibonacci( U32 _key ) const {
-		return Fibonacci32( _key, m_POT );
-	}
 };
 
 
 //////////////////////////////////////////////////////////////////////////
 #include "Hashtable.inl"
 
-}	// namespace BaseLib
\ No newline at end of file
+}	// namespace BaseLib
@@ -1,116 +1,225 @@
-#if defined(_DEBUG) || !defined(GODCOMPLEX)
-
 //////////////////////////////////////////////////////////////////////////
-// String version
-template<typename T> DictionaryString<T>::DictionaryString( int _PowerOfTwoSize ) : m_EntriesCount( 0 )
+// Flat hash map
+//
+template<typename K, typename T, typename Traits>
+HashMap<K,T,Traits>::HashMap( U32 _initialPowerOfTwoSize )
+	: m_POT( MAX( HT_MIN_SIZE_POT, _initialPowerOfTwoSize ) )
+	, m_slotsCount( 0 )
+	, m_slots( NULL )
+	, m_entriesCount( 0 )
+	, m_entriesCapacity( 0 )
+	, m_entries( NULL )
+#ifdef _DEBUG
+	, m_maxCollisionsCount( 0 )
+#endif
 {
-	m_POT = _PowerOfTwoSize;
-	m_SizePOT = 1 << m_POT;
-	m_ppTable = new Node*[m_SizePOT];
-	memset( m_ppTable, 0, m_SizePOT*sizeof(Node*) );
 }
-template<typename T> DictionaryString<T>::~DictionaryString() {
-	for ( int i=0; i < m_SizePOT; i++ ) {
-		Node*	pNode = m_ppTable[i];
-		while ( pNode != NULL ) {
-			Node*	pOld = pNode;
-			pNode = pNode->pNext;
-			delete pOld;
-		}
-	}
 
-	delete[] m_ppTable;
+template<typename K, typename T, typename Traits>
+HashMap<K,T,Traits>::~HashMap() {
+	Destroy( m_entries, m_entriesCount );
+	delete[] reinterpret_cast< U8* >( m_entries );
+	SAFE_DELETE_ARRAY( m_slots );
 }
 
-template<typename T> T*	DictionaryString<T>::Get( const BString& _key ) const {
-	if ( !m_EntriesCount )
-		return NULL;
+template<typename K, typename T, typename Traits>
+template<typename L>
+U32	HashMap<K,T,Traits>::FindSlot( const L& _key, U32 _hash ) const {
+	if ( m_entriesCount == 0 )
+		return EMPTY;
 
-//	U32		idx = _key.Hash() & (m_SizePOT-1);
-	U32		idx = Fibonacci( _key.Hash() );
-
-	Node*	pNode = m_ppTable[idx];
-	while ( pNode != NULL ) {
-		if ( !BString::Compare( _key, pNode->key, HT_MAX_KEYLEN ) )
-			return &pNode->value;
- 
-		pNode = pNode->pNext;
+	U32	mask = m_slotsCount-1;
+	U32	slotIndex = Home( _hash );
+#ifdef _DEBUG
+	U32	collisionsCount = 0;
+#endif
+	for ( U32 distance=0; ; distance++, slotIndex=(slotIndex+1) & mask ) {
+		const Slot&	slot = m_slots[slotIndex];
+		if ( slot.entryIndex == EMPTY || Distance( slotIndex, slot.hash ) < distance )
+			return EMPTY;	// We would have been stored here or sooner if we existed
+
+		if ( slot.hash != _hash )
+			continue;
+		if ( Traits::Equals( _key, m_entries[slot.entryIndex].key ) ) {
+#ifdef _DEBUG
+			m_maxCollisionsCount = MAX( m_maxCollisionsCount, collisionsCount );
+#endif
+			return slotIndex;
+		}
+#ifdef _DEBUG
+		collisionsCount++;
+#endif
 	}
- 
-	return NULL;
 }
 
-template<typename T> T&	DictionaryString<T>::Add( const BString& _key ) {
-//	U32		idx = _key.Hash() & (m_SizePOT-1);
-	U32		idx = Fibonacci( _key.Hash() );
-
- 	Node*	pNode = new Node();
+template<typename K, typename T, typename Traits>
+void	HashMap<K,T,Traits>::InsertSlot( U32 _hash, U32 _entryIndex ) {
+	U32		mask = m_slotsCount-1;
+	Slot	inserted = { _hash, _entryIndex };
+	U32		slotIndex = Home( _hash );
+	for ( U32 distance=0; ; distance++, slotIndex=(slotIndex+1) & mask ) {
+		Slot&	slot = m_slots[slotIndex];
+		if ( slot.entryIndex == EMPTY ) {
+			slot = inserted;
+			return;
+		}
 
-	int		keyLength = int( MIN( _key.Length(), HT_MAX_KEYLEN ) + 1 );
-	pNode->key = _key;
-	pNode->pNext = m_ppTable[idx];
-	m_ppTable[idx] = pNode;
+		// Steal the slot from richer entries (i.e. closer to their home slot) and keep on inserting the displaced entry
+		U32	slotDistance = Distance( slotIndex, slot.hash );
+		if ( slotDistance < distance ) {
+			Slot	temp = slot;
+			slot = inserted;
+			inserted = temp;
+			distance = slotDistance;
+		}
+	}
+}
 
-	m_EntriesCount++;
+template<typename K, typename T, typename Traits>
+void	HashMap<K,T,Traits>::Grow( U32 _POT ) {
+	Slot*	oldSlots = m_slots;
+	U32		oldSlotsCount = m_slotsCount;
+
+	m_POT = _POT;
+	m_slotsCount = 1U << m_POT;
+	m_slots = new Slot[m_slotsCount];
+	memset( m_slots, 0xFF, m_slotsCount*sizeof(Slot) );
+
+	// Re-insert existing slots, the hashes are stored so there's no need to rehash the keys
+	for ( U32 slotIndex=0; slotIndex < oldSlotsCount; slotIndex++ )
+		if ( oldSlots[slotIndex].entryIndex != EMPTY )
+			InsertSlot( oldSlots[slotIndex].hash, oldSlots[slotIndex].entryIndex );
+	SAFE_DELETE_ARRAY( oldSlots );
+
+	// Reallocate entries as raw memory and move the existing ones
+	m_entriesCapacity = m_slotsCount - (m_slotsCount >> 2);
+	Entry*	oldEntries = m_entries;
+	m_entries = reinterpret_cast< Entry* >( new U8[m_entriesCapacity*sizeof(Entry)] );
+	if ( oldEntries != NULL ) {
+		Relocate( m_entries, oldEntries, m_entriesCount );
+		delete[] reinterpret_cast< U8* >( oldEntries );
+	}
+}
 
-	return pNode->value;
+template<typename K, typename T, typename Traits>
+void	HashMap<K,T,Traits>::Relocate( Entry* _target, Entry* _source, U32 _count, std::true_type ) {
+	if ( _count > 0 )
+		memcpy( _target, _source, _count*sizeof(Entry) );
 }
 
-template<typename T> T&	DictionaryString<T>::AddUnique( const BString& _key ) {
-	T*	pExisting = Get( _key );
-	if ( pExisting != NULL )
-		return *pExisting;
+// Move-constructs the entries at their new location and destroys the old ones
+template<typename K, typename T, typename Traits>
+void	HashMap<K,T,Traits>::Relocate( Entry* _target, Entry* _source, U32 _count, std::false_type ) {
+	for ( U32 i=0; i < _count; i++ ) {
+		new( &_target[i] ) Entry( std::move( _source[i] ) );
+		_source[i].~Entry();
+	}
+}
 
-	return Add( _key );
+template<typename K, typename T, typename Traits>
+void	HashMap<K,T,Traits>::Destroy( Entry* _entries, U32 _count ) {
+	for ( U32 i=0; i < _count; i++ )
+		_entries[i].~Entry();
 }
 
-template<typename T> void	DictionaryString<T>::Add( const BString& _key, const T& _Value ) {
-	T&	Value = Add( _key );
-		Value = _Value;
+template<typename K, typename T, typename Traits>
+template<typename L>
+T*	HashMap<K,T,Traits>::Get( const L& _key ) const {
+	U32	slotIndex = FindSlot( _key, Traits::Hash( _key ) );
+	return slotIndex != EMPTY ? &m_entries[m_slots[slotIndex].entryIndex].value : NULL;
 }
 
-template<typename T> void	DictionaryString<T>::AddUnique( const BString& _key, const T& _Value ) {
-	T&	Value = AddUnique( _key );
-		Value = _Value;
+template<typename K, typename T, typename Traits>
+template<typename L>
+T&	HashMap<K,T,Traits>::Add( const L& _key ) {
+	bool	added;
+	return Add( _key, added );
 }
 
-template<typename T> void	DictionaryString<T>::Remove( const BString& _key ) {
-//	U32		idx = _key.Hash() & (m_SizePOT-1);
-	U32		idx = Fibonacci( _key.Hash() );
- 
-	Node*	pPrevious = NULL;
-	Node*	pCurrent = m_ppTable[idx];
-	while ( pCurrent != NULL ) {
-		if ( !BString::Compare( _key, pCurrent->key, HT_MAX_KEYLEN ) ) {
-			if ( pPrevious != NULL )
-				pPrevious->pNext = pCurrent->pNext;	// Link over...
-			else
-				m_ppTable[idx] = pCurrent->pNext;	// We replaced the root key...
- 
-			delete pCurrent;
- 
-			m_EntriesCount--;
+template<typename K, typename T, typename Traits>
+template<typename L>
+T&	HashMap<K,T,Traits>::Add( const L& _key, bool& _added ) {
+	U32	hash = Traits::Hash( _key );
+	U32	slotIndex = FindSlot( _key, hash );
+	if ( slotIndex != EMPTY ) {
+		_added = false;
+		return m_entries[m_slots[slotIndex].entryIndex].value;
+	}
 
-			return;
+	if ( m_slots == NULL )
+		Grow( m_POT );
+	else if ( m_entriesCount == m_entriesCapacity )
+		Grow( m_POT+1 );
+
+	U32		entryIndex = m_entriesCount++;
+	Entry&	entry = *new( &m_entries[entryIndex] ) Entry();	// Value-initialized
+	entry.key = _key;
+	InsertSlot( hash, entryIndex );
+
+	_added = true;
+	return entry.value;
+}
+
+template<typename K, typename T, typename Traits>
+template<typename L>
+bool	HashMap<K,T,Traits>::Remove( const L& _key ) {
+	U32	slotIndex = FindSlot( _key, Traits::Hash( _key ) );
+	if ( slotIndex == EMPTY )
+		return false;
+
+	// Shift back the following slots until we find an empty slot or a slot at its home position
+	U32	mask = m_slotsCount-1;
+	U32	entryIndex = m_slots[slotIndex].entryIndex;
+	for ( U32 nextSlotIndex=(slotIndex+1) & mask; ; slotIndex=nextSlotIndex, nextSlotIndex=(nextSlotIndex+1) & mask ) {
+		const Slot&	nextSlot = m_slots[nextSlotIndex];
+		if ( nextSlot.entryIndex == EMPTY || Distance( nextSlotIndex, nextSlot.hash ) == 0 ) {
+			m_slots[slotIndex].entryIndex = EMPTY;
+			break;
 		}
- 
-		pPrevious = pCurrent;
-		pCurrent = pCurrent->pNext;
+		m_slots[slotIndex] = nextSlot;
+	}
+
+	// Move the last entry into the hole to keep the entries packed
+	U32	lastEntryIndex = --m_entriesCount;
+	if ( entryIndex != lastEntryIndex ) {
+		Entry&	lastEntry = m_entries[lastEntryIndex];
+		U32		lastSlotIndex = Home( Traits::Hash( lastEntry.key ) );
+		while ( m_slots[lastSlotIndex].entryIndex != lastEntryIndex )
+			lastSlotIndex = (lastSlotIndex+1) & mask;
+		m_slots[lastSlotIndex].entryIndex = entryIndex;
+
+		// Destroy the removed entry and move the last one in its place
+		Destroy( &m_entries[entryIndex], 1 );
+		Relocate( &m_entries[entryIndex], &lastEntry, 1 );
+	} else {
+		Destroy( &m_entries[entryIndex], 1 );
 	}
+
+	return true;
+}
+
+template<typename K, typename T, typename Traits>
+void	HashMap<K,T,Traits>::Clear() {
+	Destroy( m_entries, m_entriesCount );
+	m_entriesCount = 0;
+
+	if ( m_slots != NULL )
+		memset( m_slots, 0xFF, m_slotsCount*sizeof(Slot) );
+}
+
+template<typename K, typename T, typename Traits>
+void	HashMap<K,T,Traits>::Reserve( U32 _entriesCount ) {
+	U32	POT = m_POT;
+	while ( (1U << POT) - (1U << POT >> 2) < _entriesCount )
+		POT++;
+	if ( m_slots == NULL || POT > m_POT )
+		Grow( POT );
 }
 
-// template<typename T> U32	DictionaryString<T>::Hash( const String& _key )
-// {
-//   /* djb2 */
-//   U32 hash = 5381;
-//   int c;
-//  
-//   while ( c = *_pKey++ )
-//     hash = ((hash << 5) + hash) + c;
-//  
-//   return hash;
-// }
+#if defined(_DEBUG) || !defined(GODCOMPLEX)
 
+//////////////////////////////////////////////////////////////////////////
+// String version
 template<typename T> U32	DictionaryString<T>::Hash( U32 _Key )
 {
 	U32	hash = 5381;
@@ -123,230 +232,117 @@ template<typename T> U32	DictionaryString<T>::Hash( U32 _Key )
   return hash;
 }
 
-template<typename T> void	DictionaryString<T>::ForEach( VisitorDelegate _pDelegate, void* _pUserData ) {
-	int	EntryIndex = 0;
-	for ( int i=0; i < m_SizePOT; i++ ) {
-		Node*	pNode = m_ppTable[i];
-		while ( pNode != NULL ) {
-			if ( !(*_pDelegate)( EntryIndex++, pNode->key, pNode->value, _pUserData ) )
-				return;	// Stop!
-			pNode = pNode->pNext;
-		}
-	}
+template<typename T> template<typename L> T*	DictionaryString<T>::Find( const L& _key ) const {
+	Node**	ppHead = m_map.Get( _key );
+	return ppHead != NULL ? &(*ppHead)->value : NULL;
 }
 
-#endif
-
-//////////////////////////////////////////////////////////////////////////
-// U32 specific version
-//
-#ifdef _DEBUG
-template<typename T> int	Dictionary<T>::ms_MaxCollisionsCount = 0;
-#endif
-
-template<typename T> Dictionary<T>::Dictionary( int _PowerOfTwoSize ) : m_EntriesCount( 0 ) {
-	m_POT = _PowerOfTwoSize;
-	m_SizePOT = 1 << m_POT;
-	m_ppTable = new Node*[m_SizePOT];
-	memset( m_ppTable, 0, m_SizePOT*sizeof(Node*) );
-}
-template<typename T> Dictionary<T>::~Dictionary() {
-	for ( int i=0; i < m_SizePOT; i++ ) {
-		Node*	pNode = m_ppTable[i];
-		while ( pNode != NULL ) {
-			Node*	pOld = pNode;
-			pNode = pNode->pNext;
-
-			delete pOld;
-		}
-	}
-
-	delete[] m_ppTable;
-}
-
-template<typename T> T*	Dictionary<T>::Get( U32 _Key ) const {
-	if ( !m_EntriesCount )
-		return NULL;
-
-//	U32		idx = _Key & (m_SizePOT-1);
-	U32		idx = Fibonacci( _Key );
-	Node*	pNode = m_ppTable[idx];
-
-#ifdef _DEBUG
-	int		CollisionsCount = 0;
-	while ( pNode != NULL ) {
-		if ( _Key == pNode->key ) {
-			ms_MaxCollisionsCount = MAX( ms_MaxCollisionsCount, CollisionsCount );
-			return &pNode->value;
-		}
- 
-		pNode = pNode->pNext;
-		CollisionsCount++;
-	}
-#else
-	while ( pNode != NULL )
-	{
-		if ( _Key == pNode->key )
-			return &pNode->value;
- 
-		pNode = pNode->pNext;
-	}
-#endif
-
-	return NULL;
-}
+template<typename T> T&	DictionaryString<T>::Add( const BString& _key ) {
+	Node*&	pHead = m_map.Add( _key );
 
-template<typename T> T&	Dictionary<T>::Add( U32 _Key ) {
-//	U32		idx = _Key & (m_SizePOT-1);
-	U32		idx = Fibonacci( _Key );
- 
 	Node*	pNode = new Node();
-	pNode->key = _Key;
-	pNode->pNext = m_ppTable[idx];	// Here, we could add a check for m_ppTable[idx] == NULL to ensure no collision...
-	m_ppTable[idx] = pNode;
+	pNode->pNext = pHead;
+	pHead = pNode;
 
 	m_EntriesCount++;
 
 	return pNode->value;
 }
 
-template<typename T> T&	Dictionary<T>::Add( U32 _Key, const T& _Value ) {
-	T&	Value = Add( _Key );
-	memcpy( &Value, &_Value, sizeof(T) );
+template<typename T> T&	DictionaryString<T>::AddUnique( const BString& _key ) {
+	T*	pExisting = Get( _key );
+	if ( pExisting != NULL )
+		return *pExisting;
 
-	return Value;
+	return Add( _key );
 }
 
-template<typename T> void	Dictionary<T>::Remove( U32 _Key )
-{
-//	U32		idx = _Key & (m_SizePOT-1);
-	U32		idx = Fibonacci( _Key );
- 
-	Node*	pPrevious = NULL;
-	Node*	pCurrent = m_ppTable[idx];
-	while ( pCurrent != NULL ) {
-		if ( _Key == pCurrent->key ) {
-			if ( pPrevious != NULL )
-				pPrevious->pNext = pCurrent->pNext;	// Link over...
-			else
-				m_ppTable[idx] = pCurrent->pNext;	// We replaced the root key...
-
-			delete pCurrent;
-
-			m_EntriesCount--;
-
- 			return;
-		}
- 
-		pPrevious = pCurrent;
-		pCurrent = pCurrent->pNext;
-	}
+// Removes the most recent value of the key, the key itself is removed with its last value
+template<typename T> template<typename L> void	DictionaryString<T>::Unlink( const L& _key ) {
+	Node**	ppHead = m_map.Get( _key );
+	if ( ppHead == NULL )
+		return;
+
+	Node*	pNode = *ppHead;
+	*ppHead = pNode->pNext;
+	delete pNode;
+
+	m_EntriesCount--;
+
+	if ( *ppHead == NULL )
+		m_map.Remove( _key );
 }
 
-template<typename T> void	Dictionary<T>::Clear() {
-	// Clear all linked lists of nodes from each head
-	for ( int HeadIndex=0; HeadIndex < m_SizePOT; HeadIndex++ ) {
-		Node*	pNode = m_ppTable[HeadIndex];
+template<typename T> void	DictionaryString<T>::Clear() {
+	typename HashMap< BString, Node* >::Entry*	entry = m_map.GetEntries();
+	for ( U32 i=0; i < m_map.GetEntriesCount(); i++, entry++ ) {
+		Node*	pNode = entry->value;
 		while ( pNode != NULL ) {
 			Node*	pOld = pNode;
 			pNode = pNode->pNext;
 			delete pOld;
 		}
 	}
-	// Clear heads
-	memset( m_ppTable, 0, m_SizePOT*sizeof(Node*) );
+	m_map.Clear();
+	m_EntriesCount = 0;
 }
 
-template<typename T> void	Dictionary<T>::ForEach( VisitorDelegate _pDelegate, void* _pUserData ) {
+template<typename T> void	DictionaryString<T>::ForEach( VisitorDelegate _pDelegate, void* _pUserData ) {
 	int	EntryIndex = 0;
-	for ( int i=0; i < m_SizePOT; i++ ) {
-		Node*	pNode = m_ppTable[i];
-		while ( pNode != NULL ) {
-			(*_pDelegate)( EntryIndex++, pNode->value, _pUserData );
-			pNode = pNode->pNext;
+	typename HashMap< BString, Node* >::Entry*	entry = m_map.GetEntries();
+	for ( U32 i=0; i < m_map.GetEntriesCount(); i++, entry++ ) {
+		for ( Node* pNode=entry->value; pNode != NULL; pNode=pNode->pNext ) {
+			if ( !(*_pDelegate)( EntryIndex++, entry->key, pNode->value, _pUserData ) )
+				return;	// Stop!
 		}
 	}
 }
 
+#endif
+
 //////////////////////////////////////////////////////////////////////////
-// Generic version
+// U32 specific version
 //
 #ifdef _DEBUG
-template<typename K, typename T>
-int	DictionaryGeneric<K,T>::ms_MaxCollisionsCount = 0;
+template<typename T> int	Dictionary<T>::ms_MaxCollisionsCount = 0;
 #endif
 
-template<typename K, typename T>
-DictionaryGeneric<K,T>::DictionaryGeneric( int _PowerOfTwoSize ) : m_EntriesCount( 0 )
-{
-	m_POT = _PowerOfTwoSize;
-	m_SizePOT = 1 << m_POT;
-	m_ppTable = new Node*[m_SizePOT];
-	memset( m_ppTable, 0, m_SizePOT*sizeof(Node*) );
+template<typename T> T*	Dictionary<T>::Get( U32 _Key ) const {
+	T*	pValue = m_map.Get( _Key );
+#ifdef _DEBUG
+	ms_MaxCollisionsCount = MAX( ms_MaxCollisionsCount, int( m_map.GetMaxCollisionsCount() ) );
+#endif
+	return pValue;
 }
-template<typename K, typename T>
-DictionaryGeneric<K,T>::~DictionaryGeneric()
-{
-	for ( int i=0; i < m_SizePOT; i++ )
-	{
-		Node*	pNode = m_ppTable[i];
-		while ( pNode != NULL )
-		{
-			Node*	pOld = pNode;
-			pNode = pNode->pNext;
 
-			delete pOld;
-		}
-	}
+template<typename T> T&	Dictionary<T>::Add( U32 _Key, const T& _Value ) {
+	T&	Value = Add( _Key );
+	Value = _Value;
 
-	delete[] m_ppTable;
+	return Value;
 }
 
-template<typename K, typename T>
-T*	DictionaryGeneric<K,T>::Get( const K& _Key ) const {
-	if ( !m_EntriesCount )
-		return NULL;
-
-//	U32		idx = GetHash( _Key ) & (m_SizePOT-1);
-	U32		idx = Fibonacci( GetHash( _Key ) );
-	Node*	pNode = m_ppTable[idx];
-
-	#ifdef _DEBUG
-		int		CollisionsCount = 0;
-		while ( pNode != NULL ) {
-			if ( Compare( _Key, pNode->key ) == 0 ) {
-				ms_MaxCollisionsCount = MAX( ms_MaxCollisionsCount, CollisionsCount );
-				return &pNode->value;
-			}
- 
-			pNode = pNode->pNext;
-			CollisionsCount++;
-		}
-	#else
-		while ( pNode != NULL ) {
-			if ( Compare( _Key, pNode->key ) == 0 )
-				return &pNode->value;
- 
-			pNode = pNode->pNext;
-		}
-	#endif
-
-	return NULL;
+template<typename T> void	Dictionary<T>::ForEach( VisitorDelegate _pDelegate, void* _pUserData ) {
+	typename HashMap< U32, T >::Entry*	entry = m_map.GetEntries();
+	for ( U32 EntryIndex=0; EntryIndex < m_map.GetEntriesCount(); EntryIndex++, entry++ )
+		(*_pDelegate)( EntryIndex, entry->value, _pUserData );
 }
 
+//////////////////////////////////////////////////////////////////////////
+// Generic version
+//
+#ifdef _DEBUG
 template<typename K, typename T>
-T&	DictionaryGeneric<K,T>::Add( const K& _key ) {
-//	U32		idx = GetHash( _key ) & (m_SizePOT-1);
-	U32		idx = Fibonacci( GetHash( _key ) );
- 
-	Node*	pNode = new Node();
-	pNode->key = _key;
-	pNode->pNext = m_ppTable[idx];	// Here, we could add a check for m_ppTable[idx] == NULL to ensure no collision...
-	m_ppTable[idx] = pNode;
-
-	m_EntriesCount++;
+int	DictionaryGeneric<K,T>::ms_MaxCollisionsCount = 0;
+#endif
 
-	return pNode->value;
+template<typename K, typename T>
+T*	DictionaryGeneric<K,T>::Get( const K& _Key ) const {
+	T*	pValue = m_map.Get( _Key );
+#ifdef _DEBUG
+	ms_MaxCollisionsCount = MAX( ms_MaxCollisionsCount, int( m_map.GetMaxCollisionsCount() ) );
+#endif
+	return pValue;
 }
 
 template<typename K, typename T>
@@ -357,56 +353,11 @@ T&	DictionaryGeneric<K,T>::Add( const K& _key, const T& _value ) {
 	return value;
 }
 
-template<typename K, typename T>
-void	DictionaryGeneric<K,T>::Remove( const K& _key ) {
-//	U32		idx = GetHash( _key ) & (m_SizePOT-1);
-	U32		idx = Fibonacci( GetHash( _key ) );
- 
-	Node*	pPrevious = NULL;
-	Node*	pCurrent = m_ppTable[idx];
-	while ( pCurrent != NULL ) {
-		if ( Compare( _key, pCurrent->key ) == 0 ) {
-			if ( pPrevious != NULL )
-				pPrevious->pNext = pCurrent->pNext;	// Link over...
-			else
-				m_ppTable[idx] = pCurrent->pNext;	// We replaced the root key...
-
-			delete pCurrent;
-
-			m_EntriesCount--;
-
- 			return;
-		}
- 
-		pPrevious = pCurrent;
-		pCurrent = pCurrent->pNext;
-	}
-}
-
-template<typename K, typename T>
-void	DictionaryGeneric<K,T>::Clear() {
-	// Clear all linked lists of nodes from each head
-	for ( int HeadIndex=0; HeadIndex < m_SizePOT; HeadIndex++ ) {
-		Node*	pNode = m_ppTable[HeadIndex];
-		while ( pNode != NULL ) {
-			Node*	pOld = pNode;
-			pNode = pNode->pNext;
-			delete pOld;
-		}
-	}
-	// Clear heads
-	memset( m_ppTable, 0, m_SizePOT*sizeof(Node*) );
-}
-
 template<typename K, typename T>
 void	DictionaryGeneric<K,T>::ForEach( VisitorDelegate _pDelegate, void* _pUserData ) {
-	int	EntryIndex = 0;
-	for ( int i=0; i < m_SizePOT; i++ ) {
-		Node*	pNode = m_ppTable[i];
-		while ( pNode != NULL ) {
-			if ( !(*_pDelegate)( EntryIndex++, pNode->key, pNode->value, _pUserData ) )
-				return;	// Stop!
-			pNode = pNode->pNext;
-		}
+	typename HashMap< K, T >::Entry*	entry = m_map.GetEntries();
+	for ( U32 EntryIndex=0; EntryIndex < m_map.GetEntriesCount(); EntryIndex++, entry++ ) {
+		if ( !(*_pDelegate)( EntryIndex, entry->key, entry->value, _pUserData ) )
+			return;	// Stop!
 	}
 }
@@ -1,20 +1,69 @@
 #pragma once
 
+#include <new>			// Placement new
+#include <utility>		// std::move, std::forward
+#include <type_traits>	// Relocation and radix key dispatch
+
 #include "../Types.h"
 
 namespace BaseLib {
 
 // Comparer should return:
-//	+1 if a < b 
+//	+1 if a < b
 //	-1 if a > b
 //	 0 if a == b
 template<typename T> class	IComparer {
 public:	virtual int		Compare( const T& a, const T& b ) const = 0;
 };
 
+// Radix sort keys
+//	Keys are encoded into unsigned integers whose natural order is the order of the original keys
+//	Types without a specialization are sorted by comparison using their operator<
+template<typename K> struct	RadixKey			{ static const bool	IS_RADIX = false; };
+template<> struct	RadixKey<U32>	{ static const bool	IS_RADIX = true;	typedef U32	Type;	static U32	Encode( U32 _key )	{ return _key; } };
+template<> struct	RadixKey<S32>	{ static const bool	IS_RADIX = true;	typedef U32	Type;	static U32	Encode( S32 _key )	{ return U32(_key) ^ 0x80000000U; } };
+template<> struct	RadixKey<U64>	{ static const bool	IS_RADIX = true;	typedef U64	Type;	static U64	Encode( U64 _key )	{ return _key; } };
+template<> struct	RadixKey<S64>	{ static const bool	IS_RADIX = true;	typedef U64	Type;	static U64	Encode( S64 _key )	{ return U64(_key) ^ 0x8000000000000000ULL; } };
+template<> struct	RadixKey<float>	{ static const bool	IS_RADIX = true;	typedef U32	Type;
+	static U32	Encode( float _key ) {
+		// Flip all the bits of negative numbers and only the sign bit of positive numbers
+		//	-0 is encoded as +0 since they compare equal, so they keep their relative order like with the comparison sort
+		U32	bits = *reinterpret_cast<U32*>( &_key );
+		if ( bits == 0x80000000U )
+			bits = 0;
+		return bits ^ (U32( S32(bits) >> 31 ) | 0x80000000U);
+	}
+};
+template<> struct	RadixKey<double>	{ static const bool	IS_RADIX = true;	typedef U64	Type;
+	static U64	Encode( double _key ) {
+		U64	bits = *reinterpret_cast<U64*>( &_key );
+		if ( bits == 0x8000000000000000ULL )
+			bits = 0;
+		return bits ^ (U64( S64(bits) >> 63 ) | 0x8000000000000000ULL);
+	}
+};
+
+// Optional storage for the first elements of the list, avoiding heap allocations for small lists
+template<typename T, U32 N> class	ListInlineStorage {
+protected:
+	alignas(T) U8	m_inlineBuffer[N*sizeof(T)];
+	T*	InlineBuffer() const	{ return reinterpret_cast<T*>( const_cast<U8*>( m_inlineBuffer ) ); }
+};
+template<typename T> class	ListInlineStorage<T,0> {
+protected:
+	T*	InlineBuffer() const	{ return NULL; }
+};
+
 // Simple list class
-template<typename T>
-class	List {
+//	- Only the first Count() elements are constructed, the remaining allocated elements are raw memory
+//	- The list grows geometrically when elements are appended, use Reserve() to allocate once when the final count is known
+//	- Elements are moved when the list is reallocated (trivially copyable types and types that can't be moved are copied with memcpy)
+//	- The INLINE_CAPACITY first elements are stored in the list itself so small lists don't need any heap allocation
+//
+// WARNING: pointers and references to the elements are invalidated when the list grows!
+//
+template<typename T, U32 INLINE_CAPACITY=0>
+class	List : protected ListInlineStorage<T,INLINE_CAPACITY> {
 protected:	// FIELDS
 
 	T*		m_pList;	// List of allocated elements
@@ -24,7 +73,7 @@ protected:	// FIELDS
 public:		// PROPERTIES
 
 	U32		Count() const				{ return m_Count; }
-	void	SetCount( U32 _Count );		// Sets the new count, possibility resizing the list
+	void	SetCount( U32 _Count );		// Sets the new count, possibility resizing the list. New elements are default-initialized.
 	U32		GetAllocatedSize() const	{ return m_Size; }
 
 
@@ -32,28 +81,84 @@ public:		// METHODS
 
 	List();
 	List( U32 _InitialSize );
+	List( const List& _other );
+	List( List&& _other );
 	~List();
 
+	List&		operator=( const List& _other );
+	List&		operator=( List&& _other );
+
 	// Resizes the list, preserving the existing list if possible
 	void		Resize( U32 _Size );
+	// Makes sure the list can hold the given amount of elements without reallocating
+	void		Reserve( U32 _Size );
 
 	T&			operator[]( U32 _Index );
 	const T&	operator[]( U32 _Index ) const;
 	T&			Insert( U32 _Index );
 	void		Append( const T& _Value );
+	void		Append( T&& _Value );
 	void		AppendUnique( const T& _Value );
 	T&			Append();
+	template<typename... Args>
+	T&			Emplace( Args&&... _args );	// Constructs a new element in place at the end of the list
 	T*			Ptr() { return m_pList; }
 	const T*	Ptr() const { return m_pList; }
 	U32			IndexOf( const T& _Value ) const;
 	void		RemoveAt( U32 _Index );
 	bool		Remove( const T& _Value );
-	void		Clear()	{ m_Count = 0; }
+	void		Clear();
 
+	// Sorts the elements using the comparer (see IComparer for the order of the elements)
 	void		Sort( const IComparer<T>& _Comparer );
 
+	// Sorts the elements using a _Less( const T& a, const T& b ) functor that must return true if a must be placed before b
+	template<typename LESS>
+	void		Sort( LESS _Less );
+
+	// Sorts the elements by increasing keys using a _KeyExtractor( const T& ) functor returning the key of an element
+	//	The sort is stable and switches to a radix sort for integer and floating-point keys
+	template<typename KEY_EXTRACTOR>
+	void		SortByKey( KEY_EXTRACTOR _KeyExtractor );
+
 private:
-	void		Allocate( U32 _NewCount );
+	bool		IsInline() const { return m_pList == this->InlineBuffer(); }
+	U32			GrowSize( U32 _NewCount ) const;
+	void		Reallocate( U32 _Size, T* _pNewList );
+	void		Release();
+	void		MoveFrom( List& _other );
+
+	// Element relocation (the ranges can overlap)
+	static const bool	IS_RAW_RELOCATABLE = std::is_trivially_copyable<T>::value || !std::is_move_constructible<T>::value;
+	static void	Relocate( T* _pTarget, T* _pSource, U32 _Count )	{ Relocate( _pTarget, _pSource, _Count, std::integral_constant< bool, IS_RAW_RELOCATABLE >() ); }
+	static void	Relocate( T* _pTarget, T* _pSource, U32 _Count, std::true_type );
+	static void	Relocate( T* _pTarget, T* _pSource, U32 _Count, std::false_type );
+	static void	Destroy( T* _pList, U32 _Count );
+
+	// Sorting
+	template<typename LESS>
+	void		SortElements( LESS& _Less, std::false_type );
+	template<typename LESS>
+	void		SortElements( LESS& _Comparer, std::true_type );
+	static U32	DepthLimit( U32 _Count );
+	template<typename KEY, typename KEY_EXTRACTOR>
+	void		SortKeys( KEY_EXTRACTOR& _KeyExtractor, U32* _pOrder, std::true_type );
+	template<typename KEY, typename KEY_EXTRACTOR>
+	void		SortKeys( KEY_EXTRACTOR& _KeyExtractor, U32* _pOrder, std::false_type );
+	template<typename E, typename LESS>
+	static void	IntroSort( E* _pBegin, E* _pEnd, LESS& _Less, U32 _DepthLimit );
+	template<typename E, typename LESS>
+	static void	InsertionSort( E* _pBegin, E* _pEnd, LESS& _Less );
+	template<typename E, typename LESS>
+	static void	HeapSort( E* _pBegin, E* _pEnd, LESS& _Less );
+	template<typename E, typename LESS>
+	static void	SiftDown( E* _pHeap, size_t _Root, size_t _Count, LESS& _Less );
+	template<typename E>
+	static void	SwapElements( E& a, E& b )	{ SwapElements( a, b, std::integral_constant< bool, std::is_trivially_copyable<E>::value || !std::is_move_constructible<E>::value >() ); }
+	template<typename E>
+	static void	SwapElements( E& a, E& b, std::true_type );
+	template<typename E>
+	static void	SwapElements( E& a, E& b, std::false_type );
 };
 
 #include "List.inl"
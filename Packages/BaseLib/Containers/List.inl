@@ -1,65 +1,108 @@
 
-template<typename T> List<T>::List()
-	: m_pList( NULL )
-	, m_Size( 0 )
+template<typename T, U32 N> List<T,N>::List()
+	: m_pList( this->InlineBuffer() )
+	, m_Size( N )
 	, m_Count( 0 )
 {
 
 }
 
-template<typename T> List<T>::List( U32 _InitialSize )
-	: m_pList( NULL )
-	, m_Size( 0 )
+template<typename T, U32 N> List<T,N>::List( U32 _InitialSize )
+	: m_pList( this->InlineBuffer() )
+	, m_Size( N )
 	, m_Count( 0 )
 {
-	Resize( _InitialSize );
+	Reserve( _InitialSize );
 }
 
-template<typename T> void	List<T>::Resize( U32 _Size ) {
-	if ( _Size > m_Size ) {
-		T*	old = m_pList;
-		m_pList = new T[_Size];
-		if ( old != nullptr ) {
-			// Copy former list and delete
-			memcpy_s( m_pList, _Size*sizeof(T), old, m_Size*sizeof(T) );
-			delete[] old;
-		}
-	}
-
-	m_Size = _Size;
-	m_Count = 0;
+template<typename T, U32 N> List<T,N>::List( const List& _other )
+	: m_pList( this->InlineBuffer() )
+	, m_Size( N )
+	, m_Count( 0 )
+{
+	*this = _other;
 }
 
-template<typename T> void	List<T>::SetCount( U32 _Count ) {
-	if ( _Count > m_Size ) {
-		Resize( _Count );
-	}
-	m_Count = _Count;
+template<typename T, U32 N> List<T,N>::List( List&& _other )
+	: m_pList( this->InlineBuffer() )
+	, m_Size( N )
+	, m_Count( 0 )
+{
+	MoveFrom( _other );
 }
 
-template<typename T> List<T>::~List()
+template<typename T, U32 N> List<T,N>::~List()
 {
-	delete[] m_pList;
+	Release();
+}
+
+template<typename T, U32 N> List<T,N>&	List<T,N>::operator=( const List& _other ) {
+	if ( &_other == this )
+		return *this;
+
+	Clear();
+	Reserve( _other.m_Count );
+	for ( U32 i=0; i < _other.m_Count; i++ )
+		new( &m_pList[i] ) T( _other.m_pList[i] );
+	m_Count = _other.m_Count;
+
+	return *this;
+}
+
+template<typename T, U32 N> List<T,N>&	List<T,N>::operator=( List&& _other ) {
+	if ( &_other == this )
+		return *this;
+
+	Release();
+	MoveFrom( _other );
+
+	return *this;
+}
+
+template<typename T, U32 N> void	List<T,N>::Resize( U32 _Size ) {
+	Clear();
+	Reserve( _Size );
+}
+
+template<typename T, U32 N> void	List<T,N>::Reserve( U32 _Size ) {
+	if ( _Size <= m_Size )
+		return;
+
+	Reallocate( _Size, reinterpret_cast< T* >( new U8[_Size*sizeof(T)] ) );
+}
+
+template<typename T, U32 N> void	List<T,N>::SetCount( U32 _Count ) {
+	if ( _Count > m_Count ) {
+		Reserve( _Count );
+		for ( U32 i=m_Count; i < _Count; i++ )
+			new( &m_pList[i] ) T;
+	} else {
+		Destroy( m_pList + _Count, m_Count - _Count );
+	}
+	m_Count = _Count;
 }
 
-template<typename T> T&			List<T>::operator[]( U32 _Index )
+template<typename T, U32 N> T&			List<T,N>::operator[]( U32 _Index )
 {
 	ASSERT( _Index < m_Count, "Index out of range!" );
 	return m_pList[_Index];
 }
 
-template<typename T> const T&	List<T>::operator[]( U32 _Index ) const
+template<typename T, U32 N> const T&	List<T,N>::operator[]( U32 _Index ) const
 {
 	ASSERT( _Index < m_Count, "Index out of range!" );
 	return m_pList[_Index];
 }
 
-template<typename T> void		List<T>::Append( const T& _Value ) {
-	Allocate( m_Count+1 );
-	memcpy( &m_pList[m_Count-1], &_Value, sizeof(T) );
+template<typename T, U32 N> void		List<T,N>::Append( const T& _Value ) {
+	Emplace( _Value );
 }
 
-template<typename T> void		List<T>::AppendUnique( const T& _Value ) {
+template<typename T, U32 N> void		List<T,N>::Append( T&& _Value ) {
+	Emplace( std::move( _Value ) );
+}
+
+template<typename T, U32 N> void		List<T,N>::AppendUnique( const T& _Value ) {
 	T*	pExistingValue = m_pList;
 	for ( U32 i=0; i < m_Count; i++, pExistingValue++ ) {
 		if ( *pExistingValue == _Value )
@@ -68,23 +111,44 @@ template<typename T> void		List<T>::AppendUnique( const T& _Value ) {
 	Append( _Value );
 }
 
-template<typename T> T&			List<T>::Append() {
-	Allocate( m_Count+1 );
-	return m_pList[m_Count-1];
+template<typename T, U32 N> T&			List<T,N>::Append() {
+	return Emplace();
+}
+
+template<typename T, U32 N>
+template<typename... Args>
+T&		List<T,N>::Emplace( Args&&... _args ) {
+	if ( m_Count < m_Size ) {
+		T*	pValue = new( &m_pList[m_Count] ) T( std::forward<Args>( _args )... );
+		m_Count++;
+		return *pValue;
+	}
+
+	// Construct the new element before relocating the existing ones, the arguments may reference an element of the list
+	U32	NewSize = GrowSize( m_Count+1 );
+	T*	pNewList = reinterpret_cast< T* >( new U8[NewSize*sizeof(T)] );
+	T*	pValue = new( &pNewList[m_Count] ) T( std::forward<Args>( _args )... );
+	Reallocate( NewSize, pNewList );
+	m_Count++;
+
+	return *pValue;
 }
 
-template<typename T> T&			List<T>::Insert( U32 _Index ) {
+template<typename T, U32 N> T&			List<T,N>::Insert( U32 _Index ) {
 	if ( _Index == m_Count )
-		return Append( _Index );
+		return Append();
 
 	ASSERT( _Index < m_Count, "Index out of range!" );
-	Allocate( m_Count+1 );
+	if ( m_Count == m_Size )
+		Reserve( GrowSize( m_Count+1 ) );
 
-	memcpy( &m_pList[_Index+1], &m_pList[_Index], (m_Count-1-_Index)*sizeof(T) );
-	return m_pList[_Index];
+	Relocate( &m_pList[_Index+1], &m_pList[_Index], m_Count-_Index );
+	m_Count++;
+
+	return *new( &m_pList[_Index] ) T();
 }
 
-template<typename T> U32		List<T>::IndexOf( const T& _Value ) const {
+template<typename T, U32 N> U32		List<T,N>::IndexOf( const T& _Value ) const {
 	for ( U32 i=0; i < m_Count; i++ ) {
 		if ( m_pList[i] == _Value ) {
 			return i;
@@ -93,12 +157,14 @@ template<typename T> U32		List<T>::IndexOf( const T& _Value ) const {
 	return ~0UL;
 }
 
-template<typename T> void		List<T>::RemoveAt( U32 _Index ) {
+template<typename T, U32 N> void		List<T,N>::RemoveAt( U32 _Index ) {
 	ASSERT( _Index < m_Count, "Index out of range!" );
-	memcpy( &m_pList[_Index], &m_pList[_Index+1], (m_Count-_Index-1)*sizeof(T) );
+	Destroy( &m_pList[_Index], 1 );
+	Relocate( &m_pList[_Index], &m_pList[_Index+1], m_Count-_Index-1 );
+	m_Count--;
 }
 
-template<typename T> bool		List<T>::Remove( const T& _Value ) {
+template<typename T, U32 N> bool		List<T,N>::Remove( const T& _Value ) {
 	U32	Index = IndexOf( _Value );
 	if ( Index == ~0UL )
 		return false;
@@ -107,46 +173,320 @@ template<typename T> bool		List<T>::Remove( const T& _Value ) {
 	return true;
 }
 
-template<typename T> void		List<T>::Allocate( U32 _NewCount ) {
-	if ( _NewCount <= m_Size )
-	{	// No need to re-allocate...
-		m_Count = _NewCount;
+template<typename T, U32 N> void		List<T,N>::Clear() {
+	Destroy( m_pList, m_Count );
+	m_Count = 0;
+}
+
+// Grows by doubling the allocated size to keep appending in amortized constant time
+template<typename T, U32 N> U32		List<T,N>::GrowSize( U32 _NewCount ) const {
+	U32	NewSize = m_Size != 0 ? 2 * m_Size : 8;	// Arbitrary...
+	return MAX( NewSize, _NewCount );
+}
+
+// Moves the existing elements into the new list, which becomes the current list
+template<typename T, U32 N> void		List<T,N>::Reallocate( U32 _Size, T* _pNewList ) {
+	Relocate( _pNewList, m_pList, m_Count );
+	if ( !IsInline() )
+		delete[] reinterpret_cast< U8* >( m_pList );
+
+	m_pList = _pNewList;
+	m_Size = _Size;
+}
+
+template<typename T, U32 N> void		List<T,N>::Release() {
+	Clear();
+	if ( !IsInline() )
+		delete[] reinterpret_cast< U8* >( m_pList );
+
+	m_pList = this->InlineBuffer();
+	m_Size = N;
+}
+
+// Steals the elements of the other list, the current list must be empty and released
+template<typename T, U32 N> void		List<T,N>::MoveFrom( List& _other ) {
+	if ( _other.IsInline() ) {
+		// Inline elements can't be stolen, move them individually
+		Relocate( m_pList, _other.m_pList, _other.m_Count );
+		m_Count = _other.m_Count;
+		_other.m_Count = 0;
 		return;
 	}
 
-	T*	pOldList = m_pList;
-	int	OldSize = m_Size;
+	m_pList = _other.m_pList;
+	m_Size = _other.m_Size;
+	m_Count = _other.m_Count;
 
-	if ( m_Size != 0 )
-		m_Size *= 2;
-	else
-		m_Size = 8;	// Arbitrary...
+	_other.m_pList = _other.InlineBuffer();
+	_other.m_Size = N;
+	_other.m_Count = 0;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Element relocation
+//
+template<typename T, U32 N> void		List<T,N>::Relocate( T* _pTarget, T* _pSource, U32 _Count, std::true_type ) {
+	if ( _Count > 0 )
+		memmove( _pTarget, _pSource, _Count*sizeof(T) );
+}
+
+// Move-constructs the elements at their new location and destroys the old ones, the ranges can overlap
+template<typename T, U32 N> void		List<T,N>::Relocate( T* _pTarget, T* _pSource, U32 _Count, std::false_type ) {
+	if ( _pTarget < _pSource ) {
+		for ( U32 i=0; i < _Count; i++ ) {
+			new( &_pTarget[i] ) T( std::move( _pSource[i] ) );
+			_pSource[i].~T();
+		}
+	} else {
+		for ( U32 i=_Count; i > 0; i-- ) {
+			new( &_pTarget[i-1] ) T( std::move( _pSource[i-1] ) );
+			_pSource[i-1].~T();
+		}
+	}
+}
+
+template<typename T, U32 N> void		List<T,N>::Destroy( T* _pList, U32 _Count ) {
+	for ( U32 i=0; i < _Count; i++ )
+		_pList[i].~T();
+}
 
-	m_pList = new T[m_Size];
-	memset( m_pList, 0, m_Size*sizeof(T) );
-	if ( pOldList != NULL )
-		memcpy( m_pList, pOldList, OldSize*sizeof(T) );
-	m_Count = _NewCount;
+//////////////////////////////////////////////////////////////////////////
+// Sorting
+//
+template<typename T, U32 N> void	List<T,N>::Sort( const IComparer<T>& _Comparer ) {
+	auto	Less = [&]( const T& a, const T& b ) { return _Comparer.Compare( a, b ) > 0; };
+	SortElements( Less, std::false_type() );
+}
 
-	delete[] pOldList;
+template<typename T, U32 N>
+template<typename LESS>
+void	List<T,N>::Sort( LESS _Less ) {
+	SortElements( _Less, std::is_base_of< IComparer<T>, LESS >() );
 }
 
-// Poor man's version: bubble sort!
-template<typename T> void	List<T>::Sort( const IComparer<T>& _Comparer ) {
-	if ( m_Size == 0 )
+template<typename T, U32 N>
+template<typename LESS>
+void	List<T,N>::SortElements( LESS& _Less, std::false_type ) {
+	if ( m_Count < 2 )
 		return;
 
-	T	temp;
-	for ( U32 i=0; i < m_Size-1; i++ ) {
-		T&	a = m_pList[i];
-		for ( U32 j=i; j < m_Size; j++ ) {
-			T&	b = m_pList[j];
-			if ( _Comparer.Compare( a, b ) < 0 ) {
-				// Swap since a > b and should be placed afterward...
-				memcpy_s( &temp, sizeof(T), &a, sizeof(T) );
-				memcpy_s( &a, sizeof(T), &b, sizeof(T) );
-				memcpy_s( &b, sizeof(T), &temp, sizeof(T) );
-			}
+	IntroSort( m_pList, m_pList + m_Count, _Less, DepthLimit( m_Count ) );
+}
+
+// Derived comparer classes are matched by the template overload, forward them to the IComparer version
+template<typename T, U32 N>
+template<typename LESS>
+void	List<T,N>::SortElements( LESS& _Comparer, std::true_type ) {
+	Sort( static_cast< const IComparer<T>& >( _Comparer ) );
+}
+
+template<typename T, U32 N>
+template<typename KEY_EXTRACTOR>
+void	List<T,N>::SortByKey( KEY_EXTRACTOR _KeyExtractor ) {
+	typedef typename std::decay< decltype( _KeyExtractor( *m_pList ) ) >::type	KEY;
+	if ( m_Count < 2 )
+		return;
+
+	U32*	pOrder = new U32[m_Count];
+	if ( RadixKey<KEY>::IS_RADIX && m_Count >= 64 )
+		SortKeys<KEY>( _KeyExtractor, pOrder, std::integral_constant< bool, RadixKey<KEY>::IS_RADIX >() );
+	else
+		SortKeys<KEY>( _KeyExtractor, pOrder, std::false_type() );
+
+	// Move the elements into their sorted position
+	T*	pSorted = reinterpret_cast< T* >( new U8[m_Count*sizeof(T)] );
+	for ( U32 i=0; i < m_Count; i++ )
+		Relocate( &pSorted[i], &m_pList[pOrder[i]], 1 );
+	Relocate( m_pList, pSorted, m_Count );
+
+	delete[] reinterpret_cast< U8* >( pSorted );
+	delete[] pOrder;
+}
+
+// LSD radix sort of the keys 8 bits at a time, digits shared by all the keys are skipped
+template<typename T, U32 N>
+template<typename KEY, typename KEY_EXTRACTOR>
+void	List<T,N>::SortKeys( KEY_EXTRACTOR& _KeyExtractor, U32* _pOrder, std::true_type ) {
+	typedef typename RadixKey<KEY>::Type	RADIX;
+	struct	Node {
+		RADIX	Key;
+		U32		Index;
+	};
+	static const U32	DIGITS_COUNT = sizeof(RADIX);
+
+	Node*	pNodes[2] = { new Node[m_Count], new Node[m_Count] };
+	U32		Histograms[DIGITS_COUNT][256];
+	memset( Histograms, 0, sizeof(Histograms) );
+	for ( U32 i=0; i < m_Count; i++ ) {
+		RADIX	Key = RadixKey<KEY>::Encode( _KeyExtractor( m_pList[i] ) );
+		pNodes[0][i].Key = Key;
+		pNodes[0][i].Index = i;
+		for ( U32 DigitIndex=0; DigitIndex < DIGITS_COUNT; DigitIndex++ )
+			Histograms[DigitIndex][U32( Key >> (8*DigitIndex) ) & 0xFF]++;
+	}
+
+	U32	SourceIndex = 0;
+	for ( U32 DigitIndex=0; DigitIndex < DIGITS_COUNT; DigitIndex++ ) {
+		U32*	Histogram = Histograms[DigitIndex];
+		U32		Shift = 8*DigitIndex;
+		if ( Histogram[U32( pNodes[SourceIndex][0].Key >> Shift ) & 0xFF] == m_Count )
+			continue;	// All keys share the same digit
+
+		U32	Offset = 0;
+		for ( U32 Digit=0; Digit < 256; Digit++ ) {
+			U32	Count = Histogram[Digit];
+			Histogram[Digit] = Offset;
+			Offset += Count;
 		}
+
+		const Node*	pSource = pNodes[SourceIndex];
+		Node*		pTarget = pNodes[1-SourceIndex];
+		for ( U32 i=0; i < m_Count; i++ )
+			pTarget[Histogram[U32( pSource[i].Key >> Shift ) & 0xFF]++] = pSource[i];
+		SourceIndex = 1 - SourceIndex;
+	}
+
+	for ( U32 i=0; i < m_Count; i++ )
+		_pOrder[i] = pNodes[SourceIndex][i].Index;
+
+	delete[] pNodes[1];
+	delete[] pNodes[0];
+}
+
+// Comparison sort of the keys, ties are broken by index to keep the sort stable
+template<typename T, U32 N>
+template<typename KEY, typename KEY_EXTRACTOR>
+void	List<T,N>::SortKeys( KEY_EXTRACTOR& _KeyExtractor, U32* _pOrder, std::false_type ) {
+	struct	Node {
+		KEY		Key;
+		U32		Index;
+	};
+
+	Node*	pNodes = new Node[m_Count];
+	for ( U32 i=0; i < m_Count; i++ ) {
+		pNodes[i].Key = _KeyExtractor( m_pList[i] );
+		pNodes[i].Index = i;
 	}
+
+	auto	Less = []( const Node& a, const Node& b ) {
+		if ( a.Key < b.Key )
+			return true;
+		if ( b.Key < a.Key )
+			return false;
+		return a.Index < b.Index;
+	};
+	IntroSort( pNodes, pNodes + m_Count, Less, DepthLimit( m_Count ) );
+
+	for ( U32 i=0; i < m_Count; i++ )
+		_pOrder[i] = pNodes[i].Index;
+
+	delete[] pNodes;
+}
+
+// Maximum recursion depth of the quick sort before switching to a heap sort: 2*log2(N)
+template<typename T, U32 N> U32	List<T,N>::DepthLimit( U32 _Count ) {
+	U32	Depth = 0;
+	for ( ; _Count > 1; _Count >>= 1 )
+		Depth += 2;
+	return Depth;
+}
+
+// Quick sort with a median of 3 pivot, switching to a heap sort when the recursion gets too deep and to an insertion sort for small partitions
+template<typename T, U32 N>
+template<typename E, typename LESS>
+void	List<T,N>::IntroSort( E* _pBegin, E* _pEnd, LESS& _Less, U32 _DepthLimit ) {
+	while ( _pEnd - _pBegin > 16 ) {
+		if ( _DepthLimit == 0 ) {
+			HeapSort( _pBegin, _pEnd, _Less );
+			return;
+		}
+		_DepthLimit--;
+
+		// Move the median of the first, middle and last elements at the beginning
+		E*	pMiddle = _pBegin + (_pEnd - _pBegin) / 2;
+		E*	pLast = _pEnd - 1;
+		if ( _Less( *pMiddle, *_pBegin ) )
+			SwapElements( *pMiddle, *_pBegin );
+		if ( _Less( *pLast, *pMiddle ) ) {
+			SwapElements( *pLast, *pMiddle );
+			if ( _Less( *pMiddle, *_pBegin ) )
+				SwapElements( *pMiddle, *_pBegin );
+		}
+		SwapElements( *pMiddle, *_pBegin );
+
+		// Partition around the pivot, elements equal to the pivot are spread on both sides
+		E*	pPivot = _pBegin;
+		E*	i = _pBegin + 1;
+		E*	j = pLast;
+		for ( ;; ) {
+			while ( i <= j && _Less( *i, *pPivot ) )
+				i++;
+			while ( i <= j && _Less( *pPivot, *j ) )
+				j--;
+			if ( i >= j )
+				break;
+			SwapElements( *i++, *j-- );
+		}
+		SwapElements( *pPivot, *j );
+
+		// Recurse into the smaller partition and loop on the larger one
+		if ( j - _pBegin < _pEnd - (j+1) ) {
+			IntroSort( _pBegin, j, _Less, _DepthLimit );
+			_pBegin = j+1;
+		} else {
+			IntroSort( j+1, _pEnd, _Less, _DepthLimit );
+			_pEnd = j;
+		}
+	}
+
+	InsertionSort( _pBegin, _pEnd, _Less );
+}
+
+template<typename T, U32 N>
+template<typename E, typename LESS>
+void	List<T,N>::InsertionSort( E* _pBegin, E* _pEnd, LESS& _Less ) {
+	for ( E* i=_pBegin+1; i < _pEnd; i++ )
+		for ( E* j=i; j > _pBegin && _Less( *j, *(j-1) ); j-- )
+			SwapElements( *j, *(j-1) );
+}
+
+template<typename T, U32 N>
+template<typename E, typename LESS>
+void	List<T,N>::HeapSort( E* _pBegin, E* _pEnd, LESS& _Less ) {
+	size_t	Count = _pEnd - _pBegin;
+	for ( size_t i=Count/2; i > 0; i-- )
+		SiftDown( _pBegin, i-1, Count, _Less );
+	for ( size_t i=Count-1; i > 0; i-- ) {
+		SwapElements( _pBegin[0], _pBegin[i] );
+		SiftDown( _pBegin, 0, i, _Less );
+	}
+}
+
+template<typename T, U32 N>
+template<typename E, typename LESS>
+void	List<T,N>::SiftDown( E* _pHeap, size_t _Root, size_t _Count, LESS& _Less ) {
+	for ( size_t Child=2*_Root+1; Child < _Count; _Root=Child, Child=2*_Root+1 ) {
+		if ( Child+1 < _Count && _Less( _pHeap[Child], _pHeap[Child+1] ) )
+			Child++;
+		if ( !_Less( _pHeap[_Root], _pHeap[Child] ) )
+			return;
+		SwapElements( _pHeap[_Root], _pHeap[Child] );
+	}
+}
+
+template<typename T, U32 N>
+template<typename E>
+void	List<T,N>::SwapElements( E& a, E& b, std::true_type ) {
+	alignas(E) U8	Temp[sizeof(E)];
+	memcpy( Temp, &a, sizeof(E) );
+	memcpy( &a, &b, sizeof(E) );
+	memcpy( &b, Temp, sizeof(E) );
+}
+
+template<typename T, U32 N>
+template<typename E>
+void	List<T,N>::SwapElements( E& a, E& b, std::false_type ) {
+	E	Temp( std::move( a ) );
+	a = std::move( b );
+	b = std::move( Temp );
 }
@@ -3,11 +3,17 @@
 // 
 // 	Implements a spatial hashing scheme by storing 3D positions into a discretized grid cell and using a unique hash to encode the position.
 // 	Based on http://www.beosil.com/download/CollisionDetectionHashing_VMV03.pdf
+//
+//	The table has 2 modes:
+//	 - A dynamic mode where entries are allocated from a pool and chained in the table, entries can be added, removed and moved at will
+//	 - A sorted mode built by BuildFromArray() or Sort() where entries are sorted by cell hash into contiguous SoA arrays,
+//		the table is then read-only but queries are much more cache-friendly and batched queries can be dispatched to all the cores
 // ================================================================================================
 //
 #pragma once
 
 #include "../Types.h"
+#include "..\Utility\ThreadPool.h"
 
 namespace BaseLib {
 
@@ -34,6 +40,19 @@ private:
 
 	int				m_entriesCount;
 
+	// Bounds of the positions added to the table, used to stop the searches once all the occupied cells have been visited
+	// NOTE: The bounds of a dynamic table only grow, they're reset by Clear()
+	bfloat3			m_boundsMin;
+	bfloat3			m_boundsMax;
+
+	// Sorted mode
+	bool			m_sorted;
+	U32*			m_cellStart;		// Index of the first sorted entry for each hash, entries of hash H are in [m_cellStart[H],m_cellStart[H+1][
+	float*			m_sortedX;			// Sorted positions (SoA)
+	float*			m_sortedY;
+	float*			m_sortedZ;
+	_type_*			m_sortedValues;
+
 public:
 
 	typedef keyValue_t*		entryHandle_t;
@@ -45,8 +64,20 @@ public:
 	void			Init( int _maxEntries );
 
 	// Clears the entire table
+	// NOTE: A sorted table is emptied but stays read-only, call Init() to switch back to the dynamic mode
 	void			Clear();
 
+	// Builds a sorted read-only table from arrays of positions and values, the construction is dispatched to the default thread pool
+	// NOTE: The cell size must be set before building the table
+	void			BuildFromArray( U32 _count, const bfloat3* _positions, const _type_* _values );
+
+	// Converts the entries of the dynamic table into a sorted read-only table
+	// NOTE: All the entry handles are invalidated
+	void			Sort();
+
+	// Tells if the table is in sorted read-only mode
+	bool			IsSorted() const	{ return m_sorted; }
+
 	// Sets the resolution of the grid cells by which the positions are descretized
 	void			SetGridCellSize( const bfloat3& _cellSize ) {
 		ASSERT( _cellSize.x > 1e-6f && _cellSize.y > 1e-6f && _cellSize.z > 1e-6f, "Cell size is too small!" );
@@ -82,6 +113,17 @@ public:
 	// NOTE: Neighbor cells are consulted only if within _epsilon threshold
 	void			FindAllIncludeNeighborCells( const bfloat3& _position, List< _type_* >& _result, float _epsilon=1e-3f ) const;
 
+	// Batched queries, dispatched to the default thread pool
+
+	// Retrieves the _k nearest entries within _maxDistance of each query position
+	//	_neighbors receives _k entries per query sorted by increasing distance, missing neighbors are NULL
+	//	_distances optionally receives the distances to the neighbors (MAX_FLOAT for missing neighbors)
+	void			FindKNearest( U32 _queriesCount, const bfloat3* _positions, U32 _k, float _maxDistance, List< _type_* >& _neighbors, List< float >* _distances=NULL ) const;
+
+	// Retrieves all the entries within _radius of each query position
+	//	The entries found for query Q are stored in _results at indices [_resultOffsets[Q],_resultOffsets[Q+1][
+	void			FindAllInRadius( U32 _queriesCount, const bfloat3* _positions, float _radius, List< U32 >& _resultOffsets, List< _type_* >& _results ) const;
+
 	// Retrieves the the cell for a given position
 	void			GetCellIndices( const bfloat3& _position, int& _cellX, int& _cellY, int& _cellZ ) const;
 
@@ -121,6 +163,27 @@ private:
 
 	keyValue_t*		Alloc();
 
+	void			GrowBounds( const bfloat3& _position ) {
+		m_boundsMin = m_boundsMin.Min( _position );
+		m_boundsMax = m_boundsMax.Max( _position );
+	}
+	void			ResetBounds() {
+		m_boundsMin.Set( MAX_FLOAT, MAX_FLOAT, MAX_FLOAT );
+		m_boundsMax.Set( -MAX_FLOAT, -MAX_FLOAT, -MAX_FLOAT );
+	}
+
+	void			InitTableSize( U32 _maxEntries );
+	void			ReleaseSortedArrays();
+
+	// Calls _visitor( const bfloat3& _position, _type_& _value ) for every entry with the given hash until the visitor returns false
+	// Returns false if the visit was aborted
+	template< typename V >
+	bool			VisitHash( U32 _hash, V& _visitor ) const;
+
+	// Same as above but only visits the entries that really belong to the cell (i.e. skips the entries of other cells sharing the same hash)
+	template< typename V >
+	bool			VisitCell( int _cellX, int _cellY, int _cellZ, V& _visitor ) const;
+
 	static const int	MAX_SUPPORTED_POT = 29;
 	static long			ms_PowerOfTwoNextPrimes[];
 };
@@ -171,15 +234,23 @@ SpatialHashing< _type_ >::SpatialHashing()
 	, m_entriesCount( 0 )
 	, m_table( NULL )
 	, m_nodesPool( NULL )
-	, m_freeNode( NULL ) {
+	, m_freeNode( NULL )
+	, m_sorted( false )
+	, m_cellStart( NULL )
+	, m_sortedX( NULL )
+	, m_sortedY( NULL )
+	, m_sortedZ( NULL )
+	, m_sortedValues( NULL ) {
 
 	// Assume a 1 unit grid cell size
 	m_cellSize = bfloat3::One;
 	m_invCellSize = bfloat3::One;
+	ResetBounds();
 }
 
 template < typename _type_ >
 SpatialHashing< _type_ >::~SpatialHashing() {
+	ReleaseSortedArrays();
 	SAFE_DELETE_ARRAY( m_nodesPool );
 	SAFE_DELETE_ARRAY( m_table );
 }
@@ -188,14 +259,11 @@ template < typename _type_ >
 void SpatialHashing< _type_ >::Init( int _maxEntries ) {
 	m_maxEntries = _maxEntries;
 
+	ReleaseSortedArrays();
 	SAFE_DELETE_ARRAY( m_nodesPool );
 	SAFE_DELETE_ARRAY( m_table );
 
-	// Initialize hashtable entries count to the next prime number above the nearest power of two of the specified max entries count
-	U32	POT = U32( ceilf( log2f( float( m_maxEntries ) ) ) );
-	ASSERT( POT <= MAX_SUPPORTED_POT, "Table of primes must be augmented because it only supports up to 2^29 entries!" );
-	
-	m_tableSize = ms_PowerOfTwoNextPrimes[POT];
+	InitTableSize( U32( MAX( 0, _maxEntries ) ) );
 	m_table = new keyValue_t*[m_tableSize];
 
 	// Initialize the pool of entry nodes
@@ -207,6 +275,13 @@ void SpatialHashing< _type_ >::Init( int _maxEntries ) {
 
 template < typename _type_ >
 void SpatialHashing< _type_ >::Clear() {
+	ResetBounds();
+	if ( m_sorted ) {
+		memset( m_cellStart, 0, (m_tableSize+1) * sizeof(U32) );
+		m_entriesCount = 0;
+		return;
+	}
+
 	memset( m_table, 0, m_tableSize * sizeof(keyValue_t*) );
 	if ( m_maxEntries > 0 ) {
 		memset( m_nodesPool, 0, m_maxEntries*sizeof(keyValue_t) );
@@ -222,6 +297,7 @@ void SpatialHashing< _type_ >::Clear() {
 
 template < typename _type_ >
 typename SpatialHashing< _type_ >::entryHandle_t SpatialHashing< _type_ >::Add( const bfloat3& _position, const _type_& _value ) {
+	RELEASE_ASSERT( !m_sorted, "Can't add entries to a sorted table!" );
 	U32		hash = ComputeHash( _position );
 
 	keyValue_t*	firstEntry = m_table[hash];
@@ -234,6 +310,7 @@ typename SpatialHashing< _type_ >::entryHandle_t SpatialHashing< _type_ >::Add(
 		newEntry->value = _value;
 
 		m_table[hash] = newEntry;	// We're the new first entry
+		GrowBounds( _position );
 	}
 
 	return static_cast< entryHandle_t >( newEntry );
@@ -242,6 +319,7 @@ typename SpatialHashing< _type_ >::entryHandle_t SpatialHashing< _type_ >::Add(
 
 template < typename _type_ >
 _type_& SpatialHashing< _type_ >::Add( const bfloat3& _position ) {
+	RELEASE_ASSERT( !m_sorted, "Can't add entries to a sorted table!" );
 	U32		hash = ComputeHash( _position );
 
 	keyValue_t*	firstEntry = m_table[hash];
@@ -252,6 +330,7 @@ _type_& SpatialHashing< _type_ >::Add( const bfloat3& _position ) {
 	newEntry->position = _position;
 
 	m_table[hash] = newEntry;	// We're the new first entry
+	GrowBounds( _position );
 
 	return newEntry->value;
 }
@@ -260,6 +339,7 @@ template < typename _type_ >
 bool SpatialHashing< _type_ >::Remove( entryHandle_t _handle ) {
 	keyValue_t*	entry = static_cast< keyValue_t* >( _handle );
 	ASSERT( entry != NULL, "Invalid entry!" );
+	ASSERT( !m_sorted, "Can't remove entries from a sorted table!" );
 
 	keyValue_t*	previous = nullptr;
 	keyValue_t*	current = m_table[entry->hash];
@@ -295,8 +375,10 @@ template < typename _type_ >
 bool SpatialHashing< _type_ >::Update( entryHandle_t _handle, const bfloat3& _newPosition ) {
 	keyValue_t*	entry = static_cast< keyValue_t* >( _handle );
 	ASSERT( entry != NULL, "Invalid entry!" );
+	ASSERT( !m_sorted, "Can't update entries of a sorted table!" );
 
 	entry->position = _newPosition;
+	GrowBounds( _newPosition );
 	U32	newHash = ComputeHash( _newPosition );
 	if ( newHash == entry->hash ) {
 		return true;	// No change in hash...
@@ -362,52 +444,51 @@ const bfloat3& SpatialHashing< _type_ >::GetPositionAndValuePtr( entryHandle_t _
 
 template < typename _type_ >
 _type_* SpatialHashing< _type_ >::Find( const bfloat3& _position, float _epsilon ) const {
-	U32	hash = ComputeHash( _position );
+	_type_*	result = nullptr;
+	auto	visitor = [&]( const bfloat3& _entryPosition, _type_& _value ) {
+		if ( !_entryPosition.Almost( _position, _epsilon ) )
+			return true;
 
-	keyValue_t*	current = m_table[hash];
-	while ( current != nullptr ) {
-		if ( current->position.Compare( _position, _epsilon ) ) {
-			return &current->value;	// Found it!
-		}
-		current = current->next;
-	}
+		result = &_value;	// Found it!
+		return false;
+	};
+	VisitHash( ComputeHash( _position ), visitor );
 
-	return nullptr;	// Not found...
+	return result;
 }
 
 template < typename _type_ >
 void	SpatialHashing< _type_ >::FindAll( const bfloat3& _position, List< _type_* >& _result, float _epsilon ) const {
-	U32	hash = ComputeHash( _position );
-
-	keyValue_t*	current = m_table[hash];
-	while ( current != nullptr ) {
-		if ( current->position.Compare( _position, _epsilon ) ) {
-			_result.Append( &current->value );	// Another match!
+	auto	visitor = [&]( const bfloat3& _entryPosition, _type_& _value ) {
+		if ( _entryPosition.Almost( _position, _epsilon ) ) {
+			_result.Append( &_value );	// Another match!
 		}
-		current = current->next;
-	}
+		return true;
+	};
+	VisitHash( ComputeHash( _position ), visitor );
 }
 
 template < typename _type_ >
 void	SpatialHashing< _type_ >::FindAllIncludeNeighborCells( const bfloat3& _position, List< _type_* >& _result, float _epsilon ) const {
 
 	int	minCellX, minCellY, minCellZ;
-	GetCellIndices( _position - _epsilon*bfloat3::one, minCellX, minCellY, minCellZ );
+	GetCellIndices( _position - _epsilon*bfloat3::One, minCellX, minCellY, minCellZ );
 
 	int	maxCellX, maxCellY, maxCellZ;
-	GetCellIndices( _position + _epsilon*bfloat3::one, maxCellX, maxCellY, maxCellZ );
+	GetCellIndices( _position + _epsilon*bfloat3::One, maxCellX, maxCellY, maxCellZ );
+
+	auto	visitor = [&]( const bfloat3& _entryPosition, _type_& _value ) {
+		if ( _entryPosition.Almost( _position, _epsilon ) ) {
+			_result.Append( &_value );	// Another match!
+		}
+		return true;
+	};
 
+	// Only visit the entries that belong to each cell, otherwise neighbor cells sharing the same hash would report the same entries several times
 	for ( int Z=minCellZ; Z <= maxCellZ; Z++ ) {
 		for ( int Y=minCellY; Y <= maxCellY; Y++ ) {
 			for ( int X=minCellX; X <= maxCellX; X++ ) {
-				U32		hash = ComputeHash( X, Y, Z );
-				keyValue_t*	current = m_table[hash];
-				while ( current != nullptr ) {
-					if ( current->position.Compare( _position, _epsilon ) ) {
-						_result.Append( &current->value );	// Another match!
-					}
-					current = current->next;
-				}
+				VisitCell( X, Y, Z, visitor );
 			}
 		}
 	}
@@ -415,9 +496,9 @@ void	SpatialHashing< _type_ >::FindAllIncludeNeighborCells( const bfloat3& _posi
 
 template < typename _type_ >
 void	SpatialHashing< _type_ >::GetCellIndices( const bfloat3& _position, int& _cellX, int& _cellY, int& _cellZ ) const {
-	_cellX = int( idMath::Floor( _position.x * m_invCellSize.x ) );
-	_cellY = int( idMath::Floor( _position.y * m_invCellSize.y ) );
-	_cellZ = int( idMath::Floor( _position.z * m_invCellSize.z ) );
+	_cellX = int( floorf( _position.x * m_invCellSize.x ) );
+	_cellY = int( floorf( _position.y * m_invCellSize.y ) );
+	_cellZ = int( floorf( _position.z * m_invCellSize.z ) );
 }
 
 template < typename _type_ >
@@ -431,50 +512,32 @@ bfloat3	SpatialHashing< _type_ >::GetCellCenter( int _cellX, int _cellY, int _ce
 
 template < typename _type_ >
 _type_*	SpatialHashing< _type_ >::FindFirstValueInCell( int _cellX, int _cellY, int _cellZ ) const {
-	U32		hash = ComputeHash( _cellX, _cellY, _cellZ );	
-	keyValue_t*	current = m_table[hash];
-	while ( current != nullptr ) {
+	_type_*	result = nullptr;
+	auto	visitor = [&]( const bfloat3& _entryPosition, _type_& _value ) {
+		result = &_value;
+		return false;
+	};
+	VisitCell( _cellX, _cellY, _cellZ, visitor );
 
-		int	entryCellX, entryCellY, entryCellZ;
-		GetCellIndices( current->position, entryCellX, entryCellY, entryCellZ );
-		if ( entryCellX == _cellX && entryCellY == _cellY && entryCellZ == _cellZ ) {
-			return &current->value;
-		}
-		current = current->next;
-	}
-	return nullptr;
+	return result;
 }
 
 template < typename _type_ >
 void	SpatialHashing< _type_ >::FindAllValuesInCell( int _cellX, int _cellY, int _cellZ, List< _type_ >& _values ) const {
-	U32	hash = ComputeHash( _cellX, _cellY, _cellZ );
-
-	keyValue_t*	current = m_table[hash];
-	while ( current != nullptr ) {
-
-		int	entryCellX, entryCellY, entryCellZ;
-		GetCellIndices( current->position, entryCellX, entryCellY, entryCellZ );
-		if ( entryCellX == _cellX && entryCellY == _cellY && entryCellZ == _cellZ ) {
-			_values.Append( current->value );
-		}
-		current = current->next;
-	}
+	auto	visitor = [&]( const bfloat3& _entryPosition, _type_& _value ) {
+		_values.Append( _value );
+		return true;
+	};
+	VisitCell( _cellX, _cellY, _cellZ, visitor );
 }
 
 template < typename _type_ >
 void	SpatialHashing< _type_ >::FindAllValuePointersInCell( int _cellX, int _cellY, int _cellZ, List< _type_* >& _values ) const {
-	U32	hash = ComputeHash( _cellX, _cellY, _cellZ );
-
-	keyValue_t*	current = m_table[hash];
-	while ( current != nullptr ) {
-
-		int	entryCellX, entryCellY, entryCellZ;
-		GetCellIndices( current->position, entryCellX, entryCellY, entryCellZ );
-		if ( entryCellX == _cellX && entryCellY == _cellY && entryCellZ == _cellZ ) {
-			_values.Append( &current->value );
-		}
-		current = current->next;
-	}
+	auto	visitor = [&]( const bfloat3& _entryPosition, _type_& _value ) {
+		_values.Append( &_value );
+		return true;
+	};
+	VisitCell( _cellX, _cellY, _cellZ, visitor );
 }
 
 template < typename _type_ >
@@ -494,4 +557,403 @@ typename SpatialHashing< _type_ >::keyValue_t* SpatialHashing< _type_ >::Alloc()
 	return node;
 }
 
-}	// namespace BaseLib}
\ No newline at end of file
+template < typename _type_ >
+void	SpatialHashing< _type_ >::InitTableSize( U32 _maxEntries ) {
+	// Initialize hashtable entries count to the next prime number above the nearest power of two of the specified max entries count
+	U32	POT = 0;
+	while ( (1U << POT) < _maxEntries )
+		POT++;
+	ASSERT( POT <= MAX_SUPPORTED_POT, "Table of primes must be augmented because it only supports up to 2^29 entries!" );
+
+	m_tableSize = ms_PowerOfTwoNextPrimes[POT];
+}
+
+template < typename _type_ >
+void	SpatialHashing< _type_ >::ReleaseSortedArrays() {
+	SAFE_DELETE_ARRAY( m_sortedValues );
+	SAFE_DELETE_ARRAY( m_sortedZ );
+	SAFE_DELETE_ARRAY( m_sortedY );
+	SAFE_DELETE_ARRAY( m_sortedX );
+	SAFE_DELETE_ARRAY( m_cellStart );
+	m_sorted = false;
+}
+
+template < typename _type_ >
+template< typename V >
+bool	SpatialHashing< _type_ >::VisitHash( U32 _hash, V& _visitor ) const {
+	if ( m_sorted ) {
+		U32	end = m_cellStart[_hash+1];
+		for ( U32 i=m_cellStart[_hash]; i < end; i++ ) {
+			if ( !_visitor( bfloat3( m_sortedX[i], m_sortedY[i], m_sortedZ[i] ), m_sortedValues[i] ) )
+				return false;
+		}
+		return true;
+	}
+
+	for ( keyValue_t* current=m_table[_hash]; current != nullptr; current=current->next ) {
+		if ( !_visitor( current->position, current->value ) )
+			return false;
+	}
+	return true;
+}
+
+template < typename _type_ >
+template< typename V >
+bool	SpatialHashing< _type_ >::VisitCell( int _cellX, int _cellY, int _cellZ, V& _visitor ) const {
+	auto	cellVisitor = [&]( const bfloat3& _position, _type_& _value ) {
+		int	entryCellX, entryCellY, entryCellZ;
+		GetCellIndices( _position, entryCellX, entryCellY, entryCellZ );
+		if ( entryCellX != _cellX || entryCellY != _cellY || entryCellZ != _cellZ )
+			return true;	// Another cell sharing the same hash
+
+		return _visitor( _position, _value );
+	};
+	return VisitHash( ComputeHash( _cellX, _cellY, _cellZ ), cellVisitor );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Sorted mode
+//
+template < typename _type_ >
+void	SpatialHashing< _type_ >::BuildFromArray( U32 _count, const bfloat3* _positions, const _type_* _values ) {
+	// Release the dynamic table
+	ReleaseSortedArrays();
+	SAFE_DELETE_ARRAY( m_nodesPool );
+	SAFE_DELETE_ARRAY( m_table );
+	m_maxEntries = 0;
+	m_freeNode = NULL;
+
+	InitTableSize( _count );
+	const U32	tableSize = U32( m_tableSize );
+
+	m_sorted = true;
+	m_entriesCount = int( _count );
+	m_cellStart = new U32[tableSize+1];
+	m_sortedX = new float[_count];
+	m_sortedY = new float[_count];
+	m_sortedZ = new float[_count];
+	m_sortedValues = new _type_[_count];
+	ResetBounds();
+	if ( _count == 0 ) {
+		memset( m_cellStart, 0, (tableSize+1) * sizeof(U32) );
+		return;
+	}
+
+	ThreadPool&	pool = ThreadPool::Default();
+
+	//////////////////////////////////////////////////////////////////////////
+	// 1] Compute the hash of every entry and the bounds of the positions
+	U32*			hashes = new U32[_count];
+	List< bfloat3 >	threadBounds;
+	threadBounds.SetCount( 2*pool.GetThreadsCount() );
+	for ( U32 threadIndex=0; threadIndex < pool.GetThreadsCount(); threadIndex++ ) {
+		threadBounds[2*threadIndex+0].Set( MAX_FLOAT, MAX_FLOAT, MAX_FLOAT );
+		threadBounds[2*threadIndex+1].Set( -MAX_FLOAT, -MAX_FLOAT, -MAX_FLOAT );
+	}
+	pool.ParallelForRange( _count, 4096, [&]( U32 _start, U32 _end, U32 _threadIndex ) {
+		bfloat3&	boundsMin = threadBounds[2*_threadIndex+0];
+		bfloat3&	boundsMax = threadBounds[2*_threadIndex+1];
+		for ( U32 i=_start; i < _end; i++ ) {
+			hashes[i] = ComputeHash( _positions[i] );
+			boundsMin = boundsMin.Min( _positions[i] );
+			boundsMax = boundsMax.Max( _positions[i] );
+		}
+	} );
+	for ( U32 threadIndex=0; threadIndex < pool.GetThreadsCount(); threadIndex++ ) {
+		GrowBounds( threadBounds[2*threadIndex+0] );
+		GrowBounds( threadBounds[2*threadIndex+1] );
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// 2] Stable counting sort of the entries by hash
+	// The sort is done in 2 passes to keep the histograms small enough to be computed in parallel:
+	//	a) Each chunk of entries is distributed into coarse bins covering contiguous ranges of hashes
+	//	b) Each bin is then sorted independently into its own range of hashes
+	//
+	const U32	binsCount = MIN( 1024U, tableSize );
+	const U32	chunkSize = MAX( 4096U, (_count + 4*pool.GetThreadsCount() - 1) / (4*pool.GetThreadsCount()) );
+	const U32	chunksCount = (_count + chunkSize - 1) / chunkSize;
+	auto		GetBinIndex = [=]( U32 _hash ) { return U32( U64( _hash ) * binsCount / tableSize ); };
+
+	// 2.a) Build the bins histogram of each chunk and turn them into offsets
+	U32*	chunkBinOffsets = new U32[chunksCount * binsCount];
+	pool.ParallelFor( chunksCount, [&]( U32 _chunkIndex, U32 _threadIndex ) {
+		U32*	histogram = &chunkBinOffsets[_chunkIndex * binsCount];
+		memset( histogram, 0, binsCount * sizeof(U32) );
+
+		U32		end = MIN( _count, (_chunkIndex+1) * chunkSize );
+		for ( U32 i=_chunkIndex * chunkSize; i < end; i++ )
+			histogram[GetBinIndex( hashes[i] )]++;
+	} );
+
+	U32*	binStart = new U32[binsCount+1];
+	U32		offset = 0;
+	for ( U32 binIndex=0; binIndex < binsCount; binIndex++ ) {
+		binStart[binIndex] = offset;
+		for ( U32 chunkIndex=0; chunkIndex < chunksCount; chunkIndex++ ) {
+			U32&	chunkOffset = chunkBinOffsets[chunkIndex * binsCount + binIndex];
+			U32		count = chunkOffset;
+			chunkOffset = offset;
+			offset += count;
+		}
+	}
+	binStart[binsCount] = _count;
+
+	U32*	binnedIndices = new U32[_count];
+	pool.ParallelFor( chunksCount, [&]( U32 _chunkIndex, U32 _threadIndex ) {
+		U32*	offsets = &chunkBinOffsets[_chunkIndex * binsCount];
+		U32		end = MIN( _count, (_chunkIndex+1) * chunkSize );
+		for ( U32 i=_chunkIndex * chunkSize; i < end; i++ )
+			binnedIndices[offsets[GetBinIndex( hashes[i] )]++] = i;
+	} );
+
+	// 2.b) Sort each bin into its range of hashes [firstHash,endHash[
+	U32*	sortedIndices = new U32[_count];
+	pool.ParallelFor( binsCount, [&]( U32 _binIndex, U32 _threadIndex ) {
+		U32	firstHash = U32( (U64( _binIndex ) * tableSize + binsCount-1) / binsCount );
+		U32	endHash = U32( (U64( _binIndex+1 ) * tableSize + binsCount-1) / binsCount );
+		U32	binEnd = binStart[_binIndex+1];
+
+		memset( &m_cellStart[firstHash], 0, (endHash - firstHash) * sizeof(U32) );
+		for ( U32 i=binStart[_binIndex]; i < binEnd; i++ )
+			m_cellStart[hashes[binnedIndices[i]]]++;
+
+		U32	hashOffset = binStart[_binIndex];
+		for ( U32 hash=firstHash; hash < endHash; hash++ ) {
+			U32	count = m_cellStart[hash];
+			m_cellStart[hash] = hashOffset;
+			hashOffset += count;
+		}
+
+		// Scatter the entries, each cell start is used as a cursor and ends up at the start of the next hash so we shift them back afterward
+		for ( U32 i=binStart[_binIndex]; i < binEnd; i++ ) {
+			U32	index = binnedIndices[i];
+			sortedIndices[m_cellStart[hashes[index]]++] = index;
+		}
+		for ( U32 hash=endHash-1; hash > firstHash; hash-- )
+			m_cellStart[hash] = m_cellStart[hash-1];
+		m_cellStart[firstHash] = binStart[_binIndex];
+	} );
+	m_cellStart[tableSize] = _count;
+
+	//////////////////////////////////////////////////////////////////////////
+	// 3] Gather the positions and values into the sorted arrays
+	pool.ParallelForRange( _count, 4096, [&]( U32 _start, U32 _end, U32 _threadIndex ) {
+		for ( U32 i=_start; i < _end; i++ ) {
+			U32				index = sortedIndices[i];
+			const bfloat3&	position = _positions[index];
+			m_sortedX[i] = position.x;
+			m_sortedY[i] = position.y;
+			m_sortedZ[i] = position.z;
+			m_sortedValues[i] = _values[index];
+		}
+	} );
+
+	delete[] sortedIndices;
+	delete[] binnedIndices;
+	delete[] binStart;
+	delete[] chunkBinOffsets;
+	delete[] hashes;
+}
+
+template < typename _type_ >
+void	SpatialHashing< _type_ >::Sort() {
+	if ( m_sorted )
+		return;
+
+	// Gather the entries hash by hash
+	U32					count = U32( m_entriesCount );
+	List< bfloat3 >		positions( count );
+	List< _type_ >		values( count );
+	for ( int hash=0; hash < m_tableSize; hash++ ) {
+		for ( keyValue_t* current=m_table[hash]; current != nullptr; current=current->next ) {
+			positions.Append( current->position );
+			values.Append( current->value );
+		}
+	}
+
+	BuildFromArray( count, positions.Ptr(), values.Ptr() );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Batched queries
+//
+template < typename _type_ >
+void	SpatialHashing< _type_ >::FindKNearest( U32 _queriesCount, const bfloat3* _positions, U32 _k, float _maxDistance, List< _type_* >& _neighbors, List< float >* _distances ) const {
+	_neighbors.SetCount( _queriesCount * _k );
+	if ( _distances != NULL )
+		_distances->SetCount( _queriesCount * _k );
+	if ( _k == 0 )
+		return;
+
+	// Entries in the ring of cells at distance R from the query's cell are at least (R-1) cells away from the query
+	const float	minCellSize = m_cellSize.Min();
+	const float	maxDistanceSq = _maxDistance * _maxDistance;
+	const int	maxRing = int( MIN( _maxDistance / minCellSize, 1024.0f ) ) + 1;
+
+	// Only the cells overlapping the bounds of the entries are visited
+	int	minCellX = 0, minCellY = 0, minCellZ = 0;
+	int	maxCellX = 0, maxCellY = 0, maxCellZ = 0;
+	if ( m_entriesCount > 0 ) {
+		GetCellIndices( m_boundsMin, minCellX, minCellY, minCellZ );
+		GetCellIndices( m_boundsMax, maxCellX, maxCellY, maxCellZ );
+	}
+
+	ThreadPool::Default().ParallelForRange( _queriesCount, 64, [&]( U32 _start, U32 _end, U32 _threadIndex ) {
+		List< float >	distancesSq;
+		distancesSq.SetCount( _k );
+		float*			nearestDistancesSq = distancesSq.Ptr();
+
+		for ( U32 queryIndex=_start; queryIndex < _end; queryIndex++ ) {
+			const bfloat3&	position = _positions[queryIndex];
+			_type_**		nearest = _neighbors.Ptr() + queryIndex * _k;
+			U32				nearestCount = 0;
+			for ( U32 i=0; i < _k; i++ ) {
+				nearest[i] = NULL;
+				nearestDistancesSq[i] = MAX_FLOAT;
+			}
+
+			int	X, Y, Z;
+			auto	visitor = [&]( const bfloat3& _entryPosition, _type_& _value ) {
+				float	distanceSq = (_entryPosition - position).LengthSq();
+				if ( distanceSq > maxDistanceSq || distanceSq >= nearestDistancesSq[_k-1] )
+					return true;
+
+				int	entryCellX, entryCellY, entryCellZ;
+				GetCellIndices( _entryPosition, entryCellX, entryCellY, entryCellZ );
+				if ( entryCellX != X || entryCellY != Y || entryCellZ != Z )
+					return true;	// Another cell sharing the same hash
+
+				// Insert into the sorted list of nearest entries
+				U32	insertIndex = MIN( nearestCount, _k-1 );
+				for ( ; insertIndex > 0 && nearestDistancesSq[insertIndex-1] > distanceSq; insertIndex-- ) {
+					nearestDistancesSq[insertIndex] = nearestDistancesSq[insertIndex-1];
+					nearest[insertIndex] = nearest[insertIndex-1];
+				}
+				nearestDistancesSq[insertIndex] = distanceSq;
+				nearest[insertIndex] = &_value;
+				nearestCount = MIN( nearestCount+1, _k );
+				return true;
+			};
+
+			// Visit growing rings of cells around the query's cell until no closer entry can be found
+			// The rings stop growing once they enclose all the occupied cells
+			int	cellX, cellY, cellZ;
+			GetCellIndices( position, cellX, cellY, cellZ );
+			int	occupiedRing = MAX( MAX( MAX( cellX - minCellX, maxCellX - cellX ), MAX( cellY - minCellY, maxCellY - cellY ) ), MAX( cellZ - minCellZ, maxCellZ - cellZ ) );
+			int	lastRing = m_entriesCount > 0 ? MIN( maxRing, occupiedRing ) : -1;
+			for ( int ring=0; ring <= lastRing; ring++ ) {
+				if ( ring > 0 ) {
+					// Stop if the nearest entries are closer than the distance to the boundary of the cells visited so far
+					float	boundaryDistance = MAX_FLOAT;
+					for ( int component=0; component < 3; component++ ) {
+						float	cellSize = m_cellSize[component];
+						int		cell = component == 0 ? cellX : (component == 1 ? cellY : cellZ);
+						boundaryDistance = MIN( boundaryDistance, position[component] - (cell - ring + 1) * cellSize );
+						boundaryDistance = MIN( boundaryDistance, (cell + ring) * cellSize - position[component] );
+					}
+					if ( boundaryDistance > _maxDistance )
+						break;
+					if ( nearestCount == _k && nearestDistancesSq[_k-1] <= SQR( boundaryDistance ) )
+						break;
+				}
+
+				// Cells of the ring that lie outside the occupied bounds are skipped
+				int	endZ = MIN( cellZ + ring, maxCellZ );
+				int	endY = MIN( cellY + ring, maxCellY );
+				int	endX = MIN( cellX + ring, maxCellX );
+				for ( Z=MAX( cellZ - ring, minCellZ ); Z <= endZ; Z++ ) {
+					for ( Y=MAX( cellY - ring, minCellY ); Y <= endY; Y++ ) {
+						bool	isFace = Z == cellZ - ring || Z == cellZ + ring || Y == cellY - ring || Y == cellY + ring;
+						if ( isFace ) {
+							for ( X=MAX( cellX - ring, minCellX ); X <= endX; X++ )
+								VisitHash( ComputeHash( X, Y, Z ), visitor );
+						} else {
+							// Only the 2 extremities of the ring if we're not on a Y or Z face
+							X = cellX - ring;
+							if ( X >= minCellX )
+								VisitHash( ComputeHash( X, Y, Z ), visitor );
+							X = cellX + ring;
+							if ( X <= maxCellX )
+								VisitHash( ComputeHash( X, Y, Z ), visitor );
+						}
+					}
+				}
+			}
+
+			if ( _distances != NULL ) {
+				float*	distances = _distances->Ptr() + queryIndex * _k;
+				for ( U32 i=0; i < _k; i++ )
+					distances[i] = i < nearestCount ? sqrtf( nearestDistancesSq[i] ) : MAX_FLOAT;
+			}
+		}
+	} );
+}
+
+template < typename _type_ >
+void	SpatialHashing< _type_ >::FindAllInRadius( U32 _queriesCount, const bfloat3* _positions, float _radius, List< U32 >& _resultOffsets, List< _type_* >& _results ) const {
+	const U32	QUERIES_PER_CHUNK = 64;
+	const U32	chunksCount = (_queriesCount + QUERIES_PER_CHUNK - 1) / QUERIES_PER_CHUNK;
+	const float	radiusSq = _radius * _radius;
+
+	// Each chunk of queries accumulates its results separately, the offsets are first relative to the chunk's results
+	List< List< _type_* > >	chunkResults;
+	chunkResults.SetCount( chunksCount );
+	_resultOffsets.SetCount( _queriesCount+1 );
+
+	ThreadPool&	pool = ThreadPool::Default();
+	pool.ParallelForRange( _queriesCount, QUERIES_PER_CHUNK, [&]( U32 _start, U32 _end, U32 _threadIndex ) {
+		List< _type_* >&	results = chunkResults[_start / QUERIES_PER_CHUNK];
+		for ( U32 queryIndex=_start; queryIndex < _end; queryIndex++ ) {
+			const bfloat3&	position = _positions[queryIndex];
+			_resultOffsets[queryIndex] = results.Count();
+
+			int	X, Y, Z;
+			auto	visitor = [&]( const bfloat3& _entryPosition, _type_& _value ) {
+				if ( (_entryPosition - position).LengthSq() > radiusSq )
+					return true;
+
+				int	entryCellX, entryCellY, entryCellZ;
+				GetCellIndices( _entryPosition, entryCellX, entryCellY, entryCellZ );
+				if ( entryCellX == X && entryCellY == Y && entryCellZ == Z )
+					results.Append( &_value );
+				return true;
+			};
+
+			int	minCellX, minCellY, minCellZ;
+			GetCellIndices( position - _radius*bfloat3::One, minCellX, minCellY, minCellZ );
+			int	maxCellX, maxCellY, maxCellZ;
+			GetCellIndices( position + _radius*bfloat3::One, maxCellX, maxCellY, maxCellZ );
+			for ( Z=minCellZ; Z <= maxCellZ; Z++ ) {
+				for ( Y=minCellY; Y <= maxCellY; Y++ ) {
+					for ( X=minCellX; X <= maxCellX; X++ ) {
+						VisitHash( ComputeHash( X, Y, Z ), visitor );
+					}
+				}
+			}
+		}
+	} );
+
+	// Concatenate the results of all the chunks
+	List< U32 >	chunkStart;
+	chunkStart.SetCount( chunksCount );
+	U32	resultsCount = 0;
+	for ( U32 chunkIndex=0; chunkIndex < chunksCount; chunkIndex++ ) {
+		chunkStart[chunkIndex] = resultsCount;
+		resultsCount += chunkResults[chunkIndex].Count();
+	}
+	_results.SetCount( resultsCount );
+	_resultOffsets[_queriesCount] = resultsCount;
+
+	pool.ParallelFor( chunksCount, [&]( U32 _chunkIndex, U32 _threadIndex ) {
+		const List< _type_* >&	results = chunkResults[_chunkIndex];
+		U32	start = chunkStart[_chunkIndex];
+		U32	end = MIN( _queriesCount, (_chunkIndex+1) * QUERIES_PER_CHUNK );
+		for ( U32 queryIndex=_chunkIndex * QUERIES_PER_CHUNK; queryIndex < end; queryIndex++ )
+			_resultOffsets[queryIndex] += start;
+		if ( results.Count() > 0 )
+			memcpy( _results.Ptr() + start, results.Ptr(), results.Count() * sizeof(_type_*) );
+	} );
+}
+
+}	// namespace BaseLib
\ No newline at end of file
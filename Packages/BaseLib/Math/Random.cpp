@@ -1,44 +1,34 @@
 #include "stdafx.h"
+#include "SIMD.h"
 
-// These values are not magical, just the default values Marsaglia used.
-// Any pair of unsigned integers should be fine.
-static U32	gs_w = RAND_DEFAULT_SEED_U;
-static U32	gs_z = RAND_DEFAULT_SEED_V;
-
-static U32	gs_SeedPushW = 0;
-static U32	gs_SeedPushZ = 0;
+// The global generator is a shared legacy MWC stream, constant-initialized so _rand() can be used during the dynamic initialization of other globals
+// Its default seeds are not magical, just the default values Marsaglia used. Any pair of unsigned integers should be fine.
+// See http://www.bobwheeler.com/statistics/Password/MarsagliaPost.txt
+static BaseLib::LegacyRandomStream	gs_Random;
+static BaseLib::LegacyRandomStream	gs_SeedPush;
 
 void	_randpushseed()
 {
-	gs_SeedPushW = gs_w;
-	gs_SeedPushZ = gs_z;
+	gs_SeedPush = gs_Random;
 }
 void	_randpopseed()
 {
-	gs_w = gs_SeedPushW;
-	gs_z = gs_SeedPushZ;
+	gs_Random = gs_SeedPush;
 }
 
-// This is the heart of the generator.
-// It uses George Marsaglia's MWC algorithm to produce an unsigned integer.
-// See http://www.bobwheeler.com/statistics/Password/MarsagliaPost.txt
 U32	_rand()
 {
-	gs_z = 36969 * (gs_z & 0xFFFF) + (gs_z >> 16);
-	gs_w = 18000 * (gs_w & 0xFFFF) + (gs_w >> 16);
-	return (gs_z << 16) + gs_w;
+	return gs_Random.NextU32();
 }
 
 U32	_rand( U32 min, U32 max )
 {
-	U32	D = 1+max-min;
-	U32	v = _rand() % D;
-	return min + v;
+	return gs_Random.NextU32( min, max );
 }
 
 U32	_rand( U32 size )
 {
-	return _rand() % size;
+	return gs_Random.NextU32( size );
 }
 
 // The random generator seed can be set three ways:
@@ -47,40 +37,151 @@ U32	_rand( U32 size )
 // 3) setting the seed from the system time
 void	_srand( U32 u, U32 v )
 {
-	if (u != 0) gs_w = u;
-	if (v != 0) gs_z = v;
+	gs_Random.SetSeed( u, v );
 }
 
 float	_frand()
 {
-	U32 u = _rand();
-	return u / (4294967295.0f);	// Denominator = 2^32-1
+	return gs_Random.NextFloat();
 }
 
 float	_frand( float min, float max )
 {
-	return min + (max-min) * _frand();
+	return gs_Random.NextFloat( min, max );
 }
 
 // Produce a uniform random sample from the open interval ]0, 1[.
 // The method will not return either end point.
 float	_frandStrict()
 {
-	// 0 <= u < 2^32
-	U32 u = _rand();
-
-	// The magic number below is 1/(2^32 + 2).
-	// The result is strictly between 0 and 1.
-	return float( (u + 1.0) * 2.328306435454494e-10 );
+	return gs_Random.NextFloatStrict();
 }
 
 // Get normal (Gaussian) random sample with mean 0 and standard deviation 1
 float	_randGauss()
 {
-	// Use Box-Muller algorithm
-	float	u1 = _frand();
-	float	u2 = _frand();
-	float	r = sqrtf( -2.0f * logf(u1) );
-	float	theta = 2.0f * PI * u2;
-	return r * sinf(theta);
+	return gs_Random.NextGauss();
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// RandomStream bulk generation
+//
+using namespace BaseLib;
+
+// Hashes 4 counters at once, same as RandomStream::Mix32()
+static inline __m128i	Mix32x4( __m128i _x )
+{
+	_x = _mm_xor_si128( _x, _mm_srli_epi32( _x, 16 ) );
+	_x = SIMD::MulLo32( _x, _mm_set1_epi32( 0x7FEB352D ) );
+	_x = _mm_xor_si128( _x, _mm_srli_epi32( _x, 15 ) );
+	_x = SIMD::MulLo32( _x, _mm_set1_epi32( 0x846CA68B ) );
+	return _mm_xor_si128( _x, _mm_srli_epi32( _x, 16 ) );
+}
+
+// Converts 4 draws into floats in [0,1[ (or ]0,1[ when _strict is true)
+static inline __m128	ToUniform( __m128i _u, bool _strict )
+{
+	__m128	v = _mm_cvtepi32_ps( _mm_srli_epi32( _u, 8 ) );	// 24 bits, exact
+	if ( _strict )
+		v = _mm_add_ps( v, _mm_set1_ps( 0.5f ) );
+	return _mm_mul_ps( v, _mm_set1_ps( 1.0f / 16777216.0f ) );
+}
+
+void	RandomStream::FillU32( U32 _count, U32* _values )
+{
+	while ( _count > 0 )
+	{
+		// Never let the counter wrap inside a chunk since the keys change when it does
+		U32	available = DrawsBeforeWrap();
+		U32	count = available == 0 || available > _count ? _count : available;
+
+		const __m128i	key0 = _mm_set1_epi32( m_key0 );
+		const __m128i	key1 = _mm_set1_epi32( m_key1 );
+		__m128i			counters = _mm_add_epi32( _mm_set1_epi32( m_counter ), _mm_setr_epi32( 0, 1, 2, 3 ) );
+		U32				i = 0;
+		for ( ; i+4 <= count; i+=4 )
+		{
+			_mm_storeu_si128( (__m128i*) (_values + i), Mix32x4( _mm_xor_si128( Mix32x4( _mm_add_epi32( counters, key0 ) ), key1 ) ) );
+			counters = _mm_add_epi32( counters, _mm_set1_epi32( 4 ) );
+		}
+		for ( ; i < count; i++ )
+			_values[i] = Hash( m_counter + i );
+
+		Skip( count );
+		_values += count;
+		_count -= count;
+	}
+}
+
+void	RandomStream::FillUniform( U32 _count, float* _values )
+{
+	// Generate the draws in place then convert them
+	FillU32( _count, (U32*) _values );
+
+	U32	i = 0;
+	for ( ; i+4 <= _count; i+=4 )
+		_mm_storeu_ps( _values + i, ToUniform( _mm_loadu_si128( (__m128i*) (_values + i) ), false ) );
+	for ( ; i < _count; i++ )
+		_values[i] = (((U32*) _values)[i] >> 8) * (1.0f / 16777216.0f);
+}
+
+void	RandomStream::FillGauss( U32 _count, float* _values )
+{
+	// Each block of 8 draws gives 4 radii and 4 angles, and the Box-Muller transform yields 2 independent values per radius/angle pair
+	U32	draws[256];
+	while ( _count > 0 )
+	{
+		U32	count = MIN( _count, 256U );
+		U32	drawsCount = (count + 7) & ~7U;
+		FillU32( drawsCount, draws );
+
+		for ( U32 i=0; i < count; i+=8 )
+		{
+			__m128	u1 = ToUniform( _mm_loadu_si128( (__m128i*) (draws + i) ), true );
+			__m128	u2 = ToUniform( _mm_loadu_si128( (__m128i*) (draws + i + 4) ), false );
+			__m128	r = _mm_sqrt_ps( _mm_mul_ps( SIMD::Log2( u1 ), _mm_set1_ps( -2.0f * 0.69314718f ) ) );	// sqrt( -2 ln(u1) )
+			__m128	s, c;
+			SIMD::SinCos2PI( u2, s, c );
+
+			float	results[8];
+			_mm_storeu_ps( results, _mm_mul_ps( r, s ) );
+			_mm_storeu_ps( results + 4, _mm_mul_ps( r, c ) );
+			memcpy( _values + i, results, MIN( 8U, count - i ) * sizeof(float) );
+		}
+
+		_values += count;
+		_count -= count;
+	}
+}
+
+void	RandomStream::FillUnitSphere( U32 _count, bfloat3* _directions )
+{
+	// Each block of 8 draws gives 4 heights and 4 azimuths
+	U32	draws[256];
+	while ( _count > 0 )
+	{
+		U32	count = MIN( _count, 128U );
+		U32	drawsCount = (2 * count + 7) & ~7U;
+		FillU32( drawsCount, draws );
+
+		for ( U32 i=0; i < count; i+=4 )
+		{
+			__m128	z = _mm_sub_ps( _mm_set1_ps( 1.0f ), _mm_mul_ps( _mm_set1_ps( 2.0f ), ToUniform( _mm_loadu_si128( (__m128i*) (draws + 2*i) ), false ) ) );
+			__m128	r = _mm_sqrt_ps( _mm_max_ps( _mm_setzero_ps(), _mm_sub_ps( _mm_set1_ps( 1.0f ), _mm_mul_ps( z, z ) ) ) );
+			__m128	s, c;
+			SIMD::SinCos2PI( ToUniform( _mm_loadu_si128( (__m128i*) (draws + 2*i + 4) ), false ), s, c );
+
+			float	x[4], y[4], zs[4];
+			_mm_storeu_ps( x, _mm_mul_ps( r, c ) );
+			_mm_storeu_ps( y, _mm_mul_ps( r, s ) );
+			_mm_storeu_ps( zs, z );
+			U32	lanesCount = MIN( 4U, count - i );
+			for ( U32 lane=0; lane < lanesCount; lane++ )
+				_directions[i+lane].Set( x[lane], y[lane], zs[lane] );
+		}
+
+		_directions += count;
+		_count -= count;
+	}
 }
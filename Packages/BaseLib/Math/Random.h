@@ -26,6 +26,174 @@ U32		_rand( U32 size );				// [0,size[
 float	_randGauss();
 
 
+//////////////////////////////////////////////////////////////////////////
+// Random streams
+// The global _rand() functions above share a single LegacyRandomStream and are kept for the existing code, they produce the exact same sequences as before.
+// Code that needs those sequences without sharing the global state can use its own LegacyRandomStream instance.
+// New code should rather use a RandomStream instance, which is cheap to copy and can be split deterministically per thread, task or pixel.
+//
+// The generator is counter-based: the i-th draw of a stream is a hash of i and the 64-bits stream key so draws
+//	can be skipped in O(1) and generated 4 at a time in SSE registers.
+// The hash is 2 rounds of the "lowbias32" integer mixer (https://nullprogram.com/blog/2018/07/31/) keyed by the 2 halves of the stream key.
+// When the 32-bits counter wraps around, the stream rekeys itself so the period is not limited to 2^32 draws.
+//
+namespace BaseLib {
+	class	RandomStream {
+	public:
+		RandomStream( U64 _seed=0 ) { SetSeed( _seed, 0 ); }
+		RandomStream( U64 _seed, U64 _streamIndex ) { SetSeed( _seed, _streamIndex ); }
+
+		// Initializes the stream from a seed and a stream index, different indices yield independent streams for the same seed
+		void			SetSeed( U64 _seed, U64 _streamIndex ) {
+			U64	key = SplitMix64( SplitMix64( _seed ) + _streamIndex );
+			m_key0 = U32( key );
+			m_key1 = U32( key >> 32 );
+			m_counter = 0;
+		}
+
+		// Creates a child stream. The child only depends on this stream's key and the index, not on how many values were drawn,
+		//	so splitting by thread/task/pixel index gives the same results whatever the scheduling
+		RandomStream	Split( U64 _index ) const {
+			return RandomStream( (U64(m_key1) << 32) | m_key0, _index );
+		}
+
+		// Skips the next _count draws
+		void			Skip( U32 _count ) {
+			U32	counter = m_counter + _count;
+			if ( counter < m_counter )
+				NextEpoch();
+			m_counter = counter;
+		}
+
+		U32				NextU32() {								// [0,2^32[
+			U32	value = Hash( m_counter );
+			if ( ++m_counter == 0 )
+				NextEpoch();
+			return value;
+		}
+		U32				NextU32( U32 _size ) {					// [0,size[ (multiply-shift range reduction, no modulo)
+			return U32( (U64( NextU32() ) * _size) >> 32 );
+		}
+		U32				NextU32( U32 _min, U32 _max ) {			// [min,max]
+			U32	size = 1+_max-_min;
+			return size != 0 ? _min + NextU32( size ) : NextU32();	// The size wraps to 0 for the full [0,2^32[ range
+		}
+		float			NextFloat() {							// [0,1[
+			return (NextU32() >> 8) * (1.0f / 16777216.0f);
+		}
+		float			NextFloat( float _min, float _max ) {	// [min,max[
+			return _min + (_max-_min) * NextFloat();
+		}
+		float			NextFloatStrict() {						// ]0,1[
+			return ((NextU32() >> 8) + 0.5f) * (1.0f / 16777216.0f);
+		}
+
+		// Normal distribution with mean 0 and standard deviation 1 (Box-Muller, uses 2 draws)
+		float			NextGauss() {
+			float	r = sqrtf( -2.0f * logf( NextFloatStrict() ) );
+			float	theta = 2.0f * PI * NextFloat();
+			return r * sinf( theta );
+		}
+
+		// Uniformly distributed direction on the unit sphere (uses 2 draws)
+		bfloat3			NextUnitSphere() {
+			float	z = 1.0f - 2.0f * NextFloat();
+			float	phi = 2.0f * PI * NextFloat();
+			float	r = sqrtf( MAX( 0.0f, 1.0f - z*z ) );
+			return bfloat3( r * cosf( phi ), r * sinf( phi ), z );
+		}
+
+		// Bulk generation using SSE2
+		//	FillU32() and FillUniform() produce the same values as the same amount of calls to NextU32() and NextFloat()
+		//	FillGauss() and FillUnitSphere() consume one draw per scalar value (i.e. 2 per direction) rounded up to a multiple of 8,
+		//		they are statistically equivalent but not bit-exact with NextGauss() and NextUnitSphere()
+		void			FillU32( U32 _count, U32* _values );
+		void			FillUniform( U32 _count, float* _values );
+		void			FillGauss( U32 _count, float* _values );
+		void			FillUnitSphere( U32 _count, bfloat3* _directions );
+
+		// The 32-bits integer hash used by the streams, also handy to derive seeds from pixel coordinates or dimension indices
+		static U32		Mix32( U32 _x ) {
+			_x ^= _x >> 16;
+			_x *= 0x7FEB352DU;
+			_x ^= _x >> 15;
+			_x *= 0x846CA68BU;
+			return _x ^ (_x >> 16);
+		}
+
+	private:
+		static U64		SplitMix64( U64 _x ) {
+			_x += 0x9E3779B97F4A7C15ULL;
+			_x = (_x ^ (_x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+			_x = (_x ^ (_x >> 27)) * 0x94D049BB133111EBULL;
+			return _x ^ (_x >> 31);
+		}
+		U32				Hash( U32 _counter ) const	{ return Mix32( Mix32( _counter + m_key0 ) ^ m_key1 ); }
+		void			NextEpoch() {
+			U64	key = SplitMix64( (U64(m_key1) << 32) | m_key0 );
+			m_key0 = U32( key );
+			m_key1 = U32( key >> 32 );
+		}
+		// Returns the amount of draws available before the counter wraps around (0 means 2^32)
+		U32				DrawsBeforeWrap() const		{ return 0U - m_counter; }
+
+	private:
+		U32		m_key0;
+		U32		m_key1;
+		U32		m_counter;
+	};
+
+	// Marsaglia's MWC generator, exactly as used by the global _rand() functions (which are implemented with a shared instance)
+	// The draws follow the legacy conventions: modulo range reduction and NextFloat() in [0,1]
+	class	LegacyRandomStream {
+	public:
+		// constexpr so the global instances are constant-initialized and can be used by other static initializers
+		constexpr LegacyRandomStream( U32 _u=RAND_DEFAULT_SEED_U, U32 _v=RAND_DEFAULT_SEED_V ) : m_w( _u != 0 ? _u : RAND_DEFAULT_SEED_U ), m_z( _v != 0 ? _v : RAND_DEFAULT_SEED_V ) {}
+
+		// Same as _srand(): a zero value keeps the current part of the seed
+		void			SetSeed( U32 _u, U32 _v ) {
+			if ( _u != 0 ) m_w = _u;
+			if ( _v != 0 ) m_z = _v;
+		}
+
+		U32				NextU32() {								// [0,2^32[
+			m_z = 36969 * (m_z & 0xFFFF) + (m_z >> 16);
+			m_w = 18000 * (m_w & 0xFFFF) + (m_w >> 16);
+			return (m_z << 16) + m_w;
+		}
+		U32				NextU32( U32 _size ) {					// [0,size[
+			return NextU32() % _size;
+		}
+		U32				NextU32( U32 _min, U32 _max ) {			// [min,max]
+			U32	size = 1+_max-_min;
+			return size != 0 ? _min + NextU32() % size : NextU32();	// The size wraps to 0 for the full [0,2^32[ range
+		}
+		float			NextFloat() {							// [0,1]
+			return NextU32() / 4294967295.0f;	// Denominator = 2^32-1
+		}
+		float			NextFloat( float _min, float _max ) {	// [min,max]
+			return _min + (_max-_min) * NextFloat();
+		}
+		float			NextFloatStrict() {						// ]0,1[
+			return float( (NextU32() + 1.0) * 2.328306435454494e-10 );	// The magic number is 1/(2^32 + 2)
+		}
+
+		// Normal distribution with mean 0 and standard deviation 1 (Box-Muller, uses 2 draws)
+		float			NextGauss() {
+			float	u1 = NextFloat();
+			float	u2 = NextFloat();
+			float	r = sqrtf( -2.0f * logf( u1 ) );
+			float	theta = 2.0f * PI * u2;
+			return r * sinf( theta );
+		}
+
+	private:
+		U32		m_w;
+		U32		m_z;
+	};
+}
+
+
 //////////////////////////////////////////////////////////////////////////
 // bmayaux (2015-02-24) Hammersley sequence generator
 //
@@ -1,4 +1,8 @@
 ﻿#include "stdafx.h"
+#include "SIMD.h"
+#include "../Utility/ThreadPool.h"
+
+using namespace BaseLib;
 
 double	SH::FACTORIAL[] = {	1.0,
 							1.0,
@@ -49,10 +53,12 @@ double	SH::ComputeSHCoeff( int l, int m, double _θ, double _ϕ )
 
 	if ( m == 0 )
 		return	K( l, m ) * P( l, m, cos( _θ ) );
-	else if ( m > 0 )
-		return powf( -1.0f, float(m) ) * SQRT2 * K( l, m ) * cos( m * _ϕ ) * P( l, m, cos( _θ ) );
+
+	double	Sign = (m & 1) ? -1.0 : 1.0;	// (-1)^m
+	if ( m > 0 )
+		return Sign * SQRT2 * K( l, m ) * cos( m * _ϕ ) * P( l, m, cos( _θ ) );
 	else
-		return powf( -1.0f, float(m) ) * SQRT2 * K( l, -m ) * sin( -m * _ϕ ) * P( l, -m, cos( _θ ) );
+		return Sign * SQRT2 * K( l, -m ) * sin( -m * _ϕ ) * P( l, -m, cos( _θ ) );
 }
 
 // Computes a SH windowed with a cardinal sine function
@@ -87,14 +93,236 @@ double	SH::ComputeSHCoeff( int l, int m, const bfloat3& _Direction )
 // True computation of coefficients
 void	SH::BuildSHCoeffs( const bfloat3& _Direction, double _Coeffs[9] )
 {
-	// Convert from cartesian to polar coords
-	double	θ, ϕ;
-	CartesianToSpherical( _Direction, θ, ϕ );
+	BuildSHCoeffs( _Direction, 2, _Coeffs );
+}
 
-	int	CoeffIndex = 0;
-	for ( int l=0; l < 3; l++ )
-		for ( int m=-l; m <= l; m++ )
-			_Coeffs[CoeffIndex++] = ComputeSHCoeff( l, m, θ, ϕ );
+// Builds the (_Order+1)² SH coefficients for the specified direction using the cartesian recurrences
+//	_ The associated Legendre polynomials are normalized along the recurrence so they remain stable for large orders
+//	_ sinθ^m cos(mϕ) and sinθ^m sin(mϕ) are the real and imaginary parts of (x + i y)^m so no trigonometric function is ever called
+//
+// NOTE ==> The (x,y,z) direction must be normalized!!
+//
+template<typename T> static void	BuildSHCoeffsRecurrence( T x, T y, T z, int _Order, T* _Coeffs )
+{
+	T		C = T(1);			// sinθ^m cos(mϕ)
+	T		S = T(0);			// sinθ^m sin(mϕ)
+	double	Pmm = 0.28209479177387814347403972578039;	// K(m,m) P(m,m) / sinθ^m, starting with 1/sqrt(4PI)
+	for ( int m=0; m <= _Order; m++ )
+	{
+		T	ScaleCos = T(1);
+		T	ScaleSin = T(0);
+		if ( m > 0 )
+		{
+			T	Temp = x * C - y * S;
+			S = x * S + y * C;
+			C = Temp;
+			Pmm *= sqrt( (2.0 * m + 1.0) / (2.0 * m) );
+			ScaleCos = T(1.4142135623730950488016887242097) * C;
+			ScaleSin = T(1.4142135623730950488016887242097) * S;
+		}
+
+		T	Pl_2 = T(0);
+		T	Pl_1 = T(Pmm);
+		for ( int l=m; l <= _Order; l++ )
+		{
+			T	Pl = Pl_1;
+			if ( l > m )
+			{
+				double	a = sqrt( (4.0 * l * l - 1.0) / (l * l - m * m) );
+				double	b = sqrt( ((l - 1.0) * (l - 1.0) - m * m) / (4.0 * (l - 1.0) * (l - 1.0) - 1.0) );
+				Pl = T(a) * (z * Pl_1 - T(b) * Pl_2);
+				Pl_2 = Pl_1;
+				Pl_1 = Pl;
+			}
+
+			int	Offset = l*(l+1);
+			_Coeffs[Offset+m] = ScaleCos * Pl;
+			if ( m > 0 )
+				_Coeffs[Offset-m] = ScaleSin * Pl;
+		}
+	}
+}
+
+void	SH::BuildSHCoeffs( const bfloat3& _Direction, U32 _Order, double* _Coeffs )
+{
+	BuildSHCoeffsRecurrence( double(_Direction.x), double(_Direction.y), double(_Direction.z), int(_Order), _Coeffs );
+}
+
+void	SH::BuildSHCoeffs( const bfloat3& _Direction, U32 _Order, float* _Coeffs )
+{
+	BuildSHCoeffsRecurrence( _Direction.x, _Direction.y, _Direction.z, int(_Order), _Coeffs );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Batched projection
+//
+// The directions are evaluated 4 at a time with the same recurrences as BuildSHCoeffs(), with the direction-independent terms precomputed once per projection
+//
+class	SHRecurrenceTables
+{
+public:
+	U32		m_Order;
+	U32		m_CoeffsCount;
+	float*	m_Pmm;		// K(m,m) P(m,m) / sinθ^m for each m
+	float*	m_A;		// Recurrence factors, indexed like the coefficients with m >= 0
+	float*	m_B;
+
+	SHRecurrenceTables( U32 _Order ) : m_Order( _Order ), m_CoeffsCount( (_Order+1) * (_Order+1) )
+	{
+		m_Pmm = new float[_Order+1];
+		m_A = new float[m_CoeffsCount];
+		m_B = new float[m_CoeffsCount];
+
+		double	Pmm = 0.28209479177387814347403972578039;
+		for ( int m=0; m <= int(_Order); m++ )
+		{
+			if ( m > 0 )
+				Pmm *= sqrt( (2.0 * m + 1.0) / (2.0 * m) );
+			m_Pmm[m] = float( Pmm );
+
+			for ( int l=m+1; l <= int(_Order); l++ )
+			{
+				m_A[l*(l+1)+m] = float( sqrt( (4.0 * l * l - 1.0) / (l * l - m * m) ) );
+				m_B[l*(l+1)+m] = float( sqrt( ((l - 1.0) * (l - 1.0) - m * m) / (4.0 * (l - 1.0) * (l - 1.0) - 1.0) ) );
+			}
+		}
+	}
+	~SHRecurrenceTables()
+	{
+		delete[] m_Pmm;
+		delete[] m_A;
+		delete[] m_B;
+	}
+
+	// Evaluates the coefficients of 4 directions, _Coeffs receives 4 lanes per coefficient
+	void	Evaluate( __m128 _x, __m128 _y, __m128 _z, float* _Coeffs ) const
+	{
+		const __m128	Sqrt2 = _mm_set1_ps( 1.4142135623730950488016887242097f );
+
+		__m128	C = _mm_set1_ps( 1.0f );
+		__m128	S = _mm_setzero_ps();
+		for ( int m=0; m <= int(m_Order); m++ )
+		{
+			__m128	ScaleCos = C;
+			__m128	ScaleSin = S;
+			if ( m > 0 )
+			{
+				__m128	Temp = _mm_sub_ps( _mm_mul_ps( _x, C ), _mm_mul_ps( _y, S ) );
+				S = _mm_add_ps( _mm_mul_ps( _x, S ), _mm_mul_ps( _y, C ) );
+				C = Temp;
+				ScaleCos = _mm_mul_ps( Sqrt2, C );
+				ScaleSin = _mm_mul_ps( Sqrt2, S );
+			}
+
+			__m128	Pl_2 = _mm_setzero_ps();
+			__m128	Pl_1 = _mm_set1_ps( m_Pmm[m] );
+			for ( int l=m; l <= int(m_Order); l++ )
+			{
+				int		Offset = l*(l+1);
+				__m128	Pl = Pl_1;
+				if ( l > m )
+				{
+					Pl = _mm_mul_ps( _mm_set1_ps( m_A[Offset+m] ), _mm_sub_ps( _mm_mul_ps( _z, Pl_1 ), _mm_mul_ps( _mm_set1_ps( m_B[Offset+m] ), Pl_2 ) ) );
+					Pl_2 = Pl_1;
+					Pl_1 = Pl;
+				}
+
+				_mm_storeu_ps( _Coeffs + 4*(Offset+m), _mm_mul_ps( ScaleCos, Pl ) );
+				if ( m > 0 )
+					_mm_storeu_ps( _Coeffs + 4*(Offset-m), _mm_mul_ps( ScaleSin, Pl ) );
+			}
+		}
+	}
+};
+
+// Projects weighted directions whose weights have _ChannelsCount interleaved channels
+//	_Coeffs receives the _ChannelsCount interleaved channels of each coefficient
+static void	ProjectDirections( const bfloat3* _Directions, const float* _Weights, U32 _ChannelsCount, U32 _Count, U32 _Order, float* _Coeffs )
+{
+	const SHRecurrenceTables	Tables( _Order );
+	const U32					SumsCount = Tables.m_CoeffsCount * _ChannelsCount;
+
+	ThreadPool&	Pool = ThreadPool::Default();
+	U32			ThreadsCount = Pool.GetThreadsCount();
+	double*		ThreadSums = new double[ThreadsCount * SumsCount];
+	memset( ThreadSums, 0, ThreadsCount * SumsCount * sizeof(double) );
+
+	// Each thread also gets its own buffers for the coefficients of its 4 directions and for the float sums (4 lanes per sum)
+	U32			ThreadBufferSize = 4 * (Tables.m_CoeffsCount + SumsCount);
+	float*		ThreadBuffers = new float[ThreadsCount * ThreadBufferSize];
+
+	U32	GroupsCount = (_Count + 3) >> 2;
+	Pool.ParallelForRange( GroupsCount, MAX( 1U, GroupsCount / (4 * ThreadsCount) ), [&]( U32 _StartGroup, U32 _EndGroup, U32 _ThreadIndex )
+	{
+		float*	Y = ThreadBuffers + _ThreadIndex * ThreadBufferSize;
+		float*	Sums = Y + 4 * Tables.m_CoeffsCount;
+		double*	TargetSums = ThreadSums + _ThreadIndex * SumsCount;
+
+		for ( U32 BatchStart=_StartGroup; BatchStart < _EndGroup; BatchStart+=256 )
+		{
+			// Accumulate batches of 256 groups in float, then flush them to the double sums
+			memset( Sums, 0, 4 * SumsCount * sizeof(float) );
+			U32	BatchEnd = MIN( BatchStart + 256, _EndGroup );
+			for ( U32 GroupIndex=BatchStart; GroupIndex < BatchEnd; GroupIndex++ )
+			{
+				// Gather the 4 directions, missing directions at the end get a 0 weight
+				float	x[4], y[4], z[4], w[4*3];
+				for ( U32 Lane=0; Lane < 4; Lane++ )
+				{
+					U32	Index = 4 * GroupIndex + Lane;
+					if ( Index < _Count )
+					{
+						x[Lane] = _Directions[Index].x;
+						y[Lane] = _Directions[Index].y;
+						z[Lane] = _Directions[Index].z;
+						for ( U32 Channel=0; Channel < _ChannelsCount; Channel++ )
+							w[4*Channel+Lane] = _Weights[_ChannelsCount*Index+Channel];
+					}
+					else
+					{
+						x[Lane] = y[Lane] = 0.0f;
+						z[Lane] = 1.0f;
+						for ( U32 Channel=0; Channel < _ChannelsCount; Channel++ )
+							w[4*Channel+Lane] = 0.0f;
+					}
+				}
+
+				Tables.Evaluate( _mm_loadu_ps( x ), _mm_loadu_ps( y ), _mm_loadu_ps( z ), Y );
+
+				for ( U32 Channel=0; Channel < _ChannelsCount; Channel++ )
+				{
+					__m128	Weight = _mm_loadu_ps( w + 4*Channel );
+					float*	ChannelSums = Sums + 4*Channel;
+					for ( U32 CoeffIndex=0; CoeffIndex < Tables.m_CoeffsCount; CoeffIndex++, ChannelSums+=4*_ChannelsCount )
+						_mm_storeu_ps( ChannelSums, _mm_add_ps( _mm_loadu_ps( ChannelSums ), _mm_mul_ps( _mm_loadu_ps( Y + 4*CoeffIndex ), Weight ) ) );
+				}
+			}
+
+			for ( U32 SumIndex=0; SumIndex < SumsCount; SumIndex++ )
+				TargetSums[SumIndex] += double(Sums[4*SumIndex+0]) + double(Sums[4*SumIndex+1]) + double(Sums[4*SumIndex+2]) + double(Sums[4*SumIndex+3]);
+		}
+	} );
+	delete[] ThreadBuffers;
+
+	for ( U32 SumIndex=0; SumIndex < SumsCount; SumIndex++ )
+	{
+		double	Sum = 0.0;
+		for ( U32 ThreadIndex=0; ThreadIndex < ThreadsCount; ThreadIndex++ )
+			Sum += ThreadSums[ThreadIndex * SumsCount + SumIndex];
+		_Coeffs[SumIndex] = float( Sum );
+	}
+
+	delete[] ThreadSums;
+}
+
+void	SH::Project( const bfloat3* _Directions, const float* _Weights, U32 _Count, U32 _Order, float* _Coeffs )
+{
+	ProjectDirections( _Directions, _Weights, 1, _Count, _Order, _Coeffs );
+}
+
+void	SH::Project( const bfloat3* _Directions, const bfloat3* _Values, U32 _Count, U32 _Order, bfloat3* _Coeffs )
+{
+	ProjectDirections( _Directions, &_Values[0].x, 3, _Count, _Order, &_Coeffs[0].x );
 }
 
 
@@ -713,3 +941,577 @@ double		SH::Factorial( int _Value )
 {
 	return	FACTORIAL[_Value];
 }
+
+//////////////////////////////////////////////////////////////////////////
+// SH Rotation
+//
+SHRotation::SHRotation( U32 _Order )
+	: m_Order( _Order )
+{
+	U32	MatricesSize = (_Order+1) * (2*_Order+1) * (2*_Order+3) / 3;	// Sum of (2l+1)² for l in [0,Order]
+	m_Matrices = new float[MatricesSize];
+	m_Scratch = new double[2 * (2*_Order+1) * (2*_Order+1)];
+
+	Build( float3x3::Identity );
+}
+
+SHRotation::~SHRotation()
+{
+	delete[] m_Scratch;
+	delete[] m_Matrices;
+}
+
+void	SHRotation::Build( const float3x3& _Rotation )
+{
+	// Band 0 is invariant
+	m_Matrices[0] = 1.0f;
+	if ( m_Order == 0 )
+		return;
+
+	// Band 1 basis functions are proportional to (y,z,x) so its matrix is a permutation of the transposed rotation
+	//	R1[m][m'] with m and m' in [-1,+1] (i.e. rows and columns ordered as y, z, x)
+	static const int	AXES[3] = { 1, 2, 0 };
+	double	R1[3][3];
+	for ( int i=0; i < 3; i++ )
+		for ( int j=0; j < 3; j++ )
+			R1[i][j] = (&_Rotation.r[AXES[j]].x)[AXES[i]];
+
+	double*	Previous = m_Scratch;
+	double*	Current = m_Scratch + (2*m_Order+1) * (2*m_Order+1);
+	for ( int i=0; i < 3; i++ )
+		for ( int j=0; j < 3; j++ )
+			Previous[3*i+j] = R1[i][j];
+
+	float*	Band1 = m_Matrices + 1;
+	for ( int i=0; i < 9; i++ )
+		Band1[i] = float( Previous[i] );
+
+	// Higher bands are built from the previous band and band 1
+	for ( int l=2; l <= int(m_Order); l++ )
+	{
+		int	PreviousSize = 2*l-1;
+		int	Size = 2*l+1;
+
+		// P(i,a,b) term of the recurrence, with i in [-1,+1], a in [-(l-1),+(l-1)] and b in [-l,+l]
+		auto	P = [&]( int i, int a, int b ) -> double
+		{
+			const double*	PreviousRow = Previous + (a+l-1) * PreviousSize;
+			if ( b == l )
+				return R1[i+1][2] * PreviousRow[2*l-2] - R1[i+1][0] * PreviousRow[0];
+			else if ( b == -l )
+				return R1[i+1][2] * PreviousRow[0] + R1[i+1][0] * PreviousRow[2*l-2];
+			else
+				return R1[i+1][1] * PreviousRow[b+l-1];
+		};
+
+		for ( int m=-l; m <= l; m++ )
+		{
+			int		AbsM = abs( m );
+			for ( int n=-l; n <= l; n++ )
+			{
+				double	Denominator = abs( n ) < l ? double( (l+n) * (l-n) ) : double( 2*l * (2*l-1) );
+				double	u = sqrt( (l+m) * (l-m) / Denominator );
+				double	v = 0.5 * sqrt( (m == 0 ? 2.0 : 1.0) * (l+AbsM-1) * (l+AbsM) / Denominator ) * (m == 0 ? -1.0 : 1.0);
+				double	w = m == 0 ? 0.0 : -0.5 * sqrt( (l-AbsM-1) * (l-AbsM) / Denominator );
+
+				double	Value = 0.0;
+				if ( u != 0.0 )
+					Value += u * P( 0, m, n );
+
+				if ( v != 0.0 )
+				{
+					double	V;
+					if ( m == 0 )
+						V = P( 1, 1, n ) + P( -1, -1, n );
+					else if ( m > 0 )
+						V = m == 1 ? sqrt( 2.0 ) * P( 1, 0, n ) : P( 1, m-1, n ) - P( -1, -m+1, n );
+					else
+						V = m == -1 ? sqrt( 2.0 ) * P( -1, 0, n ) : P( 1, m+1, n ) + P( -1, -m-1, n );
+					Value += v * V;
+				}
+
+				if ( w != 0.0 )
+				{
+					double	W = m > 0 ? P( 1, m+1, n ) + P( -1, -m-1, n ) : P( 1, m-1, n ) - P( -1, -m+1, n );
+					Value += w * W;
+				}
+
+				Current[(m+l) * Size + (n+l)] = Value;
+			}
+		}
+
+		float*	Band = m_Matrices + l * (2*l-1) * (2*l+1) / 3;
+		for ( int i=0; i < Size*Size; i++ )
+			Band[i] = float( Current[i] );
+
+		double*	Temp = Previous;
+		Previous = Current;
+		Current = Temp;
+	}
+}
+
+void	SHRotation::Rotate( const float* _Source, float* _Target ) const
+{
+	ASSERT( _Source != _Target, "Source and target coefficients must not overlap!" );
+	for ( U32 l=0; l <= m_Order; l++ )
+	{
+		U32				Size = 2*l+1;
+		const float*	Matrix = GetBandMatrix( l );
+		const float*	Source = _Source + l*l;
+		float*			Target = _Target + l*l;
+		for ( U32 i=0; i < Size; i++, Matrix+=Size )
+		{
+			float	Sum = 0.0f;
+			for ( U32 j=0; j < Size; j++ )
+				Sum += Matrix[j] * Source[j];
+			Target[i] = Sum;
+		}
+	}
+}
+
+void	SHRotation::Rotate( const bfloat3* _Source, bfloat3* _Target ) const
+{
+	ASSERT( _Source != _Target, "Source and target coefficients must not overlap!" );
+	for ( U32 l=0; l <= m_Order; l++ )
+	{
+		U32				Size = 2*l+1;
+		const float*	Matrix = GetBandMatrix( l );
+		const bfloat3*	Source = _Source + l*l;
+		bfloat3*		Target = _Target + l*l;
+		for ( U32 i=0; i < Size; i++, Matrix+=Size )
+		{
+			bfloat3	Sum( 0, 0, 0 );
+			for ( U32 j=0; j < Size; j++ )
+			{
+				Sum.x += Matrix[j] * Source[j].x;
+				Sum.y += Matrix[j] * Source[j].y;
+				Sum.z += Matrix[j] * Source[j].z;
+			}
+			Target[i] = Sum;
+		}
+	}
+}
+
+void	SHRotation::Rotate( const float* _Sources, float* _Targets, U32 _Count ) const
+{
+	U32	CoeffsCount = GetCoeffsCount();
+	U32	GroupsCount = _Count >> 2;
+
+	// Each thread gets its own buffer for the current band of its 4 vectors, transposed
+	ThreadPool&	Pool = ThreadPool::Default();
+	U32			LanesSize = 4 * (2*m_Order+1);
+	float*		ThreadLanes = new float[Pool.GetThreadsCount() * LanesSize];
+	Pool.ParallelForRange( GroupsCount, MAX( 1U, GroupsCount / (4 * Pool.GetThreadsCount()) ), [&]( U32 _StartGroup, U32 _EndGroup, U32 _ThreadIndex )
+	{
+		float*	Lanes = ThreadLanes + _ThreadIndex * LanesSize;
+		for ( U32 GroupIndex=_StartGroup; GroupIndex < _EndGroup; GroupIndex++ )
+		{
+			const float*	Sources = _Sources + 4 * GroupIndex * CoeffsCount;
+			float*			Targets = _Targets + 4 * GroupIndex * CoeffsCount;
+			for ( U32 l=0; l <= m_Order; l++ )
+			{
+				U32	Size = 2*l+1;
+				U32	Offset = l*l;
+				for ( U32 j=0; j < Size; j++ )
+					_mm_storeu_ps( Lanes + 4*j, _mm_setr_ps( Sources[Offset+j], Sources[CoeffsCount+Offset+j], Sources[2*CoeffsCount+Offset+j], Sources[3*CoeffsCount+Offset+j] ) );
+
+				const float*	Matrix = GetBandMatrix( l );
+				for ( U32 i=0; i < Size; i++, Matrix+=Size )
+				{
+					__m128	Sum = _mm_setzero_ps();
+					for ( U32 j=0; j < Size; j++ )
+						Sum = _mm_add_ps( Sum, _mm_mul_ps( _mm_set1_ps( Matrix[j] ), _mm_loadu_ps( Lanes + 4*j ) ) );
+
+					float	Values[4];
+					_mm_storeu_ps( Values, Sum );
+					Targets[Offset+i] = Values[0];
+					Targets[CoeffsCount+Offset+i] = Values[1];
+					Targets[2*CoeffsCount+Offset+i] = Values[2];
+					Targets[3*CoeffsCount+Offset+i] = Values[3];
+				}
+			}
+		}
+	} );
+	delete[] ThreadLanes;
+
+	// Remaining vectors
+	for ( U32 VectorIndex=4*GroupsCount; VectorIndex < _Count; VectorIndex++ )
+		Rotate( _Sources + VectorIndex * CoeffsCount, _Targets + VectorIndex * CoeffsCount );
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SH Rotation Cache
+//
+SHRotationCache::SHRotationCache( U32 _Order, U32 _EntriesCount )
+	: m_Order( _Order )
+	, m_EntriesCount( MAX( 1U, _EntriesCount ) )
+	, m_Clock( 0 )
+	, m_HitsCount( 0 )
+	, m_MissesCount( 0 )
+{
+	m_Entries = new Entry[m_EntriesCount];
+	for ( U32 EntryIndex=0; EntryIndex < m_EntriesCount; EntryIndex++ )
+	{
+		m_Entries[EntryIndex].m_pSHRotation = NULL;
+		m_Entries[EntryIndex].m_LastUse = 0;
+	}
+}
+
+SHRotationCache::~SHRotationCache()
+{
+	for ( U32 EntryIndex=0; EntryIndex < m_EntriesCount; EntryIndex++ )
+		delete m_Entries[EntryIndex].m_pSHRotation;
+	delete[] m_Entries;
+}
+
+const SHRotation&	SHRotationCache::Get( const float3x3& _Rotation )
+{
+	// FNV-1a hash of the matrix bits
+	const U32*	Bits = reinterpret_cast< const U32* >( &_Rotation.r[0].x );
+	U32			Hash = 2166136261U;
+	for ( U32 i=0; i < 9; i++ )
+		Hash = (Hash ^ Bits[i]) * 16777619U;
+
+	m_Clock++;
+	Entry*	pOldest = NULL;
+	for ( U32 ProbeIndex=0; ProbeIndex < MIN( 4U, m_EntriesCount ); ProbeIndex++ )
+	{
+		Entry&	E = m_Entries[(Hash + ProbeIndex) % m_EntriesCount];
+		if ( E.m_pSHRotation != NULL && memcmp( &E.m_Rotation, &_Rotation, sizeof(float3x3) ) == 0 )
+		{
+			m_HitsCount++;
+			E.m_LastUse = m_Clock;
+			return *E.m_pSHRotation;
+		}
+		if ( pOldest == NULL || E.m_LastUse < pOldest->m_LastUse )
+			pOldest = &E;
+	}
+
+	// Rebuild the least recently used entry
+	m_MissesCount++;
+	if ( pOldest->m_pSHRotation == NULL )
+		pOldest->m_pSHRotation = new SHRotation( m_Order );
+	pOldest->m_pSHRotation->Build( _Rotation );
+	pOldest->m_Rotation = _Rotation;
+	pOldest->m_LastUse = m_Clock;
+
+	return *pOldest->m_pSHRotation;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// SH Product
+//
+// Tells if the 2 memory ranges overlap (the products clear their output before reading the operands)
+static bool	Overlap( const void* _A, U32 _SizeA, const void* _B, U32 _SizeB )
+{
+	return (const U8*) _A < (const U8*) _B + _SizeB && (const U8*) _B < (const U8*) _A + _SizeA;
+}
+
+// Computes the nodes and weights of the n-points Gauss-Legendre quadrature on [-1,+1]
+static void	ComputeGaussLegendre( int _PointsCount, double* _Nodes, double* _Weights )
+{
+	for ( int i=0; i < _PointsCount; i++ )
+	{
+		double	x = cos( 3.1415926535897932384626433832795 * (i + 0.75) / (_PointsCount + 0.5) );
+		double	Derivative;
+		for ( int Iteration=0; Iteration < 100; Iteration++ )
+		{
+			// Evaluate the Legendre polynomial and its derivative by recurrence
+			double	P0 = 1.0, P1 = 0.0;
+			for ( int j=1; j <= _PointsCount; j++ )
+			{
+				double	P2 = P1;
+				P1 = P0;
+				P0 = ((2.0*j - 1.0) * x * P1 - (j - 1.0) * P2) / j;
+			}
+			Derivative = _PointsCount * (x * P0 - P1) / (x * x - 1.0);
+
+			double	Delta = P0 / Derivative;
+			x -= Delta;
+			if ( fabs( Delta ) < 1e-15 )
+				break;
+		}
+		_Nodes[i] = x;
+		_Weights[i] = 2.0 / ((1.0 - x * x) * Derivative * Derivative);
+	}
+}
+
+SHProduct::SHProduct( U32 _Order )
+	: m_Order( _Order )
+	, m_CoeffsCount( (_Order+1) * (_Order+1) )
+	, m_EntriesCount( 0 )
+	, m_Entries( NULL )
+{
+	RELEASE_ASSERT( _Order <= 254, "SH product order is limited to 254 since the coefficient indices are stored as U16!" );
+
+	// The product of 3 SH of order N is a polynomial of degree 3N:
+	//	_ a uniform azimuthal sampling with more than 3N points integrates it exactly along ϕ
+	//	_ what remains is a polynomial of degree 3N in cosθ that Gauss-Legendre integrates exactly with (3N/2)+1 points
+	int		N = int(_Order);
+	int		ZCount = 3*N/2 + 1;
+	int		PhiCount = 3*N + 2;
+	int		PointsCount = ZCount * PhiCount;
+
+	double*	Nodes = new double[ZCount];
+	double*	Weights = new double[ZCount];
+	ComputeGaussLegendre( ZCount, Nodes, Weights );
+
+	double*	PointWeights = new double[PointsCount];
+	double*	Y = new double[PointsCount * m_CoeffsCount];	// Y[Coeff * PointsCount + Point]
+	double*	PointY = new double[m_CoeffsCount];
+	for ( int ZIndex=0; ZIndex < ZCount; ZIndex++ )
+	{
+		double	z = Nodes[ZIndex];
+		double	r = sqrt( MAX( 0.0, 1.0 - z*z ) );
+		for ( int PhiIndex=0; PhiIndex < PhiCount; PhiIndex++ )
+		{
+			int		PointIndex = ZIndex * PhiCount + PhiIndex;
+			double	ϕ = 2.0 * 3.1415926535897932384626433832795 * PhiIndex / PhiCount;
+			BuildSHCoeffsRecurrence( r * cos( ϕ ), r * sin( ϕ ), z, N, PointY );	// In double precision: float directions are off the quadrature nodes and leave ~1e-9 in the vanishing entries
+			for ( U32 CoeffIndex=0; CoeffIndex < m_CoeffsCount; CoeffIndex++ )
+				Y[CoeffIndex * PointsCount + PointIndex] = PointY[CoeffIndex];
+			PointWeights[PointIndex] = Weights[ZIndex] * 2.0 * 3.1415926535897932384626433832795 / PhiCount;
+		}
+	}
+
+	// Integrate all the triplets allowed by the selection rules:
+	//	_ |l1-l2| <= l3 <= l1+l2 with l1+l2+l3 even
+	//	_ |m3| is either |m1|+|m2| or ||m1|-|m2||
+	// Some of the remaining triplets still vanish because of the signs of m, they integrate to round-off noise (~1e-16) while the
+	//	smallest actual entries get below 1e-6 from order 20, so the entries of each band are pruned relatively to the band's largest one
+	U32		MaxEntriesCount = 256;
+	m_Entries = new Entry[MaxEntriesCount];
+	for ( int l3=0; l3 <= N; l3++ )
+	{
+		U32		BandStart = m_EntriesCount;
+		double	BandMaxG = 0.0;
+		for ( int m3=-l3; m3 <= l3; m3++ )
+		{
+			U32				k = l3*(l3+1)+m3;
+			const double*	Yk = Y + k * PointsCount;
+			for ( int l1=0; l1 <= N; l1++ )
+				for ( int m1=-l1; m1 <= l1; m1++ )
+				{
+					U32		i = l1*(l1+1)+m1;
+					for ( int l2=l1; l2 <= N; l2++ )
+					{
+						if ( l3 < l2-l1 || l3 > l1+l2 || ((l1+l2+l3) & 1) )
+							continue;
+
+						for ( int m2=-l2; m2 <= l2; m2++ )
+						{
+							U32	j = l2*(l2+1)+m2;
+							if ( j < i )
+								continue;
+							if ( abs( m3 ) != abs( m1 ) + abs( m2 ) && abs( m3 ) != abs( abs( m1 ) - abs( m2 ) ) )
+								continue;
+
+							const double*	Yi = Y + i * PointsCount;
+							const double*	Yj = Y + j * PointsCount;
+							double	G = 0.0;
+							for ( int PointIndex=0; PointIndex < PointsCount; PointIndex++ )
+								G += PointWeights[PointIndex] * Yi[PointIndex] * Yj[PointIndex] * Yk[PointIndex];
+							BandMaxG = MAX( BandMaxG, fabs( G ) );
+
+							if ( m_EntriesCount == MaxEntriesCount )
+							{
+								Entry*	Temp = new Entry[2*MaxEntriesCount];
+								memcpy( Temp, m_Entries, m_EntriesCount * sizeof(Entry) );
+								delete[] m_Entries;
+								m_Entries = Temp;
+								MaxEntriesCount *= 2;
+							}
+
+							Entry&	E = m_Entries[m_EntriesCount++];
+							E.i = U16( i );
+							E.j = U16( j );
+							E.k = U16( k );
+							E.G = float( G );
+						}
+					}
+				}
+		}
+
+		// Prune the vanishing entries of the band
+		U32		BandEnd = m_EntriesCount;
+		m_EntriesCount = BandStart;
+		for ( U32 EntryIndex=BandStart; EntryIndex < BandEnd; EntryIndex++ )
+		{
+			Entry	E = m_Entries[EntryIndex];
+			if ( fabs( E.G ) < 1e-10 * BandMaxG )
+				continue;	// Vanishes because of the signs of m
+
+			if ( E.i == E.j )
+				E.G *= 0.5f;
+			m_Entries[m_EntriesCount++] = E;
+		}
+	}
+
+	delete[] PointY;
+	delete[] Y;
+	delete[] PointWeights;
+	delete[] Weights;
+	delete[] Nodes;
+}
+
+SHProduct::~SHProduct()
+{
+	delete[] m_Entries;
+}
+
+void	SHProduct::Product( const float* _A, const float* _B, float* _C ) const
+{
+	U32	Size = m_CoeffsCount * sizeof(float);
+	ASSERT( !Overlap( _C, Size, _A, Size ) && !Overlap( _C, Size, _B, Size ), "The product must not overlap its operands!" );
+	memset( _C, 0, m_CoeffsCount * sizeof(float) );
+	for ( U32 EntryIndex=0; EntryIndex < m_EntriesCount; EntryIndex++ )
+	{
+		const Entry&	E = m_Entries[EntryIndex];
+		_C[E.k] += E.G * (_A[E.i] * _B[E.j] + _A[E.j] * _B[E.i]);
+	}
+}
+
+void	SHProduct::Product( const bfloat3* _A, const float* _B, bfloat3* _C ) const
+{
+	U32	Size = m_CoeffsCount * sizeof(bfloat3);
+	ASSERT( !Overlap( _C, Size, _A, Size ) && !Overlap( _C, Size, _B, m_CoeffsCount * sizeof(float) ), "The product must not overlap its operands!" );
+	memset( _C, 0, m_CoeffsCount * sizeof(bfloat3) );
+	for ( U32 EntryIndex=0; EntryIndex < m_EntriesCount; EntryIndex++ )
+	{
+		const Entry&	E = m_Entries[EntryIndex];
+		float			Bi = E.G * _B[E.i];
+		float			Bj = E.G * _B[E.j];
+		_C[E.k].x += _A[E.i].x * Bj + _A[E.j].x * Bi;
+		_C[E.k].y += _A[E.i].y * Bj + _A[E.j].y * Bi;
+		_C[E.k].z += _A[E.i].z * Bj + _A[E.j].z * Bi;
+	}
+}
+
+void	SHProduct::Product( const bfloat3* _A, const bfloat3* _B, bfloat3* _C ) const
+{
+	U32	Size = m_CoeffsCount * sizeof(bfloat3);
+	ASSERT( !Overlap( _C, Size, _A, Size ) && !Overlap( _C, Size, _B, Size ), "The product must not overlap its operands!" );
+	memset( _C, 0, m_CoeffsCount * sizeof(bfloat3) );
+	for ( U32 EntryIndex=0; EntryIndex < m_EntriesCount; EntryIndex++ )
+	{
+		const Entry&	E = m_Entries[EntryIndex];
+		_C[E.k].x += E.G * (_A[E.i].x * _B[E.j].x + _A[E.j].x * _B[E.i].x);
+		_C[E.k].y += E.G * (_A[E.i].y * _B[E.j].y + _A[E.j].y * _B[E.i].y);
+		_C[E.k].z += E.G * (_A[E.i].z * _B[E.j].z + _A[E.j].z * _B[E.i].z);
+	}
+}
+
+void	SHProduct::ProductSoA( const float* _A, const float* _B, float* _C, U32 _Count, U32 _Stride ) const
+{
+	U32	Size = ((m_CoeffsCount-1) * _Stride + _Count) * sizeof(float);
+	ASSERT( !Overlap( _C, Size, _A, Size ) && !Overlap( _C, Size, _B, Size ), "The product must not overlap its operands!" );
+
+	// Tiles of 64 vectors keep the operands of a tile in cache while all the entries are processed
+	const U32	TILE_SIZE = 64;
+	U32			TilesCount = (_Count + TILE_SIZE-1) / TILE_SIZE;
+	ThreadPool::Default().ParallelFor( TilesCount, [&]( U32 _TileIndex, U32 _ThreadIndex )
+	{
+		U32	Start = _TileIndex * TILE_SIZE;
+		U32	End = MIN( Start + TILE_SIZE, _Count );
+		U32	End4 = Start + ((End - Start) & ~3U);
+
+		for ( U32 CoeffIndex=0; CoeffIndex < m_CoeffsCount; CoeffIndex++ )
+			memset( _C + CoeffIndex * _Stride + Start, 0, (End - Start) * sizeof(float) );
+
+		for ( U32 EntryIndex=0; EntryIndex < m_EntriesCount; EntryIndex++ )
+		{
+			const Entry&	E = m_Entries[EntryIndex];
+			const float*	Ai = _A + E.i * _Stride;
+			const float*	Aj = _A + E.j * _Stride;
+			const float*	Bi = _B + E.i * _Stride;
+			const float*	Bj = _B + E.j * _Stride;
+			float*			C = _C + E.k * _Stride;
+
+			__m128	G = _mm_set1_ps( E.G );
+			U32		v = Start;
+			for ( ; v < End4; v+=4 )
+			{
+				__m128	Sum = _mm_add_ps( _mm_mul_ps( _mm_loadu_ps( Ai + v ), _mm_loadu_ps( Bj + v ) ), _mm_mul_ps( _mm_loadu_ps( Aj + v ), _mm_loadu_ps( Bi + v ) ) );
+				_mm_storeu_ps( C + v, _mm_add_ps( _mm_loadu_ps( C + v ), _mm_mul_ps( G, Sum ) ) );
+			}
+			for ( ; v < End; v++ )
+				C[v] += E.G * (Ai[v] * Bj[v] + Aj[v] * Bi[v]);
+		}
+	} );
+}
+
+void	SHProduct::BuildOperator( const float* _FixedOperand, float* _Operator ) const
+{
+	ASSERT( !Overlap( _Operator, m_CoeffsCount * m_CoeffsCount * sizeof(float), _FixedOperand, m_CoeffsCount * sizeof(float) ), "The operator must not overlap the fixed operand!" );
+	memset( _Operator, 0, m_CoeffsCount * m_CoeffsCount * sizeof(float) );
+	for ( U32 EntryIndex=0; EntryIndex < m_EntriesCount; EntryIndex++ )
+	{
+		const Entry&	E = m_Entries[EntryIndex];
+		float*			Row = _Operator + E.k * m_CoeffsCount;
+		Row[E.i] += E.G * _FixedOperand[E.j];
+		Row[E.j] += E.G * _FixedOperand[E.i];
+	}
+}
+
+void	SHProduct::ApplyOperator( const float* _Operator, const float* _A, float* _C ) const
+{
+	ASSERT( !Overlap( _C, m_CoeffsCount * sizeof(float), _A, m_CoeffsCount * sizeof(float) ), "The product must not overlap its operand!" );
+	for ( U32 k=0; k < m_CoeffsCount; k++, _Operator+=m_CoeffsCount )
+	{
+		float	Sum = 0.0f;
+		for ( U32 i=0; i < m_CoeffsCount; i++ )
+			Sum += _Operator[i] * _A[i];
+		_C[k] = Sum;
+	}
+}
+
+void	SHProduct::ApplyOperator( const float* _Operator, const bfloat3* _A, bfloat3* _C ) const
+{
+	ASSERT( !Overlap( _C, m_CoeffsCount * sizeof(bfloat3), _A, m_CoeffsCount * sizeof(bfloat3) ), "The product must not overlap its operand!" );
+	for ( U32 k=0; k < m_CoeffsCount; k++, _Operator+=m_CoeffsCount )
+	{
+		bfloat3	Sum( 0, 0, 0 );
+		for ( U32 i=0; i < m_CoeffsCount; i++ )
+		{
+			Sum.x += _Operator[i] * _A[i].x;
+			Sum.y += _Operator[i] * _A[i].y;
+			Sum.z += _Operator[i] * _A[i].z;
+		}
+		_C[k] = Sum;
+	}
+}
+
+void	SHProduct::ApplyOperatorSoA( const float* _Operator, const float* _A, float* _C, U32 _Count, U32 _Stride ) const
+{
+	U32	Size = ((m_CoeffsCount-1) * _Stride + _Count) * sizeof(float);
+	ASSERT( !Overlap( _C, Size, _A, Size ), "The product must not overlap its operand!" );
+
+	const U32	TILE_SIZE = 64;
+	U32			TilesCount = (_Count + TILE_SIZE-1) / TILE_SIZE;
+	ThreadPool::Default().ParallelFor( TilesCount, [&]( U32 _TileIndex, U32 _ThreadIndex )
+	{
+		U32	Start = _TileIndex * TILE_SIZE;
+		U32	End = MIN( Start + TILE_SIZE, _Count );
+		U32	End4 = Start + ((End - Start) & ~3U);
+
+		const float*	Row = _Operator;
+		for ( U32 k=0; k < m_CoeffsCount; k++, Row+=m_CoeffsCount )
+		{
+			float*	C = _C + k * _Stride;
+			memset( C + Start, 0, (End - Start) * sizeof(float) );
+			for ( U32 i=0; i < m_CoeffsCount; i++ )
+			{
+				if ( Row[i] == 0.0f )
+					continue;
+
+				const float*	A = _A + i * _Stride;
+				__m128			M = _mm_set1_ps( Row[i] );
+				U32				v = Start;
+				for ( ; v < End4; v+=4 )
+					_mm_storeu_ps( C + v, _mm_add_ps( _mm_loadu_ps( C + v ), _mm_mul_ps( M, _mm_loadu_ps( A + v ) ) ) );
+				for ( ; v < End; v++ )
+					C[v] += Row[i] * A[v];
+			}
+		}
+	} );
+}
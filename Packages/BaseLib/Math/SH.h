@@ -43,6 +43,18 @@ public:
 
 	static void			BuildSHCoeffs( const bfloat3& _Direction, double _Coeffs[9] );
 
+	// Order-N evaluation
+	// _Order is the highest band: the (_Order+1)² coefficients are ordered by band, coefficient (l,m) being at index l*(l+1)+m
+	// NOTE ==> The '_Direction' vectors must be normalized!!
+	static void			BuildSHCoeffs( const bfloat3& _Direction, U32 _Order, double* _Coeffs );
+	static void			BuildSHCoeffs( const bfloat3& _Direction, U32 _Order, float* _Coeffs );
+
+	// Projects a set of weighted directions: _Coeffs[i] = Sum( _Weights[k] * Y_i( _Directions[k] ) )
+	// The weights usually combine the sampled signal and the solid angle of each sample (e.g. the texel solid angle of a cube map)
+	// Directions are evaluated 4 at a time with SSE and spread across the default thread pool
+	static void			Project( const bfloat3* _Directions, const float* _Weights, U32 _Count, U32 _Order, float* _Coeffs );
+	static void			Project( const bfloat3* _Directions, const bfloat3* _Values, U32 _Count, U32 _Order, bfloat3* _Coeffs );
+
 	// Advanced
 	static void			Product3( const double a[9], const double b[9], double r[9] );
 	static void			Product3( const float a[9], const float b[9], float r[9] );
@@ -93,3 +105,122 @@ private:
 	static void			Filter( float _SH[9], int l, float a );		// Modulate all coefficients of degree l by scalar a.
 	static void			Filter( bfloat3 _SH[9], int l, float a );	// Modulate all coefficients of degree l by scalar a.
 };
+
+//////////////////////////////////////////////////////////////////////////
+// SH rotation for any order, using the Ivanic-Ruedenberg recurrence
+//	(from "Rotation Matrices for Real Spherical Harmonics. Direct Determination by Recursion", Ivanic & Ruedenberg (1996) + the 1998 errata)
+//
+// Rotated coefficients represent the rotated function: a lobe pointing toward direction D in the source coefficients points toward D * _Rotation in the rotated ones
+//	(row vectors as in the rest of BaseLib, the matrix must be orthonormal)
+//
+// Each band l is rotated by its own (2l+1)x(2l+1) matrix, band 1 being a permutation of the 3x3 rotation and the other bands being built from the previous one
+//
+class	SHRotation
+{
+private:
+	U32		m_Order;
+	float*	m_Matrices;		// All the band matrices, one after another
+	double*	m_Scratch;		// The previous and current bands while building the matrices
+
+public:
+	SHRotation( U32 _Order );
+	~SHRotation();
+
+	U32		GetOrder() const		{ return m_Order; }
+	U32		GetCoeffsCount() const	{ return (m_Order+1) * (m_Order+1); }
+
+	// Gets the (2l+1)x(2l+1) row-major matrix of band l
+	const float*	GetBandMatrix( U32 l ) const	{ return m_Matrices + l * (2*l-1) * (2*l+1) / 3; }
+
+	void	Build( const float3x3& _Rotation );
+
+	// Rotates a single vector of (Order+1)² coefficients (_Source and _Target must not overlap)
+	void	Rotate( const float* _Source, float* _Target ) const;
+	void	Rotate( const bfloat3* _Source, bfloat3* _Target ) const;
+
+	// Rotates _Count consecutive vectors of (Order+1)² coefficients, 4 vectors at a time with SSE and spread across the default thread pool
+	void	Rotate( const float* _Sources, float* _Targets, U32 _Count ) const;
+};
+
+// Caches the rotation matrices of recurring orientations (e.g. the fixed frames of a set of probes)
+// Rotations are looked up among 4 consecutive entries from a hash of the rotation matrix, a miss rebuilds the least recently used one
+// NOTE: Not thread-safe! Use one cache per thread
+//
+class	SHRotationCache
+{
+private:
+	struct	Entry
+	{
+		float3x3	m_Rotation;
+		SHRotation*	m_pSHRotation;
+		U32			m_LastUse;
+	};
+
+	U32		m_Order;
+	U32		m_EntriesCount;
+	Entry*	m_Entries;
+	U32		m_Clock;
+	U32		m_HitsCount;
+	U32		m_MissesCount;
+
+public:
+	SHRotationCache( U32 _Order, U32 _EntriesCount=64 );
+	~SHRotationCache();
+
+	// Gets the SH rotation matching the given rotation matrix
+	// The returned reference is valid until a miss evicts its entry
+	const SHRotation&	Get( const float3x3& _Rotation );
+
+	U32		GetHitsCount() const	{ return m_HitsCount; }
+	U32		GetMissesCount() const	{ return m_MissesCount; }
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Product of SH vectors of any order, using the precomputed Gaunt tensor G(i,j,k) = Integral( Y_i Y_j Y_k )
+//
+// The product c = a * b is c_k = Sum( G(i,j,k) a_i b_j ), truncated to the order of the operands
+// Only the non-zero entries of the tensor with i <= j are stored (i.e. about 2% of the full tensor at order 8), they are computed once by exact quadrature
+// The order is limited to 254 as the coefficient indices are stored on 16 bits
+//
+// NOTE: The results must not overlap the operands since they are cleared before the operands are read (i.e. no in-place product)
+//
+class	SHProduct
+{
+private:
+	struct	Entry
+	{
+		U16		i, j, k;
+		float	G;			// Halved when i == j so the kernel can always use G * (a_i b_j + a_j b_i)
+	};
+
+	U32		m_Order;
+	U32		m_CoeffsCount;
+	U32		m_EntriesCount;
+	Entry*	m_Entries;		// Sorted by k
+
+public:
+	SHProduct( U32 _Order );
+	~SHProduct();
+
+	U32		GetOrder() const		{ return m_Order; }
+	U32		GetCoeffsCount() const	{ return m_CoeffsCount; }
+	U32		GetEntriesCount() const	{ return m_EntriesCount; }
+
+	// Computes _C = _A * _B for single vectors of (Order+1)² coefficients
+	void	Product( const float* _A, const float* _B, float* _C ) const;
+	void	Product( const bfloat3* _A, const float* _B, bfloat3* _C ) const;
+	void	Product( const bfloat3* _A, const bfloat3* _B, bfloat3* _C ) const;
+
+	// Computes the products of _Count vectors stored as SoA: coefficient i of vector v is at index i * _Stride + v
+	//	RGB vectors are simply stored as 3 vectors, one for each channel
+	//	The vectors are processed 4 at a time with SSE, in tiles spread across the default thread pool
+	void	ProductSoA( const float* _A, const float* _B, float* _C, U32 _Count, U32 _Stride ) const;
+
+	// Product with a fixed operand
+	// When the same vector multiplies many others (e.g. a probe's occlusion applied to several lighting vectors), the product becomes a linear operator that can be built once:
+	//	BuildOperator() fills the (Order+1)² x (Order+1)² row-major matrix M so that _A * _FixedOperand = M _A
+	void	BuildOperator( const float* _FixedOperand, float* _Operator ) const;
+	void	ApplyOperator( const float* _Operator, const float* _A, float* _C ) const;
+	void	ApplyOperator( const float* _Operator, const bfloat3* _A, bfloat3* _C ) const;
+	void	ApplyOperatorSoA( const float* _Operator, const float* _A, float* _C, U32 _Count, U32 _Stride ) const;
+};
@@ -0,0 +1,193 @@
+//////////////////////////////////////////////////////////////////////////
+// SSE helpers for span kernels working on 4 lanes at a time
+// The transcendental functions are polynomial approximations, their accuracy is given for each function
+//
+#pragma once
+
+#include <emmintrin.h>
+
+namespace BaseLib {
+	namespace SIMD {
+
+		//////////////////////////////////////////////////////////////////////////
+		// AoS <-> SoA
+		//
+		// Loads 4 consecutive bfloat4 and transposes them into 4 vectors of x, y, z and w
+		inline void	LoadSoA( const bfloat4* _source, __m128& _x, __m128& _y, __m128& _z, __m128& _w ) {
+			_x = _mm_loadu_ps( &_source[0].x );
+			_y = _mm_loadu_ps( &_source[1].x );
+			_z = _mm_loadu_ps( &_source[2].x );
+			_w = _mm_loadu_ps( &_source[3].x );
+			_MM_TRANSPOSE4_PS( _x, _y, _z, _w );
+		}
+
+		// Transposes 4 vectors of x, y, z and w and stores them as 4 consecutive bfloat4
+		inline void	StoreAoS( __m128 _x, __m128 _y, __m128 _z, __m128 _w, bfloat4* _target ) {
+			_MM_TRANSPOSE4_PS( _x, _y, _z, _w );
+			_mm_storeu_ps( &_target[0].x, _x );
+			_mm_storeu_ps( &_target[1].x, _y );
+			_mm_storeu_ps( &_target[2].x, _z );
+			_mm_storeu_ps( &_target[3].x, _w );
+		}
+
+		// Selects _a where the mask is set, _b otherwise
+		inline __m128	Select( __m128 _mask, __m128 _a, __m128 _b ) {
+			return _mm_or_ps( _mm_and_ps( _mask, _a ), _mm_andnot_ps( _mask, _b ) );
+		}
+		inline __m128i	Select( __m128i _mask, __m128i _a, __m128i _b ) {
+			return _mm_or_si128( _mm_and_si128( _mask, _a ), _mm_andnot_si128( _mask, _b ) );
+		}
+
+		// Packs the low 16 bits of the 4 U32 lanes of _a and _b into 8 U16 lanes (i.e. no saturation)
+		inline __m128i	PackU16( __m128i _a, __m128i _b ) {
+			_a = _mm_srai_epi32( _mm_slli_epi32( _a, 16 ), 16 );
+			_b = _mm_srai_epi32( _mm_slli_epi32( _b, 16 ), 16 );
+			return _mm_packs_epi32( _a, _b );
+		}
+
+		// Multiplies 4 U32 lanes and keeps the low 32 bits of the products (i.e. SSE4.1's _mm_mullo_epi32)
+		inline __m128i	MulLo32( __m128i _a, __m128i _b ) {
+			__m128i	even = _mm_mul_epu32( _a, _b );
+			__m128i	odd = _mm_mul_epu32( _mm_srli_epi64( _a, 32 ), _mm_srli_epi64( _b, 32 ) );
+			return _mm_unpacklo_epi32( _mm_shuffle_epi32( even, _MM_SHUFFLE( 0, 0, 2, 0 ) ), _mm_shuffle_epi32( odd, _MM_SHUFFLE( 0, 0, 2, 0 ) ) );
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Half floats
+		//
+		// Converts 4 half floats stored in the low 16 bits of each U32 lane into floats
+		// The result is bit-exact with the half::operator float() conversion
+		inline __m128	HalfToFloat( __m128i _halves ) {
+			const __m128i	exponentMask = _mm_set1_epi32( 0x7C00 );
+			const __m128i	mantissaMask = _mm_set1_epi32( 0x03FF );
+
+			__m128i	sign = _mm_slli_epi32( _mm_and_si128( _halves, _mm_set1_epi32( 0x8000 ) ), 16 );
+			__m128i	exponent = _mm_and_si128( _halves, exponentMask );
+			__m128i	mantissa = _mm_and_si128( _halves, mantissaMask );
+
+			// Normalized values simply need to be re-biased (i.e. 127-15 = 112)
+			__m128i	normalized = _mm_add_epi32( _mm_slli_epi32( _mm_and_si128( _halves, _mm_set1_epi32( 0x7FFF ) ), 13 ), _mm_set1_epi32( 112 << 23 ) );
+			__m128i	denormalized = _mm_castps_si128( _mm_mul_ps( _mm_cvtepi32_ps( mantissa ), _mm_set1_ps( 1.0f / (1 << 24) ) ) );
+			__m128i	infNaN = _mm_or_si128( _mm_set1_epi32( 0x7F800000 ), mantissa );	// NaN payload is not shifted, as in the scalar conversion
+			__m128i	result = Select( _mm_cmpeq_epi32( exponent, _mm_setzero_si128() ), denormalized, normalized );
+					result = Select( _mm_cmpeq_epi32( exponent, exponentMask ), infNaN, result );
+
+			return _mm_castsi128_ps( _mm_or_si128( sign, result ) );
+		}
+
+		// Converts 4 floats into half floats stored in the low 16 bits of each U32 lane
+		// The result is bit-exact with the half( float ) conversion (i.e. truncation, denormals flushed to 0, overflows to infinity)
+		inline __m128i	FloatToHalf( __m128 _values ) {
+			__m128i	bits = _mm_castps_si128( _values );
+			__m128i	sign = _mm_and_si128( _mm_srli_epi32( bits, 16 ), _mm_set1_epi32( 0x8000 ) );
+			__m128i	exponent = _mm_and_si128( _mm_srli_epi32( bits, 23 ), _mm_set1_epi32( 0xFF ) );
+			__m128i	mantissa = _mm_and_si128( bits, _mm_set1_epi32( 0x007FFFFF ) );
+			__m128i	infinity = _mm_or_si128( sign, _mm_set1_epi32( 0x7C00 ) );
+
+			__m128i	normalized = _mm_or_si128( sign, _mm_or_si128( _mm_slli_epi32( _mm_sub_epi32( exponent, _mm_set1_epi32( 112 ) ), 10 ), _mm_srli_epi32( mantissa, 13 ) ) );
+			__m128i	result = Select( _mm_cmpgt_epi32( exponent, _mm_set1_epi32( 112 ) ), normalized, sign );
+					result = Select( _mm_cmpgt_epi32( exponent, _mm_set1_epi32( 142 ) ), infinity, result );
+					result = Select( _mm_cmpeq_epi32( exponent, _mm_set1_epi32( 255 ) ), _mm_or_si128( infinity, _mm_and_si128( mantissa, _mm_set1_epi32( 0x03FF ) ) ), result );
+
+			return result;
+		}
+
+		// Transforms the (x,y,z) row vectors by the matrix (i.e. same convention as bfloat3 * float3x3)
+		inline void	Transform( __m128& _x, __m128& _y, __m128& _z, const float3x3& _M ) {
+			__m128	x = _x, y = _y, z = _z;
+			_x = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( _M.r[0].x ) ), _mm_mul_ps( y, _mm_set1_ps( _M.r[1].x ) ) ), _mm_mul_ps( z, _mm_set1_ps( _M.r[2].x ) ) );
+			_y = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( _M.r[0].y ) ), _mm_mul_ps( y, _mm_set1_ps( _M.r[1].y ) ) ), _mm_mul_ps( z, _mm_set1_ps( _M.r[2].y ) ) );
+			_z = _mm_add_ps( _mm_add_ps( _mm_mul_ps( x, _mm_set1_ps( _M.r[0].z ) ), _mm_mul_ps( y, _mm_set1_ps( _M.r[1].z ) ) ), _mm_mul_ps( z, _mm_set1_ps( _M.r[2].z ) ) );
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// Transcendental functions
+		//
+		// Computes log2(x) for x > 0 (denormals are flushed to 0 and return -126)
+		// Maximum absolute error is 1.5e-7 * max( 1, |log2(x)| ) over the normalized float range
+		inline __m128	Log2( __m128 _x ) {
+			const __m128i	exponentMask = _mm_set1_epi32( 0x7F800000 );
+			const __m128i	mantissaMask = _mm_set1_epi32( 0x007FFFFF );
+			const __m128	one = _mm_set1_ps( 1.0f );
+
+			// Split into exponent and a mantissa in [sqrt(0.5),sqrt(2)[
+			__m128i	bits = _mm_castps_si128( _x );
+			__m128i	exponent = _mm_sub_epi32( _mm_srli_epi32( _mm_and_si128( bits, exponentMask ), 23 ), _mm_set1_epi32( 127 ) );
+			__m128	mantissa = _mm_castsi128_ps( _mm_or_si128( _mm_and_si128( bits, mantissaMask ), _mm_castps_si128( one ) ) );	// in [1,2[
+			__m128	adjust = _mm_cmpgt_ps( mantissa, _mm_set1_ps( 1.41421356f ) );
+			mantissa = Select( adjust, _mm_mul_ps( mantissa, _mm_set1_ps( 0.5f ) ), mantissa );
+			__m128	e = _mm_add_ps( _mm_cvtepi32_ps( exponent ), _mm_and_ps( adjust, one ) );
+
+			// log2(m) = 2/ln(2) * atanh(t) with t = (m-1)/(m+1) in [-0.1716,0.1716]
+			__m128	t = _mm_div_ps( _mm_sub_ps( mantissa, one ), _mm_add_ps( mantissa, one ) );
+			__m128	t2 = _mm_mul_ps( t, t );
+			__m128	p = _mm_set1_ps( 0.41219858f );												// 2/(7 ln2)
+					p = _mm_add_ps( _mm_mul_ps( p, t2 ), _mm_set1_ps( 0.57707801f ) );			// 2/(5 ln2)
+					p = _mm_add_ps( _mm_mul_ps( p, t2 ), _mm_set1_ps( 0.96179669f ) );			// 2/(3 ln2)
+					p = _mm_add_ps( _mm_mul_ps( p, t2 ), _mm_set1_ps( 2.88539008f ) );			// 2/ln2
+			return _mm_add_ps( e, _mm_mul_ps( p, t ) );
+		}
+
+		// Computes 2^x, the result is clamped to [2^-125,2^127.5] (i.e. no denormals nor infinities)
+		// Maximum relative error is 2.2e-7
+		inline __m128	Exp2( __m128 _x ) {
+			_x = _mm_min_ps( _mm_max_ps( _x, _mm_set1_ps( -125.0f ) ), _mm_set1_ps( 127.5f ) );
+
+			// Split into integer part and fraction in [-0.5,0.5]
+			__m128i	n = _mm_cvtps_epi32( _x );	// Round to nearest
+			__m128	f = _mm_sub_ps( _x, _mm_cvtepi32_ps( n ) );
+
+			// Minimax polynomial for 2^f on [-0.5,0.5]
+			__m128	p = _mm_set1_ps( 1.5353362e-4f );
+					p = _mm_add_ps( _mm_mul_ps( p, f ), _mm_set1_ps( 1.3398874e-3f ) );
+					p = _mm_add_ps( _mm_mul_ps( p, f ), _mm_set1_ps( 9.6181245e-3f ) );
+					p = _mm_add_ps( _mm_mul_ps( p, f ), _mm_set1_ps( 5.5504110e-2f ) );
+					p = _mm_add_ps( _mm_mul_ps( p, f ), _mm_set1_ps( 2.4022652e-1f ) );
+					p = _mm_add_ps( _mm_mul_ps( p, f ), _mm_set1_ps( 6.9314718e-1f ) );
+					p = _mm_add_ps( _mm_mul_ps( p, f ), _mm_set1_ps( 1.0f ) );
+
+			// Scale by 2^n by adding n to the exponent
+			return _mm_castsi128_ps( _mm_add_epi32( _mm_castps_si128( p ), _mm_slli_epi32( n, 23 ) ) );
+		}
+
+		// Computes sin(2PI x) and cos(2PI x) for |x| < 2^22
+		// Maximum absolute error is 2e-7 after range reduction (i.e. the error of x - round(x) adds up for large x)
+		inline void		SinCos2PI( __m128 _x, __m128& _sin, __m128& _cos ) {
+			// Reduce to an angle in [-PI/4,PI/4] and a quadrant
+			__m128i	quadrant = _mm_cvtps_epi32( _mm_mul_ps( _x, _mm_set1_ps( 4.0f ) ) );	// Round to nearest
+			__m128	a = _mm_mul_ps( _mm_sub_ps( _x, _mm_mul_ps( _mm_cvtepi32_ps( quadrant ), _mm_set1_ps( 0.25f ) ) ), _mm_set1_ps( 6.283185307f ) );
+			__m128	a2 = _mm_mul_ps( a, a );
+
+			// Taylor series, the first neglected terms are below 1e-8 on [-PI/4,PI/4]
+			__m128	s = _mm_set1_ps( 2.7557319e-6f );												// 1/9!
+					s = _mm_add_ps( _mm_mul_ps( s, a2 ), _mm_set1_ps( -1.9841270e-4f ) );			// -1/7!
+					s = _mm_add_ps( _mm_mul_ps( s, a2 ), _mm_set1_ps( 8.3333333e-3f ) );			// 1/5!
+					s = _mm_add_ps( _mm_mul_ps( s, a2 ), _mm_set1_ps( -1.6666667e-1f ) );			// -1/3!
+					s = _mm_add_ps( _mm_mul_ps( _mm_mul_ps( s, a2 ), a ), a );
+			__m128	c = _mm_set1_ps( 2.4801587e-5f );												// 1/8!
+					c = _mm_add_ps( _mm_mul_ps( c, a2 ), _mm_set1_ps( -1.3888889e-3f ) );			// -1/6!
+					c = _mm_add_ps( _mm_mul_ps( c, a2 ), _mm_set1_ps( 4.1666667e-2f ) );			// 1/4!
+					c = _mm_add_ps( _mm_mul_ps( c, a2 ), _mm_set1_ps( -0.5f ) );					// -1/2!
+					c = _mm_add_ps( _mm_mul_ps( c, a2 ), _mm_set1_ps( 1.0f ) );
+
+			// Rotate by the quadrant: odd quadrants swap sin and cos, quadrants 2 and 3 negate sin, quadrants 1 and 2 negate cos
+			__m128	swap = _mm_castsi128_ps( _mm_cmpeq_epi32( _mm_and_si128( quadrant, _mm_set1_epi32( 1 ) ), _mm_set1_epi32( 1 ) ) );
+			__m128	sinResult = Select( swap, c, s );
+			__m128	cosResult = Select( swap, s, c );
+			__m128i	q = _mm_and_si128( quadrant, _mm_set1_epi32( 3 ) );
+			__m128	negateSin = _mm_castsi128_ps( _mm_or_si128( _mm_cmpeq_epi32( q, _mm_set1_epi32( 2 ) ), _mm_cmpeq_epi32( q, _mm_set1_epi32( 3 ) ) ) );
+			__m128	negateCos = _mm_castsi128_ps( _mm_or_si128( _mm_cmpeq_epi32( q, _mm_set1_epi32( 1 ) ), _mm_cmpeq_epi32( q, _mm_set1_epi32( 2 ) ) ) );
+			__m128	signBit = _mm_set1_ps( -0.0f );
+			_sin = _mm_xor_ps( sinResult, _mm_and_ps( negateSin, signBit ) );
+			_cos = _mm_xor_ps( cosResult, _mm_and_ps( negateCos, signBit ) );
+		}
+
+		// Computes x^y for x > 0, returns 0 for x <= 0
+		// Maximum relative error is 2e-7 * (1 + |y * log2(x)|), i.e. 3.1e-6 for gamma curves over [1e-6,65504]
+		inline __m128	Pow( __m128 _x, __m128 _y ) {
+			__m128	positive = _mm_cmpgt_ps( _x, _mm_setzero_ps() );
+			__m128	result = Exp2( _mm_mul_ps( _y, Log2( _x ) ) );
+			return _mm_and_ps( positive, result );
+		}
+	}
+}
@@ -0,0 +1,663 @@
+#include "stdafx.h"
+#include "SIMD.h"
+#include "../Utility/ThreadPool.h"
+
+using namespace BaseLib;
+
+//////////////////////////////////////////////////////////////////////////
+// SSE helpers
+//
+static inline __m128i	ReverseBits4( __m128i _bits )
+{
+	_bits = _mm_or_si128( _mm_slli_epi32( _bits, 16 ), _mm_srli_epi32( _bits, 16 ) );
+	_bits = _mm_or_si128( _mm_slli_epi32( _mm_and_si128( _bits, _mm_set1_epi32( 0x00FF00FF ) ), 8 ), _mm_srli_epi32( _mm_andnot_si128( _mm_set1_epi32( 0x00FF00FF ), _bits ), 8 ) );
+	_bits = _mm_or_si128( _mm_slli_epi32( _mm_and_si128( _bits, _mm_set1_epi32( 0x0F0F0F0F ) ), 4 ), _mm_srli_epi32( _mm_andnot_si128( _mm_set1_epi32( 0x0F0F0F0F ), _bits ), 4 ) );
+	_bits = _mm_or_si128( _mm_slli_epi32( _mm_and_si128( _bits, _mm_set1_epi32( 0x33333333 ) ), 2 ), _mm_srli_epi32( _mm_andnot_si128( _mm_set1_epi32( 0x33333333 ), _bits ), 2 ) );
+	return _mm_or_si128( _mm_slli_epi32( _mm_and_si128( _bits, _mm_set1_epi32( 0x55555555 ) ), 1 ), _mm_srli_epi32( _mm_andnot_si128( _mm_set1_epi32( 0x55555555 ), _bits ), 1 ) );
+}
+
+// Same as Sampling::OwenScramble()
+static inline __m128i	OwenScramble4( __m128i _x, U32 _seed )
+{
+	_x = ReverseBits4( _x );
+	_x = _mm_add_epi32( _x, _mm_set1_epi32( _seed ) );
+	_x = _mm_xor_si128( _x, SIMD::MulLo32( _x, _mm_set1_epi32( 0x6C50B47C ) ) );
+	_x = _mm_xor_si128( _x, SIMD::MulLo32( _x, _mm_set1_epi32( 0xB82F1E52 ) ) );
+	_x = _mm_xor_si128( _x, SIMD::MulLo32( _x, _mm_set1_epi32( 0xC7AFE638 ) ) );
+	_x = _mm_xor_si128( _x, SIMD::MulLo32( _x, _mm_set1_epi32( 0x8D22F6E6 ) ) );
+	return ReverseBits4( _x );
+}
+
+// Same as Sampling::ToFloat()
+static inline __m128	ToFloat4( __m128i _x )
+{
+	return _mm_mul_ps( _mm_cvtepi32_ps( _mm_srli_epi32( _x, 8 ) ), _mm_set1_ps( 1.0f / 16777216.0f ) );
+}
+
+// Stores the first _count lanes
+static inline void	Store( __m128 _values, U32 _count, float* _target )
+{
+	if ( _count >= 4 )
+	{
+		_mm_storeu_ps( _target, _values );
+		return;
+	}
+	float	temp[4];
+	_mm_storeu_ps( temp, _values );
+	memcpy( _target, temp, _count * sizeof(float) );
+}
+
+// Calls _functor( __m128i _indices, U32 _firstPoint, U32 _lanesCount ) for each group of 4 points, the groups being spread across the default thread pool
+template< typename F > static void	ForEachGroup( U32 _firstIndex, U32 _count, const F& _functor )
+{
+	U32	groupsCount = (_count + 3) >> 2;
+	auto	processGroups = [&]( U32 _startGroup, U32 _endGroup, U32 _threadIndex )
+	{
+		for ( U32 groupIndex=_startGroup; groupIndex < _endGroup; groupIndex++ )
+		{
+			U32	firstPoint = 4 * groupIndex;
+			_functor( _mm_add_epi32( _mm_set1_epi32( _firstIndex + firstPoint ), _mm_setr_epi32( 0, 1, 2, 3 ) ), firstPoint, MIN( 4U, _count - firstPoint ) );
+		}
+	};
+
+	if ( groupsCount < 256 )
+		processGroups( 0, groupsCount, 0 );	// Not worth waking up the pool
+	else
+		ThreadPool::Default().ParallelForRange( groupsCount, 64, processGroups );
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Sobol' sequence
+//
+
+// Direction numbers from S. Joe and F. Kuo, "Constructing Sobol sequences with better two-dimensional projections" (2008)
+// The polynomials are x^s + a_1 x^(s-1) + ... + a_(s-1) x + 1, the a_j coefficients being the bits of a (a_1 is the most significant one)
+// They are the primitive polynomials sorted by degree then by a, so they match the ones enumerated by BuildPrimitivePolynomials()
+struct	JoeKuoEntry
+{
+	U32	s, a;
+	U32	m[8];
+};
+static const JoeKuoEntry	JOE_KUO_TABLE[] = {
+	{ 1,  0, { 1 } },
+	{ 2,  1, { 1, 3 } },
+	{ 3,  1, { 1, 3, 1 } },
+	{ 3,  2, { 1, 1, 1 } },
+	{ 4,  1, { 1, 1, 3, 3 } },
+	{ 4,  4, { 1, 3, 5, 13 } },
+	{ 5,  2, { 1, 1, 5, 5, 17 } },
+	{ 5,  4, { 1, 1, 5, 5, 5 } },
+	{ 5,  7, { 1, 1, 7, 11, 19 } },
+	{ 5, 11, { 1, 1, 5, 1, 1 } },
+	{ 5, 13, { 1, 1, 1, 3, 11 } },
+	{ 5, 14, { 1, 3, 5, 5, 31 } },
+	{ 6,  1, { 1, 3, 3, 9, 7, 49 } },
+	{ 6, 13, { 1, 1, 1, 15, 21, 21 } },
+	{ 6, 16, { 1, 3, 1, 13, 27, 49 } },
+	{ 6, 19, { 1, 1, 1, 15, 7, 5 } },
+	{ 6, 22, { 1, 3, 1, 15, 13, 25 } },
+	{ 6, 25, { 1, 1, 5, 5, 19, 61 } },
+	{ 7,  1, { 1, 3, 7, 11, 23, 15, 103 } },
+	{ 7,  4, { 1, 3, 7, 13, 13, 15, 69 } },
+	{ 7,  7, { 1, 1, 3, 13, 7, 35, 63 } },
+	{ 7,  8, { 1, 3, 5, 9, 1, 25, 53 } },
+	{ 7, 14, { 1, 3, 1, 13, 9, 35, 107 } },
+	{ 7, 19, { 1, 3, 1, 5, 27, 61, 31 } },
+	{ 7, 21, { 1, 1, 5, 11, 19, 41, 61 } },
+	{ 7, 28, { 1, 3, 5, 3, 3, 13, 69 } },
+	{ 7, 31, { 1, 1, 7, 13, 1, 19, 1 } },
+	{ 7, 32, { 1, 3, 7, 5, 13, 19, 59 } },
+	{ 7, 37, { 1, 1, 3, 9, 25, 29, 41 } },
+	{ 7, 41, { 1, 3, 5, 13, 23, 1, 55 } },
+	{ 7, 42, { 1, 3, 7, 3, 13, 59, 17 } },
+	{ 7, 50, { 1, 3, 1, 3, 5, 53, 69 } },
+	{ 7, 55, { 1, 1, 5, 5, 23, 33, 13 } },
+	{ 7, 56, { 1, 1, 7, 7, 1, 61, 123 } },
+	{ 7, 59, { 1, 1, 7, 9, 13, 61, 49 } },
+	{ 7, 62, { 1, 3, 3, 5, 3, 55, 33 } },
+};
+static const U32	JOE_KUO_ENTRIES_COUNT = sizeof(JOE_KUO_TABLE) / sizeof(JoeKuoEntry);
+
+// Computes x^_exponent modulo the polynomial of degree _degree (polynomials over GF(2) are stored as bit fields)
+static U32	PolynomialPowerOfX( U64 _exponent, U32 _polynomial, U32 _degree )
+{
+	U32	result = 1;
+	U32	power = 2;	// x
+	for ( ; _exponent != 0; _exponent >>= 1 )
+	{
+		if ( _exponent & 1 )
+		{
+			// result *= power
+			U32	product = 0;
+			for ( U32 a=result, b=power; b != 0; b >>= 1 )
+			{
+				if ( b & 1 )
+					product ^= a;
+				a <<= 1;
+				if ( a & (1U << _degree) )
+					a ^= _polynomial;
+			}
+			result = product;
+		}
+
+		// power *= power
+		U32	square = 0;
+		for ( U32 a=power, b=power; b != 0; b >>= 1 )
+		{
+			if ( b & 1 )
+				square ^= a;
+			a <<= 1;
+			if ( a & (1U << _degree) )
+				a ^= _polynomial;
+		}
+		power = square;
+	}
+	return result;
+}
+
+// A polynomial of degree s is primitive when x has order exactly 2^s-1 modulo the polynomial
+static bool	IsPrimitive( U32 _polynomial, U32 _degree )
+{
+	U32	order = (1U << _degree) - 1;
+	if ( PolynomialPowerOfX( order, _polynomial, _degree ) != 1 )
+		return false;
+
+	// Check x^(order/q) != 1 for each prime factor q of the order
+	U32	remainder = order;
+	for ( U32 q=2; q*q <= remainder; q++ )
+	{
+		if ( remainder % q != 0 )
+			continue;
+		if ( PolynomialPowerOfX( order / q, _polynomial, _degree ) == 1 )
+			return false;
+		while ( remainder % q == 0 )
+			remainder /= q;
+	}
+	if ( remainder > 1 && remainder != order && PolynomialPowerOfX( order / remainder, _polynomial, _degree ) == 1 )
+		return false;
+
+	return true;
+}
+
+SobolSampler::SobolSampler( U32 _dimensionsCount )
+	: m_dimensionsCount( _dimensionsCount )
+{
+	RELEASE_ASSERT( _dimensionsCount > 0 && _dimensionsCount <= MAX_DIMENSIONS, "Unsupported amount of dimensions!" );
+
+	m_matrices.SetCount( 32 * _dimensionsCount );
+	U32*	columns = m_matrices.Ptr();
+
+	// The first dimension is the van der Corput sequence
+	for ( U32 k=0; k < 32; k++ )
+		columns[k] = 0x80000000U >> k;
+
+	// The other dimensions use the primitive polynomials in order
+	U32	degree = 1;
+	U32	a = 0;
+	for ( U32 dimension=1; dimension < _dimensionsCount; dimension++ )
+	{
+		// Find the next primitive polynomial
+		while ( !IsPrimitive( (1U << degree) | (a << 1) | 1, degree ) )
+		{
+			if ( ++a == (1U << (degree-1)) )
+			{
+				degree++;
+				a = 0;
+			}
+		}
+
+		// Initial direction numbers
+		U32	m[32];
+		if ( dimension <= JOE_KUO_ENTRIES_COUNT )
+		{
+			const JoeKuoEntry&	entry = JOE_KUO_TABLE[dimension-1];
+			ASSERT( entry.s == degree && entry.a == a, "Table doesn't match the enumerated polynomials!" );
+			for ( U32 k=0; k < degree; k++ )
+				m[k] = entry.m[k];
+		}
+		else
+		{
+			// Random odd m_k < 2^k
+			RandomStream	rng( 0x50B0150B0ULL, dimension );
+			for ( U32 k=0; k < degree; k++ )
+				m[k] = (rng.NextU32( 1U << k ) << 1) | 1;
+		}
+
+		// Recurrence m_k = 2 a_1 m_(k-1) ^ 4 a_2 m_(k-2) ^ ... ^ 2^(s-1) a_(s-1) m_(k-s+1) ^ 2^s m_(k-s) ^ m_(k-s)
+		for ( U32 k=degree; k < 32; k++ )
+		{
+			U32	value = m[k-degree] ^ (m[k-degree] << degree);
+			for ( U32 j=1; j < degree; j++ )
+				if ( (a >> (degree-1-j)) & 1 )
+					value ^= m[k-j] << j;
+			m[k] = value;
+		}
+
+		U32*	dimensionColumns = columns + 32 * dimension;
+		for ( U32 k=0; k < 32; k++ )
+			dimensionColumns[k] = m[k] << (31 - k);
+
+		// Move on to the next candidate
+		if ( ++a == (1U << (degree-1)) )
+		{
+			degree++;
+			a = 0;
+		}
+	}
+}
+
+U32	SobolSampler::SampleU32( U32 _index, U32 _dimension ) const
+{
+	ASSERT( _dimension < m_dimensionsCount, "Dimension out of range!" );
+	const U32*	columns = m_matrices.Ptr() + 32 * _dimension;
+	U32			value = 0;
+	for ( ; _index != 0; _index >>= 1, columns++ )
+		if ( _index & 1 )
+			value ^= *columns;
+
+	return value;
+}
+
+float	SobolSampler::Sample( U32 _index, U32 _dimension, U32 _seed ) const
+{
+	U32	index = Sampling::OwenScramble( _index, RandomStream::Mix32( _seed ) );
+	return Sampling::ToFloat( Sampling::OwenScramble( SampleU32( index, _dimension ), Sampling::HashCombine( _seed, _dimension ) ) );
+}
+
+void	SobolSampler::Sample( U32 _index, U32 _seed, float* _point ) const
+{
+	U32	index = Sampling::OwenScramble( _index, RandomStream::Mix32( _seed ) );
+	for ( U32 dimension=0; dimension < m_dimensionsCount; dimension++ )
+		_point[dimension] = Sampling::ToFloat( Sampling::OwenScramble( SampleU32( index, dimension ), Sampling::HashCombine( _seed, dimension ) ) );
+}
+
+// Computes the unscrambled values of 4 indices
+static inline __m128i	SobolU32x4( __m128i _indices, const U32* _columns )
+{
+	const __m128i	one = _mm_set1_epi32( 1 );
+	__m128i			value = _mm_setzero_si128();
+	for ( U32 k=0; k < 32; k++, _indices = _mm_srli_epi32( _indices, 1 ) )
+	{
+		__m128i	mask = _mm_sub_epi32( _mm_setzero_si128(), _mm_and_si128( _indices, one ) );
+		value = _mm_xor_si128( value, _mm_and_si128( mask, _mm_set1_epi32( _columns[k] ) ) );
+	}
+	return value;
+}
+
+void	SobolSampler::Sample( U32 _firstIndex, U32 _count, U32 _dimension, U32 _seed, float* _values ) const
+{
+	ASSERT( _dimension < m_dimensionsCount, "Dimension out of range!" );
+	const U32*	columns = m_matrices.Ptr() + 32 * _dimension;
+	U32			shuffleSeed = RandomStream::Mix32( _seed );
+	U32			dimensionSeed = Sampling::HashCombine( _seed, _dimension );
+	ForEachGroup( _firstIndex, _count, [&]( __m128i _indices, U32 _firstPoint, U32 _lanesCount )
+	{
+		__m128i	value = SobolU32x4( OwenScramble4( _indices, shuffleSeed ), columns );
+		Store( ToFloat4( OwenScramble4( value, dimensionSeed ) ), _lanesCount, _values + _firstPoint );
+	} );
+}
+
+void	SobolSampler::SamplePoints( U32 _firstIndex, U32 _count, U32 _seed, float* _points ) const
+{
+	U32	shuffleSeed = RandomStream::Mix32( _seed );
+	ForEachGroup( _firstIndex, _count, [&]( __m128i _indices, U32 _firstPoint, U32 _lanesCount )
+	{
+		__m128i	indices = OwenScramble4( _indices, shuffleSeed );
+		float*	target = _points + _firstPoint * m_dimensionsCount;
+		for ( U32 dimension=0; dimension < m_dimensionsCount; dimension++ )
+		{
+			__m128i	value = SobolU32x4( indices, m_matrices.Ptr() + 32 * dimension );
+			float	values[4];
+			_mm_storeu_ps( values, ToFloat4( OwenScramble4( value, Sampling::HashCombine( _seed, dimension ) ) ) );
+			for ( U32 lane=0; lane < _lanesCount; lane++ )
+				target[lane * m_dimensionsCount + dimension] = values[lane];
+		}
+	} );
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Rank-1 lattice
+//
+Rank1Lattice::Rank1Lattice( U32 _dimensionsCount, U32 _log2PointsCount )
+	: m_dimensionsCount( _dimensionsCount )
+	, m_log2PointsCount( _log2PointsCount )
+{
+	RELEASE_ASSERT( _dimensionsCount > 0 && _dimensionsCount <= MAX_DIMENSIONS, "Unsupported amount of dimensions!" );
+	RELEASE_ASSERT( _log2PointsCount > 0 && _log2PointsCount <= 24, "Unsupported amount of points!" );
+
+	const U32		pointsCount = 1U << _log2PointsCount;
+	const U32		mask = pointsCount - 1;
+	const double	rcpPointsCount = 1.0 / pointsCount;
+
+	// The candidate multipliers are odd and in [1,N/2[ since a and N-a give mirrored lattices of the same quality
+	//	The whole search is kept under 2^28 kernel evaluations (i.e. candidates * points * evaluated dimensions):
+	//	_ the weights decreasing in 1/j^2, the error is dominated by the first dimensions so the last ones are left out first,
+	//		as long as 16 candidates can be tried with at least 2 dimensions (the first component of g is always 1)
+	//	_ large lattices then only try a regularly spaced subset of the candidates
+	const U64	MAX_EVALUATIONS_COUNT = 1U << 28;
+	U32	allCandidatesCount = MAX( 1U, pointsCount >> 2 );
+	U32	evaluatedDimensionsCount = MIN( _dimensionsCount, MAX( 2U, U32( MAX_EVALUATIONS_COUNT / (U64( pointsCount ) * MIN( allCandidatesCount, 16U )) ) ) );
+	U32	candidatesCount = MIN( allCandidatesCount, MAX( 1U, U32( MAX_EVALUATIONS_COUNT / (U64( pointsCount ) * evaluatedDimensionsCount) ) ) );
+
+	double*		weights = new double[evaluatedDimensionsCount];
+	for ( U32 dimension=0; dimension < evaluatedDimensionsCount; dimension++ )
+		weights[dimension] = 2.0 * PI * PI / ((dimension+1.0) * (dimension+1.0));
+
+	List< double >	errors;
+	errors.SetCount( candidatesCount );
+	ThreadPool::Default().ParallelFor( candidatesCount, [&]( U32 _candidateIndex, U32 _threadIndex )
+	{
+		U32	a = 2 * U32( U64( _candidateIndex ) * allCandidatesCount / candidatesCount ) + 1;
+
+		U32*	generator = new U32[evaluatedDimensionsCount];
+		U32*	residues = new U32[evaluatedDimensionsCount];
+		for ( U32 dimension=0, g=1; dimension < evaluatedDimensionsCount; dimension++, g = U32( (U64( g ) * a) & mask ) )
+		{
+			generator[dimension] = g;
+			residues[dimension] = 0;
+		}
+
+		// P2 = -1 + 1/N Sum_k Prod_j( 1 + weight_j 2PI^2 B2( {k g_j / N} ) ) with the Bernoulli polynomial B2(x) = x^2 - x + 1/6
+		double	sum = 0.0;
+		for ( U32 k=0; k < pointsCount; k++ )
+		{
+			double	product = 1.0;
+			for ( U32 dimension=0; dimension < evaluatedDimensionsCount; dimension++ )
+			{
+				double	x = residues[dimension] * rcpPointsCount;
+				product *= 1.0 + weights[dimension] * (x * x - x + 1.0 / 6.0);
+				residues[dimension] = (residues[dimension] + generator[dimension]) & mask;
+			}
+			sum += product;
+		}
+		errors[_candidateIndex] = sum * rcpPointsCount - 1.0;
+
+		delete[] residues;
+		delete[] generator;
+	} );
+	delete[] weights;
+
+	U32	bestCandidate = 0;
+	for ( U32 candidateIndex=1; candidateIndex < candidatesCount; candidateIndex++ )
+		if ( errors[candidateIndex] < errors[bestCandidate] )
+			bestCandidate = candidateIndex;
+	U32	a = 2 * U32( U64( bestCandidate ) * allCandidatesCount / candidatesCount ) + 1;
+
+	m_generatingVector.SetCount( _dimensionsCount );
+	for ( U32 dimension=0, g=1; dimension < _dimensionsCount; dimension++, g = U32( (U64( g ) * a) & mask ) )
+		m_generatingVector[dimension] = g;
+}
+
+Rank1Lattice::Rank1Lattice( U32 _dimensionsCount, U32 _log2PointsCount, const U32* _generatingVector )
+	: m_dimensionsCount( _dimensionsCount )
+	, m_log2PointsCount( _log2PointsCount )
+{
+	RELEASE_ASSERT( _dimensionsCount > 0 && _dimensionsCount <= MAX_DIMENSIONS, "Unsupported amount of dimensions!" );
+	RELEASE_ASSERT( _log2PointsCount > 0 && _log2PointsCount <= 31, "Unsupported amount of points!" );
+
+	m_generatingVector.SetCount( _dimensionsCount );
+	for ( U32 dimension=0; dimension < _dimensionsCount; dimension++ )
+	{
+		ASSERT( _generatingVector[dimension] & 1, "The generating vector's components should be odd to get full 1D projections!" );
+		m_generatingVector[dimension] = _generatingVector[dimension];
+	}
+}
+
+float	Rank1Lattice::Sample( U32 _index, U32 _dimension, U32 _seed ) const
+{
+	ASSERT( _dimension < m_dimensionsCount, "Dimension out of range!" );
+	return Sampling::ToFloat( Sampling::ReverseBits( _index ) * m_generatingVector[_dimension] + Sampling::HashCombine( _seed, _dimension ) );
+}
+
+void	Rank1Lattice::Sample( U32 _index, U32 _seed, float* _point ) const
+{
+	U32	radicalInverse = Sampling::ReverseBits( _index );
+	for ( U32 dimension=0; dimension < m_dimensionsCount; dimension++ )
+		_point[dimension] = Sampling::ToFloat( radicalInverse * m_generatingVector[dimension] + Sampling::HashCombine( _seed, dimension ) );
+}
+
+void	Rank1Lattice::Sample( U32 _firstIndex, U32 _count, U32 _dimension, U32 _seed, float* _values ) const
+{
+	ASSERT( _dimension < m_dimensionsCount, "Dimension out of range!" );
+	__m128i	generator = _mm_set1_epi32( m_generatingVector[_dimension] );
+	__m128i	shift = _mm_set1_epi32( Sampling::HashCombine( _seed, _dimension ) );
+	ForEachGroup( _firstIndex, _count, [&]( __m128i _indices, U32 _firstPoint, U32 _lanesCount )
+	{
+		__m128i	value = _mm_add_epi32( SIMD::MulLo32( ReverseBits4( _indices ), generator ), shift );
+		Store( ToFloat4( value ), _lanesCount, _values + _firstPoint );
+	} );
+}
+
+void	Rank1Lattice::SamplePoints( U32 _firstIndex, U32 _count, U32 _seed, float* _points ) const
+{
+	ForEachGroup( _firstIndex, _count, [&]( __m128i _indices, U32 _firstPoint, U32 _lanesCount )
+	{
+		__m128i	radicalInverses = ReverseBits4( _indices );
+		float*	target = _points + _firstPoint * m_dimensionsCount;
+		for ( U32 dimension=0; dimension < m_dimensionsCount; dimension++ )
+		{
+			__m128i	value = _mm_add_epi32( SIMD::MulLo32( radicalInverses, _mm_set1_epi32( m_generatingVector[dimension] ) ), _mm_set1_epi32( Sampling::HashCombine( _seed, dimension ) ) );
+			float	values[4];
+			_mm_storeu_ps( values, ToFloat4( value ) );
+			for ( U32 lane=0; lane < _lanesCount; lane++ )
+				target[lane * m_dimensionsCount + dimension] = values[lane];
+		}
+	} );
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// Blue noise
+//
+
+// Maintains the energy of a binary pattern on a torus and the tightest cluster / largest void of each cell of pixels
+class	VoidAndClusterPattern
+{
+public:
+	U32			m_log2Size;
+	U32			m_mask;
+	U32			m_log2CellSize;
+	U32			m_cellsPerRow;
+	S32			m_radius;
+	List< float >	m_kernel;			// The 1D Gaussian, the 2D kernel being separable
+	List< float >	m_energy;
+	List< U8 >		m_ones;
+	U32			m_onesCount;
+	List< S32 >	m_cellTightestCluster;	// Index of the one with the largest energy in each cell, -1 if none
+	List< S32 >	m_cellLargestVoid;		// Index of the zero with the smallest energy in each cell, -1 if none
+
+public:
+	VoidAndClusterPattern( U32 _log2Size, float _sigma, RandomStream& _rng )
+	{
+		U32	size = 1U << _log2Size;
+		m_log2Size = _log2Size;
+		m_mask = size - 1;
+		m_log2CellSize = MIN( 3U, _log2Size );
+		m_cellsPerRow = size >> m_log2CellSize;
+
+		// Truncate the kernel where it falls under 1e-3 (i.e. exp( -r^2 / (2 sigma^2) ) = 1e-3), the window must not wrap onto itself
+		m_radius = MIN( S32( ceilf( _sigma * sqrtf( 2.0f * logf( 1000.0f ) ) ) ), S32( size - 1 ) / 2 );
+		m_kernel.SetCount( 2 * m_radius + 1 );
+		for ( S32 d=-m_radius; d <= m_radius; d++ )
+			m_kernel[m_radius + d] = expf( -0.5f * d * d / (_sigma * _sigma) );
+
+		// The energy starts with a tiny random value that breaks the ties between pixels too far from any one to get energy (e.g. when the pattern is very sparse)
+		m_energy.SetCount( size * size );
+		m_ones.SetCount( size * size );
+		for ( U32 i=0; i < size * size; i++ )
+		{
+			m_energy[i] = 1e-5f * _rng.NextFloat();
+			m_ones[i] = 0;
+		}
+		m_onesCount = 0;
+
+		m_cellTightestCluster.SetCount( m_cellsPerRow * m_cellsPerRow );
+		m_cellLargestVoid.SetCount( m_cellsPerRow * m_cellsPerRow );
+		for ( U32 cellY=0; cellY < m_cellsPerRow; cellY++ )
+			for ( U32 cellX=0; cellX < m_cellsPerRow; cellX++ )
+				UpdateCell( cellX, cellY );
+	}
+
+	void	Set( U32 _pixelIndex, bool _one )
+	{
+		ASSERT( m_ones[_pixelIndex] != U8(_one), "Pixel is already in that state!" );
+		m_ones[_pixelIndex] = _one;
+		if ( _one )
+			m_onesCount++;
+		else
+			m_onesCount--;
+
+		// Splat the kernel
+		S32	x = _pixelIndex & m_mask;
+		S32	y = _pixelIndex >> m_log2Size;
+		float	sign = _one ? 1.0f : -1.0f;
+		for ( S32 dy=-m_radius; dy <= m_radius; dy++ )
+		{
+			float*	row = m_energy.Ptr() + (((y + dy) & m_mask) << m_log2Size);
+			float	weight = sign * m_kernel[m_radius + dy];
+			for ( S32 dx=-m_radius; dx <= m_radius; dx++ )
+				row[(x + dx) & m_mask] += weight * m_kernel[m_radius + dx];
+		}
+
+		// Update the cells overlapped by the kernel
+		U32	cellSize = 1U << m_log2CellSize;
+		U32	left = (x - m_radius) & m_mask;
+		U32	top = (y - m_radius) & m_mask;
+		U32	cellsCountX = MIN( m_cellsPerRow, (((left & (cellSize-1)) + 2 * m_radius) >> m_log2CellSize) + 1 );
+		U32	cellsCountY = MIN( m_cellsPerRow, (((top & (cellSize-1)) + 2 * m_radius) >> m_log2CellSize) + 1 );
+		for ( U32 cellY=0; cellY < cellsCountY; cellY++ )
+			for ( U32 cellX=0; cellX < cellsCountX; cellX++ )
+				UpdateCell( ((left >> m_log2CellSize) + cellX) % m_cellsPerRow, ((top >> m_log2CellSize) + cellY) % m_cellsPerRow );
+	}
+
+	U32		FindTightestCluster() const
+	{
+		S32	best = -1;
+		for ( U32 cellIndex=0; cellIndex < m_cellTightestCluster.Count(); cellIndex++ )
+		{
+			S32	candidate = m_cellTightestCluster[cellIndex];
+			if ( candidate >= 0 && (best < 0 || m_energy[candidate] > m_energy[best]) )
+				best = candidate;
+		}
+		ASSERT( best >= 0, "No one in the pattern!" );
+		return best;
+	}
+
+	U32		FindLargestVoid() const
+	{
+		S32	best = -1;
+		for ( U32 cellIndex=0; cellIndex < m_cellLargestVoid.Count(); cellIndex++ )
+		{
+			S32	candidate = m_cellLargestVoid[cellIndex];
+			if ( candidate >= 0 && (best < 0 || m_energy[candidate] < m_energy[best]) )
+				best = candidate;
+		}
+		ASSERT( best >= 0, "No zero in the pattern!" );
+		return best;
+	}
+
+private:
+	void	UpdateCell( U32 _cellX, U32 _cellY )
+	{
+		U32	cellSize = 1U << m_log2CellSize;
+		S32	tightestCluster = -1;
+		S32	largestVoid = -1;
+		for ( U32 y=0; y < cellSize; y++ )
+		{
+			U32	pixelIndex = (((_cellY << m_log2CellSize) + y) << m_log2Size) + (_cellX << m_log2CellSize);
+			for ( U32 x=0; x < cellSize; x++, pixelIndex++ )
+			{
+				if ( m_ones[pixelIndex] )
+				{
+					if ( tightestCluster < 0 || m_energy[pixelIndex] > m_energy[tightestCluster] )
+						tightestCluster = pixelIndex;
+				}
+				else if ( largestVoid < 0 || m_energy[pixelIndex] < m_energy[largestVoid] )
+					largestVoid = pixelIndex;
+			}
+		}
+		U32	cellIndex = _cellY * m_cellsPerRow + _cellX;
+		m_cellTightestCluster[cellIndex] = tightestCluster;
+		m_cellLargestVoid[cellIndex] = largestVoid;
+	}
+};
+
+BlueNoiseTile::BlueNoiseTile( U32 _log2Size, U32 _seed, float _sigma )
+	: m_log2Size( _log2Size )
+{
+	RELEASE_ASSERT( _log2Size >= 2 && _log2Size <= 8, "Unsupported tile size!" );
+
+	U32	pixelsCount = 1U << (2 * _log2Size);
+	m_ranks.SetCount( pixelsCount );
+
+	// Initial random pattern with 10% of ones
+	RandomStream			rng( _seed );
+	VoidAndClusterPattern	pattern( _log2Size, _sigma, rng );
+	U32	initialOnesCount = MAX( 1U, pixelsCount / 10 );
+	while ( pattern.m_onesCount < initialOnesCount )
+	{
+		U32	pixelIndex = rng.NextU32( pixelsCount );
+		if ( !pattern.m_ones[pixelIndex] )
+			pattern.Set( pixelIndex, true );
+	}
+
+	// Relax it into the prototype pattern by moving the tightest cluster into the largest void until it doesn't change anymore
+	for ( U32 iteration=0; iteration < pixelsCount; iteration++ )
+	{
+		U32	tightestCluster = pattern.FindTightestCluster();
+		pattern.Set( tightestCluster, false );
+		U32	largestVoid = pattern.FindLargestVoid();
+		pattern.Set( largestVoid, true );
+		if ( largestVoid == tightestCluster )
+			break;
+	}
+	VoidAndClusterPattern	prototype = pattern;
+
+	// Phase 1: rank the ones of the prototype by removing the tightest clusters
+	while ( pattern.m_onesCount > 0 )
+	{
+		U32	tightestCluster = pattern.FindTightestCluster();
+		pattern.Set( tightestCluster, false );
+		m_ranks[tightestCluster] = pattern.m_onesCount;
+	}
+
+	// Phases 2 and 3: rank the zeros of the prototype by filling the largest voids
+	//	(Ulichney switches to the tightest clusters of zeros past half the pixels, but since the kernel sums to a constant it is the same as the largest void of ones)
+	pattern = prototype;
+	while ( pattern.m_onesCount < pixelsCount )
+	{
+		U32	largestVoid = pattern.FindLargestVoid();
+		m_ranks[largestVoid] = pattern.m_onesCount;
+		pattern.Set( largestVoid, true );
+	}
+}
+
+float	BlueNoiseTile::Sample( U32 _x, U32 _y, U32 _dimension ) const
+{
+	// Offset the tile and rotate the 32-bits fixed point threshold by the golden ratio
+	U32	offset = _dimension > 0 ? RandomStream::Mix32( _dimension ) : 0;
+	U32	rank = GetRank( _x + offset, _y + (offset >> 16) );
+	U32	shift = 32 - 2 * m_log2Size;
+	return Sampling::ToFloat( (rank << shift) + (1U << (shift-1)) + _dimension * 0x9E3779B9U );
+}
+
+void	BlueNoiseTile::GetThresholds( U32 _dimension, float* _thresholds ) const
+{
+	U32	size = GetSize();
+	U32	mask = size - 1;
+	U32	offset = _dimension > 0 ? RandomStream::Mix32( _dimension ) : 0;
+	U32	shift = 32 - 2 * m_log2Size;
+	__m128i	bias = _mm_set1_epi32( (1U << (shift-1)) + _dimension * 0x9E3779B9U );
+	__m128i	shiftCount = _mm_cvtsi32_si128( shift );
+	for ( U32 y=0; y < size; y++ )
+	{
+		const U32*	row = m_ranks.Ptr() + (((y + (offset >> 16)) & mask) << m_log2Size);
+		for ( U32 x=0; x < size; x+=4 )
+		{
+			__m128i	ranks = _mm_setr_epi32( row[(x + offset) & mask], row[(x + 1 + offset) & mask], row[(x + 2 + offset) & mask], row[(x + 3 + offset) & mask] );
+			_mm_storeu_ps( _thresholds + (y << m_log2Size) + x, ToFloat4( _mm_add_epi32( _mm_sll_epi32( ranks, shiftCount ), bias ) ) );
+		}
+	}
+}
@@ -0,0 +1,171 @@
+//////////////////////////////////////////////////////////////////////////
+// Sample generators for integrators
+//
+// All the samplers are stateless once built: a sample is a pure function of its index, its dimension and a seed,
+//	so samples can be drawn in any order and from any thread, and per-pixel decorrelation is simply a matter of
+//	using a different seed for each pixel (e.g. RandomStream::Mix32() of the pixel index).
+// Generation is O(1) per sample (i.e. it doesn't depend on the index) and batches of 4 samples are computed at once with SSE.
+//
+//	- SobolSampler, Owen-scrambled Sobol' sequence in up to 1024 dimensions.
+//		Any aligned block of 2^k samples is a (t,k,s)-net, the sequence can thus be used progressively.
+//	- Rank1Lattice, extensible rank-1 lattice in base 2 with a Cranley-Patterson rotation per seed.
+//		Cheaper than Sobol' (a single multiply per value) and very good for smooth periodic integrands.
+//	- BlueNoiseTile, toroidal tile of ranks built with the void-and-cluster algorithm.
+//		Used as dither thresholds or to decorrelate the other sequences across neighbor pixels with a visually pleasing error distribution.
+//
+// The existing Hammersley generator in Random.h is kept as-is for the existing code.
+//
+#pragma once
+
+namespace BaseLib {
+
+	namespace Sampling {
+
+		inline U32		ReverseBits( U32 _bits ) {
+			_bits = (_bits << 16) | (_bits >> 16);
+			_bits = ((_bits & 0x00FF00FFU) << 8) | ((_bits & 0xFF00FF00U) >> 8);
+			_bits = ((_bits & 0x0F0F0F0FU) << 4) | ((_bits & 0xF0F0F0F0U) >> 4);
+			_bits = ((_bits & 0x33333333U) << 2) | ((_bits & 0xCCCCCCCCU) >> 2);
+			return ((_bits & 0x55555555U) << 1) | ((_bits & 0xAAAAAAAAU) >> 1);
+		}
+
+		// Hash-based Owen scrambling of a 32-bits fixed point value from "Practical Hash-based Owen Scrambling", B. Burley (2020)
+		//	Each bit is flipped depending on the seed and the bits above it, which is a nested uniform scramble (although not a fully random one)
+		inline U32		OwenScramble( U32 _x, U32 _seed ) {
+			_x = ReverseBits( _x );
+			_x += _seed;
+			_x ^= _x * 0x6C50B47CU;
+			_x ^= _x * 0xB82F1E52U;
+			_x ^= _x * 0xC7AFE638U;
+			_x ^= _x * 0x8D22F6E6U;
+			return ReverseBits( _x );
+		}
+
+		// Derives a new seed from a seed and a value (e.g. a dimension index)
+		inline U32		HashCombine( U32 _seed, U32 _value ) {
+			return RandomStream::Mix32( _seed ^ RandomStream::Mix32( _value + 0x9E3779B9U ) );
+		}
+
+		// Converts a 32-bits fixed point value into a float in [0,1[ (the 24 upper bits are used so the conversion is exact)
+		inline float	ToFloat( U32 _x ) {
+			return (_x >> 8) * (1.0f / 16777216.0f);
+		}
+	}
+
+	//////////////////////////////////////////////////////////////////////////
+	// Owen-scrambled Sobol' sequence
+	// The direction numbers of the first 37 dimensions are the ones from S. Joe and F. Kuo's "new-joe-kuo-6.21201" table,
+	//	the following dimensions use the next primitive polynomials with random initial direction numbers (i.e. worse 2D projections, mostly hidden by the scrambling).
+	//
+	// Following Burley, the seed scrambles each dimension independently and also shuffles the order of the points
+	//	(the shuffle keeps aligned blocks of 2^k indices together so progressive use still yields nets)
+	//
+	class	SobolSampler {
+	public:
+		static const U32	MAX_DIMENSIONS = 1024;
+
+	public:
+		SobolSampler( U32 _dimensionsCount );
+
+		U32		GetDimensionsCount() const	{ return m_dimensionsCount; }
+
+		// Gets the raw unscrambled sample as a 32-bits fixed point value
+		U32		SampleU32( U32 _index, U32 _dimension ) const;
+
+		// Gets a scrambled sample in [0,1[
+		float	Sample( U32 _index, U32 _dimension, U32 _seed ) const;
+
+		// Gets all the dimensions of a scrambled point
+		void	Sample( U32 _index, U32 _seed, float* _point ) const;
+
+		// Gets a single dimension of the _count points starting at _firstIndex
+		void	Sample( U32 _firstIndex, U32 _count, U32 _dimension, U32 _seed, float* _values ) const;
+
+		// Gets all the dimensions of the _count points starting at _firstIndex (i.e. _count * GetDimensionsCount() values, point after point)
+		//	Large batches are spread across the default thread pool
+		void	SamplePoints( U32 _firstIndex, U32 _count, U32 _seed, float* _points ) const;
+
+	private:
+		U32			m_dimensionsCount;
+		List< U32 >	m_matrices;			// The 32 generator matrix columns of each dimension, the column for index bit 0 first
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// Extensible rank-1 lattice in base 2
+	// Point i is frac( radicalInverse(i) * g + shift ) with g the generating vector of integers and shift a random offset per seed and dimension.
+	// Ordering the points by radical inverse makes the lattice extensible: any aligned block of 2^k points is a rank-1 lattice of 2^k points too,
+	//	so the lattice can be used progressively up to GetPointsCount() points (indices beyond keep producing points of finer lattices).
+	//
+	class	Rank1Lattice {
+	public:
+		static const U32	MAX_DIMENSIONS = 1024;
+
+	public:
+		// Builds a Korobov generating vector g = (1, a, a^2, ...) mod 2^_log2PointsCount, searching the multiplier a that minimizes the
+		//	worst-case integration error in the weighted Korobov space (i.e. the P2 criterion with product weights 1/j^2)
+		//	The search costs O(candidates * points * dimensions) and is spread across the default thread pool, it is kept under 2^28 by
+		//	only evaluating the first dimensions of many-dimensional lattices and reducing the amount of candidates for large ones (_log2PointsCount in [1,24])
+		Rank1Lattice( U32 _dimensionsCount, U32 _log2PointsCount );
+
+		// Uses a known generating vector of _dimensionsCount odd integers (e.g. from published tables, _log2PointsCount in [1,31])
+		Rank1Lattice( U32 _dimensionsCount, U32 _log2PointsCount, const U32* _generatingVector );
+
+		U32		GetDimensionsCount() const		{ return m_dimensionsCount; }
+		U32		GetPointsCount() const			{ return 1U << m_log2PointsCount; }
+		const U32*	GetGeneratingVector() const	{ return m_generatingVector.Ptr(); }
+
+		// Gets a shifted sample in [0,1[
+		float	Sample( U32 _index, U32 _dimension, U32 _seed ) const;
+
+		// Gets all the dimensions of a shifted point
+		void	Sample( U32 _index, U32 _seed, float* _point ) const;
+
+		// Gets a single dimension of the _count points starting at _firstIndex
+		void	Sample( U32 _firstIndex, U32 _count, U32 _dimension, U32 _seed, float* _values ) const;
+
+		// Gets all the dimensions of the _count points starting at _firstIndex (i.e. _count * GetDimensionsCount() values, point after point)
+		void	SamplePoints( U32 _firstIndex, U32 _count, U32 _seed, float* _points ) const;
+
+	private:
+		U32			m_dimensionsCount;
+		U32			m_log2PointsCount;
+		List< U32 >	m_generatingVector;		// The radical inverse of an index < 2^m being a multiple of 2^(32-m), the products with g are directly 32-bits fixed point coordinates
+	};
+
+	//////////////////////////////////////////////////////////////////////////
+	// Blue noise tile built with the void-and-cluster algorithm from "The void-and-cluster method for dither array generation", R. Ulichney (1993)
+	// The tile stores a rank in [0,size^2[ per pixel, thresholding the ranks at any level gives a blue noise pattern that tiles seamlessly.
+	//
+	// The energy of the patterns is maintained incrementally with a Gaussian kernel truncated where it falls under 1e-3, and the tightest cluster
+	//	and largest void are tracked per cell of 8x8 pixels so each of the size^2 steps only updates a few cells instead of scanning the whole tile.
+	//
+	class	BlueNoiseTile {
+	public:
+		// Builds a tile of 2^_log2Size x 2^_log2Size pixels (_log2Size in [2,8])
+		//	_seed selects the initial random pattern
+		//	_sigma is the standard deviation of the energy kernel in pixels, Ulichney's 1.5 keeps the sparse levels free of adjacent pixels
+		//		while larger values slightly improve the mid-tones at the cost of a few clumps in the sparse levels
+		BlueNoiseTile( U32 _log2Size, U32 _seed, float _sigma=1.5f );
+
+		U32			GetSize() const				{ return 1U << m_log2Size; }
+		const U32*	GetRanks() const			{ return m_ranks.Ptr(); }	// Row-major ranks
+
+		// Gets the rank of a pixel, the coordinates wrap around
+		U32		GetRank( U32 _x, U32 _y ) const	{ U32 mask = GetSize() - 1; return m_ranks[((_y & mask) << m_log2Size) + (_x & mask)]; }
+
+		// Gets the dither threshold of a pixel in ]0,1[
+		float	Sample( U32 _x, U32 _y ) const	{ return (GetRank( _x, _y ) + 0.5f) / m_ranks.Count(); }
+
+		// Gets a different threshold for each dimension (or frame) of the same pixel
+		//	The tile is offset by a hash of the dimension and the threshold is rotated by the golden ratio, so each dimension is blue noise
+		//	on its own while successive dimensions of a pixel are well distributed too
+		float	Sample( U32 _x, U32 _y, U32 _dimension ) const;
+
+		// Fills the size^2 row-major thresholds of a dimension (same as calling Sample( x, y, _dimension ) for every pixel)
+		void	GetThresholds( U32 _dimension, float* _thresholds ) const;
+
+	private:
+		U32			m_log2Size;
+		List< U32 >	m_ranks;
+	};
+}
@@ -218,6 +218,10 @@ PIXEL_FORMAT	BaseLib::DXGIFormat2PixelFormat( DXGI_FORMAT _sourceFormat, COMPONE
 }
 
 DXGI_FORMAT	BaseLib::PixelFormat2DXGIFormat( PIXEL_FORMAT _sourceFormat, COMPONENT_FORMAT _componentFormat ) {
+	// Uncompressed formats may be flagged as raw buffers when they're directly mapped from a DDS file
+	if ( (U32(_sourceFormat) & U32(PIXEL_FORMAT::COMPRESSED)) == 0 )
+		_sourceFormat = PIXEL_FORMAT( U32(_sourceFormat) & ~U32(PIXEL_FORMAT::RAW_BUFFER) );
+
 	switch ( _sourceFormat ) {
 		// 8-bits formats
 		case PIXEL_FORMAT::R8:
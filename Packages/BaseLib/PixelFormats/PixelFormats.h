@@ -655,53 +655,21 @@ namespace BaseLib {
 		} Descriptor;
 		#pragma endregion
 
+		// The 11 and 10 bits floats are simply half floats stripped of their sign and of their 4 or 5 least significant mantissa bits
 		void	EncodeColor( float _R, float _G, float _B ) {
-			U8	exponent, mantissa;
-			EncodeValue( _R, exponent, mantissa );
-			R = (exponent << 6) | mantissa;
-			EncodeValue( _G, exponent, mantissa );
-			G = (exponent << 6) | mantissa;
-			EncodeValue( _B, exponent, mantissa );
-			B = (exponent << 5) | (mantissa >> 1);
+			R = half( MAX( _R, 0.0f ) ).raw >> 4;
+			G = half( MAX( _G, 0.0f ) ).raw >> 4;
+			B = half( MAX( _B, 0.0f ) ).raw >> 5;
 		}
 
 		void	DecodedColor( bfloat3& _HDRColor ) {
-// Strangely enough, this line doesn't return the correct values!
-//			_HDRColor.Set( DecodeValue( R >> 6, R & 0x3F ), DecodeValue( G >> 6, G & 0x3F ), DecodeValue( B >> 5, (B & 0x1F) << 1 ) );
-
-// But decomposing into these 3 distinct calls does... :/
-			U8	exponent, mantissa;
-			exponent = R >> 6;
-			mantissa = R & 0x3F;
-			_HDRColor.x = DecodeValue( exponent, mantissa );
-			exponent = G >> 6;
-			mantissa = G & 0x3F;
-			_HDRColor.y = DecodeValue( exponent, mantissa );
-			exponent = B >> 5;
-			mantissa = (B & 0x1F) << 1;
-			_HDRColor.z = DecodeValue( exponent, mantissa );
-		}
-
-	private:
-		void	EncodeValue( float _value, U8& _exponent, U8& _mantissa ) {
-throw "Encoding is wrong! FIX! Be careful about compiler failing to recompile changes for some reason!";
-			U32		exponent = U32( ceilf( log2f( _value ) ) );
-			float	mantissa = _value / float(1 << exponent);
-			if ( mantissa == 1.0f ) {
-				// Step to next order
-				mantissa = 0.5f;
-				exponent++;
-			}
-			_exponent = MIN( 63U, U32( 15 + exponent ) );
-			_mantissa = MIN( 63U, U32( 64.0f * mantissa ) );
-		}
-
-		float	DecodeValue( U8 _exponent, U8 _mantissa ) {
-throw "Decoding is wrong! FIX! Be careful about compiler failing to recompile changes for some reason!";
-			float	exponent = _exponent < 15 ? 1.0f / (1 << (15-_exponent)) : (1 << (_exponent - 15));
-			float	mantissa = _mantissa / 64.0f;
-			float	result = mantissa * exponent;
-			return result;
+			half	temp;
+			temp.raw = U16( R << 4 );
+			_HDRColor.x = temp;
+			temp.raw = U16( G << 4 );
+			_HDRColor.y = temp;
+			temp.raw = U16( B << 5 );
+			_HDRColor.z = temp;
 		}
 	};
 
@@ -0,0 +1,523 @@
+#include "stdafx.h"
+#include "PixelSpans.h"
+#include "../Math/SIMD.h"
+
+using namespace BaseLib;
+
+namespace {
+
+	const __m128	ZERO = _mm_setzero_ps();
+	const __m128	ONE = _mm_set1_ps( 1.0f );
+	const __m128	MASK_W = _mm_castsi128_ps( _mm_set_epi32( -1, 0, 0, 0 ) );
+	const __m128	ZERO_ONE = _mm_set_ps( 0.0f, 0.0f, 1.0f, 0.0f );	// (0,1) in the 2 low lanes, used to complete RG colors with B=0 and A=1
+
+	//////////////////////////////////////////////////////////////////////////
+	// Component helpers
+	// They must perform the exact same operations as the IPixelAccessor helpers so spans stay bit-exact with single pixel accesses
+	//
+
+	// Completes a color with A=1
+	inline __m128	RGB1( __m128 _color )		{ return SIMD::Select( MASK_W, ONE, _color ); }
+	// Completes a color with B=0 and A=1
+	inline __m128	RG01( __m128 _color )		{ return _mm_movelh_ps( _color, ZERO_ONE ); }
+	// Swaps the R and B components
+	inline __m128	SwapRB( __m128 _color )		{ return _mm_shuffle_ps( _color, _color, _MM_SHUFFLE( 3, 0, 1, 2 ) ); }
+
+	// Stores 4 grayscale values as 4 (V,V,V,1) colors
+	inline void		StoreGray( __m128 _values, bfloat4* _colors ) {
+		_mm_storeu_ps( &_colors[0].x, RGB1( _mm_shuffle_ps( _values, _values, _MM_SHUFFLE( 0, 0, 0, 0 ) ) ) );
+		_mm_storeu_ps( &_colors[1].x, RGB1( _mm_shuffle_ps( _values, _values, _MM_SHUFFLE( 1, 1, 1, 1 ) ) ) );
+		_mm_storeu_ps( &_colors[2].x, RGB1( _mm_shuffle_ps( _values, _values, _MM_SHUFFLE( 2, 2, 2, 2 ) ) ) );
+		_mm_storeu_ps( &_colors[3].x, RGB1( _mm_shuffle_ps( _values, _values, _MM_SHUFFLE( 3, 3, 3, 3 ) ) ) );
+	}
+
+	// Gathers the red components of 4 colors
+	inline __m128	LoadRed( const bfloat4* _colors ) {
+		__m128	R, G, B, A;
+		SIMD::LoadSoA( _colors, R, G, B, A );
+		return R;
+	}
+
+	// UNORM8 <-> F32
+	inline __m128	U8toF32( __m128i _components ) {
+		return _mm_div_ps( _mm_cvtepi32_ps( _components ), _mm_set1_ps( 255.0f ) );
+	}
+	inline __m128	U8x4toF32( U32 _packed ) {
+		__m128i	v = _mm_unpacklo_epi8( _mm_cvtsi32_si128( int(_packed) ), _mm_setzero_si128() );
+		return U8toF32( _mm_unpacklo_epi16( v, _mm_setzero_si128() ) );
+	}
+	inline __m128i	F32toU8( __m128 _components ) {
+		return _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( ZERO, _mm_mul_ps( _components, _mm_set1_ps( 255.0f ) ) ), _mm_set1_ps( 255.0f ) ) );
+	}
+	inline U32		F32toU8x4( __m128 _components ) {
+		__m128i	v = F32toU8( _components );
+				v = _mm_packs_epi32( v, v );
+				v = _mm_packus_epi16( v, v );
+		return U32( _mm_cvtsi128_si32( v ) );
+	}
+
+	// UNORM16 <-> F32
+	inline __m128	U16toF32( __m128i _components ) {
+		return _mm_div_ps( _mm_cvtepi32_ps( _mm_unpacklo_epi16( _components, _mm_setzero_si128() ) ), _mm_set1_ps( 65535.0f ) );
+	}
+	inline __m128i	F32toU16( __m128 _components ) {
+		__m128i	v = _mm_cvttps_epi32( _mm_min_ps( _mm_max_ps( ZERO, _mm_mul_ps( _components, _mm_set1_ps( 65535.0f ) ) ), _mm_set1_ps( 65535.0f ) ) );
+		return SIMD::PackU16( v, v );
+	}
+
+	// F16 <-> F32
+	inline __m128	F16toF32( __m128i _components ) {
+		return SIMD::HalfToFloat( _mm_unpacklo_epi16( _components, _mm_setzero_si128() ) );
+	}
+	inline __m128i	F32toF16( __m128 _components ) {
+		__m128i	v = SIMD::FloatToHalf( _components );
+		return SIMD::PackU16( v, v );
+	}
+
+	// Loads 3 U16 without reading past the pixel
+	inline __m128i	LoadU16x3( const U16* _components ) {
+		return _mm_insert_epi16( _mm_cvtsi32_si128( *((const int*) _components) ), _components[2], 2 );
+	}
+	// Stores 3 U16 without writing past the pixel
+	inline void		StoreU16x3( __m128i _components, U16* _target ) {
+		*((int*) _target) = _mm_cvtsi128_si32( _components );
+		_target[2] = U16( _mm_extract_epi16( _components, 2 ) );
+	}
+
+	// Scalar codecs used for the remaining pixels of a span
+	template< typename PF >
+	void	DecodePixels( const void* _pixels, bfloat4* _colors, U32 _count ) {
+		const PF*	pixel = (const PF*) _pixels;
+		for ( ; _count > 0; _count--, pixel++, _colors++ )
+			PF::Descriptor.desc_t::RGBA( pixel, *_colors );
+	}
+	template< typename PF >
+	void	EncodePixels( const bfloat4* _colors, void* _pixels, U32 _count ) {
+		PF*	pixel = (PF*) _pixels;
+		for ( ; _count > 0; _count--, pixel++, _colors++ )
+			PF::Descriptor.desc_t::Write( pixel, *_colors );
+	}
+
+	void	DecodeNothing( const void* _pixels, bfloat4* _colors, U32 _count ) {}
+	void	EncodeNothing( const bfloat4* _colors, void* _pixels, U32 _count ) {}
+}
+
+#pragma region 8-Bits Formats
+
+template<> void	BaseLib::DecodeSpan<PF_R8>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U8*	pixel = (const U8*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 )
+		StoreGray( U8x4toF32( *((const U32*) pixel) ), _colors );
+	DecodePixels<PF_R8>( pixel, _colors, _count );
+}
+template<> void	BaseLib::EncodeSpan<PF_R8>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U8*	pixel = (U8*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 )
+		*((U32*) pixel) = F32toU8x4( LoadRed( _colors ) );
+	EncodePixels<PF_R8>( _colors, pixel, _count );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RG8>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U16*	pixel = (const U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel++, _colors++ )
+		_mm_storeu_ps( &_colors->x, RG01( U8x4toF32( *pixel ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RG8>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U16*	pixel = (U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel++, _colors++ )
+		*pixel = U16( F32toU8x4( _mm_loadu_ps( &_colors->x ) ) );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGB8>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U8*	pixel = (const U8*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ )
+		_mm_storeu_ps( &_colors->x, RGB1( U8x4toF32( pixel[0] | (pixel[1] << 8) | (pixel[2] << 16) ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGB8>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U8*	pixel = (U8*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ ) {
+		U32	RGB = F32toU8x4( _mm_loadu_ps( &_colors->x ) );
+		pixel[0] = U8( RGB );
+		pixel[1] = U8( RGB >> 8 );
+		pixel[2] = U8( RGB >> 16 );
+	}
+}
+
+template<> void	BaseLib::DecodeSpan<PF_BGR8>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U8*	pixel = (const U8*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ )
+		_mm_storeu_ps( &_colors->x, RGB1( SwapRB( U8x4toF32( pixel[0] | (pixel[1] << 8) | (pixel[2] << 16) ) ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_BGR8>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U8*	pixel = (U8*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ ) {
+		U32	BGR = F32toU8x4( SwapRB( _mm_loadu_ps( &_colors->x ) ) );
+		pixel[0] = U8( BGR );
+		pixel[1] = U8( BGR >> 8 );
+		pixel[2] = U8( BGR >> 16 );
+	}
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGBA8>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U8*	pixel = (const U8*) _pixels;
+	const __m128i	zero = _mm_setzero_si128();
+	for ( ; _count >= 4; _count-=4, pixel+=16, _colors+=4 ) {
+		__m128i	v = _mm_loadu_si128( (const __m128i*) pixel );
+		__m128i	lo = _mm_unpacklo_epi8( v, zero );
+		__m128i	hi = _mm_unpackhi_epi8( v, zero );
+		_mm_storeu_ps( &_colors[0].x, U8toF32( _mm_unpacklo_epi16( lo, zero ) ) );
+		_mm_storeu_ps( &_colors[1].x, U8toF32( _mm_unpackhi_epi16( lo, zero ) ) );
+		_mm_storeu_ps( &_colors[2].x, U8toF32( _mm_unpacklo_epi16( hi, zero ) ) );
+		_mm_storeu_ps( &_colors[3].x, U8toF32( _mm_unpackhi_epi16( hi, zero ) ) );
+	}
+	for ( ; _count > 0; _count--, pixel+=4, _colors++ )
+		_mm_storeu_ps( &_colors->x, U8x4toF32( *((const U32*) pixel) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGBA8>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U8*	pixel = (U8*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=16, _colors+=4 ) {
+		__m128i	v01 = _mm_packs_epi32( F32toU8( _mm_loadu_ps( &_colors[0].x ) ), F32toU8( _mm_loadu_ps( &_colors[1].x ) ) );
+		__m128i	v23 = _mm_packs_epi32( F32toU8( _mm_loadu_ps( &_colors[2].x ) ), F32toU8( _mm_loadu_ps( &_colors[3].x ) ) );
+		_mm_storeu_si128( (__m128i*) pixel, _mm_packus_epi16( v01, v23 ) );
+	}
+	for ( ; _count > 0; _count--, pixel+=4, _colors++ )
+		*((U32*) pixel) = F32toU8x4( _mm_loadu_ps( &_colors->x ) );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_BGRA8>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U8*	pixel = (const U8*) _pixels;
+	const __m128i	zero = _mm_setzero_si128();
+	for ( ; _count >= 4; _count-=4, pixel+=16, _colors+=4 ) {
+		__m128i	v = _mm_loadu_si128( (const __m128i*) pixel );
+		__m128i	lo = _mm_unpacklo_epi8( v, zero );
+		__m128i	hi = _mm_unpackhi_epi8( v, zero );
+		_mm_storeu_ps( &_colors[0].x, SwapRB( U8toF32( _mm_unpacklo_epi16( lo, zero ) ) ) );
+		_mm_storeu_ps( &_colors[1].x, SwapRB( U8toF32( _mm_unpackhi_epi16( lo, zero ) ) ) );
+		_mm_storeu_ps( &_colors[2].x, SwapRB( U8toF32( _mm_unpacklo_epi16( hi, zero ) ) ) );
+		_mm_storeu_ps( &_colors[3].x, SwapRB( U8toF32( _mm_unpackhi_epi16( hi, zero ) ) ) );
+	}
+	for ( ; _count > 0; _count--, pixel+=4, _colors++ )
+		_mm_storeu_ps( &_colors->x, SwapRB( U8x4toF32( *((const U32*) pixel) ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_BGRA8>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U8*	pixel = (U8*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=16, _colors+=4 ) {
+		__m128i	v01 = _mm_packs_epi32( F32toU8( SwapRB( _mm_loadu_ps( &_colors[0].x ) ) ), F32toU8( SwapRB( _mm_loadu_ps( &_colors[1].x ) ) ) );
+		__m128i	v23 = _mm_packs_epi32( F32toU8( SwapRB( _mm_loadu_ps( &_colors[2].x ) ) ), F32toU8( SwapRB( _mm_loadu_ps( &_colors[3].x ) ) ) );
+		_mm_storeu_si128( (__m128i*) pixel, _mm_packus_epi16( v01, v23 ) );
+	}
+	for ( ; _count > 0; _count--, pixel+=4, _colors++ )
+		*((U32*) pixel) = F32toU8x4( SwapRB( _mm_loadu_ps( &_colors->x ) ) );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGBE>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U8*	pixel = (const U8*) _pixels;
+	const __m128i	mask = _mm_set1_epi32( 0xFF );
+	const __m128	bias = _mm_set1_ps( 0.5f );
+	for ( ; _count >= 4; _count-=4, pixel+=16, _colors+=4 ) {
+		__m128i	v = _mm_loadu_si128( (const __m128i*) pixel );
+		__m128	B = _mm_add_ps( _mm_cvtepi32_ps( _mm_and_si128( v, mask ) ), bias );
+		__m128	G = _mm_add_ps( _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 8 ), mask ) ), bias );
+		__m128	R = _mm_add_ps( _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 16 ), mask ) ), bias );
+
+		// 2^(E-136) is split into 2 normalized factors so we get the same single rounding as the scalar path even for tiny exponents
+		__m128i	E = _mm_srli_epi32( v, 24 );
+		__m128i	E0 = _mm_srli_epi32( E, 1 );
+		__m128i	E1 = _mm_sub_epi32( E, E0 );
+		__m128	scale0 = _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( E0, _mm_set1_epi32( 127 - 68 ) ), 23 ) );
+		__m128	scale1 = _mm_castsi128_ps( _mm_slli_epi32( _mm_add_epi32( E1, _mm_set1_epi32( 127 - 68 ) ), 23 ) );
+
+		R = _mm_mul_ps( _mm_mul_ps( R, scale0 ), scale1 );
+		G = _mm_mul_ps( _mm_mul_ps( G, scale0 ), scale1 );
+		B = _mm_mul_ps( _mm_mul_ps( B, scale0 ), scale1 );
+		SIMD::StoreAoS( R, G, B, ONE, _colors );
+	}
+	DecodePixels<PF_RGBE>( pixel, _colors, _count );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGB10A2>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U32*	pixel = (const U32*) _pixels;
+	const __m128i	mask = _mm_set1_epi32( 0x3FF );
+	const __m128	scale = _mm_set1_ps( 1023.0f );
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 ) {
+		__m128i	v = _mm_loadu_si128( (const __m128i*) pixel );
+		__m128	R = _mm_div_ps( _mm_cvtepi32_ps( _mm_and_si128( v, mask ) ), scale );
+		__m128	G = _mm_div_ps( _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 10 ), mask ) ), scale );
+		__m128	B = _mm_div_ps( _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 20 ), mask ) ), scale );
+		SIMD::StoreAoS( R, G, B, ONE, _colors );
+	}
+	DecodePixels<PF_RGB10A2>( pixel, _colors, _count );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGB10A2>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U32*	pixel = (U32*) _pixels;
+	const __m128	scale = _mm_set1_ps( 1023.0f );
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 ) {
+		__m128	R, G, B, A;
+		SIMD::LoadSoA( _colors, R, G, B, A );
+		__m128i	iR = _mm_cvttps_epi32( _mm_mul_ps( scale, _mm_min_ps( _mm_max_ps( R, ZERO ), ONE ) ) );
+		__m128i	iG = _mm_cvttps_epi32( _mm_mul_ps( scale, _mm_min_ps( _mm_max_ps( G, ZERO ), ONE ) ) );
+		__m128i	iB = _mm_cvttps_epi32( _mm_mul_ps( scale, _mm_min_ps( _mm_max_ps( B, ZERO ), ONE ) ) );
+		__m128i	v = _mm_or_si128( _mm_or_si128( iR, _mm_slli_epi32( iG, 10 ) ), _mm_or_si128( _mm_slli_epi32( iB, 20 ), _mm_set1_epi32( 3 << 30 ) ) );
+		_mm_storeu_si128( (__m128i*) pixel, v );
+	}
+	EncodePixels<PF_RGB10A2>( _colors, pixel, _count );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_R11G11B10>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U32*	pixel = (const U32*) _pixels;
+	const __m128i	mask = _mm_set1_epi32( 0x7FF );
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 ) {
+		__m128i	v = _mm_loadu_si128( (const __m128i*) pixel );
+		__m128	R = SIMD::HalfToFloat( _mm_slli_epi32( _mm_and_si128( v, mask ), 4 ) );
+		__m128	G = SIMD::HalfToFloat( _mm_slli_epi32( _mm_and_si128( _mm_srli_epi32( v, 11 ), mask ), 4 ) );
+		__m128	B = SIMD::HalfToFloat( _mm_slli_epi32( _mm_srli_epi32( v, 22 ), 5 ) );
+		SIMD::StoreAoS( R, G, B, ONE, _colors );
+	}
+	DecodePixels<PF_R11G11B10>( pixel, _colors, _count );
+}
+template<> void	BaseLib::EncodeSpan<PF_R11G11B10>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U32*	pixel = (U32*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 ) {
+		__m128	R, G, B, A;
+		SIMD::LoadSoA( _colors, R, G, B, A );
+		__m128i	iR = _mm_srli_epi32( SIMD::FloatToHalf( _mm_max_ps( R, ZERO ) ), 4 );
+		__m128i	iG = _mm_srli_epi32( SIMD::FloatToHalf( _mm_max_ps( G, ZERO ) ), 4 );
+		__m128i	iB = _mm_srli_epi32( SIMD::FloatToHalf( _mm_max_ps( B, ZERO ) ), 5 );
+		__m128i	v = _mm_or_si128( _mm_or_si128( iR, _mm_slli_epi32( iG, 11 ) ), _mm_slli_epi32( iB, 22 ) );
+		_mm_storeu_si128( (__m128i*) pixel, v );
+	}
+	EncodePixels<PF_R11G11B10>( _colors, pixel, _count );
+}
+
+#pragma endregion
+
+#pragma region 16-Bits Formats
+
+template<> void	BaseLib::DecodeSpan<PF_R16>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U16*	pixel = (const U16*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 )
+		StoreGray( U16toF32( _mm_loadl_epi64( (const __m128i*) pixel ) ), _colors );
+	DecodePixels<PF_R16>( pixel, _colors, _count );
+}
+template<> void	BaseLib::EncodeSpan<PF_R16>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U16*	pixel = (U16*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 )
+		_mm_storel_epi64( (__m128i*) pixel, F32toU16( LoadRed( _colors ) ) );
+	EncodePixels<PF_R16>( _colors, pixel, _count );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RG16>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U32*	pixel = (const U32*) _pixels;
+	for ( ; _count > 0; _count--, pixel++, _colors++ )
+		_mm_storeu_ps( &_colors->x, RG01( U16toF32( _mm_cvtsi32_si128( int(*pixel) ) ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RG16>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U32*	pixel = (U32*) _pixels;
+	for ( ; _count > 0; _count--, pixel++, _colors++ )
+		*pixel = U32( _mm_cvtsi128_si32( F32toU16( _mm_loadu_ps( &_colors->x ) ) ) );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGB16>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U16*	pixel = (const U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ )
+		_mm_storeu_ps( &_colors->x, RGB1( U16toF32( LoadU16x3( pixel ) ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGB16>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U16*	pixel = (U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ )
+		StoreU16x3( F32toU16( _mm_loadu_ps( &_colors->x ) ), pixel );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGBA16>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U16*	pixel = (const U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=4, _colors++ )
+		_mm_storeu_ps( &_colors->x, U16toF32( _mm_loadl_epi64( (const __m128i*) pixel ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGBA16>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U16*	pixel = (U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=4, _colors++ )
+		_mm_storel_epi64( (__m128i*) pixel, F32toU16( _mm_loadu_ps( &_colors->x ) ) );
+}
+
+#pragma endregion
+
+#pragma region 16 bits floating-point formats
+
+template<> void	BaseLib::DecodeSpan<PF_R16F>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U16*	pixel = (const U16*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 )
+		StoreGray( F16toF32( _mm_loadl_epi64( (const __m128i*) pixel ) ), _colors );
+	DecodePixels<PF_R16F>( pixel, _colors, _count );
+}
+template<> void	BaseLib::EncodeSpan<PF_R16F>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U16*	pixel = (U16*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 )
+		_mm_storel_epi64( (__m128i*) pixel, F32toF16( LoadRed( _colors ) ) );
+	EncodePixels<PF_R16F>( _colors, pixel, _count );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RG16F>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U32*	pixel = (const U32*) _pixels;
+	for ( ; _count > 0; _count--, pixel++, _colors++ )
+		_mm_storeu_ps( &_colors->x, RG01( F16toF32( _mm_cvtsi32_si128( int(*pixel) ) ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RG16F>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U32*	pixel = (U32*) _pixels;
+	for ( ; _count > 0; _count--, pixel++, _colors++ )
+		*pixel = U32( _mm_cvtsi128_si32( F32toF16( _mm_loadu_ps( &_colors->x ) ) ) );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGB16F>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U16*	pixel = (const U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ )
+		_mm_storeu_ps( &_colors->x, RGB1( F16toF32( LoadU16x3( pixel ) ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGB16F>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U16*	pixel = (U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ )
+		StoreU16x3( F32toF16( _mm_loadu_ps( &_colors->x ) ), pixel );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGBA16F>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const U16*	pixel = (const U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=4, _colors++ )
+		_mm_storeu_ps( &_colors->x, F16toF32( _mm_loadl_epi64( (const __m128i*) pixel ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGBA16F>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	U16*	pixel = (U16*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=4, _colors++ )
+		_mm_storel_epi64( (__m128i*) pixel, F32toF16( _mm_loadu_ps( &_colors->x ) ) );
+}
+
+#pragma endregion
+
+#pragma region 32 bits floating points Formats
+
+template<> void	BaseLib::DecodeSpan<PF_R32F>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const float*	pixel = (const float*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 )
+		StoreGray( _mm_loadu_ps( pixel ), _colors );
+	DecodePixels<PF_R32F>( pixel, _colors, _count );
+}
+template<> void	BaseLib::EncodeSpan<PF_R32F>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	float*	pixel = (float*) _pixels;
+	for ( ; _count >= 4; _count-=4, pixel+=4, _colors+=4 )
+		_mm_storeu_ps( pixel, LoadRed( _colors ) );
+	EncodePixels<PF_R32F>( _colors, pixel, _count );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RG32F>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const float*	pixel = (const float*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=2, _colors++ )
+		_mm_storeu_ps( &_colors->x, RG01( _mm_castpd_ps( _mm_load_sd( (const double*) pixel ) ) ) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RG32F>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	float*	pixel = (float*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=2, _colors++ )
+		_mm_store_sd( (double*) pixel, _mm_castps_pd( _mm_loadu_ps( &_colors->x ) ) );
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGB32F>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	const float*	pixel = (const float*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ )
+		_colors->Set( pixel[0], pixel[1], pixel[2], 1.0f );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGB32F>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	float*	pixel = (float*) _pixels;
+	for ( ; _count > 0; _count--, pixel+=3, _colors++ ) {
+		pixel[0] = _colors->x;
+		pixel[1] = _colors->y;
+		pixel[2] = _colors->z;
+	}
+}
+
+template<> void	BaseLib::DecodeSpan<PF_RGBA32F>( const void* _pixels, bfloat4* _colors, U32 _count ) {
+	memcpy( _colors, _pixels, _count * sizeof(bfloat4) );
+}
+template<> void	BaseLib::EncodeSpan<PF_RGBA32F>( const bfloat4* _colors, void* _pixels, U32 _count ) {
+	memcpy( _pixels, _colors, _count * sizeof(bfloat4) );
+}
+
+#pragma endregion
+
+spanDecoder_t	BaseLib::PixelFormat2SpanDecoder( PIXEL_FORMAT _pixelFormat ) {
+	switch ( _pixelFormat ) {
+		// 8-bits
+	case PIXEL_FORMAT::R8:			return &DecodeSpan<PF_R8>;
+	case PIXEL_FORMAT::RG8:			return &DecodeSpan<PF_RG8>;
+	case PIXEL_FORMAT::BGR8:		return &DecodeSpan<PF_BGR8>;
+	case PIXEL_FORMAT::BGRA8:		return &DecodeSpan<PF_BGRA8>;
+	case PIXEL_FORMAT::RGB8:		return &DecodeSpan<PF_RGB8>;
+	case PIXEL_FORMAT::RGBA8:		return &DecodeSpan<PF_RGBA8>;
+	case PIXEL_FORMAT::RGBE:		return &DecodeSpan<PF_RGBE>;
+	case PIXEL_FORMAT::RGB10A2:		return &DecodeSpan<PF_RGB10A2>;
+	case PIXEL_FORMAT::R11G11B10:	return &DecodeSpan<PF_R11G11B10>;
+
+		// 16-bits
+	case PIXEL_FORMAT::R16:			return &DecodeSpan<PF_R16>;
+	case PIXEL_FORMAT::RG16:		return &DecodeSpan<PF_RG16>;
+	case PIXEL_FORMAT::RGB16:		return &DecodeSpan<PF_RGB16>;
+	case PIXEL_FORMAT::RGBA16:		return &DecodeSpan<PF_RGBA16>;
+
+		// 16-bits half-precision floating points
+	case PIXEL_FORMAT::R16F:		return &DecodeSpan<PF_R16F>;
+	case PIXEL_FORMAT::RG16F:		return &DecodeSpan<PF_RG16F>;
+	case PIXEL_FORMAT::RGB16F:		return &DecodeSpan<PF_RGB16F>;
+	case PIXEL_FORMAT::RGBA16F:		return &DecodeSpan<PF_RGBA16F>;
+
+		// 32-bits
+	case PIXEL_FORMAT::R32:			return &DecodeSpan<PF_R32>;
+	case PIXEL_FORMAT::RG32:		return &DecodeSpan<PF_RG32>;
+	case PIXEL_FORMAT::RGB32:		return &DecodeSpan<PF_RGB32>;
+	case PIXEL_FORMAT::RGBA32:		return &DecodeSpan<PF_RGBA32>;
+
+		// 32-bits floating points
+	case PIXEL_FORMAT::R32F:		return &DecodeSpan<PF_R32F>;
+	case PIXEL_FORMAT::RG32F:		return &DecodeSpan<PF_RG32F>;
+	case PIXEL_FORMAT::RGB32F:		return &DecodeSpan<PF_RGB32F>;
+	case PIXEL_FORMAT::RGBA32F:		return &DecodeSpan<PF_RGBA32F>;
+	}
+
+	return &DecodeNothing;
+}
+
+spanEncoder_t	BaseLib::PixelFormat2SpanEncoder( PIXEL_FORMAT _pixelFormat ) {
+	switch ( _pixelFormat ) {
+		// 8-bits
+	case PIXEL_FORMAT::R8:			return &EncodeSpan<PF_R8>;
+	case PIXEL_FORMAT::RG8:			return &EncodeSpan<PF_RG8>;
+	case PIXEL_FORMAT::BGR8:		return &EncodeSpan<PF_BGR8>;
+	case PIXEL_FORMAT::BGRA8:		return &EncodeSpan<PF_BGRA8>;
+	case PIXEL_FORMAT::RGB8:		return &EncodeSpan<PF_RGB8>;
+	case PIXEL_FORMAT::RGBA8:		return &EncodeSpan<PF_RGBA8>;
+	case PIXEL_FORMAT::RGBE:		return &EncodeSpan<PF_RGBE>;	// Generic codec: the shared exponent is computed with the same log2f()/powf() as the single pixel path
+	case PIXEL_FORMAT::RGB10A2:		return &EncodeSpan<PF_RGB10A2>;
+	case PIXEL_FORMAT::R11G11B10:	return &EncodeSpan<PF_R11G11B10>;
+
+		// 16-bits
+	case PIXEL_FORMAT::R16:			return &EncodeSpan<PF_R16>;
+	case PIXEL_FORMAT::RG16:		return &EncodeSpan<PF_RG16>;
+	case PIXEL_FORMAT::RGB16:		return &EncodeSpan<PF_RGB16>;
+	case PIXEL_FORMAT::RGBA16:		return &EncodeSpan<PF_RGBA16>;
+
+		// 16-bits half-precision floating points
+	case PIXEL_FORMAT::R16F:		return &EncodeSpan<PF_R16F>;
+	case PIXEL_FORMAT::RG16F:		return &EncodeSpan<PF_RG16F>;
+	case PIXEL_FORMAT::RGB16F:		return &EncodeSpan<PF_RGB16F>;
+	case PIXEL_FORMAT::RGBA16F:		return &EncodeSpan<PF_RGBA16F>;
+
+		// 32-bits
+	case PIXEL_FORMAT::R32:			return &EncodeSpan<PF_R32>;
+	case PIXEL_FORMAT::RG32:		return &EncodeSpan<PF_RG32>;
+	case PIXEL_FORMAT::RGB32:		return &EncodeSpan<PF_RGB32>;
+	case PIXEL_FORMAT::RGBA32:		return &EncodeSpan<PF_RGBA32>;
+
+		// 32-bits floating points
+	case PIXEL_FORMAT::R32F:		return &EncodeSpan<PF_R32F>;
+	case PIXEL_FORMAT::RG32F:		return &EncodeSpan<PF_RG32F>;
+	case PIXEL_FORMAT::RGB32F:		return &EncodeSpan<PF_RGB32F>;
+	case PIXEL_FORMAT::RGBA32F:		return &EncodeSpan<PF_RGBA32F>;
+	}
+
+	return &EncodeNothing;
+}
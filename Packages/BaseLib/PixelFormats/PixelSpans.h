@@ -0,0 +1,86 @@
+//////////////////////////////////////////////////////////////////////////
+// Bulk pixel codecs converting entire spans of pixels to and from bfloat4
+//
+// Contrary to the IPixelAccessor interface that costs a virtual call per pixel, the span codecs are resolved once
+//	per span (e.g. per scanline) and are specialized at compile time for each pixel structure.
+// The specialized codecs use SSE to convert UNORM and half components and are bit-exact with their IPixelAccessor counterparts.
+//
+// Usage:
+//	spanDecoder_t	decoder = PixelFormat2SpanDecoder( image.GetPixelFormat() );
+//	(*decoder)( scanlinePixels, scanlineColors, W );
+//
+#pragma once
+
+#include "../Types.h"
+
+namespace BaseLib {
+
+	// Decodes _count consecutive pixels into _count colors
+	typedef void	(*spanDecoder_t)( const void* _pixels, bfloat4* _colors, U32 _count );
+
+	// Encodes _count colors into _count consecutive pixels
+	typedef void	(*spanEncoder_t)( const bfloat4* _colors, void* _pixels, U32 _count );
+
+	// Generic codecs calling the pixel structure's accessor non-virtually
+	template< typename PF >
+	void	DecodeSpan( const void* _pixels, bfloat4* _colors, U32 _count ) {
+		const PF*	pixel = (const PF*) _pixels;
+		for ( ; _count > 0; _count--, pixel++, _colors++ )
+			PF::Descriptor.desc_t::RGBA( pixel, *_colors );
+	}
+
+	template< typename PF >
+	void	EncodeSpan( const bfloat4* _colors, void* _pixels, U32 _count ) {
+		PF*	pixel = (PF*) _pixels;
+		for ( ; _count > 0; _count--, pixel++, _colors++ )
+			PF::Descriptor.desc_t::Write( pixel, *_colors );
+	}
+
+	// Specialized codecs (cf. PixelSpans.cpp)
+	template<> void	DecodeSpan<PF_R8>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RG8>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGB8>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_BGR8>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGBA8>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_BGRA8>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGBE>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGB10A2>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_R11G11B10>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_R16>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RG16>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGB16>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGBA16>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_R16F>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RG16F>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGB16F>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGBA16F>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_R32F>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RG32F>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGB32F>( const void* _pixels, bfloat4* _colors, U32 _count );
+	template<> void	DecodeSpan<PF_RGBA32F>( const void* _pixels, bfloat4* _colors, U32 _count );
+
+	template<> void	EncodeSpan<PF_R8>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RG8>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGB8>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_BGR8>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGBA8>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_BGRA8>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGB10A2>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_R11G11B10>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_R16>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RG16>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGB16>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGBA16>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_R16F>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RG16F>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGB16F>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGBA16F>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_R32F>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RG32F>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGB32F>( const bfloat4* _colors, void* _pixels, U32 _count );
+	template<> void	EncodeSpan<PF_RGBA32F>( const bfloat4* _colors, void* _pixels, U32 _count );
+
+	// Resolves the span codecs for a given pixel format (a codec doing nothing is returned for unsupported formats)
+	extern spanDecoder_t	PixelFormat2SpanDecoder( PIXEL_FORMAT _pixelFormat );
+	extern spanEncoder_t	PixelFormat2SpanEncoder( PIXEL_FORMAT _pixelFormat );
+}
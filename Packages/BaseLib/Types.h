@@ -81,6 +81,7 @@ template<typename T> void	Swap( T& a, T& b ) { T temp = a; a = b; b = temp; }
 #include "Containers/SpatialHashing.h"
 
 #include "Math/Random.h"
+#include "Math/Sampling.h"
 #include "Math/SH.h"
 #include "PixelFormats/PixelFormats.h"
 #include "Utility/tweakval.h"
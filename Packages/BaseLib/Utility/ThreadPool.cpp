@@ -0,0 +1,202 @@
+#include "stdafx.h"
+#include "ThreadPool.h"
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+
+using namespace BaseLib;
+
+// The pools whose tasks the current thread is executing, innermost first (a task of one pool can run a job on another pool)
+struct	TaskScope {
+	const ThreadPool*	pool;
+	U32					threadIndex;
+	TaskScope*			previous;
+};
+static thread_local TaskScope*	ts_currentScope = nullptr;
+
+// Registers the current thread as executing the tasks of a pool, until the end of the C++ scope (even if a task throws)
+struct	TaskScopeGuard {
+	TaskScope	scope;
+
+	TaskScopeGuard( const ThreadPool* _pool, U32 _threadIndex ) {
+		scope.pool = _pool;
+		scope.threadIndex = _threadIndex;
+		scope.previous = ts_currentScope;
+		ts_currentScope = &scope;
+	}
+	~TaskScopeGuard() {
+		ts_currentScope = scope.previous;
+	}
+};
+
+// Finds the scope of the pool if the current thread is executing one of its tasks
+static const TaskScope*	FindTaskScope( const ThreadPool* _pool ) {
+	for ( const TaskScope* scope=ts_currentScope; scope != nullptr; scope=scope->previous )
+		if ( scope->pool == _pool )
+			return scope;
+	return nullptr;
+}
+
+struct	ThreadPool::Internals {
+	std::thread*			threads;
+
+	std::mutex				runMutex;		// Only a single job can run at a time
+	std::mutex				mutex;
+	std::condition_variable	wakeUp;
+	std::condition_variable	done;
+
+	// Current job
+	U64						jobID;
+	TaskFunction_t			function;
+	void*					userData;
+	U32						tasksCount;
+	std::atomic<U32>		nextTask;
+	U32						busyWorkersCount;
+	std::atomic<bool>		failed;
+	std::exception_ptr		exception;		// The first exception thrown by a task of the current job, rethrown by Run()
+	bool					exit;
+
+	Internals() : threads( nullptr ), jobID( 0 ), function( nullptr ), userData( nullptr ), tasksCount( 0 ), nextTask( 0 ), busyWorkersCount( 0 ), failed( false ), exit( false ) {}
+
+	// Consumes tasks until there are none left
+	//	Once a task has thrown, the remaining tasks are drained without being executed
+	void	ExecuteTasks( const ThreadPool* _owner, U32 _threadIndex ) {
+		TaskScopeGuard	scope( _owner, _threadIndex );
+		for ( U32 taskIndex=nextTask++; taskIndex < tasksCount; taskIndex=nextTask++ ) {
+			if ( failed )
+				continue;
+			try {
+				function( taskIndex, _threadIndex, userData );
+			} catch ( ... ) {
+				std::unique_lock<std::mutex>	lock( mutex );
+				if ( !exception )
+					exception = std::current_exception();
+				failed = true;
+			}
+		}
+	}
+};
+
+ThreadPool::ThreadPool( U32 _workersCount )
+	: m_workersCount( _workersCount )
+	, m_internals( new Internals() )
+{
+	if ( m_workersCount == 0 ) {
+		U32	hardwareThreadsCount = std::thread::hardware_concurrency();
+		m_workersCount = hardwareThreadsCount > 1 ? hardwareThreadsCount - 1 : 0;
+	}
+
+	if ( m_workersCount > 0 ) {
+		m_internals->threads = new std::thread[m_workersCount];
+		for ( U32 workerIndex=0; workerIndex < m_workersCount; workerIndex++ )
+			m_internals->threads[workerIndex] = std::thread( &ThreadPool::WorkerThread, this, 1+workerIndex );
+	}
+}
+
+ThreadPool::~ThreadPool() {
+	{
+		std::unique_lock<std::mutex>	lock( m_internals->mutex );
+		m_internals->exit = true;
+	}
+	m_internals->wakeUp.notify_all();
+
+	for ( U32 workerIndex=0; workerIndex < m_workersCount; workerIndex++ )
+		m_internals->threads[workerIndex].join();
+
+	SAFE_DELETE_ARRAY( m_internals->threads );
+	SAFE_DELETE( m_internals );
+}
+
+static std::mutex				gs_defaultMutex;
+static std::atomic<ThreadPool*>	gs_default( nullptr );
+
+ThreadPool&	ThreadPool::Default() {
+	ThreadPool*	pool = gs_default.load( std::memory_order_acquire );
+	if ( pool == nullptr ) {
+		std::unique_lock<std::mutex>	lock( gs_defaultMutex );
+		pool = gs_default.load( std::memory_order_relaxed );
+		if ( pool == nullptr ) {
+			pool = new ThreadPool();
+			gs_default.store( pool, std::memory_order_release );
+		}
+	}
+	return *pool;
+}
+
+void	ThreadPool::ShutdownDefault() {
+	std::unique_lock<std::mutex>	lock( gs_defaultMutex );
+	ThreadPool*	pool = gs_default.exchange( nullptr );
+	delete pool;
+}
+
+void	ThreadPool::Run( U32 _tasksCount, TaskFunction_t _function, void* _userData ) {
+	if ( _tasksCount == 0 )
+		return;
+
+	const TaskScope*	currentScope = FindTaskScope( this );
+	if ( m_workersCount == 0 || _tasksCount == 1 || currentScope != nullptr ) {
+		// Execute serially if there's no worker, a single task or if we're called from within a task of this pool
+		//	(the thread index then stays the one this pool gave to the current thread so it's still in [0,GetThreadsCount()[)
+		U32	threadIndex = currentScope != nullptr ? currentScope->threadIndex : 0;
+		for ( U32 taskIndex=0; taskIndex < _tasksCount; taskIndex++ )
+			_function( taskIndex, threadIndex, _userData );
+		return;
+	}
+
+	std::unique_lock<std::mutex>	runLock( m_internals->runMutex );
+
+	// Post the new job
+	{
+		std::unique_lock<std::mutex>	lock( m_internals->mutex );
+		m_internals->function = _function;
+		m_internals->userData = _userData;
+		m_internals->tasksCount = _tasksCount;
+		m_internals->nextTask = 0;
+		m_internals->busyWorkersCount = m_workersCount;
+		m_internals->failed = false;
+		m_internals->exception = nullptr;
+		m_internals->jobID++;
+	}
+	m_internals->wakeUp.notify_all();
+
+	// Participate
+	m_internals->ExecuteTasks( this, 0 );
+
+	// Wait for all workers to be done with the job so the user data can safely go out of scope, even if a task has thrown
+	std::exception_ptr	exception;
+	{
+		std::unique_lock<std::mutex>	lock( m_internals->mutex );
+		m_internals->done.wait( lock, [&]() { return m_internals->busyWorkersCount == 0; } );
+		exception = m_internals->exception;
+		m_internals->exception = nullptr;
+	}
+	if ( exception )
+		std::rethrow_exception( exception );
+}
+
+void	ThreadPool::WorkerThread( ThreadPool* _owner, U32 _threadIndex ) {
+	Internals&	internals = *_owner->m_internals;
+	U64			lastJobID = 0;
+	while ( true ) {
+		{
+			std::unique_lock<std::mutex>	lock( internals.mutex );
+			internals.wakeUp.wait( lock, [&]() { return internals.exit || internals.jobID != lastJobID; } );
+			if ( internals.exit )
+				return;
+			lastJobID = internals.jobID;
+		}
+
+		internals.ExecuteTasks( _owner, _threadIndex );
+
+		bool	lastWorker;
+		{
+			std::unique_lock<std::mutex>	lock( internals.mutex );
+			lastWorker = --internals.busyWorkersCount == 0;
+		}
+		if ( lastWorker )
+			internals.done.notify_one();
+	}
+}
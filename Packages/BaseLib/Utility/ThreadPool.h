@@ -0,0 +1,79 @@
+//////////////////////////////////////////////////////////////////////////
+// Simple thread pool used to dispatch data-parallel loops onto all the available cores
+//
+// The calling thread always takes part in the work so ParallelFor() is a blocking call that returns once all the tasks are complete.
+// Nested calls issued from within a task of the same pool are executed serially on the calling thread to avoid dead-locks.
+// If tasks throw, the remaining tasks are skipped and the first exception is rethrown on the calling thread once all the workers are done.
+//
+// Usage:
+//	ThreadPool::Default().ParallelFor( H, [&]( U32 _Y, U32 _threadIndex ) {
+//		... process scanline _Y using the scratch buffer at index _threadIndex ...
+//	} );
+//
+#pragma once
+
+#include "../Types.h"
+
+namespace BaseLib {
+
+	class	ThreadPool {
+	public:
+		// The task function called for each task index in [0,_tasksCount[
+		//	_threadIndex is in [0,GetThreadsCount()[ and can be used to address per-thread scratch buffers
+		typedef void	(*TaskFunction_t)( U32 _taskIndex, U32 _threadIndex, void* _userData );
+
+	private:
+		struct	Internals;
+
+		U32			m_workersCount;
+		Internals*	m_internals;
+
+	public:
+		// Creates a pool with the given amount of worker threads (0 means "hardware concurrency - 1" since the calling thread also works)
+		ThreadPool( U32 _workersCount=0 );
+		~ThreadPool();
+
+		// Gets the default pool shared by all the libraries
+		//	The pool is created on first use and is never destroyed by static destructors: joining threads while a DLL is being unloaded
+		//	happens under the loader lock and can dead-lock, so a host that wants to release the workers must call ShutdownDefault() explicitly
+		static ThreadPool&	Default();
+
+		// Joins and destroys the workers of the default pool, a new pool is created if Default() is called again afterwards
+		//	Must not be called while the default pool is in use by another thread
+		static void			ShutdownDefault();
+
+		// Gets the maximum amount of threads that can execute tasks concurrently (i.e. the workers + the calling thread)
+		U32			GetThreadsCount() const	{ return m_workersCount + 1; }
+
+		// Executes the function for every task index in [0,_tasksCount[ and waits for completion
+		void		Run( U32 _tasksCount, TaskFunction_t _function, void* _userData );
+
+		// Executes the functor for every task index in [0,_tasksCount[ and waits for completion
+		//	_functor should have the signature void( U32 _taskIndex, U32 _threadIndex )
+		template< typename F >
+		void		ParallelFor( U32 _tasksCount, const F& _functor ) {
+			Run( _tasksCount, &CallFunctor<F>, (void*) &_functor );
+		}
+
+		// Splits [0,_count[ into chunks of _grainSize elements and executes the functor for each chunk
+		//	_functor should have the signature void( U32 _start, U32 _end, U32 _threadIndex )
+		template< typename F >
+		void		ParallelForRange( U32 _count, U32 _grainSize, const F& _functor ) {
+			_grainSize = MAX( 1U, _grainSize );
+			U32	chunksCount = (_count + _grainSize - 1) / _grainSize;
+			ParallelFor( chunksCount, [&]( U32 _chunkIndex, U32 _threadIndex ) {
+				U32	start = _chunkIndex * _grainSize;
+				U32	end = MIN( _count, start + _grainSize );
+				_functor( start, end, _threadIndex );
+			} );
+		}
+
+	private:
+		template< typename F >
+		static void	CallFunctor( U32 _taskIndex, U32 _threadIndex, void* _userData ) {
+			(*((const F*) _userData))( _taskIndex, _threadIndex );
+		}
+
+		static void	WorkerThread( ThreadPool* _owner, U32 _threadIndex );
+	};
+}
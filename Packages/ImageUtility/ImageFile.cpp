@@ -441,6 +441,91 @@ System::String^	ImageFile::LastDumpedText() {
 	return gcnew System::String( (Char*) ImageUtilityLib::ImageFile::ms_lastDumpedText );;
 }
 
+void	ImageFile::ShutdownWorkerThreads() {
+	BaseLib::ThreadPool::ShutdownDefault();
+}
+
+#pragma unmanaged
+
+// Native loops for BenchmarkScanlineCodecs(), kept out of /clr so we time the codecs and not the managed transitions
+static void	DecodeScanlinesPerPixel( const BaseLib::IPixelAccessor& _accessor, const U8* _pixels, bfloat4* _scanline, U32 _width, U32 _height ) {
+	U32	pixelSize = _accessor.Size();
+	for ( U32 Y=0; Y < _height; Y++ ) {
+		for ( U32 X=0; X < _width; X++, _pixels+=pixelSize )
+			_accessor.RGBA( _pixels, _scanline[X] );
+	}
+}
+static void	EncodeScanlinesPerPixel( const BaseLib::IPixelAccessor& _accessor, const bfloat4* _scanline, U8* _pixels, U32 _width, U32 _height ) {
+	U32	pixelSize = _accessor.Size();
+	for ( U32 Y=0; Y < _height; Y++ ) {
+		for ( U32 X=0; X < _width; X++, _pixels+=pixelSize )
+			_accessor.Write( _pixels, _scanline[X] );
+	}
+}
+static void	DecodeScanlinesSpan( BaseLib::spanDecoder_t _decoder, U32 _pixelSize, const U8* _pixels, bfloat4* _scanline, U32 _width, U32 _height ) {
+	for ( U32 Y=0; Y < _height; Y++, _pixels+=_width*_pixelSize )
+		(*_decoder)( _pixels, _scanline, _width );
+}
+static void	EncodeScanlinesSpan( BaseLib::spanEncoder_t _encoder, U32 _pixelSize, const bfloat4* _scanline, U8* _pixels, U32 _width, U32 _height ) {
+	for ( U32 Y=0; Y < _height; Y++, _pixels+=_width*_pixelSize )
+		(*_encoder)( _scanline, _pixels, _width );
+}
+
+#pragma managed
+
+void	ImageFile::BenchmarkScanlineCodecs( PIXEL_FORMAT _format, UInt32 _width, UInt32 _height, UInt32 _repeatCount, double% _decodePerPixel, double% _decodeSpan, double% _encodePerPixel, double% _encodeSpan ) {
+	BaseLib::PIXEL_FORMAT			nativeFormat = BaseLib::PIXEL_FORMAT( _format );
+	const BaseLib::IPixelAccessor&	accessor = BaseLib::PixelFormat2PixelAccessor( nativeFormat );
+	BaseLib::spanDecoder_t			decoder = BaseLib::PixelFormat2SpanDecoder( nativeFormat );
+	BaseLib::spanEncoder_t			encoder = BaseLib::PixelFormat2SpanEncoder( nativeFormat );
+	U32		pixelSize = accessor.Size();
+	if ( pixelSize == 0 )
+		throw gcnew Exception( "Unsupported pixel format!" );
+	if ( _width == 0 || _height == 0 || _repeatCount == 0 )
+		throw gcnew Exception( "Invalid benchmark size!" );
+
+	// Fill a scanline with a ramp that covers the [0,1] range so the encoders don't only see zeroes
+	U8*			pixels = new U8[_width * _height * pixelSize];
+	bfloat4*	scanline = new bfloat4[_width];
+	for ( U32 X=0; X < _width; X++ ) {
+		float	t = float(X) / _width;
+		scanline[X].Set( t, 1.0f - t, 0.5f * t, 1.0f );
+	}
+	EncodeScanlinesSpan( encoder, pixelSize, scanline, pixels, _width, 1 );
+	for ( U32 Y=1; Y < _height; Y++ )
+		memcpy( pixels + Y * _width * pixelSize, pixels, _width * pixelSize );
+
+	// Keep the best time of each path
+	System::Diagnostics::Stopwatch^	watch = gcnew System::Diagnostics::Stopwatch();
+	double	bestTimes[4] = { Double::MaxValue, Double::MaxValue, Double::MaxValue, Double::MaxValue };
+	for ( U32 repeatIndex=0; repeatIndex < _repeatCount; repeatIndex++ ) {
+		watch->Restart();
+		DecodeScanlinesPerPixel( accessor, pixels, scanline, _width, _height );
+		bestTimes[0] = Math::Min( bestTimes[0], watch->Elapsed.TotalSeconds );
+
+		watch->Restart();
+		DecodeScanlinesSpan( decoder, pixelSize, pixels, scanline, _width, _height );
+		bestTimes[1] = Math::Min( bestTimes[1], watch->Elapsed.TotalSeconds );
+
+		watch->Restart();
+		EncodeScanlinesPerPixel( accessor, scanline, pixels, _width, _height );
+		bestTimes[2] = Math::Min( bestTimes[2], watch->Elapsed.TotalSeconds );
+
+		watch->Restart();
+		EncodeScanlinesSpan( encoder, pixelSize, scanline, pixels, _width, _height );
+		bestTimes[3] = Math::Min( bestTimes[3], watch->Elapsed.TotalSeconds );
+	}
+
+	delete[] scanline;
+	delete[] pixels;
+
+	double	MPixels = 1e-6 * _width * _height;
+	_decodePerPixel = MPixels / Math::Max( 1e-9, bestTimes[0] );
+	_decodeSpan = MPixels / Math::Max( 1e-9, bestTimes[1] );
+	_encodePerPixel = MPixels / Math::Max( 1e-9, bestTimes[2] );
+	_encodeSpan = MPixels / Math::Max( 1e-9, bestTimes[3] );
+}
+
 
 
 //////////////////////////////////////////////////////////////////////////
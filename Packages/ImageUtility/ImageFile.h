@@ -526,6 +526,16 @@ namespace ImageUtility {
 		// Gets the last text dumped by the FreeImage library (maybe it can help to track errors?)
 		static System::String^		LastDumpedText();
 
+		// Joins the worker threads used by the parallel image operations
+		// The workers are never joined by the DLL's static destructors (that would happen under the loader lock), call this before exiting
+		//	if the threads must be released deterministically. They are created again if another parallel operation is issued.
+		static void					ShutdownWorkerThreads();
+
+		// Measures the scanline decoding/encoding throughput of a pixel format, in MPixels/s
+		// Both the per-pixel virtual IPixelAccessor path (what ReadScanline()/WriteScanline() used to do) and the span codecs they now use
+		//	are timed on the same _width x _height buffer, each figure being the best of _repeatCount runs
+		static void					BenchmarkScanlineCodecs( PIXEL_FORMAT _format, UInt32 _width, UInt32 _height, UInt32 _repeatCount, double% _decodePerPixel, double% _decodeSpan, double% _encodePerPixel, double% _encodeSpan );
+
 
 	public:
 		//////////////////////////////////////////////////////////////////////////
@@ -20,6 +20,17 @@ namespace ImageUtility {
 
 		return (ImageUtility::COMPONENT_FORMAT) loadedFormat;
 	}
+	COMPONENT_FORMAT	ImagesMatrix::DDSMapFile( System::IO::FileInfo^ _fileName ) {
+		if ( !_fileName->Exists )
+			throw gcnew System::IO::FileNotFoundException( "File not found!", _fileName->FullName );
+
+		pin_ptr< const wchar_t >	nativeFileName = PtrToStringChars( _fileName->FullName );
+
+		ImageUtilityLib::COMPONENT_FORMAT	loadedFormat;
+		m_nativeObject->DDSMapFile( nativeFileName, loadedFormat );
+
+		return (ImageUtility::COMPONENT_FORMAT) loadedFormat;
+	}
 	COMPONENT_FORMAT	ImagesMatrix::DDSLoadMemory( NativeByteArray^ _imageContent ) {
 		ImageUtilityLib::COMPONENT_FORMAT	loadedFormat;
 		m_nativeObject->DDSLoadMemory( _imageContent->Length, _imageContent->AsBytePointer.ToPointer(), loadedFormat );
@@ -41,6 +52,35 @@ namespace ImageUtility {
 		return result;
 	}
 
+	void	ImagesMatrix::BenchmarkCompression( ImageFile^ _source, COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat, COMPRESSION_QUALITY _quality, UInt32 _repeatCount, double% _PSNR, double% _MPixelsPerSecond ) {
+		DXGI_FORMAT	format = ImageUtilityLib::ImagesMatrix::CompressionType2DXGIFormat( ImageUtilityLib::ImagesMatrix::COMPRESSION_TYPE( _compressionType ), BaseLib::COMPONENT_FORMAT( _componentFormat ) );
+		if ( !ImageUtilityLib::BlockCompressor::IsSupported( format ) )
+			throw gcnew Exception( "Unsupported compression type and/or component format!" );
+		if ( _repeatCount == 0 )
+			throw gcnew Exception( "Invalid repeat count!" );
+
+		const ImageUtilityLib::ImageFile&	source = *_source->m_nativeObject;
+		U32	blocksCountX = (source.Width() + 3) >> 2;
+		U32	blocksCountY = (source.Height() + 3) >> 2;
+		U32	rowPitch = blocksCountX * ImageUtilityLib::BlockCompressor::GetBlockSize( format );
+		U8*	target = new U8[blocksCountY * rowPitch];
+
+		// Keep the best time, the error is the same for every run
+		System::Diagnostics::Stopwatch^	watch = gcnew System::Diagnostics::Stopwatch();
+		double	bestTime = Double::MaxValue;
+		double	MSE = 0.0;
+		for ( U32 repeatIndex=0; repeatIndex < _repeatCount; repeatIndex++ ) {
+			watch->Restart();
+			MSE = ImageUtilityLib::BlockCompressor::CompressImage( format, source, ImageUtilityLib::BlockCompressor::QUALITY( _quality ), target, rowPitch );
+			bestTime = Math::Min( bestTime, watch->Elapsed.TotalSeconds );
+		}
+
+		delete[] target;
+
+		_PSNR = ImageUtilityLib::BlockCompressor::MSE2PSNR( MSE );
+		_MPixelsPerSecond = 1e-6 * source.Width() * source.Height() / Math::Max( 1e-9, bestTime );
+	}
+
 
 	//////////////////////////////////////////////////////////////////////////
 	// Helpers
@@ -35,6 +35,13 @@ namespace ImageUtility {
 			NORMAL_MAP,	// 0.5-offseted vectors
 		};
 
+		// Filter used for mips generation
+		enum class MIP_FILTER {
+			BOX,		// Default, averages the texels covered by the target texel (weighted by coverage for odd sizes)
+			KAISER,		// Kaiser-windowed sinc, sharper than the box
+			LANCZOS,	// Lanczos-3 windowed sinc, sharpest but may ring on strong edges
+		};
+
 		// The Mips class contains a collection of "Mip" elements, as many mips as necessary to represent a texture
 		//
 		ref class	Mips {
@@ -57,6 +64,11 @@ namespace ImageUtility {
 				property UInt32		Width			{ UInt32 get() { return m_nativeObject->Width(); } }
 				property UInt32		Height			{ UInt32 get() { return m_nativeObject->Height(); } }
 				property UInt32		Depth			{ UInt32 get() { return m_nativeObject->Depth(); } }
+
+				// Raw buffer access (e.g. for mapped DDS files), NULL if the mip uses image files
+				property UInt32		RowPitch		{ UInt32 get() { return m_nativeObject->RowPitch(); } }
+				property UInt32		SlicePitch		{ UInt32 get() { return m_nativeObject->SlicePitch(); } }
+				property IntPtr		RawBuffer		{ IntPtr get() { return IntPtr( m_nativeObject->GetRawBuffer() ); } }
 				property ImageFile^	default[UInt32]	{
 					ImageFile^ get( UInt32 _index ) {
 						ImageUtilityLib::ImageFile* nativeImage = (*m_nativeObject)[_index];
@@ -188,6 +200,9 @@ namespace ImageUtility {
 		void				DDSSaveFile( System::IO::FileInfo^ _fileName, COMPONENT_FORMAT _componentFormat );
 		NativeByteArray^	DDSSaveMemory( COMPONENT_FORMAT _componentFormat );
 
+		// Maps the file in memory without copying nor converting anything: the matrix format is flagged as RAW_BUFFER and the file stays mapped until the matrix is released
+		COMPONENT_FORMAT	DDSMapFile( System::IO::FileInfo^ _fileName );
+
 		// DDS-Compression
  		// NOTE: Use the RendererLib::Device version to compress using the GPU
 		enum class COMPRESSION_TYPE {
@@ -195,21 +210,36 @@ namespace ImageUtility {
 			BC5,
 			BC6H,
 			BC7,
+			BC1,
+			BC3,
+		};
+		enum class COMPRESSION_QUALITY {
+			FAST,
+			NORMAL,
+			HIGH,
 		};
 		// NOTE: If you want to use GPU compression, use Device.DDSCompress() instead!
 		void	DDSCompress( ImagesMatrix^ _sourceImage, COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat ) {
-			m_nativeObject->DDSCompress( *reinterpret_cast< ImageUtilityLib::ImagesMatrix* >( _sourceImage->NativeObject.ToPointer() ), ImageUtilityLib::ImagesMatrix::COMPRESSION_TYPE( _compressionType ), BaseLib::COMPONENT_FORMAT( _componentFormat ) );
+			DDSCompress( _sourceImage, _compressionType, _componentFormat, COMPRESSION_QUALITY::NORMAL );
+		}
+		void	DDSCompress( ImagesMatrix^ _sourceImage, COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat, COMPRESSION_QUALITY _quality ) {
+			m_nativeObject->DDSCompress( *reinterpret_cast< ImageUtilityLib::ImagesMatrix* >( _sourceImage->NativeObject.ToPointer() ), ImageUtilityLib::ImagesMatrix::COMPRESSION_TYPE( _compressionType ), BaseLib::COMPONENT_FORMAT( _componentFormat ), NULL, ImageUtilityLib::BlockCompressor::QUALITY( _quality ) );
 		}
 
+		// Measures the CPU block compression of an image: the PSNR of the encoded components (in dB) and the throughput (in MPixels/s)
+		//	The throughput is the best of _repeatCount runs
+		static void	BenchmarkCompression( ImageFile^ _source, COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat, COMPRESSION_QUALITY _quality, UInt32 _repeatCount, double% _PSNR, double% _MPixelsPerSecond );
+
 	public:
 		//////////////////////////////////////////////////////////////////////////
 		// Mips generation methods
 		void			BuildMips( IMAGE_TYPE _imageType )	{ m_nativeObject->BuildMips( (ImageUtilityLib::ImagesMatrix::IMAGE_TYPE) _imageType ); }
+		void			BuildMips( IMAGE_TYPE _imageType, MIP_FILTER _filter )	{ m_nativeObject->BuildMips( (ImageUtilityLib::ImagesMatrix::IMAGE_TYPE) _imageType, (ImageUtilityLib::ImagesMatrix::MIP_FILTER) _filter ); }
 
 		// Computes the next mip size
-		static void		NextMipSize( UInt32% _size ) { U32 size; ImageUtilityLib::ImagesMatrix::NextMipSize( size ); _size = size; }
-		static void		NextMipSize( UInt32% _width, UInt32% _height ) { U32 width, height; ImageUtilityLib::ImagesMatrix::NextMipSize( width, height ); _width = width; _height = height; }
-		static void		NextMipSize( UInt32% _width, UInt32% _height, UInt32% _depth ) { U32 width, height, depth; ImageUtilityLib::ImagesMatrix::NextMipSize( width, height, depth ); _width = width; _height = height; _depth = depth; }
+		static void		NextMipSize( UInt32% _size ) { U32 size = _size; ImageUtilityLib::ImagesMatrix::NextMipSize( size ); _size = size; }
+		static void		NextMipSize( UInt32% _width, UInt32% _height ) { U32 width = _width, height = _height; ImageUtilityLib::ImagesMatrix::NextMipSize( width, height ); _width = width; _height = height; }
+		static void		NextMipSize( UInt32% _width, UInt32% _height, UInt32% _depth ) { U32 width = _width, height = _height, depth = _depth; ImageUtilityLib::ImagesMatrix::NextMipSize( width, height, depth ); _width = width; _height = height; _depth = depth; }
 
 	public:
 		//////////////////////////////////////////////////////////////////////////
@@ -15,6 +15,7 @@
 
 // Base lib
 #include "..\BaseLib\Types.h"
+#include "..\BaseLib\PixelFormats\PixelSpans.h"
 
 // Image Utility lib
 #include "..\ImageUtilityLib\Bitmap.h"
@@ -37,7 +37,7 @@ void	Bitmap::FromImageFile( const ImageFile& _sourceFile, const ColorProfile* _p
 	// Convert to XYZ in bulk using profile
 	const bfloat4*	source = (const bfloat4*) FreeImage_GetBits( float4Bitmap );
 	m_XYZ = new bfloat4[m_width * m_height];
-	colorProfile->RGB2XYZ( source, m_XYZ, U32(m_width * m_height) );
+	colorProfile->ParallelRGB2XYZ( source, m_XYZ, U32(m_width * m_height) );
 
 	FreeImage_Unload( float4Bitmap );
 
@@ -73,7 +73,7 @@ void	Bitmap::ToImageFile( ImageFile& _targetFile, const ColorProfile& _colorProf
 		}
 		source = target;	// In-place conversion
 	}
-	_colorProfile.XYZ2RGB( source, target, m_width*m_height );
+	_colorProfile.ParallelXYZ2RGB( source, target, m_width*m_height );
 }
 
 void	Bitmap::BilinearSample( float X, float Y, bfloat4& _XYZ ) const {
@@ -125,6 +125,77 @@ void	Bitmap::LDR2HDR( U32 _imagesCount, const ImageFile** _images, const float*
 	LDR2HDR( _imagesCount, _images, _imageShutterSpeeds, responseCurve_filtered, _parms._luminanceOnly, _parms._luminanceFactor );
 }
 
+// Accumulates the weighted log2 radiance of a single exposure's scanline
+//	_linearRGB, the scanline converted into linear RGB
+//	_sumHDR, the weighted sum of log2 radiances that is accumulated into (only RGB is written)
+//	_sumWeights, the sum of weights that is accumulated into
+//	_luminanceOnly, if true then only the first channel of the response curve is valid and it is used for all 3 components
+// The response curve lookup, the weighting and the accumulation are fused so each LDR pixel is only visited once
+static void	AccumulateExposure( const bfloat4* _linearRGB, U32 _count, const List< bfloat3 >& _responseCurve, bool _luminanceOnly, float _imageEV, bfloat4* _sumHDR, bfloat3* _sumWeights ) {
+	const U32		responseCurveSize = U32(_responseCurve.Count());
+	const U32		Zmax = responseCurveSize-1;
+
+	// Response curve channels, strided by 3 floats
+	const float*	curveR = &_responseCurve.Ptr()->x;
+	const float*	curveG = _luminanceOnly ? curveR : &_responseCurve.Ptr()->y;
+	const float*	curveB = _luminanceOnly ? curveR : &_responseCurve.Ptr()->z;
+
+	U32		Zr, Zg, Zb;
+	bfloat3	weight;
+	for ( U32 X=0; X < _count; X++, _linearRGB++, _sumHDR++, _sumWeights++ ) {
+		// Retrieve LDR values for RGB
+		Zr = CLAMP( U32( Zmax * _linearRGB->x ), 0U, Zmax );
+		Zg = CLAMP( U32( Zmax * _linearRGB->y ), 0U, Zmax );
+		Zb = CLAMP( U32( Zmax * _linearRGB->z ), 0U, Zmax );
+
+		// Compute weights
+		weight.x = ComputeWeight( Zr, responseCurveSize );
+		weight.y = ComputeWeight( Zg, responseCurveSize );
+		weight.z = ComputeWeight( Zb, responseCurveSize );
+
+		// Accumulate weighted response
+		_sumHDR->x += weight.x * (curveR[3*Zr] - _imageEV);
+		_sumHDR->y += weight.y * (curveG[3*Zg] - _imageEV);
+		_sumHDR->z += weight.z * (curveB[3*Zb] - _imageEV);
+
+		// Accumulate weight
+		*_sumWeights += weight;
+	}
+}
+
+// Divides the accumulated log2 radiances by their weights and retrieves linear radiance in place
+static void	ResolveRadiance( bfloat4* _HDR, const bfloat3* _sumWeights, U32 _count, float _luminanceFactor ) {
+	for ( U32 X=0; X < _count; X++, _HDR++, _sumWeights++ ) {
+		bfloat4&	temp = *_HDR;
+
+		// Retrieve log2(E)
+		temp.x *= _luminanceFactor / _sumWeights->x;
+		temp.y *= _luminanceFactor / _sumWeights->y;
+		temp.z *= _luminanceFactor / _sumWeights->z;
+
+		// Retrieve linear radiance
+		temp.x = powf( 2.0f, temp.x );
+		temp.y = powf( 2.0f, temp.y );
+		temp.z = powf( 2.0f, temp.z );
+
+		temp.w = 1.0f;	// Force alpha to 1
+	}
+}
+
+// Converts a scanline of an LDR image into linear RGB, in place
+static void	ScanlineToLinearRGB( const ImageFile& _image, U32 _Y, const ColorProfile& _linearProfile, bfloat4* _scanline ) {
+	const ColorProfile&	imageProfile = _image.GetColorProfile();
+	U32					W = _image.Width();
+	_image.ReadScanline( _Y, _scanline );
+	imageProfile.RGB2XYZ( _scanline, _scanline, W );
+	_linearProfile.XYZ2RGB( _scanline, _scanline, W );
+}
+
+// Amount of scanlines per band so each thread gets several bands to balance the load
+static U32	HDRBandHeight( U32 _height ) {
+	return MAX( 1U, _height / (4 * ThreadPool::Default().GetThreadsCount()) );
+}
+
 void	Bitmap::LDR2HDR( U32 _imagesCount, const ImageFile** _images, const float* _imageShutterSpeeds, const List< bfloat3 >& _responseCurve, bool _luminanceOnly, float _luminanceFactor ) {
 	if ( _images == nullptr )
 		throw "Invalid images array!";
@@ -135,13 +206,45 @@ void	Bitmap::LDR2HDR( U32 _imagesCount, const ImageFile** _images, const float*
 	U32		H = _images[0]->Height();
 	Init( W, H );
 
-	U32		responseCurveSize = U32(_responseCurve.Count());
-
 	ColorProfile	linearProfile( ColorProfile::STANDARD_PROFILE::LINEAR );
 
+#if 1
+	List< float >	imageEVs( _imagesCount );
+	for ( U32 imageIndex=0; imageIndex < _imagesCount; imageIndex++ )
+		imageEVs.Append( log2f( _imageShutterSpeeds[imageIndex] ) );
+
+	// The image is split into horizontal bands processed in parallel
+	// Each scanline of each exposure is decoded once and merged into the target scanline before moving to the next one,
+	//	so the weights only need to be stored for a single scanline
+	ThreadPool::Default().ParallelForRange( H, HDRBandHeight( H ), [&]( U32 _startY, U32 _endY, U32 _threadIndex ) {
+		List< bfloat4 >	scanline;
+		List< bfloat3 >	sumWeights;
+		scanline.SetCount( W );
+		sumWeights.SetCount( W );
+
+		for ( U32 Y=_startY; Y < _endY; Y++ ) {
+			//////////////////////////////////////////////////////////////////////////
+			// 1] Recompose HDR scanline into the XYZ buffer (still RGB but it will be converted into XYZ at the end)
+			bfloat4*	targetHDR = m_XYZ + W*Y;
+			memset( sumWeights.Ptr(), 0, W*sizeof(bfloat3) );
+			for ( U32 imageIndex=0; imageIndex < _imagesCount; imageIndex++ ) {
+				ScanlineToLinearRGB( *_images[imageIndex], Y, linearProfile, scanline.Ptr() );
+				AccumulateExposure( scanline.Ptr(), W, _responseCurve, _luminanceOnly, imageEVs[imageIndex], targetHDR, sumWeights.Ptr() );
+			}
+
+			//////////////////////////////////////////////////////////////////////////
+			// 2] Divide by weights and retrieve linear radiance
+			ResolveRadiance( targetHDR, sumWeights.Ptr(), W, _luminanceFactor );
+
+			//////////////////////////////////////////////////////////////////////////
+			// 3] Convert into XYZ using a linear profile
+			linearProfile.RGB2XYZ( targetHDR, targetHDR, W );
+		}
+	} );
+
+#else
+	U32		responseCurveSize = U32(_responseCurve.Count());
 
-	//////////////////////////////////////////////////////////////////////////
-	// 1] Recompose HDR image into the XYZ buffer (still RGB but it will be converted into XYZ at the end)
 	bfloat3*	sumWeights = new bfloat3[W*H];
 	memset( sumWeights, 0, W*H*sizeof(bfloat3) );
 	bfloat4*	scanline = new bfloat4[W];
@@ -155,84 +258,6 @@ void	Bitmap::LDR2HDR( U32 _imagesCount, const ImageFile** _images, const float*
 	bfloat4		colorLDR_XYZ;
 	bfloat4		colorLDR_xyY;
 
-#if 1
-	for ( U32 imageIndex=0; imageIndex < _imagesCount; imageIndex++ ) {
-		const ImageFile&	image = *_images[imageIndex];
-		const ColorProfile&	imageProfile = image.GetColorProfile();
-		float				shutterSpeed = _imageShutterSpeeds[imageIndex];
-		float				imageEV = log2f( shutterSpeed );
-
-		targetHDR = m_XYZ;
-		targetWeights = sumWeights;
-		for ( U32 Y=0; Y < H; Y++ ) {
-			image.ReadScanline( Y, scanline );
-			bfloat4*	scanlinePtr = scanline;
-			for ( U32 X=0; X < W; X++, scanlinePtr++, targetHDR++, targetWeights++ ) {
-				imageProfile.RGB2XYZ( *scanlinePtr, colorLDR_XYZ );
-				linearProfile.XYZ2RGB( colorLDR_XYZ, colorLDR_RGB_Linear );
-
-// 				if ( colorLDR_RGB_Linear.x < -1e-3f || colorLDR_RGB_Linear.x > 1.001f ) throw "PROUT!";
-// 				if ( colorLDR_RGB_Linear.y < -1e-3f || colorLDR_RGB_Linear.y > 1.001f ) throw "PROUT!";
-// 				if ( colorLDR_RGB_Linear.z < -1e-3f || colorLDR_RGB_Linear.z > 1.001f ) throw "PROUT!";
-
-				// Retrieve LDR values for RGB
-// 				Zr = CLAMP( U32( (responseCurveSize-1) * scanlinePtr->x ), 0U, responseCurveSize-1 );
-// 				Zg = CLAMP( U32( (responseCurveSize-1) * scanlinePtr->y ), 0U, responseCurveSize-1 );
-// 				Zb = CLAMP( U32( (responseCurveSize-1) * scanlinePtr->z ), 0U, responseCurveSize-1 );
-				Zr = CLAMP( U32( (responseCurveSize-1) * colorLDR_RGB_Linear.x ), 0U, responseCurveSize-1 );
-				Zg = CLAMP( U32( (responseCurveSize-1) * colorLDR_RGB_Linear.y ), 0U, responseCurveSize-1 );
-				Zb = CLAMP( U32( (responseCurveSize-1) * colorLDR_RGB_Linear.z ), 0U, responseCurveSize-1 );
-
-				// Compute weights
-				weight.x = ComputeWeight( Zr, responseCurveSize );
-				weight.y = ComputeWeight( Zg, responseCurveSize );
-				weight.z = ComputeWeight( Zb, responseCurveSize );
-
-				// Accumulate weighted response
-				response.x = _responseCurve[Zr].x - imageEV;
-				response.y = _responseCurve[Zg].y - imageEV;
-				response.z = _responseCurve[Zb].z - imageEV;
-
-				targetHDR->x += weight.x * response.x;
-				targetHDR->y += weight.y * response.y;
-				targetHDR->z += weight.z * response.z;
-
-				// Accumulate weight
-				*targetWeights += weight;
-			}
-		}
-	}
-
-	//////////////////////////////////////////////////////////////////////////
-	// 2] Divide by weights and retrieve linear radiance
-	targetHDR = m_XYZ;
-	targetWeights = sumWeights;
-	for ( U32 Y=0; Y < H; Y++ ) {
-		for ( U32 X=0; X < W; X++, targetHDR++, targetWeights++ ) {
-			bfloat4&	temp = *targetHDR;
-
-			// Retrieve log2(E)
-			temp.x *= _luminanceFactor / targetWeights->x;
-			temp.y *= _luminanceFactor / targetWeights->y;
-			temp.z *= _luminanceFactor / targetWeights->z;
-
-			// Retrieve linear radiance
-			temp.x = powf( 2.0f, temp.x );
-			temp.y = powf( 2.0f, temp.y );
-			temp.z = powf( 2.0f, temp.z );
-
-			temp.w = 1.0f;	// Force alpha to 1
-		}
-	}
-
-	delete[] scanline;
-	delete[] sumWeights;
-
-	//////////////////////////////////////////////////////////////////////////
-	// 3] Convert into XYZ using a linear profile
-	linearProfile.RGB2XYZ( m_XYZ, m_XYZ, W*H );
-
-#else
 	for ( U32 imageIndex=0; imageIndex < _imagesCount; imageIndex++ ) {
 		const ImageFile&	image = *_images[imageIndex];
 		const ColorProfile&	imageProfile = image.GetColorProfile();
@@ -369,16 +394,73 @@ void	Bitmap::LDR2HDR( U32 _imagesCount, const ImageFile** _images, const float*
 #endif
 }
 
+void	Bitmap::LDR2HDR( U32 _imagesCount, const wchar_t** _imageFileNames, const float* _imageShutterSpeeds, const List< bfloat3 >& _responseCurve, bool _luminanceOnly, float _luminanceFactor ) {
+	if ( _imageFileNames == nullptr )
+		throw "Invalid image file names array!";
+	if ( _imageShutterSpeeds == nullptr )
+		throw "Invalid shutter speeds array!";
+
+	ColorProfile	linearProfile( ColorProfile::STANDARD_PROFILE::LINEAR );
+
+	// Only a single exposure is kept in memory at a time: each one is loaded and merged in parallel before being replaced by the next one
+	// Since the weights must be kept for the entire image between exposures, this is a bit slower than the version taking images from memory
+	// The weights live in a List so they're released if loading an image throws
+	ImageFile		image;
+	List< bfloat3 >	sumWeights;
+	U32				W = 0, H = 0;
+	for ( U32 imageIndex=0; imageIndex < _imagesCount; imageIndex++ ) {
+		image.Load( _imageFileNames[imageIndex] );
+		if ( imageIndex == 0 ) {
+			W = image.Width();
+			H = image.Height();
+			Init( W, H );
+			sumWeights.SetCount( W*H );	// Default-constructed bfloat3 are zero
+		} else if ( image.Width() != W || image.Height() != H ) {
+			throw "All the images must have the same dimensions!";
+		}
+
+		//////////////////////////////////////////////////////////////////////////
+		// 1] Recompose HDR image into the XYZ buffer (still RGB but it will be converted into XYZ at the end)
+		float	imageEV = log2f( _imageShutterSpeeds[imageIndex] );
+		ThreadPool::Default().ParallelForRange( H, HDRBandHeight( H ), [&]( U32 _startY, U32 _endY, U32 _threadIndex ) {
+			List< bfloat4 >	scanline;
+			scanline.SetCount( W );
+			for ( U32 Y=_startY; Y < _endY; Y++ ) {
+				ScanlineToLinearRGB( image, Y, linearProfile, scanline.Ptr() );
+				AccumulateExposure( scanline.Ptr(), W, _responseCurve, _luminanceOnly, imageEV, m_XYZ + W*Y, sumWeights.Ptr() + W*Y );
+			}
+		} );
+	}
+	if ( sumWeights.Count() == 0 )
+		throw "Invalid images count!";
+
+	ThreadPool::Default().ParallelForRange( H, HDRBandHeight( H ), [&]( U32 _startY, U32 _endY, U32 _threadIndex ) {
+		//////////////////////////////////////////////////////////////////////////
+		// 2] Divide by weights and retrieve linear radiance
+		bfloat4*	targetHDR = m_XYZ + W*_startY;
+		U32			count = W*(_endY - _startY);
+		ResolveRadiance( targetHDR, sumWeights.Ptr() + W*_startY, count, _luminanceFactor );
+
+		//////////////////////////////////////////////////////////////////////////
+		// 3] Convert into XYZ using a linear profile
+		linearProfile.RGB2XYZ( targetHDR, targetHDR, count );
+	} );
+}
+
 void svdcmp( int m, int n, float** a, float w[], float** v );
 void svdcmp_ORIGINAL( int m, int n, float** a, float w[], float** v );
 
 //#define DEBUG_LINEAR_SIGNAL	// Define this to inject a linear sensor response for debugging purpose
 
+static const U32	MAX_RESPONSE_CURVE_BITS = 14;					// The response curve is solved with a dense 2^bits x 2^bits matrix (i.e. 2 GiB for 14 bits)
+static const U32	MAX_PARALLEL_RESPONSE_CURVE_SIZE = 1U << 10;	// Larger curves solve their components one after another to bound the memory usage
+
 void	Bitmap::ComputeCameraResponseCurve( U32 _imagesCount, const ImageFile** _images, const float* _imageShutterSpeeds, U32 _inputBitsPerComponent, float _curveSmoothnessConstraint, float _quality, bool _luminanceOnly, List< bfloat3 >& _responseCurve ) {
 	if ( _images == nullptr )
 		throw "Invalid images array!";
 	if ( _imageShutterSpeeds == nullptr )
 		throw "Invalid shutter speeds array!";
+	RELEASE_ASSERT( _inputBitsPerComponent > 0 && _inputBitsPerComponent <= MAX_RESPONSE_CURVE_BITS, "Unsupported amount of bits per component!" );
 
 	U32		W = _images[0]->Width();
 	U32		H = _images[0]->Height();
@@ -426,9 +508,8 @@ Hammersley::BuildSequence( pixelsCountPerImage, sequence );
 	U32		componentsCount = _luminanceOnly ? 1 : 3;
 
 	U32*	pixels = new U32[3 *totalPixelsCount];
-	for ( U32 componentIndex=0; componentIndex < componentsCount; componentIndex++ ) {	// Because R, G, B
 
-		// 1] Select the pixels within the images that best cover the [Zmin,Zmax] range
+	// 1] Select the pixels within the images that best cover the [Zmin,Zmax] range
 // @TODO!
 // @TODO!
 // @TODO!
@@ -437,11 +518,14 @@ Hammersley::BuildSequence( pixelsCountPerImage, sequence );
 // @TODO!
 // @TODO!
 
-		// 2] Store as integer pixel values within range [Zmin,Zmax] (which is [0,2^bitDepth[ )
-		const bfloat2*	sequencePtr = sequence.Ptr();
+	// 2] Store as integer pixel values within range [Zmin,Zmax] (which is [0,2^bitDepth[ )
+	// Samples are processed in parallel and each sample is converted once for all the components
+	ThreadPool::Default().ParallelForRange( sequence.Count(), 16, [&]( U32 _start, U32 _end, U32 _threadIndex ) {
+		bfloat4	neighborhood[17];
 		bfloat4	colorLDR_RGB, colorLDR_XYZ, colorLDR_RGB_Linear;
 
-		for ( U32 pixelIndex=0; pixelIndex < sequence.Count(); pixelIndex++, sequencePtr++ ) {
+		const bfloat2*	sequencePtr = sequence.Ptr() + _start;
+		for ( U32 pixelIndex=_start; pixelIndex < _end; pixelIndex++, sequencePtr++ ) {
 			U32	X = U32( floorf( sequencePtr->x * (W-1) ) );
 			U32	Y = U32( floorf( sequencePtr->y * (H-1) ) );
 
@@ -451,26 +535,22 @@ Hammersley::BuildSequence( pixelsCountPerImage, sequence );
 
 				const ColorProfile&	imageProfile = image.GetColorProfile();
 
-				// Get floating point value of the selected pixel for R, G or B
+				// Get floating point value of the selected pixel
 				#if 1
 					// Use an average of neighbor pixels
-					S32	X0 = MAX( 0, S32(X) - 8 );
-					S32	X1 = MIN( S32(W-1), S32(X) + 8 );
-					S32	Y0 = MAX( 0, S32(Y) - 8 );
-					S32	Y1 = MIN( S32(H-1), S32(Y) + 8 );
+					U32	X0 = U32( MAX( 0, S32(X) - 8 ) );
+					U32	X1 = U32( MIN( S32(W-1), S32(X) + 8 ) );
+					U32	Y0 = U32( MAX( 0, S32(Y) - 8 ) );
+					U32	Y1 = U32( MIN( S32(H-1), S32(Y) + 8 ) );
+					U32	count = 1+X1-X0;
 					bfloat4	sum_XYZ( 0, 0, 0, 0 );
-					for ( S32 CY=Y0; CY <= Y1; CY++ )
-						for ( S32 CX=X0; CX <= X1; CX++ ) {
-							image.Get( CX, CY, colorLDR_RGB );
-							imageProfile.RGB2XYZ( colorLDR_RGB, colorLDR_XYZ );	// Transform into linear XYZ
-							sum_XYZ += colorLDR_XYZ;
-//sum_XYZ += colorLDR;
-// colorLDR.x = powf( colorLDR.x, 2.2f );
-// colorLDR.y = powf( colorLDR.y, 2.2f );
-// colorLDR.z = powf( colorLDR.z, 2.2f );
-// sum_XYZ.x += colorLDR.Dot( LUMINANCE_D65 );
-						}
-					colorLDR_XYZ = sum_XYZ / float( (1+X1-X0)*(1+Y1-Y0) );
+					for ( U32 CY=Y0; CY <= Y1; CY++ ) {
+						image.ReadScanline( CY, neighborhood, X0, count );
+						imageProfile.RGB2XYZ( neighborhood, neighborhood, count );	// Transform into linear XYZ
+						for ( U32 CX=0; CX < count; CX++ )
+							sum_XYZ += neighborhood[CX];
+					}
+					colorLDR_XYZ = sum_XYZ / float( count*(1+Y1-Y0) );
 				#else
 					image.Get( X, Y, colorLDR_RGB );
 
@@ -478,139 +558,147 @@ Hammersley::BuildSequence( pixelsCountPerImage, sequence );
 					imageProfile.RGB2XYZ( colorLDR_RGB, colorLDR_XYZ );
 				#endif
 
-				float	pixelValue;
-				if ( _luminanceOnly ) {
-					// Use luminance directly
-					pixelValue = colorLDR_XYZ.y;
-//pixelValue = colorLDR_XYZ.Dot( LUMINANCE_D65 );
-//pixelValue = colorLDR_XYZ.x;
-// colorLDR_XYZ.x = powf( colorLDR_XYZ.x, 2.2f );
-// colorLDR_XYZ.y = powf( colorLDR_XYZ.y, 2.2f );
-// colorLDR_XYZ.z = powf( colorLDR_XYZ.z, 2.2f );
-// pixelValue = colorLDR_XYZ.Dot( LUMINANCE_D65 );
-
-				} else {
-					// Transform back into linear RGB
-					linearProfile.XYZ2RGB( colorLDR_XYZ, colorLDR_RGB );
-					pixelValue = ((float*) &colorLDR_RGB.x)[componentIndex];
-				}
+				// Transform back into linear RGB
+				if ( !_luminanceOnly )
+					linearProfile.XYZ2RGB( colorLDR_XYZ, colorLDR_RGB_Linear );
+
+				for ( U32 componentIndex=0; componentIndex < componentsCount; componentIndex++ ) {	// Because R, G, B
+					float	pixelValue = _luminanceOnly	? colorLDR_XYZ.y	// Use luminance directly
+														: ((float*) &colorLDR_RGB_Linear.x)[componentIndex];
 
 #ifdef DEBUG_LINEAR_SIGNAL
 pixelValue = SATURATE( float(1+pixelIndex) / sequence.Count() * powf( 2.0f, -float(imageIndex) ) );
 #endif
 
-				// Convert to integer value
-				U32		Z = CLAMP( U32( (responseCurveSize-1) * pixelValue ), 0U, responseCurveSize-1 );
+					// Convert to integer value
+					U32		Z = CLAMP( U32( (responseCurveSize-1) * pixelValue ), 0U, responseCurveSize-1 );
 
-				pixels[totalPixelsCount*componentIndex + pixelsCountPerImage*imageIndex + pixelIndex] = Z;
+					pixels[totalPixelsCount*componentIndex + pixelsCountPerImage*imageIndex + pixelIndex] = Z;
+				}
 			}
 		}
-	}
+	} );
 
 
 	//////////////////////////////////////////////////////////////////////////
-	// 2] Apply SVD 
+	// 2] Solve for the response curve
 	const float	lambda = _curveSmoothnessConstraint;
 
 #if 1
-	U32	equationsCount  = totalPixelsCount		// Pixels
-						+ responseCurveSize		// Used to enforce the smoothness of the g curve
-						+ 1;					// Constraint that g(Zmid) = 0 (with Zmid = (Zmax+Zmin)/2)
-
-	U32	unknownsCount	= responseCurveSize		// g(Z) = curve solution
-						+ pixelsCountPerImage;	// log(E) for each pixel
+	// Debevec's system of equations has a very specific structure:
+	//	 Each of the N*P data equations Wij.(g(Zij) - ln(Ei)) = Wij.ln(DeltaTj) only involves a single g() unknown and a single ln(Ei) unknown
+	//	 Each of the smoothness equations only involves 3 consecutive g() unknowns
+	//
+	// Instead of decomposing the entire (N*P + Zcount + 1) x (Zcount + N) matrix with a SVD, we directly assemble the normal equations A^T.A.x = A^T.b
+	//	whose ln(Ei) block is diagonal. These unknowns are eliminated pixel by pixel (i.e. Schur complement) so we only need to solve a Zcount x Zcount
+	//	system for g() with a Cholesky decomposition.
+	// The assembly is linear in the amount of pixels and the solve only depends on the response curve size, so the amount of pixels is not a bottleneck anymore.
+	//
+	List< double >	imageEVs( _imagesCount );
+	for ( U32 imageIndex=0; imageIndex < _imagesCount; imageIndex++ ) {
+		// Compute image EV = log2(shutterSpeed)
+		// (e.g. taking 3 shots in bracket mode with shutter speeds [1/4s, 1s, 4s] will yield EV array [-2, 0, +2] respectively)
+		//
+		float	imageShutterSpeed = _imageShutterSpeeds[imageIndex];
+		float	imageEV = log2f( imageShutterSpeed );
 
-	MathSolversLib::SVD			SVD( equationsCount, unknownsCount );
-	MathSolversLib::VectorF		b( equationsCount );
-	MathSolversLib::VectorF		x( unknownsCount );
+#ifdef DEBUG_LINEAR_SIGNAL
+imageEV = -float(imageIndex);
+#endif
 
-	U32*		pixelPtr = pixels;
-	for ( U32 componentIndex=0; componentIndex < componentsCount; componentIndex++ ) {	// Because R, G, B
+		imageEVs.Append( imageEV );
+	}
 
-		// ===================================================================
-		// 2.1] Build the "A" matrix and target vector "b"
-		SVD.A.Clear();
+	// Each component needs a dense Zcount x Zcount matrix (i.e. 128 MiB for 12-bits input) so the components are only solved in parallel for small curves
+	auto	SolveComponent = [&]( U32 _componentIndex, U32 _threadIndex ) {
+		MathSolversLib::Cholesky	cholesky( responseCurveSize );
+		MathSolversLib::VectorD		b( responseCurveSize );
+		MathSolversLib::VectorD		x( responseCurveSize );
+		MathSolversLib::MatrixD&	S = cholesky.M;
+		S.Clear();
 		b.Clear();
 
-		// 2.1.1) Fill the first part of the equations containing our data
-		MathSolversLib::VectorF*	A1 = &SVD.A[0];	// A1 starts at A
-		for ( U32 imageIndex=0; imageIndex < _imagesCount; imageIndex++ ) {
-
-			// Compute image EV = log2(shutterSpeed)
-			// (e.g. taking 3 shots in bracket mode with shutter speeds [1/4s, 1s, 4s] will yield EV array [-2, 0, +2] respectively)
-			//
-			float	imageShutterSpeed = _imageShutterSpeeds[imageIndex];
-			float	imageEV = log2f( imageShutterSpeed );
-
-#ifdef DEBUG_LINEAR_SIGNAL
-imageEV = -float(imageIndex);
-#endif
+		// ===================================================================
+		// 2.1] Accumulate the smoothness equations
+		// This part will ensure the g() curve's smoothness
+		double	weight = lambda * ComputeWeight( 0, responseCurveSize );	// First element can't reach neighbors
+		S[0][0] += weight * weight;
+		U32		Z = 1;
+		for ( ; Z < responseCurveSize-1; Z++ ) {
+			weight = lambda * ComputeWeight( Z, responseCurveSize );
+			const double	coefficients[3] = { weight, -2.0 * weight, weight };
+			for ( U32 i=0; i < 3; i++ )
+				for ( U32 j=0; j < 3; j++ )
+					S[Z-1+i][Z-1+j] += coefficients[i] * coefficients[j];
+		}
+		weight = lambda * ComputeWeight( Z, responseCurveSize );			// Last element can't reach neighbors either
+		S[Z][Z] += weight * weight;
 
-			for ( int pixelIndex=0; pixelIndex < pixelsCountPerImage; pixelIndex++, A1++ ) {
+		// Accumulate the equation used to ensure the Zmid value transforms into g(Zmid) = 0
+		S[responseCurveSize>>1][responseCurveSize>>1] += 1.0;
 
+		// ===================================================================
+		// 2.2] Accumulate the data equations
+		List< U32 >		pixelZ;
+		List< double >	pixelSqWeights;
+		pixelZ.SetCount( _imagesCount );
+		pixelSqWeights.SetCount( _imagesCount );
+		const U32*	componentPixels = pixels + totalPixelsCount*_componentIndex;
+		for ( int pixelIndex=0; pixelIndex < pixelsCountPerImage; pixelIndex++ ) {
+			double	sumSqWeights = 0.0;	// Diagonal term of ln(Ei)
+			double	sumSqWeightedEV = 0.0;	// Right-hand side of ln(Ei)
+			for ( U32 imageIndex=0; imageIndex < _imagesCount; imageIndex++ ) {
 				// Zij = pixel value for selected pixel i in image j
-				U32		Z = *pixelPtr++;
+				U32		Zij = componentPixels[pixelsCountPerImage*imageIndex + pixelIndex];
 
 				// Weight based on Z position within the range [Zmin,Zmax]
-				float	Wij = ComputeWeight( Z, responseCurveSize );
+				double	Wij = ComputeWeight( Zij, responseCurveSize );
+				double	sqWij = Wij * Wij;
 
-				// First weight g(Zi)
-				(*A1)[Z] = Wij;
+				S[Zij][Zij] += sqWij;
+				b[Zij] += sqWij * imageEVs[imageIndex];
+				sumSqWeights += sqWij;
+				sumSqWeightedEV -= sqWij * imageEVs[imageIndex];
 
-				// Next, weight ln(Ei)
-				(*A1)[responseCurveSize + pixelIndex] = -Wij;
+				pixelZ[imageIndex] = Zij;
+				pixelSqWeights[imageIndex] = sqWij;
+			}
 
-				// And subtract weighted EV = log2(DeltaT)
-				b[pixelsCountPerImage*imageIndex + pixelIndex] = Wij * imageEV;
+			// Eliminate ln(Ei) whose coefficient in the equations of g(Zij) is -Wij
+			for ( U32 i=0; i < _imagesCount; i++ ) {
+				double	factor = pixelSqWeights[i] / sumSqWeights;
+				b[pixelZ[i]] += factor * sumSqWeightedEV;
+				for ( U32 j=0; j < _imagesCount; j++ )
+					S[pixelZ[i]][pixelZ[j]] -= factor * pixelSqWeights[j];
 			}
 		}
 
-		// 2.1.2) Fill the second part of the equations containing weighted smoothing coefficients
-		// This part will ensure the g() curve's smoothness
-		MathSolversLib::VectorF*	A2 = &SVD.A[totalPixelsCount];	// A2 starts at the end of A's first part, A1
-
-		A2[0][0] = lambda * ComputeWeight( 0, responseCurveSize );	// First element can't reach neighbors
-		U32		Z = 1;
-		for ( ; Z < responseCurveSize-1; Z++ ) {
-			float	Weight = lambda * ComputeWeight( Z, responseCurveSize );
-			A2[Z][Z-1] = Weight;
-			A2[Z][Z+0] = -2.0f * Weight;
-			A2[Z][Z+1] = Weight;
-		}
-		A2[Z][Z] = lambda * ComputeWeight( Z, responseCurveSize );	// Last element can't reach neighbors either
-
-		// 2.1.3) Fill the last equation used to ensure the Zmid value transforms into g(Zmid) = 0
-		MathSolversLib::VectorF*	A3 = &SVD.A[totalPixelsCount+responseCurveSize];	// A3 starts at the end of A's second part and should actually be the last row of A
-
-		A3[0][responseCurveSize>>1] = 1;	// Make sure g(Zmid) maps to 0
-
 		// ===================================================================
-		// 2.2] Apply SVD
-		SVD.Decompose();
-
-		// ===================================================================
-		// 2.3] Solve for x
-		// We know that A was decomposed into U.w.V^T where U and V are orthonormal matrices and w a diagonal matrix with (theoretically) non null components
-		//	so A^-1 = V.1/w.U^T
-		// Since A.x = b it ensues that x = A^-1.b
-		//
-		SVD.Solve( b, x );
+		// 2.3] Solve for g()
+		cholesky.Decompose();
+		cholesky.Solve( b, x );
 
 		// ===================================================================
 		// 2.4] Recover curve values
-		// At this point, we recovered the g(Z) for Z[Zmin,Zmax], followed by the log2(Ei) for the N selected pixels
+		// At this point, we recovered the g(Z) for Z[Zmin,Zmax] (the log2(Ei) for the N selected pixels were eliminated)
 		// Let's just store the g(Z) into our target array
 		if ( _luminanceOnly ) {
 			for ( U32 Z=0; Z < responseCurveSize; Z++ ) {
-				_responseCurve[Z].Set( x[Z], x[Z], x[Z] );
+				float	g = float( x[Z] );
+				_responseCurve[Z].Set( g, g, g );
 			}
 		} else {
 			for ( U32 Z=0; Z < responseCurveSize; Z++ ) {
-				((float*) &_responseCurve[Z].x)[componentIndex] = x[Z];
+				((float*) &_responseCurve[Z].x)[_componentIndex] = float( x[Z] );
 			}
 		}
+	};
+	if ( responseCurveSize <= MAX_PARALLEL_RESPONSE_CURVE_SIZE ) {
+		ThreadPool::Default().ParallelFor( componentsCount, SolveComponent );
+	} else {
+		for ( U32 componentIndex=0; componentIndex < componentsCount; componentIndex++ )
+			SolveComponent( componentIndex, 0 );
 	}
-
 #else
 
 #if 0
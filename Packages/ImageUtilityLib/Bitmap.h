@@ -146,6 +146,7 @@ static ImageFile*	ms_DEBUG;
 		public:
 			// The amount of bits per (R,G,B) component the camera is able to output
 			// Usually, for RAW input images are either 12- or 16-bits depending on model while non-RAW outputs (e.g. JPG or PNG) are simply 8-bits
+			// At most 14 bits are supported since the response curve is solved with a dense 2^bits x 2^bits matrix, 16-bits RAW images must be quantized first
 			U32		_inputBitsPerComponent;
 
 			//	The default luminance factor to apply to all the images
@@ -189,10 +190,15 @@ static ImageFile*	ms_DEBUG;
 		//	_images, the array of LDR bitmaps
 		//	_imageShutterSpeeds, the array of shutter speeds (in seconds) used for each image
 		//	_responseCurve, the list of values corresponding to the response curve
-		//	_luminanceOnly, if true then response curve is assumed to contain a single channel only
+		//	_luminanceOnly, if true then response curve is assumed to contain a single channel only (X) that is applied to all 3 RGB components
 		//	The default luminance factor to apply to all the images (allows you to scale the base luminance if you know the absolute value)
 		void		LDR2HDR( U32 _imagesCount, const ImageFile** _images, const float* _imageShutterSpeeds, const BaseLib::List< bfloat3 >& _responseCurve, bool _luminanceOnly, float _luminanceFactor );
 
+		// Same as above except the LDR images are streamed from disk so only a single exposure is held in memory at a time
+		// Use this method for large brackets of high resolution images that wouldn't fit in memory all at once
+		//	_imageFileNames, the array of LDR image file names (all the images must have the same dimensions)
+		void		LDR2HDR( U32 _imagesCount, const wchar_t** _imageFileNames, const float* _imageShutterSpeeds, const BaseLib::List< bfloat3 >& _responseCurve, bool _luminanceOnly, float _luminanceFactor );
+
 		// Computes the response curve of the sensor that captured the provided LDR images
 		//	_images, the array of LDR bitmaps
 		//	_imageShutterSpeeds, the array of shutter speeds (in seconds) used for each image
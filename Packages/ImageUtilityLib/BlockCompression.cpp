@@ -0,0 +1,800 @@
+#include "stdafx.h"
+#include "BlockCompression.h"
+#include "..\BaseLib\Math\SIMD.h"
+
+using namespace ImageUtilityLib;
+using namespace BaseLib;
+
+#pragma region Block Helpers
+
+// A 4x4 block of texels stored as separate channels so 4 texels can be processed at once
+struct	TexelsBlock {
+	float	channels[4][16];
+};
+
+// Finds the closest palette entry for each texel, using the first _channelsCount channels
+//	Texels whose bit is set in _excludedMask don't contribute to the error (their index is meaningless)
+//	Returns the sum of the squared errors
+static float	FindClosestEntries( const TexelsBlock& _block, U32 _channelsCount, const float _palette[][4], U32 _entriesCount, U32 _excludedMask, U8 _indices[16] ) {
+	const __m128i	laneBits = _mm_setr_epi32( 1, 2, 4, 8 );
+
+	__m128	sumErrors = _mm_setzero_ps();
+	for ( U32 groupIndex=0; groupIndex < 4; groupIndex++ ) {
+		__m128	values[4];
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			values[channelIndex] = _mm_loadu_ps( &_block.channels[channelIndex][4*groupIndex] );
+		}
+
+		__m128	bestErrors = _mm_set1_ps( FLT_MAX );
+		__m128i	bestIndices = _mm_setzero_si128();
+		for ( U32 entryIndex=0; entryIndex < _entriesCount; entryIndex++ ) {
+			__m128	errors = _mm_setzero_ps();
+			for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+				__m128	delta = _mm_sub_ps( values[channelIndex], _mm_set1_ps( _palette[entryIndex][channelIndex] ) );
+				errors = _mm_add_ps( errors, _mm_mul_ps( delta, delta ) );
+			}
+			__m128	closer = _mm_cmplt_ps( errors, bestErrors );
+			bestErrors = _mm_min_ps( errors, bestErrors );
+			bestIndices = SIMD::Select( _mm_castps_si128( closer ), _mm_set1_epi32( entryIndex ), bestIndices );
+		}
+
+		__m128i	excluded = _mm_cmpeq_epi32( _mm_and_si128( _mm_set1_epi32( _excludedMask >> (4*groupIndex) ), laneBits ), laneBits );
+		sumErrors = _mm_add_ps( sumErrors, _mm_andnot_ps( _mm_castsi128_ps( excluded ), bestErrors ) );
+
+		U32	indices[4];
+		_mm_storeu_si128( (__m128i*) indices, bestIndices );
+		for ( U32 i=0; i < 4; i++ ) {
+			_indices[4*groupIndex+i] = U8( indices[i] );
+		}
+	}
+
+	float	errors[4];
+	_mm_storeu_ps( errors, sumErrors );
+	return (errors[0] + errors[1]) + (errors[2] + errors[3]);
+}
+
+// Computes the mean of the texels (excluding the ones whose bit is set in _excludedMask)
+//	Returns the amount of texels that were used
+static U32		ComputeMean( const TexelsBlock& _block, U32 _channelsCount, U32 _excludedMask, float _mean[4] ) {
+	U32	count = 0;
+	for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+		_mean[channelIndex] = 0.0f;
+	}
+	for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+		if ( _excludedMask & (1 << texelIndex) )
+			continue;
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			_mean[channelIndex] += _block.channels[channelIndex][texelIndex];
+		}
+		count++;
+	}
+	if ( count > 0 ) {
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			_mean[channelIndex] /= count;
+		}
+	}
+	return count;
+}
+
+// Endpoints spanning the bounding box of the texels, insetted by _inset times the box size
+//	The diagonal of the box is flipped for the channels that are anti-correlated with the channel of largest extent
+static void		ComputeBoxEndpoints( const TexelsBlock& _block, U32 _channelsCount, U32 _excludedMask, float _inset, float _endpoint0[4], float _endpoint1[4] ) {
+	float	mean[4];
+	if ( ComputeMean( _block, _channelsCount, _excludedMask, mean ) == 0 ) {
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			_endpoint0[channelIndex] = _endpoint1[channelIndex] = 0.0f;
+		}
+		return;
+	}
+
+	float	minimum[4], maximum[4];
+	U32		referenceChannelIndex = 0;
+	for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+		minimum[channelIndex] = FLT_MAX;
+		maximum[channelIndex] = -FLT_MAX;
+		for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+			if ( (_excludedMask & (1 << texelIndex)) == 0 ) {
+				minimum[channelIndex] = MIN( minimum[channelIndex], _block.channels[channelIndex][texelIndex] );
+				maximum[channelIndex] = MAX( maximum[channelIndex], _block.channels[channelIndex][texelIndex] );
+			}
+		}
+		if ( maximum[channelIndex] - minimum[channelIndex] > maximum[referenceChannelIndex] - minimum[referenceChannelIndex] )
+			referenceChannelIndex = channelIndex;
+	}
+
+	for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+		float	covariance = 0.0f;
+		for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+			if ( (_excludedMask & (1 << texelIndex)) == 0 )
+				covariance += (_block.channels[channelIndex][texelIndex] - mean[channelIndex]) * (_block.channels[referenceChannelIndex][texelIndex] - mean[referenceChannelIndex]);
+		}
+
+		float	inset = _inset * (maximum[channelIndex] - minimum[channelIndex]);
+		_endpoint0[channelIndex] = minimum[channelIndex] + inset;
+		_endpoint1[channelIndex] = maximum[channelIndex] - inset;
+		if ( covariance < 0.0f ) {
+			float	temp = _endpoint0[channelIndex];
+			_endpoint0[channelIndex] = _endpoint1[channelIndex];
+			_endpoint1[channelIndex] = temp;
+		}
+	}
+}
+
+// Endpoints spanning the extent of the texels along their principal axis, insetted by _inset times the extent
+static void		ComputeAxisEndpoints( const TexelsBlock& _block, U32 _channelsCount, U32 _excludedMask, float _inset, float _endpoint0[4], float _endpoint1[4] ) {
+	float	mean[4];
+	if ( ComputeMean( _block, _channelsCount, _excludedMask, mean ) == 0 ) {
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			_endpoint0[channelIndex] = _endpoint1[channelIndex] = 0.0f;
+		}
+		return;
+	}
+
+	// Build the covariance matrix
+	float	covariance[4][4];
+	memset( covariance, 0, sizeof(covariance) );
+	for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+		if ( _excludedMask & (1 << texelIndex) )
+			continue;
+
+		float	delta[4];
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			delta[channelIndex] = _block.channels[channelIndex][texelIndex] - mean[channelIndex];
+		}
+		for ( U32 row=0; row < _channelsCount; row++ ) {
+			for ( U32 column=0; column < _channelsCount; column++ ) {
+				covariance[row][column] += delta[row] * delta[column];
+			}
+		}
+	}
+
+	// Power iterations, starting from the column of largest variance
+	U32	startColumn = 0;
+	for ( U32 channelIndex=1; channelIndex < _channelsCount; channelIndex++ ) {
+		if ( covariance[channelIndex][channelIndex] > covariance[startColumn][startColumn] )
+			startColumn = channelIndex;
+	}
+
+	float	axis[4];
+	for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+		axis[channelIndex] = covariance[channelIndex][startColumn];
+	}
+	for ( U32 iteration=0; iteration < 8; iteration++ ) {
+		float	next[4];
+		float	largest = 0.0f;
+		for ( U32 row=0; row < _channelsCount; row++ ) {
+			next[row] = 0.0f;
+			for ( U32 column=0; column < _channelsCount; column++ ) {
+				next[row] += covariance[row][column] * axis[column];
+			}
+			largest = MAX( largest, fabsf( next[row] ) );
+		}
+		if ( largest < 1e-12f )
+			break;
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			axis[channelIndex] = next[channelIndex] / largest;
+		}
+	}
+
+	float	sqLength = 0.0f;
+	for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+		sqLength += axis[channelIndex] * axis[channelIndex];
+	}
+	if ( sqLength < 1e-12f ) {
+		// Uniform block
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			_endpoint0[channelIndex] = _endpoint1[channelIndex] = mean[channelIndex];
+		}
+		return;
+	}
+	float	invLength = 1.0f / sqrtf( sqLength );
+	for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+		axis[channelIndex] *= invLength;
+	}
+
+	// Project the texels on the axis
+	float	minT = FLT_MAX, maxT = -FLT_MAX;
+	for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+		if ( _excludedMask & (1 << texelIndex) )
+			continue;
+
+		float	t = 0.0f;
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			t += (_block.channels[channelIndex][texelIndex] - mean[channelIndex]) * axis[channelIndex];
+		}
+		minT = MIN( minT, t );
+		maxT = MAX( maxT, t );
+	}
+
+	float	inset = _inset * (maxT - minT);
+	minT += inset;
+	maxT -= inset;
+	for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+		_endpoint0[channelIndex] = CLAMP( mean[channelIndex] + minT * axis[channelIndex], 0.0f, 1.0f );
+		_endpoint1[channelIndex] = CLAMP( mean[channelIndex] + maxT * axis[channelIndex], 0.0f, 1.0f );
+	}
+}
+
+// Solves for the endpoints that best fit the texels in the least-squares sense, given the interpolation weight of each texel (i.e. texel = (1-w) * endpoint0 + w * endpoint1)
+//	Texels with a negative weight are ignored. Returns false if the system is degenerate (e.g. all the texels use the same weight)
+static bool		FitEndpoints( const TexelsBlock& _block, U32 _channelsCount, const float _weights[16], float _endpoint0[4], float _endpoint1[4] ) {
+	float	a = 0.0f, b = 0.0f, c = 0.0f;
+	float	x0[4] = { 0, 0, 0, 0 };
+	float	x1[4] = { 0, 0, 0, 0 };
+	for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+		float	w = _weights[texelIndex];
+		if ( w < 0.0f )
+			continue;
+
+		float	w0 = 1.0f - w;
+		a += w0 * w0;
+		b += w0 * w;
+		c += w * w;
+		for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+			x0[channelIndex] += w0 * _block.channels[channelIndex][texelIndex];
+			x1[channelIndex] += w * _block.channels[channelIndex][texelIndex];
+		}
+	}
+
+	float	determinant = a * c - b * b;
+	if ( fabsf( determinant ) < 1e-6f )
+		return false;
+
+	float	invDeterminant = 1.0f / determinant;
+	for ( U32 channelIndex=0; channelIndex < _channelsCount; channelIndex++ ) {
+		_endpoint0[channelIndex] = CLAMP( (c * x0[channelIndex] - b * x1[channelIndex]) * invDeterminant, 0.0f, 1.0f );
+		_endpoint1[channelIndex] = CLAMP( (a * x1[channelIndex] - b * x0[channelIndex]) * invDeterminant, 0.0f, 1.0f );
+	}
+	return true;
+}
+
+static U32		RefinementsCount( BlockCompressor::QUALITY _quality ) {
+	switch ( _quality ) {
+		case BlockCompressor::QUALITY::FAST:	return 0;
+		case BlockCompressor::QUALITY::NORMAL:	return 1;
+		default:								return 8;
+	}
+}
+
+#pragma endregion
+
+#pragma region BC1 Color Blocks
+
+struct	ColorBlock {
+	U16		color0;
+	U16		color1;
+	bool	threeColors;	// 3 colors + transparent black mode
+	U8		indices[16];
+	float	error;
+};
+
+static U16		QuantizeRGB565( const float _color[4] ) {
+	U32	R = U32( CLAMP( _color[0], 0.0f, 1.0f ) * 31.0f + 0.5f );
+	U32	G = U32( CLAMP( _color[1], 0.0f, 1.0f ) * 63.0f + 0.5f );
+	U32	B = U32( CLAMP( _color[2], 0.0f, 1.0f ) * 31.0f + 0.5f );
+	return U16( (R << 11) | (G << 5) | B );
+}
+
+static void		DecodeRGB565( U16 _color, float _RGB[4] ) {
+	U32	R = (_color >> 11) & 0x1F;
+	U32	G = (_color >> 5) & 0x3F;
+	U32	B = _color & 0x1F;
+	_RGB[0] = ((R << 3) | (R >> 2)) / 255.0f;
+	_RGB[1] = ((G << 2) | (G >> 4)) / 255.0f;
+	_RGB[2] = ((B << 3) | (B >> 2)) / 255.0f;
+	_RGB[3] = 1.0f;
+}
+
+// Evaluates a pair of quantized endpoints and keeps them if they're better than the current best
+static void		EvaluateColorEndpoints( const TexelsBlock& _block, U32 _transparentMask, U16 _color0, U16 _color1, bool _threeColors, ColorBlock& _best ) {
+	float	palette[4][4];
+	DecodeRGB565( _color0, palette[0] );
+	DecodeRGB565( _color1, palette[1] );
+	for ( U32 channelIndex=0; channelIndex < 3; channelIndex++ ) {
+		float	c0 = palette[0][channelIndex];
+		float	c1 = palette[1][channelIndex];
+		if ( _threeColors ) {
+			palette[2][channelIndex] = 0.5f * (c0 + c1);
+			palette[3][channelIndex] = 0.0f;
+		} else {
+			palette[2][channelIndex] = (2.0f * c0 + c1) / 3.0f;
+			palette[3][channelIndex] = (c0 + 2.0f * c1) / 3.0f;
+		}
+	}
+
+	ColorBlock	candidate;
+	candidate.color0 = _color0;
+	candidate.color1 = _color1;
+	candidate.threeColors = _threeColors;
+	candidate.error = FindClosestEntries( _block, 3, palette, _threeColors ? 3 : 4, _transparentMask, candidate.indices );
+	if ( candidate.error < _best.error ) {
+		_best = candidate;
+	}
+}
+
+// Encodes the RGB part of a block into a BC1 color block
+//	_transparentMask tells which texels must be transparent, this forces the 3 colors mode
+//	_allowThreeColors must be false for BC3 color blocks since they're always decoded in 4 colors mode
+static float	EncodeColorBlock( const TexelsBlock& _block, U32 _transparentMask, bool _allowThreeColors, BlockCompressor::QUALITY _quality, U8* _target ) {
+	float	endpoint0[4], endpoint1[4];
+	if ( _quality == BlockCompressor::QUALITY::FAST ) {
+		ComputeBoxEndpoints( _block, 3, _transparentMask, 1.0f / 16.0f, endpoint0, endpoint1 );
+	} else {
+		ComputeAxisEndpoints( _block, 3, _transparentMask, 1.0f / 16.0f, endpoint0, endpoint1 );
+	}
+
+	static const float	WEIGHTS_4COLORS[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	static const float	WEIGHTS_3COLORS[4] = { 0.0f, 1.0f, 0.5f, -1.0f };
+
+	ColorBlock	best;
+	best.error = FLT_MAX;
+
+	// Opaque blocks use the 4 colors mode, the 3 colors mode is only tried in high quality as it rarely wins
+	bool	tryFourColors = _transparentMask == 0;
+	bool	tryThreeColors = _transparentMask != 0 || (_allowThreeColors && _quality == BlockCompressor::QUALITY::HIGH);
+	for ( U32 mode=0; mode < 2; mode++ ) {
+		bool	threeColors = mode == 1;
+		if ( (threeColors && !tryThreeColors) || (!threeColors && !tryFourColors) )
+			continue;
+
+		ColorBlock	modeBest;
+		modeBest.error = FLT_MAX;
+		EvaluateColorEndpoints( _block, _transparentMask, QuantizeRGB565( endpoint0 ), QuantizeRGB565( endpoint1 ), threeColors, modeBest );
+
+		// Refine the endpoints from the chosen indices
+		const float*	weightsTable = threeColors ? WEIGHTS_3COLORS : WEIGHTS_4COLORS;
+		U32				refinementsCount = RefinementsCount( _quality );
+		for ( U32 refinementIndex=0; refinementIndex < refinementsCount; refinementIndex++ ) {
+			float	weights[16];
+			for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+				weights[texelIndex] = (_transparentMask & (1 << texelIndex)) ? -1.0f : weightsTable[modeBest.indices[texelIndex]];
+			}
+
+			float	refined0[4], refined1[4];
+			if ( !FitEndpoints( _block, 3, weights, refined0, refined1 ) )
+				break;
+
+			float	previousError = modeBest.error;
+			EvaluateColorEndpoints( _block, _transparentMask, QuantizeRGB565( refined0 ), QuantizeRGB565( refined1 ), threeColors, modeBest );
+			if ( modeBest.error >= previousError )
+				break;	// Converged
+		}
+
+		if ( modeBest.error < best.error ) {
+			best = modeBest;
+		}
+	}
+
+	// Order the endpoints to select the mode
+	U16	color0 = best.color0;
+	U16	color1 = best.color1;
+	U8*	indices = best.indices;
+	if ( !best.threeColors ) {
+		if ( color0 < color1 ) {
+			color0 = best.color1;
+			color1 = best.color0;
+			for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+				indices[texelIndex] ^= 1;	// 0 <-> 1 and 2 <-> 3
+			}
+		} else if ( color0 == color1 ) {
+			memset( indices, 0, 16 );	// Single color
+		}
+	} else {
+		if ( color0 > color1 ) {
+			color0 = best.color1;
+			color1 = best.color0;
+			for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+				if ( indices[texelIndex] < 2 )
+					indices[texelIndex] ^= 1;
+			}
+		}
+		for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+			if ( _transparentMask & (1 << texelIndex) )
+				indices[texelIndex] = 3;
+		}
+	}
+
+	U32	packedIndices = 0;
+	for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+		packedIndices |= U32( indices[texelIndex] ) << (2*texelIndex);
+	}
+
+	_target[0] = U8( color0 );
+	_target[1] = U8( color0 >> 8 );
+	_target[2] = U8( color1 );
+	_target[3] = U8( color1 >> 8 );
+	_target[4] = U8( packedIndices );
+	_target[5] = U8( packedIndices >> 8 );
+	_target[6] = U8( packedIndices >> 16 );
+	_target[7] = U8( packedIndices >> 24 );
+
+	return best.error;
+}
+
+#pragma endregion
+
+#pragma region BC4 Single Channel Blocks
+
+struct	SingleChannelBlock {
+	U8		value0;
+	U8		value1;
+	U8		indices[16];
+	float	error;
+};
+
+// Evaluates a pair of endpoints and keeps them if they're better than the current best
+//	value0 > value1 selects the 8 values mode, otherwise the 6 values mode with explicit 0 and 1
+static void		EvaluateSingleChannelEndpoints( const TexelsBlock& _block, U8 _value0, U8 _value1, SingleChannelBlock& _best ) {
+	float	palette[8][4];
+	float	v0 = _value0 / 255.0f;
+	float	v1 = _value1 / 255.0f;
+	palette[0][0] = v0;
+	palette[1][0] = v1;
+	if ( _value0 > _value1 ) {
+		for ( U32 i=2; i < 8; i++ ) {
+			palette[i][0] = ((8-i) * v0 + (i-1) * v1) / 7.0f;
+		}
+	} else {
+		for ( U32 i=2; i < 6; i++ ) {
+			palette[i][0] = ((6-i) * v0 + (i-1) * v1) / 5.0f;
+		}
+		palette[6][0] = 0.0f;
+		palette[7][0] = 1.0f;
+	}
+
+	SingleChannelBlock	candidate;
+	candidate.value0 = _value0;
+	candidate.value1 = _value1;
+	candidate.error = FindClosestEntries( _block, 1, palette, 8, 0, candidate.indices );
+	if ( candidate.error < _best.error ) {
+		_best = candidate;
+	}
+}
+
+static U8		QuantizeU8( float _value ) {
+	return U8( CLAMP( _value, 0.0f, 1.0f ) * 255.0f + 0.5f );
+}
+
+// Encodes a single channel of 16 values into a BC4 block (also used for BC3 alpha and BC5)
+static float	EncodeSingleChannelBlock( const float _values[16], BlockCompressor::QUALITY _quality, U8* _target ) {
+	TexelsBlock	block;
+	memcpy( block.channels[0], _values, 16*sizeof(float) );
+
+	float	minimum = 1.0f, maximum = 0.0f;
+	float	innerMinimum = 1.0f, innerMaximum = 0.0f;	// Extremes of the values that are not exactly represented by the explicit 0 and 1 of the 6 values mode
+	for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+		float	value = _values[texelIndex];
+		minimum = MIN( minimum, value );
+		maximum = MAX( maximum, value );
+		U8	quantized = QuantizeU8( value );
+		if ( quantized > 0 && quantized < 255 ) {
+			innerMinimum = MIN( innerMinimum, value );
+			innerMaximum = MAX( innerMaximum, value );
+		}
+	}
+
+	SingleChannelBlock	best;
+	best.error = FLT_MAX;
+	EvaluateSingleChannelEndpoints( block, QuantizeU8( maximum ), QuantizeU8( minimum ), best );
+
+	if ( _quality != BlockCompressor::QUALITY::FAST ) {
+		// Refine the 8 values mode from the chosen indices
+		static const float	WEIGHTS_8VALUES[8] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+		U32	refinementsCount = RefinementsCount( _quality );
+		for ( U32 refinementIndex=0; refinementIndex < refinementsCount && best.value0 > best.value1; refinementIndex++ ) {
+			float	weights[16];
+			for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+				weights[texelIndex] = WEIGHTS_8VALUES[best.indices[texelIndex]];
+			}
+
+			float	refined0[4], refined1[4];
+			if ( !FitEndpoints( block, 1, weights, refined0, refined1 ) )
+				break;
+
+			U8	value0 = QuantizeU8( refined0[0] );
+			U8	value1 = QuantizeU8( refined1[0] );
+			float	previousError = best.error;
+			EvaluateSingleChannelEndpoints( block, MAX( value0, value1 ), MIN( value0, value1 ), best );
+			if ( best.error >= previousError )
+				break;	// Converged
+		}
+
+		// Try the 6 values mode when some values can use the explicit 0 and 1
+		if ( innerMinimum <= innerMaximum && (minimum < innerMinimum || maximum > innerMaximum) ) {
+			EvaluateSingleChannelEndpoints( block, QuantizeU8( innerMinimum ), QuantizeU8( innerMaximum ), best );
+		}
+	}
+
+	if ( _quality == BlockCompressor::QUALITY::HIGH ) {
+		// Search the neighborhood of the best endpoints
+		U8	center0 = best.value0;
+		U8	center1 = best.value1;
+		for ( int delta0=-2; delta0 <= 2; delta0++ ) {
+			for ( int delta1=-2; delta1 <= 2; delta1++ ) {
+				int	value0 = CLAMP( int(center0) + delta0, 0, 255 );
+				int	value1 = CLAMP( int(center1) + delta1, 0, 255 );
+				if ( (value0 > value1) != (center0 > center1) )
+					continue;	// Don't switch mode
+				EvaluateSingleChannelEndpoints( block, U8( value0 ), U8( value1 ), best );
+			}
+		}
+	}
+
+	// Uniform blocks in 6 values mode always use the first endpoint
+	if ( best.value0 == best.value1 ) {
+		for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+			if ( best.indices[texelIndex] < 6 )
+				best.indices[texelIndex] = 0;
+		}
+	}
+
+	_target[0] = best.value0;
+	_target[1] = best.value1;
+	U64	packedIndices = 0;
+	for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+		packedIndices |= U64( best.indices[texelIndex] ) << (3*texelIndex);
+	}
+	for ( U32 byteIndex=0; byteIndex < 6; byteIndex++ ) {
+		_target[2+byteIndex] = U8( packedIndices >> (8*byteIndex) );
+	}
+
+	return best.error;
+}
+
+#pragma endregion
+
+#pragma region BC7 Blocks
+
+static const U32	BC7_WEIGHTS4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct	BC7Block {
+	U8		endpoints[2][4];	// 8-bits endpoints, the LSB is the p-bit
+	U8		indices[16];
+	float	error;
+};
+
+// Writes bits in a 128-bits block, LSB first
+class	BitWriter {
+	U8*		m_target;
+	U32		m_position;
+public:
+	BitWriter( U8* _target ) : m_target( _target ), m_position( 0 ) { memset( _target, 0, 16 ); }
+	void	Write( U32 _value, U32 _bitsCount ) {
+		for ( U32 bitIndex=0; bitIndex < _bitsCount; bitIndex++, m_position++ ) {
+			if ( (_value >> bitIndex) & 1 )
+				m_target[m_position >> 3] |= U8( 1 << (m_position & 7) );
+		}
+	}
+};
+
+// Quantizes an endpoint to 7 bits per component + the given p-bit
+static float	QuantizeBC7Endpoint( const float _endpoint[4], U32 _pBit, U8 _quantized[4] ) {
+	float	error = 0.0f;
+	for ( U32 channelIndex=0; channelIndex < 4; channelIndex++ ) {
+		int	value = CLAMP( int( floorf( 0.5f * (_endpoint[channelIndex] * 255.0f - _pBit) + 0.5f ) ), 0, 127 );
+		_quantized[channelIndex] = U8( (value << 1) | _pBit );
+		float	delta = _quantized[channelIndex] / 255.0f - _endpoint[channelIndex];
+		error += delta * delta;
+	}
+	return error;
+}
+
+static void		EvaluateBC7QuantizedEndpoints( const TexelsBlock& _block, const U8 _endpoint0[4], const U8 _endpoint1[4], BC7Block& _best ) {
+	float	palette[16][4];
+	for ( U32 entryIndex=0; entryIndex < 16; entryIndex++ ) {
+		U32	w = BC7_WEIGHTS4[entryIndex];
+		for ( U32 channelIndex=0; channelIndex < 4; channelIndex++ ) {
+			palette[entryIndex][channelIndex] = (((64 - w) * _endpoint0[channelIndex] + w * _endpoint1[channelIndex] + 32) >> 6) / 255.0f;
+		}
+	}
+
+	BC7Block	candidate;
+	memcpy( candidate.endpoints[0], _endpoint0, 4 );
+	memcpy( candidate.endpoints[1], _endpoint1, 4 );
+	candidate.error = FindClosestEntries( _block, 4, palette, 16, 0, candidate.indices );
+	if ( candidate.error < _best.error ) {
+		_best = candidate;
+	}
+}
+
+// Evaluates a pair of endpoints, either with the p-bits that best represent each endpoint or with all the p-bits combinations
+static void		EvaluateBC7Endpoints( const TexelsBlock& _block, const float _endpoint0[4], const float _endpoint1[4], bool _allPBits, BC7Block& _best ) {
+	U8	quantized[2][2][4];	// [endpoint][p-bit]
+	float	errors[2][2];
+	for ( U32 pBit=0; pBit < 2; pBit++ ) {
+		errors[0][pBit] = QuantizeBC7Endpoint( _endpoint0, pBit, quantized[0][pBit] );
+		errors[1][pBit] = QuantizeBC7Endpoint( _endpoint1, pBit, quantized[1][pBit] );
+	}
+
+	if ( _allPBits ) {
+		for ( U32 pBit0=0; pBit0 < 2; pBit0++ ) {
+			for ( U32 pBit1=0; pBit1 < 2; pBit1++ ) {
+				EvaluateBC7QuantizedEndpoints( _block, quantized[0][pBit0], quantized[1][pBit1], _best );
+			}
+		}
+	} else {
+		U32	pBit0 = errors[0][1] < errors[0][0] ? 1 : 0;
+		U32	pBit1 = errors[1][1] < errors[1][0] ? 1 : 0;
+		EvaluateBC7QuantizedEndpoints( _block, quantized[0][pBit0], quantized[1][pBit1], _best );
+	}
+}
+
+// Encodes an RGBA block into a BC7 mode 6 block (single subset, 7-bits RGBA endpoints with unique p-bits and 4-bits indices)
+static float	EncodeBC7Block( const TexelsBlock& _block, BlockCompressor::QUALITY _quality, U8* _target ) {
+	float	endpoint0[4], endpoint1[4];
+	if ( _quality == BlockCompressor::QUALITY::FAST ) {
+		ComputeBoxEndpoints( _block, 4, 0, 1.0f / 64.0f, endpoint0, endpoint1 );
+	} else {
+		ComputeAxisEndpoints( _block, 4, 0, 1.0f / 64.0f, endpoint0, endpoint1 );
+	}
+
+	bool		allPBits = _quality == BlockCompressor::QUALITY::HIGH;
+	BC7Block	best;
+	best.error = FLT_MAX;
+	EvaluateBC7Endpoints( _block, endpoint0, endpoint1, allPBits, best );
+
+	U32	refinementsCount = RefinementsCount( _quality );
+	for ( U32 refinementIndex=0; refinementIndex < refinementsCount; refinementIndex++ ) {
+		float	weights[16];
+		for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+			weights[texelIndex] = BC7_WEIGHTS4[best.indices[texelIndex]] / 64.0f;
+		}
+
+		float	refined0[4], refined1[4];
+		if ( !FitEndpoints( _block, 4, weights, refined0, refined1 ) )
+			break;
+
+		float	previousError = best.error;
+		EvaluateBC7Endpoints( _block, refined0, refined1, allPBits, best );
+		if ( best.error >= previousError )
+			break;	// Converged
+	}
+
+	// The MSB of the first texel's index is implicitly 0
+	U32	first = 0;
+	if ( best.indices[0] & 8 ) {
+		first = 1;
+		for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+			best.indices[texelIndex] = 15 - best.indices[texelIndex];
+		}
+	}
+	const U8*	endpoint0Bits = best.endpoints[first];
+	const U8*	endpoint1Bits = best.endpoints[1-first];
+
+	BitWriter	writer( _target );
+	writer.Write( 1 << 6, 7 );	// Mode 6
+	for ( U32 channelIndex=0; channelIndex < 4; channelIndex++ ) {
+		writer.Write( endpoint0Bits[channelIndex] >> 1, 7 );
+		writer.Write( endpoint1Bits[channelIndex] >> 1, 7 );
+	}
+	writer.Write( endpoint0Bits[0] & 1, 1 );
+	writer.Write( endpoint1Bits[0] & 1, 1 );
+	writer.Write( best.indices[0], 3 );
+	for ( U32 texelIndex=1; texelIndex < 16; texelIndex++ ) {
+		writer.Write( best.indices[texelIndex], 4 );
+	}
+
+	return best.error;
+}
+
+#pragma endregion
+
+bool	BlockCompressor::IsSupported( DXGI_FORMAT _format ) {
+	switch ( _format ) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_UNORM:
+		case DXGI_FORMAT_BC5_UNORM:
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return true;
+	}
+	return false;
+}
+
+U32		BlockCompressor::GetBlockSize( DXGI_FORMAT _format ) {
+	switch ( _format ) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+		case DXGI_FORMAT_BC4_UNORM:
+			return 8;
+	}
+	return 16;
+}
+
+// Gets the amount of components the error is measured on
+static U32	EncodedChannelsCount( DXGI_FORMAT _format ) {
+	switch ( _format ) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:	return 3;
+		case DXGI_FORMAT_BC4_UNORM:			return 1;
+		case DXGI_FORMAT_BC5_UNORM:			return 2;
+	}
+	return 4;
+}
+
+float	BlockCompressor::CompressBlock( DXGI_FORMAT _format, const bfloat4 _texels[16], QUALITY _quality, U8* _block ) {
+	TexelsBlock	block;
+	U32			transparentMask = 0;
+	for ( U32 texelIndex=0; texelIndex < 16; texelIndex++ ) {
+		const bfloat4&	texel = _texels[texelIndex];
+		block.channels[0][texelIndex] = CLAMP( texel.x, 0.0f, 1.0f );
+		block.channels[1][texelIndex] = CLAMP( texel.y, 0.0f, 1.0f );
+		block.channels[2][texelIndex] = CLAMP( texel.z, 0.0f, 1.0f );
+		block.channels[3][texelIndex] = CLAMP( texel.w, 0.0f, 1.0f );
+		if ( texel.w < 0.5f )
+			transparentMask |= 1 << texelIndex;
+	}
+
+	switch ( _format ) {
+		case DXGI_FORMAT_BC1_UNORM:
+		case DXGI_FORMAT_BC1_UNORM_SRGB:
+			return EncodeColorBlock( block, transparentMask, true, _quality, _block );
+
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC3_UNORM_SRGB:
+			return EncodeSingleChannelBlock( block.channels[3], _quality, _block ) + EncodeColorBlock( block, 0, false, _quality, _block + 8 );
+
+		case DXGI_FORMAT_BC4_UNORM:
+			return EncodeSingleChannelBlock( block.channels[0], _quality, _block );
+
+		case DXGI_FORMAT_BC5_UNORM:
+			return EncodeSingleChannelBlock( block.channels[0], _quality, _block ) + EncodeSingleChannelBlock( block.channels[1], _quality, _block + 8 );
+
+		case DXGI_FORMAT_BC7_UNORM:
+		case DXGI_FORMAT_BC7_UNORM_SRGB:
+			return EncodeBC7Block( block, _quality, _block );
+	}
+
+	throw "Unsupported block compression format!";
+}
+
+double	BlockCompressor::CompressImage( DXGI_FORMAT _format, const ImageFile& _source, QUALITY _quality, U8* _target, U32 _rowPitch ) {
+	if ( !IsSupported( _format ) )
+		throw "Unsupported block compression format!";
+
+	U32	W = _source.Width();
+	U32	H = _source.Height();
+	U32	blocksCountX = (W + 3) >> 2;
+	U32	blocksCountY = (H + 3) >> 2;
+	U32	blockSize = GetBlockSize( _format );
+
+	// Each thread accumulates the error of the block rows it encoded
+	ThreadPool&		pool = ThreadPool::Default();
+	List< double >	threadErrors( pool.GetThreadsCount() );
+	for ( U32 threadIndex=0; threadIndex < pool.GetThreadsCount(); threadIndex++ ) {
+		threadErrors.Append( 0.0 );
+	}
+
+	U32	bandHeight = MAX( 1U, blocksCountY / (4 * pool.GetThreadsCount()) );
+	pool.ParallelForRange( blocksCountY, bandHeight, [&]( U32 _startBlockY, U32 _endBlockY, U32 _threadIndex ) {
+		bfloat4*	scanlines = new bfloat4[4*W];
+		bfloat4		texels[16];
+		double		error = 0.0;
+		for ( U32 blockY=_startBlockY; blockY < _endBlockY; blockY++ ) {
+			for ( U32 row=0; row < 4; row++ ) {
+				_source.ReadScanline( MIN( 4*blockY+row, H-1 ), scanlines + row*W );
+			}
+
+			U8*	targetBlock = _target + blockY * _rowPitch;
+			for ( U32 blockX=0; blockX < blocksCountX; blockX++, targetBlock+=blockSize ) {
+				for ( U32 row=0; row < 4; row++ ) {
+					for ( U32 column=0; column < 4; column++ ) {
+						texels[4*row+column] = scanlines[row*W + MIN( 4*blockX+column, W-1 )];
+					}
+				}
+				error += CompressBlock( _format, texels, _quality, targetBlock );
+			}
+		}
+		threadErrors[_threadIndex] += error;
+		delete[] scanlines;
+	} );
+
+	double	sumErrors = 0.0;
+	for ( U32 threadIndex=0; threadIndex < threadErrors.Count(); threadIndex++ ) {
+		sumErrors += threadErrors[threadIndex];
+	}
+	return sumErrors / (16.0 * blocksCountX * blocksCountY * EncodedChannelsCount( _format ));
+}
@@ -0,0 +1,48 @@
+//////////////////////////////////////////////////////////////////////////
+// CPU block-compression encoder for the BCn formats
+// Each 4x4 block is encoded independently and the block rows of an image are spread across the default thread pool
+//
+// Supported formats:
+//	 BC1 (with 1-bit alpha when some texels have alpha < 0.5), BC3, BC4 and BC5 (UNORM/UNORM_sRGB)
+//	 BC7 (UNORM/UNORM_sRGB), using mode 6 only (i.e. a single RGBA subset with 4-bits indices)
+//
+// The texel values are encoded as-is (i.e. sRGB formats expect sRGB-encoded values) and are clamped to [0,1]
+//
+// Only the palette index search (finding the closest palette entry of 4 texels at once, the inner loop of every mode) uses SSE,
+//	the endpoints fitting and the quantization are scalar
+//
+#pragma once
+
+#include "ImageFile.h"
+
+namespace ImageUtilityLib {
+
+	class	BlockCompressor {
+	public:
+		// Compression quality
+		enum class QUALITY {
+			FAST,		// Bounding box endpoints, no refinement
+			NORMAL,		// Principal axis endpoints and a single least-squares refinement (Default)
+			HIGH,		// Principal axis endpoints, iterated least-squares refinement and a wider search of the alternative block modes
+		};
+
+	public:
+		// Tells if the format can be encoded
+		static bool		IsSupported( DXGI_FORMAT _format );
+
+		// Gets the size of a compressed 4x4 block in bytes (8 or 16)
+		static U32		GetBlockSize( DXGI_FORMAT _format );
+
+		// Compresses a single block of 4x4 texels stored in rows
+		//	Returns the sum of the squared errors of the decoded texels' components
+		static float	CompressBlock( DXGI_FORMAT _format, const bfloat4 _texels[16], QUALITY _quality, U8* _block );
+
+		// Compresses a whole image into the target buffer, block rows are separated by _rowPitch bytes
+		//	Texels of partial blocks on the right and bottom edges are replicated from the last column/row
+		//	Returns the mean squared error of the encoded components (in [0,1]), use MSE2PSNR() to get the PSNR
+		static double	CompressImage( DXGI_FORMAT _format, const ImageFile& _source, QUALITY _quality, U8* _target, U32 _rowPitch );
+
+		// Converts a mean squared error into a peak signal-to-noise ratio (in dB) for signals in [0,1]
+		static double	MSE2PSNR( double _MSE )	{ return _MSE > 0.0 ? -10.0 * log10( _MSE ) : 999.0; }
+	};
+}
@@ -1,5 +1,7 @@
 #include "stdafx.h"
 #include "ColorProfile.h"
+#include "..\BaseLib\Math\SIMD.h"
+#include "..\BaseLib\Utility\ThreadPool.h"
 
 using namespace ImageUtilityLib;
 
@@ -355,6 +357,131 @@ void	ColorProfile::ComputeWhitePointChromaticitiesAnalytical( float _blackBodyTe
 }
 
 
+//////////////////////////////////////////////////////////////////////////
+// Multithreaded span conversions
+//
+static const U32	PARALLEL_CONVERSION_CHUNK_SIZE = 16384;	// Amount of pixels converted by a single task
+
+void	ColorProfile::ParallelXYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
+	const IColorConverter*	converter = m_internalConverter;
+	ThreadPool::Default().ParallelForRange( _length, PARALLEL_CONVERSION_CHUNK_SIZE, [=]( U32 _start, U32 _end, U32 _threadIndex ) {
+		converter->XYZ2RGB( _XYZ + _start, _RGB + _start, _end - _start );
+	} );
+}
+
+void	ColorProfile::ParallelRGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
+	const IColorConverter*	converter = m_internalConverter;
+	ThreadPool::Default().ParallelForRange( _length, PARALLEL_CONVERSION_CHUNK_SIZE, [=]( U32 _start, U32 _end, U32 _threadIndex ) {
+		converter->RGB2XYZ( _RGB + _start, _XYZ + _start, _end - _start );
+	} );
+}
+
+
+//////////////////////////////////////////////////////////////////////////
+// SSE span kernels shared by all the internal converters
+// Pixels are transposed into SoA form and processed 4 at a time, the remaining pixels go through a padded temporary block.
+//
+// Maximum error against the scalar per-pixel path, measured over [1e-6,65504]:
+//	 Matrix transforms only differ by float rounding
+//	 Gamma curves using powf() have a maximum relative error of 3.1e-6 (see SIMD::Pow()), that is 0.0008 of a 16-bits quantization step
+//	 Non-positive values produce 0 with the pure power curves where powf() would return NaN for negative values
+//
+namespace {
+	using namespace BaseLib;
+
+	struct	GammaNone {
+		__m128	Linear2Gamma( __m128 _x ) const	{ return _x; }
+		__m128	Gamma2Linear( __m128 _x ) const	{ return _x; }
+	};
+
+	struct	GammaStandard {
+		__m128	m_gamma;
+		__m128	m_invGamma;
+
+		GammaStandard( float _gamma ) : m_gamma( _mm_set1_ps( _gamma ) ), m_invGamma( _mm_set1_ps( 1.0f / _gamma ) ) {}
+		__m128	Linear2Gamma( __m128 _x ) const	{ return SIMD::Pow( _x, m_invGamma ); }
+		__m128	Gamma2Linear( __m128 _x ) const	{ return SIMD::Pow( _x, m_gamma ); }
+	};
+
+	struct	GammasRGB {
+		__m128	Linear2Gamma( __m128 _x ) const {
+			__m128	isLinear = _mm_cmplt_ps( _x, _mm_set1_ps( 0.0031308f ) );
+			__m128	linear = _mm_mul_ps( _x, _mm_set1_ps( 12.92f ) );
+			__m128	curve = _mm_sub_ps( _mm_mul_ps( _mm_set1_ps( 1.055f ), SIMD::Pow( _x, _mm_set1_ps( 1.0f / ColorProfile::GAMMA_EXPONENT_sRGB ) ) ), _mm_set1_ps( 0.055f ) );
+			return SIMD::Select( isLinear, linear, curve );
+		}
+		__m128	Gamma2Linear( __m128 _x ) const {
+			__m128	isLinear = _mm_cmplt_ps( _x, _mm_set1_ps( 0.04045f ) );
+			__m128	linear = _mm_mul_ps( _x, _mm_set1_ps( 1.0f / 12.92f ) );
+			__m128	curve = SIMD::Pow( _mm_mul_ps( _mm_add_ps( _x, _mm_set1_ps( 0.055f ) ), _mm_set1_ps( 1.0f / 1.055f ) ), _mm_set1_ps( ColorProfile::GAMMA_EXPONENT_sRGB ) );
+			return SIMD::Select( isLinear, linear, curve );
+		}
+	};
+
+	struct	GammaProPhoto {
+		__m128	Linear2Gamma( __m128 _x ) const {
+			__m128	isCurve = _mm_cmpgt_ps( _x, _mm_set1_ps( 0.001953f ) );
+			__m128	linear = _mm_mul_ps( _x, _mm_set1_ps( 16.0f ) );
+			__m128	curve = SIMD::Pow( _x, _mm_set1_ps( 1.0f / ColorProfile::GAMMA_EXPONENT_PRO_PHOTO ) );
+			return SIMD::Select( isCurve, curve, linear );
+		}
+		__m128	Gamma2Linear( __m128 _x ) const {
+			__m128	isCurve = _mm_cmpgt_ps( _x, _mm_set1_ps( 0.031248f ) );
+			__m128	linear = _mm_mul_ps( _x, _mm_set1_ps( 1.0f / 16.0f ) );
+			__m128	curve = SIMD::Pow( _x, _mm_set1_ps( ColorProfile::GAMMA_EXPONENT_PRO_PHOTO ) );
+			return SIMD::Select( isCurve, curve, linear );
+		}
+	};
+
+	// Transforms 4 XYZ pixels into RGB and applies the gamma curve
+	template< typename GAMMA > void	XYZ2RGB_Block( const bfloat4* _XYZ, bfloat4* _RGB, const float3x3& _XYZ2RGB, const GAMMA& _gamma ) {
+		__m128	x, y, z, w;
+		SIMD::LoadSoA( _XYZ, x, y, z, w );
+		SIMD::Transform( x, y, z, _XYZ2RGB );
+		SIMD::StoreAoS( _gamma.Linear2Gamma( x ), _gamma.Linear2Gamma( y ), _gamma.Linear2Gamma( z ), w, _RGB );
+	}
+
+	// Removes the gamma curve from 4 RGB pixels and transforms them into XYZ
+	template< typename GAMMA > void	RGB2XYZ_Block( const bfloat4* _RGB, bfloat4* _XYZ, const float3x3& _RGB2XYZ, const GAMMA& _gamma ) {
+		__m128	x, y, z, w;
+		SIMD::LoadSoA( _RGB, x, y, z, w );
+		x = _gamma.Gamma2Linear( x );
+		y = _gamma.Gamma2Linear( y );
+		z = _gamma.Gamma2Linear( z );
+		SIMD::Transform( x, y, z, _RGB2XYZ );
+		SIMD::StoreAoS( x, y, z, w, _XYZ );
+	}
+
+	template< typename GAMMA > void	XYZ2RGB_SSE( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length, const float3x3& _XYZ2RGB, const GAMMA& _gamma ) {
+		U32	blocksCount = _length >> 2;
+		for ( U32 i=blocksCount; i > 0; i--, _XYZ+=4, _RGB+=4 )
+			XYZ2RGB_Block( _XYZ, _RGB, _XYZ2RGB, _gamma );
+
+		U32	remainder = _length & 3;
+		if ( remainder == 0 )
+			return;
+		bfloat4	temp[4];
+		memcpy( temp, _XYZ, remainder * sizeof(bfloat4) );
+		XYZ2RGB_Block( temp, temp, _XYZ2RGB, _gamma );
+		memcpy( _RGB, temp, remainder * sizeof(bfloat4) );
+	}
+
+	template< typename GAMMA > void	RGB2XYZ_SSE( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length, const float3x3& _RGB2XYZ, const GAMMA& _gamma ) {
+		U32	blocksCount = _length >> 2;
+		for ( U32 i=blocksCount; i > 0; i--, _RGB+=4, _XYZ+=4 )
+			RGB2XYZ_Block( _RGB, _XYZ, _RGB2XYZ, _gamma );
+
+		U32	remainder = _length & 3;
+		if ( remainder == 0 )
+			return;
+		bfloat4	temp[4];
+		memcpy( temp, _RGB, remainder * sizeof(bfloat4) );
+		RGB2XYZ_Block( temp, temp, _RGB2XYZ, _gamma );
+		memcpy( _XYZ, temp, remainder * sizeof(bfloat4) );
+	}
+}
+
+
 //////////////////////////////////////////////////////////////////////////
 // InternalColorConverter_sRGB
 //
@@ -393,29 +520,11 @@ void ColorProfile::InternalColorConverter_sRGB::RGB2XYZ( const bfloat4& _RGB, bf
 }
 
 void ColorProfile::InternalColorConverter_sRGB::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Transform into RGB
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * MAT_XYZ2RGB;
-
-		// Gamma correct
-		_RGB->x = Linear2sRGB( _RGB->x );
-		_RGB->y = Linear2sRGB( _RGB->y );
-		_RGB->z = Linear2sRGB( _RGB->z );
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, MAT_XYZ2RGB, GammasRGB() );
 }
 
 void ColorProfile::InternalColorConverter_sRGB::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Gamma un-correct
-		_XYZ->x = sRGB2Linear( _RGB->x );
-		_XYZ->y = sRGB2Linear( _RGB->y );
-		_XYZ->z = sRGB2Linear( _RGB->z );
-		_XYZ->w = _RGB->w;
-
-		// Transform into XYZ
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_XYZ) * MAT_RGB2XYZ;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, MAT_RGB2XYZ, GammasRGB() );
 }
 
 void ColorProfile::InternalColorConverter_sRGB::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -470,29 +579,11 @@ void ColorProfile::InternalColorConverter_AdobeRGB_D50::RGB2XYZ( const bfloat4&
 }
 
 void ColorProfile::InternalColorConverter_AdobeRGB_D50::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Transform into RGB
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * MAT_XYZ2RGB;
-
-		// Gamma correct
-		_RGB->x = powf( _RGB->x, 1.0f / GAMMA_EXPONENT_ADOBE );
-		_RGB->y = powf( _RGB->y, 1.0f / GAMMA_EXPONENT_ADOBE );
-		_RGB->z = powf( _RGB->z, 1.0f / GAMMA_EXPONENT_ADOBE );
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, MAT_XYZ2RGB, GammaStandard( GAMMA_EXPONENT_ADOBE ) );
 }
 
 void ColorProfile::InternalColorConverter_AdobeRGB_D50::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Gamma un-correct
-		_XYZ->x = powf( _RGB->x, GAMMA_EXPONENT_ADOBE );
-		_XYZ->y = powf( _RGB->y, GAMMA_EXPONENT_ADOBE );
-		_XYZ->z = powf( _RGB->z, GAMMA_EXPONENT_ADOBE );
-		_XYZ->w = _RGB->w;
-
-		// Transform into XYZ
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_XYZ) * MAT_RGB2XYZ;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, MAT_RGB2XYZ, GammaStandard( GAMMA_EXPONENT_ADOBE ) );
 }
 
 void ColorProfile::InternalColorConverter_AdobeRGB_D50::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -546,29 +637,11 @@ void ColorProfile::InternalColorConverter_AdobeRGB_D65::RGB2XYZ( const bfloat4&
 }
 
 void ColorProfile::InternalColorConverter_AdobeRGB_D65::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Transform into RGB
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * MAT_XYZ2RGB;
-
-		// Gamma correct
-		_RGB->x = powf( _RGB->x, 1.0f / GAMMA_EXPONENT_ADOBE );
-		_RGB->y = powf( _RGB->y, 1.0f / GAMMA_EXPONENT_ADOBE );
-		_RGB->z = powf( _RGB->z, 1.0f / GAMMA_EXPONENT_ADOBE );
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, MAT_XYZ2RGB, GammaStandard( GAMMA_EXPONENT_ADOBE ) );
 }
 
 void ColorProfile::InternalColorConverter_AdobeRGB_D65::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Gamma un-correct
-		_XYZ->x = powf( _RGB->x, GAMMA_EXPONENT_ADOBE );
-		_XYZ->y = powf( _RGB->y, GAMMA_EXPONENT_ADOBE );
-		_XYZ->z = powf( _RGB->z, GAMMA_EXPONENT_ADOBE );
-		_XYZ->w = _RGB->w;
-
-		// Transform into XYZ
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_XYZ) * MAT_RGB2XYZ;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, MAT_RGB2XYZ, GammaStandard( GAMMA_EXPONENT_ADOBE ) );
 }
 
 void ColorProfile::InternalColorConverter_AdobeRGB_D65::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -622,29 +695,11 @@ void ColorProfile::InternalColorConverter_ProPhoto::RGB2XYZ( const bfloat4& _RGB
 }
 
 void ColorProfile::InternalColorConverter_ProPhoto::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Transform into RGB
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * MAT_XYZ2RGB;
-
-		// Gamma correct
-		_RGB->x = _RGB->x > 0.001953f ? powf( _RGB->x, 1.0f / GAMMA_EXPONENT_PRO_PHOTO ) : 16.0f * _RGB->x;
-		_RGB->y = _RGB->y > 0.001953f ? powf( _RGB->y, 1.0f / GAMMA_EXPONENT_PRO_PHOTO ) : 16.0f * _RGB->y;
-		_RGB->z = _RGB->z > 0.001953f ? powf( _RGB->z, 1.0f / GAMMA_EXPONENT_PRO_PHOTO ) : 16.0f * _RGB->z;
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, MAT_XYZ2RGB, GammaProPhoto() );
 }
 
 void ColorProfile::InternalColorConverter_ProPhoto::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Gamma un-correct
-		_XYZ->x = _RGB->x > 0.031248f ? powf( _RGB->x, GAMMA_EXPONENT_PRO_PHOTO ) : _RGB->x / 16.0f;
-		_XYZ->y = _RGB->y > 0.031248f ? powf( _RGB->y, GAMMA_EXPONENT_PRO_PHOTO ) : _RGB->y / 16.0f;
-		_XYZ->z = _RGB->z > 0.031248f ? powf( _RGB->z, GAMMA_EXPONENT_PRO_PHOTO ) : _RGB->z / 16.0f;
-		_XYZ->w = _RGB->w;
-
-		// Transform into XYZ
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_XYZ) * MAT_RGB2XYZ;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, MAT_RGB2XYZ, GammaProPhoto() );
 }
 
 void ColorProfile::InternalColorConverter_ProPhoto::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -688,17 +743,11 @@ void ColorProfile::InternalColorConverter_Radiance::RGB2XYZ( const bfloat4& _RGB
 }
 
 void ColorProfile::InternalColorConverter_Radiance::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * MAT_XYZ2RGB;
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, MAT_XYZ2RGB, GammaNone() );
 }
 
 void ColorProfile::InternalColorConverter_Radiance::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_RGB) * MAT_RGB2XYZ;
-		_XYZ->w = _RGB->w;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, MAT_RGB2XYZ, GammaNone() );
 }
 
 void ColorProfile::InternalColorConverter_Radiance::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -724,17 +773,11 @@ void ColorProfile::InternalColorConverter_Generic_NoGamma::RGB2XYZ( const bfloat
 }
 
 void ColorProfile::InternalColorConverter_Generic_NoGamma::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * m_XYZ2RGB;
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, m_XYZ2RGB, GammaNone() );
 }
 
 void ColorProfile::InternalColorConverter_Generic_NoGamma::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_RGB) * m_RGB2XYZ;
-		_XYZ->w = _RGB->w;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, m_RGB2XYZ, GammaNone() );
 }
 
 void ColorProfile::InternalColorConverter_Generic_NoGamma::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -770,29 +813,11 @@ void ColorProfile::InternalColorConverter_Generic_StandardGamma::RGB2XYZ( const
 }
 
 void ColorProfile::InternalColorConverter_Generic_StandardGamma::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Transform into RGB
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * m_XYZ2RGB;
-
-		// Gamma correct
-		_RGB->x = powf( _RGB->x, m_InvGamma );
-		_RGB->y = powf( _RGB->y, m_InvGamma );
-		_RGB->z = powf( _RGB->z, m_InvGamma );
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, m_XYZ2RGB, GammaStandard( m_Gamma ) );
 }
 
 void ColorProfile::InternalColorConverter_Generic_StandardGamma::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Gamma un-correct
-		_XYZ->x = powf( _RGB->x, m_Gamma );
-		_XYZ->y = powf( _RGB->y, m_Gamma );
-		_XYZ->z = powf( _RGB->z, m_Gamma );
-		_XYZ->w = _RGB->w;
-
-		// Transform into XYZ
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_XYZ) * m_RGB2XYZ;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, m_RGB2XYZ, GammaStandard( m_Gamma ) );
 }
 
 void ColorProfile::InternalColorConverter_Generic_StandardGamma::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -834,29 +859,11 @@ void ColorProfile::InternalColorConverter_Generic_sRGBGamma::RGB2XYZ( const bflo
 }
 
 void ColorProfile::InternalColorConverter_Generic_sRGBGamma::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Transform into RGB
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * m_XYZ2RGB;
-
-		// Gamma correct
-		_RGB->x = _RGB->x > 0.0031308f ? 1.055f * powf( _RGB->x, 1.0f / GAMMA_EXPONENT_sRGB ) - 0.055f : 12.92f * _RGB->x;
-		_RGB->y = _RGB->y > 0.0031308f ? 1.055f * powf( _RGB->y, 1.0f / GAMMA_EXPONENT_sRGB ) - 0.055f : 12.92f * _RGB->y;
-		_RGB->z = _RGB->z > 0.0031308f ? 1.055f * powf( _RGB->z, 1.0f / GAMMA_EXPONENT_sRGB ) - 0.055f : 12.92f * _RGB->z;
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, m_XYZ2RGB, GammasRGB() );
 }
 
 void ColorProfile::InternalColorConverter_Generic_sRGBGamma::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Gamma un-correct
-		_XYZ->x = _RGB->x < 0.04045f ? _RGB->x / 12.92f : powf( (_RGB->x + 0.055f) / 1.055f, GAMMA_EXPONENT_sRGB );
-		_XYZ->y = _RGB->y < 0.04045f ? _RGB->y / 12.92f : powf( (_RGB->y + 0.055f) / 1.055f, GAMMA_EXPONENT_sRGB );
-		_XYZ->z = _RGB->z < 0.04045f ? _RGB->z / 12.92f : powf( (_RGB->z + 0.055f) / 1.055f, GAMMA_EXPONENT_sRGB );
-		_XYZ->w = _RGB->w;
-
-		// Transform into XYZ
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_XYZ) * m_RGB2XYZ;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, m_RGB2XYZ, GammasRGB() );
 }
 
 void ColorProfile::InternalColorConverter_Generic_sRGBGamma::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -898,29 +905,11 @@ void ColorProfile::InternalColorConverter_Generic_ProPhoto::RGB2XYZ( const bfloa
 }
 
 void ColorProfile::InternalColorConverter_Generic_ProPhoto::XYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Transform into RGB
-		((bfloat3&) *_RGB) = ((bfloat3&) *_XYZ) * m_XYZ2RGB;
-
-		// Gamma correct
-		_RGB->x = _RGB->x > 0.001953f ? powf( _RGB->x, 1.0f / GAMMA_EXPONENT_PRO_PHOTO ) : 16.0f * _RGB->x;
-		_RGB->y = _RGB->y > 0.001953f ? powf( _RGB->y, 1.0f / GAMMA_EXPONENT_PRO_PHOTO ) : 16.0f * _RGB->y;
-		_RGB->z = _RGB->z > 0.001953f ? powf( _RGB->z, 1.0f / GAMMA_EXPONENT_PRO_PHOTO ) : 16.0f * _RGB->z;
-		_RGB->w = _XYZ->w;
-	}
+	XYZ2RGB_SSE( _XYZ, _RGB, _length, m_XYZ2RGB, GammaProPhoto() );
 }
 
 void ColorProfile::InternalColorConverter_Generic_ProPhoto::RGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const {
-	for ( U32 i=_length; i > 0; i--, _XYZ++, _RGB++ ) {
-		// Gamma un-correct
-		_XYZ->x = _RGB->x > 0.031248f ? powf( _RGB->x, GAMMA_EXPONENT_PRO_PHOTO ) : _RGB->x / 16.0f;
-		_XYZ->y = _RGB->y > 0.031248f ? powf( _RGB->y, GAMMA_EXPONENT_PRO_PHOTO ) : _RGB->y / 16.0f;
-		_XYZ->z = _RGB->z > 0.031248f ? powf( _RGB->z, GAMMA_EXPONENT_PRO_PHOTO ) : _RGB->z / 16.0f;
-		_XYZ->w = _RGB->w;
-
-		// Transform into XYZ
-		((bfloat3&) *_XYZ) = ((bfloat3&) *_XYZ) * m_RGB2XYZ;
-	}
+	RGB2XYZ_SSE( _RGB, _XYZ, _length, m_RGB2XYZ, GammaProPhoto() );
 }
 
 void ColorProfile::InternalColorConverter_Generic_ProPhoto::GammaRGB2LinearRGB( const bfloat4& _gammaRGB, bfloat4& _linearRGB ) const {
@@ -497,6 +497,18 @@ namespace ImageUtilityLib {
 
 		#pragma endregion
 
+		/// <summary>
+		/// Converts a span of CIEXYZ colors to RGB colors using all the available threads
+		/// Use this for full images, the span is split into chunks converted in parallel by the default thread pool
+		/// </summary>
+		void	ParallelXYZ2RGB( const bfloat4* _XYZ, bfloat4* _RGB, U32 _length ) const;
+
+		/// <summary>
+		/// Converts a span of RGB colors to CIEXYZ colors using all the available threads
+		/// Use this for full images, the span is split into chunks converted in parallel by the default thread pool
+		/// </summary>
+		void	ParallelRGB2XYZ( const bfloat4* _RGB, bfloat4* _XYZ, U32 _length ) const;
+
 	public:
 
 		#pragma region Helpers
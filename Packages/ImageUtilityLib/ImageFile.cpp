@@ -3,6 +3,7 @@
 #include "ImageFile.h"
 #include "Bitmap.h"
 #include "ImagesMatrix.h"
+#include "..\BaseLib\PixelFormats\PixelSpans.h"
 
 using namespace ImageUtilityLib;
 
@@ -343,25 +344,20 @@ void	ImageFile::ConvertFrom_NoSupport( const ImageFile& _source, PIXEL_FORMAT _t
 	int				BPP = int( PixelFormat2BPP( m_pixelFormat ) );
 	m_bitmap = FreeImage_AllocateT( bitmapType, W, H, BPP );
 
-	const IPixelAccessor&	sourceAccessor = PixelFormat2PixelAccessor( _source.m_pixelFormat );
-	const IPixelAccessor&	targetAccessor = PixelFormat2PixelAccessor( m_pixelFormat );
+	spanDecoder_t	decoder = PixelFormat2SpanDecoder( _source.m_pixelFormat );
+	spanEncoder_t	encoder = PixelFormat2SpanEncoder( m_pixelFormat );
 
 	const U8*	sourceBits = _source.GetBits();
 	U8*			targetBits = GetBits();
-	U32			sourcePixelSize = sourceAccessor.Size();
 	U32			sourcePitch = _source.Pitch();
-	U32			targetPixelSize = targetAccessor.Size();
 	U32			targetPitch = Pitch();
 
-	bfloat4	temp;
+	bfloat4*	tempScanline = new bfloat4[W];
 	for ( U32 Y=0; Y < H; Y++ ) {
-		const U8*	scanlineSource = sourceBits + Y * sourcePitch;
-		U8*			scanlineTarget = targetBits + Y * targetPitch;
-		for ( U32 X=0; X < W; X++, scanlineSource += sourcePixelSize, scanlineTarget += targetPixelSize ) {
-			sourceAccessor.RGBA( scanlineSource, temp );
-			targetAccessor.Write( scanlineTarget, temp );
-		}
+		(*decoder)( sourceBits + Y * sourcePitch, tempScanline, W );
+		(*encoder)( tempScanline, targetBits + Y * targetPitch, W );
 	}
+	delete[] tempScanline;
 }
 
 void	ImageFile::ToneMapFrom( const ImageFile& _source, toneMapper_t _toneMapper ) {
@@ -834,9 +830,7 @@ void	ImageFile::ReadScanline( U32 _Y, bfloat4* _color, U32 _startX, U32 _count )
 	bits += pitch * _Y + _startX * pixelSize;
 
 	_count = MIN( _count, W-_startX );
-	for ( U32 i=_count; i > 0; i--, bits += pixelSize, _color++ ) {
-		m_pixelAccessor->RGBA( bits, *_color );
-	}
+	(*PixelFormat2SpanDecoder( m_pixelFormat ))( bits, _color, _count );
 }
 void	ImageFile::WriteScanline( U32 _Y, const bfloat4* _color, U32 _startX, U32 _count ) {
 	U32	W = Width();
@@ -847,9 +841,7 @@ void	ImageFile::WriteScanline( U32 _Y, const bfloat4* _color, U32 _startX, U32 _
 		bits += pitch * _Y + _startX * pixelSize;
 
 	_count = MIN( _count, W-_startX );
-	for ( U32 i=_count; i > 0; i--, bits += pixelSize, _color++ ) {
-		m_pixelAccessor->Write( bits, *_color );
-	}
+	(*PixelFormat2SpanEncoder( m_pixelFormat ))( _color, bits, _count );
 }
 
 void	ImageFile::ReadPixels( pixelReaderWriter_t _reader, U32 _startX, U32 _startY, U32 _width, U32 _height ) const {
@@ -858,14 +850,53 @@ void	ImageFile::ReadPixels( pixelReaderWriter_t _reader, U32 _startX, U32 _start
 	if ( _height == ~0U )
 		_height = Height();
 
-	bfloat4*	tempScanline = new bfloat4[_width];
+	ScratchColors	scratch( _width );
+	bfloat4*		tempScanline = scratch.m_colors;
 	for ( U32 Y=0; Y < _height; Y++ ) {
 		ReadScanline( _startY+Y, tempScanline, _startX, _width );
 		for ( U32 X=0; X < _width; X++ ) {
 			(*_reader)( _startX+X, _startY+Y, tempScanline[X] );
 		}
 	}
-	delete[] tempScanline;
+}
+
+// Each thread keeps a small stack of buffers so visitors can themselves visit other images
+static const U32	MAX_SCRATCH_LEVELS = 4;
+struct	ScratchBuffers {
+	bfloat4*	m_colors[MAX_SCRATCH_LEVELS];
+	U32			m_counts[MAX_SCRATCH_LEVELS];
+	U32			m_level;
+
+	ScratchBuffers() : m_level( 0 ) {
+		memset( m_colors, 0, sizeof(m_colors) );
+		memset( m_counts, 0, sizeof(m_counts) );
+	}
+	~ScratchBuffers() {
+		for ( U32 i=0; i < MAX_SCRATCH_LEVELS; i++ )
+			SAFE_DELETE_ARRAY( m_colors[i] );
+	}
+};
+static thread_local ScratchBuffers	ts_scratchBuffers;
+
+ImageFile::ScratchColors::ScratchColors( U32 _colorsCount ) {
+	m_level = ts_scratchBuffers.m_level++;
+	if ( m_level >= MAX_SCRATCH_LEVELS ) {
+		m_colors = new bfloat4[_colorsCount];	// Too deep, use a temporary buffer
+		return;
+	}
+
+	if ( _colorsCount > ts_scratchBuffers.m_counts[m_level] ) {
+		SAFE_DELETE_ARRAY( ts_scratchBuffers.m_colors[m_level] );
+		ts_scratchBuffers.m_colors[m_level] = new bfloat4[_colorsCount];
+		ts_scratchBuffers.m_counts[m_level] = _colorsCount;
+	}
+	m_colors = ts_scratchBuffers.m_colors[m_level];
+}
+
+ImageFile::ScratchColors::~ScratchColors() {
+	if ( m_level >= MAX_SCRATCH_LEVELS )
+		SAFE_DELETE_ARRAY( m_colors );
+	ts_scratchBuffers.m_level--;
 }
 
 void	ImageFile::WritePixels( pixelReaderWriter_t _writer, U32 _startX, U32 _startY, U32 _width, U32 _height ) {
@@ -874,14 +905,14 @@ void	ImageFile::WritePixels( pixelReaderWriter_t _writer, U32 _startX, U32 _star
 	if ( _height == ~0U )
 		_height = Height();
 
-	bfloat4*	tempScanline = new bfloat4[_width];
+	ScratchColors	scratch( _width );
+	bfloat4*		tempScanline = scratch.m_colors;
 	for ( U32 Y=0; Y < _height; Y++ ) {
 		for ( U32 X=0; X < _width; X++ ) {
 			(*_writer)( _startX+X, _startY+Y, tempScanline[X] );
 		}
 		WriteScanline( _startY+Y, tempScanline, _startX, _width );
 	}
-	delete[] tempScanline;
 }
 
 void	ImageFile::ReadWritePixels( pixelReaderWriter_t _writer, U32 _startX, U32 _startY, U32 _width, U32 _height ) {
@@ -890,7 +921,8 @@ void	ImageFile::ReadWritePixels( pixelReaderWriter_t _writer, U32 _startX, U32 _
 	if ( _height == ~0U )
 		_height = Height();
 
-	bfloat4*	tempScanline = new bfloat4[_width];
+	ScratchColors	scratch( _width );
+	bfloat4*		tempScanline = scratch.m_colors;
 	for ( U32 Y=0; Y < _height; Y++ ) {
 		ReadScanline( _startY+Y, tempScanline, _startX, _width );
 		for ( U32 X=0; X < _width; X++ ) {
@@ -898,7 +930,6 @@ void	ImageFile::ReadWritePixels( pixelReaderWriter_t _writer, U32 _startX, U32 _
 		}
 		WriteScanline( _startY+Y, tempScanline, _startX, _width );
 	}
-	delete[] tempScanline;
 }
 
 
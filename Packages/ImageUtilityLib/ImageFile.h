@@ -49,6 +49,7 @@
 #define IMAGE_FILE_INCLUDED
 
 #include "MetaData.h"
+#include "..\BaseLib\Utility\ThreadPool.h"
 
 namespace ImageUtilityLib {
 
@@ -324,6 +325,18 @@ namespace ImageUtilityLib {
 		void				WritePixels( pixelReaderWriter_t _writer, U32 _startX=0, U32 _startY=0, U32 _width=~0U, U32 _height=~0U );
 		void				ReadWritePixels( pixelReaderWriter_t _writer, U32 _startX=0, U32 _startY=0, U32 _width=~0U, U32 _height=~0U );	// Same as WritePixels() but the color provided to the delegate is the actual current color of the pixel
 
+		// Parallel color visitors
+		// The region is split into bands of rows (or into tiles) that are dispatched to the default ThreadPool, the colors are decoded into per-thread scratch buffers
+		//	 Row visitors have the signature void( U32 _X, U32 _Y, U32 _count, bfloat4* _colors )
+		//	 Tile visitors have the signature void( U32 _X, U32 _Y, U32 _width, U32 _height, bfloat4* _colors ) where _colors holds _width*_height colors, row by row
+		// WARNING: The visitor is called concurrently from several threads! Results are deterministic as long as it only touches the colors it's given
+		template< typename F > void	ReadRows( const F& _reader, U32 _startX=0, U32 _startY=0, U32 _width=~0U, U32 _height=~0U ) const						{ VisitTiles( false, true, ~0U, 1, RowVisitor<F>( _reader ), _startX, _startY, _width, _height ); }
+		template< typename F > void	WriteRows( const F& _writer, U32 _startX=0, U32 _startY=0, U32 _width=~0U, U32 _height=~0U )							{ VisitTiles( true, false, ~0U, 1, RowVisitor<F>( _writer ), _startX, _startY, _width, _height ); }
+		template< typename F > void	ReadWriteRows( const F& _writer, U32 _startX=0, U32 _startY=0, U32 _width=~0U, U32 _height=~0U )						{ VisitTiles( true, true, ~0U, 1, RowVisitor<F>( _writer ), _startX, _startY, _width, _height ); }
+		template< typename F > void	ReadTiles( U32 _tileSize, const F& _reader, U32 _startX=0, U32 _startY=0, U32 _width=~0U, U32 _height=~0U ) const		{ VisitTiles( false, true, _tileSize, _tileSize, _reader, _startX, _startY, _width, _height ); }
+		template< typename F > void	WriteTiles( U32 _tileSize, const F& _writer, U32 _startX=0, U32 _startY=0, U32 _width=~0U, U32 _height=~0U )			{ VisitTiles( true, false, _tileSize, _tileSize, _writer, _startX, _startY, _width, _height ); }
+		template< typename F > void	ReadWriteTiles( U32 _tileSize, const F& _writer, U32 _startX=0, U32 _startY=0, U32 _width=~0U, U32 _height=~0U )		{ VisitTiles( true, true, _tileSize, _tileSize, _writer, _startX, _startY, _width, _height ); }
+
 		// Retrieves the image file type based on the image file name
 		// WARNING: The image file MUST exist on disk as FreeImage inspects the content!
 		static FILE_FORMAT	GetFileTypeFromExistingFileContent( const wchar_t* _imageFileNameName );
@@ -384,6 +397,26 @@ namespace ImageUtilityLib {
 
 		void				ConvertFrom_NoSupport( const ImageFile& _source, PIXEL_FORMAT _targetFormat );
 
+		// Adapts a row visitor to the tile visitor signature (tiles are single rows)
+		template< typename F >
+		struct	RowVisitor {
+			const F&	m_visitor;
+			RowVisitor( const F& _visitor ) : m_visitor( _visitor ) {}
+			void	operator()( U32 _X, U32 _Y, U32 _width, U32 _height, bfloat4* _colors ) const	{ m_visitor( _X, _Y, _width, _colors ); }
+		};
+
+		template< typename F >
+		void				VisitTiles( bool _write, bool _read, U32 _tileWidth, U32 _tileHeight, const F& _visitor, U32 _startX, U32 _startY, U32 _width, U32 _height ) const;
+
+		// Scratch colors owned by the calling thread, only reallocated when growing (nested scopes get their own buffer)
+		class	ScratchColors {
+			U32			m_level;
+		public:
+			bfloat4*	m_colors;
+			ScratchColors( U32 _colorsCount );
+			~ScratchColors();
+		};
+
 	private:	// Ref-counting for free image lib init/release
 		static U32		ms_freeImageUsageRefCount;
 		void				UseFreeImage();
@@ -393,4 +426,47 @@ namespace ImageUtilityLib {
 		static wchar_t	ms_lastDumpedText[1024];
 	};
 
+	template< typename F >
+	void	ImageFile::VisitTiles( bool _write, bool _read, U32 _tileWidth, U32 _tileHeight, const F& _visitor, U32 _startX, U32 _startY, U32 _width, U32 _height ) const {
+		_width = MIN( _width, Width() - MIN( _startX, Width() ) );
+		_height = MIN( _height, Height() - MIN( _startY, Height() ) );
+		if ( _width == 0 || _height == 0 )
+			return;
+
+		// A tile size of 0 means single pixel tiles
+		_tileWidth = MAX( 1U, MIN( _tileWidth, _width ) );
+		_tileHeight = MAX( 1U, MIN( _tileHeight, _height ) );
+		U32	tilesCountX = (_width + _tileWidth - 1) / _tileWidth;
+		U32	tilesCountY = (_height + _tileHeight - 1) / _tileHeight;
+		U32	tilesCount = tilesCountX * tilesCountY;
+
+		// Group consecutive tiles so each thread gets a few bands to balance the load without too much scheduling
+		ThreadPool&	pool = ThreadPool::Default();
+		U32			grainSize = MAX( 1U, tilesCount / (4 * pool.GetThreadsCount()) );
+
+		ImageFile&	target = const_cast< ImageFile& >( *this );	// Only written to when _write is true, i.e. from the non-const visitors
+		pool.ParallelForRange( tilesCount, grainSize, [&]( U32 _start, U32 _end, U32 _threadIndex ) {
+			ScratchColors	scratch( _tileWidth * _tileHeight );
+			bfloat4*		colors = scratch.m_colors;
+			for ( U32 tileIndex=_start; tileIndex < _end; tileIndex++ ) {
+				U32	X = _startX + (tileIndex % tilesCountX) * _tileWidth;
+				U32	Y = _startY + (tileIndex / tilesCountX) * _tileHeight;
+				U32	W = MIN( _tileWidth, _startX + _width - X );
+				U32	H = MIN( _tileHeight, _startY + _height - Y );
+
+				if ( _read ) {
+					for ( U32 row=0; row < H; row++ )
+						ReadScanline( Y + row, colors + row * W, X, W );
+				}
+
+				_visitor( X, Y, W, H, colors );
+
+				if ( _write ) {
+					for ( U32 row=0; row < H; row++ )
+						target.WriteScanline( Y + row, colors + row * W, X, W );
+				}
+			}
+		} );
+	}
+
 }	// namespace
@@ -1,5 +1,6 @@
 #include "stdafx.h"
 #include "ImagesMatrix.h"
+#include "..\DirectXTex\DirectXTex\DDS.h"
 #include <d3d11.h>
 
 using namespace ImageUtilityLib;
@@ -7,7 +8,8 @@ using namespace BaseLib;
 
 ImagesMatrix::ImagesMatrix()
 	: m_type( TYPE::GENERIC )
-	, m_format( PIXEL_FORMAT::UNKNOWN ) {
+	, m_format( PIXEL_FORMAT::UNKNOWN )
+	, m_mappedFile( NULL ) {
 }
 ImagesMatrix::~ImagesMatrix() {
 	ReleasePointers();
@@ -131,6 +133,14 @@ void	ImagesMatrix::AllocateRawBuffers( PIXEL_FORMAT _format, const GetRawBufferS
 }
 
 void	ImagesMatrix::ReleasePointers() {
+	if ( m_mappedFile != NULL ) {
+		// Raw buffers are pointing into the mapped file, forget them before unmapping it
+		for ( U32 i=0; i < m_mipsArray.Count(); i++ ) {
+			m_mipsArray[i].ClearPointers();
+		}
+		SAFE_DELETE( m_mappedFile );
+	}
+
 	for ( U32 i=0; i < m_mipsArray.Count(); i++ ) {
 		m_mipsArray[i].ReleasePointers();
 	}
@@ -222,23 +232,298 @@ static void		Copy( const DirectX::Image& _source, ImageFile& _target ) {
 	}
 }
 
-static void		Copy( const ImageFile& _source, const DirectX::Image& _target ) {
-	if (	_source.Width() != _target.width
-		||	_source.Height() != _target.height ) {
+// Copies rows from a buffer with a given pitch into a buffer with another pitch
+//	For block-compressed formats, a "row" is a row of blocks
+static void		CopyRows( const U8* _source, U32 _sourceRowPitch, U8* _target, U32 _targetRowPitch, U32 _rowsCount ) {
+	if ( _sourceRowPitch == _targetRowPitch ) {
+		memcpy( _target, _source, _rowsCount * _targetRowPitch );
+		return;
+	}
+
+	U32	rowSize = MIN( _sourceRowPitch, _targetRowPitch );
+	for ( U32 Y=0; Y < _rowsCount; Y++ ) {
+		memcpy( _target + Y * _targetRowPitch, _source + Y * _sourceRowPitch, rowSize );
+	}
+}
+
+static void		ComputeDDSPitches( DXGI_FORMAT _format, U32 _width, U32 _height, U32& _rowPitch, U32& _slicePitch ) {
+	size_t	rowPitch, slicePitch;
+	DirectX::ComputePitch( _format, _width, _height, rowPitch, slicePitch );
+	_rowPitch = U32(rowPitch);
+	_slicePitch = U32(slicePitch);
+}
+
+// Packs a single slice of a mip (either from its image or from its raw buffer) into a buffer with the DDS pitches
+static void		PackDDSSlice( const ImagesMatrix::Mips::Mip& _mip, U32 _sliceIndex, U32 _rowPitch, U32 _slicePitch, U8* _target ) {
+	const U8*	source = NULL;
+	U32			sourceRowPitch = 0;
+	if ( _mip.GetRawBuffer() != NULL ) {
+		source = _mip.GetRawBuffer() + _sliceIndex * _mip.SlicePitch();
+		sourceRowPitch = _mip.RowPitch();
+	} else {
+		const ImageFile*	sourceImage = _mip[_sliceIndex];
+		if ( sourceImage == NULL )
+			throw "Invalid source image! The images matrix is not initialized!";
+		if ( sourceImage->Width() != _mip.Width() || sourceImage->Height() != _mip.Height() )
 			throw "Source and target image sizes mismatch!";
+
+		source = sourceImage->GetBits();
+		sourceRowPitch = sourceImage->Pitch();
 	}
 
-	U32		targetSize = U32(_target.rowPitch);
-	U32		sourceSize = _source.Pitch();
-	for ( U32 Y=0; Y < _target.height; Y++ ) {
-		const U8*	scanlineSource = _source.GetBits() + Y * sourceSize;
-		U8*			scanlineTarget = _target.pixels + Y * targetSize;
-		memcpy_s( scanlineTarget, targetSize, scanlineSource, targetSize );
+	CopyRows( source, sourceRowPitch, _target, _rowPitch, _slicePitch / _rowPitch );
+}
+
+// Maps DDS_PIXELFORMAT legacy descriptors to the DXGI formats DirectX would load them as without any conversion
+//	Returns DXGI_FORMAT_UNKNOWN for formats that need a conversion (e.g. 24-bits RGB, 16-bits RGB, palettes, etc.)
+static DXGI_FORMAT	DDSLegacyFormat( const DirectX::DDS_PIXELFORMAT& _pixelFormat ) {
+	if ( _pixelFormat.dwFlags & DDS_FOURCC ) {
+		switch ( _pixelFormat.dwFourCC ) {
+			case MAKEFOURCC( 'D', 'X', 'T', '1' ):	return DXGI_FORMAT_BC1_UNORM;
+			case MAKEFOURCC( 'D', 'X', 'T', '2' ):
+			case MAKEFOURCC( 'D', 'X', 'T', '3' ):	return DXGI_FORMAT_BC2_UNORM;
+			case MAKEFOURCC( 'D', 'X', 'T', '4' ):
+			case MAKEFOURCC( 'D', 'X', 'T', '5' ):	return DXGI_FORMAT_BC3_UNORM;
+			case MAKEFOURCC( 'A', 'T', 'I', '1' ):
+			case MAKEFOURCC( 'B', 'C', '4', 'U' ):	return DXGI_FORMAT_BC4_UNORM;
+			case MAKEFOURCC( 'B', 'C', '4', 'S' ):	return DXGI_FORMAT_BC4_SNORM;
+			case MAKEFOURCC( 'A', 'T', 'I', '2' ):
+			case MAKEFOURCC( 'B', 'C', '5', 'U' ):	return DXGI_FORMAT_BC5_UNORM;
+			case MAKEFOURCC( 'B', 'C', '5', 'S' ):	return DXGI_FORMAT_BC5_SNORM;
+
+			// D3DFORMAT codes
+			case 36:	return DXGI_FORMAT_R16G16B16A16_UNORM;	// D3DFMT_A16B16G16R16
+			case 110:	return DXGI_FORMAT_R16G16B16A16_SNORM;	// D3DFMT_Q16W16V16U16
+			case 111:	return DXGI_FORMAT_R16_FLOAT;			// D3DFMT_R16F
+			case 112:	return DXGI_FORMAT_R16G16_FLOAT;		// D3DFMT_G16R16F
+			case 113:	return DXGI_FORMAT_R16G16B16A16_FLOAT;	// D3DFMT_A16B16G16R16F
+			case 114:	return DXGI_FORMAT_R32_FLOAT;			// D3DFMT_R32F
+			case 115:	return DXGI_FORMAT_R32G32_FLOAT;		// D3DFMT_G32R32F
+			case 116:	return DXGI_FORMAT_R32G32B32A32_FLOAT;	// D3DFMT_A32B32G32R32F
+		}
+		return DXGI_FORMAT_UNKNOWN;
+	}
+
+	#define	HAS_MASKS( r, g, b, a )	(_pixelFormat.dwRBitMask == r && _pixelFormat.dwGBitMask == g && _pixelFormat.dwBBitMask == b && _pixelFormat.dwABitMask == a)
+	if ( _pixelFormat.dwFlags & DDS_RGB ) {
+		if ( _pixelFormat.dwRGBBitCount == 32 ) {
+			if ( HAS_MASKS( 0x000000FF, 0x0000FF00, 0x00FF0000, 0xFF000000 ) )	return DXGI_FORMAT_R8G8B8A8_UNORM;
+			if ( HAS_MASKS( 0x00FF0000, 0x0000FF00, 0x000000FF, 0xFF000000 ) )	return DXGI_FORMAT_B8G8R8A8_UNORM;
+			if ( HAS_MASKS( 0x00FF0000, 0x0000FF00, 0x000000FF, 0x00000000 ) )	return DXGI_FORMAT_B8G8R8X8_UNORM;
+			if ( HAS_MASKS( 0x0000FFFF, 0xFFFF0000, 0x00000000, 0x00000000 ) )	return DXGI_FORMAT_R16G16_UNORM;
+			if ( HAS_MASKS( 0xFFFFFFFF, 0x00000000, 0x00000000, 0x00000000 ) )	return DXGI_FORMAT_R32_FLOAT;
+		}
+	} else if ( _pixelFormat.dwFlags & DDS_LUMINANCE ) {
+		if ( _pixelFormat.dwRGBBitCount == 8 && HAS_MASKS( 0x000000FF, 0x00000000, 0x00000000, 0x00000000 ) )		return DXGI_FORMAT_R8_UNORM;
+		if ( _pixelFormat.dwRGBBitCount == 16 && HAS_MASKS( 0x0000FFFF, 0x00000000, 0x00000000, 0x00000000 ) )	return DXGI_FORMAT_R16_UNORM;
+	} else if ( _pixelFormat.dwFlags & DDS_ALPHA ) {
+		if ( _pixelFormat.dwRGBBitCount == 8 )	return DXGI_FORMAT_A8_UNORM;
+	}
+	#undef HAS_MASKS
+
+	return DXGI_FORMAT_UNKNOWN;
+}
+
+// Describes the layout of the content of a DDS file
+struct	DDSLayout {
+	DXGI_FORMAT			format;
+	ImagesMatrix::TYPE	type;
+	U32					width;
+	U32					height;
+	U32					depth;			// 1 for 2D textures
+	U32					arraySize;		// Amount of 2D slices (i.e. 6 times the amount of cube maps for cube textures), 1 for 3D textures
+	U32					mipLevelsCount;
+	U32					headerSize;		// Offset of the first mip in the file
+	U64					contentSize;	// Total size of the mips
+
+	// Size of the mip chain of a single array slice
+	U64		ComputeSliceContentSize() const {
+		U64	sliceContentSize = 0;
+		U32	W = width, H = height, D = depth;
+		for ( U32 mipLevelIndex=0; mipLevelIndex < mipLevelsCount; mipLevelIndex++ ) {
+			U32	rowPitch, slicePitch;
+			ComputeDDSPitches( format, W, H, rowPitch, slicePitch );
+			sliceContentSize += U64(D) * slicePitch;
+			ImagesMatrix::NextMipSize( W, H, D );
+		}
+		return sliceContentSize;
+	}
+
+	void	ComputeContentSize() {
+		contentSize = arraySize * ComputeSliceContentSize();
+	}
+};
+
+static const U32	DDS_DX10_HEADER_SIZE = sizeof(U32) + sizeof(DirectX::DDS_HEADER) + sizeof(DirectX::DDS_HEADER_DXT10);
+
+// Parses the header of a DDS file
+//	Returns false if the file uses a legacy format that needs a conversion, throws if the file is invalid
+static bool		DDSParseHeader( const U8* _fileContent, U64 _fileSize, DDSLayout& _layout ) {
+	if ( _fileSize < sizeof(U32) + sizeof(DirectX::DDS_HEADER) || *((const U32*) _fileContent) != DirectX::DDS_MAGIC )
+		throw "Not a DDS file!";
+
+	const DirectX::DDS_HEADER&	header = *((const DirectX::DDS_HEADER*) (_fileContent + sizeof(U32)));
+	if ( header.dwSize != sizeof(DirectX::DDS_HEADER) || header.ddspf.dwSize != sizeof(DirectX::DDS_PIXELFORMAT) )
+		throw "Invalid DDS header!";
+
+	_layout.width = header.dwWidth;
+	_layout.height = header.dwHeight;
+	_layout.depth = 1;
+	_layout.arraySize = 1;
+	_layout.mipLevelsCount = MAX( 1U, header.dwMipMapCount );
+	_layout.type = ImagesMatrix::TYPE::TEXTURE2D;
+
+	if ( (header.ddspf.dwFlags & DDS_FOURCC) && header.ddspf.dwFourCC == MAKEFOURCC( 'D', 'X', '1', '0' ) ) {
+		// DX10 extended header
+		if ( _fileSize < DDS_DX10_HEADER_SIZE )
+			throw "Truncated DDS file!";
+
+		const DirectX::DDS_HEADER_DXT10&	header10 = *((const DirectX::DDS_HEADER_DXT10*) (&header + 1));
+		_layout.format = header10.dxgiFormat;
+		_layout.arraySize = header10.arraySize;
+		if ( _layout.arraySize > 0xFFFFFFFFU / 6 )
+			throw "Invalid array size!";	// Would overflow once multiplied by the 6 cube faces
+		_layout.headerSize = DDS_DX10_HEADER_SIZE;
+		switch ( header10.resourceDimension ) {
+			case DirectX::DDS_DIMENSION_TEXTURE1D:
+				_layout.height = 1;
+				break;
+			case DirectX::DDS_DIMENSION_TEXTURE2D:
+				if ( header10.miscFlag & DirectX::DDS_RESOURCE_MISC_TEXTURECUBE ) {
+					_layout.type = ImagesMatrix::TYPE::TEXTURECUBE;
+					_layout.arraySize *= 6;
+				}
+				break;
+			case DirectX::DDS_DIMENSION_TEXTURE3D:
+				if ( _layout.arraySize != 1 )
+					throw "Invalid array size! Must be 1 for a 3D texture!";
+				_layout.type = ImagesMatrix::TYPE::TEXTURE3D;
+				_layout.depth = header.dwDepth;
+				break;
+			default:
+				throw "Unsupported DDS resource dimension!";
+		}
+	} else {
+		// Legacy header
+		_layout.format = DDSLegacyFormat( header.ddspf );
+		if ( _layout.format == DXGI_FORMAT_UNKNOWN )
+			return false;
+
+		_layout.headerSize = sizeof(U32) + sizeof(DirectX::DDS_HEADER);
+		if ( header.dwFlags & DDS_HEADER_FLAGS_VOLUME ) {
+			_layout.type = ImagesMatrix::TYPE::TEXTURE3D;
+			_layout.depth = header.dwDepth;
+		} else if ( header.dwCaps2 & DDS_CUBEMAP ) {
+			if ( (header.dwCaps2 & DDS_CUBEMAP_ALLFACES) != DDS_CUBEMAP_ALLFACES )
+				throw "Partial cube maps are not supported!";
+			_layout.type = ImagesMatrix::TYPE::TEXTURECUBE;
+			_layout.arraySize = 6;
+		}
 	}
+
+	if ( _layout.width == 0 || _layout.height == 0 || _layout.depth == 0 || _layout.arraySize == 0 )
+		throw "Invalid dimensions!";
+	if ( _layout.type == ImagesMatrix::TYPE::TEXTURECUBE && _layout.width != _layout.height )
+		throw "Cube texture width and height mismatch!";
+	if ( _layout.mipLevelsCount > ImagesMatrix::ComputeMipsCount( MAX( MAX( _layout.width, _layout.height ), _layout.depth ) ) )
+		throw "Invalid mip levels count!";
+
+	// Check the array size against the file size before anything else depends on it (a corrupt header could claim billions of slices)
+	U64	sliceContentSize = _layout.ComputeSliceContentSize();
+	if ( sliceContentSize == 0 || _layout.arraySize > (_fileSize - _layout.headerSize) / sliceContentSize )
+		throw "Truncated DDS file!";
+
+	_layout.contentSize = _layout.arraySize * sliceContentSize;
+
+	return true;
 }
 
+// Writes the header of a DDS file, always using the DX10 extension
+static void		DDSWriteHeader( const DDSLayout& _layout, U8* _target ) {
+	*((U32*) _target) = DirectX::DDS_MAGIC;
+
+	bool	isCompressed = DirectX::IsCompressed( _layout.format );
+	U32		rowPitch, slicePitch;
+	ComputeDDSPitches( _layout.format, _layout.width, _layout.height, rowPitch, slicePitch );
+
+	DirectX::DDS_HEADER&	header = *((DirectX::DDS_HEADER*) (_target + sizeof(U32)));
+	memset( &header, 0, sizeof(DirectX::DDS_HEADER) );
+	header.dwSize = sizeof(DirectX::DDS_HEADER);
+	header.dwFlags = DDS_HEADER_FLAGS_TEXTURE | DDS_HEADER_FLAGS_MIPMAP | (isCompressed ? DDS_HEADER_FLAGS_LINEARSIZE : DDS_HEADER_FLAGS_PITCH);
+	header.dwWidth = _layout.width;
+	header.dwHeight = _layout.height;
+	header.dwPitchOrLinearSize = isCompressed ? slicePitch : rowPitch;
+	header.dwMipMapCount = _layout.mipLevelsCount;
+	header.ddspf.dwSize = sizeof(DirectX::DDS_PIXELFORMAT);
+	header.ddspf.dwFlags = DDS_FOURCC;
+	header.ddspf.dwFourCC = MAKEFOURCC( 'D', 'X', '1', '0' );
+	header.dwCaps = DDS_SURFACE_FLAGS_TEXTURE | (_layout.mipLevelsCount > 1 ? DDS_SURFACE_FLAGS_MIPMAP : 0);
+
+	DirectX::DDS_HEADER_DXT10&	header10 = *((DirectX::DDS_HEADER_DXT10*) (&header + 1));
+	memset( &header10, 0, sizeof(DirectX::DDS_HEADER_DXT10) );
+	header10.dxgiFormat = _layout.format;
+	header10.resourceDimension = DirectX::DDS_DIMENSION_TEXTURE2D;
+	header10.arraySize = _layout.arraySize;
+
+	switch ( _layout.type ) {
+		case ImagesMatrix::TYPE::TEXTURECUBE:
+			header.dwCaps |= DDS_SURFACE_FLAGS_CUBEMAP;
+			header.dwCaps2 = DDS_CUBEMAP_ALLFACES;
+			header10.miscFlag = DirectX::DDS_RESOURCE_MISC_TEXTURECUBE;
+			header10.arraySize = _layout.arraySize / 6;
+			break;
+		case ImagesMatrix::TYPE::TEXTURE3D:
+			header.dwFlags |= DDS_HEADER_FLAGS_VOLUME;
+			header.dwDepth = _layout.depth;
+			header.dwCaps2 = DDS_FLAGS_VOLUME;
+			header10.resourceDimension = DirectX::DDS_DIMENSION_TEXTURE3D;
+			break;
+	}
+}
+
+// Read-only view of a whole file
+struct	ImagesMatrix::MappedFile {
+	const U8*	m_content;
+	U64			m_size;
+
+	MappedFile( const wchar_t* _fileName ) : m_content( NULL ), m_size( 0 ) {
+		HANDLE	file = CreateFileW( _fileName, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL );
+		if ( file == INVALID_HANDLE_VALUE )
+			throw "Failed to open the DDS file!";
+
+		LARGE_INTEGER	fileSize;
+		HANDLE			mapping = NULL;
+		if ( GetFileSizeEx( file, &fileSize ) && fileSize.QuadPart > 0 ) {
+			m_size = U64(fileSize.QuadPart);
+			mapping = CreateFileMappingW( file, NULL, PAGE_READONLY, 0, 0, NULL );
+		}
+		CloseHandle( file );	// The mapping keeps the file open
+		if ( mapping == NULL )
+			throw "Failed to map the DDS file!";
+
+		m_content = (const U8*) MapViewOfFile( mapping, FILE_MAP_READ, 0, 0, 0 );
+		CloseHandle( mapping );	// The view keeps the mapping alive
+		if ( m_content == NULL )
+			throw "Failed to map the DDS file!";
+	}
+	~MappedFile() {
+		UnmapViewOfFile( m_content );
+	}
+};
+
+
 void	ImagesMatrix::DDSLoadFile( const wchar_t* _fileName, COMPONENT_FORMAT& _componentFormat ) {
-	// Load the image
+	// Parse the mapped file directly so the content is only copied once, into the images
+	DDSLayout	layout;
+	{
+		MappedFile	file( _fileName );
+		if ( DDSParseHeader( file.m_content, file.m_size, layout ) ) {
+			DDSLoadLayout( &layout, file.m_content, false, _componentFormat );
+			return;
+		}
+	}
+
+	// Legacy formats requiring a conversion are loaded by DirectX
 	DirectX::ScratchImage*	DXT = new DirectX::ScratchImage();
 	DirectX::TexMetadata	meta;
 	DWORD	flags = DirectX::DDS_FLAGS_NONE;
@@ -253,7 +538,13 @@ void	ImagesMatrix::DDSLoadFile( const wchar_t* _fileName, COMPONENT_FORMAT& _com
 	delete DXT;
 }
 void	ImagesMatrix::DDSLoadMemory( U64 _fileSize, void* _fileContent, COMPONENT_FORMAT& _componentFormat ) {
-	// Load the image
+	DDSLayout	layout;
+	if ( DDSParseHeader( (const U8*) _fileContent, _fileSize, layout ) ) {
+		DDSLoadLayout( &layout, (const U8*) _fileContent, false, _componentFormat );
+		return;
+	}
+
+	// Legacy formats requiring a conversion are loaded by DirectX
 	DirectX::ScratchImage*	DXT = new DirectX::ScratchImage();
 	DirectX::TexMetadata	meta;
 	DWORD	flags = DirectX::DDS_FLAGS_NONE;
@@ -267,6 +558,82 @@ void	ImagesMatrix::DDSLoadMemory( U64 _fileSize, void* _fileContent, COMPONENT_F
 
 	delete DXT;
 }
+void	ImagesMatrix::DDSMapFile( const wchar_t* _fileName, COMPONENT_FORMAT& _componentFormat ) {
+	MappedFile*	file = new MappedFile( _fileName );
+	try {
+		DDSLayout	layout;
+		if ( !DDSParseHeader( file->m_content, file->m_size, layout ) )
+			throw "Unsupported legacy DDS format! Use DDSLoadFile() to convert it...";
+
+		DDSLoadLayout( &layout, file->m_content, true, _componentFormat );	// Releases any previous mapping
+	} catch ( ... ) {
+		// Forget the mips that were already pointing into the file before unmapping it
+		for ( U32 arrayIndex=0; arrayIndex < m_mipsArray.Count(); arrayIndex++ ) {
+			Mips&	mips = m_mipsArray[arrayIndex];
+			for ( U32 mipLevelIndex=0; mipLevelIndex < mips.GetMipLevelsCount(); mipLevelIndex++ ) {
+				const U8*	rawBuffer = mips[mipLevelIndex].GetRawBuffer();
+				if ( rawBuffer >= file->m_content && rawBuffer < file->m_content + file->m_size )
+					mips[mipLevelIndex].ClearPointers();
+			}
+		}
+		delete file;
+		throw;
+	}
+
+	m_mappedFile = file;
+}
+void	ImagesMatrix::DDSLoadLayout( const void* _blindPointerLayout, const U8* _fileContent, bool _mapView, COMPONENT_FORMAT& _componentFormat ) {
+	const DDSLayout&	layout = *reinterpret_cast<const DDSLayout*>( _blindPointerLayout );
+
+	// Retrieve supported format
+	U32				pixelSize = 0;
+	PIXEL_FORMAT	format = DXGIFormat2PixelFormat( layout.format, _componentFormat, pixelSize );
+	if ( format == PIXEL_FORMAT::UNKNOWN )
+		throw "Unsupported format! Cannot find appropriate target image format to support source DXGI format...";
+
+	ColorProfile	profile( _componentFormat == COMPONENT_FORMAT::UNORM_sRGB ? ColorProfile::STANDARD_PROFILE::sRGB : ColorProfile::STANDARD_PROFILE::LINEAR );
+
+	switch ( layout.type ) {
+		case ImagesMatrix::TYPE::TEXTURECUBE:	InitCubeTextureArray( layout.width, layout.arraySize / 6, layout.mipLevelsCount ); break;
+		case ImagesMatrix::TYPE::TEXTURE3D:		InitTexture3D( layout.width, layout.height, layout.depth, layout.mipLevelsCount ); break;
+		default:								InitTexture2DArray( layout.width, layout.height, layout.arraySize, layout.mipLevelsCount ); break;
+	}
+
+	bool	isRawBuffer = _mapView || (U32(format) & U32(PIXEL_FORMAT::RAW_BUFFER)) != 0;
+	if ( isRawBuffer ) {
+		m_format = PIXEL_FORMAT( U32(format) | U32(PIXEL_FORMAT::RAW_BUFFER) );
+		m_colorProfile = profile;
+	} else {
+		AllocateImageFiles( format, profile );
+	}
+
+	// The mips of each array slice are stored contiguously, and 3D textures store each mip's slices contiguously: our matrix follows the exact same order
+	const U8*	mipContent = _fileContent + layout.headerSize;
+	for ( U32 arrayIndex=0; arrayIndex < m_mipsArray.Count(); arrayIndex++ ) {
+		Mips&	mips = m_mipsArray[arrayIndex];
+		for ( U32 mipLevelIndex=0; mipLevelIndex < mips.GetMipLevelsCount(); mipLevelIndex++ ) {
+			Mips::Mip&	mip = mips[mipLevelIndex];
+
+			U32	rowPitch, slicePitch;
+			ComputeDDSPitches( layout.format, mip.Width(), mip.Height(), rowPitch, slicePitch );
+
+			if ( _mapView ) {
+				mip.MapRawBuffer( rowPitch, slicePitch, const_cast< U8* >( mipContent ) );	// Read-only!
+			} else if ( isRawBuffer ) {
+				mip.AllocateRawBuffer( rowPitch, slicePitch, mipContent );
+			} else {
+				for ( U32 sliceIndex=0; sliceIndex < mip.Depth(); sliceIndex++ ) {
+					ImageFile&	targetImage = *mip[sliceIndex];
+					targetImage.m_fileFormat = ImageFile::FILE_FORMAT::DDS;
+					CopyRows( mipContent + sliceIndex * slicePitch, rowPitch, targetImage.GetBits(), targetImage.Pitch(), mip.Height() );
+				}
+			}
+
+			mipContent += mip.Depth() * slicePitch;
+		}
+	}
+}
+
 void	ImagesMatrix::DDSLoad( const void* _blindPointerImage, const void* _blindPointerMetaData, COMPONENT_FORMAT& _componentFormat ) {
 	const DirectX::ScratchImage&	image = *reinterpret_cast<const DirectX::ScratchImage*>( _blindPointerImage );
 	const DirectX::TexMetadata&		meta = *reinterpret_cast<const DirectX::TexMetadata*>( _blindPointerMetaData );
@@ -372,160 +739,245 @@ void	ImagesMatrix::DDSLoad( const void* _blindPointerImage, const void* _blindPo
 }
 
 void	ImagesMatrix::DDSSaveFile( const wchar_t* _fileName, COMPONENT_FORMAT _componentFormat ) const {
-
-	// Create and fill the image
-	DirectX::ScratchImage*	DXT = NULL;
-	DDSSave( (void**) &DXT, _componentFormat );
-
-	// Save to disk
-	DWORD	flags = DirectX::DDS_FLAGS_FORCE_RGB | DirectX::DDS_FLAGS_NO_16BPP | DirectX::DDS_FLAGS_EXPAND_LUMINANCE | DirectX::DDS_FLAGS_FORCE_DX10_EXT;
-	HRESULT	hResult = DirectX::SaveToDDSFile( DXT->GetImages(), DXT->GetImageCount(), DXT->GetMetadata(), flags, _fileName );
-	if ( hResult != S_OK ) {
-		throw "An error occurred while saving the DDS file!";
+	DDSLayout	layout;
+	DDSDescribeLayout( &layout, _componentFormat );
+
+	// Stream each mip to disk
+	DDSStreamWriter	writer( _fileName, layout.type, m_format, _componentFormat, layout.width, layout.height, layout.type == TYPE::TEXTURE3D ? layout.depth : layout.arraySize, layout.mipLevelsCount );
+	for ( U32 arrayIndex=0; arrayIndex < layout.arraySize; arrayIndex++ ) {
+		const Mips&	sourceMips = m_mipsArray[arrayIndex];
+		for ( U32 mipLevelIndex=0; mipLevelIndex < layout.mipLevelsCount; mipLevelIndex++ ) {
+			writer.WriteMip( sourceMips[mipLevelIndex] );
+		}
 	}
-
-	// Release the image
-	delete DXT;
+	writer.Close();
 }
 void	ImagesMatrix::DDSSaveMemory( U64& _fileSize, void*& _fileContent, COMPONENT_FORMAT _componentFormat ) const {
+	DDSLayout	layout;
+	DDSDescribeLayout( &layout, _componentFormat );
 
-	// Create and fill the image
-	DirectX::ScratchImage*	DXT = NULL;
-	DDSSave( (void**) &DXT, _componentFormat );
+	// Pack each mip directly into the target buffer
+	_fileSize = layout.headerSize + layout.contentSize;
+	U8*	targetBuffer = new U8[_fileSize];
+	_fileContent = targetBuffer;
 
-	// Transfer into a memory blob
-	DirectX::Blob	blob;
-	DWORD			flags = DirectX::DDS_FLAGS_FORCE_RGB | DirectX::DDS_FLAGS_NO_16BPP | DirectX::DDS_FLAGS_EXPAND_LUMINANCE | DirectX::DDS_FLAGS_FORCE_DX10_EXT;
-	HRESULT			hResult = DirectX::SaveToDDSMemory( DXT->GetImages(), DXT->GetImageCount(), DXT->GetMetadata(), flags, blob );
-	if ( hResult != S_OK ) {
-		throw "An error occurred while saving the DDS file into memory!";
-	}
+	DDSWriteHeader( layout, targetBuffer );
 
-	// Release the image
-	delete DXT;
+	U8*	mipContent = targetBuffer + layout.headerSize;
+	for ( U32 arrayIndex=0; arrayIndex < layout.arraySize; arrayIndex++ ) {
+		const Mips&	sourceMips = m_mipsArray[arrayIndex];
+		for ( U32 mipLevelIndex=0; mipLevelIndex < layout.mipLevelsCount; mipLevelIndex++ ) {
+			const Mips::Mip&	sourceMip = sourceMips[mipLevelIndex];
 
-	// Copy blob content
-	_fileSize = blob.GetBufferSize();
-	 U8*	targetBuffer = new U8[_fileSize];
-	_fileContent = targetBuffer;
-	memcpy_s( targetBuffer, _fileSize, blob.GetBufferPointer(), blob.GetBufferSize() );
+			U32	rowPitch, slicePitch;
+			ComputeDDSPitches( layout.format, sourceMip.Width(), sourceMip.Height(), rowPitch, slicePitch );
+			for ( U32 sliceIndex=0; sliceIndex < sourceMip.Depth(); sliceIndex++ ) {
+				PackDDSSlice( sourceMip, sliceIndex, rowPitch, slicePitch, mipContent );
+				mipContent += slicePitch;
+			}
+		}
+	}
 }
 
-void	ImagesMatrix::DDSSave( void** _blindPointerImage, COMPONENT_FORMAT _componentFormat ) const {
-	DirectX::ScratchImage*&	image = *reinterpret_cast<DirectX::ScratchImage**>( _blindPointerImage );
+void	ImagesMatrix::DDSDescribeLayout( void* _blindPointerLayout, COMPONENT_FORMAT _componentFormat ) const {
+	DDSLayout&	layout = *reinterpret_cast<DDSLayout*>( _blindPointerLayout );
 
-	DXGI_FORMAT	DXFormat = PixelFormat2DXGIFormat( GetFormat(), _componentFormat );
-	if ( DXFormat == DXGI_FORMAT_UNKNOWN )
+	layout.format = PixelFormat2DXGIFormat( GetFormat(), _componentFormat );
+	if ( layout.format == DXGI_FORMAT_UNKNOWN )
 		throw "Unsupported image format! Cannot find appropriate target DXGI format to support source image format...";
 
-	// Build DTex scratch image
-	image = new DirectX::ScratchImage();
-
-	U32	arraySize = GetArraySize();
-	if ( arraySize == 0 )
+	layout.arraySize = GetArraySize();
+	if ( layout.arraySize == 0 )
 		throw "Invalid array size!";
-	U32	mipLevelsCount = m_mipsArray[0].GetMipLevelsCount();
-	if ( mipLevelsCount == 0 )
+	layout.mipLevelsCount = m_mipsArray[0].GetMipLevelsCount();
+	if ( layout.mipLevelsCount == 0 )
 		throw "Invalid mip levels count!";
 
-	U32	W = m_mipsArray[0][0].Width();
-	U32	H = m_mipsArray[0][0].Height();
-	U32	D = m_mipsArray[0][0].Depth();
-	if ( W == 0 || H == 0 || D == 0 )
+	layout.width = m_mipsArray[0][0].Width();
+	layout.height = m_mipsArray[0][0].Height();
+	layout.depth = m_mipsArray[0][0].Depth();
+	if ( layout.width == 0 || layout.height == 0 || layout.depth == 0 )
 		throw "Invalid dimensions!";
 
 	switch ( m_type ) {
+		case ImagesMatrix::TYPE::TEXTURECUBE:
+			if ( layout.width != layout.height )
+				throw "Cube texture width and height mismatch!";
+			if ( (layout.arraySize % 6) != 0 )
+				throw "Array size is not an integer multiple of 6!";
+			// Fall through...
 		case ImagesMatrix::TYPE::GENERIC:
 		case ImagesMatrix::TYPE::TEXTURE2D:
-		case ImagesMatrix::TYPE::TEXTURECUBE: {
 			// Assume 2D texture
-			if ( D != 1 )
+			if ( layout.depth != 1 )
 				throw "Invalid depth! Must be 1 for a 2D texture";
+			layout.type = m_type == ImagesMatrix::TYPE::TEXTURECUBE ? ImagesMatrix::TYPE::TEXTURECUBE : ImagesMatrix::TYPE::TEXTURE2D;
+			break;
 
-			HRESULT	hr = S_FALSE;
-			if ( m_type == ImagesMatrix::TYPE::TEXTURECUBE ) {
-				if ( W != H )
-					throw "Cube texture width and height mismatch!";
-				if ( (arraySize % 6) != 0 )
-					throw "Array size is not an integer multiple of 6!";
-
-				hr = image->InitializeCube( DXFormat, W, H, arraySize / 6, mipLevelsCount );
-			} else {
-				hr = image->Initialize2D( DXFormat, W, H, arraySize, mipLevelsCount );
-			}
-			if ( hr != S_OK )
-				throw "Failed to initialize 2D texture!";
-
-// Why can't we just do it ourselves???
-// 			if ( _images.GetType() == ImagesMatrix::TYPE::TEXTURECUBE ) {
-// 				image->GetMetadata().miscFlags |= DirectX::TEX_MISC_TEXTURECUBE;
-// 			}
-
-			// Copy to scratch image
-			if ( (U32(m_format) & U32(PIXEL_FORMAT::RAW_BUFFER)) == 0 ) {
-				for ( U32 arrayIndex=0; arrayIndex < arraySize; arrayIndex++ ) {
-					const ImagesMatrix::Mips&	sourceMips = m_mipsArray[arrayIndex];
-					for ( U32 mipLevelIndex=0; mipLevelIndex < mipLevelsCount; mipLevelIndex++ ) {
-						const ImagesMatrix::Mips::Mip&	sourceMip = sourceMips[mipLevelIndex];
-						const ImageFile*				sourceImage = sourceMip[0];
-						if ( sourceImage == NULL )
-							throw "Invalid source image! The images matrix is not initialized!";
-
-						const DirectX::Image*	targetImage = image->GetImage( mipLevelIndex, arrayIndex, 0 );
-						Copy( *sourceImage, *targetImage );
-					}
-				}
-			} else {
-				for ( U32 arrayIndex=0; arrayIndex < arraySize; arrayIndex++ ) {
-					const ImagesMatrix::Mips&	sourceMips = m_mipsArray[arrayIndex];
-					for ( U32 mipLevelIndex=0; mipLevelIndex < mipLevelsCount; mipLevelIndex++ ) {
-						const ImagesMatrix::Mips::Mip&	sourceMip = sourceMips[mipLevelIndex];
-						U32								sourceSlicePitch = sourceMip.SlicePitch();
-						const U8*						sourceRawBuffer = sourceMip.GetRawBuffer();
-						const DirectX::Image*			targetImage = image->GetImage( mipLevelIndex, arrayIndex, 0 );
-						memcpy_s( targetImage->pixels, targetImage->slicePitch, sourceRawBuffer, sourceSlicePitch );
-					}
-				}
-			}
+		case ImagesMatrix::TYPE::TEXTURE3D:
+			if ( layout.arraySize != 1 )
+				throw "Invalid array size! Must be 1 for a 3D texture!";	// At least for the moment, DirectX doesn't support arrays of 3D textures (but we do! :D)
+			layout.type = ImagesMatrix::TYPE::TEXTURE3D;
 			break;
+	}
+
+	for ( U32 arrayIndex=0; arrayIndex < layout.arraySize; arrayIndex++ ) {
+		if ( m_mipsArray[arrayIndex].GetMipLevelsCount() != layout.mipLevelsCount )
+			throw "Mip levels count mismatch!";
+	}
+
+	layout.headerSize = DDS_DX10_HEADER_SIZE;
+	layout.ComputeContentSize();
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Streaming DDS writer
+//
+ImagesMatrix::DDSStreamWriter::DDSStreamWriter( const wchar_t* _fileName, TYPE _type, PIXEL_FORMAT _format, COMPONENT_FORMAT _componentFormat, U32 _width, U32 _height, U32 _depthOrArraySize, U32 _mipLevelsCount )
+	: m_file( INVALID_HANDLE_VALUE )
+	, m_fileName( NULL )
+	, m_writtenMipsCount( 0 )
+	, m_scratchSlice( NULL ) {
+
+	m_DXFormat = PixelFormat2DXGIFormat( _format, _componentFormat );
+	if ( m_DXFormat == DXGI_FORMAT_UNKNOWN )
+		throw "Unsupported image format! Cannot find appropriate target DXGI format to support source image format...";
+	if ( _width == 0 || _height == 0 || _depthOrArraySize == 0 )
+		throw "Invalid dimensions!";
+	if ( _mipLevelsCount == 0 )
+		_mipLevelsCount = ComputeMipsCount( MAX( MAX( _width, _height ), _type == TYPE::TEXTURE3D ? _depthOrArraySize : 1U ) );
+
+	DDSLayout	layout;
+	layout.format = m_DXFormat;
+	layout.type = _type == TYPE::GENERIC ? TYPE::TEXTURE2D : _type;
+	layout.width = _width;
+	layout.height = _height;
+	layout.depth = _type == TYPE::TEXTURE3D ? _depthOrArraySize : 1;
+	layout.arraySize = _type == TYPE::TEXTURE3D ? 1 : _depthOrArraySize;
+	layout.mipLevelsCount = _mipLevelsCount;
+	layout.headerSize = DDS_DX10_HEADER_SIZE;
+	if ( layout.type == TYPE::TEXTURECUBE && ((layout.arraySize % 6) != 0 || _width != _height) )
+		throw "Invalid cube texture dimensions!";
+
+	m_isVolume = layout.type == TYPE::TEXTURE3D;
+	m_width = layout.width;
+	m_height = layout.height;
+	m_depth = layout.depth;
+	m_arraySize = layout.arraySize;
+	m_mipLevelsCount = layout.mipLevelsCount;
+
+	m_file = CreateFileW( _fileName, GENERIC_WRITE, 0, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL );
+	if ( m_file == INVALID_HANDLE_VALUE )
+		throw "Failed to create the DDS file!";
+
+	// Keep the file name so an incomplete file can be deleted
+	size_t	fileNameLength = wcslen( _fileName ) + 1;
+	m_fileName = new wchar_t[fileNameLength];
+	wcscpy_s( m_fileName, fileNameLength, _fileName );
+
+	U8	header[DDS_DX10_HEADER_SIZE];
+	DDSWriteHeader( layout, header );
+	try {
+		Write( header, DDS_DX10_HEADER_SIZE );
+	} catch ( ... ) {
+		Abort();
+		SAFE_DELETE_ARRAY( m_fileName );	// The destructor won't be called
+		throw;
+	}
+
+	U32	rowPitch, slicePitch;
+	ComputeDDSPitches( m_DXFormat, m_width, m_height, rowPitch, slicePitch );	// Largest slice
+	m_scratchSlice = new U8[slicePitch];
+}
+
+ImagesMatrix::DDSStreamWriter::~DDSStreamWriter() {
+	if ( m_file != INVALID_HANDLE_VALUE ) {
+		// Not closed explicitly (e.g. a WriteMip() threw): only keep the file if it's complete
+		if ( m_writtenMipsCount == m_arraySize * m_mipLevelsCount ) {
+			CloseHandle( m_file );
+			m_file = INVALID_HANDLE_VALUE;
+		} else {
+			Abort();
 		}
+	}
+	SAFE_DELETE_ARRAY( m_fileName );
+	SAFE_DELETE_ARRAY( m_scratchSlice );
+}
 
-		case ImagesMatrix::TYPE::TEXTURE3D: {
-			// Assume 3D texture
-			if ( arraySize != 1 )
-				throw "Invalid array size! Must be 1 for a 3D texture!";	// At least for the moment, DirectX doesn't support arrays of 3D textures (but we do! :D)
+void	ImagesMatrix::DDSStreamWriter::WriteMip( const Mips::Mip& _mip ) {
+	if ( _mip.GetRawBuffer() != NULL ) {
+		WriteMip( _mip.GetRawBuffer(), _mip.RowPitch(), _mip.SlicePitch() );
+		return;
+	}
+	if ( m_writtenMipsCount >= m_arraySize * m_mipLevelsCount )
+		throw "Too many mips written!";
+
+	U32	mipLevelIndex = m_writtenMipsCount % m_mipLevelsCount;
+	U32	W = MAX( 1U, m_width >> mipLevelIndex );
+	U32	H = MAX( 1U, m_height >> mipLevelIndex );
+	U32	D = MAX( 1U, m_depth >> mipLevelIndex );
+	if ( _mip.Width() != W || _mip.Height() != H || _mip.Depth() != D )
+		throw "Mip size mismatch! Mips must be written in the DDS order...";
+
+	U32	rowPitch, slicePitch;
+	ComputeDDSPitches( m_DXFormat, W, H, rowPitch, slicePitch );
+
+	// Pack one slice at a time
+	for ( U32 sliceIndex=0; sliceIndex < D; sliceIndex++ ) {
+		PackDDSSlice( _mip, sliceIndex, rowPitch, slicePitch, m_scratchSlice );
+		Write( m_scratchSlice, slicePitch );
+	}
+	m_writtenMipsCount++;
+}
 
-			HRESULT	hr = image->Initialize3D( DXFormat, W, H, D, mipLevelsCount );
-			if ( hr != S_OK )
-				throw "Failed to initialize 3D texture!";
-
-			// Copy to scratch image
-			if ( (U32(m_format) & U32(PIXEL_FORMAT::RAW_BUFFER)) == 0 ) {
-				for ( U32 mipLevelIndex=0; mipLevelIndex < mipLevelsCount; mipLevelIndex++ ) {
-					for ( U32 sliceIndex=0; sliceIndex < D; sliceIndex++ ) {
-						const ImageFile*	sourceImage = m_mipsArray[0][mipLevelIndex][sliceIndex];
-						if ( sourceImage == NULL )
-							throw "Invalid source image! The images matrix is not initialized!";
-						const DirectX::Image*	targetImage = image->GetImage( mipLevelIndex, 0, sliceIndex );
-						Copy( *sourceImage, *targetImage );
-					}
-				}
-			} else {
-				const ImagesMatrix::Mips&	sourceMips = m_mipsArray[0];
-				for ( U32 mipLevelIndex=0; mipLevelIndex < mipLevelsCount; mipLevelIndex++ ) {
-					const ImagesMatrix::Mips::Mip&	sourceMip = sourceMips[mipLevelIndex];
-					U32								sourceSlicePitch = sourceMip.SlicePitch();
-					const U8*						sourceRawBuffer = sourceMip.GetRawBuffer();
-
-					for ( U32 sliceIndex=0; sliceIndex < sourceMip.Depth(); sliceIndex++ ) {
-						const DirectX::Image*	targetImage = image->GetImage( mipLevelIndex, 0, sliceIndex );
-						memcpy_s( targetImage->pixels, targetImage->slicePitch, sourceRawBuffer + sliceIndex * sourceSlicePitch, sourceMip.SlicePitch() );
-					}
-				}
-			}
-			break;
+void	ImagesMatrix::DDSStreamWriter::WriteMip( const U8* _rawBuffer, U32 _rowPitch, U32 _slicePitch ) {
+	if ( m_writtenMipsCount >= m_arraySize * m_mipLevelsCount )
+		throw "Too many mips written!";
+	RELEASE_ASSERT( _rawBuffer != NULL, "Invalid raw buffer!" );
+
+	U32	mipLevelIndex = m_writtenMipsCount % m_mipLevelsCount;
+	U32	W = MAX( 1U, m_width >> mipLevelIndex );
+	U32	H = MAX( 1U, m_height >> mipLevelIndex );
+	U32	D = MAX( 1U, m_depth >> mipLevelIndex );
+
+	U32	rowPitch, slicePitch;
+	ComputeDDSPitches( m_DXFormat, W, H, rowPitch, slicePitch );
+	if ( _rowPitch == rowPitch && _slicePitch == slicePitch ) {
+		// Same layout as the file, write all the slices at once
+		Write( _rawBuffer, D * slicePitch );
+	} else {
+		// Repack one slice at a time
+		for ( U32 sliceIndex=0; sliceIndex < D; sliceIndex++ ) {
+			CopyRows( _rawBuffer + sliceIndex * _slicePitch, _rowPitch, m_scratchSlice, rowPitch, slicePitch / rowPitch );
+			Write( m_scratchSlice, slicePitch );
 		}
 	}
+	m_writtenMipsCount++;
+}
+
+void	ImagesMatrix::DDSStreamWriter::Close() {
+	if ( m_file == INVALID_HANDLE_VALUE )
+		return;
+
+	if ( m_writtenMipsCount != m_arraySize * m_mipLevelsCount ) {
+		Abort();
+		throw "Missing mips! The DDS file is incomplete...";
+	}
+
+	CloseHandle( m_file );
+	m_file = INVALID_HANDLE_VALUE;
+}
+
+void	ImagesMatrix::DDSStreamWriter::Abort() {
+	CloseHandle( m_file );
+	m_file = INVALID_HANDLE_VALUE;
+	DeleteFileW( m_fileName );
+}
+
+void	ImagesMatrix::DDSStreamWriter::Write( const void* _data, U32 _size ) {
+	DWORD	writtenSize = 0;
+	if ( !WriteFile( m_file, _data, _size, &writtenSize, NULL ) || writtenSize != _size )
+		throw "An error occurred while writing the DDS file!";
 }
 
 
@@ -561,7 +1013,20 @@ public:
 	CompressedImagesCopier( const DirectX::ScratchImage& _sourceImages, ImagesMatrix& _targetMatrix ) : m_sourceImages( _sourceImages ), m_targetMatrix( _targetMatrix ) {}
 };
 
-void	ImagesMatrix::DDSCompress( const ImagesMatrix& _source, COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat, void* _blindPointerDevice ) {
+// Only gives the compressed pitches, the raw buffers are filled afterward by the block compressor
+class BlockCompressedPitches : public ImagesMatrix::GetRawBufferSizeFunctor {
+	virtual const U8*	operator()( U32 _arraySliceIndex, U32 _mipLevelIndex, U32& _rowPitch, U32& _slicePitch ) const override {
+		const ImagesMatrix::Mips::Mip&	targetMip = m_targetMatrix[_arraySliceIndex][_mipLevelIndex];
+		ComputeDDSPitches( m_targetFormat, targetMip.Width(), targetMip.Height(), _rowPitch, _slicePitch );
+		return NULL;
+	}
+	DXGI_FORMAT			m_targetFormat;
+	const ImagesMatrix&	m_targetMatrix;
+public:
+	BlockCompressedPitches( DXGI_FORMAT _targetFormat, const ImagesMatrix& _targetMatrix ) : m_targetFormat( _targetFormat ), m_targetMatrix( _targetMatrix ) {}
+};
+
+void	ImagesMatrix::DDSCompress( const ImagesMatrix& _source, COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat, void* _blindPointerDevice, BlockCompressor::QUALITY _quality ) {
 	if ( (U32(_source.m_format) & U32(PIXEL_FORMAT::RAW_BUFFER)) != 0 )
 		throw "Unsupported raw buffer source pixel format: the source images must be of a valid pixel type to be compressed!";
 
@@ -587,6 +1052,35 @@ void	ImagesMatrix::DDSCompress( const ImagesMatrix& _source, COMPRESSION_TYPE _c
 	U32			H = sourceReferenceMip.Height();
 	U32			D = sourceReferenceMip.Depth();
 
+	// =============================================================
+	// Use our own encoder for the CPU path whenever it supports the target format
+	if ( _blindPointerDevice == NULL && BlockCompressor::IsSupported( targetFormat ) ) {
+		InitTextureGeneric( W, H, D, arraySize, mipLevelsCount );
+		m_type = _source.m_type;
+
+		COMPONENT_FORMAT	targetComponentFormat;
+		U32					pixelSize;
+		PIXEL_FORMAT		format = DXGIFormat2PixelFormat( targetFormat, targetComponentFormat, pixelSize );
+		AllocateRawBuffers( format, BlockCompressedPitches( targetFormat, *this ) );
+
+		for ( U32 arrayIndex=0; arrayIndex < arraySize; arrayIndex++ ) {
+			const Mips&	sourceMips = _source[arrayIndex];
+			Mips&		targetMips = (*this)[arrayIndex];
+			for ( U32 mipLevelIndex=0; mipLevelIndex < mipLevelsCount; mipLevelIndex++ ) {
+				const Mips::Mip&	sourceMip = sourceMips[mipLevelIndex];
+				Mips::Mip&			targetMip = targetMips[mipLevelIndex];
+				for ( U32 Z=0; Z < targetMip.Depth(); Z++ ) {
+					const ImageFile*	sourceImage = sourceMip[Z];
+					if ( sourceImage == NULL )
+						throw "Invalid image: the ImagesMatrix must be allocated with valid image files before compression!";
+
+					BlockCompressor::CompressImage( targetFormat, *sourceImage, _quality, targetMip.GetRawBuffer() + Z * targetMip.SlicePitch(), targetMip.RowPitch() );
+				}
+			}
+		}
+		return;
+	}
+
 	// =============================================================
 	// Create & fill source scratch image
 	DirectX::ScratchImage	sourceImagesContainer;
@@ -645,7 +1139,7 @@ void	ImagesMatrix::DDSCompress( const ImagesMatrix& _source, COMPRESSION_TYPE _c
 	PIXEL_FORMAT		format = DXGIFormat2PixelFormat( targetFormat, targetComponentFormat, pixelSize );
 	ASSERT( targetComponentFormat == _componentFormat, "Component formats mismatch!" );	// Routine check that's quite useless after all since we chose the component format ourselves so obviously it should be equal to what we chose... :/
 
-	CompressedImagesCopier	 compressor( sourceImagesContainer, *this );
+	CompressedImagesCopier	 compressor( targetImagesContainer, *this );
 	AllocateRawBuffers( format, compressor );
 }
 
@@ -682,12 +1176,29 @@ void	ImagesMatrix::DDSCompress( const ImagesMatrix& _source, COMPRESSION_TYPE _c
 
 DXGI_FORMAT	ImagesMatrix::CompressionType2DXGIFormat( COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat ) {
 	switch ( _compressionType ) {
+	case COMPRESSION_TYPE::BC1:
+		switch ( _componentFormat ) {
+		case COMPONENT_FORMAT::AUTO:
+		case COMPONENT_FORMAT::UNORM:	return DXGI_FORMAT_BC1_UNORM;
+		case COMPONENT_FORMAT::UNORM_sRGB:	return DXGI_FORMAT_BC1_UNORM_SRGB;
+		}
+		return DXGI_FORMAT_UNKNOWN;
+
+	case COMPRESSION_TYPE::BC3:
+		switch ( _componentFormat ) {
+		case COMPONENT_FORMAT::AUTO:
+		case COMPONENT_FORMAT::UNORM:	return DXGI_FORMAT_BC3_UNORM;
+		case COMPONENT_FORMAT::UNORM_sRGB:	return DXGI_FORMAT_BC3_UNORM_SRGB;
+		}
+		return DXGI_FORMAT_UNKNOWN;
+
 	case COMPRESSION_TYPE::BC4:
 		switch ( _componentFormat ) {
 		case COMPONENT_FORMAT::AUTO:
 		case COMPONENT_FORMAT::UNORM:	return DXGI_FORMAT_BC4_UNORM;
 		case COMPONENT_FORMAT::SNORM:	return DXGI_FORMAT_BC4_SNORM;
 		}
+		return DXGI_FORMAT_UNKNOWN;
 
 	case COMPRESSION_TYPE::BC5:
 		switch ( _componentFormat ) {
@@ -695,6 +1206,7 @@ DXGI_FORMAT	ImagesMatrix::CompressionType2DXGIFormat( COMPRESSION_TYPE _compress
 		case COMPONENT_FORMAT::UNORM:	return DXGI_FORMAT_BC5_UNORM;
 		case COMPONENT_FORMAT::SNORM:	return DXGI_FORMAT_BC5_SNORM;
 		}
+		return DXGI_FORMAT_UNKNOWN;
 
 	case COMPRESSION_TYPE::BC6H:
 		switch ( _componentFormat ) {
@@ -702,6 +1214,7 @@ DXGI_FORMAT	ImagesMatrix::CompressionType2DXGIFormat( COMPRESSION_TYPE _compress
 		case COMPONENT_FORMAT::UNORM:	return DXGI_FORMAT_BC6H_UF16;
 		case COMPONENT_FORMAT::SNORM:	return DXGI_FORMAT_BC6H_SF16;
 		}
+		return DXGI_FORMAT_UNKNOWN;
 
 	case COMPRESSION_TYPE::BC7:
 		switch ( _componentFormat ) {
@@ -709,6 +1222,7 @@ DXGI_FORMAT	ImagesMatrix::CompressionType2DXGIFormat( COMPRESSION_TYPE _compress
 		case COMPONENT_FORMAT::UNORM:	return DXGI_FORMAT_BC7_UNORM;
 		case COMPONENT_FORMAT::UNORM_sRGB:	return DXGI_FORMAT_BC7_UNORM_SRGB;
 		}
+		return DXGI_FORMAT_UNKNOWN;
 	}
 
 	return DXGI_FORMAT_UNKNOWN;
@@ -716,19 +1230,19 @@ DXGI_FORMAT	ImagesMatrix::CompressionType2DXGIFormat( COMPRESSION_TYPE _compress
 
 #pragma endregion
 
-void	ImagesMatrix::BuildMips( IMAGE_TYPE _imageType ) {
+void	ImagesMatrix::BuildMips( IMAGE_TYPE _imageType, MIP_FILTER _filter ) {
 	switch ( m_type ) {
 		case ImagesMatrix::TYPE::TEXTURE3D:
 			RELEASE_ASSERT( m_mipsArray.Count() == 1, "Only 1 slice is supported for 3D texture mip building!" );
-			m_mipsArray[0].BuildMips3D( _imageType );
+			m_mipsArray[0].BuildMips3D( _imageType, _filter );
 			break;
 
 		case ImagesMatrix::TYPE::TEXTURE2D:
 		case ImagesMatrix::TYPE::TEXTURECUBE:
-			for ( U32 sliceIndex=0; sliceIndex < m_mipsArray.Count(); sliceIndex++ ) {
-				Mips&	mips = m_mipsArray[sliceIndex];
-				mips.BuildMips2D( _imageType );
-			}
+			// Array slices and cube faces are independent so they're built in parallel
+			ThreadPool::Default().ParallelFor( m_mipsArray.Count(), [&]( U32 _sliceIndex, U32 _threadIndex ) {
+				m_mipsArray[_sliceIndex].BuildMips2D( _imageType, _filter );
+			} );
 			break;
 
 		default:
@@ -805,6 +1319,13 @@ void	ImagesMatrix::Mips::Mip::AllocateRawBuffer( U32 _rowPitch, U32 _slicePitch,
 	}
 }
 
+void	ImagesMatrix::Mips::Mip::MapRawBuffer( U32 _rowPitch, U32 _slicePitch, U8* _view ) {
+	RELEASE_ASSERT( m_rawBuffer == NULL, "Raw buffer already allocated!" );
+	m_rowPitch = _rowPitch;
+	m_slicePitch = _slicePitch;
+	m_rawBuffer = _view;
+}
+
 void	ImagesMatrix::Mips::Mip::ReleasePointers() {
 	for ( U32 i=0; i < m_images.Count(); i++ ) {
 		SAFE_DELETE( m_images[i] );
@@ -845,7 +1366,7 @@ void	ImagesMatrix::NextMipSize( U32& _width, U32& _height ) {
 }
 void	ImagesMatrix::NextMipSize( U32& _width, U32& _height, U32& _depth ) {
 	NextMipSize( _width, _height );
-	_depth = (1+_depth) >> 1;
+	NextMipSize( _depth );	// Not rounded up: DDS files and D3D use the same rule for all the dimensions
 }
 
 // Examples:
@@ -875,194 +1396,349 @@ void	Linear2sRGB( const bfloat4& _source, bfloat4& _target ) {
 	_target.w = _source.w;
 }
 
-void	ImagesMatrix::Mips::BuildMips2D( IMAGE_TYPE _imageType ) {
-	if ( m_mips.Count() == 1 )
-		return;	// No mip to build anyway...
-
-	for ( U32 mipLevelIndex=1; mipLevelIndex < m_mips.Count(); mipLevelIndex++ ) {
-		const Mip&	sourceMip = m_mips[mipLevelIndex-1];
-		RELEASE_ASSERT( sourceMip.Depth() == 1, "Only a depth of 1 is allowed for 2D mips building!" );
-		Mip&		targetMip = m_mips[mipLevelIndex];
-		RELEASE_ASSERT( targetMip.Depth() == 1, "Only a depth of 1 is allowed for 2D mips building!" );
-
-		ImageFile*	sourceMipImage = sourceMip[0];
-		RELEASE_ASSERT( sourceMipImage != NULL, "Unallocated images: can't create mips!" );
-		ImageFile*	targetMipImage = targetMip[0];
-		RELEASE_ASSERT( targetMipImage != NULL, "Unallocated images: can't create mips!" );
+// Decodes colors into the linear space mips are filtered in
+static void	DecodeMipColors( ImagesMatrix::IMAGE_TYPE _imageType, bfloat4* _colors, U32 _count ) {
+	switch ( _imageType ) {
+		case ImagesMatrix::LINEAR:
+			break;
+		case ImagesMatrix::sRGB:
+			for ( U32 i=0; i < _count; i++ )
+				sRGB2Linear( _colors[i], _colors[i] );
+			break;
+		case ImagesMatrix::NORMAL_MAP:
+			for ( U32 i=0; i < _count; i++ ) {
+				bfloat4&	V = _colors[i];
+				V.Set( 2.0f * V.x - 1.0f, 2.0f * V.y - 1.0f, 2.0f * V.z - 1.0f, V.w );
+			}
+			break;
+		default:
+			throw "Not implemented!";
+	}
+}
 
-		BuildMip2D( *sourceMipImage, *targetMipImage, _imageType );
+// Encodes filtered linear colors back into the image's space
+static void	EncodeMipColors( ImagesMatrix::IMAGE_TYPE _imageType, const bfloat4* _source, bfloat4* _target, U32 _count ) {
+	switch ( _imageType ) {
+		case ImagesMatrix::LINEAR:
+			memcpy( _target, _source, _count * sizeof(bfloat4) );
+			break;
+		case ImagesMatrix::sRGB:
+			for ( U32 i=0; i < _count; i++ ) {
+				bfloat4	V( MAX( 0.0f, _source[i].x ), MAX( 0.0f, _source[i].y ), MAX( 0.0f, _source[i].z ), _source[i].w );	// Windowed sincs may overshoot below 0
+				Linear2sRGB( V, _target[i] );
+			}
+			break;
+		case ImagesMatrix::NORMAL_MAP:
+			// Renormalize the averaged vectors (the unnormalized average is kept to filter the next mip)
+			for ( U32 i=0; i < _count; i++ ) {
+				const bfloat4&	V = _source[i];
+				float	length = sqrtf( V.x*V.x + V.y*V.y + V.z*V.z );
+				float	scale = length > 1e-6f ? 0.5f / length : 0.0f;
+				_target[i].Set( scale * V.x + 0.5f, scale * V.y + 0.5f, scale * V.z + 0.5f, V.w );
+			}
+			break;
+		default:
+			throw "Not implemented!";
 	}
 }
 
-void	ImagesMatrix::Mips::BuildMips3D( IMAGE_TYPE _imageType ) {
-	if ( m_mips.Count() == 1 )
-		return;	// No mip to build anyway...
+// Polyphase weights resampling a line of _sourceSize texels into _targetSize texels
+//	Each target texel uses m_tapsCount consecutive source texels starting at m_first[i], texels outside the line are clamped to the border
+//
+class	MipFilterTaps {
+public:
+	U32		m_sourceSize;
+	U32		m_targetSize;
+	U32		m_tapsCount;
+	U32*	m_first;
+	float*	m_weights;		// m_tapsCount weights per target texel
 
-	for ( U32 mipLevelIndex=1; mipLevelIndex < m_mips.Count(); mipLevelIndex++ ) {
-		const Mip&	sourceMip = m_mips[mipLevelIndex-1];
-		Mip&		targetMip = m_mips[mipLevelIndex];
-		targetMip.BuildMip3D( sourceMip, _imageType );
+public:
+	MipFilterTaps() : m_sourceSize( 0 ), m_targetSize( 0 ), m_tapsCount( 0 ), m_first( NULL ), m_weights( NULL ) {}
+	~MipFilterTaps() {
+		SAFE_DELETE_ARRAY( m_weights );
+		SAFE_DELETE_ARRAY( m_first );
 	}
-}
 
-void	ImagesMatrix::Mips::BuildMip2D( const ImageFile& _sourceMip, ImageFile& _targetMip, IMAGE_TYPE _imageType ) {
-	U32			W0 = _sourceMip.Width();
-	U32			H0 = _sourceMip.Height();
-	bfloat4*	sourceScanlines = new bfloat4[2*W0];
-
-	U32			W1 = _targetMip.Width();
-	U32			H1 = _targetMip.Height();
-	bfloat4*	targetScanline = new bfloat4[W1];
-
-	bfloat4		two( 2, 2, 2, 1 );
-	bfloat4		one( 1, 1, 1, 0 );
-	bfloat4		eighth( 0.125f, 0.125f, 0.125f, 0 );
-	bfloat4		halff( 0.5f, 0.5f, 0.5f, 0 );
-
-	bfloat4		V00, V01, V10, V11, V0, V1, V;
-
-	for ( U32 Y1=0; Y1 < H1; Y1++ ) {
-		U32	Y00 = Y1 << 1;
-		U32	Y01 = MIN( H0-1, Y00 + 1 );
-		_sourceMip.ReadScanline( Y00, sourceScanlines );
-		_sourceMip.ReadScanline( Y01, sourceScanlines + W0 );
-
-		switch ( _imageType ) {
-			case ImagesMatrix::NORMAL_MAP:
-				// Average as vectors
-				for ( U32 X1=0; X1 < W1; X1++ ) {
-					U32	X00 = X1 << 1;
-					U32	X01 = MIN( W0-1, X00+1 );
-
-					V00 = two * sourceScanlines[X00] - one;
-					V10 = two * sourceScanlines[X01] - one;
-					V01 = two * sourceScanlines[W0+X00] - one;
-					V11 = two * sourceScanlines[W0+X01] - one;
-					V = eighth * (V00 + V10 + V01 + V11) + halff;
-					targetScanline[X1] = V;
+	void	Init( U32 _sourceSize, U32 _targetSize, ImagesMatrix::MIP_FILTER _filter ) {
+		m_sourceSize = _sourceSize;
+		m_targetSize = _targetSize;
+
+		// The kernels are expressed in target texels and stretched to the source texels covered by a target texel
+		float	scale = float(_sourceSize) / _targetSize;
+		float	radius = (_filter == ImagesMatrix::MIP_FILTER::BOX ? 0.5f : 3.0f) * scale;
+		if ( _sourceSize == _targetSize )
+			radius = 0.0f;	// Plain copy whatever the filter (e.g. the height of a 2D texture reaching 1 before its width)
+
+		m_tapsCount = radius > 0.0f ? MIN( _sourceSize, U32( ceilf( 2.0f * radius ) ) + 2 ) : 1;
+		m_first = new U32[_targetSize];
+		m_weights = new float[_targetSize * m_tapsCount];
+		memset( m_weights, 0, _targetSize * m_tapsCount * sizeof(float) );
+
+		for ( U32 i=0; i < _targetSize; i++ ) {
+			float	center = (i + 0.5f) * scale;
+			int		start = int( floorf( center - radius ) );
+			int		end = int( ceilf( center + radius ) );
+			m_first[i] = U32( CLAMP( start, 0, int(_sourceSize - m_tapsCount) ) );
+
+			float*	weights = m_weights + i * m_tapsCount;
+			float	sumWeights = 0.0f;
+			for ( int j=start; j <= end; j++ ) {
+				float	weight;
+				if ( radius == 0.0f ) {
+					weight = j == int(i) ? 1.0f : 0.0f;
+				} else if ( _filter == ImagesMatrix::MIP_FILTER::BOX ) {
+					// Exact coverage of the source texel by the target texel's footprint (correct for odd sizes as well)
+					weight = MAX( 0.0f, MIN( j + 1.0f, center + radius ) - MAX( float(j), center - radius ) );
+				} else {
+					weight = Kernel( _filter, (j + 0.5f - center) / scale );
 				}
-				break;
+				if ( weight == 0.0f )
+					continue;
 
-			case ImagesMatrix::sRGB:
-				// Average as sRGB-encoded colors
-				for ( U32 X1=0; X1 < W1; X1++ ) {
-					U32	X00 = X1 << 1;
-					U32	X01 = MIN( W0-1, X00+1 );
-
-					sRGB2Linear( sourceScanlines[X00], V00 );
-					sRGB2Linear( sourceScanlines[X01], V10 );
-					sRGB2Linear( sourceScanlines[W0+X00], V01 );
-					sRGB2Linear( sourceScanlines[W0+X01], V11 );
-					V = 0.25f * (V00 + V10 + V01 + V11);
-					Linear2sRGB( V, targetScanline[X1] );
-				}
-				break;
+				U32	clampedIndex = U32( CLAMP( j, 0, int(_sourceSize)-1 ) );
+				weights[clampedIndex - m_first[i]] += weight;
+				sumWeights += weight;
+			}
 
-			case ImagesMatrix::LINEAR:
-				// Average as regular linear values
-				for ( U32 X1=0; X1 < W1; X1++ ) {
-					U32	X00 = X1 << 1;
-					U32	X01 = MIN( W0-1, X00+1 );
-
-					V00 = sourceScanlines[X00];
-					V10 = sourceScanlines[X01];
-					V01 = sourceScanlines[W0+X00];
-					V11 = sourceScanlines[W0+X01];
-					V = 0.25f * (V00 + V10 + V01 + V11);
-					targetScanline[X1] = V;
-				}
-				break;
+			float	normalizer = sumWeights != 0.0f ? 1.0f / sumWeights : 0.0f;
+			for ( U32 tapIndex=0; tapIndex < m_tapsCount; tapIndex++ )
+				weights[tapIndex] *= normalizer;
+		}
+	}
+
+	// Resamples _linesCount interleaved lines, the texels of a line are _stride colors apart and consecutive lines are 1 color apart
+	void	Resample( const bfloat4* _source, bfloat4* _target, U32 _stride, U32 _linesCount ) const {
+		for ( U32 i=0; i < m_targetSize; i++ ) {
+			const float*	weights = m_weights + i * m_tapsCount;
+			const bfloat4*	source = _source + m_first[i] * _stride;
+			bfloat4*		target = _target + i * _stride;
+			for ( U32 line=0; line < _linesCount; line++ )
+				target[line] = bfloat4::Zero;
+			for ( U32 tapIndex=0; tapIndex < m_tapsCount; tapIndex++ ) {
+				float	weight = weights[tapIndex];
+				if ( weight == 0.0f )
+					continue;
+				const bfloat4*	sourceLine = source + tapIndex * _stride;
+				for ( U32 line=0; line < _linesCount; line++ )
+					target[line] += weight * sourceLine[line];
+			}
+		}
+	}
 
+private:
+	static float	Sinc( float _x ) {
+		if ( fabs( _x ) < 1e-6f )
+			return 1.0f;
+		_x *= PI;
+		return sinf( _x ) / _x;
+	}
+	static float	BesselI0( float _x ) {
+		float	sum = 1.0f, term = 1.0f, halfX = 0.5f * _x;
+		for ( int k=1; k < 16; k++ ) {
+			term *= halfX / k;
+			sum += term * term;
+		}
+		return sum;
+	}
+	static float	Kernel( ImagesMatrix::MIP_FILTER _filter, float _x ) {
+		const float	R = 3.0f;
+		if ( fabs( _x ) >= R )
+			return 0.0f;
+
+		switch ( _filter ) {
+			case ImagesMatrix::MIP_FILTER::KAISER: {
+				const float	alpha = 4.0f;
+				float	t = _x / R;
+				return Sinc( _x ) * BesselI0( alpha * sqrtf( 1.0f - t*t ) ) / BesselI0( alpha );
+			}
+			case ImagesMatrix::MIP_FILTER::LANCZOS:
+				return Sinc( _x ) * Sinc( _x / R );
 			default:
 				throw "Not implemented!";
 		}
+	}
+};
 
-		_targetMip.WriteScanline( Y1, targetScanline );
+// Builds a whole mip chain in a single streaming pass over the mip 0
+//	The source is fed one element at a time (a scanline for 2D textures, a slice for 3D textures) and each mip level keeps only
+//	the few resampled elements its filter needs in a ring buffer. As soon as a target element is complete, it's written to the
+//	target image and fed to the next level, so the working set of the whole chain stays within the cache and each image is
+//	read once and written once.
+//	All the filtering happens in linear float, colors are decoded/encoded once when reading the mip 0 and writing the levels.
+//
+class	MipCascade {
+	struct	Level {
+		ImagesMatrix::Mips::Mip*	mip;
+		U32				width, height, depth;
+		U32				elementSize;		// Colors per element of this level
+		MipFilterTaps	tapsX, tapsY;		// In-element filters (tapsY is the identity for 2D scanlines)
+		MipFilterTaps	tapsElements;		// Filter across elements
+		bfloat4*		ring;				// tapsElements.m_tapsCount resampled source elements
+		bfloat4*		resampleX;			// Source element resampled horizontally only (3D)
+		bfloat4*		result;
+		U32				nextTargetElement;
+	};
+
+	ImagesMatrix::IMAGE_TYPE	m_imageType;
+	bool			m_is3D;
+	U32				m_levelsCount;
+	Level*			m_levels;
+	bfloat4*		m_encoded;
+
+public:
+	MipCascade( ImagesMatrix::Mips& _mips, bool _is3D, ImagesMatrix::IMAGE_TYPE _imageType, ImagesMatrix::MIP_FILTER _filter )
+		: m_imageType( _imageType )
+		, m_is3D( _is3D )
+		, m_levelsCount( _mips.GetMipLevelsCount() - 1 )
+	{
+		m_levels = new Level[m_levelsCount];
+		U32	maxElementSize = 0;
+		for ( U32 levelIndex=0; levelIndex < m_levelsCount; levelIndex++ ) {
+			const ImagesMatrix::Mips::Mip&	sourceMip = _mips[levelIndex];
+			Level&	level = m_levels[levelIndex];
+			level.mip = &_mips[1+levelIndex];
+			level.width = level.mip->Width();
+			level.height = level.mip->Height();
+			level.depth = level.mip->Depth();
+			for ( U32 sliceIndex=0; sliceIndex < level.depth; sliceIndex++ )
+				RELEASE_ASSERT( (*level.mip)[sliceIndex] != NULL, "Unallocated images: can't create mips!" );
+
+			level.tapsX.Init( sourceMip.Width(), level.width, _filter );
+			if ( m_is3D ) {
+				level.elementSize = level.width * level.height;
+				level.tapsY.Init( sourceMip.Height(), level.height, _filter );
+				level.tapsElements.Init( sourceMip.Depth(), level.depth, _filter );
+				level.resampleX = new bfloat4[level.width * sourceMip.Height()];
+			} else {
+				RELEASE_ASSERT( sourceMip.Depth() == 1 && level.depth == 1, "Only a depth of 1 is allowed for 2D mips building!" );
+				level.elementSize = level.width;
+				level.tapsElements.Init( sourceMip.Height(), level.height, _filter );
+				level.resampleX = NULL;
+			}
+			level.ring = new bfloat4[level.tapsElements.m_tapsCount * level.elementSize];
+			level.result = new bfloat4[level.elementSize];
+			level.nextTargetElement = 0;
+			maxElementSize = MAX( maxElementSize, level.elementSize );
+		}
+		m_encoded = new bfloat4[maxElementSize];
 	}
 
-	SAFE_DELETE_ARRAY( targetScanline );
-	SAFE_DELETE_ARRAY( sourceScanlines );
-}
+	~MipCascade() {
+		for ( U32 levelIndex=0; levelIndex < m_levelsCount; levelIndex++ ) {
+			Level&	level = m_levels[levelIndex];
+			SAFE_DELETE_ARRAY( level.result );
+			SAFE_DELETE_ARRAY( level.resampleX );
+			SAFE_DELETE_ARRAY( level.ring );
+		}
+		SAFE_DELETE_ARRAY( m_levels );
+		SAFE_DELETE_ARRAY( m_encoded );
+	}
 
-void	ImagesMatrix::Mips::Mip::BuildMip3D( const Mip& _sourceMip, IMAGE_TYPE _imageType ) {
-	U32			W0 = _sourceMip.Width();
-	U32			H0 = _sourceMip.Height();
-	U32			D0 = _sourceMip.Depth();
-	bfloat4*	sourceScanlines = new bfloat4[4*W0];
-	bfloat4*	sourceScanlinesZ0 = sourceScanlines;
-	bfloat4*	sourceScanlinesZ1 = sourceScanlines + 2*W0;
-
-	U32			W1 = Width();
-	U32			H1 = Height();
-	U32			D1 = Depth();
-	bfloat4*	targetScanline = new bfloat4[W1];
-
-	bfloat4		V000, V001, V010, V011, V100, V101, V110, V111, V;
-
-	for ( U32 Z1=0; Z1 < D1; Z1++ ) {
-		U32	Z00 = Z1 << 1;
-		U32	Z01 = MIN( D0-1, Z00 + 1 );
-		const ImageFile&	sourceSlice0 = *_sourceMip[Z00];
-		const ImageFile&	sourceSlice1 = *_sourceMip[Z01];
-		ImageFile&			targetSlice = *m_images[Z1];
-
-		for ( U32 Y1=0; Y1 < H1; Y1++ ) {
-			U32	Y00 = Y1 << 1;
-			U32	Y01 = MIN( H0-1, Y00 + 1 );
-
-			sourceSlice0.ReadScanline( Y00, sourceScanlinesZ0 );
-			sourceSlice0.ReadScanline( Y01, sourceScanlinesZ0 + W0 );
-			sourceSlice1.ReadScanline( Y00, sourceScanlinesZ1 );
-			sourceSlice1.ReadScanline( Y01, sourceScanlinesZ1 + W0 );
-
-			switch ( _imageType ) {
-				case ImagesMatrix::sRGB:
-					// Average as sRGB-encoded colors
-					for ( U32 X1=0; X1 < W1; X1++ ) {
-						U32	X00 = X1 << 1;
-						U32	X01 = MIN( W0-1, X00+1 );
-
-						sRGB2Linear( sourceScanlinesZ0[X00], V000 );
-						sRGB2Linear( sourceScanlinesZ0[X01], V100 );
-						sRGB2Linear( sourceScanlinesZ0[W0+X00], V010 );
-						sRGB2Linear( sourceScanlinesZ0[W0+X01], V110 );
-						sRGB2Linear( sourceScanlinesZ1[X00], V001 );
-						sRGB2Linear( sourceScanlinesZ1[X01], V101 );
-						sRGB2Linear( sourceScanlinesZ1[W0+X00], V011 );
-						sRGB2Linear( sourceScanlinesZ1[W0+X01], V111 );
-						V = 0.125f * (V000 + V001 + V010 + V011 + V100 + V101 + V110 + V111);
-						Linear2sRGB( V, targetScanline[X1] );
-					}
-					break;
-				case ImagesMatrix::LINEAR:
-					// Average as regular linear values
-					for ( U32 X1=0; X1 < W1; X1++ ) {
-						U32	X00 = X1 << 1;
-						U32	X01 = MIN( W0-1, X00+1 );
-
-						V000 = sourceScanlinesZ0[X00];
-						V100 = sourceScanlinesZ0[X01];
-						V010 = sourceScanlinesZ0[W0+X00];
-						V110 = sourceScanlinesZ0[W0+X01];
-						V001 = sourceScanlinesZ1[X00];
-						V101 = sourceScanlinesZ1[X01];
-						V011 = sourceScanlinesZ1[W0+X00];
-						V111 = sourceScanlinesZ1[W0+X01];
-
-						V = 0.125f * (V000 + V001 + V010 + V011 + V100 + V101 + V110 + V111);
-						targetScanline[X1] = V;
-					}
+	// Feeds the next element of the mip 0, already decoded into linear space
+	void	Push( U32 _elementIndex, const bfloat4* _element ) {
+		Push( 0, _elementIndex, _element );
+	}
+
+private:
+	void	Push( U32 _levelIndex, U32 _sourceElementIndex, const bfloat4* _sourceElement ) {
+		if ( _levelIndex >= m_levelsCount )
+			return;
+
+		Level&	level = m_levels[_levelIndex];
+		U32		ringSize = level.tapsElements.m_tapsCount;
+		bfloat4*	slot = level.ring + (_sourceElementIndex % ringSize) * level.elementSize;
+		if ( m_is3D ) {
+			// Resample the slice along X for each source row, then along Y for all the target columns at once
+			U32	sourceWidth = level.tapsX.m_sourceSize;
+			U32	sourceHeight = level.tapsY.m_sourceSize;
+			ThreadPool::Default().ParallelForRange( sourceHeight, 16, [&]( U32 _start, U32 _end, U32 _threadIndex ) {
+				for ( U32 Y=_start; Y < _end; Y++ )
+					level.tapsX.Resample( _sourceElement + Y * sourceWidth, level.resampleX + Y * level.width, 1, 1 );
+			} );
+			level.tapsY.Resample( level.resampleX, slot, level.width, level.width );
+		} else {
+			level.tapsX.Resample( _sourceElement, slot, 1, 1 );
+		}
 
-				default:
-					throw "Not implemented!";
+		// Emit all the target elements whose source elements are now available
+		while ( level.nextTargetElement < level.tapsElements.m_targetSize ) {
+			U32	targetElementIndex = level.nextTargetElement;
+			U32	first = level.tapsElements.m_first[targetElementIndex];
+			if ( first + ringSize - 1 > _sourceElementIndex )
+				break;	// Not available yet
+
+			const float*	weights = level.tapsElements.m_weights + targetElementIndex * ringSize;
+			for ( U32 i=0; i < level.elementSize; i++ )
+				level.result[i] = bfloat4::Zero;
+			for ( U32 tapIndex=0; tapIndex < ringSize; tapIndex++ ) {
+				float	weight = weights[tapIndex];
+				if ( weight == 0.0f )
+					continue;
+				const bfloat4*	element = level.ring + ((first + tapIndex) % ringSize) * level.elementSize;
+				for ( U32 i=0; i < level.elementSize; i++ )
+					level.result[i] += weight * element[i];
 			}
 
-			targetSlice.WriteScanline( Y1, targetScanline );
+			Write( level, targetElementIndex );
+			level.nextTargetElement++;
+
+			Push( _levelIndex+1, targetElementIndex, level.result );
+		}
+	}
+
+	void	Write( Level& _level, U32 _targetElementIndex ) {
+		EncodeMipColors( m_imageType, _level.result, m_encoded, _level.elementSize );
+		if ( m_is3D ) {
+			ImageFile&	slice = *(*_level.mip)[_targetElementIndex];
+			for ( U32 Y=0; Y < _level.height; Y++ )
+				slice.WriteScanline( Y, m_encoded + Y * _level.width );
+		} else {
+			(*_level.mip)[0]->WriteScanline( _targetElementIndex, m_encoded );
 		}
 	}
+};
+
+void	ImagesMatrix::Mips::BuildMips2D( IMAGE_TYPE _imageType, MIP_FILTER _filter ) {
+	if ( m_mips.Count() == 1 )
+		return;	// No mip to build anyway...
+
+	const Mip&	sourceMip = m_mips[0];
+	RELEASE_ASSERT( sourceMip.Depth() == 1, "Only a depth of 1 is allowed for 2D mips building!" );
+	const ImageFile*	sourceImage = sourceMip[0];
+	RELEASE_ASSERT( sourceImage != NULL, "Unallocated images: can't create mips!" );
+
+	MipCascade	cascade( *this, false, _imageType, _filter );
+
+	U32			W = sourceMip.Width();
+	bfloat4*	scanline = new bfloat4[W];
+	for ( U32 Y=0; Y < sourceMip.Height(); Y++ ) {
+		sourceImage->ReadScanline( Y, scanline );
+		DecodeMipColors( _imageType, scanline, W );
+		cascade.Push( Y, scanline );
+	}
+	SAFE_DELETE_ARRAY( scanline );
+}
 
-	SAFE_DELETE_ARRAY( targetScanline );
-	SAFE_DELETE_ARRAY( sourceScanlines );
+void	ImagesMatrix::Mips::BuildMips3D( IMAGE_TYPE _imageType, MIP_FILTER _filter ) {
+	if ( m_mips.Count() == 1 )
+		return;	// No mip to build anyway...
+
+	const Mip&	sourceMip = m_mips[0];
+	MipCascade	cascade( *this, true, _imageType, _filter );
+
+	U32			W = sourceMip.Width();
+	U32			H = sourceMip.Height();
+	bfloat4*	slice = new bfloat4[W*H];
+	for ( U32 Z=0; Z < sourceMip.Depth(); Z++ ) {
+		const ImageFile*	sourceImage = sourceMip[Z];
+		RELEASE_ASSERT( sourceImage != NULL, "Unallocated images: can't create mips!" );
+		for ( U32 Y=0; Y < H; Y++ )
+			sourceImage->ReadScanline( Y, slice + Y * W );
+		DecodeMipColors( _imageType, slice, W*H );
+		cascade.Push( Z, slice );
+	}
+	SAFE_DELETE_ARRAY( slice );
 }
 
 /*
@@ -6,6 +6,7 @@
 #pragma once
 
 #include "ImageFile.h"
+#include "BlockCompression.h"
 
 namespace ImageUtilityLib {
 
@@ -22,6 +23,13 @@ namespace ImageUtilityLib {
 			NORMAL_MAP,	// 0.5-offseted vectors
 		};
 
+		// Filter used for mips generation
+		enum class MIP_FILTER {
+			BOX,		// Default, averages the texels covered by the target texel (weighted by coverage for odd sizes)
+			KAISER,		// Kaiser-windowed sinc (3 texels radius, alpha=4), sharper than the box
+			LANCZOS,	// Lanczos-3 windowed sinc, sharpest but may ring on strong edges
+		};
+
 		// The Mips class contains a collection of "Mip" elements, as many mips as necessary to represent a texture
 		//
 		class	Mips {
@@ -65,14 +73,12 @@ namespace ImageUtilityLib {
 				// Allocates/Releases actual ImageFiles and Raw buffer
 				void			AllocateImageFiles( PIXEL_FORMAT _format, const ColorProfile& _colorProfile );
 				void			AllocateRawBuffer( U32 _rowPitch, U32 _slicePitch, const U8* _sourceBuffer=NULL );
+				void			MapRawBuffer( U32 _rowPitch, U32 _slicePitch, U8* _view );	// Points the raw buffer to memory the mip doesn't own (e.g. a mapped file). Use ClearPointers() to forget it, NOT ReleasePointers()!
 				void			ReleasePointers();	// Release image and raw buffer pointers
 				void			ClearPointers();	// Clears pointers but don't release
 
 				void			MakeSigned();
 				void			MakeUnSigned();
-
-				// Build the mips from mip 0
-				void			BuildMip3D( const Mip& _sourceMip, IMAGE_TYPE _imageType );
 			};
 
 		private:
@@ -100,9 +106,9 @@ namespace ImageUtilityLib {
 			void			MakeUnSigned();
 
 			// Build the mips from mip 0
-			void			BuildMips2D( IMAGE_TYPE _imageType );
-			void			BuildMips3D( IMAGE_TYPE _imageType );
-			static void		BuildMip2D( const ImageFile& _sourceMip, ImageFile& _targetMip, IMAGE_TYPE _imageType );
+			//	The whole chain is built in a single pass over mip 0, filtering in linear float
+			void			BuildMips2D( IMAGE_TYPE _imageType, MIP_FILTER _filter=MIP_FILTER::BOX );
+			void			BuildMips3D( IMAGE_TYPE _imageType, MIP_FILTER _filter=MIP_FILTER::BOX );
 		};
 
 		// The type of texture the matrix is a container for
@@ -123,12 +129,53 @@ namespace ImageUtilityLib {
 			virtual const U8*	operator()( U32 _arraySliceIndex, U32 _mipLevelIndex, U32& _rowPitch, U32& _slicePitch ) const abstract;
 		};
 
+		// Streaming DDS writer
+		//	The header is written upfront and the mips are then appended one at a time as soon as they are produced, so the complete texture never needs to be held in memory
+		//	Mips must be written in the DDS order:
+		//	 For Texture2DArrays and TextureCubes, all the mips of array slice 0, then all the mips of array slice 1, etc.
+		//	 For Texture3D, mip 0 with all its slices, then mip 1, etc.
+		//
+		class	DDSStreamWriter {
+			HANDLE			m_file;
+			wchar_t*		m_fileName;			// Used to delete the file if it's left incomplete
+			DXGI_FORMAT		m_DXFormat;
+			bool			m_isVolume;
+			U32				m_width;
+			U32				m_height;
+			U32				m_depth;
+			U32				m_arraySize;
+			U32				m_mipLevelsCount;
+			U32				m_writtenMipsCount;
+			U8*				m_scratchSlice;		// Used to repack slices whose pitch differs from the DDS pitch
+
+		public:
+							DDSStreamWriter( const wchar_t* _fileName, TYPE _type, PIXEL_FORMAT _format, COMPONENT_FORMAT _componentFormat, U32 _width, U32 _height, U32 _depthOrArraySize, U32 _mipLevelsCount );
+							~DDSStreamWriter();
+
+			// Appends the next mip, either from its images or from its raw buffer
+			void			WriteMip( const Mips::Mip& _mip );
+
+			// Appends the next mip from a raw buffer containing all its slices
+			void			WriteMip( const U8* _rawBuffer, U32 _rowPitch, U32 _slicePitch );
+
+			// Closes the file, throws if some mips are missing
+			//	The incomplete file is deleted, as it is if the writer gets destroyed before all the mips were written (e.g. a WriteMip() threw)
+			void			Close();
+
+		private:
+			void			Write( const void* _data, U32 _size );
+			void			Abort();	// Closes and deletes the incomplete file
+		};
+
 	private:
 
+		struct	MappedFile;
+
 		TYPE				m_type;				// Optional field describing the type of images stored in the matrix
 		PIXEL_FORMAT		m_format;			// Pixel format of the images in the matrix
 		ColorProfile		m_colorProfile;		// Color profile of the images in the matrix
 		List< Mips >		m_mipsArray;		// An array of mip-mapped images
+		MappedFile*			m_mappedFile;		// The DDS file the raw buffers are pointing into if the matrix was mapped using DDSMapFile()
 
 	public:
 
@@ -138,6 +185,7 @@ namespace ImageUtilityLib {
 		const ColorProfile&		GetColorProfile() const			{ return m_colorProfile; }
 		ColorProfile&			GetColorProfile()				{ return m_colorProfile; }
 		U32						GetArraySize() const			{ return m_mipsArray.Count(); }
+		bool					IsMapped() const				{ return m_mappedFile != NULL; }
 
 		// Indexers
 		Mips&					operator[]( U32 _index )		{ return m_mipsArray[_index]; }
@@ -178,22 +226,33 @@ namespace ImageUtilityLib {
 		void			DDSSaveFile( const wchar_t* _fileName, COMPONENT_FORMAT _componentFormat=COMPONENT_FORMAT::AUTO ) const;
 		void			DDSSaveMemory( U64& _fileSize, void*& _fileContent, COMPONENT_FORMAT _componentFormat=COMPONENT_FORMAT::AUTO ) const;	// NOTE: The caller MUST delete[] the returned buffer!
 
+		// Maps a DDS file in memory and makes the mips' raw buffers point directly into it: nothing is copied nor converted, even for uncompressed formats
+		//	 The resulting format is always flagged as RAW_BUFFER and the raw buffers are read-only
+		//	 The file stays mapped until ReleasePointers() is called or the matrix is destroyed
+		// NOTE: Only DX10 headers and the legacy formats that don't need any conversion are supported, throws otherwise
+		void			DDSMapFile( const wchar_t* _fileName, COMPONENT_FORMAT& _componentFormat );
+
 		// DDS-Compression
 		enum class COMPRESSION_TYPE {
 			BC4,
 			BC5,
 			BC6H,
 			BC7,
+			BC1,
+			BC3,
 		};
-		void			DDSCompress( const ImagesMatrix& _source, COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat=COMPONENT_FORMAT::AUTO, void* _blindPointerDevice=NULL );	// NOTE: Pass a valid D3D device to enable GPU compression
+		// NOTE: Pass a valid D3D device to enable GPU compression
+		// Without a device, BC1, BC3, BC4, BC5 and BC7 UNORM formats are encoded by the multithreaded BlockCompressor with the requested quality, the other formats fall back to DirectXTex
+		void			DDSCompress( const ImagesMatrix& _source, COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat=COMPONENT_FORMAT::AUTO, void* _blindPointerDevice=NULL, BlockCompressor::QUALITY _quality=BlockCompressor::QUALITY::NORMAL );
 
 		static DXGI_FORMAT	CompressionType2DXGIFormat( COMPRESSION_TYPE _compressionType, COMPONENT_FORMAT _componentFormat );
 
 		//////////////////////////////////////////////////////////////////////////
 		// Mips Building methods
-		void			BuildMips( IMAGE_TYPE _imageType );
+		//	Array slices and cube faces are processed in parallel
+		void			BuildMips( IMAGE_TYPE _imageType, MIP_FILTER _filter=MIP_FILTER::BOX );
 
-		// Computes the next mip size
+		// Computes the next mip size, using the D3D rule for every dimension: size = MAX( 1, size >> 1 )
 		static void		NextMipSize( U32& _size );
 		static void		NextMipSize( U32& _width, U32& _height );
 		static void		NextMipSize( U32& _width, U32& _height, U32& _depth );
@@ -202,6 +261,7 @@ namespace ImageUtilityLib {
 	private:
 
 		void			DDSLoad( const void* _blindPointerImage, const void* _blindPointerMetaData, COMPONENT_FORMAT& _componentFormat );
-		void			DDSSave( void** _blindPointerImage, COMPONENT_FORMAT _componentFormat ) const;
+		void			DDSLoadLayout( const void* _blindPointerLayout, const U8* _fileContent, bool _mapView, COMPONENT_FORMAT& _componentFormat );
+		void			DDSDescribeLayout( void* _blindPointerLayout, COMPONENT_FORMAT _componentFormat ) const;
 	};
 }
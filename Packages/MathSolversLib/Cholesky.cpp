@@ -0,0 +1,62 @@
+#include "stdafx.h"
+#include "Cholesky.h"
+
+using namespace MathSolversLib;
+
+void	Cholesky::Init( U32 _size ) {
+	M.Init( _size, _size );
+}
+
+void	Cholesky::Decompose() {
+	if ( M.rows != M.columns )
+		throw "Matrix M must be square!";
+
+	const double	EPSILON = 1e-12;	// Relative pivot threshold
+
+	U32	n = M.rows;
+
+	// Cholesky-Crout: L is computed row by row so the dot products always run along contiguous rows
+	//	Element (i,j) of M is only read once to compute element (i,j) of L, so L can overwrite M as it goes
+	for ( U32 i=0; i < n; i++ ) {
+		double*	Li = M[i].m;
+		double	diagonal = Li[i];
+		for ( U32 j=0; j <= i; j++ ) {
+			const double*	Lj = M[j].m;
+			double	sum = Li[j];
+			for ( U32 k=0; k < j; k++ )
+				sum -= Li[k] * Lj[k];
+
+			if ( j < i ) {
+				Li[j] = Lj[j] != 0.0 ? sum / Lj[j] : 0.0;
+			} else {
+				Li[i] = sum > EPSILON * fabs( diagonal ) ? sqrt( sum ) : 0.0;
+			}
+		}
+	}
+}
+
+void	Cholesky::Solve( const VectorD& b, VectorD& x ) const {
+	const MatrixD&	L = M;
+	U32	n = L.rows;
+	if ( b.length != n )
+		throw "Vector b length and matrix M's rows count mismatch!";
+
+	x.Init( n );
+
+	// 1) Forward substitution L.y = b (y is stored in x)
+	for ( U32 i=0; i < n; i++ ) {
+		const double*	Li = L[i].m;
+		double	sum = b[i];
+		for ( U32 k=0; k < i; k++ )
+			sum -= Li[k] * x[k];
+		x[i] = Li[i] != 0.0 ? sum / Li[i] : 0.0;
+	}
+
+	// 2) Backward substitution L^T.x = y
+	for ( int i=int(n)-1; i >= 0; i-- ) {
+		double	sum = x[i];
+		for ( U32 k=i+1; k < n; k++ )
+			sum -= L[k][i] * x[k];
+		x[i] = L[i][i] != 0.0 ? sum / L[i][i] : 0.0;
+	}
+}
@@ -0,0 +1,47 @@
+//////////////////////////////////////////////////////////////////////////
+// Implementation of the Cholesky decomposition of a symmetric positive definite matrix
+// It's typically used to solve the normal equations A^T.A.x = A^T.b of a least-squares problem whose structure is known,
+//	which is much cheaper than a SVD of the entire A matrix when A^T.A can be assembled directly
+//
+// The Cholesky decomposition factors a matrix M into a product of a lower triangular matrix L and its transpose:
+//	M = L.L^T
+//
+// USAGE:
+//	Cholesky	cholesky( N );
+//	... fill cholesky.M (only the lower triangle is used) ...
+//	cholesky.Decompose();
+//	cholesky.Solve( b, x );
+//
+// The decomposition is computed in place so only a single N x N matrix is ever allocated
+//
+#pragma once
+
+#include "Matrix.h"
+
+namespace MathSolversLib {
+
+	class Cholesky {
+	public:		// FIELDS
+
+		MatrixD		M;	// The symmetric matrix to decompose (only the lower triangle is read), its lower triangle is replaced by the factor L by Decompose()
+
+	public:		// METHODS
+
+		Cholesky() {}
+		Cholesky( U32 _size ) {
+			Init( _size );
+		}
+
+		void	Init( U32 _size );
+
+		// Computes L such as M = L.L^T and stores it into the lower triangle of M (the upper triangle is left untouched)
+		//	Pivots that are negligible compared to their diagonal element are considered as 0 so a semi-definite M doesn't fail,
+		//	the corresponding unknowns are then solved to 0 (akin to the SVD ignoring null singular values)
+		void	Decompose();
+
+		// Solves M.x = b
+		// NOTE: Decompose must have been called first so M holds the L factor!
+		void	Solve( const VectorD& b, VectorD& x ) const;
+	};
+
+}	// namespace MathSolvers
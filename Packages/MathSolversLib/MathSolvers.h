@@ -3,5 +3,6 @@
 #pragma once
 
 #include "Matrix.h"
+#include "Cholesky.h"
 #include "MinimizeBFGS.h"
 #include "SVD.h"
@@ -0,0 +1,64 @@
+// TestBaseLib.cpp : Defines the entry point for the console application.
+//
+// Usage: TestBaseLib [-bench] [TestName ...]
+//	-bench also runs the (slow) benchmarks
+//	Only the named tests are run if any name is provided, all of them otherwise
+//
+// Returns the amount of failed tests
+//
+#include "stdafx.h"
+
+struct	TestDesc {
+	const char*	name;
+	bool		(*pTest)( bool _runBenchmarks );
+};
+
+static const TestDesc	TESTS[] = {
+	{ "Hashtable",	TestHashtable },
+	{ "List",		TestList },
+	{ "Random",		TestRandom },
+	{ "Sampling",	TestSampling },
+	{ "SH",			TestSH },
+	{ "ThreadPool",	TestThreadPool },
+};
+static const int	TESTS_COUNT = sizeof(TESTS) / sizeof(TestDesc);
+
+static bool	IsSelected( const char* _name, int _argc, char* _argv[] ) {
+	bool	hasNames = false;
+	for ( int argIndex=1; argIndex < _argc; argIndex++ ) {
+		if ( _argv[argIndex][0] == '-' )
+			continue;
+		hasNames = true;
+		if ( !_stricmp( _argv[argIndex], _name ) )
+			return true;
+	}
+	return !hasNames;
+}
+
+int main( int _argc, char* _argv[] ) {
+	bool	runBenchmarks = false;
+	for ( int argIndex=1; argIndex < _argc; argIndex++ )
+		if ( !_stricmp( _argv[argIndex], "-bench" ) )
+			runBenchmarks = true;
+
+	int	failedCount = 0;
+	for ( int testIndex=0; testIndex < TESTS_COUNT; testIndex++ ) {
+		const TestDesc&	test = TESTS[testIndex];
+		if ( !IsSelected( test.name, _argc, _argv ) )
+			continue;
+
+		printf( "%s...\n", test.name );
+		Chrono	chrono;
+		bool	succeeded = (*test.pTest)( runBenchmarks );
+		printf( "%s %s (%.2f s)\n\n", test.name, succeeded ? "PASSED" : "FAILED", chrono.Elapsed() );
+		if ( !succeeded )
+			failedCount++;
+	}
+
+	if ( failedCount > 0 )
+		printf( "%d test(s) FAILED!\n", failedCount );
+	else
+		printf( "All tests PASSED\n" );
+
+	return failedCount;
+}
@@ -0,0 +1,40 @@
+//////////////////////////////////////////////////////////////////////////
+// Native unit tests & benchmarks for BaseLib
+//
+// Each test function prints its results and returns false if a check failed
+// Benchmarks only print their timings, they never fail
+//
+#pragma once
+
+// High resolution timer
+class	Chrono {
+	LARGE_INTEGER	m_frequency;
+	LARGE_INTEGER	m_start;
+
+public:
+	Chrono() {
+		QueryPerformanceFrequency( &m_frequency );
+		Start();
+	}
+
+	void	Start() {
+		QueryPerformanceCounter( &m_start );
+	}
+
+	// Returns the time elapsed since Start() (in seconds)
+	double	Elapsed() const {
+		LARGE_INTEGER	now;
+		QueryPerformanceCounter( &now );
+		return double( now.QuadPart - m_start.QuadPart ) / m_frequency.QuadPart;
+	}
+};
+
+// Reports a failed check and returns false
+#define CHECK( condition, text )	if ( !(condition) ) { printf( "    FAILED: %s (%s, line %d)\n", text, __FILE__, __LINE__ ); return false; }
+
+bool	TestHashtable( bool _runBenchmarks );
+bool	TestList( bool _runBenchmarks );
+bool	TestRandom( bool _runBenchmarks );
+bool	TestSampling( bool _runBenchmarks );
+bool	TestSH( bool _runBenchmarks );
+bool	TestThreadPool( bool _runBenchmarks );
@@ -0,0 +1,324 @@
+//////////////////////////////////////////////////////////////////////////
+// Tests the Hashtable containers and benchmarks them against the former chained dictionaries
+//
+#include "stdafx.h"
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////
+// The chained dictionaries as they were before the Robin Hood HashMap, kept as a reference for the benchmark
+//	(fixed 2^13 buckets that never grow, one allocated node per entry, new entries are pushed at the head of the chains)
+//
+template<typename T> class	LegacyDictionary {
+	struct	Node {
+		Node*	pNext;
+		U32		key;
+		T		value;
+	};
+
+	U32		m_POT;
+	U32		m_size;
+	Node**	m_ppTable;
+	int		m_EntriesCount;
+
+public:
+	LegacyDictionary( U32 _PowerOfTwoSize=13 ) : m_POT( _PowerOfTwoSize ), m_size( 1U << _PowerOfTwoSize ), m_EntriesCount( 0 ) {
+		m_ppTable = new Node*[m_size];
+		memset( m_ppTable, 0, m_size*sizeof(Node*) );
+	}
+	~LegacyDictionary() {
+		for ( U32 i=0; i < m_size; i++ ) {
+			Node*	pNode = m_ppTable[i];
+			while ( pNode != NULL ) {
+				Node*	pOld = pNode;
+				pNode = pNode->pNext;
+				delete pOld;
+			}
+		}
+		delete[] m_ppTable;
+	}
+
+	T*	Get( U32 _key ) const {
+		Node*	pNode = m_ppTable[Fibonacci32( _key, m_POT )];
+		while ( pNode != NULL ) {
+			if ( pNode->key == _key )
+				return &pNode->value;
+			pNode = pNode->pNext;
+		}
+		return NULL;
+	}
+
+	T&	Add( U32 _key ) {
+		U32		idx = Fibonacci32( _key, m_POT );
+		Node*	pNode = new Node();
+				pNode->key = _key;
+				pNode->pNext = m_ppTable[idx];
+		m_ppTable[idx] = pNode;
+		m_EntriesCount++;
+		return pNode->value;
+	}
+};
+
+template<typename T> class	LegacyDictionaryString {
+	struct	Node {
+		Node*	pNext;
+		BString	key;
+		T		value;
+	};
+
+	U32		m_POT;
+	U32		m_size;
+	Node**	m_ppTable;
+	int		m_EntriesCount;
+
+public:
+	LegacyDictionaryString( U32 _PowerOfTwoSize=13 ) : m_POT( _PowerOfTwoSize ), m_size( 1U << _PowerOfTwoSize ), m_EntriesCount( 0 ) {
+		m_ppTable = new Node*[m_size];
+		memset( m_ppTable, 0, m_size*sizeof(Node*) );
+	}
+	~LegacyDictionaryString() {
+		for ( U32 i=0; i < m_size; i++ ) {
+			Node*	pNode = m_ppTable[i];
+			while ( pNode != NULL ) {
+				Node*	pOld = pNode;
+				pNode = pNode->pNext;
+				delete pOld;
+			}
+		}
+		delete[] m_ppTable;
+	}
+
+	T*	Get( const BString& _key ) const {
+		Node*	pNode = m_ppTable[Fibonacci32( _key.Hash(), m_POT )];
+		while ( pNode != NULL ) {
+			if ( !BString::Compare( _key, pNode->key, HT_MAX_KEYLEN ) )
+				return &pNode->value;
+			pNode = pNode->pNext;
+		}
+		return NULL;
+	}
+
+	T&	Add( const BString& _key ) {
+		U32		idx = Fibonacci32( _key.Hash(), m_POT );
+		Node*	pNode = new Node();
+				pNode->key = _key;
+				pNode->pNext = m_ppTable[idx];
+		m_ppTable[idx] = pNode;
+		m_EntriesCount++;
+		return pNode->value;
+	}
+};
+
+//////////////////////////////////////////////////////////////////////////
+// Correctness
+//
+bool	VisitCount( int _EntryIndex, const BString& _key, int& _Value, void* _pUserData ) {
+	(*((int*) _pUserData))++;
+	return true;
+}
+
+bool	TestDictionaryString() {
+	DictionaryString<int>	dictionary;
+
+	// Several values can share the same key (e.g. several shaders compiled from the same file), the most recent one shadows the others
+	dictionary.Add( "Shader.hlsl", 1 );
+	dictionary.Add( "Shader.hlsl", 2 );
+	dictionary.Add( "Other.hlsl", 3 );
+	CHECK( dictionary.GetEntriesCount() == 3, "Add() must not replace the values of an existing key" );
+	CHECK( dictionary.Get( "Shader.hlsl" ) != NULL && *dictionary.Get( "Shader.hlsl" ) == 2, "Get() must return the most recent value" );
+
+	int	visitsCount = 0;
+	dictionary.ForEach( VisitCount, &visitsCount );
+	CHECK( visitsCount == 3, "ForEach() must visit the shadowed values" );
+
+	dictionary.Remove( "Shader.hlsl" );
+	CHECK( dictionary.Get( "Shader.hlsl" ) != NULL && *dictionary.Get( "Shader.hlsl" ) == 1, "Remove() must reveal the previous value" );
+	dictionary.Remove( BString( "Shader.hlsl" ) );
+	CHECK( dictionary.Get( "Shader.hlsl" ) == NULL, "Remove() must remove the last value" );
+	CHECK( dictionary.GetEntriesCount() == 1, "Wrong entries count after Remove()" );
+	dictionary.Remove( "Unknown.hlsl" );
+	CHECK( dictionary.GetEntriesCount() == 1, "Removing an unknown key must do nothing" );
+
+	dictionary.AddUnique( "Other.hlsl", 4 );
+	CHECK( dictionary.GetEntriesCount() == 1 && *dictionary.Get( "Other.hlsl" ) == 4, "AddUnique() must replace the existing value" );
+
+	// Empty strings are valid keys
+	BString	emptyKey;
+	dictionary.Add( emptyKey, 7 );
+	CHECK( dictionary.Get( emptyKey ) != NULL && *dictionary.Get( "" ) == 7, "Null and empty keys must be equal" );
+
+	dictionary.Clear();
+	CHECK( dictionary.GetEntriesCount() == 0 && dictionary.Get( "Other.hlsl" ) == NULL, "Clear() must remove all the entries" );
+
+	return true;
+}
+
+bool	TestDictionaryU32() {
+	// Random adds & removes compared against a plain array
+	const U32	KEYS_COUNT = 4096;
+	bool*		present = new bool[KEYS_COUNT];
+	U32*		values = new U32[KEYS_COUNT];
+	memset( present, 0, KEYS_COUNT*sizeof(bool) );
+
+	Dictionary<U32>	dictionary;
+	RandomStream	random( 1 );
+	int				expectedCount = 0;
+	bool			succeeded = true;
+	for ( U32 operationIndex=0; operationIndex < 200000 && succeeded; operationIndex++ ) {
+		U32	keyIndex = random.NextU32( KEYS_COUNT );
+		U32	key = keyIndex * 0x9E3779B1U;	// Scatter the keys
+		if ( random.NextU32( 3 ) != 0 ) {
+			U32	value = random.NextU32();
+			dictionary.Add( key, value );
+			if ( !present[keyIndex] )
+				expectedCount++;
+			present[keyIndex] = true;
+			values[keyIndex] = value;
+		} else {
+			dictionary.Remove( key );
+			if ( present[keyIndex] )
+				expectedCount--;
+			present[keyIndex] = false;
+		}
+
+		U32		checkedIndex = random.NextU32( KEYS_COUNT );
+		U32*	pValue = dictionary.Get( checkedIndex * 0x9E3779B1U );
+		succeeded &= present[checkedIndex] ? pValue != NULL && *pValue == values[checkedIndex] : pValue == NULL;
+		succeeded &= dictionary.GetEntriesCount() == expectedCount;
+	}
+
+	delete[] values;
+	delete[] present;
+
+	CHECK( succeeded, "Dictionary<U32> content differs from the expected content" );
+	return true;
+}
+
+bool	TestHashMapStrings() {
+	// Non-trivial keys and values must survive the table growing and the entries being moved by Remove()
+	const U32			KEYS_COUNT = 2000;
+	HashMap< BString, BString >	map;
+	for ( U32 i=0; i < KEYS_COUNT; i++ )
+		map.Add( BString( true, "Key%04d", i ) ) = BString( true, "Value%04d", i );
+	CHECK( map.GetEntriesCount() == KEYS_COUNT, "Wrong entries count" );
+
+	for ( U32 i=0; i < KEYS_COUNT; i+=2 )
+		CHECK( map.Remove( BString( true, "Key%04d", i ) ), "Failed to remove an existing key" );
+	CHECK( map.GetEntriesCount() == KEYS_COUNT/2, "Wrong entries count after removal" );
+
+	for ( U32 i=0; i < KEYS_COUNT; i++ ) {
+		BString		key( true, "Key%04d", i );
+		BString*	pValue = map.Get( key );
+		if ( (i & 1) == 0 ) {
+			CHECK( pValue == NULL, "Removed key is still present" );
+		} else {
+			CHECK( pValue != NULL && *pValue == BString( true, "Value%04d", i ), "Wrong value" );
+		}
+	}
+
+	map.Clear();
+	CHECK( map.GetEntriesCount() == 0, "Clear() must remove all the entries" );
+
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmarks
+//
+volatile U32	gs_sink;
+
+U32	ScatterKey( U32 _index ) {
+	// MurmurHash3 finalizer, bijective so all the keys are different
+	_index ^= _index >> 16;
+	_index *= 0x85EBCA6BU;
+	_index ^= _index >> 13;
+	_index *= 0xC2B2AE35U;
+	_index ^= _index >> 16;
+	return _index;
+}
+
+// Measures the add, hit and miss costs in nanoseconds per operation
+//	_keys must contain 2*_entriesCount keys, the second half is used for misses
+//	Small tables are filled several times to get stable timings, the best time is kept
+template<typename D, typename K> void	Benchmark( const K* _keys, U32 _entriesCount, U32 _lookupsCount, double& _add, double& _hit, double& _miss ) {
+	U32	repeatsCount = MAX( 1U, 1000000U / _entriesCount );
+	_add = 1e30;
+	for ( U32 repeatIndex=0; repeatIndex < repeatsCount; repeatIndex++ ) {
+		D		dictionary;
+		Chrono	chrono;
+		for ( U32 i=0; i < _entriesCount; i++ )
+			dictionary.Add( _keys[i] ) = i;
+		_add = MIN( _add, 1e9 * chrono.Elapsed() / _entriesCount );
+	}
+
+	D	dictionary;
+	for ( U32 i=0; i < _entriesCount; i++ )
+		dictionary.Add( _keys[i] ) = i;
+
+	RandomStream	random( _entriesCount );
+	U32				sum = 0;
+	Chrono			chrono;
+	for ( U32 i=0; i < _lookupsCount; i++ )
+		sum += *dictionary.Get( _keys[random.NextU32( _entriesCount )] );
+	_hit = 1e9 * chrono.Elapsed() / _lookupsCount;
+
+	chrono.Start();
+	for ( U32 i=0; i < _lookupsCount; i++ )
+		sum += dictionary.Get( _keys[_entriesCount + random.NextU32( _entriesCount )] ) != NULL;
+	_miss = 1e9 * chrono.Elapsed() / _lookupsCount;
+
+	gs_sink = sum;	// So the lookups aren't optimized away
+}
+
+template<typename D, typename LegacyD, typename K> void	BenchmarkSizes( const K* _keys, U32 _maxEntriesCount ) {
+	printf( "       Entries | Legacy (ns/op)  add     hit    miss | HashMap (ns/op) add     hit    miss | Speed-up  add   hit\n" );
+	for ( U32 entriesCount=1000; entriesCount <= _maxEntriesCount; entriesCount*=10 ) {
+		// The legacy tables have 2^13 chains that never grow so their lookups become linear past 8K entries: use less lookups for large sizes
+		double	legacyAdd, legacyHit, legacyMiss;
+		Benchmark< LegacyD >( _keys, entriesCount, MAX( 10000U, MIN( 1000000U, 1000000000U / entriesCount ) ), legacyAdd, legacyHit, legacyMiss );
+
+		double	add, hit, miss;
+		Benchmark< D >( _keys, entriesCount, 1000000U, add, hit, miss );
+
+		printf( "  %12d |          %7.1f %7.1f %7.1f |          %7.1f %7.1f %7.1f |       x%4.1f x%.1f\n", entriesCount, legacyAdd, legacyHit, legacyMiss, add, hit, miss, legacyAdd / add, legacyHit / hit );
+	}
+}
+
+void	BenchmarkDictionaries() {
+	const U32	MAX_U32_COUNT = 10000000;
+	U32*		keysU32 = new U32[2*MAX_U32_COUNT];
+	for ( U32 i=0; i < 2*MAX_U32_COUNT; i++ )
+		keysU32[i] = ScatterKey( i );
+
+	printf( "  Dictionary<U32> vs. legacy chained Dictionary<U32>\n" );
+	BenchmarkSizes< Dictionary<U32>, LegacyDictionary<U32> >( keysU32, MAX_U32_COUNT );
+	delete[] keysU32;
+
+	const U32	MAX_STRINGS_COUNT = 1000000;
+	BString*	keysString = new BString[2*MAX_STRINGS_COUNT];
+	for ( U32 i=0; i < 2*MAX_STRINGS_COUNT; i++ ) {
+		char	temp[64];
+		sprintf_s( temp, 64, "Shaders/Key%08X.hlsl", ScatterKey( i ) );
+		keysString[i] = temp;
+	}
+
+	printf( "\n  DictionaryString<U32> vs. legacy chained DictionaryString<U32>\n" );
+	BenchmarkSizes< DictionaryString<U32>, LegacyDictionaryString<U32> >( keysString, MAX_STRINGS_COUNT );
+	delete[] keysString;
+}
+
+}	// namespace
+
+bool	TestHashtable( bool _runBenchmarks ) {
+	if ( !TestDictionaryString() )
+		return false;
+	if ( !TestDictionaryU32() )
+		return false;
+	if ( !TestHashMapStrings() )
+		return false;
+
+	if ( _runBenchmarks )
+		BenchmarkDictionaries();
+
+	return true;
+}
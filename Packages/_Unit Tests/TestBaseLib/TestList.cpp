@@ -0,0 +1,236 @@
+//////////////////////////////////////////////////////////////////////////
+// Tests the List container: sorts, inline storage and element relocation
+//
+#include "stdafx.h"
+
+namespace {
+
+//////////////////////////////////////////////////////////////////////////
+// An element that is not trivially movable: it knows its own address and counts the living instances
+//
+struct	Tracked {
+	static int	ms_aliveCount;
+
+	Tracked*	pSelf;
+	U32			value;
+
+	Tracked() : pSelf( this ), value( 0 )										{ ms_aliveCount++; }
+	Tracked( U32 _value ) : pSelf( this ), value( _value )						{ ms_aliveCount++; }
+	Tracked( const Tracked& _other ) : pSelf( this ), value( _other.value )		{ ms_aliveCount++; }
+	Tracked( Tracked&& _other ) : pSelf( this ), value( _other.value )			{ _other.value = ~0U; ms_aliveCount++; }
+	~Tracked()																	{ pSelf = NULL; ms_aliveCount--; }
+
+	Tracked&	operator=( const Tracked& _other )	{ value = _other.value; return *this; }
+	Tracked&	operator=( Tracked&& _other )		{ value = _other.value; _other.value = ~0U; return *this; }
+
+	// An element copied with memcpy would still point to its former address
+	bool		IsValid() const						{ return pSelf == this; }
+};
+int	Tracked::ms_aliveCount = 0;
+
+template< typename LIST >
+bool	CheckTracked( const LIST& _list, const U32* _expected, U32 _count ) {
+	if ( _list.Count() != _count )
+		return false;
+	for ( U32 i=0; i < _count; i++ )
+		if ( !_list[i].IsValid() || _list[i].value != _expected[i] )
+			return false;
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Sorts
+//
+template< typename KEY >
+struct	KeyedElement {
+	KEY		key;
+	U32		index;	// Original index, to check the stability
+};
+
+// Checks the keys are sorted, that equal keys kept their original order and that no element was lost
+template< typename KEY >
+bool	IsStablySorted( const List< KeyedElement<KEY> >& _list ) {
+	U32		count = _list.Count();
+	U8*		found = new U8[count];
+	memset( found, 0, count );
+	bool	sorted = true;
+	for ( U32 i=0; i < count && sorted; i++ ) {
+		const KeyedElement<KEY>&	element = _list[i];
+		sorted = element.index < count && found[element.index]++ == 0;
+		if ( i > 0 && sorted ) {
+			const KeyedElement<KEY>&	previous = _list[i-1];
+			sorted = !(element.key < previous.key) && (previous.key < element.key || previous.index < element.index);
+		}
+	}
+	delete[] found;
+	return sorted;
+}
+
+// Keys with many duplicates, negative values and both signed zeroes
+template< typename KEY >
+void	BuildKeys( U32 _count, RandomStream& _random, List< KeyedElement<KEY> >& _list ) {
+	_list.SetCount( _count );
+	for ( U32 i=0; i < _count; i++ ) {
+		S32	value = S32( _random.NextU32( 41 ) ) - 20;
+		_list[i].key = value != 0 ? KEY( value ) * KEY( 0.25 ) : (_random.NextU32( 2 ) ? KEY( -0.0 ) : KEY( 0.0 ));
+		_list[i].index = i;
+	}
+}
+
+template< typename KEY >
+bool	TestSortByKey( RandomStream& _random ) {
+	// Small lists use the comparison sort, large ones the radix sort
+	const U32	COUNTS[] = { 2, 17, 63, 64, 1000, 100000 };
+	for ( U32 countIndex=0; countIndex < 6; countIndex++ ) {
+		List< KeyedElement<KEY> >	list;
+		BuildKeys( COUNTS[countIndex], _random, list );
+		list.SortByKey( []( const KeyedElement<KEY>& _element ) { return _element.key; } );
+		CHECK( IsStablySorted( list ), "SortByKey() must be a stable sort, -0 and +0 being equal keys" );
+	}
+	return true;
+}
+
+bool	TestSorts() {
+	RandomStream	random( 1 );
+	if ( !TestSortByKey<float>( random ) )
+		return false;
+	if ( !TestSortByKey<double>( random ) )
+		return false;
+
+	// Integer keys
+	List< KeyedElement<S32> >	keys;
+	keys.SetCount( 10000 );
+	for ( U32 i=0; i < keys.Count(); i++ ) {
+		keys[i].key = S32( random.NextU32( 2000 ) ) - 1000;
+		keys[i].index = i;
+	}
+	keys.SortByKey( []( const KeyedElement<S32>& _element ) { return _element.key; } );
+	CHECK( IsStablySorted( keys ), "SortByKey() must be a stable sort for integer keys" );
+
+	// Introsort on random, sorted, reversed, organ pipe and constant sequences
+	const U32	COUNT = 10000;
+	List< U32 >	values;
+	values.SetCount( COUNT );
+	for ( U32 sequenceIndex=0; sequenceIndex < 5; sequenceIndex++ ) {
+		for ( U32 i=0; i < COUNT; i++ ) {
+			switch ( sequenceIndex ) {
+				case 0: values[i] = random.NextU32(); break;
+				case 1: values[i] = i; break;
+				case 2: values[i] = COUNT - i; break;
+				case 3: values[i] = i < COUNT/2 ? i : COUNT - i; break;
+				case 4: values[i] = 7; break;
+			}
+		}
+		values.Sort( []( U32 a, U32 b ) { return a < b; } );
+		for ( U32 i=1; i < COUNT; i++ )
+			CHECK( values[i-1] <= values[i], "Sort() must sort the values" );
+	}
+
+	// Sorting non trivially movable elements
+	List< Tracked >	tracked;
+	for ( U32 i=0; i < 1000; i++ )
+		tracked.Append( Tracked( random.NextU32( 100 ) ) );
+	tracked.SortByKey( []( const Tracked& _element ) { return _element.value; } );
+	for ( U32 i=0; i < tracked.Count(); i++ ) {
+		CHECK( tracked[i].IsValid(), "Sorted elements must be moved, not copied with memcpy" );
+		CHECK( i == 0 || tracked[i-1].value <= tracked[i].value, "SortByKey() must sort the elements" );
+	}
+	tracked.Sort( []( const Tracked& a, const Tracked& b ) { return a.value > b.value; } );
+	for ( U32 i=0; i < tracked.Count(); i++ ) {
+		CHECK( tracked[i].IsValid(), "Sorted elements must be moved, not copied with memcpy" );
+		CHECK( i == 0 || tracked[i-1].value >= tracked[i].value, "Sort() must sort the elements" );
+	}
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Inline storage
+//
+bool	TestInlineStorage() {
+	const U32	COUNT = 20;
+	U32			expected[COUNT];
+	{
+		List< Tracked, 4 >	list;
+		for ( U32 i=0; i < COUNT; i++ ) {
+			// Appending a copy of an element of the list while the list grows
+			if ( i == 4 )
+				list.Append( list[0] );
+			else
+				list.Append( Tracked( 100 + i ) );
+			expected[i] = i == 4 ? 100 : 100 + i;
+			CHECK( CheckTracked( list, expected, i+1 ), "Elements must be moved from the inline storage to the heap" );
+		}
+
+		// Copies and moves of heap lists
+		List< Tracked, 4 >	copy( list );
+		CHECK( CheckTracked( copy, expected, COUNT ), "Copied list mismatch" );
+		List< Tracked, 4 >	moved( std::move( copy ) );
+		CHECK( CheckTracked( moved, expected, COUNT ) && copy.Count() == 0, "Moved list mismatch" );
+
+		// Copies and moves of inline lists
+		List< Tracked, 4 >	small;
+		small.Append( Tracked( 1 ) );
+		small.Append( Tracked( 2 ) );
+		List< Tracked, 4 >	movedSmall( std::move( small ) );
+		const U32	expectedSmall[2] = { 1, 2 };
+		CHECK( CheckTracked( movedSmall, expectedSmall, 2 ) && small.Count() == 0, "Moved inline list mismatch" );
+		moved = movedSmall;
+		CHECK( CheckTracked( moved, expectedSmall, 2 ), "Assigned inline list mismatch" );
+	}
+	CHECK( Tracked::ms_aliveCount == 0, "All the elements must be destroyed" );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Insert/RemoveAt
+//
+bool	TestInsertRemove() {
+	const U32	MAX_COUNT = 64;
+	{
+		RandomStream		random( 2 );
+		List< Tracked, 4 >	list;
+		U32					expected[MAX_COUNT];
+		U32					count = 0;
+		for ( U32 operationIndex=0; operationIndex < 1000; operationIndex++ ) {
+			if ( count > 0 && (count == MAX_COUNT || random.NextU32( 3 ) == 0) ) {
+				U32	index = random.NextU32( count );
+				list.RemoveAt( index );
+				memmove( expected + index, expected + index + 1, (count - index - 1) * sizeof(U32) );
+				count--;
+			} else {
+				U32	index = random.NextU32( count + 1 );
+				list.Insert( index ).value = operationIndex;
+				memmove( expected + index + 1, expected + index, (count - index) * sizeof(U32) );
+				expected[index] = operationIndex;
+				count++;
+			}
+			CHECK( CheckTracked( list, expected, count ), "Insert() and RemoveAt() must keep the other elements in order" );
+		}
+	}
+	CHECK( Tracked::ms_aliveCount == 0, "All the elements must be destroyed" );
+
+	// Trivially copyable elements
+	List< U32 >	values;
+	for ( U32 i=0; i < 10; i++ )
+		values.Append( i );
+	values.Insert( 5 ) = 100;
+	values.RemoveAt( 2 );
+	const U32	EXPECTED[10] = { 0, 1, 3, 4, 100, 5, 6, 7, 8, 9 };
+	CHECK( values.Count() == 10, "Insert() and RemoveAt() must update the count" );
+	for ( U32 i=0; i < 10; i++ )
+		CHECK( values[i] == EXPECTED[i], "Insert() and RemoveAt() must keep the other elements in order" );
+	return true;
+}
+
+}	// namespace
+
+bool	TestList( bool _runBenchmarks ) {
+	if ( !TestSorts() )
+		return false;
+	if ( !TestInlineStorage() )
+		return false;
+	if ( !TestInsertRemove() )
+		return false;
+
+	return true;
+}
@@ -0,0 +1,98 @@
+//////////////////////////////////////////////////////////////////////////
+// Tests the random streams against the former global MWC generator
+//
+#include "stdafx.h"
+
+namespace {
+
+const U32	DRAWS_COUNT = 100000;
+
+//////////////////////////////////////////////////////////////////////////
+// The global MWC generator as it was before it moved to LegacyRandomStream, kept as a reference
+//
+struct	ReferenceMWC {
+	U32	w, z;
+
+	ReferenceMWC( U32 _u, U32 _v ) : w( _u ), z( _v ) {}
+
+	U32		Rand() {
+		z = 36969 * (z & 0xFFFF) + (z >> 16);
+		w = 18000 * (w & 0xFFFF) + (w >> 16);
+		return (z << 16) + w;
+	}
+	U32		Rand( U32 _min, U32 _max )	{ return _min + Rand() % (1+_max-_min); }
+	float	FRand()						{ return Rand() / (4294967295.0f); }
+	float	FRandStrict()				{ return float( (Rand() + 1.0) * 2.328306435454494e-10 ); }
+	float	RandGauss() {
+		float	u1 = FRand();
+		float	u2 = FRand();
+		float	r = sqrtf( -2.0f * logf(u1) );
+		float	theta = 2.0f * PI * u2;
+		return r * sinf(theta);
+	}
+};
+
+bool	TestLegacyStream() {
+	ReferenceMWC		reference( 0x12345678U, 0x9ABCDEF0U );
+	LegacyRandomStream	stream( 0x12345678U, 0x9ABCDEF0U );
+	for ( U32 i=0; i < DRAWS_COUNT; i++ ) {
+		CHECK( stream.NextU32() == reference.Rand(), "LegacyRandomStream::NextU32() must match the former _rand()" );
+		CHECK( stream.NextU32( 10, 1000 ) == reference.Rand( 10, 1000 ), "LegacyRandomStream::NextU32( min, max ) must match the former _rand( min, max )" );
+		CHECK( stream.NextFloat() == reference.FRand(), "LegacyRandomStream::NextFloat() must match the former _frand()" );
+		CHECK( stream.NextFloatStrict() == reference.FRandStrict(), "LegacyRandomStream::NextFloatStrict() must match the former _frandStrict()" );
+		float	gauss = stream.NextGauss();
+		float	referenceGauss = reference.RandGauss();
+		CHECK( gauss == referenceGauss || (gauss != gauss && referenceGauss != referenceGauss), "LegacyRandomStream::NextGauss() must match the former _randGauss()" );
+	}
+	return true;
+}
+
+bool	TestGlobalFunctions() {
+	ReferenceMWC	reference( 0x0BADF00DU, 0xDEADBEEFU );
+	_randpushseed();
+	_srand( 0x0BADF00DU, 0xDEADBEEFU );
+	for ( U32 i=0; i < DRAWS_COUNT; i++ ) {
+		CHECK( _rand() == reference.Rand(), "_rand() must keep its former sequence" );
+		CHECK( _frand() == reference.FRand(), "_frand() must keep its former sequence" );
+	}
+
+	// Popping the seed restores the sequence as it was when pushed
+	_randpopseed();
+	_randpushseed();
+	U32	first = _rand();
+	_randpopseed();
+	CHECK( _rand() == first, "_randpopseed() must restore the pushed sequence" );
+	return true;
+}
+
+// The full [0,2^32[ range wraps the range size to 0, it must still draw the whole range
+bool	TestFullRange() {
+	RandomStream		stream( 1 );
+	LegacyRandomStream	legacyStream;
+	bool	hasHighValue = false, hasLegacyHighValue = false;
+	for ( U32 i=0; i < 64; i++ ) {
+		hasHighValue |= stream.NextU32( 0, 0xFFFFFFFFU ) >= 0x80000000U;
+		hasLegacyHighValue |= legacyStream.NextU32( 0, 0xFFFFFFFFU ) >= 0x80000000U;
+	}
+	CHECK( hasHighValue, "RandomStream::NextU32( 0, 0xFFFFFFFF ) must cover the full range" );
+	CHECK( hasLegacyHighValue, "LegacyRandomStream::NextU32( 0, 0xFFFFFFFF ) must cover the full range" );
+
+	for ( U32 i=0; i < DRAWS_COUNT; i++ ) {
+		U32	value = stream.NextU32( 5, 9 );
+		CHECK( value >= 5 && value <= 9, "RandomStream::NextU32( min, max ) must stay within [min,max]" );
+	}
+	return true;
+}
+
+}	// namespace
+
+bool	TestRandom( bool _runBenchmarks ) {
+	if ( !TestLegacyStream() )
+		return false;
+	if ( !TestGlobalFunctions() )
+		return false;
+	if ( !TestFullRange() )
+		return false;
+
+	return true;
+}
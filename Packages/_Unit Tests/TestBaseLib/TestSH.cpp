@@ -0,0 +1,366 @@
+//////////////////////////////////////////////////////////////////////////
+// Tests the SH evaluation and projection against the analytical coefficients
+// Tests the SH rotation: rotating the projection of a function must give the projection of the rotated function
+// Tests the SH product against the hardcoded order 2 product and its operator/SoA variants against the single vector product
+//
+#include "stdafx.h"
+
+namespace {
+
+const U32	MAX_ORDER = 6;
+const U32	MAX_COEFFS_COUNT = (MAX_ORDER+1) * (MAX_ORDER+1);
+const U32	IMPULSES_COUNT = 16;
+const U32	ROTATIONS_COUNT = 8;
+const float	TOLERANCE = 1e-4f;
+
+// The test function is a sum of weighted impulses, its projection is exact so it can be compared to the rotated coefficients
+//	(if _pRotation is not NULL, the impulse directions are rotated first)
+void	ProjectImpulses( const bfloat3* _directions, const float* _weights, const float3x3* _pRotation, U32 _order, float* _coeffs ) {
+	U32		coeffsCount = (_order+1) * (_order+1);
+	double	Y[MAX_COEFFS_COUNT];
+	double	sums[MAX_COEFFS_COUNT];
+	memset( sums, 0, coeffsCount * sizeof(double) );
+	for ( U32 impulseIndex=0; impulseIndex < IMPULSES_COUNT; impulseIndex++ ) {
+		bfloat3	direction = _pRotation != NULL ? _directions[impulseIndex] * *_pRotation : _directions[impulseIndex];
+		direction.Normalize();
+		SH::BuildSHCoeffs( direction, _order, Y );
+		for ( U32 i=0; i < coeffsCount; i++ )
+			sums[i] += _weights[impulseIndex] * Y[i];
+	}
+	for ( U32 i=0; i < coeffsCount; i++ )
+		_coeffs[i] = float( sums[i] );
+}
+
+float	MaxError( const float* _a, const float* _b, U32 _count ) {
+	float	maxError = 0.0f;
+	for ( U32 i=0; i < _count; i++ )
+		maxError = MAX( maxError, fabsf( _a[i] - _b[i] ) );
+	return maxError;
+}
+
+float3x3	RandomRotation( RandomStream& _random ) {
+	float3x3	rotation;
+	rotation.BuildFromAngleAxis( _random.NextFloat( 0.0f, 2.0f * PI ), _random.NextUnitSphere() );
+	return rotation;
+}
+
+// The recurrences of BuildSHCoeffs() must match the analytical coefficients of ComputeSHCoeff()
+bool	TestBuildSHCoeffs() {
+	const U32	ORDER = 14;
+	const U32	COEFFS_COUNT = (ORDER+1) * (ORDER+1);
+
+	RandomStream	random( 7 );
+	double			coeffs[COEFFS_COUNT];
+	float			floatCoeffs[COEFFS_COUNT];
+	for ( U32 directionIndex=0; directionIndex < 64; directionIndex++ ) {
+		bfloat3	direction = random.NextUnitSphere();
+		direction.Normalize();
+		SH::BuildSHCoeffs( direction, ORDER, coeffs );
+		SH::BuildSHCoeffs( direction, ORDER, floatCoeffs );
+		for ( int l=0; l <= int(ORDER); l++ )
+			for ( int m=-l; m <= l; m++ ) {
+				double	expected = SH::ComputeSHCoeff( l, m, direction );
+				CHECK( fabs( coeffs[l*(l+1)+m] - expected ) < 1e-5, "BuildSHCoeffs() must match ComputeSHCoeff()" );
+				CHECK( fabs( floatCoeffs[l*(l+1)+m] - expected ) < 1e-5, "BuildSHCoeffs() in float must match ComputeSHCoeff()" );
+			}
+	}
+	return true;
+}
+
+// The batched projection must match the sum of the individual coefficients
+bool	TestProject() {
+	const U32	DIRECTIONS_COUNT = 2051;	// More than one batch of 256 groups of 4 directions, with a partial group at the end
+
+	RandomStream	random( 8 );
+	bfloat3*		directions = new bfloat3[DIRECTIONS_COUNT];
+	float*			weights = new float[DIRECTIONS_COUNT];
+	bfloat3*		values = new bfloat3[DIRECTIONS_COUNT];
+	for ( U32 directionIndex=0; directionIndex < DIRECTIONS_COUNT; directionIndex++ ) {
+		directions[directionIndex] = random.NextUnitSphere();
+		directions[directionIndex].Normalize();
+		weights[directionIndex] = random.NextFloat( -1.0f, 1.0f );
+		values[directionIndex].Set( weights[directionIndex], random.NextFloat( -1.0f, 1.0f ), random.NextFloat( -1.0f, 1.0f ) );
+	}
+
+	double	Y[MAX_COEFFS_COUNT];
+	double	expected[3*MAX_COEFFS_COUNT];
+	float	coeffs[MAX_COEFFS_COUNT];
+	bfloat3	coeffs3[MAX_COEFFS_COUNT];
+	float	maxError = 0.0f;
+	float	maxError3 = 0.0f;
+	float	maxImpulseError = 0.0f;
+	for ( U32 order=0; order <= MAX_ORDER; order++ ) {
+		U32	coeffsCount = (order+1) * (order+1);
+		memset( expected, 0, 3 * coeffsCount * sizeof(double) );
+		for ( U32 directionIndex=0; directionIndex < DIRECTIONS_COUNT; directionIndex++ ) {
+			SH::BuildSHCoeffs( directions[directionIndex], order, Y );
+			for ( U32 i=0; i < coeffsCount; i++ ) {
+				expected[3*i+0] += values[directionIndex].x * Y[i];
+				expected[3*i+1] += values[directionIndex].y * Y[i];
+				expected[3*i+2] += values[directionIndex].z * Y[i];
+			}
+		}
+
+		SH::Project( directions, weights, DIRECTIONS_COUNT, order, coeffs );
+		SH::Project( directions, values, DIRECTIONS_COUNT, order, coeffs3 );
+		for ( U32 i=0; i < coeffsCount; i++ ) {
+			maxError = MAX( maxError, float( fabs( coeffs[i] - expected[3*i] ) ) );
+			maxError3 = MAX( maxError3, float( fabs( coeffs3[i].x - expected[3*i+0] ) ) );
+			maxError3 = MAX( maxError3, float( fabs( coeffs3[i].y - expected[3*i+1] ) ) );
+			maxError3 = MAX( maxError3, float( fabs( coeffs3[i].z - expected[3*i+2] ) ) );
+		}
+
+		// A single impulse projects to its coefficients
+		SH::Project( directions, weights, 1, order, coeffs );
+		SH::BuildSHCoeffs( directions[0], order, Y );
+		for ( U32 i=0; i < coeffsCount; i++ )
+			maxImpulseError = MAX( maxImpulseError, float( fabs( coeffs[i] - weights[0] * Y[i] ) ) );
+	}
+
+	delete[] values;
+	delete[] weights;
+	delete[] directions;
+
+	CHECK( maxError < TOLERANCE, "Projection must match the sum of the coefficients" );
+	CHECK( maxError3 < TOLERANCE, "bfloat3 projection must match the sum of the coefficients" );
+	CHECK( maxImpulseError < TOLERANCE, "Projection of a single impulse must match its coefficients" );
+	return true;
+}
+
+// Band 1 basis functions are proportional to (y, z, x) so its matrix is a permutation of the 3x3 rotation
+bool	TestBand1Convention() {
+	static const int	AXES[3] = { 1, 2, 0 };
+
+	RandomStream	random( 1 );
+	SHRotation		rotation( 1 );
+	for ( U32 rotationIndex=0; rotationIndex < ROTATIONS_COUNT; rotationIndex++ ) {
+		float3x3	R = RandomRotation( random );
+		rotation.Build( R );
+		const float*	band1 = rotation.GetBandMatrix( 1 );
+		for ( int i=0; i < 3; i++ )
+			for ( int j=0; j < 3; j++ )
+				CHECK( band1[3*i+j] == (&R.r[AXES[j]].x)[AXES[i]], "Band 1 matrix must be R1[i][j] = r[AXES[j]][AXES[i]]" );
+	}
+	return true;
+}
+
+bool	TestRotationMatchesReprojection() {
+	RandomStream	random( 2 );
+	bfloat3			directions[IMPULSES_COUNT];
+	float			weights[IMPULSES_COUNT];
+	for ( U32 impulseIndex=0; impulseIndex < IMPULSES_COUNT; impulseIndex++ ) {
+		directions[impulseIndex] = random.NextUnitSphere();
+		weights[impulseIndex] = random.NextFloat( -1.0f, 1.0f );
+	}
+
+	for ( U32 order=0; order <= MAX_ORDER; order++ ) {
+		SHRotation	rotation( order );
+		U32			coeffsCount = rotation.GetCoeffsCount();
+
+		float	source[MAX_COEFFS_COUNT];
+		ProjectImpulses( directions, weights, NULL, order, source );
+
+		for ( U32 rotationIndex=0; rotationIndex < ROTATIONS_COUNT; rotationIndex++ ) {
+			float3x3	R = RandomRotation( random );
+			rotation.Build( R );
+
+			float	expected[MAX_COEFFS_COUNT];
+			float	rotated[MAX_COEFFS_COUNT];
+			ProjectImpulses( directions, weights, &R, order, expected );
+			rotation.Rotate( source, rotated );
+			CHECK( MaxError( rotated, expected, coeffsCount ) < TOLERANCE, "Rotating the projection must give the projection of the rotated function" );
+		}
+	}
+	return true;
+}
+
+// The bfloat3 and the batched SSE rotations must match the single vector rotation
+bool	TestRotationVariants() {
+	const U32	VECTORS_COUNT = 11;	// Not a multiple of 4 so the remaining vectors are tested too
+
+	RandomStream	random( 3 );
+	SHRotation		rotation( MAX_ORDER );
+	U32				coeffsCount = rotation.GetCoeffsCount();
+	rotation.Build( RandomRotation( random ) );
+
+	float*	sources = new float[VECTORS_COUNT * coeffsCount];
+	float*	targets = new float[VECTORS_COUNT * coeffsCount];
+	float*	expected = new float[VECTORS_COUNT * coeffsCount];
+	for ( U32 i=0; i < VECTORS_COUNT * coeffsCount; i++ )
+		sources[i] = random.NextFloat( -1.0f, 1.0f );
+	for ( U32 vectorIndex=0; vectorIndex < VECTORS_COUNT; vectorIndex++ )
+		rotation.Rotate( sources + vectorIndex * coeffsCount, expected + vectorIndex * coeffsCount );
+
+	rotation.Rotate( sources, targets, VECTORS_COUNT );
+	float	batchedError = MaxError( targets, expected, VECTORS_COUNT * coeffsCount );
+
+	bfloat3	sources3[MAX_COEFFS_COUNT];
+	bfloat3	targets3[MAX_COEFFS_COUNT];
+	for ( U32 i=0; i < coeffsCount; i++ )
+		sources3[i].Set( sources[i], sources[coeffsCount+i], sources[2*coeffsCount+i] );
+	rotation.Rotate( sources3, targets3 );
+	float	vectorError = 0.0f;
+	for ( U32 i=0; i < coeffsCount; i++ ) {
+		vectorError = MAX( vectorError, fabsf( targets3[i].x - expected[i] ) );
+		vectorError = MAX( vectorError, fabsf( targets3[i].y - expected[coeffsCount+i] ) );
+		vectorError = MAX( vectorError, fabsf( targets3[i].z - expected[2*coeffsCount+i] ) );
+	}
+
+	delete[] expected;
+	delete[] targets;
+	delete[] sources;
+
+	CHECK( batchedError < TOLERANCE, "Batched rotation must match the single vector rotation" );
+	CHECK( vectorError < TOLERANCE, "bfloat3 rotation must match the single vector rotation" );
+	return true;
+}
+
+void	RandomCoeffs( RandomStream& _random, U32 _count, float* _coeffs ) {
+	for ( U32 i=0; i < _count; i++ )
+		_coeffs[i] = _random.NextFloat( -1.0f, 1.0f );
+}
+
+bool	TestProductMatchesProduct3() {
+	RandomStream	random( 4 );
+	SHProduct		product( 2 );
+	for ( U32 testIndex=0; testIndex < 16; testIndex++ ) {
+		float	a[9], b[9], expected[9], c[9];
+		RandomCoeffs( random, 9, a );
+		RandomCoeffs( random, 9, b );
+		SH::Product3( a, b, expected );
+		product.Product( a, b, c );
+		CHECK( MaxError( c, expected, 9 ) < TOLERANCE, "Order 2 product must match Product3()" );
+	}
+	return true;
+}
+
+// The constant function 1 has the single coefficient sqrt(4PI) so multiplying by it must not change the vector, at any order
+bool	TestProductIdentity() {
+	RandomStream	random( 5 );
+	for ( U32 order=0; order <= MAX_ORDER; order++ ) {
+		SHProduct	product( order );
+		U32			coeffsCount = product.GetCoeffsCount();
+
+		float	one[MAX_COEFFS_COUNT], a[MAX_COEFFS_COUNT], c[MAX_COEFFS_COUNT];
+		memset( one, 0, coeffsCount * sizeof(float) );
+		one[0] = sqrtf( 4.0f * PI );
+		RandomCoeffs( random, coeffsCount, a );
+		product.Product( a, one, c );
+		CHECK( MaxError( c, a, coeffsCount ) < TOLERANCE, "Product by the constant function 1 must be the identity" );
+	}
+	return true;
+}
+
+// The bfloat3, operator and SoA products must match the single vector product
+bool	TestProductVariants() {
+	const U32	VECTORS_COUNT = 11;	// Not a multiple of 4 so the remaining vectors are tested too
+	const U32	STRIDE = 12;
+
+	RandomStream	random( 6 );
+	SHProduct		product( MAX_ORDER );
+	U32				coeffsCount = product.GetCoeffsCount();
+
+	float*	a = new float[VECTORS_COUNT * coeffsCount];
+	float*	b = new float[VECTORS_COUNT * coeffsCount];
+	float*	expected = new float[VECTORS_COUNT * coeffsCount];
+	float*	c = new float[VECTORS_COUNT * coeffsCount];
+	RandomCoeffs( random, VECTORS_COUNT * coeffsCount, a );
+	RandomCoeffs( random, VECTORS_COUNT * coeffsCount, b );
+	for ( U32 vectorIndex=0; vectorIndex < VECTORS_COUNT; vectorIndex++ )
+		product.Product( a + vectorIndex * coeffsCount, b + vectorIndex * coeffsCount, expected + vectorIndex * coeffsCount );
+
+	// SoA products
+	float*	aSoA = new float[coeffsCount * STRIDE];
+	float*	bSoA = new float[coeffsCount * STRIDE];
+	float*	cSoA = new float[coeffsCount * STRIDE];
+	for ( U32 vectorIndex=0; vectorIndex < VECTORS_COUNT; vectorIndex++ )
+		for ( U32 i=0; i < coeffsCount; i++ ) {
+			aSoA[i * STRIDE + vectorIndex] = a[vectorIndex * coeffsCount + i];
+			bSoA[i * STRIDE + vectorIndex] = b[vectorIndex * coeffsCount + i];
+		}
+	product.ProductSoA( aSoA, bSoA, cSoA, VECTORS_COUNT, STRIDE );
+	float	SoAError = 0.0f;
+	for ( U32 vectorIndex=0; vectorIndex < VECTORS_COUNT; vectorIndex++ )
+		for ( U32 i=0; i < coeffsCount; i++ )
+			SoAError = MAX( SoAError, fabsf( cSoA[i * STRIDE + vectorIndex] - expected[vectorIndex * coeffsCount + i] ) );
+
+	// Operators built from the first vector of b
+	float*	op = new float[coeffsCount * coeffsCount];
+	product.BuildOperator( b, op );
+	product.ApplyOperator( op, a, c );
+	float	operatorError = MaxError( c, expected, coeffsCount );
+
+	for ( U32 vectorIndex=0; vectorIndex < VECTORS_COUNT; vectorIndex++ )
+		product.Product( a + vectorIndex * coeffsCount, b, c + vectorIndex * coeffsCount );
+	product.ApplyOperatorSoA( op, aSoA, cSoA, VECTORS_COUNT, STRIDE );
+	float	operatorSoAError = 0.0f;
+	for ( U32 vectorIndex=0; vectorIndex < VECTORS_COUNT; vectorIndex++ )
+		for ( U32 i=0; i < coeffsCount; i++ )
+			operatorSoAError = MAX( operatorSoAError, fabsf( cSoA[i * STRIDE + vectorIndex] - c[vectorIndex * coeffsCount + i] ) );
+
+	// bfloat3 products, each channel uses one of the first 3 vectors
+	bfloat3	a3[MAX_COEFFS_COUNT];
+	bfloat3	b3[MAX_COEFFS_COUNT];
+	bfloat3	c3[MAX_COEFFS_COUNT];
+	for ( U32 i=0; i < coeffsCount; i++ ) {
+		a3[i].Set( a[i], a[coeffsCount+i], a[2*coeffsCount+i] );
+		b3[i].Set( b[i], b[coeffsCount+i], b[2*coeffsCount+i] );
+	}
+	product.Product( a3, b3, c3 );
+	float	vectorError = 0.0f;
+	for ( U32 i=0; i < coeffsCount; i++ ) {
+		vectorError = MAX( vectorError, fabsf( c3[i].x - expected[i] ) );
+		vectorError = MAX( vectorError, fabsf( c3[i].y - expected[coeffsCount+i] ) );
+		vectorError = MAX( vectorError, fabsf( c3[i].z - expected[2*coeffsCount+i] ) );
+	}
+
+	// All the channels multiplied by the first vector of b, which c holds for the first 3 vectors
+	bfloat3	d3[MAX_COEFFS_COUNT];
+	product.Product( a3, b, c3 );
+	product.ApplyOperator( op, a3, d3 );
+	float	vectorOperatorError = 0.0f;
+	for ( U32 i=0; i < coeffsCount; i++ ) {
+		vectorOperatorError = MAX( vectorOperatorError, MAX( fabsf( c3[i].x - c[i] ), fabsf( d3[i].x - c[i] ) ) );
+		vectorOperatorError = MAX( vectorOperatorError, MAX( fabsf( c3[i].y - c[coeffsCount+i] ), fabsf( d3[i].y - c[coeffsCount+i] ) ) );
+		vectorOperatorError = MAX( vectorOperatorError, MAX( fabsf( c3[i].z - c[2*coeffsCount+i] ), fabsf( d3[i].z - c[2*coeffsCount+i] ) ) );
+	}
+
+	delete[] op;
+	delete[] cSoA;
+	delete[] bSoA;
+	delete[] aSoA;
+	delete[] c;
+	delete[] expected;
+	delete[] b;
+	delete[] a;
+
+	CHECK( SoAError < TOLERANCE, "SoA product must match the single vector product" );
+	CHECK( operatorError < TOLERANCE, "Operator product must match the single vector product" );
+	CHECK( operatorSoAError < TOLERANCE, "SoA operator product must match the single vector product" );
+	CHECK( vectorError < TOLERANCE, "bfloat3 product must match the single vector product" );
+	CHECK( vectorOperatorError < TOLERANCE, "bfloat3 operator product must match the single vector product" );
+	return true;
+}
+
+}	// namespace
+
+bool	TestSH( bool _runBenchmarks ) {
+	if ( !TestBuildSHCoeffs() )
+		return false;
+	if ( !TestProject() )
+		return false;
+	if ( !TestBand1Convention() )
+		return false;
+	if ( !TestRotationMatchesReprojection() )
+		return false;
+	if ( !TestRotationVariants() )
+		return false;
+	if ( !TestProductMatchesProduct3() )
+		return false;
+	if ( !TestProductIdentity() )
+		return false;
+	if ( !TestProductVariants() )
+		return false;
+
+	return true;
+}
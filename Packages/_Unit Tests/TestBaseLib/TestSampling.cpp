@@ -0,0 +1,213 @@
+//////////////////////////////////////////////////////////////////////////
+// Tests the samplers: net and stratification properties, and the SSE batches against the scalar samples
+//
+#include "stdafx.h"
+
+namespace {
+
+// Tells if the _count values put exactly one value in each of the _count intervals of [0,1[
+bool	IsStratified( const float* _values, U32 _count ) {
+	U32*	histogram = new U32[_count];
+	memset( histogram, 0, _count * sizeof(U32) );
+	bool	stratified = true;
+	for ( U32 i=0; i < _count && stratified; i++ ) {
+		U32	interval = U32( _values[i] * _count );
+		stratified = interval < _count && histogram[interval]++ == 0;
+	}
+	delete[] histogram;
+	return stratified;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Sobol'
+//
+bool	TestSobolStratification() {
+	SobolSampler	sampler( SobolSampler::MAX_DIMENSIONS );
+	float			values[256];
+	for ( U32 dimension=0; dimension < SobolSampler::MAX_DIMENSIONS; dimension++ ) {
+		for ( U32 log2Count=4; log2Count <= 8; log2Count+=4 ) {
+			// Any aligned block of 2^k scrambled samples is stratified in 1D
+			U32	count = 1U << log2Count;
+			U32	seed = 1234 + dimension;
+			for ( U32 i=0; i < count; i++ )
+				values[i] = sampler.Sample( 3 * count + i, dimension, seed );
+			CHECK( IsStratified( values, count ), "Sobol' blocks of 2^k samples must be stratified in every dimension" );
+		}
+	}
+	return true;
+}
+
+bool	TestSobolNet() {
+	// The first 2 dimensions form a (0,m,2)-net: each elementary interval of area 1/2^m holds exactly one point
+	const U32	LOG2_COUNT = 8;
+	const U32	COUNT = 1U << LOG2_COUNT;
+
+	SobolSampler	sampler( 2 );
+	U32				cells[COUNT];
+	for ( U32 log2Width=0; log2Width <= LOG2_COUNT; log2Width++ ) {
+		memset( cells, 0, COUNT * sizeof(U32) );
+		for ( U32 i=0; i < COUNT; i++ ) {
+			U32	x = U32( sampler.Sample( i, 0, 77 ) * (1U << log2Width) );
+			U32	y = U32( sampler.Sample( i, 1, 77 ) * (1U << (LOG2_COUNT - log2Width)) );
+			cells[(x << (LOG2_COUNT - log2Width)) | y]++;
+		}
+		for ( U32 cellIndex=0; cellIndex < COUNT; cellIndex++ )
+			CHECK( cells[cellIndex] == 1, "The first 2 Sobol' dimensions must form a (0,m,2)-net" );
+	}
+	return true;
+}
+
+bool	TestSobolBatches() {
+	const U32	COUNT = 1003;	// Not a multiple of 4 so the remaining lanes are tested too
+	const U32	DIMENSIONS_COUNT = 8;
+
+	SobolSampler	sampler( 512 );
+	float*			values = new float[COUNT];
+	U32				mismatchesCount = 0;
+	const U32		DIMENSIONS[] = { 0, 5, 37, 500 };
+	for ( U32 i=0; i < 4; i++ ) {
+		sampler.Sample( 17, COUNT, DIMENSIONS[i], 99, values );
+		for ( U32 sampleIndex=0; sampleIndex < COUNT; sampleIndex++ )
+			if ( values[sampleIndex] != sampler.Sample( 17 + sampleIndex, DIMENSIONS[i], 99 ) )
+				mismatchesCount++;
+	}
+	delete[] values;
+
+	SobolSampler	sampler8( DIMENSIONS_COUNT );
+	float*			points = new float[COUNT * DIMENSIONS_COUNT];
+	float			point[DIMENSIONS_COUNT];
+	sampler8.SamplePoints( 5, COUNT, 42, points );
+	for ( U32 pointIndex=0; pointIndex < COUNT; pointIndex++ ) {
+		sampler8.Sample( 5 + pointIndex, 42, point );
+		for ( U32 dimension=0; dimension < DIMENSIONS_COUNT; dimension++ )
+			if ( point[dimension] != points[pointIndex * DIMENSIONS_COUNT + dimension] )
+				mismatchesCount++;
+	}
+	delete[] points;
+
+	CHECK( mismatchesCount == 0, "Sobol' SSE batches must match the scalar samples" );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Rank-1 lattice
+//
+bool	TestLatticeStratification() {
+	const U32	DIMENSIONS_COUNT = 6;
+	const U32	LOG2_COUNT = 12;
+	const U32	COUNT = 1U << LOG2_COUNT;
+
+	Rank1Lattice	lattice( DIMENSIONS_COUNT, LOG2_COUNT );
+	for ( U32 dimension=0; dimension < DIMENSIONS_COUNT; dimension++ )
+		CHECK( lattice.GetGeneratingVector()[dimension] & 1, "The generating vector components must be odd" );
+
+	// Every dimension of a lattice (or of an aligned block of 2^k points of it) is stratified, whatever the shift
+	float*	values = new float[COUNT];
+	bool	stratified = true;
+	for ( U32 dimension=0; dimension < DIMENSIONS_COUNT; dimension++ ) {
+		lattice.Sample( 0, COUNT, dimension, 5 + dimension, values );
+		stratified &= IsStratified( values, COUNT );
+		lattice.Sample( 64, 64, dimension, 5 + dimension, values );
+		stratified &= IsStratified( values, 64 );
+	}
+	delete[] values;
+
+	CHECK( stratified, "Rank-1 lattice blocks of 2^k points must be stratified in every dimension" );
+	return true;
+}
+
+bool	TestLatticeBatches() {
+	const U32	COUNT = 1001;
+	const U32	DIMENSIONS_COUNT = 6;
+
+	Rank1Lattice	lattice( DIMENSIONS_COUNT, 16 );
+	float*			values = new float[COUNT * DIMENSIONS_COUNT];
+	float			point[DIMENSIONS_COUNT];
+	U32				mismatchesCount = 0;
+
+	lattice.Sample( 3, COUNT, 2, 5, values );
+	for ( U32 sampleIndex=0; sampleIndex < COUNT; sampleIndex++ )
+		if ( values[sampleIndex] != lattice.Sample( 3 + sampleIndex, 2, 5 ) )
+			mismatchesCount++;
+
+	lattice.SamplePoints( 1, COUNT, 9, values );
+	for ( U32 pointIndex=0; pointIndex < COUNT; pointIndex++ ) {
+		lattice.Sample( 1 + pointIndex, 9, point );
+		for ( U32 dimension=0; dimension < DIMENSIONS_COUNT; dimension++ )
+			if ( point[dimension] != values[pointIndex * DIMENSIONS_COUNT + dimension] )
+				mismatchesCount++;
+	}
+	delete[] values;
+
+	CHECK( mismatchesCount == 0, "Rank-1 lattice SSE batches must match the scalar samples" );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Blue noise
+//
+bool	TestBlueNoise() {
+	BlueNoiseTile	tile( 6, 1 );
+	U32				size = tile.GetSize();
+	U32				pixelsCount = size * size;
+
+	// The ranks are a permutation of [0,size^2[
+	U8*		used = new U8[pixelsCount];
+	memset( used, 0, pixelsCount );
+	bool	isPermutation = true;
+	for ( U32 pixelIndex=0; pixelIndex < pixelsCount && isPermutation; pixelIndex++ ) {
+		U32	rank = tile.GetRanks()[pixelIndex];
+		isPermutation = rank < pixelsCount && used[rank]++ == 0;
+	}
+	delete[] used;
+	CHECK( isPermutation, "Blue noise ranks must be a permutation" );
+
+	float*	thresholds = new float[pixelsCount];
+	U32		mismatchesCount = 0;
+	for ( U32 dimension=0; dimension < 4; dimension+=3 ) {
+		tile.GetThresholds( dimension, thresholds );
+		for ( U32 y=0; y < size; y++ )
+			for ( U32 x=0; x < size; x++ )
+				if ( thresholds[y * size + x] != tile.Sample( x, y, dimension ) )
+					mismatchesCount++;
+	}
+	delete[] thresholds;
+
+	CHECK( mismatchesCount == 0, "Blue noise thresholds must match the scalar samples" );
+	return true;
+}
+
+//////////////////////////////////////////////////////////////////////////
+// Benchmarks
+//
+void	BenchmarkLatticeSearch() {
+	// The search is bounded whatever the amount of points and dimensions
+	const U32	SIZES[][2] = { { 16, 20 }, { 1024, 16 }, { 1024, 24 } };
+	for ( U32 i=0; i < 3; i++ ) {
+		Chrono	chrono;
+		Rank1Lattice	lattice( SIZES[i][0], SIZES[i][1] );
+		printf( "  Rank-1 lattice search of 2^%u points in %u dimensions: %.2f s\n", SIZES[i][1], SIZES[i][0], chrono.Elapsed() );
+	}
+}
+
+}	// namespace
+
+bool	TestSampling( bool _runBenchmarks ) {
+	if ( !TestSobolStratification() )
+		return false;
+	if ( !TestSobolNet() )
+		return false;
+	if ( !TestSobolBatches() )
+		return false;
+	if ( !TestLatticeStratification() )
+		return false;
+	if ( !TestLatticeBatches() )
+		return false;
+	if ( !TestBlueNoise() )
+		return false;
+
+	if ( _runBenchmarks )
+		BenchmarkLatticeSearch();
+
+	return true;
+}
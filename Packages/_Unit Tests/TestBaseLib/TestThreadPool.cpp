@@ -0,0 +1,85 @@
+//////////////////////////////////////////////////////////////////////////
+// Tests the thread pool: exceptions thrown by tasks and jobs nested across pools
+//
+#include "stdafx.h"
+#include "..\..\BaseLib\Utility\ThreadPool.h"
+
+namespace {
+
+const U32	TASKS_COUNT = 64;
+
+// Tells if the job was spread across several threads (the tasks sleep a bit so the workers get a chance to grab some)
+bool	RunsInParallel( ThreadPool& _pool ) {
+	volatile LONG	threadsMask = 0;
+	_pool.ParallelFor( TASKS_COUNT, [&]( U32 _taskIndex, U32 _threadIndex ) {
+		Sleep( 1 );
+		InterlockedOr( &threadsMask, 1 << _threadIndex );
+	} );
+	return (threadsMask & (threadsMask-1)) != 0;
+}
+
+bool	TestExceptions() {
+	ThreadPool	pool( 3 );
+	CHECK( RunsInParallel( pool ), "The pool must spread the tasks across its workers" );
+
+	// Every task throws, including the ones executed by the calling thread and the workers
+	const char*	caught = NULL;
+	try {
+		pool.ParallelFor( TASKS_COUNT, [&]( U32 _taskIndex, U32 _threadIndex ) {
+			Sleep( 1 );
+			throw "Task failed!";
+		} );
+	} catch ( const char* _error ) {
+		caught = _error;
+	}
+	CHECK( caught != NULL, "The exception thrown by a task must be rethrown by ParallelFor()" );
+
+	// A single failing task
+	caught = NULL;
+	try {
+		pool.ParallelFor( TASKS_COUNT, [&]( U32 _taskIndex, U32 _threadIndex ) {
+			if ( _taskIndex == TASKS_COUNT / 2 )
+				throw "Task failed!";
+		} );
+	} catch ( const char* _error ) {
+		caught = _error;
+	}
+	CHECK( caught != NULL, "The exception thrown by a single task must be rethrown by ParallelFor()" );
+
+	// The calling thread must not be considered as still executing a task
+	CHECK( RunsInParallel( pool ), "Jobs following an exception must still run in parallel" );
+	return true;
+}
+
+bool	TestNestedPools() {
+	ThreadPool	outerPool( 3 );
+	ThreadPool	innerPool( 1 );
+
+	volatile LONG	outOfRangeCount = 0;
+	outerPool.ParallelFor( TASKS_COUNT, [&]( U32 _taskIndex, U32 _outerThreadIndex ) {
+		// A job on another pool gets thread indices of that pool
+		innerPool.ParallelFor( 4, [&]( U32 _innerTaskIndex, U32 _innerThreadIndex ) {
+			if ( _innerThreadIndex >= innerPool.GetThreadsCount() )
+				InterlockedIncrement( &outOfRangeCount );
+		} );
+
+		// A job nested in the same pool runs serially with the current thread index
+		outerPool.ParallelFor( 4, [&]( U32 _innerTaskIndex, U32 _innerThreadIndex ) {
+			if ( _innerThreadIndex != _outerThreadIndex )
+				InterlockedIncrement( &outOfRangeCount );
+		} );
+	} );
+	CHECK( outOfRangeCount == 0, "Nested jobs must get thread indices in the range of their own pool" );
+	return true;
+}
+
+}	// namespace
+
+bool	TestThreadPool( bool _runBenchmarks ) {
+	if ( !TestExceptions() )
+		return false;
+	if ( !TestNestedPools() )
+		return false;
+
+	return true;
+}
@@ -80,6 +80,11 @@
 			this.buttonDraw2 = new System.Windows.Forms.Button();
 			this.buttonDraw1 = new System.Windows.Forms.Button();
 			this.buttonLoadDDS2 = new System.Windows.Forms.Button();
+			this.buttonLoadDDS3 = new System.Windows.Forms.Button();
+			this.tabPageBenchmarks = new System.Windows.Forms.TabPage();
+			this.buttonBenchmark1 = new System.Windows.Forms.Button();
+			this.buttonBenchmark2 = new System.Windows.Forms.Button();
+			this.textBoxBenchmark = new System.Windows.Forms.TextBox();
 			this.panelBuild = new ImageUtility.UnitTests.PanelOutput(this.components);
 			this.panelLoad = new ImageUtility.UnitTests.PanelOutput(this.components);
 			this.panelOutputHDR = new ImageUtility.UnitTests.PanelOutput(this.components);
@@ -91,6 +96,7 @@
 			this.tabPageLDR2HDR.SuspendLayout();
 			this.tabPageColorProfiles.SuspendLayout();
 			this.tabPageDrawing.SuspendLayout();
+			this.tabPageBenchmarks.SuspendLayout();
 			this.SuspendLayout();
 			// 
 			// textBoxEXIF
@@ -109,6 +115,7 @@
 			this.tabControlTests.Controls.Add(this.tabPageLDR2HDR);
 			this.tabControlTests.Controls.Add(this.tabPageColorProfiles);
 			this.tabControlTests.Controls.Add(this.tabPageDrawing);
+			this.tabControlTests.Controls.Add(this.tabPageBenchmarks);
 			this.tabControlTests.Location = new System.Drawing.Point(13, 13);
 			this.tabControlTests.Name = "tabControlTests";
 			this.tabControlTests.SelectedIndex = 0;
@@ -177,6 +184,7 @@
 			this.tabPageLoading.Controls.Add(this.buttonLoad22);
 			this.tabPageLoading.Controls.Add(this.buttonLoad14);
 			this.tabPageLoading.Controls.Add(this.buttonLoad13);
+			this.tabPageLoading.Controls.Add(this.buttonLoadDDS3);
 			this.tabPageLoading.Controls.Add(this.buttonLoadDDS2);
 			this.tabPageLoading.Controls.Add(this.buttonLoadDDS1);
 			this.tabPageLoading.Controls.Add(this.buttonLoad12);
@@ -653,6 +661,59 @@
 			this.buttonLoadDDS2.UseVisualStyleBackColor = true;
 			this.buttonLoadDDS2.Click += new System.EventHandler(this.buttonLoadDDS2_Click);
 			// 
+			// buttonLoadDDS3
+			// 
+			this.buttonLoadDDS3.Location = new System.Drawing.Point(230, 79);
+			this.buttonLoadDDS3.Name = "buttonLoadDDS3";
+			this.buttonLoadDDS3.Size = new System.Drawing.Size(123, 23);
+			this.buttonLoadDDS3.TabIndex = 2;
+			this.buttonLoadDDS3.Text = "DDS 3D Round-Trip";
+			this.buttonLoadDDS3.UseVisualStyleBackColor = true;
+			this.buttonLoadDDS3.Click += new System.EventHandler(this.buttonLoadDDS3_Click);
+			// 
+			// tabPageBenchmarks
+			// 
+			this.tabPageBenchmarks.Controls.Add(this.textBoxBenchmark);
+			this.tabPageBenchmarks.Controls.Add(this.buttonBenchmark2);
+			this.tabPageBenchmarks.Controls.Add(this.buttonBenchmark1);
+			this.tabPageBenchmarks.Location = new System.Drawing.Point(4, 22);
+			this.tabPageBenchmarks.Name = "tabPageBenchmarks";
+			this.tabPageBenchmarks.Size = new System.Drawing.Size(1162, 737);
+			this.tabPageBenchmarks.TabIndex = 5;
+			this.tabPageBenchmarks.Text = "Benchmarks";
+			this.tabPageBenchmarks.UseVisualStyleBackColor = true;
+			// 
+			// buttonBenchmark1
+			// 
+			this.buttonBenchmark1.Location = new System.Drawing.Point(3, 21);
+			this.buttonBenchmark1.Name = "buttonBenchmark1";
+			this.buttonBenchmark1.Size = new System.Drawing.Size(119, 23);
+			this.buttonBenchmark1.TabIndex = 0;
+			this.buttonBenchmark1.Text = "Scanline Codecs";
+			this.buttonBenchmark1.UseVisualStyleBackColor = true;
+			this.buttonBenchmark1.Click += new System.EventHandler(this.buttonBenchmark1_Click);
+			// 
+			// buttonBenchmark2
+			// 
+			this.buttonBenchmark2.Location = new System.Drawing.Point(128, 21);
+			this.buttonBenchmark2.Name = "buttonBenchmark2";
+			this.buttonBenchmark2.Size = new System.Drawing.Size(119, 23);
+			this.buttonBenchmark2.TabIndex = 2;
+			this.buttonBenchmark2.Text = "Block Compression";
+			this.buttonBenchmark2.UseVisualStyleBackColor = true;
+			this.buttonBenchmark2.Click += new System.EventHandler(this.buttonBenchmark2_Click);
+			// 
+			// textBoxBenchmark
+			// 
+			this.textBoxBenchmark.Font = new System.Drawing.Font("Courier New", 8.25F, System.Drawing.FontStyle.Regular, System.Drawing.GraphicsUnit.Point, ((byte)(0)));
+			this.textBoxBenchmark.Location = new System.Drawing.Point(3, 84);
+			this.textBoxBenchmark.Multiline = true;
+			this.textBoxBenchmark.Name = "textBoxBenchmark";
+			this.textBoxBenchmark.ReadOnly = true;
+			this.textBoxBenchmark.ScrollBars = System.Windows.Forms.ScrollBars.Vertical;
+			this.textBoxBenchmark.Size = new System.Drawing.Size(1151, 640);
+			this.textBoxBenchmark.TabIndex = 1;
+			// 
 			// panelBuild
 			// 
 			this.panelBuild.Bitmap = null;
@@ -711,6 +772,8 @@
 			this.tabPageLDR2HDR.PerformLayout();
 			this.tabPageColorProfiles.ResumeLayout(false);
 			this.tabPageDrawing.ResumeLayout(false);
+			this.tabPageBenchmarks.ResumeLayout(false);
+			this.tabPageBenchmarks.PerformLayout();
 			this.ResumeLayout(false);
 
 		}
@@ -773,6 +836,11 @@
 		private System.Windows.Forms.Button buttonLDR11RAW;
 		private System.Windows.Forms.Button buttonLoadDDS1;
 		private System.Windows.Forms.Button buttonLoadDDS2;
+		private System.Windows.Forms.Button buttonLoadDDS3;
+		private System.Windows.Forms.TabPage tabPageBenchmarks;
+		private System.Windows.Forms.Button buttonBenchmark1;
+		private System.Windows.Forms.Button buttonBenchmark2;
+		private System.Windows.Forms.TextBox textBoxBenchmark;
 
 	}
 }
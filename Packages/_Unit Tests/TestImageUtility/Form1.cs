@@ -971,6 +971,7 @@ float	quality = _RAW ? 3.0f : 3.0f;
 
 			DDS_2D_RGBA8_MIPS,
 			DDS_2D_RGBA32_CUBE,
+			DDS_3D_ODD_DEPTH_ROUND_TRIP,
 		}
 
 		private void buttonLoad1_Click(object sender, EventArgs e) {
@@ -1049,6 +1050,45 @@ float	quality = _RAW ? 3.0f : 3.0f;
 			TestLoadImage( LOADING_TESTS.DDS_2D_RGBA32_CUBE );
 		}
 
+		private void buttonLoadDDS3_Click(object sender, EventArgs e) {
+			TestLoadImage( LOADING_TESTS.DDS_3D_ODD_DEPTH_ROUND_TRIP );
+		}
+
+		// Checks the mips of a 3D texture read back from a DDS file follow the D3D size rule and that each texel holds its (X,Y,Z,mip) coordinates
+		void	CheckDDS3DRoundTrip( ImagesMatrix _images, uint _width, uint _height, uint _depth, uint _mipLevelsCount, bool _mapped ) {
+			if ( _images.Type != ImagesMatrix.TYPE.TEXTURE3D || _images.ArraySize != 1 || _images[0].MipLevelsCount != _mipLevelsCount )
+				throw new Exception( "Unexpected 3D texture layout!" );
+
+			float[]	texel = new float[4];
+			for ( uint mipLevelIndex=0; mipLevelIndex < _mipLevelsCount; mipLevelIndex++ ) {
+				ImagesMatrix.Mips.Mip	mip = _images[0][mipLevelIndex];
+				uint	W = Math.Max( 1U, _width >> (int) mipLevelIndex );
+				uint	H = Math.Max( 1U, _height >> (int) mipLevelIndex );
+				uint	D = Math.Max( 1U, _depth >> (int) mipLevelIndex );
+				if ( mip.Width != W || mip.Height != H || mip.Depth != D )
+					throw new Exception( "Mip " + mipLevelIndex + " is " + mip.Width + "x" + mip.Height + "x" + mip.Depth + " instead of " + W + "x" + H + "x" + D + "!" );
+
+				for ( uint sliceIndex=0; sliceIndex < D; sliceIndex++ ) {
+					for ( uint Y=0; Y < H; Y++ ) {
+						for ( uint X=0; X < W; X++ ) {
+							float4	color;
+							if ( _mapped ) {
+								long	offset = sliceIndex * mip.SlicePitch + Y * mip.RowPitch + X * 16;
+								System.Runtime.InteropServices.Marshal.Copy( new IntPtr( mip.RawBuffer.ToInt64() + offset ), texel, 0, 4 );
+								color = new float4( texel[0], texel[1], texel[2], texel[3] );
+							} else {
+								float4	readColor = new float4();
+								mip[sliceIndex].ReadPixels( ( uint _X, uint _Y, ref float4 _color ) => { readColor = _color; }, X, Y, 1, 1 );
+								color = readColor;
+							}
+							if ( color.x != X || color.y != Y || color.z != sliceIndex || color.w != mipLevelIndex )
+								throw new Exception( "Texel (" + X + "," + Y + "," + sliceIndex + ") of mip " + mipLevelIndex + " mismatch" + (_mapped ? " in the mapped file!" : "!") );
+						}
+					}
+				}
+			}
+		}
+
 		void TestLoadImage( LOADING_TESTS _type ) {
 			string	customLines = "";
 			try {
@@ -1178,6 +1218,53 @@ float	quality = _RAW ? 3.0f : 3.0f;
 						break;
 					}
 
+					// DDS 3D texture with an odd depth saved then read back by the parser, both loaded and mapped
+					case LOADING_TESTS.DDS_3D_ODD_DEPTH_ROUND_TRIP: {
+						const uint	SIZE = 4;
+						const uint	DEPTH = 13;			// Mip depths are 13, 6, 3, 1 (rounding up would give 13, 7, 4, 2)
+						const uint	MIP_LEVELS_COUNT = 4;
+
+						System.IO.FileInfo	file = new System.IO.FileInfo( System.IO.Path.Combine( System.IO.Path.GetTempPath(), "DDS3DRoundTrip.dds" ) );
+						using ( ImagesMatrix source = new ImagesMatrix() ) {
+							source.InitTexture3D( SIZE, SIZE, DEPTH, 0 );
+							source.AllocateImageFiles( PIXEL_FORMAT.RGBA32F, new ColorProfile( ColorProfile.STANDARD_PROFILE.LINEAR ) );
+							for ( uint mipLevelIndex=0; mipLevelIndex < source[0].MipLevelsCount; mipLevelIndex++ ) {
+								ImagesMatrix.Mips.Mip	mip = source[0][mipLevelIndex];
+								for ( uint sliceIndex=0; sliceIndex < mip.Depth; sliceIndex++ ) {
+									mip[sliceIndex].WritePixels( ( uint _X, uint _Y, ref float4 _color ) => {
+										_color = new float4( _X, _Y, sliceIndex, mipLevelIndex );
+									} );
+								}
+							}
+							CheckDDS3DRoundTrip( source, SIZE, SIZE, DEPTH, MIP_LEVELS_COUNT, false );
+							source.DDSSaveFile( file, COMPONENT_FORMAT.AUTO );
+						}
+
+						using ( ImagesMatrix mapped = new ImagesMatrix() ) {
+							mapped.DDSMapFile( file );
+							CheckDDS3DRoundTrip( mapped, SIZE, SIZE, DEPTH, MIP_LEVELS_COUNT, true );
+						}
+
+						ImagesMatrix	images = new ImagesMatrix();
+						images.DDSLoadFile( file );
+						CheckDDS3DRoundTrip( images, SIZE, SIZE, DEPTH, MIP_LEVELS_COUNT, false );
+						file.Delete();
+
+						m_imageFile = images[0][0][0];
+						images[0][0][0] = null;	// Remove it from the matrix so it doesn't get destroyed!
+						panelLoad.Bitmap = m_imageFile.AsCustomBitmap( ( ref float4 _color ) => {
+							_color.x /= SIZE;
+							_color.y /= SIZE;
+							_color.z = 0;
+							_color.w = 1;
+						} );
+
+						customLines = "\r\n"
+									+ "Saved, mapped and loaded back a " + SIZE + "x" + SIZE + "x" + DEPTH + " 3D texture\r\n"
+									+ images[0].MipLevelsCount + " mip levels\r\n";
+						break;
+					}
+
 					default:
 						// High-Dynamic Range Images
 						switch ( _type ) {
@@ -1258,6 +1345,73 @@ float	quality = _RAW ? 3.0f : 3.0f;
 
 		#endregion
 
+		#region Benchmarks
+
+		// The formats handled by the span codecs
+		static readonly PIXEL_FORMAT[]	BENCHMARK_FORMATS = new PIXEL_FORMAT[] {
+			PIXEL_FORMAT.R8, PIXEL_FORMAT.RG8, PIXEL_FORMAT.RGB8, PIXEL_FORMAT.RGBA8, PIXEL_FORMAT.BGR8, PIXEL_FORMAT.BGRA8,
+			PIXEL_FORMAT.R16, PIXEL_FORMAT.RG16, PIXEL_FORMAT.RGB16, PIXEL_FORMAT.RGBA16,
+			PIXEL_FORMAT.R16F, PIXEL_FORMAT.RG16F, PIXEL_FORMAT.RGB16F, PIXEL_FORMAT.RGBA16F,
+			PIXEL_FORMAT.R32, PIXEL_FORMAT.RG32, PIXEL_FORMAT.RGB32, PIXEL_FORMAT.RGBA32,
+			PIXEL_FORMAT.R32F, PIXEL_FORMAT.RG32F, PIXEL_FORMAT.RGB32F, PIXEL_FORMAT.RGBA32F,
+			PIXEL_FORMAT.RGBE, PIXEL_FORMAT.RGB10A2, PIXEL_FORMAT.R11G11B10,
+		};
+
+		// Compares the per-pixel IPixelAccessor path (before) against the span codecs (after) used by ReadScanline()/WriteScanline()
+		private void buttonBenchmark1_Click(object sender, EventArgs e) {
+			try {
+				const uint	W = 2048;
+				const uint	H = 1024;
+				const uint	REPEAT_COUNT = 8;
+
+				List< string >	lines = new List< string >();
+				lines.Add( "Scanline codecs on " + W + "x" + H + " pixels, best of " + REPEAT_COUNT + " runs (MPixels/s)" );
+				lines.Add( "" );
+				lines.Add( "Format       Decode Before  Decode After  Speed Up  Encode Before  Encode After  Speed Up" );
+				foreach ( PIXEL_FORMAT format in BENCHMARK_FORMATS ) {
+					double	decodeBefore = 0, decodeAfter = 0, encodeBefore = 0, encodeAfter = 0;
+					ImageFile.BenchmarkScanlineCodecs( format, W, H, REPEAT_COUNT, ref decodeBefore, ref decodeAfter, ref encodeBefore, ref encodeAfter );
+					lines.Add( string.Format( "{0,-12} {1,13:F1} {2,13:F1} {3,8:F2}x {4,14:F1} {5,13:F1} {6,8:F2}x", format, decodeBefore, decodeAfter, decodeAfter / decodeBefore, encodeBefore, encodeAfter, encodeAfter / encodeBefore ) );
+				}
+				textBoxBenchmark.Lines = lines.ToArray();
+
+			} catch ( Exception _e ) {
+				MessageBox.Show( "Error: " + _e.Message );
+			}
+		}
+
+		// Measures the quality and speed of the CPU block compressor for each format and quality tier
+		private void buttonBenchmark2_Click(object sender, EventArgs e) {
+			try {
+				const uint	REPEAT_COUNT = 3;
+
+				ImagesMatrix.COMPRESSION_TYPE[]		types = new ImagesMatrix.COMPRESSION_TYPE[] { ImagesMatrix.COMPRESSION_TYPE.BC1, ImagesMatrix.COMPRESSION_TYPE.BC3, ImagesMatrix.COMPRESSION_TYPE.BC4, ImagesMatrix.COMPRESSION_TYPE.BC5, ImagesMatrix.COMPRESSION_TYPE.BC7 };
+				ImagesMatrix.COMPRESSION_QUALITY[]	qualities = new ImagesMatrix.COMPRESSION_QUALITY[] { ImagesMatrix.COMPRESSION_QUALITY.FAST, ImagesMatrix.COMPRESSION_QUALITY.NORMAL, ImagesMatrix.COMPRESSION_QUALITY.HIGH };
+
+				using ( ImageFile source = new ImageFile( new System.IO.FileInfo( @"..\..\..\Data\Images\In\PNG\RGB8.png" ) ) ) {
+					List< string >	lines = new List< string >();
+					lines.Add( "Block compression of a " + source.Width + "x" + source.Height + " image, best of " + REPEAT_COUNT + " runs" );
+					lines.Add( "" );
+					lines.Add( "Format  Quality   PSNR (dB)  MPixels/s" );
+					foreach ( ImagesMatrix.COMPRESSION_TYPE type in types ) {
+						// BC4 and BC5 don't have sRGB variants
+						COMPONENT_FORMAT	componentFormat = type == ImagesMatrix.COMPRESSION_TYPE.BC4 || type == ImagesMatrix.COMPRESSION_TYPE.BC5 ? COMPONENT_FORMAT.UNORM : COMPONENT_FORMAT.UNORM_sRGB;
+						foreach ( ImagesMatrix.COMPRESSION_QUALITY quality in qualities ) {
+							double	PSNR = 0, MPixelsPerSecond = 0;
+							ImagesMatrix.BenchmarkCompression( source, type, componentFormat, quality, REPEAT_COUNT, ref PSNR, ref MPixelsPerSecond );
+							lines.Add( string.Format( "{0,-7} {1,-7} {2,11:F2} {3,10:F2}", type, quality, PSNR, MPixelsPerSecond ) );
+						}
+					}
+					textBoxBenchmark.Lines = lines.ToArray();
+				}
+
+			} catch ( Exception _e ) {
+				MessageBox.Show( "Error: " + _e.Message );
+			}
+		}
+
+		#endregion
+
 		protected override void OnClosed( EventArgs e ) {
 
 			m_imageFile.Dispose();